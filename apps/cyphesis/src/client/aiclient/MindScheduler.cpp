@@ -0,0 +1,172 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "MindScheduler.h"
+
+#include "common/log.h"
+
+#include "Remotery.h"
+
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+MindScheduler::MindScheduler() :
+		m_slowTickReport(0),
+		m_tickDuration(Metrics::instance().histogram("mind_tick_seconds", "Time spent ticking a mind.")),
+		m_operationDuration(Metrics::instance().histogram("mind_operation_seconds", "Time spent by a mind handling an operation.")),
+		m_dueMinds(Metrics::instance().gauge("minds_due", "Number of minds which were due to be ticked, the last time minds were ticked.")),
+		m_forgottenEntities(Metrics::instance().counter("mind_forgotten_entities_total", "Number of entities forgotten by minds.")) {
+}
+
+MindScheduler::~MindScheduler() {
+	for (auto& entry: m_entries) {
+		removeMemoryMetrics(entry.first);
+	}
+}
+
+void MindScheduler::add(Ref<BaseMind> mind) {
+	auto id = mind->getIdAsInt();
+	auto due = mind->getNextTickTime();
+	Metrics::Labels labels{{"mind", std::to_string(id)}};
+	auto& rememberedEntities = Metrics::instance().gauge("mind_remembered_entities", "Number of entities remembered by a mind.", labels);
+	auto& entityMemories = Metrics::instance().gauge("mind_entity_memories", "Number of entities a mind has memories about.", labels);
+	auto result = m_entries.emplace(id, Entry{std::move(mind), std::chrono::steady_clock::time_point::max(), {}, &rememberedEntities, &entityMemories});
+	updateMemoryStats(result.first->second);
+	schedule(id, result.first->second, due);
+}
+
+void MindScheduler::remove(const BaseMind& mind) {
+	auto I = m_entries.find(mind.getIdAsInt());
+	if (I != m_entries.end()) {
+		m_queue.erase({I->second.due, I->first});
+		removeMemoryMetrics(I->first);
+		m_entries.erase(I);
+	}
+}
+
+void MindScheduler::reschedule(const BaseMind& mind) {
+	auto I = m_entries.find(mind.getIdAsInt());
+	if (I != m_entries.end()) {
+		schedule(I->first, I->second, mind.getNextTickTime());
+	}
+}
+
+void MindScheduler::operationHandled(const BaseMind& mind, std::chrono::steady_clock::duration duration) {
+	m_operationDuration.observe(duration);
+	auto I = m_entries.find(mind.getIdAsInt());
+	if (I != m_entries.end()) {
+		I->second.stats.operationTime += duration;
+		I->second.stats.operations++;
+		updateMemoryStats(I->second);
+		schedule(I->first, I->second, mind.getNextTickTime());
+	}
+}
+
+void MindScheduler::schedule(long id, Entry& entry, std::chrono::steady_clock::time_point due) {
+	if (entry.due == due) {
+		return;
+	}
+	if (entry.due != std::chrono::steady_clock::time_point::max()) {
+		m_queue.erase({entry.due, id});
+	}
+	entry.due = due;
+	if (due != std::chrono::steady_clock::time_point::max()) {
+		m_queue.emplace(due, id);
+	}
+}
+
+size_t MindScheduler::tickDue(std::chrono::steady_clock::time_point now, std::chrono::steady_clock::duration maxWallClockDuration, OpVector& res) {
+	rmt_ScopedCPUSample(MindScheduler_tickDue, 0)
+	auto expiry = std::chrono::steady_clock::now() + maxWallClockDuration;
+	size_t count = 0;
+
+	//Only tick minds which were due when we started, so that minds which are due again right away don't starve the others.
+	auto end = m_queue.upper_bound({now, std::numeric_limits<long>::max()});
+	m_dueMinds.set(static_cast<std::int64_t>(std::distance(m_queue.begin(), end)));
+	std::vector<long> dueIds;
+	for (auto I = m_queue.begin(); I != end; ++I) {
+		dueIds.push_back(I->second);
+	}
+
+	for (auto id: dueIds) {
+		if (count > 0 && std::chrono::steady_clock::now() >= expiry) {
+			break;
+		}
+		auto I = m_entries.find(id);
+		//The mind might have been removed by an earlier tick.
+		if (I == m_entries.end()) {
+			continue;
+		}
+		auto& entry = I->second;
+		if (entry.mind->isDestroyed()) {
+			m_queue.erase({entry.due, id});
+			removeMemoryMetrics(id);
+			m_entries.erase(I);
+			continue;
+		}
+		auto tickStart = std::chrono::steady_clock::now();
+		entry.mind->processTick(res);
+		auto duration = std::chrono::steady_clock::now() - tickStart;
+		entry.stats.tickTime += duration;
+		entry.stats.ticks++;
+		m_tickDuration.observe(duration);
+		if (m_slowTickReport.count() > 0 && duration > m_slowTickReport) {
+			spdlog::warn("Ticking mind {} took {} milliseconds.", entry.mind->describeEntity(),
+						 std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(duration).count());
+		}
+		count++;
+		updateMemoryStats(entry);
+		schedule(id, entry, entry.mind->getNextTickTime());
+	}
+	return count;
+}
+
+void MindScheduler::updateMemoryStats(Entry& entry) {
+	auto& map = *entry.mind->getMap();
+	auto forgotten = map.getForgottenCount();
+	if (forgotten > entry.stats.forgottenEntities) {
+		m_forgottenEntities.increment(forgotten - entry.stats.forgottenEntities);
+	}
+	entry.stats.forgottenEntities = forgotten;
+	entry.stats.rememberedEntities = map.getEntities().size();
+	entry.rememberedEntities->set(static_cast<std::int64_t>(entry.stats.rememberedEntities));
+	entry.entityMemories->set(static_cast<std::int64_t>(map.getEntityRelatedMemory().size()));
+}
+
+void MindScheduler::removeMemoryMetrics(long id) {
+	Metrics::Labels labels{{"mind", std::to_string(id)}};
+	Metrics::instance().remove("mind_remembered_entities", labels);
+	Metrics::instance().remove("mind_entity_memories", labels);
+}
+
+std::optional<std::chrono::steady_clock::time_point> MindScheduler::getNextTickTime() const {
+	if (m_queue.empty()) {
+		return {};
+	}
+	return m_queue.begin()->first;
+}
+
+const MindScheduler::Stats* MindScheduler::getStats(const BaseMind& mind) const {
+	auto I = m_entries.find(mind.getIdAsInt());
+	if (I != m_entries.end()) {
+		return &I->second.stats;
+	}
+	return nullptr;
+}
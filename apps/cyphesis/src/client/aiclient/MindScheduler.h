@@ -0,0 +1,137 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_MINDSCHEDULER_H
+#define CYPHESIS_MINDSCHEDULER_H
+
+#include "rules/ai/BaseMind.h"
+#include "common/Metrics.h"
+#include "modules/Ref.h"
+
+#include <chrono>
+#include <optional>
+#include <set>
+#include <unordered_map>
+
+/**
+ * @brief Ticks minds only when they have something to do.
+ *
+ * Each mind is kept in a queue ordered by the time it next needs to be ticked, as reported by BaseMind::getNextTickTime().
+ * Whenever a mind has handled an operation it should be rescheduled, since that might have given it something to do.
+ *
+ * The scheduler also keeps track of how much time is spent on each mind, both when ticking it and when it handles operations,
+ * as well as how much each mind remembers.
+ */
+class MindScheduler {
+public:
+	struct Stats {
+		std::chrono::steady_clock::duration tickTime{};
+		std::chrono::steady_clock::duration operationTime{};
+		size_t ticks = 0;
+		size_t operations = 0;
+		/**
+		 * The number of entities remembered by the mind, the last time it was ticked or handled an operation.
+		 */
+		size_t rememberedEntities = 0;
+		size_t forgottenEntities = 0;
+	};
+
+	MindScheduler();
+
+	~MindScheduler();
+
+	/**
+	 * @brief Adds a mind, scheduling it according to when it next needs to be ticked.
+	 */
+	void add(Ref<BaseMind> mind);
+
+	void remove(const BaseMind& mind);
+
+	/**
+	 * @brief Updates when the mind should be ticked.
+	 *
+	 * Call this after the mind has handled an operation.
+	 */
+	void reschedule(const BaseMind& mind);
+
+	/**
+	 * @brief Records the time a mind spent handling an operation, and reschedules it.
+	 */
+	void operationHandled(const BaseMind& mind, std::chrono::steady_clock::duration duration);
+
+	/**
+	 * @brief Ticks all minds that are due.
+	 *
+	 * At least one mind is ticked, as long as any is due, even if that exceeds the max wall clock duration.
+	 * @param now The current time.
+	 * @param maxWallClockDuration How long to spend ticking minds, before leaving the rest for later.
+	 * @param res Any operations resulting from the ticks.
+	 * @return The number of minds ticked.
+	 */
+	size_t tickDue(std::chrono::steady_clock::time_point now, std::chrono::steady_clock::duration maxWallClockDuration, OpVector& res);
+
+	/**
+	 * @brief Gets the time when the next mind needs to be ticked, if any.
+	 */
+	std::optional<std::chrono::steady_clock::time_point> getNextTickTime() const;
+
+	const Stats* getStats(const BaseMind& mind) const;
+
+	size_t size() const {
+		return m_entries.size();
+	}
+
+	/**
+	 * If set to more than zero any mind which spends more time than this in a tick will be reported.
+	 */
+	std::chrono::steady_clock::duration m_slowTickReport;
+
+private:
+	struct Entry {
+		Ref<BaseMind> mind;
+		std::chrono::steady_clock::time_point due;
+		Stats stats;
+		Metrics::Gauge* rememberedEntities;
+		Metrics::Gauge* entityMemories;
+	};
+
+	/**
+	 * Minds by their id.
+	 */
+	std::unordered_map<long, Entry> m_entries;
+
+	/**
+	 * Minds ordered by the time they are due.
+	 * Minds which don't need to be ticked until they get an operation aren't included.
+	 */
+	std::set<std::pair<std::chrono::steady_clock::time_point, long>> m_queue;
+
+	Metrics::Histogram& m_tickDuration;
+	Metrics::Histogram& m_operationDuration;
+	Metrics::Gauge& m_dueMinds;
+	Metrics::Counter& m_forgottenEntities;
+
+	void schedule(long id, Entry& entry, std::chrono::steady_clock::time_point due);
+
+	void updateMemoryStats(Entry& entry);
+
+	void removeMemoryMetrics(long id);
+};
+
+
+#endif //CYPHESIS_MINDSCHEDULER_H
@@ -26,16 +26,20 @@
 #include "pythonbase/Python_API.h"
 
 #include "common/operations/Possess.h"
+#include "common/operations/Think.h"
 
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Entity.h>
 
+#include <sys/resource.h>
+
 
 static constexpr auto debug_flag = false;
 
 
 using Atlas::Message::Element;
 using Atlas::Message::MapType;
+using Atlas::Message::ListType;
 using Atlas::Objects::Root;
 using Atlas::Objects::Operation::RootOperation;
 using Atlas::Objects::Operation::Look;
@@ -86,17 +90,46 @@ void PossessionAccount::enablePossession(OpVector& res) {
 	res.push_back(set);
 }
 
+void PossessionAccount::reportLoad(OpVector& res) {
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	auto cpuTime = std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+				   + std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+
+	Atlas::Objects::Operation::Set set;
+	set->setTo(getIdAsString());
+	set->setFrom(getIdAsString());
+
+	Atlas::Objects::Entity::Anonymous args;
+	args->setId(getIdAsString());
+	args->setAttr("possession_load", MapType{
+			{"minds",    (Atlas::Message::IntType) m_minds.size()},
+			{"cpu_time", std::chrono::duration_cast<std::chrono::duration<double>>(cpuTime).count()}
+	});
+	args->setObjtype("object");
+
+	set->setArgs1(args);
+
+	res.push_back(set);
+}
+
+void PossessionAccount::removeMind(const Ref<BaseMind>& mind) {
+	spdlog::debug("Deleting mind {}.", mind->describeEntity());
+	m_client.getMindScheduler().remove(*mind);
+	m_minds.erase(RouterId(mind->getIdAsString()));
+	m_entitiesWithMinds.erase(RouterId(mind->getEntityId()));
+	mind_count--;
+}
+
 void PossessionAccount::operation(const Operation& op, OpVector& res) {
 	if (!op->isDefaultTo() && op->getTo() != getIdAsString()) {
 		auto I = m_minds.find(RouterId(op->getTo()));
 		if (I != m_minds.end()) {
-			I->second->operation(op, res);
+			auto mind = I->second;
+			deliverToMind(*mind, op, res);
 
-			if (I->second->isDestroyed()) {
-				spdlog::debug("Deleting mind {}.", I->second->describeEntity());
-				m_entitiesWithMinds.erase(RouterId(I->second->getEntity()->getIdAsString()));
-				m_minds.erase(I);
-				mind_count--;
+			if (mind->isDestroyed()) {
+				removeMind(mind);
 			}
 
 			return;
@@ -104,12 +137,10 @@ void PossessionAccount::operation(const Operation& op, OpVector& res) {
 
 		I = m_entitiesWithMinds.find(RouterId(op->getTo()));
 		if (I != m_entitiesWithMinds.end()) {
-			I->second->operation(op, res);
-			if (I->second->isDestroyed()) {
-				spdlog::debug("Deleting mind {}.", I->second->describeEntity());
-				m_minds.erase(RouterId(I->second->getIdAsString()));
-				mind_count--;
-				m_entitiesWithMinds.erase(I);
+			auto mind = I->second;
+			deliverToMind(*mind, op, res);
+			if (mind->isDestroyed()) {
+				removeMind(mind);
 			}
 
 			return;
@@ -131,7 +162,7 @@ void PossessionAccount::operation(const Operation& op, OpVector& res) {
 			rmt_ScopedCPUSample(opInfo, 0)
 			//Send info ops on to all minds
 			for (auto& entry: m_minds) {
-				entry.second->operation(op, res);
+				deliverToMind(*entry.second, op, res);
 			}
 		} else {
 			spdlog::debug("Unknown operation {} in PossessionAccount {}", op->getParent(), getIdAsString());
@@ -139,6 +170,13 @@ void PossessionAccount::operation(const Operation& op, OpVector& res) {
 	}
 }
 
+void PossessionAccount::deliverToMind(BaseMind& mind, const Operation& op, OpVector& res) {
+	auto start = std::chrono::steady_clock::now();
+	mind.operation(op, res);
+	//The operation might have given the mind something to do, so it might need to be ticked earlier.
+	m_client.getMindScheduler().operationHandled(mind, std::chrono::steady_clock::now() - start);
+}
+
 Ref<BaseMind> PossessionAccount::findMindForId(const RouterId& id) {
 
 	auto I = m_minds.find(id);
@@ -161,6 +199,16 @@ void PossessionAccount::PossessOperation(const Operation& op, OpVector& res) {
 	if (!args.empty()) {
 		const Root& arg = args.front();
 
+		//The server might ask us to let go of a mind, so it can be moved to a less loaded client.
+		Element relinquishElement;
+		if (arg->copyAttr("relinquish", relinquishElement) == 0 && relinquishElement.isInt() && relinquishElement.Int() != 0) {
+			Element possessionEntityIdElement;
+			if (arg->copyAttr("possess_entity_id", possessionEntityIdElement) == 0 && possessionEntityIdElement.isString()) {
+				relinquishMind(res, possessionEntityIdElement.String());
+			}
+			return;
+		}
+
 		Element possessKeyElement;
 		if (arg->copyAttr("possess_key", possessKeyElement) == 0 && possessKeyElement.isString()) {
 			Element possessionEntityIdElement;
@@ -230,6 +278,48 @@ void PossessionAccount::takePossession(OpVector&, const std::string& possessEnti
 	//res.push_back(possess);
 }
 
+void PossessionAccount::relinquishMind(OpVector& res, const std::string& entityId) {
+	auto I = m_entitiesWithMinds.find(RouterId(entityId));
+	if (I == m_entitiesWithMinds.end()) {
+		spdlog::warn("Asked to relinquish mind of entity {}, which we don't have any mind for.", entityId);
+		return;
+	}
+	auto mind = I->second;
+	spdlog::info("Relinquishing mind {} of entity {}.", mind->getIdAsString(), entityId);
+
+	//A Think op with an empty Get makes the mind return all of its thoughts, as a Think op wrapping a Set op.
+	Atlas::Objects::Operation::Think think;
+	think->setArgs1(Atlas::Objects::Operation::Get());
+	think->setTo(mind->getIdAsString());
+	think->setFrom(entityId);
+	OpVector thinkRes;
+	mind->operation(think, thinkRes);
+
+	ListType thoughts;
+	for (auto& resOp: thinkRes) {
+		if (resOp->getClassNo() == Atlas::Objects::Operation::THINK_NO && !resOp->getArgs().empty()) {
+			auto setOp = Atlas::Objects::smart_dynamic_cast<Operation>(resOp->getArgs().front());
+			if (setOp.isValid() && setOp->getClassNo() == Atlas::Objects::Operation::SET_NO) {
+				for (auto& thought: setOp->getArgs()) {
+					thoughts.push_back(thought->asMessage());
+				}
+			}
+		}
+	}
+
+	Anonymous logoutArg;
+	logoutArg->setId(mind->getIdAsString());
+	logoutArg->setAttr("thoughts", std::move(thoughts));
+
+	Atlas::Objects::Operation::Logout logout;
+	logout->setFrom(getIdAsString());
+	logout->setArgs1(logoutArg);
+	res.push_back(logout);
+
+	mind->destroy();
+	removeMind(mind);
+}
+
 void PossessionAccount::createMindInstance(OpVector& res, RouterId mindId, const std::string& entityId) {
 	spdlog::info("Creating mind instance for entity id {} with mind id {}, number of minds: {}.", entityId, mindId.asString(), m_minds.size() + 1);
 	Ref<BaseMind> mind = m_mindFactory.newMind(mindId, entityId);
@@ -240,5 +330,7 @@ void PossessionAccount::createMindInstance(OpVector& res, RouterId mindId, const
 	mind->m_scriptFactory = m_mindFactory.m_scriptFactory.get();
 	OpVector mindRes;
 	mind->init(mindRes);
+	m_client.getMindScheduler().add(mind);
 	m_client.processResponses(mindRes, res);
+	m_client.scheduleMindTicks();
 }
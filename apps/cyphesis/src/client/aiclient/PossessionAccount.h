@@ -45,6 +45,13 @@ public:
 	 */
 	void enablePossession(OpVector& res);
 
+	/**
+	 * Reports the load of this client to the server, which uses it when deciding which client should possess new minds.
+	 *
+	 * The load consists of the number of minds, and the total CPU time used by the process.
+	 */
+	void reportLoad(OpVector& res);
+
 	void operation(const Operation& op, OpVector& res) override;
 
 	const std::map<RouterId, Ref<BaseMind>>& getMinds() const {
@@ -81,8 +88,22 @@ protected:
 
 	void takePossession(OpVector& res, const std::string& possessEntityId, const std::string& possessKey);
 
+	/**
+	 * Logs out the mind controlling an entity, as requested by the server when migrating it to another client.
+	 *
+	 * The thoughts of the mind are sent along with the logout, so that they can be handed to the mind which takes over.
+	 */
+	void relinquishMind(OpVector& res, const std::string& entityId);
+
+	void removeMind(const Ref<BaseMind>& mind);
+
 	void createMindInstance(OpVector& res, RouterId mindId, const std::string& entityId);
 
+	/**
+	 * Delivers an operation to a mind, keeping track of the time spent and rescheduling it.
+	 */
+	void deliverToMind(BaseMind& mind, const Operation& op, OpVector& res);
+
 };
 
 #endif /* AICLIENT_POSSESSIONACCOUNT_H_ */
@@ -38,6 +38,13 @@ using Atlas::Objects::Root;
 using Atlas::Objects::Entity::Anonymous;
 using Atlas::Objects::Operation::RootOperation;
 
+namespace {
+/**
+ * How often the load is reported to the server.
+ */
+constexpr auto loadReportInterval = std::chrono::seconds(5);
+}
+
 size_t PossessionClient::operations_in = 0;
 size_t PossessionClient::operations_out = 0;
 
@@ -52,7 +59,15 @@ PossessionClient::PossessionClient(CommSocket& commSocket,
 		m_operationsDispatcher([&](const Operation& op, Ref<BaseMind> from) { this->operationFromEntity(op, std::move(from)); },
 							   [&]() -> std::chrono::steady_clock::duration { return getTime(); }),
 		m_dispatcherTimer(commSocket.m_io_context),
-		m_serverLocalTimeDiff(0) {
+		m_mindTickTimer(commSocket.m_io_context),
+		m_serverLocalTimeDiff(0),
+		m_loadReportTask(commSocket.m_io_context, loadReportInterval, [&]() {
+			if (m_account) {
+				OpVector res;
+				m_account->reportLoad(res);
+				send(res);
+			}
+		}) {
 
 
 }
@@ -69,6 +84,7 @@ void PossessionClient::notifyAccountCreated(RouterId accountId) {
 	m_account = std::make_unique<PossessionAccount>(accountId, m_mindFactory, *this);
 	OpVector res;
 	m_account->enablePossession(res);
+	m_account->reportLoad(res);
 	for (auto& op: res) {
 		send(op);
 	}
@@ -153,6 +169,7 @@ void PossessionClient::processOperation(const Operation& op, OpVector& res) {
 	OpVector accountRes;
 	m_account->operation(op, accountRes);
 	processResponses(accountRes, res);
+	scheduleMindTicks();
 }
 
 std::chrono::steady_clock::duration PossessionClient::getTime() const {
@@ -178,3 +195,31 @@ void PossessionClient::scheduleDispatch() {
 	});
 
 }
+
+void PossessionClient::scheduleMindTicks() {
+	auto nextTickTime = m_mindScheduler.getNextTickTime();
+	if (!nextTickTime) {
+		return;
+	}
+	//No need to touch the timer if it's already set to expire in time.
+	if (m_mindTickTimerExpiry && *m_mindTickTimerExpiry <= *nextTickTime) {
+		return;
+	}
+	m_mindTickTimerExpiry = *nextTickTime;
+	//This cancels any earlier wait.
+	m_mindTickTimer.expires_at(*nextTickTime);
+
+	m_mindTickTimer.async_wait([&](boost::system::error_code ec) {
+		if (!ec) {
+			m_mindTickTimerExpiry = {};
+			//Tick all minds that are due in one go, but don't hog the io_context if there are a lot of them.
+			OpVector tickRes;
+			m_mindScheduler.tickDue(std::chrono::steady_clock::now(), std::chrono::milliseconds(5), tickRes);
+			OpVector res;
+			processResponses(tickRes, res);
+			operations_out += res.size();
+			send(res);
+			scheduleMindTicks();
+		}
+	});
+}
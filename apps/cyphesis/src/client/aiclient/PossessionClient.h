@@ -23,6 +23,8 @@
 #include "rules/ai/BaseMind.h"
 #include "common/OperationsDispatcher.h"
 #include "common/OperationsDispatcher_impl.h"
+#include "MindScheduler.h"
+#include "common/RepeatedTask.h"
 #include <map>
 #include <unordered_map>
 
@@ -45,6 +47,17 @@ public:
 
 	void processResponses(const OpVector& incomingRes, OpVector& outgoingRes);
 
+	MindScheduler& getMindScheduler() {
+		return m_mindScheduler;
+	}
+
+	/**
+	 * @brief Makes sure that minds are ticked when the next one is due.
+	 *
+	 * Call this whenever a mind has been added or has handled an operation.
+	 */
+	void scheduleMindTicks();
+
 	static size_t operations_in;
 	static size_t operations_out;
 
@@ -76,6 +89,15 @@ protected:
 
 	boost::asio::steady_timer m_dispatcherTimer;
 
+	MindScheduler m_mindScheduler;
+
+	boost::asio::steady_timer m_mindTickTimer;
+
+	/**
+	 * When the mind tick timer is set to expire, if it's set.
+	 */
+	std::optional<std::chrono::steady_clock::time_point> m_mindTickTimerExpiry;
+
 	/**
 	 * Keep track of the difference between the server time and our local time.
 	 * This is needed when scheduling operations locally. When they are later dispatched
@@ -83,6 +105,11 @@ protected:
 	 */
 	std::chrono::milliseconds m_serverLocalTimeDiff;
 
+	/**
+	 * Periodically reports our load to the server.
+	 */
+	RepeatedTask m_loadReportTask;
+
 
 };
 
@@ -36,6 +36,7 @@
 #include "common/MainLoop.h"
 #include "common/CommAsioClient.h"
 #include "common/CommAsioClient_impl.h"
+#include "common/net/SharedMemoryChannel.h"
 #include "common/AssetsManager.h"
 #include "common/FileSystemObserver.h"
 #include "common/operations/Think.h"
@@ -53,6 +54,7 @@
 #include "rules/simulation/Inheritance.h"
 #include <varconf/config.h>
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 
@@ -70,6 +72,15 @@ namespace {
 INT_OPTION(http_port_num, 6790, CYPHESIS, "httpport",
 		   "Network listen port for http connection to the client")
 
+BOOL_OPTION(ai_shared_memory, false, CYPHESIS, "aisharedmemory",
+			"Flag to control if the server should be contacted through shared memory instead of a socket")
+
+INT_OPTION(mind_memory_entities, 0, CYPHESIS, "mindmemoryentities",
+		   "The max number of entities each mind remembers, or 0 for no limit")
+
+INT_OPTION(mind_memory_forget_time, 600, CYPHESIS, "mindmemoryforgettime",
+		   "Seconds after which a mind forgets an entity it hasn't seen")
+
 void usage(const char* prgname) {
 	std::cout << "usage: " << prgname << " [ local_socket_path ]" << std::endl;
 }
@@ -81,64 +92,92 @@ void connectToServer(boost::asio::io_context& io_context, AwareMindFactory& mind
 	auto commClient = std::make_shared<CommAsioClient<boost::asio::local::stream_protocol>>
 			("aiclient", io_context, AtlasFactories::factories);
 
-	commClient->getSocket().async_connect({client_socket_name}, [&io_context, &mindFactory, commClient](boost::system::error_code ec) {
-		if (!ec) {
-			spdlog::info("Connection detected; creating possession client.");
-
-			/**
-			 * The Flusher will flush the comm socket every ten milliseconds, as long as the connection is alive.
-			 */
-			struct Flusher : public std::enable_shared_from_this<Flusher> {
-				boost::asio::io_context& io_context;
-				std::weak_ptr<CommAsioClient<boost::asio::local::stream_protocol>> commClient;
-				boost::asio::steady_timer timer{io_context};
-				std::chrono::steady_clock::duration flushInterval;
-
-				Flusher(boost::asio::io_context& _io_context,
-						std::weak_ptr<CommAsioClient<boost::asio::local::stream_protocol>>
-						_commClient,
-						std::chrono::steady_clock::duration _flushInterval
-				) : io_context(_io_context),
-					commClient(std::move(_commClient)),
-					flushInterval(_flushInterval) {}
-
-				void flush() {
-					if (auto client = commClient.lock()) {
-						if (client->m_active && client->getSocket().is_open()) {
-							rmt_ScopedCPUSample(Flusher_flush, 0)
-							client->flush();
-							timer.expires_after(flushInterval);
-							auto self(this->shared_from_this());
-							auto waitFn = [self](boost::system::error_code ecInner) {
-								if (!ecInner) {
-									self->flush();
-								}
-							};
-							timer.async_wait(waitFn);
-						}
+	/**
+	 * Starts the connection once the socket, and possibly the shared memory, is set up.
+	 */
+	auto startClient = [&io_context, &mindFactory, commClient]() {
+		spdlog::info("Connection detected; creating possession client.");
+
+		/**
+		 * The Flusher will flush the comm socket every ten milliseconds, as long as the connection is alive.
+		 */
+		struct Flusher : public std::enable_shared_from_this<Flusher> {
+			boost::asio::io_context& io_context;
+			std::weak_ptr<CommAsioClient<boost::asio::local::stream_protocol>> commClient;
+			boost::asio::steady_timer timer{io_context};
+			std::chrono::steady_clock::duration flushInterval;
+
+			Flusher(boost::asio::io_context& _io_context,
+					std::weak_ptr<CommAsioClient<boost::asio::local::stream_protocol>>
+					_commClient,
+					std::chrono::steady_clock::duration _flushInterval
+			) : io_context(_io_context),
+				commClient(std::move(_commClient)),
+				flushInterval(_flushInterval) {}
+
+			void flush() {
+				if (auto client = commClient.lock()) {
+					if (client->m_active && client->getSocket().is_open()) {
+						rmt_ScopedCPUSample(Flusher_flush, 0)
+						client->flush();
+						timer.expires_after(flushInterval);
+						auto self(this->shared_from_this());
+						auto waitFn = [self](boost::system::error_code ecInner) {
+							if (!ecInner) {
+								self->flush();
+							}
+						};
+						timer.async_wait(waitFn);
 					}
 				}
-			};
-			auto flusher = std::make_shared<Flusher>(io_context, commClient, std::chrono::milliseconds(10));
-			flusher->flush();
+			}
+		};
+		auto flusher = std::make_shared<Flusher>(io_context, commClient, std::chrono::milliseconds(10));
+		flusher->flush();
 
 
-			commClient->startConnect(std::make_unique<PossessionClient>(*commClient, mindFactory, [&]() {
-				connectToServer(io_context, mindFactory);
-			}));
-		} else {
-			//If we couldn't connect we'll wait five seconds and try again.
-			auto timer = std::make_shared<boost::asio::steady_timer>(io_context);
+		commClient->startConnect(std::make_unique<PossessionClient>(*commClient, mindFactory, [&]() {
+			connectToServer(io_context, mindFactory);
+		}));
+	};
+
+	/**
+	 * If we couldn't connect we'll wait five seconds and try again.
+	 */
+	auto retry = [&io_context, &mindFactory]() {
+		auto timer = std::make_shared<boost::asio::steady_timer>(io_context);
 #if BOOST_VERSION >= 106600
-			timer->expires_after(std::chrono::seconds(5));
+		timer->expires_after(std::chrono::seconds(5));
 #else
-			timer->expires_from_now(std::chrono::seconds(5));
+		timer->expires_from_now(std::chrono::seconds(5));
 #endif
-			timer->async_wait([&io_context, &mindFactory, timer](boost::system::error_code ecInner) {
-				if (!ecInner) {
-					connectToServer(io_context, mindFactory);
-				}
-			});
+		timer->async_wait([&io_context, &mindFactory, timer](boost::system::error_code ecInner) {
+			if (!ecInner) {
+				connectToServer(io_context, mindFactory);
+			}
+		});
+	};
+
+	auto& socketName = ai_shared_memory ? shared_memory_socket_name : client_socket_name;
+	commClient->getSocket().async_connect({socketName}, [&io_context, commClient, startClient, retry](boost::system::error_code ec) {
+		if (!ec) {
+			if (ai_shared_memory) {
+				//The server hands over the shared memory as soon as we've connected.
+				SharedMemoryChannel::asyncReceive(io_context, commClient->getSocket(), [commClient, startClient, retry](std::shared_ptr<SharedMemoryChannel> channel) {
+					if (!channel) {
+						spdlog::error("Could not set up shared memory with the server.");
+						commClient->getSocket().close();
+						retry();
+						return;
+					}
+					commClient->useSharedMemory(std::move(channel));
+					startClient();
+				});
+			} else {
+				startClient();
+			}
+		} else {
+			retry();
 		}
 	});
 }
@@ -213,6 +252,8 @@ int main(int argc, char** argv) {
 			boost::asio::thread_pool httpThreadPool {1};
 			HttpHandling httpCache(monitors, io_context);
 			AwareMindFactory mindFactory(typeStore);
+			mindFactory.m_memoryLimits.maxEntities = static_cast<size_t>(std::max(mind_memory_entities, 0));
+			mindFactory.m_memoryLimits.forgetAfter = std::chrono::seconds(mind_memory_forget_time);
 
 			AssetsManager assets_manager(std::make_unique<FileSystemObserver>(io_context));
 
@@ -290,6 +331,7 @@ int main(int argc, char** argv) {
 			spdlog::info(" /config : shows client configuration");
 			spdlog::info(" /monitors : various monitored values, suitable for time series systems");
 			spdlog::info(" /monitors/numerics : only numerical values, suitable for time series system that only operates on numerical data");
+			spdlog::info(" /metrics : counters, gauges and histograms in the Prometheus format, together with the numerical monitored values");
 
 			monitors.watch("accounts", PossessionAccount::account_count);
 			monitors.watch("minds", PossessionAccount::mind_count);
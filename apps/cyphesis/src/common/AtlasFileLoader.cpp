@@ -37,6 +37,7 @@ void AtlasFileLoader::objectArrived(Root obj) {
 		std::stringstream ss;
 		debug_dump(obj, ss);
 		spdlog::error("Object: " + ss.str());
+		++m_errorCount;
 		return;
 	}
 	const std::string& id = obj->getId();
@@ -56,7 +57,7 @@ AtlasFileLoader::AtlasFileLoader(const Atlas::Objects::Factories& factories,
 								 std::map<std::string, Root>& m) :
 		ObjectsDecoder(factories),
 		m_file(filename.c_str(), std::ios::in),
-		m_count(0), m_messages(m), m_filename(filename) {
+		m_count(0), m_errorCount(0), m_messages(m), m_filename(filename) {
 	m_codec = std::make_unique<Atlas::Codecs::XML>(m_file, m_file, *this);
 }
 
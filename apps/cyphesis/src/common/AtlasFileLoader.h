@@ -35,6 +35,8 @@ private:
 	std::unique_ptr<Atlas::Codec> m_codec;
 	/// Counter for messages read from input
 	int m_count;
+	/// Counter for messages which couldn't be loaded
+	int m_errorCount;
 	/// Store for the messages loaded
 	std::map<std::string, Atlas::Objects::Root>& m_messages;
 
@@ -55,6 +57,9 @@ public:
 
 	/// \brief Read only accessor for the number of messages loaded
 	int count() { return m_count; }
+
+	/// \brief Read only accessor for the number of messages which couldn't be loaded
+	int errorCount() { return m_errorCount; }
 };
 
 #endif // COMMON_ATLAS_FILE_LOADER_H
@@ -21,16 +21,20 @@
 
 #include "common/Link.h"
 #include "common/CommSocket.h"
+#include "common/Metrics.h"
+#include "common/net/SharedMemoryChannel.h"
 
 #include <Atlas/Objects/Decoder.h>
 #include <Atlas/Objects/ObjectsFwd.h>
 #include <Atlas/Codec.h>
+#include <Atlas/Filter.h>
 #include <Atlas/Negotiate.h>
 
 #include <boost/asio.hpp>
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/steady_timer.hpp>
 
+#include <chrono>
 #include <memory>
 #include <sstream>
 #include <deque>
@@ -48,9 +52,19 @@ public:
 
 	typename ProtocolT::socket& getSocket();
 
-	void startAccept(std::unique_ptr<Link> connection);
+	/**
+	 * @param allowCompression True if the connection should be compressed, if the client supports it.
+	 */
+	void startAccept(std::unique_ptr<Link> connection, bool allowCompression = false);
+
+	void startConnect(std::unique_ptr<Link> connection, bool allowCompression = false);
 
-	void startConnect(std::unique_ptr<Link> connection);
+	/**
+	 * Sends and receives all data through the shared memory channel instead of the socket.
+	 * The socket is still kept open, to detect when the other end goes away.
+	 * Must be called before starting the connection.
+	 */
+	void useSharedMemory(std::shared_ptr<SharedMemoryChannel> channel);
 
 	int send(const Atlas::Objects::Operation::RootOperation&);
 
@@ -125,6 +139,18 @@ protected:
 		read_buffer_size = 16384
 	};
 
+	/// \brief Filter, such as compression, which all traffic passes through after negotiation. Null if none.
+	std::unique_ptr<Atlas::Filter> m_filter;
+	/// \brief Decodes data from mReadBuffer through the filter. Only set if there's a filter.
+	std::unique_ptr<Atlas::filterbuf> m_inFilterBuffer;
+	/// \brief Encodes data through the filter into mWriteBuffer. Only set if there's a filter.
+	std::unique_ptr<Atlas::filterbuf> m_outFilterBuffer;
+	/// \brief When filter metrics were last published.
+	std::chrono::steady_clock::time_point m_filterMetricsUpdated;
+
+	/// \brief Used instead of the socket for data, if set.
+	std::shared_ptr<SharedMemoryChannel> m_sharedMemory;
+
 	/// \brief Atlas codec that handles encoding and decoding traffic.
 	std::unique_ptr<Atlas::Codec> m_codec;
 	/// \brief high level encoder passes data to the codec for transmission.
@@ -138,6 +164,18 @@ protected:
 
 	void do_read();
 
+	/**
+	 * Reads from either the socket or the shared memory channel.
+	 */
+	template<typename Handler>
+	void readSome(boost::asio::mutable_buffer buffer, Handler handler);
+
+	/**
+	 * Writes to either the socket or the shared memory channel.
+	 */
+	template<typename Handler>
+	void writeAll(boost::asio::const_buffer buffer, Handler handler);
+
 	void write();
 
 	void startNegotiation();
@@ -151,6 +189,14 @@ protected:
 
 	void externalOperation(Atlas::Objects::Operation::RootOperation);
 
+	/**
+	 * Publishes the bytes passed through the filter, before and after, and the time spent in the filter for this connection.
+	 * The compression ratio is the quotient of the byte counts.
+	 */
+	void updateFilterMetrics();
+
+	Metrics::Labels filterMetricLabels(const char* direction) const;
+
 	void objectArrived(Atlas::Objects::Root obj) override;
 };
 
@@ -20,6 +20,7 @@
 #define COMMASIOCLIENT_IMPL_H_
 
 #include "common/log.h"
+#include "common/Metrics.h"
 
 #include "CommAsioClient.h"
 #include "Remotery.h"
@@ -56,6 +57,17 @@ CommAsioClient<ProtocolT>::CommAsioClient(std::string name,
 
 template<class ProtocolT>
 CommAsioClient<ProtocolT>::~CommAsioClient() {
+	if (m_sharedMemory) {
+		m_sharedMemory->close();
+	}
+	if (m_filter && m_link) {
+		for (auto direction: {"in", "out"}) {
+			auto labels = filterMetricLabels(direction);
+			Metrics::instance().remove("connection_unfiltered_bytes", labels);
+			Metrics::instance().remove("connection_filtered_bytes", labels);
+			Metrics::instance().remove("connection_filter_cpu_us", labels);
+		}
+	}
 	try {
 		mSocket.shutdown(ProtocolT::socket::shutdown_both);
 	} catch (const std::exception& e) {
@@ -94,42 +106,73 @@ std::string socketName(const boost::asio::ip::tcp::socket& socket) {
 }
 }
 
+template<class ProtocolT>
+template<typename Handler>
+void CommAsioClient<ProtocolT>::readSome(boost::asio::mutable_buffer buffer, Handler handler) {
+	if (m_sharedMemory) {
+		m_sharedMemory->async_read_some(buffer, std::move(handler));
+	} else {
+		mSocket.async_read_some(buffer, std::move(handler));
+	}
+}
+
+template<class ProtocolT>
+template<typename Handler>
+void CommAsioClient<ProtocolT>::writeAll(boost::asio::const_buffer buffer, Handler handler) {
+	if (m_sharedMemory) {
+		m_sharedMemory->async_write(buffer, std::move(handler));
+	} else {
+		boost::asio::async_write(mSocket, buffer, std::move(handler));
+	}
+}
+
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::do_read() {
 	auto self(this->shared_from_this());
-	mSocket.async_read_some(mReadBuffer.prepare(read_buffer_size),
-							[this, self](boost::system::error_code ec, std::size_t length) {
-								if (!ec) {
-									rmt_ScopedCPUSample(read, 0)
-									mReadBuffer.commit(length);
-									m_codec->poll();
-									if (m_active) {
-										//By calling do_read again we make sure that the instance
-										//doesn't go out of scope ("shared_from this"). As soon as that
-										//doesn't happen, and there's no write in progress, the instance
-										//will be deleted since there's no more references to it.
-										this->do_read();
-									}
-								} else {
-									//No need to read if connection has been actively shut down.
-									if (m_active) {
-										std::stringstream ss;
-										spdlog::level::level_enum level = spdlog::level::warn;
-										if (ec == boost::asio::error::eof) {
-											ss << fmt::format("Connection at '{}' hung up unexpectedly.", socketName(mSocket));
-											level = spdlog::level::debug;
-										} else {
-											ss << fmt::format("Error when reading from socket at '{}': (", socketName(mSocket)) << ec << ") " << ec.message();
-
-										}
-										spdlog::log(level, ss.str());
-									}
-								}
-							});
+	readSome(mReadBuffer.prepare(read_buffer_size),
+			 [this, self](boost::system::error_code ec, std::size_t length) {
+				 if (!ec) {
+					 rmt_ScopedCPUSample(read, 0)
+					 mReadBuffer.commit(length);
+					 try {
+						 m_codec->poll();
+					 } catch (const std::exception& e) {
+						 //Corrupt data, most likely from a filter; the connection can't be recovered.
+						 spdlog::warn("Error when decoding data from '{}': {}", socketName(mSocket), e.what());
+						 return;
+					 }
+					 if (m_active) {
+						 //By calling do_read again we make sure that the instance
+						 //doesn't go out of scope ("shared_from this"). As soon as that
+						 //doesn't happen, and there's no write in progress, the instance
+						 //will be deleted since there's no more references to it.
+						 this->do_read();
+					 }
+				 } else {
+					 //No need to read if connection has been actively shut down.
+					 if (m_active) {
+						 std::stringstream ss;
+						 spdlog::level::level_enum level = spdlog::level::warn;
+						 if (ec == boost::asio::error::eof) {
+							 ss << fmt::format("Connection at '{}' hung up unexpectedly.", socketName(mSocket));
+							 level = spdlog::level::debug;
+						 } else {
+							 ss << fmt::format("Error when reading from socket at '{}': (", socketName(mSocket)) << ec << ") " << ec.message();
+
+						 }
+						 spdlog::log(level, ss.str());
+					 }
+				 }
+			 });
 }
 
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::write() {
+	if (m_outFilterBuffer) {
+		//The filter holds on to any data until flushed.
+		mOutStream.flush();
+		updateFilterMetrics();
+	}
 	if (mWriteBuffer->size() != 0) {
 		if (mIsSending) {
 			//We're already sending in the background.
@@ -144,68 +187,72 @@ void CommAsioClient<ProtocolT>::write() {
 		auto self(this->shared_from_this());
 		//Swap places between writing buffer and sending buffer, and attach new write buffer to the out stream.
 		std::swap(mWriteBuffer, mSendBuffer);
-		mOutStream.rdbuf(mWriteBuffer.get());
+		if (m_outFilterBuffer) {
+			m_outFilterBuffer->setStreamBuffer(*mWriteBuffer);
+		} else {
+			mOutStream.rdbuf(mWriteBuffer.get());
+		}
 		mIsSending = true;
 
-		boost::asio::async_write(mSocket, *mSendBuffer,
-								 [this, self](boost::system::error_code ec, std::size_t length) {
-									 mIsSending = false;
-									 if (!ec) {
-										 rmt_ScopedCPUSample(write, 0)
-										 mSendBuffer->consume(length);
-										 //Is there data queued for transmission which we should send right away?
-										 if (mShouldSend) {
-											 this->write();
-										 }
-									 } else {
-										 //No need to write if connection has been actively shut down.
-										 if (m_active) {
-											 std::stringstream ss;
-											 spdlog::level::level_enum level = spdlog::level::warn;
-											 if (ec == boost::asio::error::eof) {
-												 ss << fmt::format("Connection at '{}' hung up unexpectedly.", socketName(mSocket));
-												 level = spdlog::level::debug;
-											 } else {
-												 ss << fmt::format("Error when reading from socket at '{}': (", socketName(mSocket)) << ec << ") " << ec.message();
-
-											 }
-											 spdlog::log(level, ss.str());
-										 }
-
-									 }
-								 });
+		writeAll(mSendBuffer->data(),
+				 [this, self](boost::system::error_code ec, std::size_t length) {
+					 mIsSending = false;
+					 if (!ec) {
+						 rmt_ScopedCPUSample(write, 0)
+						 mSendBuffer->consume(length);
+						 //Is there data queued for transmission which we should send right away?
+						 if (mShouldSend) {
+							 this->write();
+						 }
+					 } else {
+						 //No need to write if connection has been actively shut down.
+						 if (m_active) {
+							 std::stringstream ss;
+							 spdlog::level::level_enum level = spdlog::level::warn;
+							 if (ec == boost::asio::error::eof) {
+								 ss << fmt::format("Connection at '{}' hung up unexpectedly.", socketName(mSocket));
+								 level = spdlog::level::debug;
+							 } else {
+								 ss << fmt::format("Error when reading from socket at '{}': (", socketName(mSocket)) << ec << ") " << ec.message();
+
+							 }
+							 spdlog::log(level, ss.str());
+						 }
+
+					 }
+				 });
 	}
 }
 
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::negotiate_read() {
 	auto self(this->shared_from_this());
-	mSocket.async_read_some(mReadBuffer.prepare(read_buffer_size),
-							[this, self](boost::system::error_code ec, std::size_t length) {
-								if (!ec && m_active) {
-									mReadBuffer.commit(length);
-									if (length > 0) {
-										int negotiateResult = this->negotiate();
-										if (negotiateResult < 0) {
-											//this should remove any shared references and delete this instance
-											return;
-										}
-									}
-
-									//If the m_negotiate instance is removed we're done with negotiation and should start the main loop.
-									if (m_negotiate == nullptr) {
-										this->write();
-										this->do_read();
-									} else {
-										this->negotiate_write();
-										this->negotiate_read();
-									}
-								} else {
-									//If connection is shut down, we should consider this as an aborted negotiaton
-									m_negotiate.reset();
-									mNegotiateTimer.cancel();
-								}
-							});
+	readSome(mReadBuffer.prepare(read_buffer_size),
+			 [this, self](boost::system::error_code ec, std::size_t length) {
+				 if (!ec && m_active) {
+					 mReadBuffer.commit(length);
+					 if (length > 0) {
+						 int negotiateResult = this->negotiate();
+						 if (negotiateResult < 0) {
+							 //this should remove any shared references and delete this instance
+							 return;
+						 }
+					 }
+
+					 //If the m_negotiate instance is removed we're done with negotiation and should start the main loop.
+					 if (m_negotiate == nullptr) {
+						 this->write();
+						 this->do_read();
+					 } else {
+						 this->negotiate_write();
+						 this->negotiate_read();
+					 }
+				 } else {
+					 //If connection is shut down, we should consider this as an aborted negotiaton
+					 m_negotiate.reset();
+					 mNegotiateTimer.cancel();
+				 }
+			 });
 }
 
 template<class ProtocolT>
@@ -213,19 +260,19 @@ void CommAsioClient<ProtocolT>::negotiate_write() {
 	auto self(this->shared_from_this());
 
 	if (mWriteBuffer->size() != 0) {
-		boost::asio::async_write(mSocket, mWriteBuffer->data(),
-								 [this, self](boost::system::error_code ec, std::size_t length) {
-									 if (!ec && m_active) {
-										 mWriteBuffer->consume(length);
-									 }
-								 });
+		writeAll(mWriteBuffer->data(),
+				 [this, self](boost::system::error_code ec, std::size_t length) {
+					 if (!ec && m_active) {
+						 mWriteBuffer->consume(length);
+					 }
+				 });
 	}
 }
 
 template<class ProtocolT>
-void CommAsioClient<ProtocolT>::startAccept(std::unique_ptr<Link> connection) {
+void CommAsioClient<ProtocolT>::startAccept(std::unique_ptr<Link> connection, bool allowCompression) {
 	// Create the server side negotiator
-	m_negotiate = std::make_unique<Atlas::Net::StreamAccept>("cyphesis " + mName, mInStream, mOutStream);
+	m_negotiate = std::make_unique<Atlas::Net::StreamAccept>("cyphesis " + mName, mInStream, mOutStream, allowCompression);
 
 	m_link = std::move(connection);
 
@@ -233,15 +280,28 @@ void CommAsioClient<ProtocolT>::startAccept(std::unique_ptr<Link> connection) {
 }
 
 template<class ProtocolT>
-void CommAsioClient<ProtocolT>::startConnect(std::unique_ptr<Link> connection) {
+void CommAsioClient<ProtocolT>::startConnect(std::unique_ptr<Link> connection, bool allowCompression) {
 	// Create the client side negotiator
-	m_negotiate = std::make_unique<Atlas::Net::StreamConnect>("cyphesis " + mName, mInStream, mOutStream);
+	m_negotiate = std::make_unique<Atlas::Net::StreamConnect>("cyphesis " + mName, mInStream, mOutStream, allowCompression);
 
 	m_link = std::move(connection);
 
 	startNegotiation();
 }
 
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::useSharedMemory(std::shared_ptr<SharedMemoryChannel> channel) {
+	m_sharedMemory = std::move(channel);
+	//Nothing more is sent over the socket, so it only becomes readable when the other end hangs up.
+	auto self(this->shared_from_this());
+	mSocket.async_wait(ProtocolT::socket::wait_read, [this, self](boost::system::error_code ec) {
+		if (m_active) {
+			spdlog::debug("Shared memory connection at '{}' hung up.", socketName(mSocket));
+		}
+		m_sharedMemory->close();
+	});
+}
+
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::startNegotiation() {
 	auto self(this->shared_from_this());
@@ -256,6 +316,9 @@ void CommAsioClient<ProtocolT>::startNegotiation() {
 		if (m_negotiate != nullptr) {
 			spdlog::debug("Client at '{}' disconnected because of negotiation timeout.", socketName(mSocket));
 			mSocket.close();
+			if (m_sharedMemory) {
+				m_sharedMemory->close();
+			}
 		}
 	});
 
@@ -283,6 +346,7 @@ int CommAsioClient<ProtocolT>::negotiate() {
 
 	// Get the codec that negotiation established
 	m_codec = m_negotiate->getCodec(*this);
+	m_filter = m_negotiate->getFilter();
 
 	// Acceptor is now finished with
 	m_negotiate.reset();
@@ -291,6 +355,14 @@ int CommAsioClient<ProtocolT>::negotiate() {
 		spdlog::debug("Could not create codec during negotiation with '{}'.", socketName(mSocket));
 		return -1;
 	}
+	if (m_filter) {
+		// Everything after the negotiation passes through the filter.
+		m_inFilterBuffer = std::make_unique<Atlas::filterbuf>(mReadBuffer, *m_filter);
+		m_outFilterBuffer = std::make_unique<Atlas::filterbuf>(*mWriteBuffer, *m_filter);
+		mInStream.rdbuf(m_inFilterBuffer.get());
+		mOutStream.rdbuf(m_outFilterBuffer.get());
+	}
+
 	// Create a new encoder to send high level objects to the codec
 	m_encoder = std::make_unique<Atlas::Objects::ObjectsEncoder>(*m_codec);
 
@@ -305,6 +377,36 @@ int CommAsioClient<ProtocolT>::negotiate() {
 	return 0;
 }
 
+template<class ProtocolT>
+Metrics::Labels CommAsioClient<ProtocolT>::filterMetricLabels(const char* direction) const {
+	return {{"connection", m_link->getIdAsString()}, {"direction", direction}};
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::updateFilterMetrics() {
+	//Writes happen often, so don't update for every write.
+	auto now = std::chrono::steady_clock::now();
+	if (!m_link || now - m_filterMetricsUpdated < std::chrono::seconds(1)) {
+		return;
+	}
+	m_filterMetricsUpdated = now;
+
+	auto publish = [&](const char* direction, const Atlas::filterbuf::Statistics& statistics) {
+		if (statistics.unfilteredBytes == 0) {
+			return;
+		}
+		auto labels = filterMetricLabels(direction);
+		Metrics::instance().gauge("connection_unfiltered_bytes", "Bytes passed through the filter of a connection, before compression or after decompression.", labels)
+				.set(static_cast<std::int64_t>(statistics.unfilteredBytes));
+		Metrics::instance().gauge("connection_filtered_bytes", "Bytes passed through the filter of a connection, as sent or received.", labels)
+				.set(static_cast<std::int64_t>(statistics.filteredBytes));
+		Metrics::instance().gauge("connection_filter_cpu_us", "Time spent in the filter of a connection.", labels)
+				.set(std::chrono::duration_cast<std::chrono::microseconds>(statistics.filterTime).count());
+	};
+	publish("in", m_inFilterBuffer->getInStatistics());
+	publish("out", m_outFilterBuffer->getOutStatistics());
+}
+
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::externalOperation(Atlas::Objects::Operation::RootOperation op) {
 	assert(m_link != 0);
@@ -370,6 +472,9 @@ void CommAsioClient<ProtocolT>::disconnect() {
 	m_negotiate.reset();
 	mNegotiateTimer.cancel();
 	mSocket.cancel();
+	if (m_sharedMemory) {
+		m_sharedMemory->close();
+	}
 }
 
 template<class ProtocolT>
@@ -180,6 +180,10 @@ public:
 	/// Note that this method will access the database, so it's a fairly expensive method.
 	virtual long newId() = 0;
 
+	/// Makes sure that ids up to and including the specified one are never returned by newId().
+	/// Used when entities with existing ids are written to the database, for example when importing a snapshot.
+	virtual int reserveIds(long maxId) = 0;
+
 	// Interface for Entity and Property tables.
 
 	virtual int registerEntityTable() = 0;
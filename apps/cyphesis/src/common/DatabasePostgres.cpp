@@ -494,6 +494,26 @@ long DatabasePostgres::newId() {
 	return forceIntegerId(cid);
 }
 
+int DatabasePostgres::reserveIds(long maxId) {
+	assert(m_connection != nullptr);
+
+	clearPendingQuery();
+	//Never move the sequence backwards, since ids above maxId might already be in use.
+	auto query = fmt::format("SELECT setval('entity_ent_id_seq', GREATEST({}, (SELECT last_value FROM entity_ent_id_seq)))", maxId);
+	int status = PQsendQuery(m_connection, query.c_str());
+	if (!status) {
+		spdlog::error("reserveIds(): Database query error.");
+		reportError();
+		return -1;
+	}
+	if (!tuplesOk()) {
+		spdlog::error("Error reserving ids up to {}.", maxId);
+		reportError();
+		return -1;
+	}
+	return 0;
+}
+
 int DatabasePostgres::registerEntityTable(const std::map<std::string, int>& chunks) {
 	assert(m_connection != nullptr);
 
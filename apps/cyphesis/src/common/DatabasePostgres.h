@@ -97,6 +97,8 @@ public:
 	/// Note that this method will access the database, so it's a fairly expensive method.
 	long newId() override;
 
+	int reserveIds(long maxId) override;
+
 	int registerEntityIdGenerator() override;
 
 
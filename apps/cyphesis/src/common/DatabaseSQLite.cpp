@@ -297,14 +297,32 @@ long DatabaseSQLite::newId() {
 	return new_id;
 }
 
+int DatabaseSQLite::reserveIds(long maxId) {
+	idGenerator = std::max(idGenerator, maxId);
+	return 0;
+}
+
+std::string DatabaseSQLite::entityTableSchema() {
+	return fmt::format("CREATE TABLE IF NOT EXISTS entities ("
+					   "id integer NOT NULL PRIMARY KEY, "
+					   "loc integer, "
+					   "type char({}) NOT NULL, "
+					   "seq integer NOT NULL)", consts::id_len);
+}
+
+std::string DatabaseSQLite::propertyTableSchema() {
+	return fmt::format("CREATE TABLE IF NOT EXISTS properties ("
+					   "id integer NOT NULL REFERENCES entities "
+					   "ON DELETE CASCADE, "
+					   "name varchar({}) NOT NULL, "
+					   "value text,"
+					   "PRIMARY KEY (id, name))", consts::id_len);
+}
+
 int DatabaseSQLite::registerEntityTable() {
 	assert(m_database);
 
-	std::string query = fmt::format("CREATE TABLE IF NOT EXISTS entities ("
-									"id integer NOT NULL PRIMARY KEY, "
-									"loc integer, "
-									"type char({}) NOT NULL, "
-									"seq integer NOT NULL)", consts::id_len);
+	std::string query = entityTableSchema();
 	if (runCommandQuery(query) != 0) {
 		return -1;
 	}
@@ -320,12 +338,7 @@ int DatabaseSQLite::registerEntityTable() {
 int DatabaseSQLite::registerPropertyTable() {
 	assert(m_database);
 
-	std::string query = fmt::format("CREATE TABLE IF NOT EXISTS properties ("
-									"id integer NOT NULL REFERENCES entities "
-									"ON DELETE CASCADE, "
-									"name varchar({}) NOT NULL, "
-									"value text,"
-									"PRIMARY KEY (id, name))", consts::id_len);
+	std::string query = propertyTableSchema();
 	if (runCommandQuery(query) != 0) {
 		return -1;
 	}
@@ -98,11 +98,25 @@ public:
 
 	int registerPropertyTable() override;
 
+	/**
+	 * @brief The query for creating the "entities" table.
+	 *
+	 * Shared with world snapshots, so that these can be used in place of a database.
+	 */
+	static std::string entityTableSchema();
+
+	/**
+	 * @brief The query for creating the "properties" table.
+	 */
+	static std::string propertyTableSchema();
+
 
 	/// Creates a new unique id for the database.
 	/// Note that this method will access the database, so it's a fairly expensive method.
 	long newId() override;
 
+	int reserveIds(long maxId) override;
+
 	int registerEntityIdGenerator() override;
 
 
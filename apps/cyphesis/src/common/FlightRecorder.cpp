@@ -0,0 +1,204 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software Foundation,
+ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "FlightRecorder.h"
+
+#include "log.h"
+
+#include <fmt/chrono.h>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+double toMilliseconds(std::chrono::steady_clock::duration duration) {
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+}
+
+FlightRecorder::FlightRecorder(std::size_t capacity)
+		: m_frames(std::max<std::size_t>(capacity, 1)),
+		  m_index(0),
+		  m_frameCount(0),
+		  m_nextFrameNumber(0),
+		  m_inFrame(false),
+		  m_stallThreshold(0),
+		  m_minDumpInterval(0) {
+}
+
+void FlightRecorder::enableDumps(std::filesystem::path directory,
+								 std::chrono::steady_clock::duration threshold,
+								 std::chrono::steady_clock::duration minInterval) {
+	m_dumpDirectory = std::move(directory);
+	m_stallThreshold = threshold;
+	m_minDumpInterval = minInterval;
+}
+
+void FlightRecorder::beginFrame(std::chrono::steady_clock::time_point now) {
+	auto& frame = m_frames[m_index];
+	frame.number = m_nextFrameNumber++;
+	frame.start = now;
+	frame.duration = {};
+	frame.opCount = 0;
+	//Only the counts are reset, so that the strings of the previous use of the slot can be reused without allocations.
+	frame.phaseCount = 0;
+	frame.opTypeCount = 0;
+	frame.slowestOpCount = 0;
+	m_inFrame = true;
+}
+
+std::optional<std::filesystem::path> FlightRecorder::endFrame(std::chrono::steady_clock::time_point now) {
+	if (!m_inFrame) {
+		return {};
+	}
+	auto& frame = m_frames[m_index];
+	frame.duration = now - frame.start;
+	m_inFrame = false;
+	m_index = (m_index + 1) % m_frames.size();
+	m_frameCount = std::min(m_frameCount + 1, m_frames.size());
+
+	if (m_stallThreshold.count() > 0 && !m_dumpDirectory.empty() && frame.duration > m_stallThreshold) {
+		if (!m_lastDumpTime || now - *m_lastDumpTime >= m_minDumpInterval) {
+			m_lastDumpTime = now;
+			return writeDump(frame);
+		}
+	}
+	return {};
+}
+
+void FlightRecorder::addPhase(const char* name, std::chrono::steady_clock::duration duration) {
+	if (!m_inFrame) {
+		return;
+	}
+	auto& frame = m_frames[m_index];
+	for (std::size_t i = 0; i < frame.phaseCount; ++i) {
+		auto& phase = frame.phases[i];
+		if (phase.name == name || std::strcmp(phase.name, name) == 0) {
+			phase.duration += duration;
+			return;
+		}
+	}
+	if (frame.phaseCount < maxPhases) {
+		frame.phases[frame.phaseCount++] = Phase{name, duration};
+	}
+}
+
+void FlightRecorder::recordOp(int classNo, const std::string& type, long entityId, std::chrono::steady_clock::duration duration) {
+	if (!m_inFrame) {
+		return;
+	}
+	auto& frame = m_frames[m_index];
+	frame.opCount++;
+
+	auto opTypesEnd = frame.opTypes.begin() + static_cast<std::ptrdiff_t>(frame.opTypeCount);
+	auto I = std::find_if(frame.opTypes.begin(), opTypesEnd, [classNo](const OpType& opType) { return opType.classNo == classNo; });
+	if (I != opTypesEnd) {
+		I->count++;
+		I->duration += duration;
+	} else if (frame.opTypeCount < maxOpTypes) {
+		auto& opType = frame.opTypes[frame.opTypeCount++];
+		opType.classNo = classNo;
+		opType.name = type;
+		opType.count = 1;
+		opType.duration = duration;
+	}
+
+	OpSample* sample = nullptr;
+	if (frame.slowestOpCount < maxSlowestOps) {
+		sample = &frame.slowestOps[frame.slowestOpCount++];
+	} else {
+		auto slowestEnd = frame.slowestOps.begin() + static_cast<std::ptrdiff_t>(frame.slowestOpCount);
+		auto fastest = std::min_element(frame.slowestOps.begin(), slowestEnd, [](const OpSample& lhs, const OpSample& rhs) { return lhs.duration < rhs.duration; });
+		if (fastest->duration < duration) {
+			sample = &*fastest;
+		}
+	}
+	if (sample) {
+		sample->type = type;
+		sample->entityId = entityId;
+		sample->duration = duration;
+	}
+}
+
+std::vector<const FlightRecorder::Frame*> FlightRecorder::getFrames() const {
+	std::vector<const Frame*> frames;
+	frames.reserve(m_frameCount);
+	auto first = (m_index + m_frames.size() - m_frameCount) % m_frames.size();
+	for (std::size_t i = 0; i < m_frameCount; ++i) {
+		frames.push_back(&m_frames[(first + i) % m_frames.size()]);
+	}
+	return frames;
+}
+
+void FlightRecorder::dump(std::ostream& stream, const Frame& stalledFrame) const {
+	fmt::print(stream, "Frame {} took {:.2f} ms, handling {} operations.\n", stalledFrame.number, toMilliseconds(stalledFrame.duration), stalledFrame.opCount);
+
+	std::vector<Phase> phases(stalledFrame.phases.begin(), stalledFrame.phases.begin() + static_cast<std::ptrdiff_t>(stalledFrame.phaseCount));
+	std::sort(phases.begin(), phases.end(), [](const Phase& lhs, const Phase& rhs) { return lhs.duration > rhs.duration; });
+	fmt::print(stream, "\nPhases:\n");
+	for (auto& phase: phases) {
+		fmt::print(stream, "  {}: {:.2f} ms\n", phase.name, toMilliseconds(phase.duration));
+	}
+
+	std::vector<const OpType*> opTypes;
+	for (std::size_t i = 0; i < stalledFrame.opTypeCount; ++i) {
+		opTypes.push_back(&stalledFrame.opTypes[i]);
+	}
+	std::sort(opTypes.begin(), opTypes.end(), [](const OpType* lhs, const OpType* rhs) { return lhs->duration > rhs->duration; });
+	fmt::print(stream, "\nOperations by type:\n");
+	for (auto opType: opTypes) {
+		fmt::print(stream, "  {}: {} ops, {:.2f} ms\n", opType->name, opType->count, toMilliseconds(opType->duration));
+	}
+
+	std::vector<const OpSample*> slowestOps;
+	for (std::size_t i = 0; i < stalledFrame.slowestOpCount; ++i) {
+		slowestOps.push_back(&stalledFrame.slowestOps[i]);
+	}
+	std::sort(slowestOps.begin(), slowestOps.end(), [](const OpSample* lhs, const OpSample* rhs) { return lhs->duration > rhs->duration; });
+	fmt::print(stream, "\nSlowest operations:\n");
+	for (auto sample: slowestOps) {
+		fmt::print(stream, "  {} to entity {}: {:.2f} ms\n", sample->type, sample->entityId, toMilliseconds(sample->duration));
+	}
+
+	fmt::print(stream, "\nRecorded frames, oldest first (start relative to the stalled frame, duration, operations, phases):\n");
+	for (auto frame: getFrames()) {
+		fmt::print(stream, "  {} {:+.2f} ms {:.2f} ms {} ops", frame->number, toMilliseconds(frame->start - stalledFrame.start), toMilliseconds(frame->duration), frame->opCount);
+		for (std::size_t i = 0; i < frame->phaseCount; ++i) {
+			fmt::print(stream, " {}={:.2f}", frame->phases[i].name, toMilliseconds(frame->phases[i].duration));
+		}
+		fmt::print(stream, "\n");
+	}
+}
+
+std::optional<std::filesystem::path> FlightRecorder::writeDump(const Frame& stalledFrame) {
+	auto timestamp = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+	auto path = m_dumpDirectory / fmt::format("stall-{:%Y%m%d-%H%M%S}-{}.txt", timestamp, stalledFrame.number);
+	std::error_code ec;
+	std::filesystem::create_directories(m_dumpDirectory, ec);
+	std::ofstream file(path);
+	if (!file) {
+		spdlog::error("Could not write stalled frame dump to {}.", path.string());
+		return {};
+	}
+	dump(file, stalledFrame);
+	spdlog::warn("Frame {} took {:.2f} ms, which is longer than the threshold of {:.2f} ms. Recorded frames were dumped to {}.",
+				 stalledFrame.number, toMilliseconds(stalledFrame.duration), toMilliseconds(m_stallThreshold), path.string());
+	return path;
+}
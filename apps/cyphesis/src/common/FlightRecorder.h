@@ -0,0 +1,184 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software Foundation,
+ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef CYPHESIS_FLIGHTRECORDER_H
+#define CYPHESIS_FLIGHTRECORDER_H
+
+#include "Singleton.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Keeps timings of the most recent main loop frames, and dumps them to a file when a frame stalls.
+ *
+ * Each frame records the time spent in named phases (such as dispatching incoming messages, processing operations,
+ * stepping physics and storing entities), the time spent on operations by type, and the slowest operations along
+ * with the entities they were sent to. Phases may be nested; processing operations includes the physics tick, for example.
+ *
+ * Frames are kept in a fixed ring buffer which is allocated up front, so recording is cheap enough to always be on.
+ * When a frame takes longer than the stall threshold the whole buffer is written to a file in the dump directory,
+ * so that the frames leading up to the stall can be inspected without a profiler attached.
+ *
+ * It's only meant to be used from the main thread. The server creates an instance at startup; code which records
+ * timings does nothing if there's none, as in tools and tests.
+ */
+class FlightRecorder : public Singleton<FlightRecorder> {
+public:
+	static constexpr std::size_t maxPhases = 16;
+	static constexpr std::size_t maxOpTypes = 16;
+	static constexpr std::size_t maxSlowestOps = 8;
+
+	struct Phase {
+		/**
+		 * Must be a string literal, or otherwise outlive the recorder.
+		 */
+		const char* name;
+		std::chrono::steady_clock::duration duration;
+	};
+
+	struct OpType {
+		int classNo;
+		std::string name;
+		std::size_t count;
+		std::chrono::steady_clock::duration duration;
+	};
+
+	struct OpSample {
+		std::string type;
+		/**
+		 * The entity the operation was sent to.
+		 */
+		long entityId;
+		std::chrono::steady_clock::duration duration;
+	};
+
+	struct Frame {
+		std::uint64_t number;
+		std::chrono::steady_clock::time_point start;
+		std::chrono::steady_clock::duration duration;
+		std::size_t opCount;
+		std::size_t phaseCount;
+		std::array<Phase, maxPhases> phases;
+		std::size_t opTypeCount;
+		std::array<OpType, maxOpTypes> opTypes;
+		std::size_t slowestOpCount;
+		std::array<OpSample, maxSlowestOps> slowestOps;
+	};
+
+	/**
+	 * Measures the time until it goes out of scope as a phase.
+	 */
+	class ScopedPhase {
+	public:
+		/**
+		 * @param recorder The recorder to add the phase to, or null if nothing should be recorded.
+		 */
+		explicit ScopedPhase(const char* name, FlightRecorder* recorder = FlightRecorder::hasInstance() ? FlightRecorder::instancePtr() : nullptr)
+				: m_recorder(recorder),
+				  m_name(name),
+				  m_start(std::chrono::steady_clock::now()) {
+		}
+
+		~ScopedPhase() {
+			if (m_recorder) {
+				m_recorder->addPhase(m_name, std::chrono::steady_clock::now() - m_start);
+			}
+		}
+
+	private:
+		FlightRecorder* m_recorder;
+		const char* m_name;
+		std::chrono::steady_clock::time_point m_start;
+	};
+
+	/**
+	 * @param capacity The number of frames to keep.
+	 */
+	explicit FlightRecorder(std::size_t capacity = 500);
+
+	/**
+	 * @brief Enables dumping of stalled frames.
+	 * @param directory The directory to write dumps to. It's created when needed.
+	 * @param threshold Frames which take longer than this are dumped.
+	 * @param minInterval The least time between two dumps, so that a server which is overloaded doesn't fill the disk.
+	 */
+	void enableDumps(std::filesystem::path directory,
+					 std::chrono::steady_clock::duration threshold,
+					 std::chrono::steady_clock::duration minInterval = std::chrono::minutes(1));
+
+	void beginFrame(std::chrono::steady_clock::time_point now);
+
+	/**
+	 * @brief Ends the current frame, and dumps the recorded frames if it stalled.
+	 * @return The path of the dump, if one was written.
+	 */
+	std::optional<std::filesystem::path> endFrame(std::chrono::steady_clock::time_point now);
+
+	/**
+	 * @brief Adds time to a phase of the current frame. Time added to the same phase several times in a frame is summed up.
+	 *
+	 * Does nothing outside of frames.
+	 */
+	void addPhase(const char* name, std::chrono::steady_clock::duration duration);
+
+	/**
+	 * @brief Records the handling of an operation in the current frame.
+	 *
+	 * Does nothing outside of frames.
+	 * @param classNo The class number of the operation, used to group operations by type.
+	 * @param type The type of the operation, only copied the first time the type is seen in a frame, or if it's one of the slowest operations.
+	 */
+	void recordOp(int classNo, const std::string& type, long entityId, std::chrono::steady_clock::duration duration);
+
+	/**
+	 * @return The recorded frames, oldest first.
+	 */
+	std::vector<const Frame*> getFrames() const;
+
+	/**
+	 * @brief Writes a stalled frame in detail, followed by a summary of all recorded frames.
+	 */
+	void dump(std::ostream& stream, const Frame& stalledFrame) const;
+
+private:
+	std::vector<Frame> m_frames;
+	/**
+	 * Index of the current frame, or the one to be used next when outside of frames.
+	 */
+	std::size_t m_index;
+	std::size_t m_frameCount;
+	std::uint64_t m_nextFrameNumber;
+	bool m_inFrame;
+
+	std::filesystem::path m_dumpDirectory;
+	std::chrono::steady_clock::duration m_stallThreshold;
+	std::chrono::steady_clock::duration m_minDumpInterval;
+	std::optional<std::chrono::steady_clock::time_point> m_lastDumpTime;
+
+	std::optional<std::filesystem::path> writeDump(const Frame& stalledFrame);
+};
+
+
+#endif //CYPHESIS_FLIGHTRECORDER_H
@@ -21,6 +21,8 @@
 #include "globals.h"
 #include "OperationsDispatcher.h"
 #include "log.h"
+#include "Metrics.h"
+#include "FlightRecorder.h"
 #include <boost/asio/signal_set.hpp>
 #include <boost/asio/steady_timer.hpp>
 #include "Remotery.h"
@@ -105,6 +107,10 @@ void MainLoop::run(bool daemon,
 	boost::asio::steady_timer softExitTimer(io_context);
 
 	std::chrono::steady_clock::duration tick_size = std::chrono::milliseconds(10);
+
+	//Only the time spent doing work is measured, not the time spent waiting for IO.
+	auto& tickDuration = Metrics::instance().histogram("tick_duration_seconds", "Time spent dispatching incoming messages and processing operations each tick.");
+	auto flightRecorder = FlightRecorder::hasInstance() ? FlightRecorder::instancePtr() : nullptr;
 	// Loop until the exit flag is set. The exit flag can be set anywhere in
 	// the code easily.
 	while (!exit_flag) {
@@ -112,6 +118,9 @@ void MainLoop::run(bool daemon,
 		rmt_ScopedCPUSample(MainLoop, 0)
 
 		auto frameStartTime = std::chrono::steady_clock::now();
+		if (flightRecorder) {
+			flightRecorder->beginFrame(frameStartTime);
+		}
 		auto max_wall_time = std::chrono::milliseconds(8);
 		auto op_handling_expiry_time = frameStartTime + tick_size;
 		bool nextOpTimeExpired = false;
@@ -132,25 +141,44 @@ void MainLoop::run(bool daemon,
 		//Dispatch any incoming messages first
 		{
 			rmt_ScopedCPUSample(dispatchOperations, 0)
+			FlightRecorder::ScopedPhase phase("dispatch_operations", flightRecorder);
 			callbacks.dispatchOperations();
 		}
 		{
 			rmt_ScopedCPUSample(processOps, 0)
+			FlightRecorder::ScopedPhase phase("process_ops", flightRecorder);
 			operationsHandler.processUntil(time, max_wall_time);
 		}
+		tickDuration.observe(std::chrono::steady_clock::now() - frameStartTime);
 		{
 			rmt_ScopedCPUSample(runIO, 0)
-
+			//Handlers which are ready are run without blocking, and count as "io". Only when there are none do we block,
+			//which counts as "io_wait" (along with the handler we're woken up for), so that waiting isn't mistaken for work.
+			std::chrono::steady_clock::duration ioDuration{};
+			std::chrono::steady_clock::duration ioWaitDuration{};
 			do {
 				try {
 					rmt_ScopedCPUSample(runIO_one, 0)
-					io_context.run_one();
+					auto ioStart = std::chrono::steady_clock::now();
+					if (io_context.poll_one() > 0) {
+						ioDuration += std::chrono::steady_clock::now() - ioStart;
+					} else {
+						io_context.run_one();
+						ioWaitDuration += std::chrono::steady_clock::now() - ioStart;
+					}
 				} catch (const std::exception& ex) {
 					spdlog::error("Exception caught in main loop: {}", ex.what());
 				}
 			} while (!nextOpTimeExpired && std::chrono::steady_clock::now() < op_handling_expiry_time);
+			if (flightRecorder) {
+				flightRecorder->addPhase("io", ioDuration);
+				flightRecorder->addPhase("io_wait", ioWaitDuration);
+			}
 		}
 		nextOpTimer.cancel();
+		if (flightRecorder) {
+			flightRecorder->endFrame(std::chrono::steady_clock::now());
+		}
 		if (soft_exit_in_progress) {
 			//If we're in soft exit mode and either the deadline has been exceeded
 			//or we've persisted all minds we should shut down normally.
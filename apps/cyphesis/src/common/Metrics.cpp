@@ -0,0 +1,222 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software Foundation,
+ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+void writeEscaped(std::ostream& stream, const std::string& value) {
+	for (auto c: value) {
+		switch (c) {
+			case '\\':
+				stream << "\\\\";
+				break;
+			case '"':
+				stream << "\\\"";
+				break;
+			case '\n':
+				stream << "\\n";
+				break;
+			default:
+				stream << c;
+		}
+	}
+}
+
+/**
+ * Writes the labels, with an optional extra label last, as used for the "le" label of histogram buckets.
+ */
+void writeLabels(std::ostream& stream, const Metrics::Labels& labels, const std::pair<std::string, std::string>* extra = nullptr) {
+	if (labels.empty() && !extra) {
+		return;
+	}
+	stream << "{";
+	bool first = true;
+	auto writeLabel = [&](const std::pair<std::string, std::string>& label) {
+		if (!first) {
+			stream << ",";
+		}
+		first = false;
+		stream << label.first << "=\"";
+		writeEscaped(stream, label.second);
+		stream << "\"";
+	};
+	for (auto& label: labels) {
+		writeLabel(label);
+	}
+	if (extra) {
+		writeLabel(*extra);
+	}
+	stream << "}";
+}
+
+}
+
+const char* Metrics::typeName(Type type) {
+	switch (type) {
+		case Type::Counter:
+			return "counter";
+		case Type::Gauge:
+			return "gauge";
+		default:
+			return "histogram";
+	}
+}
+
+Metrics::Histogram::Histogram(std::vector<double> bounds)
+		: m_bounds(std::move(bounds)),
+		  m_buckets(new std::atomic<std::uint64_t>[m_bounds.size() + 1]) {
+	for (std::size_t i = 0; i <= m_bounds.size(); ++i) {
+		m_buckets[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+void Metrics::Histogram::observe(double value) {
+	//Buckets are inclusive of their upper bound.
+	auto index = std::lower_bound(m_bounds.begin(), m_bounds.end(), value) - m_bounds.begin();
+	m_buckets[index].fetch_add(1, std::memory_order_relaxed);
+	m_sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+std::uint64_t Metrics::Histogram::count() const {
+	std::uint64_t total = 0;
+	for (std::size_t i = 0; i <= m_bounds.size(); ++i) {
+		total += bucketCount(i);
+	}
+	return total;
+}
+
+Metrics::Metrics() = default;
+
+Metrics::~Metrics() = default;
+
+Metrics& Metrics::instance() {
+	static Metrics metrics;
+	return metrics;
+}
+
+std::vector<double> Metrics::latencyBuckets() {
+	//From 10 microseconds to about 5 seconds.
+	return exponentialBuckets(0.00001, 2.5, 15);
+}
+
+std::vector<double> Metrics::exponentialBuckets(double start, double factor, std::size_t count) {
+	std::vector<double> bounds;
+	bounds.reserve(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		bounds.push_back(start);
+		start *= factor;
+	}
+	return bounds;
+}
+
+Metrics::Family& Metrics::getFamily(const std::string& name, const std::string& help, Type type) {
+	auto result = m_families.emplace(name, Family{type, help, {}, {}, {}});
+	if (result.first->second.type != type) {
+		throw std::invalid_argument("Metric '" + name + "' is already registered as a " + typeName(result.first->second.type) + ".");
+	}
+	return result.first->second;
+}
+
+Metrics::Counter& Metrics::counter(const std::string& name, const std::string& help, const Labels& labels) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto& entry = getFamily(name, help, Type::Counter).counters[labels];
+	if (!entry) {
+		entry = std::make_unique<Counter>();
+	}
+	return *entry;
+}
+
+Metrics::Gauge& Metrics::gauge(const std::string& name, const std::string& help, const Labels& labels) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto& entry = getFamily(name, help, Type::Gauge).gauges[labels];
+	if (!entry) {
+		entry = std::make_unique<Gauge>();
+	}
+	return *entry;
+}
+
+Metrics::Histogram& Metrics::histogram(const std::string& name, const std::string& help, const Labels& labels, const std::vector<double>& bounds) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto& entry = getFamily(name, help, Type::Histogram).histograms[labels];
+	if (!entry) {
+		if (!std::is_sorted(bounds.begin(), bounds.end())) {
+			throw std::invalid_argument("Bucket bounds for histogram '" + name + "' must be in increasing order.");
+		}
+		entry = std::make_unique<Histogram>(bounds);
+	}
+	return *entry;
+}
+
+void Metrics::remove(const std::string& name, const Labels& labels) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto I = m_families.find(name);
+	if (I != m_families.end()) {
+		I->second.counters.erase(labels);
+		I->second.gauges.erase(labels);
+		I->second.histograms.erase(labels);
+	}
+}
+
+void Metrics::render(std::ostream& stream) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto& [name, family]: m_families) {
+		if (!family.help.empty()) {
+			stream << "# HELP " << name << " " << family.help << "\n";
+		}
+		stream << "# TYPE " << name << " " << typeName(family.type) << "\n";
+
+		for (auto& [labels, counter]: family.counters) {
+			stream << name;
+			writeLabels(stream, labels);
+			stream << " " << counter->value() << "\n";
+		}
+		for (auto& [labels, gauge]: family.gauges) {
+			stream << name;
+			writeLabels(stream, labels);
+			stream << " " << gauge->value() << "\n";
+		}
+		for (auto& [labels, histogram]: family.histograms) {
+			//Buckets are cumulative in Prometheus. Since the buckets might be updated while we're rendering we
+			//use the cumulative count for "_count", so that it's consistent with the "+Inf" bucket.
+			std::uint64_t cumulative = 0;
+			auto& bounds = histogram->getBounds();
+			for (std::size_t i = 0; i <= bounds.size(); ++i) {
+				cumulative += histogram->bucketCount(i);
+				std::pair<std::string, std::string> le{"le", "+Inf"};
+				if (i < bounds.size()) {
+					std::ostringstream ss;
+					ss << bounds[i];
+					le.second = ss.str();
+				}
+				stream << name << "_bucket";
+				writeLabels(stream, labels, &le);
+				stream << " " << cumulative << "\n";
+			}
+			stream << name << "_sum";
+			writeLabels(stream, labels);
+			stream << " " << histogram->sum() << "\n";
+			stream << name << "_count";
+			writeLabels(stream, labels);
+			stream << " " << cumulative << "\n";
+		}
+	}
+}
@@ -0,0 +1,199 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software Foundation,
+ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef CYPHESIS_METRICS_H
+#define CYPHESIS_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A registry of typed metrics, which can be rendered in the Prometheus text exposition format.
+ *
+ * In contrast to the Monitors, which are meant for generic values, this is meant for metrics which are
+ * updated often, such as in the main loop or when operations are handled.
+ *
+ * Registering a metric takes a lock, but updating it doesn't; it's only a couple of relaxed atomic operations.
+ * The returned references are valid for the lifetime of the registry, or until the metric is removed, so code on
+ * hot paths should look up its metrics once and then hold on to them.
+ *
+ * Rendering takes the same lock as registration, but never blocks any updates.
+ */
+class Metrics {
+public:
+
+	typedef std::vector<std::pair<std::string, std::string>> Labels;
+
+	/**
+	 * @brief A value which only ever increases.
+	 */
+	class Counter {
+	public:
+		void increment(std::uint64_t amount = 1) {
+			m_value.fetch_add(amount, std::memory_order_relaxed);
+		}
+
+		std::uint64_t value() const {
+			return m_value.load(std::memory_order_relaxed);
+		}
+
+	private:
+		std::atomic<std::uint64_t> m_value{0};
+	};
+
+	/**
+	 * @brief A value which can go up and down, such as the size of a queue.
+	 */
+	class Gauge {
+	public:
+		void set(std::int64_t value) {
+			m_value.store(value, std::memory_order_relaxed);
+		}
+
+		void add(std::int64_t amount) {
+			m_value.fetch_add(amount, std::memory_order_relaxed);
+		}
+
+		std::int64_t value() const {
+			return m_value.load(std::memory_order_relaxed);
+		}
+
+	private:
+		std::atomic<std::int64_t> m_value{0};
+	};
+
+	/**
+	 * @brief Counts observed values in buckets with fixed upper bounds.
+	 *
+	 * Durations are observed as seconds, as is the Prometheus convention.
+	 */
+	class Histogram {
+	public:
+		/**
+		 * @param bounds The upper bounds of the buckets, in increasing order. A bucket for all larger values is always added.
+		 */
+		explicit Histogram(std::vector<double> bounds);
+
+		void observe(double value);
+
+		template<typename Rep, typename Period>
+		void observe(std::chrono::duration<Rep, Period> duration) {
+			observe(std::chrono::duration_cast<std::chrono::duration<double>>(duration).count());
+		}
+
+		const std::vector<double>& getBounds() const {
+			return m_bounds;
+		}
+
+		/**
+		 * @brief Gets the number of values observed in a bucket, not including the ones in lower buckets.
+		 * @param index An index into the bounds, or the size of the bounds for the values larger than all bounds.
+		 */
+		std::uint64_t bucketCount(std::size_t index) const {
+			return m_buckets[index].load(std::memory_order_relaxed);
+		}
+
+		std::uint64_t count() const;
+
+		double sum() const {
+			return m_sum.load(std::memory_order_relaxed);
+		}
+
+	private:
+		const std::vector<double> m_bounds;
+		std::unique_ptr<std::atomic<std::uint64_t>[]> m_buckets;
+		std::atomic<double> m_sum{0};
+	};
+
+	Metrics();
+
+	~Metrics();
+
+	/**
+	 * @brief Gets the registry for the process.
+	 *
+	 * It's always available, so that any code, including tests, can record metrics without any setup.
+	 */
+	static Metrics& instance();
+
+	/**
+	 * @brief Buckets suitable for latencies ranging from tens of microseconds to seconds.
+	 */
+	static std::vector<double> latencyBuckets();
+
+	static std::vector<double> exponentialBuckets(double start, double factor, std::size_t count);
+
+	/**
+	 * @brief Gets a counter, registering it if needed.
+	 *
+	 * It's an error to register a metric with the same name as a metric of another type; if so
+	 * an exception is thrown.
+	 */
+	Counter& counter(const std::string& name, const std::string& help, const Labels& labels = {});
+
+	Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels = {});
+
+	/**
+	 * @brief Gets a histogram, registering it if needed.
+	 * @param bounds The bucket bounds. Ignored if the histogram already exists.
+	 */
+	Histogram& histogram(const std::string& name, const std::string& help, const Labels& labels = {}, const std::vector<double>& bounds = latencyBuckets());
+
+	/**
+	 * @brief Removes the metric with the labels, if it exists.
+	 *
+	 * This is meant for metrics which are labelled by things which come and go. Any references to the metric are invalid afterwards.
+	 */
+	void remove(const std::string& name, const Labels& labels);
+
+	/**
+	 * @brief Writes all metrics in the Prometheus text exposition format.
+	 */
+	void render(std::ostream& stream) const;
+
+private:
+
+	enum class Type {
+		Counter, Gauge, Histogram
+	};
+
+	struct Family {
+		Type type;
+		std::string help;
+		std::map<Labels, std::unique_ptr<Counter>> counters;
+		std::map<Labels, std::unique_ptr<Gauge>> gauges;
+		std::map<Labels, std::unique_ptr<Histogram>> histograms;
+	};
+
+	mutable std::mutex m_mutex;
+	std::map<std::string, Family> m_families;
+
+	static const char* typeName(Type type);
+
+	Family& getFamily(const std::string& name, const std::string& help, Type type);
+};
+
+#endif //CYPHESIS_METRICS_H
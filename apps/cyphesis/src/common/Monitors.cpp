@@ -36,6 +36,13 @@ void Monitors::insert(std::string key, const Element& val) {
 	mState.withState([&](auto state) { state->pairs[std::move(key)] = val; });
 }
 
+void Monitors::remove(const std::string& key) {
+	mState.withState([&](auto state) {
+		state->pairs.erase(key);
+		state->variableMonitors.erase(key);
+	});
+}
+
 void Monitors::watch(std::string name, std::unique_ptr<VariableBase> monitor) {
 	mState.withState([&](auto state) { state->variableMonitors[std::move(name)] = std::move(monitor); });
 }
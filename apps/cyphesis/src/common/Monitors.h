@@ -47,6 +47,8 @@ public:
 
 	void insert(std::string, const Atlas::Message::Element&);
 
+	void remove(const std::string&);
+
 	void watch(std::string, std::unique_ptr<VariableBase>);
 
 	void watch(std::string, int& value);
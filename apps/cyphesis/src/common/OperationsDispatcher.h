@@ -21,10 +21,13 @@
 
 #include "OperationRouter.h"
 #include "const.h"
+#include "Metrics.h"
+#include "id.h"
 
 #include <Atlas/Objects/RootOperation.h>
 
 #include <list>
+#include <map>
 #include <set>
 #include <queue>
 #include <functional>
@@ -55,6 +58,11 @@ struct OpQueEntry {
 	std::chrono::milliseconds time_for_dispatch;
 	//Sequence number is used to determine ordering when to ops have the exact same time.
 	long sequence;
+	/**
+	 * The integer id of the entity the op is sent to, resolved once when the op is queued so that it doesn't need to be parsed again when dispatched.
+	 * Zero if the op has no "to", and -1 if it's not a valid id.
+	 */
+	long to_id;
 
 	explicit OpQueEntry(Operation o, T& f, long sequence_);
 
@@ -62,7 +70,12 @@ struct OpQueEntry {
 			: op(std::move(op_)),
 			  from(std::move(from_)),
 			  time_for_dispatch(std::chrono::milliseconds(op->getStamp())),
-			  sequence(sequence_) {
+			  sequence(sequence_),
+			  to_id(resolveToId(*op)) {
+	}
+
+	static long resolveToId(const Atlas::Objects::Operation::RootOperationData& op) {
+		return op.isDefaultTo() ? 0 : integerId(op.getTo());
 	}
 
 	OpQueEntry(const OpQueEntry& o);
@@ -76,6 +89,7 @@ struct OpQueEntry {
 		this->from = std::move(rhs.from);
 		this->time_for_dispatch = std::move(rhs.time_for_dispatch);
 		this->sequence = std::move(rhs.sequence);
+		this->to_id = rhs.to_id;
 		return *this;
 	}
 
@@ -138,6 +152,13 @@ public:
 	OperationsDispatcher(std::function<void(const Operation&, Ref<T>)> operationProcessor,
 						 TimeProviderFnType timeProviderFn);
 
+	/**
+	 * @brief Ctor.
+	 * @param operationProcessor A processor function called each time an operation needs to be processed, which also gets the integer id of the recipient.
+	 */
+	OperationsDispatcher(std::function<void(const Operation&, Ref<T>, long)> operationProcessor,
+						 TimeProviderFnType timeProviderFn);
+
 	virtual ~OperationsDispatcher();
 
 	/**
@@ -191,7 +212,7 @@ public:
 
 protected:
 
-	std::function<void(const Operation&, Ref<T>)> m_operationProcessor;
+	std::function<void(const Operation&, Ref<T>, long)> m_operationProcessor;
 	const TimeProviderFnType m_timeProviderFn;
 
 	/// An ordered queue of operations to be dispatched in the future
@@ -202,6 +223,17 @@ protected:
 	/// A sequence number, used when ops that have the same second set needs ordering.
 	long m_sequence;
 
+	Metrics::Gauge& m_queueSizeGauge;
+
+	/// How late ops are handled, compared to the time they were scheduled for.
+	Metrics::Histogram& m_dispatchLatency;
+
+	/// Histograms of the time it takes to handle ops, keyed by the parent name of the op, which is also the label.
+	/// Generic ops share a class number whatever their parent, so that can't be used as the key.
+	/// These are registered when an op of a type is first seen, so that they don't need to be looked up in the registry each time.
+	std::map<std::string, Metrics::Histogram*, std::less<>> m_handlingTimes;
+
+	Metrics::Histogram& getHandlingTimeHistogram(const Operation& op);
 
 	/**
 	 * @brief Dispatches the operation contained in the OpQueueEntry.
@@ -23,7 +23,7 @@
 #include "const.h"
 #include "debug.h"
 #include "log.h"
-#include "Monitors.h"
+#include "FlightRecorder.h"
 
 #include <iostream>
 #include <cstdint>
@@ -40,7 +40,7 @@ OperationsDispatcher<T>::~OperationsDispatcher() {
 
 template<typename T>
 void OperationsDispatcher<T>::dispatchOperation(OpQueEntry<T>& oqe) {
-	m_operationProcessor(oqe.op, std::move(oqe.from));
+	m_operationProcessor(oqe.op, std::move(oqe.from), oqe.to_id);
 }
 
 template<typename T>
@@ -71,20 +71,26 @@ size_t OperationsDispatcher<T>::processUntil(std::chrono::steady_clock::duration
 			m_operationQueue.pop();
 			count++;
 
-			if (m_time_diff_report.count() > 0) {
-				//Check if there's too large a difference in time
-				auto timeDiff = duration - opQueueEntry.time_for_dispatch;
-				if (timeDiff > m_time_diff_report) {
-					spdlog::warn("Op ({}, from {} to {}) was handled too late. Time diff: {} seconds. Ops in queue: {}",
-								 opQueueEntry->getParent(), opQueueEntry.from->describeEntity(),
-								 opQueueEntry->getTo(), std::chrono::duration_cast<std::chrono::duration<float>>(timeDiff).count(), m_operationQueue.size());
-				}
+			auto timeDiff = duration - opQueueEntry.time_for_dispatch;
+			m_dispatchLatency.observe(timeDiff);
+			//Check if there's too large a difference in time
+			if (m_time_diff_report.count() > 0 && timeDiff > m_time_diff_report) {
+				spdlog::warn("Op ({}, from {} to {}) was handled too late. Time diff: {} seconds. Ops in queue: {}",
+							 opQueueEntry->getParent(), opQueueEntry.from->describeEntity(),
+							 opQueueEntry->getTo(), std::chrono::duration_cast<std::chrono::duration<float>>(timeDiff).count(), m_operationQueue.size());
 			}
+			auto& handlingTime = getHandlingTimeHistogram(opQueueEntry.op);
+			auto handlingStart = std::chrono::steady_clock::now();
 			dispatchOperation(opQueueEntry);
+			auto handlingDuration = std::chrono::steady_clock::now() - handlingStart;
+			handlingTime.observe(handlingDuration);
+			if (FlightRecorder::hasInstance()) {
+				FlightRecorder::instance().recordOp(opQueueEntry->getClassNo(), opQueueEntry->getParent(), opQueueEntry.to_id, handlingDuration);
+			}
 		}
 
 	} while (opsAvailableRightNow && std::chrono::steady_clock::now() < processUntilWallClock);
-	Monitors::instance().insert("operations_queue", (Atlas::Message::IntType) m_operationQueue.size());
+	m_queueSizeGauge.set(static_cast<std::int64_t>(m_operationQueue.size()));
 	return count;
 }
 
@@ -119,7 +125,8 @@ OpQueEntry<T>::OpQueEntry(Operation o, T& f, long sequence_) :
 		op(std::move(o)),
 		from(&f),
 		time_for_dispatch(std::chrono::milliseconds(op->getStamp())),
-		sequence(sequence_) {
+		sequence(sequence_),
+		to_id(resolveToId(*op)) {
 }
 
 template<typename T>
@@ -127,7 +134,8 @@ OpQueEntry<T>::OpQueEntry(const OpQueEntry& o) :
 		op(o.op),
 		from(o.from),
 		time_for_dispatch(std::chrono::milliseconds(op->getStamp())),
-		sequence(o.sequence) {
+		sequence(o.sequence),
+		to_id(o.to_id) {
 }
 
 template<typename T>
@@ -135,7 +143,8 @@ OpQueEntry<T>::OpQueEntry(OpQueEntry&& o) noexcept
 		: op(std::move(o.op)),
 		  from(std::move(o.from)),
 		  time_for_dispatch(std::chrono::milliseconds(op->getStamp())),
-		  sequence(std::move(o.sequence)) {
+		  sequence(std::move(o.sequence)),
+		  to_id(o.to_id) {
 
 }
 
@@ -146,11 +155,31 @@ OpQueEntry<T>::~OpQueEntry() = default;
 template<typename T>
 OperationsDispatcher<T>::OperationsDispatcher(std::function<void(const Operation&, Ref<T>)> operationProcessor,
 											  TimeProviderFnType timeProviderFn)
+		: OperationsDispatcher([operationProcessor = std::move(operationProcessor)](const Operation& op, Ref<T> from, long) { operationProcessor(op, std::move(from)); },
+							   std::move(timeProviderFn)) {
+}
+
+template<typename T>
+OperationsDispatcher<T>::OperationsDispatcher(std::function<void(const Operation&, Ref<T>, long)> operationProcessor,
+											  TimeProviderFnType timeProviderFn)
 		:       m_time_diff_report(0),
 				m_operationProcessor(std::move(operationProcessor)),
 				m_timeProviderFn(std::move(timeProviderFn)),
 				m_operation_queues_dirty(false),
-				m_sequence(0) {
+				m_sequence(0),
+				m_queueSizeGauge(Metrics::instance().gauge("operations_queue", "Number of operations waiting to be dispatched.")),
+				m_dispatchLatency(Metrics::instance().histogram("operations_dispatch_latency_seconds", "How late operations are dispatched compared to when they were scheduled.")) {
+}
+
+template<typename T>
+Metrics::Histogram& OperationsDispatcher<T>::getHandlingTimeHistogram(const Operation& op) {
+	auto& type = op->getParent();
+	auto I = m_handlingTimes.find(type);
+	if (I == m_handlingTimes.end()) {
+		auto& histogram = Metrics::instance().histogram("operations_handling_seconds", "Time spent handling operations.", {{"type", type}});
+		I = m_handlingTimes.emplace(type, &histogram).first;
+	}
+	return *I->second;
 }
 
 template<typename T>
@@ -22,6 +22,7 @@
 static const char* DEFAULT_CLIENT_SOCKET = "cyphesis.sock";
 static const char* DEFAULT_PYTHON_SOCKET = "cypython.sock";
 static const char* DEFAULT_SLAVE_SOCKET = "cyslave.sock";
+static const char* DEFAULT_SHARED_MEMORY_SOCKET = "cyshm.sock";
 
 UNIXSOCK_OPTION(client_socket_name, DEFAULT_CLIENT_SOCKET, CYPHESIS,
 				"unixport", "Local listen socket for admin connections",
@@ -32,3 +33,6 @@ UNIXSOCK_OPTION(python_socket_name, DEFAULT_PYTHON_SOCKET, CYPHESIS,
 UNIXSOCK_OPTION(slave_socket_name, DEFAULT_SLAVE_SOCKET, "slave", "unixport",
 				"Local listen socket for admin connections to the slave server",
 				"cyslave_{}.sock")
+UNIXSOCK_OPTION(shared_memory_socket_name, DEFAULT_SHARED_MEMORY_SOCKET, CYPHESIS,
+				"sharedmemoryport", "Local listen socket for AI clients which communicate through shared memory",
+				"cyshm_{}.sock")
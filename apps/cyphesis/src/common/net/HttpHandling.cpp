@@ -21,6 +21,7 @@
 #include "common/const.h"
 #include "common/globals.h"
 #include "common/Monitors.h"
+#include "common/Metrics.h"
 #include "common/log.h"
 
 #include <varconf/config.h>
@@ -55,6 +56,12 @@ HttpHandling::HttpHandling(const Monitors& monitors, boost::asio::io_context& co
 			sendHeaders(context.io);
 			m_monitors.sendNumerics(context.io);
 			co_return HandleResult::Handled;
+		} else if (context.path == "/metrics") {
+			sendHeaders(context.io, 200, "text/plain; version=0.0.4");
+			Metrics::instance().render(context.io);
+			//Also include the numerical monitors, so that everything can be scraped from one place. These are untyped.
+			m_monitors.sendNumerics(context.io);
+			co_return HandleResult::Handled;
 		} else {
 			co_return HandleResult::Ignored;
 		}
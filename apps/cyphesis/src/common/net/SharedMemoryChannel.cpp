@@ -0,0 +1,400 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "SharedMemoryChannel.h"
+
+#include <boost/asio/post.hpp>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+
+namespace {
+/**
+ * Sent along with the descriptors, to make sure that both ends agree on the layout.
+ */
+struct Announcement {
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint64_t ringSize;
+};
+
+constexpr std::uint32_t ANNOUNCEMENT_MAGIC = 0x57465348; //"WFSH"
+constexpr std::uint32_t ANNOUNCEMENT_VERSION = 1;
+
+/**
+ * The memory, the creator's eventfd and the receiver's eventfd.
+ */
+constexpr std::size_t DESCRIPTOR_COUNT = 3;
+
+std::system_error systemError(const char* what) {
+	return {errno, std::generic_category(), what};
+}
+
+bool isValidRingSize(std::size_t ringSize) {
+	return ringSize != 0 && (ringSize & (ringSize - 1)) == 0;
+}
+}
+
+SharedMemoryRing::SharedMemoryRing(void* memory, std::size_t capacity)
+		: m_header(*static_cast<Header*>(memory)),
+		  m_data(static_cast<char*>(memory) + sizeof(Header)),
+		  m_capacity(capacity) {
+}
+
+void SharedMemoryRing::initialize() {
+	new(&m_header) Header{};
+}
+
+std::size_t SharedMemoryRing::write(const void* data, std::size_t size) {
+	auto writePosition = m_header.writePosition.load(std::memory_order_relaxed);
+	auto readPosition = m_header.readPosition.load(std::memory_order_acquire);
+	auto length = std::min(size, m_capacity - static_cast<std::size_t>(writePosition - readPosition));
+	if (length == 0) {
+		return 0;
+	}
+	auto offset = static_cast<std::size_t>(writePosition & (m_capacity - 1));
+	auto first = std::min(length, m_capacity - offset);
+	std::memcpy(m_data + offset, data, first);
+	std::memcpy(m_data, static_cast<const char*>(data) + first, length - first);
+	m_header.writePosition.store(writePosition + length, std::memory_order_release);
+	return length;
+}
+
+std::size_t SharedMemoryRing::read(void* data, std::size_t size) {
+	auto readPosition = m_header.readPosition.load(std::memory_order_relaxed);
+	auto writePosition = m_header.writePosition.load(std::memory_order_acquire);
+	auto length = std::min(size, static_cast<std::size_t>(writePosition - readPosition));
+	if (length == 0) {
+		return 0;
+	}
+	auto offset = static_cast<std::size_t>(readPosition & (m_capacity - 1));
+	auto first = std::min(length, m_capacity - offset);
+	std::memcpy(data, m_data + offset, first);
+	std::memcpy(static_cast<char*>(data) + first, m_data, length - first);
+	m_header.readPosition.store(readPosition + length, std::memory_order_release);
+	return length;
+}
+
+std::size_t SharedMemoryRing::available() const {
+	return static_cast<std::size_t>(m_header.writePosition.load(std::memory_order_acquire) - m_header.readPosition.load(std::memory_order_acquire));
+}
+
+std::size_t SharedMemoryRing::space() const {
+	return m_capacity - available();
+}
+
+SharedMemoryChannel::SharedMemoryChannel(boost::asio::io_context& io_context,
+										 int memoryFd,
+										 void* memory,
+										 std::size_t ringSize,
+										 int eventFd,
+										 int peerEventFd,
+										 bool creator)
+		: m_memoryFd(memoryFd),
+		  m_memory(memory),
+		  m_ringSize(ringSize),
+		  m_event(io_context, eventFd),
+		  m_peerEventFd(peerEventFd),
+		  m_outgoing(static_cast<char*>(memory) + (creator ? 0 : SharedMemoryRing::requiredSize(ringSize)), ringSize),
+		  m_incoming(static_cast<char*>(memory) + (creator ? SharedMemoryRing::requiredSize(ringSize) : 0), ringSize),
+		  m_waiting(false),
+		  m_eventValue(0),
+		  m_closed(false) {
+	if (creator) {
+		m_outgoing.initialize();
+		m_incoming.initialize();
+	}
+}
+
+SharedMemoryChannel::~SharedMemoryChannel() {
+	if (!m_closed) {
+		m_outgoing.header().closed = true;
+		notifyPeer();
+	}
+	::munmap(m_memory, mappedSize(m_ringSize));
+	::close(m_memoryFd);
+	::close(m_peerEventFd);
+}
+
+std::size_t SharedMemoryChannel::mappedSize(std::size_t ringSize) {
+	return SharedMemoryRing::requiredSize(ringSize) * 2;
+}
+
+std::shared_ptr<SharedMemoryChannel> SharedMemoryChannel::create(boost::asio::io_context& io_context, std::size_t ringSize) {
+	if (!isValidRingSize(ringSize)) {
+		throw std::invalid_argument("Ring size must be a power of two.");
+	}
+	auto memoryFd = ::memfd_create("cyphesis-channel", MFD_CLOEXEC);
+	if (memoryFd == -1) {
+		throw systemError("Could not create shared memory");
+	}
+	if (::ftruncate(memoryFd, static_cast<off_t>(mappedSize(ringSize))) == -1) {
+		auto error = systemError("Could not size shared memory");
+		::close(memoryFd);
+		throw error;
+	}
+	auto memory = ::mmap(nullptr, mappedSize(ringSize), PROT_READ | PROT_WRITE, MAP_SHARED, memoryFd, 0);
+	if (memory == MAP_FAILED) {
+		auto error = systemError("Could not map shared memory");
+		::close(memoryFd);
+		throw error;
+	}
+	auto eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	auto peerEventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (eventFd == -1 || peerEventFd == -1) {
+		auto error = systemError("Could not create eventfd");
+		if (eventFd != -1) {
+			::close(eventFd);
+		}
+		if (peerEventFd != -1) {
+			::close(peerEventFd);
+		}
+		::munmap(memory, mappedSize(ringSize));
+		::close(memoryFd);
+		throw error;
+	}
+	return std::shared_ptr<SharedMemoryChannel>(new SharedMemoryChannel(io_context, memoryFd, memory, ringSize, eventFd, peerEventFd, true));
+}
+
+void SharedMemoryChannel::sendDescriptors(boost::asio::local::stream_protocol::socket& socket) {
+	Announcement announcement{ANNOUNCEMENT_MAGIC, ANNOUNCEMENT_VERSION, m_ringSize};
+	iovec iov{&announcement, sizeof(announcement)};
+
+	//The receiver gets our eventfd as its peer, and the peer eventfd as its own.
+	int descriptors[DESCRIPTOR_COUNT] = {m_memoryFd, m_event.native_handle(), m_peerEventFd};
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(descriptors))] = {};
+
+	msghdr message{};
+	message.msg_iov = &iov;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+	auto cmsg = CMSG_FIRSTHDR(&message);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(descriptors));
+	std::memcpy(CMSG_DATA(cmsg), descriptors, sizeof(descriptors));
+
+	if (::sendmsg(socket.native_handle(), &message, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(announcement))) {
+		throw systemError("Could not send shared memory descriptors");
+	}
+}
+
+void SharedMemoryChannel::asyncReceive(boost::asio::io_context& io_context,
+									   boost::asio::local::stream_protocol::socket& socket,
+									   std::function<void(std::shared_ptr<SharedMemoryChannel>)> callback) {
+	socket.async_wait(boost::asio::local::stream_protocol::socket::wait_read,
+					  [&io_context, &socket, callback](boost::system::error_code ec) {
+						  if (ec) {
+							  callback(nullptr);
+							  return;
+						  }
+						  Announcement announcement{};
+						  iovec iov{&announcement, sizeof(announcement)};
+						  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * DESCRIPTOR_COUNT)] = {};
+
+						  msghdr message{};
+						  message.msg_iov = &iov;
+						  message.msg_iovlen = 1;
+						  message.msg_control = control;
+						  message.msg_controllen = sizeof(control);
+
+						  auto received = ::recvmsg(socket.native_handle(), &message, MSG_CMSG_CLOEXEC);
+						  auto cmsg = CMSG_FIRSTHDR(&message);
+						  if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+							  callback(nullptr);
+							  return;
+						  }
+						  int descriptors[DESCRIPTOR_COUNT];
+						  auto descriptorCount = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+						  std::memcpy(descriptors, CMSG_DATA(cmsg), sizeof(int) * std::min(descriptorCount, DESCRIPTOR_COUNT));
+
+						  auto closeDescriptors = [&]() {
+							  for (std::size_t i = 0; i < std::min(descriptorCount, DESCRIPTOR_COUNT); ++i) {
+								  ::close(descriptors[i]);
+							  }
+						  };
+
+						  if (received != static_cast<ssize_t>(sizeof(announcement))
+							  || descriptorCount != DESCRIPTOR_COUNT
+							  || announcement.magic != ANNOUNCEMENT_MAGIC
+							  || announcement.version != ANNOUNCEMENT_VERSION) {
+							  closeDescriptors();
+							  callback(nullptr);
+							  return;
+						  }
+
+						  //The size comes from the peer, so it must be checked against the memory actually shared before mapping it.
+						  auto ringSize = static_cast<std::size_t>(announcement.ringSize);
+						  struct stat memoryStat{};
+						  if (!isValidRingSize(ringSize)
+							  || ::fstat(descriptors[0], &memoryStat) == -1
+							  || ringSize > static_cast<std::size_t>(memoryStat.st_size)
+							  || mappedSize(ringSize) > static_cast<std::size_t>(memoryStat.st_size)) {
+							  closeDescriptors();
+							  callback(nullptr);
+							  return;
+						  }
+						  auto memory = ::mmap(nullptr, mappedSize(ringSize), PROT_READ | PROT_WRITE, MAP_SHARED, descriptors[0], 0);
+						  if (memory == MAP_FAILED) {
+							  closeDescriptors();
+							  callback(nullptr);
+							  return;
+						  }
+						  callback(std::shared_ptr<SharedMemoryChannel>(new SharedMemoryChannel(io_context,
+																								 descriptors[0],
+																								 memory,
+																								 ringSize,
+																								 descriptors[2],
+																								 descriptors[1],
+																								 false)));
+					  });
+}
+
+void SharedMemoryChannel::async_read_some(boost::asio::mutable_buffer buffer, Handler handler) {
+	m_pendingRead = PendingRead{buffer, std::move(handler)};
+	process();
+}
+
+void SharedMemoryChannel::async_write(boost::asio::const_buffer buffer, Handler handler) {
+	m_pendingWrite = PendingWrite{buffer, 0, std::move(handler)};
+	process();
+}
+
+void SharedMemoryChannel::close() {
+	if (m_closed) {
+		return;
+	}
+	m_closed = true;
+	m_outgoing.header().closed = true;
+	notifyPeer();
+	m_event.cancel();
+	abortPending();
+}
+
+void SharedMemoryChannel::abortPending() {
+	if (m_pendingRead) {
+		complete(std::move(m_pendingRead->handler), boost::asio::error::operation_aborted, 0);
+		m_pendingRead.reset();
+	}
+	if (m_pendingWrite) {
+		complete(std::move(m_pendingWrite->handler), boost::asio::error::operation_aborted, m_pendingWrite->written);
+		m_pendingWrite.reset();
+	}
+}
+
+void SharedMemoryChannel::process() {
+	if (m_closed) {
+		abortPending();
+		return;
+	}
+	while (true) {
+		bool readBlocked = false;
+		bool writeBlocked = false;
+
+		if (m_pendingRead) {
+			auto length = m_incoming.read(m_pendingRead->buffer.data(), m_pendingRead->buffer.size());
+			if (length != 0 || m_pendingRead->buffer.size() == 0) {
+				if (m_incoming.header().writerWaiting.exchange(false)) {
+					notifyPeer();
+				}
+				complete(std::move(m_pendingRead->handler), {}, length);
+				m_pendingRead.reset();
+			} else if (m_incoming.header().closed) {
+				complete(std::move(m_pendingRead->handler), boost::asio::error::eof, 0);
+				m_pendingRead.reset();
+			} else {
+				readBlocked = true;
+			}
+		}
+
+		if (m_pendingWrite) {
+			auto& pending = *m_pendingWrite;
+			auto length = m_outgoing.write(static_cast<const char*>(pending.buffer.data()) + pending.written, pending.buffer.size() - pending.written);
+			pending.written += length;
+			if (length != 0 && m_outgoing.header().readerWaiting.exchange(false)) {
+				notifyPeer();
+			}
+			if (m_incoming.header().closed) {
+				//The other end is gone, so nothing will be read anymore.
+				complete(std::move(pending.handler), boost::asio::error::broken_pipe, pending.written);
+				m_pendingWrite.reset();
+			} else if (pending.written == pending.buffer.size()) {
+				complete(std::move(pending.handler), {}, pending.written);
+				m_pendingWrite.reset();
+			} else {
+				writeBlocked = true;
+			}
+		}
+
+		if (!readBlocked && !writeBlocked) {
+			return;
+		}
+
+		//Tell the other end that we want to be woken up, and then check again, since it might
+		//have written or read in between, without noticing that we wanted to know about it.
+		if (readBlocked) {
+			m_incoming.header().readerWaiting = true;
+		}
+		if (writeBlocked) {
+			m_outgoing.header().writerWaiting = true;
+		}
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if ((readBlocked && (m_incoming.available() != 0 || m_incoming.header().closed)) ||
+			(writeBlocked && (m_outgoing.space() != 0 || m_incoming.header().closed))) {
+			continue;
+		}
+		wait();
+		return;
+	}
+}
+
+void SharedMemoryChannel::wait() {
+	if (m_waiting) {
+		return;
+	}
+	m_waiting = true;
+	auto self(shared_from_this());
+	m_event.async_read_some(boost::asio::buffer(&m_eventValue, sizeof(m_eventValue)),
+							[this, self](boost::system::error_code ec, std::size_t) {
+								m_waiting = false;
+								if (ec != boost::asio::error::operation_aborted) {
+									process();
+								}
+							});
+}
+
+void SharedMemoryChannel::notifyPeer() {
+	std::uint64_t value = 1;
+	//Failure only happens if the counter overflows, in which case the other end is already signaled.
+	[[maybe_unused]] auto result = ::write(m_peerEventFd, &value, sizeof(value));
+}
+
+void SharedMemoryChannel::complete(Handler handler, boost::system::error_code ec, std::size_t length) {
+	//Never call the handler directly, since it's likely to start a new operation.
+	boost::asio::post(m_event.get_executor(), [handler = std::move(handler), ec, length]() {
+		handler(ec, length);
+	});
+}
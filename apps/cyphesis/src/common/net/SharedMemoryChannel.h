@@ -0,0 +1,210 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_SHAREDMEMORYCHANNEL_H
+#define CYPHESIS_SHAREDMEMORYCHANNEL_H
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+
+/**
+ * A single producer, single consumer byte queue placed in memory shared between two processes.
+ */
+class SharedMemoryRing {
+public:
+	/**
+	 * Placed at the start of the memory. Positions only ever increase, and are wrapped when indexing the data.
+	 * The positions are kept on separate cache lines since they are written by different processes.
+	 */
+	struct Header {
+		alignas(64) std::atomic<std::uint64_t> writePosition;
+		alignas(64) std::atomic<std::uint64_t> readPosition;
+		/// Set by the reader when it's about to sleep because the ring is empty.
+		alignas(64) std::atomic<bool> readerWaiting;
+		/// Set by the writer when it's about to sleep because the ring is full.
+		std::atomic<bool> writerWaiting;
+		/// Set by the writer when it won't write anything more.
+		std::atomic<bool> closed;
+	};
+
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Positions must be lock free to be shared between processes.");
+
+	/**
+	 * @param memory Memory of at least requiredSize(capacity) bytes.
+	 * @param capacity Number of bytes of data the ring can hold. Must be a power of two.
+	 */
+	SharedMemoryRing(void* memory, std::size_t capacity);
+
+	static std::size_t requiredSize(std::size_t capacity) {
+		return sizeof(Header) + capacity;
+	}
+
+	/**
+	 * Resets the header. Must only be done by the process which creates the memory.
+	 */
+	void initialize();
+
+	/**
+	 * Copies as much of the data as there's room for into the ring.
+	 * @return The number of bytes written.
+	 */
+	std::size_t write(const void* data, std::size_t size);
+
+	/**
+	 * Copies as much data as is available out of the ring.
+	 * @return The number of bytes read.
+	 */
+	std::size_t read(void* data, std::size_t size);
+
+	std::size_t available() const;
+
+	std::size_t space() const;
+
+	Header& header() {
+		return m_header;
+	}
+
+private:
+	Header& m_header;
+	char* m_data;
+	std::size_t m_capacity;
+};
+
+/**
+ * Transports a byte stream between two processes on the same host through a pair of shared memory rings.
+ *
+ * The memory and the eventfds used for wakeups are created by one end and handed to the other over a local socket.
+ * Thereafter sending data is only a matter of copying it into a ring; the other end is only woken up (through a
+ * system call) if it has run out of data and gone to sleep.
+ *
+ * The interface mimics that of Asio sockets, and is meant to be used from the thread running the io_context.
+ */
+class SharedMemoryChannel : public std::enable_shared_from_this<SharedMemoryChannel> {
+public:
+	typedef std::function<void(boost::system::error_code, std::size_t)> Handler;
+
+	/**
+	 * Enough to hold a large burst of ops without the writer having to wait for the reader.
+	 */
+	static constexpr std::size_t DEFAULT_RING_SIZE = 1u << 22u;
+
+	~SharedMemoryChannel();
+
+	/**
+	 * Creates a new channel, which should then be handed to the other end through sendDescriptors().
+	 * @throws std::system_error
+	 */
+	static std::shared_ptr<SharedMemoryChannel> create(boost::asio::io_context& io_context, std::size_t ringSize = DEFAULT_RING_SIZE);
+
+	/**
+	 * Waits for the other end of the socket to call sendDescriptors(), and sets up a channel from what's received.
+	 * @param socket Must be kept alive until the callback is called.
+	 * @param callback Called with the channel, or null if something went wrong.
+	 */
+	static void asyncReceive(boost::asio::io_context& io_context,
+							 boost::asio::local::stream_protocol::socket& socket,
+							 std::function<void(std::shared_ptr<SharedMemoryChannel>)> callback);
+
+	/**
+	 * Sends the memory and eventfds to the other end of the socket.
+	 * @throws std::system_error
+	 */
+	void sendDescriptors(boost::asio::local::stream_protocol::socket& socket);
+
+	/**
+	 * Reads some data into the buffer, calling the handler once there's at least one byte available.
+	 */
+	void async_read_some(boost::asio::mutable_buffer buffer, Handler handler);
+
+	/**
+	 * Writes all of the data, calling the handler once everything is in the ring.
+	 */
+	void async_write(boost::asio::const_buffer buffer, Handler handler);
+
+	/**
+	 * Tells the other end that no more data will be written, and aborts any outstanding operations.
+	 */
+	void close();
+
+private:
+	struct PendingRead {
+		boost::asio::mutable_buffer buffer;
+		Handler handler;
+	};
+
+	struct PendingWrite {
+		boost::asio::const_buffer buffer;
+		std::size_t written;
+		Handler handler;
+	};
+
+	/**
+	 * @param memory The mapped memory, which is unmapped on destruction.
+	 * @param eventFd Signaled by the other end when we should wake up.
+	 * @param peerEventFd Signaled by us when the other end should wake up.
+	 * @param creator True if we created the memory; the creator writes into the first ring.
+	 */
+	SharedMemoryChannel(boost::asio::io_context& io_context,
+						int memoryFd,
+						void* memory,
+						std::size_t ringSize,
+						int eventFd,
+						int peerEventFd,
+						bool creator);
+
+	int m_memoryFd;
+	void* m_memory;
+	std::size_t m_ringSize;
+	boost::asio::posix::stream_descriptor m_event;
+	int m_peerEventFd;
+	SharedMemoryRing m_outgoing;
+	SharedMemoryRing m_incoming;
+
+	std::optional<PendingRead> m_pendingRead;
+	std::optional<PendingWrite> m_pendingWrite;
+
+	/// True if there's an outstanding read on m_event.
+	bool m_waiting;
+	std::uint64_t m_eventValue;
+	bool m_closed;
+
+	/**
+	 * Progresses outstanding operations, and sleeps until the other end signals us if they can't be completed.
+	 */
+	void process();
+
+	void wait();
+
+	void abortPending();
+
+	void notifyPeer();
+
+	void complete(Handler handler, boost::system::error_code ec, std::size_t length);
+
+	static std::size_t mappedSize(std::size_t ringSize);
+};
+
+#endif //CYPHESIS_SHAREDMEMORYCHANNEL_H
@@ -24,6 +24,7 @@
 extern std::string client_socket_name;
 extern std::string python_socket_name;
 extern std::string slave_socket_name;
+extern std::string shared_memory_socket_name;
 
 extern int client_port_num;
 // extern int dynamic_port_start;
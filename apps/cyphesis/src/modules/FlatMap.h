@@ -0,0 +1,112 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software Foundation,
+ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef CYPHESIS_FLATMAP_H
+#define CYPHESIS_FLATMAP_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief An ordered map stored as a sorted vector.
+ *
+ * Meant for small maps which are looked up much more often than they are altered, where a std::map would spend
+ * more memory on its nodes than on the entries themselves. The interface is a subset of the one of std::map.
+ *
+ * Note that in contrast to std::map any insertion or removal invalidates iterators and references to entries.
+ */
+template<typename KeyT, typename ValueT>
+class FlatMap {
+public:
+	typedef std::pair<KeyT, ValueT> value_type;
+	typedef typename std::vector<value_type>::iterator iterator;
+	typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+	iterator begin() { return m_entries.begin(); }
+
+	iterator end() { return m_entries.end(); }
+
+	const_iterator begin() const { return m_entries.begin(); }
+
+	const_iterator end() const { return m_entries.end(); }
+
+	bool empty() const { return m_entries.empty(); }
+
+	std::size_t size() const { return m_entries.size(); }
+
+	std::size_t capacity() const { return m_entries.capacity(); }
+
+	iterator find(const KeyT& key) {
+		auto I = lowerBound(key);
+		if (I != m_entries.end() && I->first == key) {
+			return I;
+		}
+		return m_entries.end();
+	}
+
+	const_iterator find(const KeyT& key) const {
+		return const_cast<FlatMap*>(this)->find(key);
+	}
+
+	std::size_t count(const KeyT& key) const {
+		return find(key) == end() ? 0 : 1;
+	}
+
+	ValueT& operator[](const KeyT& key) {
+		auto I = lowerBound(key);
+		if (I == m_entries.end() || I->first != key) {
+			I = m_entries.emplace(I, key, ValueT());
+		}
+		return I->second;
+	}
+
+	iterator erase(const_iterator I) {
+		return m_entries.erase(I);
+	}
+
+	std::size_t erase(const KeyT& key) {
+		auto I = find(key);
+		if (I == m_entries.end()) {
+			return 0;
+		}
+		m_entries.erase(I);
+		return 1;
+	}
+
+	void clear() {
+		m_entries.clear();
+	}
+
+	/**
+	 * @brief Releases any memory reserved for entries not yet added.
+	 */
+	void shrink_to_fit() {
+		m_entries.shrink_to_fit();
+	}
+
+private:
+	std::vector<value_type> m_entries;
+
+	iterator lowerBound(const KeyT& key) {
+		return std::lower_bound(m_entries.begin(), m_entries.end(), key,
+								[](const value_type& entry, const KeyT& value) { return entry.first < value; });
+	}
+};
+
+#endif //CYPHESIS_FLATMAP_H
@@ -55,6 +55,7 @@
 
 #include "Awareness.h"
 #include "AwarenessUtils.h"
+#include "Crowd.h"
 
 #include "IHeightProvider.h"
 #include "common/debug.h"
@@ -87,7 +88,7 @@
 #include <cmath>
 #include <vector>
 #include <cstring>
-#include <queue>
+#include <algorithm>
 #include <rules/BBoxProperty.h>
 #include <Atlas/Objects/RootEntity.h>
 #include <wfmath/atlasconv.h>
@@ -184,6 +185,7 @@ Awareness::Awareness(long domainEntityId,
 		mNavMesh(nullptr),
 		mNavQuery(dtAllocNavMeshQuery()),
 		mFilter(new dtQueryFilter()),
+		mCrowd(std::make_unique<Crowd>(mMovingEntities)),
 		mActiveTileList(new MRUList<std::pair<int, int>>()),
 		mObserverCount(0) {
 	auto validExtent = extent;
@@ -392,6 +394,7 @@ void Awareness::addEntity(const MemEntity& observer, const MemEntity& entity, bo
 		entityEntry->isSolid = !solidPropery || solidPropery->isTrue();
 		if (isDynamic) {
 			mMovingEntities.insert(entityEntry.get());
+			mCrowd->invalidateNeighbours();
 		}
 		I = mObservedEntities.emplace(entity.getIdAsInt(), std::move(entityEntry)).first;
 		cy_debug_print("Creating new entry for " << entity.getIdAsString())
@@ -428,6 +431,7 @@ void Awareness::removeEntity(const MemEntity& observer, const MemEntity& entity)
 		if (entityEntry->numberOfObservers == 0) {
 			if (entityEntry->isMoving) {
 				mMovingEntities.erase(entityEntry.get());
+				mCrowd->invalidateNeighbours();
 			}
 			auto areasI = mEntityAreas.find(entityEntry.get());
 			if (areasI != mEntityAreas.end()) {
@@ -550,6 +554,7 @@ bool Awareness::processEntityUpdate(EntityEntry& entityEntry, const MemEntity& e
 					if (entityEntry.velocity.data.isValid() && entityEntry.velocity.data != WFMath::Vector<3>::ZERO()) {
 						cy_debug_print("Entity is now moving.")
 						mMovingEntities.insert(&entityEntry);
+						mCrowd->invalidateNeighbours();
 						entityEntry.isMoving = true;
 						auto existingI = mEntityAreas.find(&entityEntry);
 						if (existingI != mEntityAreas.end()) {
@@ -616,12 +621,15 @@ bool Awareness::avoidObstacles(long avatarEntityId,
 		mObstacleAvoidanceParams->horizTime = 2.5;
 	}
 
-	auto comp = [](EntityCollisionEntry& a, EntityCollisionEntry& b) { return a.distance < b.distance; };
-	std::priority_queue<EntityCollisionEntry, std::vector<EntityCollisionEntry>, decltype(comp)> nearestEntities(comp);
-
 	WFMath::Ball<2> playerRadius(position, 5);
 
-	for (auto& entry: mMovingEntities) {
+	//Only look at those entities which are close by, as given by the spatial hash maintained by the crowd.
+	mCrowd->ensureNeighbours(currentTimestamp);
+	std::vector<const EntityEntry*> neighbours;
+	mCrowd->findNeighbours(position, (float) playerRadius.radius(), currentTimestamp, neighbours);
+
+	std::vector<EntityCollisionEntry> nearestEntities;
+	for (auto& entry: neighbours) {
 
 		//All of the entities have the same location as we have, so we don't need to resolve the position in the world.
 
@@ -630,39 +638,32 @@ bool Awareness::avoidObstacles(long avatarEntityId,
 			continue;
 		}
 
-
-		// Update location
-		auto pos = entry->pos.data;
-		if (entry->velocity.data.isValid()) {
-			auto time_diff = to_seconds(currentTimestamp - entry->velocity.timestamp);
-			pos += (entry->velocity.data * time_diff);
-		}
-
-		if (!pos.isValid()) {
+		auto entityView2dPos = Crowd::projectPosition(*entry, currentTimestamp);
+		if (!entityView2dPos.isValid()) {
 			continue;
 		}
 
-		WFMath::Point<2> entityView2dPos(pos.x(), pos.z());
-		WFMath::Ball<2> entityViewRadius(entityView2dPos, (entry->bbox.data.highCorner().x() - entry->bbox.data.lowCorner().z()) * 0.5);
+		WFMath::Ball<2> entityViewRadius(entityView2dPos, Crowd::avoidanceRadius(*entry));
 		//WFMath::Ball<2> entityViewRadius(entityView2dPos, (entity->location.bBox().highCorner().x() - entity->location.bBox().lowCorner().z()));
 
 		if (WFMath::Intersect(playerRadius, entityViewRadius, false) || WFMath::Contains(playerRadius, entityViewRadius, false)) {
-			nearestEntities.push(EntityCollisionEntry({static_cast<float>(WFMath::Distance(position, entityView2dPos)), entry, entityView2dPos, entityViewRadius}));
+			nearestEntities.emplace_back(EntityCollisionEntry({static_cast<float>(WFMath::Distance(position, entityView2dPos)), entry, entityView2dPos, entityViewRadius}));
 		}
 
 	}
 
 	if (!nearestEntities.empty()) {
+		//Only the closest entities are considered.
+		auto count = std::min(nearestEntities.size(), (size_t) MAX_OBSTACLES_CIRCLES);
+		std::partial_sort(nearestEntities.begin(), nearestEntities.begin() + (long) count, nearestEntities.end(),
+						  [](const EntityCollisionEntry& a, const EntityCollisionEntry& b) { return a.distance < b.distance; });
 		mObstacleAvoidanceQuery->reset();
-		int i = 0;
-		while (!nearestEntities.empty() && i < MAX_OBSTACLES_CIRCLES) {
-			const EntityCollisionEntry& entry = nearestEntities.top();
+		for (size_t i = 0; i < count; ++i) {
+			const EntityCollisionEntry& entry = nearestEntities[i];
 			auto& entity = entry.entity;
 			float pos[]{static_cast<float>(entry.viewPosition.x()), 0, static_cast<float>(entry.viewPosition.y())};
 			float vel[]{static_cast<float>(entity->velocity.data.x()), 0, static_cast<float>(entity->velocity.data.z())};
 			mObstacleAvoidanceQuery->addCircle(pos, entry.viewRadius.radius(), vel, vel);
-			nearestEntities.pop();
-			++i;
 		}
 
 		float pos[]{static_cast<float>(position.x()), 0, static_cast<float>(position.y())};
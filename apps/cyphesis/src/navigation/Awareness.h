@@ -60,6 +60,8 @@ class dtQueryFilter;
 
 class dtObstacleAvoidanceQuery;
 
+class Crowd;
+
 struct dtObstacleAvoidanceParams;
 
 struct IHeightProvider;
@@ -341,6 +343,13 @@ public:
 
 	const std::unordered_map<long, std::unique_ptr<EntityEntry>>& getObservedEntities() const;
 
+	/**
+	 * @brief Gets the crowd shared by all agents steering within this awareness.
+	 */
+	Crowd& getCrowd() const {
+		return *mCrowd;
+	}
+
 	/**
 	 * Checks whether there are any dirty aware tiles that needs to be rebuilt.
 	 * @return
@@ -469,6 +478,11 @@ protected:
 	 */
 	std::set<const EntityEntry*> mMovingEntities;
 
+	/**
+	 * @brief Keeps a spatial hash of mMovingEntities, and queues path requests from agents.
+	 */
+	std::unique_ptr<Crowd> mCrowd;
+
 	/**
 	 * @brief Keeps track of current awareness areas.
 	 *
@@ -0,0 +1,179 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "Crowd.h"
+#include "Awareness.h"
+#include "Steering.h"
+
+#include "Remotery.h"
+
+#include <cmath>
+
+namespace {
+float to_seconds(std::chrono::milliseconds duration) {
+	return std::chrono::duration_cast<std::chrono::duration<float>>(duration).count();
+}
+}
+
+Crowd::Crowd(const std::set<const EntityEntry*>& movingEntities,
+			 std::chrono::milliseconds tickLength,
+			 size_t pathBudget,
+			 float cellSize) :
+		mMovingEntities(movingEntities),
+		mTickLength(tickLength),
+		mPathBudget(pathBudget),
+		mCellSize(cellSize),
+		mMaxRadius(0),
+		mMaxSpeed(0) {
+}
+
+void Crowd::update(std::chrono::milliseconds currentTimestamp) {
+	//Minds have their own idea of the current server time, so allow for them being slightly out of step.
+	if (mLastUpdate && std::chrono::abs(currentTimestamp - *mLastUpdate) < mTickLength) {
+		return;
+	}
+	rmt_ScopedCPUSample(Crowd_update, 0)
+	mLastUpdate = currentTimestamp;
+
+	rebuildNeighbours(currentTimestamp);
+
+	size_t pathsFound = 0;
+	while (pathsFound < mPathBudget && !mPathQueue.empty()) {
+		auto steering = mPathQueue.front();
+		mPathQueue.pop_front();
+		//Skip any requests which have been cancelled since they were queued.
+		if (mPathRequests.erase(steering) == 0) {
+			continue;
+		}
+		steering->updatePath(currentTimestamp);
+		pathsFound++;
+	}
+}
+
+void Crowd::requestPath(Steering& steering) {
+	if (mPathRequests.insert(&steering).second) {
+		mPathQueue.push_back(&steering);
+	}
+}
+
+void Crowd::cancelPathRequest(Steering& steering) {
+	mPathRequests.erase(&steering);
+	if (mPathRequests.empty()) {
+		mPathQueue.clear();
+	}
+}
+
+bool Crowd::isPathRequested(const Steering& steering) const {
+	return mPathRequests.find(&steering) != mPathRequests.end();
+}
+
+size_t Crowd::pendingPathRequests() const {
+	return mPathRequests.size();
+}
+
+void Crowd::invalidateNeighbours() {
+	mNeighboursTimestamp = {};
+}
+
+void Crowd::ensureNeighbours(std::chrono::milliseconds currentTimestamp) {
+	if (!mNeighboursTimestamp || std::chrono::abs(currentTimestamp - *mNeighboursTimestamp) >= mTickLength) {
+		rebuildNeighbours(currentTimestamp);
+	}
+}
+
+void Crowd::findNeighbours(const WFMath::Point<2>& position,
+						   float radius,
+						   std::chrono::milliseconds currentTimestamp,
+						   std::vector<const EntityEntry*>& neighbours) const {
+	if (!mNeighboursTimestamp || mCells.empty()) {
+		return;
+	}
+	//Entities might have moved since the hash was built, so widen the search to account for that.
+	auto reach = radius + mMaxRadius + mMaxSpeed * std::abs(to_seconds(currentTimestamp - *mNeighboursTimestamp));
+
+	auto minX = static_cast<std::int64_t>(std::floor((position.x() - reach) / mCellSize));
+	auto maxX = static_cast<std::int64_t>(std::floor((position.x() + reach) / mCellSize));
+	auto minY = static_cast<std::int64_t>(std::floor((position.y() - reach) / mCellSize));
+	auto maxY = static_cast<std::int64_t>(std::floor((position.y() + reach) / mCellSize));
+
+	for (auto x = minX; x <= maxX; ++x) {
+		for (auto y = minY; y <= maxY; ++y) {
+			auto I = mCells.find(cellKey(x, y));
+			if (I != mCells.end()) {
+				neighbours.insert(neighbours.end(), I->second.begin(), I->second.end());
+			}
+		}
+	}
+}
+
+WFMath::Point<2> Crowd::projectPosition(const EntityEntry& entry, std::chrono::milliseconds currentTimestamp) {
+	auto pos = entry.pos.data;
+	if (entry.velocity.data.isValid()) {
+		pos += (entry.velocity.data * to_seconds(currentTimestamp - entry.velocity.timestamp));
+	}
+	if (!pos.isValid()) {
+		return {};
+	}
+	return {pos.x(), pos.z()};
+}
+
+float Crowd::avoidanceRadius(const EntityEntry& entry) {
+	return static_cast<float>((entry.bbox.data.highCorner().x() - entry.bbox.data.lowCorner().z()) * 0.5);
+}
+
+std::int64_t Crowd::cellKey(std::int64_t x, std::int64_t y) const {
+	return (x << 32) ^ (y & 0xFFFFFFFF);
+}
+
+void Crowd::rebuildNeighbours(std::chrono::milliseconds currentTimestamp) {
+	rmt_ScopedCPUSample(Crowd_rebuildNeighbours, 0)
+	//Keep the cell vectors around, to avoid allocations when entities stay within the same cells.
+	for (auto& entry: mCells) {
+		entry.second.clear();
+	}
+	mMaxRadius = 0;
+	mMaxSpeed = 0;
+
+	for (auto& entry: mMovingEntities) {
+		auto pos = projectPosition(*entry, currentTimestamp);
+		if (!pos.isValid()) {
+			continue;
+		}
+		if (entry->bbox.data.isValid()) {
+			mMaxRadius = std::max(mMaxRadius, std::abs(avoidanceRadius(*entry)));
+		}
+		if (entry->velocity.data.isValid()) {
+			mMaxSpeed = std::max(mMaxSpeed, static_cast<float>(entry->velocity.data.mag()));
+		}
+		auto x = static_cast<std::int64_t>(std::floor(pos.x() / mCellSize));
+		auto y = static_cast<std::int64_t>(std::floor(pos.y() / mCellSize));
+		mCells[cellKey(x, y)].push_back(entry);
+	}
+
+	//Don't let cells which no longer are used accumulate as entities move around.
+	if (mCells.size() > mMovingEntities.size() * 4) {
+		for (auto I = mCells.begin(); I != mCells.end();) {
+			if (I->second.empty()) {
+				I = mCells.erase(I);
+			} else {
+				++I;
+			}
+		}
+	}
+	mNeighboursTimestamp = currentTimestamp;
+}
@@ -0,0 +1,170 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CROWD_H_
+#define CROWD_H_
+
+#include <wfmath/point.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct EntityEntry;
+
+class Steering;
+
+/**
+ * @brief Shared state for all agents steering within the same Awareness.
+ *
+ * Instead of every Steering instance doing its own work each time it's updated, the crowd does the work that
+ * can be shared in one pass per tick:
+ *
+ * - A spatial hash of all moving entities is rebuilt, so that obstacle avoidance only needs to look at entities
+ *   in neighbouring cells, instead of at all moving entities.
+ * - Path requests from all agents are put in a shared queue, and only a limited number of them are serviced
+ *   each tick. This avoids spikes when many agents need new paths at the same time, as happens when a tile is rebuilt.
+ *   Once a path is found it's delivered to the Steering instance through Steering::updatePath().
+ *
+ * The tick is driven by the agents themselves; the first agent to be updated in a new tick will run the pass.
+ */
+class Crowd {
+public:
+	/**
+	 * @param movingEntities The moving entities of the Awareness. These are what the spatial hash is built from.
+	 * @param tickLength The length of a tick. Calls to update() within the same tick will do nothing.
+	 * @param pathBudget The max number of paths to find each tick.
+	 * @param cellSize The size of each cell in the spatial hash, in world units.
+	 */
+	explicit Crowd(const std::set<const EntityEntry*>& movingEntities,
+				   std::chrono::milliseconds tickLength = std::chrono::milliseconds(20),
+				   size_t pathBudget = 4,
+				   float cellSize = 8.0f);
+
+	/**
+	 * @brief Runs the batched pass, if a new tick has started.
+	 *
+	 * The spatial hash is rebuilt and queued path requests are serviced.
+	 * @param currentTimestamp The current server timestamp.
+	 */
+	void update(std::chrono::milliseconds currentTimestamp);
+
+	/**
+	 * @brief Queues a path update for the agent.
+	 *
+	 * Nothing happens if the agent already has a request queued.
+	 */
+	void requestPath(Steering& steering);
+
+	/**
+	 * @brief Removes any queued path request for the agent.
+	 *
+	 * This must be called when an agent is destroyed or moved to another Awareness.
+	 */
+	void cancelPathRequest(Steering& steering);
+
+	bool isPathRequested(const Steering& steering) const;
+
+	size_t pendingPathRequests() const;
+
+	/**
+	 * @brief Marks the spatial hash as invalid, which forces a rebuild on the next query.
+	 *
+	 * Call this whenever an entity is added to or removed from the moving entities.
+	 */
+	void invalidateNeighbours();
+
+	/**
+	 * @brief Makes sure that the spatial hash can be used to query positions at the timestamp.
+	 *
+	 * The hash is rebuilt if it's been invalidated, or if it was built in another tick.
+	 */
+	void ensureNeighbours(std::chrono::milliseconds currentTimestamp);
+
+	/**
+	 * @brief Finds all moving entities which might be within the radius of the position.
+	 *
+	 * The result is a superset of those entities which are actually within the radius; the caller is expected
+	 * to do exact checks. ensureNeighbours() must have been called first.
+	 * @param position The position to search around.
+	 * @param radius The search radius.
+	 * @param currentTimestamp The timestamp of the query, used to account for entities moving since the hash was built.
+	 * @param neighbours Entities are added to this.
+	 */
+	void findNeighbours(const WFMath::Point<2>& position,
+						float radius,
+						std::chrono::milliseconds currentTimestamp,
+						std::vector<const EntityEntry*>& neighbours) const;
+
+	/**
+	 * @brief Calculates the position of the entity at the timestamp, projecting it along its velocity.
+	 */
+	static WFMath::Point<2> projectPosition(const EntityEntry& entry, std::chrono::milliseconds currentTimestamp);
+
+	/**
+	 * @brief The radius of the circle used to represent the entity when avoiding it.
+	 */
+	static float avoidanceRadius(const EntityEntry& entry);
+
+private:
+	const std::set<const EntityEntry*>& mMovingEntities;
+	std::chrono::milliseconds mTickLength;
+	size_t mPathBudget;
+	float mCellSize;
+
+	/**
+	 * @brief The timestamp of the last batched pass.
+	 */
+	std::optional<std::chrono::milliseconds> mLastUpdate;
+
+	/**
+	 * @brief Queued path requests, in order.
+	 *
+	 * Requests which have been cancelled are left in here and skipped; mPathRequests is what's authoritative.
+	 */
+	std::deque<Steering*> mPathQueue;
+	std::unordered_set<const Steering*> mPathRequests;
+
+	std::unordered_map<std::int64_t, std::vector<const EntityEntry*>> mCells;
+
+	/**
+	 * @brief The timestamp used when the hash was built, if it's valid.
+	 */
+	std::optional<std::chrono::milliseconds> mNeighboursTimestamp;
+
+	/**
+	 * @brief The largest radius of any entity in the hash.
+	 */
+	float mMaxRadius;
+
+	/**
+	 * @brief The highest speed of any entity in the hash. Used to widen queries made later than when the hash was built.
+	 */
+	float mMaxSpeed;
+
+	std::int64_t cellKey(std::int64_t x, std::int64_t y) const;
+
+	void rebuildNeighbours(std::chrono::milliseconds currentTimestamp);
+};
+
+#endif /* CROWD_H_ */
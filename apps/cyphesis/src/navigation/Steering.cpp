@@ -18,6 +18,7 @@
 
 #include "Steering.h"
 #include "Awareness.h"
+#include "Crowd.h"
 
 #include "rules/ai/MemEntity.h"
 #include "rules/ScaleProperty_impl.h"
@@ -63,7 +64,16 @@ Steering::Steering(MemEntity& avatar) :
 
 }
 
+Steering::~Steering() {
+	if (mAwareness) {
+		mAwareness->getCrowd().cancelPathRequest(*this);
+	}
+}
+
 void Steering::setAwareness(Awareness* awareness) {
+	if (mAwareness) {
+		mAwareness->getCrowd().cancelPathRequest(*this);
+	}
 	mAwareness = awareness;
 	mTileListenerConnection.disconnect();
 	if (mAwareness) {
@@ -217,6 +227,8 @@ int Steering::updatePath(std::chrono::milliseconds currentTimestamp, const WFMat
 		mPathResult = -7;
 		return mPathResult;
 	}
+	//Any queued request is satisfied by this update.
+	mAwareness->getCrowd().cancelPathRequest(*this);
 	auto resolvedPosition = resolvePosition(currentTimestamp, mSteeringDestination.location);
 	if (!resolvedPosition.position.isValid()) {
 		mPathResult = -8;
@@ -276,6 +288,14 @@ bool Steering::isEnabled() const {
 	return mSteeringEnabled;
 }
 
+bool Steering::isActive() const {
+	if (mSteeringEnabled) {
+		return true;
+	}
+	auto propelProperty = mAvatar.getPropertyClass<Vector3Property<MemEntity>>("_propel");
+	return propelProperty && propelProperty->data().isValid() && propelProperty->data() != WFMath::Vector<3>::ZERO();
+}
+
 const std::vector<WFMath::Point<3>>& Steering::getPath() const {
 	return mPath;
 }
@@ -383,11 +403,14 @@ SteeringResult Steering::update(std::chrono::milliseconds currentTimestamp) {
 		}
 	} else if (mAwareness) {
 
-		auto currentEntityPos = getCurrentAvatarPosition(currentTimestamp);
-
+		auto& crowd = mAwareness->getCrowd();
 		if (mUpdateNeeded) {
-			updatePath(currentTimestamp, currentEntityPos);
+			crowd.requestPath(*this);
 		}
+		crowd.update(currentTimestamp);
+
+		auto currentEntityPos = getCurrentAvatarPosition(currentTimestamp);
+
 		if (!mPath.empty()) {
 			//First check if we've arrived at our actual destination.
 			if (isAtCurrentDestination(currentTimestamp)) {
@@ -467,7 +490,7 @@ SteeringResult Steering::update(std::chrono::milliseconds currentTimestamp) {
 					mExpectingServerMovement = true;
 				}
 			}
-		} else {
+		} else if (!crowd.isPathRequested(*this)) {
 			//We are steering, but the path is empty, which means we can't find any path. If we're moving we should stop movement.
 			//But we won't stop steering; perhaps we'll find a path later.
 			if (mLastSentVelocity != WFMath::Vector<2>::ZERO()) {
@@ -147,7 +147,7 @@ public:
 
 	explicit Steering(MemEntity& avatar);
 
-	virtual ~Steering() = default;
+	virtual ~Steering();
 
 	void setAwareness(Awareness* awareness);
 
@@ -172,7 +172,7 @@ public:
 	 * @brief Requests an update of the path.
 	 *
 	 * The actual update will be deferred to when updatePath() is called, which normally happens
-	 * with a call to update()
+	 * when the path request queued by update() is serviced by the Crowd.
 	 */
 	void requestUpdate();
 
@@ -192,6 +192,15 @@ public:
 	 */
 	bool isEnabled() const;
 
+	/**
+	 * @brief Returns true if update() has any work to do.
+	 *
+	 * This is the case when steering is enabled, but also when it's disabled while the avatar still is being propelled,
+	 * as update() then will stop it.
+	 * @return True if update() needs to be called.
+	 */
+	bool isActive() const;
+
 	/**
 	 * @brief Sets the desired speed.
 	 * @param desiredSpeed The desired speed, as a normalized value.
@@ -224,6 +233,7 @@ public:
 	 * @brief Updates the steering.
 	 *
 	 * Call this often when steering is enabled.
+	 * Any needed path update is queued with the Crowd of the Awareness, and the current path is used until it has been serviced.
 	 */
 	SteeringResult update(std::chrono::milliseconds currentTimestamp);
 
@@ -80,6 +80,14 @@ void AwareMind::processNavmesh() {
 }
 
 
+bool AwareMind::isMoveActive() const {
+	return mSteering && mSteering->isActive();
+}
+
+bool AwareMind::isNavmeshActive() const {
+	return mAwareness && (mAwareness->hasDirtyAwareTiles() || mAwareness->needsPruning());
+}
+
 void AwareMind::processMove(OpVector& res) {
 	rmt_ScopedCPUSample(AwareMind_processMove, 0)
 	if (mSteering) {
@@ -256,6 +264,13 @@ void AwareMind::entityDeleted(MemEntity& entity) {
 	}
 }
 
+void AwareMind::entityForgotten(MemEntity& entity) {
+	BaseMind::entityForgotten(entity);
+	if (mAwareness) {
+		mAwareness->removeEntity(*m_ownEntity, entity);
+	}
+}
+
 void AwareMind::setOwnEntity(OpVector& res, Ref<MemEntity> ownEntity) {
 	BaseMind::setOwnEntity(res, ownEntity);
 
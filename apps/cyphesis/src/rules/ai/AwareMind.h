@@ -50,6 +50,8 @@ public:
 
 	void entityDeleted(MemEntity& entity) override;
 
+	void entityForgotten(MemEntity& entity) override;
+
 	int updatePath();
 
 	Steering* getSteering();
@@ -79,6 +81,10 @@ protected:
 
 	void processNavmesh() override;
 
+	bool isMoveActive() const override;
+
+	bool isNavmeshActive() const override;
+
 	void requestAwareness(const MemEntity& entity);
 
 	void parseTerrain(const Atlas::Message::Element& terrainElement);
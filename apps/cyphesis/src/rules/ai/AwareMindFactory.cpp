@@ -28,6 +28,8 @@ AwareMindFactory::AwareMindFactory(TypeStore<MemEntity>& typeStore)
 }
 
 BaseMind* AwareMindFactory::newMind(RouterId mind_id, const std::string& entity_id) const {
-	return new AwareMind(mind_id, entity_id, mTypeStore, *mSharedTerrain, *mAwarenessStoreProvider);
+	auto mind = new AwareMind(mind_id, entity_id, mTypeStore, *mSharedTerrain, *mAwarenessStoreProvider);
+	mind->getMap()->setLimits(m_memoryLimits);
+	return mind;
 }
 
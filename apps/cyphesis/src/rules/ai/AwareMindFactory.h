@@ -22,6 +22,7 @@
 #include "AwarenessStoreProvider.h"
 #include "SharedTerrain.h"
 #include "MindFactory.h"
+#include "MemMap.h"
 #include "common/TypeStore.h"
 
 #include <unordered_map>
@@ -37,6 +38,11 @@ public:
 
 	BaseMind* newMind(RouterId id, const std::string& entity_id) const override;
 
+	/**
+	 * Limits on the memory of each new mind.
+	 */
+	MemMap::Limits m_memoryLimits;
+
 protected:
 	TypeStore<MemEntity>& mTypeStore;
 	std::unique_ptr<SharedTerrain> mSharedTerrain;
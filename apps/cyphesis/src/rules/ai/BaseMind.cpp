@@ -46,6 +46,7 @@ using Atlas::Objects::smart_dynamic_cast;
 
 static constexpr auto debug_flag = false;
 
+const std::chrono::steady_clock::duration BaseMind::s_drainInterval = std::chrono::milliseconds(10);
 
 BaseMind::BaseMind(RouterId mindId, std::string entityId, TypeStore<MemEntity>& typeStore) :
 		Router(mindId),
@@ -71,9 +72,6 @@ BaseMind::~BaseMind() {
 
 void BaseMind::init(OpVector& res) {
 
-	//Initiate the ticks.
-	processTick(res);
-
 	Look look;
 	Root lookArg;
 	lookArg->setId(m_entityId);
@@ -83,6 +81,7 @@ void BaseMind::init(OpVector& res) {
 }
 
 void BaseMind::destroy() {
+	m_flags.addFlags(mem_entity_destroyed);
 	m_map.flush();
 	setScript(nullptr);
 }
@@ -102,7 +101,13 @@ void BaseMind::sightSetOperation(const Operation& op, OpVector& res) {
 		spdlog::error("Got sight(set) of non-entity");
 		return;
 	}
-	m_map.updateAdd(ent, std::chrono::milliseconds(op->getStamp()), res);
+	auto entity = m_map.updateAdd(ent, std::chrono::milliseconds(op->getStamp()), res);
+	//The changes only bring us up to date if they directly follow the version we know about.
+	if (entity && entity->hasKnownSeq() && ent->hasAttrFlag(Atlas::Objects::STAMP_FLAG)) {
+		if ((int) ent->getStamp() == entity->getSeq() + 1) {
+			entity->setSeq((int) ent->getStamp());
+		}
+	}
 }
 
 void BaseMind::SoundOperation(const Operation& op, OpVector& res) {
@@ -164,7 +169,11 @@ void BaseMind::SightOperation(const Operation& op, OpVector& res) {
 			return;
 		}
 		cy_debug_print(" arg is an entity!")
-		m_map.updateAdd(ent, std::chrono::milliseconds(op->getStamp()), res);
+		auto entity = m_map.updateAdd(ent, std::chrono::milliseconds(op->getStamp()), res);
+		//A sight of an entity contains either the whole entity, or everything that's changed since the version we told the server we know about.
+		if (entity && ent->hasAttrFlag(Atlas::Objects::STAMP_FLAG)) {
+			entity->setSeq((int) ent->getStamp());
+		}
 	}
 }
 
@@ -211,11 +220,16 @@ void BaseMind::AppearanceOperation(const Operation& op, OpVector& res) {
 		auto entity = m_map.getAdd(id);
 		if (entity) {
 			if (arg->hasAttrFlag(Atlas::Objects::STAMP_FLAG)) {
-				//TODO: look over this whole system, so it's either implemented correctly or removed.
 				if ((int) arg->getStamp() != entity->getSeq()) {
 					Look l;
 					Anonymous m;
 					m->setId(id);
+					//Tell the server which version we know about, so that we only get what's changed since.
+					if (entity->hasKnownSeq()) {
+						m->setStamp(entity->getSeq());
+					} else if (auto seq = m_map.getDisappearedSeq(id)) {
+						m->setStamp(*seq);
+					}
 					l->setArgs1(m);
 					res.push_back(l);
 				}
@@ -251,6 +265,8 @@ void BaseMind::DisappearanceOperation(const Operation& op, OpVector& res) {
 			if (id.empty()) {
 				continue;
 			}
+			//Remember the version we knew about, so that if it appears again we only need to ask for what's changed.
+			m_map.disappear(id);
 			removeEntity(id, res);
 		}
 	}
@@ -488,20 +504,15 @@ void BaseMind::operation(const Operation& op, OpVector& res) {
 
 void BaseMind::processTick(OpVector& res) {
 	rmt_ScopedCPUSample(tick, 0)
-	//Start by scheduling the next tick op.
-	Atlas::Objects::Operation::Tick tick;
-	//Do one tick every 10ms. (to be revisited)
-	tick->setFutureMilliseconds(10);
-	tick->setTo(getIdAsString());
-	tick->setFrom(getIdAsString());
-	res.emplace_back(std::move(tick));
+	auto now = std::chrono::steady_clock::now();
+	m_lastTickTime = now;
+	auto resSize = res.size();
 
 	//Do some housekeeping first.
 	m_map.check(mServerTime);
 	if (m_ownEntity) {
 
 		//Check if we should think?
-		auto now = std::chrono::steady_clock::now();
 		if (now >= m_tickControl.think.next) {
 			rmt_ScopedCPUSample(think, 0)
 			if (m_script) {
@@ -541,6 +552,40 @@ void BaseMind::processTick(OpVector& res) {
 	}
 
 	m_map.sendLook(res);
+
+	for (auto I = res.begin() + static_cast<OpVector::difference_type>(resSize); I != res.end(); ++I) {
+		if ((*I)->isDefaultFrom()) {
+			(*I)->setFrom(getIdAsString());
+		}
+	}
+}
+
+bool BaseMind::hasQueuedOperations() const {
+	if (m_ownEntity && (!m_pendingOperations.empty() || !mOutgoingOperations.empty())) {
+		return true;
+	}
+	return !m_map.getTypeResolverOps().empty() || m_map.hasPendingLooks();
+}
+
+std::chrono::steady_clock::time_point BaseMind::getNextTickTime() const {
+	if (isDestroyed()) {
+		return std::chrono::steady_clock::time_point::max();
+	}
+	auto next = std::chrono::steady_clock::time_point::max();
+	if (hasQueuedOperations()) {
+		next = m_lastTickTime + s_drainInterval;
+	}
+	if (m_ownEntity) {
+		next = std::min(next, m_tickControl.think.next);
+		//Moving and navmesh updates are frequent, so only wake up for them when there's something to do.
+		if (isMoveActive()) {
+			next = std::min(next, m_tickControl.move.next);
+		}
+		if (isNavmeshActive()) {
+			next = std::min(next, m_tickControl.navmesh.next);
+		}
+	}
+	return next;
 }
 
 
@@ -648,6 +693,20 @@ void BaseMind::entityDeleted(MemEntity& entity) {
 	}
 }
 
+void BaseMind::entityForgotten(MemEntity& entity) {
+	m_pendingEntitiesOperations.erase(entity.getIdAsString());
+}
+
+bool BaseMind::isEntityPinned(const MemEntity& entity) const {
+	//Our own entity, and anything containing it, must always be remembered.
+	for (auto ancestor = m_ownEntity.get(); ancestor; ancestor = ancestor->m_parent) {
+		if (ancestor == &entity) {
+			return true;
+		}
+	}
+	return false;
+}
+
 
 std::ostream& operator<<(std::ostream& s, const BaseMind& d) {
 	if (d.m_ownEntity) {
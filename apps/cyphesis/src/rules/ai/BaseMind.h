@@ -73,6 +73,10 @@ protected:
 
 	void entityDeleted(MemEntity& entity) override;
 
+	void entityForgotten(MemEntity& entity) override;
+
+	bool isEntityPinned(const MemEntity& entity) const override;
+
 	void updateServerTimeFromOperation(const Atlas::Objects::Operation::RootOperationData& op);
 
 	/**
@@ -92,10 +96,28 @@ protected:
 		TimeControl navmesh;
 	} m_tickControl;
 
+	/**
+	 * When the mind last was ticked. Queued up operations are sent at most one per queue each tick,
+	 * and at most every "s_drainInterval".
+	 */
+	std::chrono::steady_clock::time_point m_lastTickTime;
+
+	bool hasQueuedOperations() const;
+
 
 	virtual void processMove(OpVector& res) {};
 
 	virtual void processNavmesh() {};
+
+	/**
+	 * @return True if processMove() has any work to do. If not, no ticks are scheduled for it.
+	 */
+	virtual bool isMoveActive() const { return false; }
+
+	/**
+	 * @return True if processNavmesh() has any work to do. If not, no ticks are scheduled for it.
+	 */
+	virtual bool isNavmeshActive() const { return false; }
 public:
 	BaseMind(RouterId mindId, std::string entityId, TypeStore<MemEntity>& typeStore);
 
@@ -122,6 +144,13 @@ public:
 		return m_ownEntity;
 	}
 
+	/// \brief The id of the entity this mind controls, as given when the mind was created.
+	///
+	/// Unlike getEntity() this is always available, even before the mind has been told about its entity.
+	const std::string& getEntityId() const {
+		return m_entityId;
+	}
+
 	const TypeStore<MemEntity>& getTypeStore() const;
 
 	/// \brief Is this mind active
@@ -178,8 +207,26 @@ public:
 
 	void setDeleteHook(std::string hook) { m_deleteHook = std::move(hook); }
 
+	/**
+	 * @brief Performs any periodic work which is due, such as thinking, moving and updating the navmesh, and sends queued operations.
+	 *
+	 * This is called by the scheduler owning the mind, at the time returned by getNextTickTime().
+	 */
 	void processTick(OpVector& res);
 
+	/**
+	 * @brief Gets the time at which processTick() next needs to be called.
+	 *
+	 * This changes as the mind handles operations, so it needs to be checked after each operation.
+	 * @return The next tick time, or time_point::max() if the mind doesn't need to be ticked until it gets an operation.
+	 */
+	std::chrono::steady_clock::time_point getNextTickTime() const;
+
+	/**
+	 * The minimum time between ticks when the mind has queued up operations to send.
+	 */
+	static const std::chrono::steady_clock::duration s_drainInterval;
+
 };
 
 std::ostream& operator<<(std::ostream& s, const BaseMind& d);
@@ -31,10 +31,12 @@ using Atlas::Message::MapType;
 
 static constexpr auto debug_flag = false;
 
+std::function<bool(const MemEntity&)> MemEntity::isReferencedByScript;
+
 MemEntity::MemEntity(RouterId id, const TypeNode<MemEntity>* typeNode) :
 		RouterIdentifiable(std::move(id)),
 		m_lastSeen(0),
-		m_seq(0),
+		m_seq(-1),
 		m_lastUpdated(0),
 		m_flags(0),
 		m_type(typeNode),
@@ -143,6 +145,16 @@ PropertyCore<MemEntity>* MemEntity::setAttr(const std::string& name, const Atlas
 }
 
 
+void MemEntity::removeAttr(const std::string& name) {
+	auto I = m_properties.find(name);
+	if (I != m_properties.end()) {
+		if (I->second.property) {
+			I->second.property->remove(*this, name);
+		}
+		m_properties.erase(I);
+	}
+}
+
 void MemEntity::applyProperty(const std::string& name, PropertyCore<MemEntity>& prop) {
 	// Allow the value to take effect.
 	prop.apply(*this);
@@ -21,6 +21,7 @@
 
 #include "modules/ReferenceCounted.h"
 #include "modules/Ref.h"
+#include "modules/FlatMap.h"
 #include "common/Router.h"
 #include "common/PropertyManager.h"
 #include "common/log.h"
@@ -31,6 +32,7 @@
 
 #include <chrono>
 #include <any>
+#include <functional>
 #include <set>
 #include <optional>
 
@@ -59,6 +61,18 @@ public:
 		std::unique_ptr<PropertyCore<MemEntity>> property;
 
 	};
+
+	/**
+	 * Minds remember a lot of entities, most of which only have a handful of instance properties,
+	 * so these are kept in a sorted vector rather than in a tree.
+	 */
+	typedef FlatMap<std::string, PropertyEntry> PropertyStore;
+
+	/**
+	 * If set, used to check if the scripting system holds any references to an entity, apart from the one in m_scriptEntity.
+	 */
+	static std::function<bool(const MemEntity&)> isReferencedByScript;
+
 protected:
 
 
@@ -67,9 +81,9 @@ protected:
 	std::unique_ptr<PropertyCore<MemEntity>> createProperty(const std::string& propertyName) const;
 
 
-	std::map<std::string, PropertyEntry> m_properties;
+	PropertyStore m_properties;
 
-	/// Sequence number
+	/// Sequence number of the version of the entity we know about, or -1 if we've never seen all of it.
 	int m_seq;
 
 	void clearProperties();
@@ -107,10 +121,13 @@ public:
 
 	std::chrono::milliseconds m_lastUpdated;
 
-	const std::map<std::string, PropertyEntry>& getProperties() const { return m_properties; }
+	const PropertyStore& getProperties() const { return m_properties; }
 
 	PropertyCore<MemEntity>* setAttr(const std::string& name, const Atlas::Message::Element& modifier);
 
+	/// \brief Removes an instance property, if there is one.
+	void removeAttr(const std::string& name);
+
 	void applyProperty(const std::string& name, PropertyCore<MemEntity>& prop);
 
 	/// @brief Signal emitted whenever a property update is applied.
@@ -265,6 +282,12 @@ public:
 		m_seq++;
 	}
 
+	/// \brief Sets the sequence number of the version of the entity we know about.
+	void setSeq(int seq) { m_seq = seq; }
+
+	/// \brief Checks if we know about a complete version of the entity, as opposed to just parts of it.
+	bool hasKnownSeq() const { return m_seq >= 0; }
+
 	/**
 	 * This is needed for the Filter system to work. Not sure if we want to implement it for MemEntities though.
 	 * Perhaps there's a need?
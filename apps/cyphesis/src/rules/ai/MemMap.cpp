@@ -36,8 +36,23 @@
 #include <Atlas/Objects/Anonymous.h>
 #include <Atlas/Objects/Operation.h>
 
+#include <algorithm>
+#include <iterator>
+
 static constexpr auto debug_flag = false;
 
+namespace {
+/**
+ * How many entities to examine for staleness each time the map is checked.
+ */
+constexpr size_t entitiesCheckedPerCall = 10;
+/**
+ * How many of the least recently seen entities to examine each time the map is checked, when looking for entities
+ * to forget because of the limits.
+ */
+constexpr size_t maxEntitiesExaminedForLimits = 100;
+}
+
 using Atlas::Message::Element;
 using Atlas::Message::MapType;
 using Atlas::Objects::Operation::Look;
@@ -56,6 +71,7 @@ void MemMap::addEntity(const Ref<MemEntity>& entity) {
 	}
 	m_entities[entity->getIdAsInt()] = entity;
 	m_checkIterator = m_entities.find(next);
+	markAsSeen(entity->getIdAsInt());
 }
 
 void MemMap::readEntity(const Ref<MemEntity>& entity,
@@ -176,7 +192,8 @@ Ref<MemEntity> MemMap::newEntity(const RouterId& id,
 MemMap::MemMap(TypeResolver& typeResolver)
 		: m_checkIterator(m_entities.begin()),
 		  m_listener(nullptr),
-		  m_typeResolver(typeResolver) {
+		  m_typeResolver(typeResolver),
+		  m_forgottenCount(0) {
 }
 
 MemMap::~MemMap() {
@@ -196,6 +213,10 @@ void MemMap::sendLook(OpVector& res) {
 		Look l;
 		Anonymous look_arg;
 		look_arg->setId(id.asString());
+		auto I = m_disappearedEntities.find(id.m_intId);
+		if (I != m_disappearedEntities.end()) {
+			look_arg->setStamp(I->second.seq);
+		}
 		l->setArgs1(std::move(look_arg));
 		res.emplace_back(std::move(l));
 	}
@@ -227,12 +248,14 @@ Ref<MemEntity> MemMap::del(const std::string& id)
 	if (I != m_entities.end()) {
 		auto ent = I->second;
 		assert(ent);
+		forgetDisappeared(int_id);
 
 		long next = -1;
 		if (m_checkIterator != m_entities.end()) {
 			next = m_checkIterator->first;
 		}
 		m_entities.erase(I);
+		removeFromRecentlySeen(int_id);
 
 
 		if (next != -1) {
@@ -252,6 +275,52 @@ Ref<MemEntity> MemMap::del(const std::string& id)
 	return {};
 }
 
+Ref<MemEntity> MemMap::disappear(const std::string& id) {
+	auto I = m_entities.find(integerId(id));
+	//Only an entity which we've seen all of can later be updated with what's changed.
+	if (I == m_entities.end() || !I->second->hasKnownSeq() || m_limits.maxDisappearedEntities == 0) {
+		return del(id);
+	}
+	auto int_id = I->first;
+	auto& entity = *I->second;
+	DisappearedEntity disappeared{{}, entity.getSeq(), {}};
+	for (auto& entry: entity.getProperties()) {
+		Element value;
+		if (entry.second.property && entry.second.property->get(value) == 0) {
+			disappeared.properties.emplace(entry.first, std::move(value));
+		}
+	}
+	if (entity.m_parent) {
+		disappeared.properties.emplace("loc", entity.m_parent->getIdAsString());
+	}
+
+	auto result = del(id);
+
+	m_disappearedOrder.push_front(int_id);
+	disappeared.orderIterator = m_disappearedOrder.begin();
+	m_disappearedEntities.emplace(int_id, std::move(disappeared));
+	while (m_disappearedEntities.size() > m_limits.maxDisappearedEntities) {
+		forgetDisappeared(m_disappearedOrder.back());
+	}
+	return result;
+}
+
+std::optional<int> MemMap::getDisappearedSeq(const std::string& id) const {
+	auto I = m_disappearedEntities.find(integerId(id));
+	if (I != m_disappearedEntities.end()) {
+		return I->second.seq;
+	}
+	return std::nullopt;
+}
+
+void MemMap::forgetDisappeared(long id) {
+	auto I = m_disappearedEntities.find(id);
+	if (I != m_disappearedEntities.end()) {
+		m_disappearedOrder.erase(I->second.orderIterator);
+		m_disappearedEntities.erase(I);
+	}
+}
+
 Ref<MemEntity> MemMap::get(const std::string& id) const
 // Get an entity from memory
 {
@@ -332,16 +401,48 @@ Ref<MemEntity> MemMap::updateAdd(const RootEntity& ent, std::chrono::millisecond
 		return nullptr;
 	}
 
+	//A reply to a look in which we told which version we knew about only contains what's changed since, along with
+	//which properties have been removed.
+	Element removed;
+	bool hasOnlyChanges = ent->copyAttr("removed_properties", removed) == 0 && removed.isList();
+	if (hasOnlyChanges) {
+		ent->removeAttr("removed_properties");
+	}
+	auto isRemoved = [&](const std::string& name) {
+		return hasOnlyChanges && std::find(removed.List().begin(), removed.List().end(), Element(name)) != removed.List().end();
+	};
+
+	auto disappearedI = m_disappearedEntities.find(int_id);
+	if (disappearedI != m_disappearedEntities.end()) {
+		if (hasOnlyChanges) {
+			//Fill in what hasn't changed since the entity disappeared.
+			for (auto& entry: disappearedI->second.properties) {
+				if (!ent->hasAttr(entry.first) && !isRemoved(entry.first)) {
+					ent->setAttr(entry.first, entry.second);
+				}
+			}
+		}
+		forgetDisappeared(int_id);
+	}
+
 	auto I = m_entities.find(int_id);
 	Ref<MemEntity> entity;
 	if (I == m_entities.end()) {
 		entity = newEntity(RouterId{int_id}, ent, d, res);
 	} else {
 		entity = I->second;
+		if (hasOnlyChanges) {
+			for (auto& name: removed.List()) {
+				if (name.isString()) {
+					entity->removeAttr(name.String());
+				}
+			}
+		}
 		updateEntity(entity, ent, d, res);
 	}
 	if (entity) {
 		entity->update(d);
+		markAsSeen(int_id);
 	}
 	return entity;
 }
@@ -444,22 +545,104 @@ EntityVector MemMap::findByLocation(const EntityLocation<MemEntity>& loc,
 	return res;
 }
 
-void MemMap::check(std::chrono::milliseconds time) {
-	//Check if the entity hasn't been seen the last 600 seconds, and if so removes it.
-	if (m_checkIterator == m_entities.end()) {
-		m_checkIterator = m_entities.begin();
+void MemMap::markAsSeen(long id) {
+	auto I = m_recentlySeenIndex.find(id);
+	if (I != m_recentlySeenIndex.end()) {
+		m_recentlySeen.splice(m_recentlySeen.begin(), m_recentlySeen, I->second);
 	} else {
-		auto me = m_checkIterator->second;
-		assert(me);
-		if (me->getType() && (time - me->lastSeen()) > std::chrono::seconds(600) &&
-			(!me->m_contains.empty())) {
-			m_checkIterator = m_entities.erase(m_checkIterator);
+		m_recentlySeen.push_front(id);
+		m_recentlySeenIndex.emplace(id, m_recentlySeen.begin());
+	}
+}
+
+void MemMap::removeFromRecentlySeen(long id) {
+	auto I = m_recentlySeenIndex.find(id);
+	if (I != m_recentlySeenIndex.end()) {
+		m_recentlySeen.erase(I->second);
+		m_recentlySeenIndex.erase(I);
+	}
+}
+
+bool MemMap::isForgettable(const MemEntity& entity) const {
+	//Entities without types are still waiting for data from the server.
+	if (!entity.getType()) {
+		return false;
+	}
+	//Forgetting an entity with children would leave them without a parent.
+	if (!entity.m_contains.empty()) {
+		return false;
+	}
+	if (m_entityRelatedMemory.find(entity.getIdAsString()) != m_entityRelatedMemory.end()) {
+		return false;
+	}
+	if (m_listener && m_listener->isEntityPinned(entity)) {
+		return false;
+	}
+	if (MemEntity::isReferencedByScript && MemEntity::isReferencedByScript(entity)) {
+		return false;
+	}
+	return true;
+}
+
+MemMap::MemEntityDict::iterator MemMap::forget(MemEntityDict::iterator I) {
+	auto entity = I->second;
+	cy_debug_print("MemMap::forget " << entity->describeEntity())
+	auto isCheckIterator = m_checkIterator == I;
+	auto next = m_entities.erase(I);
+	if (isCheckIterator) {
+		m_checkIterator = next;
+	}
+	removeFromRecentlySeen(entity->getIdAsInt());
 
-			if (me->m_parent) {
-				me->m_parent->removeChild(*me);
-				me->m_parent = nullptr;
+	if (entity->m_parent) {
+		entity->m_parent->removeChild(*entity);
+		entity->m_parent = nullptr;
+	}
+	if (m_listener) {
+		m_listener->entityForgotten(*entity);
+	}
+	//The cached script wrapper refers back to the entity, so it would never be deleted otherwise.
+	entity->m_scriptEntity.reset();
+	m_forgottenCount++;
+	return next;
+}
+
+void MemMap::enforceLimits() {
+	if (m_limits.maxEntities == 0 || m_entities.size() <= m_limits.maxEntities) {
+		return;
+	}
+	auto excess = m_entities.size() - m_limits.maxEntities;
+	//Start with the least recently seen entities. Since many of them might not be forgettable only a limited number is examined each time.
+	auto I = m_recentlySeen.end();
+	for (size_t examined = 0; excess > 0 && I != m_recentlySeen.begin() && examined < maxEntitiesExaminedForLimits; ++examined) {
+		auto candidate = std::prev(I);
+		auto J = m_entities.find(*candidate);
+		if (J == m_entities.end()) {
+			removeFromRecentlySeen(*candidate);
+		} else if (isForgettable(*J->second)) {
+			forget(J);
+			excess--;
+		} else {
+			if (candidate == m_recentlySeen.begin()) {
+				break;
 			}
+			//Move it to the front, so that it isn't examined again until all others have been.
+			m_recentlySeen.splice(m_recentlySeen.begin(), m_recentlySeen, candidate);
+		}
+	}
+}
 
+void MemMap::check(std::chrono::milliseconds time) {
+	//Forget any entities which haven't been seen for a while.
+	auto count = std::min(entitiesCheckedPerCall, m_entities.size());
+	for (size_t i = 0; i < count && !m_entities.empty(); ++i) {
+		if (m_checkIterator == m_entities.end()) {
+			m_checkIterator = m_entities.begin();
+		}
+		auto& me = m_checkIterator->second;
+		assert(me);
+		if ((time - me->lastSeen()) > m_limits.forgetAfter && isForgettable(*me)) {
+			forget(m_checkIterator);
 		} else {
 			cy_debug_print(me->describeEntity() << "|"
 												<< me->lastSeen().count()
@@ -467,6 +650,7 @@ void MemMap::check(std::chrono::milliseconds time) {
 			++m_checkIterator;
 		}
 	}
+	enforceLimits();
 }
 
 void MemMap::flush() {
@@ -474,6 +658,8 @@ void MemMap::flush() {
 										   << " entities and " << m_entityRelatedMemory.size() << " entity memories.")
 	m_entities.clear();
 	m_checkIterator = m_entities.begin();
+	m_recentlySeen.clear();
+	m_recentlySeenIndex.clear();
 	m_entityRelatedMemory.clear();
 }
 
@@ -36,6 +36,7 @@
 #include <map>
 #include <string>
 #include <optional>
+#include <unordered_map>
 
 
 template<typename>
@@ -59,6 +60,36 @@ public:
 		virtual void entityUpdated(MemEntity& entity, const Atlas::Objects::Entity::RootEntity& ent, MemEntity* oldLocation) = 0;
 
 		virtual void entityDeleted(MemEntity& entity) = 0;
+
+		/**
+		 * @brief Called when an entity is forgotten, as opposed to being deleted from the world.
+		 */
+		virtual void entityForgotten(MemEntity& entity) = 0;
+
+		/**
+		 * @brief Checks if the entity must never be forgotten, such as the entity of the mind itself.
+		 */
+		virtual bool isEntityPinned(const MemEntity& entity) const = 0;
+	};
+
+	/**
+	 * @brief Limits on how much a mind remembers.
+	 */
+	struct Limits {
+		/**
+		 * The max number of entities to remember, or zero for no limit.
+		 * If exceeded the entities which were least recently seen are forgotten first.
+		 */
+		size_t maxEntities = 0;
+		/**
+		 * Entities which haven't been seen for this long are forgotten.
+		 */
+		std::chrono::milliseconds forgetAfter = std::chrono::seconds(600);
+		/**
+		 * The max number of entities which have disappeared from view to remember the last known version of, so that
+		 * if they appear again only what's changed since needs to be sent.
+		 */
+		size_t maxDisappearedEntities = 256;
 	};
 
 protected:
@@ -87,6 +118,57 @@ protected:
 
 	std::unique_ptr<PropertyManager<MemEntity>> m_propertyManager;
 
+	Limits m_limits;
+
+	/**
+	 * Ids of entities, with the most recently seen first.
+	 */
+	std::list<long> m_recentlySeen;
+	std::unordered_map<long, std::list<long>::iterator> m_recentlySeenIndex;
+
+	size_t m_forgottenCount;
+
+	/**
+	 * @brief The last known version of an entity which has disappeared from view.
+	 */
+	struct DisappearedEntity {
+		Atlas::Message::MapType properties;
+		int seq;
+		std::list<long>::iterator orderIterator;
+	};
+
+	std::unordered_map<long, DisappearedEntity> m_disappearedEntities;
+
+	/**
+	 * Ids of entities in m_disappearedEntities, with the most recently disappeared first.
+	 */
+	std::list<long> m_disappearedOrder;
+
+	void forgetDisappeared(long id);
+
+	void markAsSeen(long id);
+
+	void removeFromRecentlySeen(long id);
+
+	/**
+	 * @brief Checks if the entity can be forgotten.
+	 *
+	 * Entities which have children, which have any related memories, which are pinned by the listener, or which are referenced by scripts
+	 * are never forgotten.
+	 */
+	bool isForgettable(const MemEntity& entity) const;
+
+	/**
+	 * @brief Removes an entity from memory, without destroying it.
+	 * @return An iterator to the entity after the forgotten one.
+	 */
+	MemEntityDict::iterator forget(MemEntityDict::iterator I);
+
+	/**
+	 * @brief Forgets the least recently seen entities if there are more than allowed.
+	 */
+	void enforceLimits();
+
 	void readEntity(const Ref<MemEntity>&,
 					const Atlas::Objects::Entity::RootEntity&,
 					std::chrono::milliseconds timestamp,
@@ -130,8 +212,27 @@ public:
 
 	void sendLook(OpVector&);
 
+	/**
+	 * @brief Checks if there are any entities queued up to be looked at by sendLook().
+	 */
+	bool hasPendingLooks() const {
+		return !m_additionsById.empty();
+	}
+
 	Ref<MemEntity> del(const std::string& id);
 
+	/**
+	 * @brief Removes an entity which has disappeared from view, but remembers the version we knew about.
+	 *
+	 * If it appears again we only need to ask for what's changed since, see getDisappearedSeq().
+	 */
+	Ref<MemEntity> disappear(const std::string& id);
+
+	/**
+	 * @brief Gets the sequence number of the version we knew about of an entity which has disappeared, if any.
+	 */
+	std::optional<int> getDisappearedSeq(const std::string& id) const;
+
 	Ref<MemEntity> get(const std::string& id) const;
 
 	Ref<MemEntity> getAdd(const std::string& id);
@@ -166,16 +267,39 @@ public:
 								WFMath::CoordType radius,
 								const std::string& what) const;
 
+	/**
+	 * @brief Examines some of the entities, forgetting the ones which haven't been seen in a while, as well as
+	 * any exceeding the limits.
+	 */
 	void check(std::chrono::milliseconds t);
 
 	void flush();
 
 	void setListener(MapListener* listener);
 
+	void setLimits(const Limits& limits) {
+		m_limits = limits;
+	}
+
+	const Limits& getLimits() const {
+		return m_limits;
+	}
+
+	/**
+	 * @brief Gets the number of entities which have been forgotten, either because they were stale or because of the limits.
+	 */
+	size_t getForgottenCount() const {
+		return m_forgottenCount;
+	}
+
 	std::deque<Operation>& getTypeResolverOps() {
 		return m_typeResolverOps;
 	}
 
+	const std::deque<Operation>& getTypeResolverOps() const {
+		return m_typeResolverOps;
+	}
+
 	const TypeStore<MemEntity>& getTypeStore() const;
 
 	friend class BaseMindMapEntityintegration;
@@ -179,6 +179,11 @@ void CyPy_MemEntity::init_type() {
 
 	behaviors().readyType();
 
+	MemEntity::isReferencedByScript = [](const MemEntity& entity) {
+		//The entity itself holds one reference to its cached wrapper; any more means that some script refers to it.
+		auto wrapper = std::any_cast<Py::Object>(&entity.m_scriptEntity);
+		return wrapper && !wrapper->isNone() && wrapper->reference_count() > 1;
+	};
 }
 
 CyPy_MemEntity::CyPy_MemEntity(Py::PythonClassInstance* self, Ref<MemEntity> value)
@@ -73,13 +73,7 @@ Ref<LocatedEntity> BaseWorld::getEntity(const std::string& id) const {
 /// @param id integer ID of Entity to be retrieved.
 /// @return pointer to Entity retrieved, or zero if it was not found.
 Ref<LocatedEntity> BaseWorld::getEntity(long id) const {
-	auto I = m_eobjects.find(id);
-	if (I != m_eobjects.end()) {
-		assert(I->second);
-		return I->second;
-	} else {
-		return nullptr;
-	}
+	return {m_eobjects.get(id)};
 }
 
 void BaseWorld::registerAlias(std::string alias, LocatedEntity& entity) {
@@ -24,6 +24,7 @@
 #include "modules/Ref.h"
 
 #include "rules/simulation/LocatedEntity.h"
+#include "rules/simulation/EntityRegistry.h"
 
 #include <Atlas/Objects/ObjectsFwd.h>
 
@@ -36,7 +37,7 @@
 template<typename EntityT>
 class Location;
 
-typedef std::map<long, Ref<LocatedEntity>> EntityRefDict;
+typedef EntityRegistry EntityRefDict;
 
 /// \brief Base class for game world manager object.
 ///
@@ -56,7 +57,8 @@ protected:
 	/// \brief Dictionary of all the objects in the world.
 	///
 	/// Pointers to all in-game entities in the world are stored keyed to
-	/// their integer ID.
+	/// their integer ID. Lookups are constant time, and the entities are
+	/// stored densely so that iterating over them is cheap.
 	EntityRefDict m_eobjects;
 
 	/// \brief Whether the base world is suspended or not.
@@ -150,6 +152,11 @@ public:
 
 	/// \brief Signal that an operation is being dispatched.
 	sigc::signal<void(Atlas::Objects::Operation::RootOperation)> Dispatching;
+
+	/// \brief Signal that an operation has been dispatched, along with how long that took.
+	///
+	/// Only emitted when anything is connected, since measuring the time has a cost.
+	sigc::signal<void(const Atlas::Objects::Operation::RootOperation&, std::chrono::steady_clock::duration)> Dispatched;
 };
 
 #endif // RULESETS_BASE_WORLD_H
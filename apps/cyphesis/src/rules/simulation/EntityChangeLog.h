@@ -0,0 +1,142 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software Foundation,
+ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CYPHESIS_ENTITYCHANGELOG_H
+#define CYPHESIS_ENTITYCHANGELOG_H
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+
+/**
+ * @brief Keeps track of the sequence number at which each property of an entity last changed.
+ *
+ * This allows observers which already know about an earlier version of the entity to be sent only those
+ * properties which have changed since, along with the names of those which have been removed, instead of
+ * the whole entity.
+ *
+ * The number of properties tracked is bounded. When the bound is exceeded the property which changed the
+ * longest time ago is forgotten, and observers which only know about versions older than that will need
+ * to be sent the whole entity.
+ */
+class EntityChangeLog {
+public:
+	explicit EntityChangeLog(std::size_t maxEntries = 32)
+			: m_maxEntries(maxEntries),
+			  m_earliestSeq(0) {
+	}
+
+	/**
+	 * @brief The properties which have changed since a sequence number.
+	 */
+	struct Changes {
+		/**
+		 * Properties which have been changed or added.
+		 */
+		std::set<std::string> changed;
+		/**
+		 * Properties which have been removed.
+		 */
+		std::set<std::string> removed;
+	};
+
+	/**
+	 * @brief Records that a property changed with the sequence number.
+	 */
+	void record(int seq, const std::string& propertyName) {
+		m_removed.erase(propertyName);
+		auto I = m_lastChanged.find(propertyName);
+		if (I != m_lastChanged.end()) {
+			I->second = seq;
+			return;
+		}
+		m_lastChanged.emplace(propertyName, seq);
+		if (m_lastChanged.size() > m_maxEntries) {
+			auto oldest = std::min_element(m_lastChanged.begin(), m_lastChanged.end(),
+										   [](const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; });
+			m_earliestSeq = std::max(m_earliestSeq, oldest->second);
+			m_removed.erase(oldest->first);
+			m_lastChanged.erase(oldest);
+		}
+	}
+
+	/**
+	 * @brief Records that a property was removed with the sequence number.
+	 */
+	void recordRemoval(int seq, const std::string& propertyName) {
+		record(seq, propertyName);
+		m_removed.insert(propertyName);
+	}
+
+	/**
+	 * @brief Forgets all changes, so that only observers which know about the sequence number, or a later one, can be sent changes.
+	 *
+	 * Use this when something has changed which can't be expressed as changed or removed properties.
+	 */
+	void reset(int seq) {
+		m_lastChanged.clear();
+		m_removed.clear();
+		m_earliestSeq = seq;
+	}
+
+	/**
+	 * @brief Gets the names of the properties which have changed since the sequence number.
+	 * @param seq The sequence number the observer knows about.
+	 * @param currentSeq The current sequence number of the entity.
+	 * @return The names of the changed and removed properties, or nothing if the log can't tell what's changed, in which case the whole entity should be sent.
+	 */
+	std::optional<Changes> changedSince(int seq, int currentSeq) const {
+		if (seq < m_earliestSeq || seq > currentSeq) {
+			return std::nullopt;
+		}
+		Changes changes;
+		for (auto& entry: m_lastChanged) {
+			if (entry.second > seq) {
+				if (m_removed.contains(entry.first)) {
+					changes.removed.insert(entry.first);
+				} else {
+					changes.changed.insert(entry.first);
+				}
+			}
+		}
+		return changes;
+	}
+
+private:
+	std::size_t m_maxEntries;
+
+	/**
+	 * @brief The earliest sequence number for which all later changes are known.
+	 */
+	int m_earliestSeq;
+
+	/**
+	 * @brief The sequence number at which each property last changed.
+	 */
+	std::map<std::string, int> m_lastChanged;
+
+	/**
+	 * @brief The properties in m_lastChanged whose last change was a removal.
+	 */
+	std::set<std::string> m_removed;
+};
+
+#endif //CYPHESIS_ENTITYCHANGELOG_H
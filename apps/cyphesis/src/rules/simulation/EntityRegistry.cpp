@@ -0,0 +1,128 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software Foundation,
+ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "EntityRegistry.h"
+#include "LocatedEntity.h"
+
+#include <cassert>
+
+EntityHandle EntityRegistry::insert(long id, Ref<LocatedEntity> entity) {
+	auto I = m_slotsById.find(id);
+	if (I != m_slotsById.end()) {
+		auto& slot = m_slots[I->second];
+		m_entries[slot.entryIndex].second = std::move(entity);
+		return {I->second, slot.generation};
+	}
+
+	std::uint32_t slotIndex;
+	if (!m_freeSlots.empty()) {
+		slotIndex = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	} else {
+		slotIndex = static_cast<std::uint32_t>(m_slots.size());
+		m_slots.push_back({0, 0});
+	}
+	auto& slot = m_slots[slotIndex];
+	slot.entryIndex = static_cast<std::uint32_t>(m_entries.size());
+	m_entries.emplace_back(id, std::move(entity));
+	m_entrySlots.push_back(slotIndex);
+	m_slotsById.emplace(id, slotIndex);
+	return {slotIndex, slot.generation};
+}
+
+bool EntityRegistry::erase(long id) {
+	auto I = m_slotsById.find(id);
+	if (I == m_slotsById.end()) {
+		return false;
+	}
+	auto slotIndex = I->second;
+	m_slotsById.erase(I);
+	auto& slot = m_slots[slotIndex];
+	auto entryIndex = slot.entryIndex;
+
+	//Keep the entries dense by moving the last one into the place of the removed one.
+	auto lastIndex = static_cast<std::uint32_t>(m_entries.size() - 1);
+	if (entryIndex != lastIndex) {
+		m_entries[entryIndex] = std::move(m_entries[lastIndex]);
+		m_entrySlots[entryIndex] = m_entrySlots[lastIndex];
+		m_slots[m_entrySlots[entryIndex]].entryIndex = entryIndex;
+	}
+	m_entries.pop_back();
+	m_entrySlots.pop_back();
+
+	slot.generation++;
+	m_freeSlots.push_back(slotIndex);
+	return true;
+}
+
+void EntityRegistry::clear() {
+	m_entries.clear();
+	m_entrySlots.clear();
+	m_slotsById.clear();
+	m_freeSlots.clear();
+	//Keep the slots, with their generations increased, so that any outstanding handles won't resolve.
+	for (std::uint32_t i = 0; i < m_slots.size(); ++i) {
+		m_slots[i].generation++;
+		m_freeSlots.push_back(i);
+	}
+}
+
+EntityRegistry::const_iterator EntityRegistry::find(long id) const {
+	auto I = m_slotsById.find(id);
+	if (I == m_slotsById.end()) {
+		return m_entries.end();
+	}
+	return m_entries.begin() + m_slots[I->second].entryIndex;
+}
+
+LocatedEntity* EntityRegistry::get(long id) const {
+	auto I = m_slotsById.find(id);
+	if (I == m_slotsById.end()) {
+		return nullptr;
+	}
+	return m_entries[m_slots[I->second].entryIndex].second.get();
+}
+
+LocatedEntity* EntityRegistry::get(EntityHandle handle) const {
+	if (handle.index >= m_slots.size()) {
+		return nullptr;
+	}
+	auto& slot = m_slots[handle.index];
+	if (slot.generation != handle.generation) {
+		return nullptr;
+	}
+	assert(slot.entryIndex < m_entries.size());
+	return m_entries[slot.entryIndex].second.get();
+}
+
+EntityHandle EntityRegistry::getHandle(long id) const {
+	auto I = m_slotsById.find(id);
+	if (I == m_slotsById.end()) {
+		return {};
+	}
+	return {I->second, m_slots[I->second].generation};
+}
+
+std::vector<Ref<LocatedEntity>> EntityRegistry::snapshot() const {
+	std::vector<Ref<LocatedEntity>> entities;
+	entities.reserve(m_entries.size());
+	for (auto& entry: m_entries) {
+		entities.emplace_back(entry.second);
+	}
+	return entities;
+}
@@ -0,0 +1,147 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software Foundation,
+ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef CYPHESIS_ENTITYREGISTRY_H
+#define CYPHESIS_ENTITYREGISTRY_H
+
+#include "modules/Ref.h"
+
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class LocatedEntity;
+
+/**
+ * @brief A handle to an entity in an EntityRegistry.
+ *
+ * Resolving a handle is a plain array lookup. A handle to an entity which has been removed won't
+ * resolve, even if the slot it referred to has since been reused.
+ */
+struct EntityHandle {
+	static constexpr std::uint32_t invalidIndex = std::numeric_limits<std::uint32_t>::max();
+
+	std::uint32_t index = invalidIndex;
+	std::uint32_t generation = 0;
+
+	bool isValid() const {
+		return index != invalidIndex;
+	}
+};
+
+/**
+ * @brief Keeps all entities in the world, keyed by their integer id.
+ *
+ * The entities are stored densely, so that iterating over them is cheap. Entities are found
+ * through a hash of their ids, or through handles.
+ *
+ * The iteration order is undefined. Adding or removing entities invalidates all iterators; use
+ * snapshot() if entities might be added or removed while iterating.
+ */
+class EntityRegistry {
+public:
+	typedef std::pair<long, Ref<LocatedEntity>> value_type;
+	typedef std::vector<value_type>::const_iterator const_iterator;
+
+	/**
+	 * @brief Adds an entity, replacing any entity with the same id.
+	 * @return A handle to the entity.
+	 */
+	EntityHandle insert(long id, Ref<LocatedEntity> entity);
+
+	/**
+	 * @brief Removes an entity.
+	 * @return True if there was an entity with the id.
+	 */
+	bool erase(long id);
+
+	void clear();
+
+	const_iterator find(long id) const;
+
+	/**
+	 * @brief Gets an entity by its id.
+	 * @return The entity, or null if there's no such entity.
+	 */
+	LocatedEntity* get(long id) const;
+
+	/**
+	 * @brief Gets an entity by a handle.
+	 * @return The entity, or null if the entity has been removed.
+	 */
+	LocatedEntity* get(EntityHandle handle) const;
+
+	/**
+	 * @brief Gets a handle to an entity.
+	 * @return A handle, which is invalid if there's no such entity.
+	 */
+	EntityHandle getHandle(long id) const;
+
+	/**
+	 * @brief Gets references to all entities, which can be iterated over even if entities are added or removed meanwhile.
+	 */
+	std::vector<Ref<LocatedEntity>> snapshot() const;
+
+	const_iterator begin() const {
+		return m_entries.begin();
+	}
+
+	const_iterator end() const {
+		return m_entries.end();
+	}
+
+	size_t size() const {
+		return m_entries.size();
+	}
+
+	bool empty() const {
+		return m_entries.empty();
+	}
+
+private:
+	struct Slot {
+		/**
+		 * The index into m_entries, if the slot is in use.
+		 */
+		std::uint32_t entryIndex;
+		/**
+		 * Increased each time the slot is freed, so that old handles won't resolve.
+		 */
+		std::uint32_t generation;
+	};
+
+	/**
+	 * The entities, stored densely.
+	 */
+	std::vector<value_type> m_entries;
+
+	/**
+	 * The slot for each entry in m_entries.
+	 */
+	std::vector<std::uint32_t> m_entrySlots;
+
+	std::vector<Slot> m_slots;
+
+	std::vector<std::uint32_t> m_freeSlots;
+
+	std::unordered_map<long, std::uint32_t> m_slotsById;
+};
+
+#endif //CYPHESIS_ENTITYREGISTRY_H
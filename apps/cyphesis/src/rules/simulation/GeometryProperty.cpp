@@ -16,7 +16,7 @@
 // Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 
 #include "GeometryProperty.h"
-#include "OgreMeshDeserializer.h"
+#include "MeshShapeCache.h"
 #include "rules/BBoxProperty_impl.h"
 #include "physics/Convert.h"
 #include "common/log.h"
@@ -56,7 +56,7 @@ auto createBoxFn = [](const WFMath::AxisBox<3>& bbox,
 void GeometryProperty::set(const Element& data) {
 	Property::set(data);
 
-	std::shared_ptr<OgreMeshDeserializer> deserializer;
+	std::shared_ptr<MeshShape> mesh;
 	AtlasQuery::find<std::string>(data, "path", [&](const std::string& path) {
 		try {
 			if (boost::algorithm::ends_with(path, ".mesh")) {
@@ -64,11 +64,9 @@ void GeometryProperty::set(const Element& data) {
 				AssetsManager::instance().observeFile(std::filesystem::path{fullpath}, [this, fullpath](const std::filesystem::path&) {
 
 					spdlog::debug("Reloading geometry from {}.", fullpath.string());
-					if (std::ifstream fileStream(std::filesystem::path{fullpath}); fileStream) {
-						const auto innerDeserializer = std::make_shared<OgreMeshDeserializer>(fileStream);
-						innerDeserializer->deserialize();
-						m_meshBounds = innerDeserializer->m_bounds;
-						parseData(innerDeserializer);
+					if (auto innerMesh = loadMesh(fullpath)) {
+						m_meshBounds = innerMesh->bounds();
+						parseData(innerMesh);
 
 
 						struct : boost::static_visitor<> {
@@ -90,10 +88,9 @@ void GeometryProperty::set(const Element& data) {
 				});
 
 
-				if (std::ifstream fileStream(std::filesystem::path{fullpath}); fileStream) {
-					deserializer = std::make_shared<OgreMeshDeserializer>(fileStream);
-					deserializer->deserialize();
-					m_meshBounds = deserializer->m_bounds;
+				mesh = loadMesh(fullpath);
+				if (mesh) {
+					m_meshBounds = mesh->bounds();
 				} else {
 					spdlog::error("Could not find geometry file at " + fullpath.string());
 				}
@@ -105,10 +102,20 @@ void GeometryProperty::set(const Element& data) {
 		}
 	});
 
-	parseData(deserializer);
+	parseData(mesh);
 }
 
-void GeometryProperty::parseData(const std::shared_ptr<OgreMeshDeserializer>& deserializer) {
+std::shared_ptr<MeshShape> GeometryProperty::loadMesh(const std::filesystem::path& path) const {
+	if (MeshShapeCache::hasInstance()) {
+		//Only build the BVH when it's going to be used.
+		auto I = m_data.find("type");
+		bool needsBvh = I != m_data.end() && I->second.isString() && I->second.String() == "mesh";
+		return MeshShapeCache::instance().get(path, needsBvh);
+	}
+	return MeshShape::readMeshFile(path);
+}
+
+void GeometryProperty::parseData(const std::shared_ptr<MeshShape>& mesh) {
 
 	auto sphereCreator = [](float radius,
 							const WFMath::AxisBox<3>& bbox,
@@ -295,7 +302,7 @@ void GeometryProperty::parseData(const std::shared_ptr<OgreMeshDeserializer>& de
 						return shape;
 					};
 		} else if (shapeType == "mesh") {
-			buildMeshCreator(deserializer);
+			buildMeshCreator(mesh);
 		} else if (shapeType == "compound") {
 			buildCompoundCreator();
 		}
@@ -316,12 +323,10 @@ std::shared_ptr<btCollisionShape> GeometryProperty::createShape(const WFMath::Ax
 }
 
 
-void GeometryProperty::buildMeshCreator(const std::shared_ptr<OgreMeshDeserializer>& meshDeserializer) {
-	//Shared pointers since we want these values to survive as long as "meshShape" is alive.
-	auto verts = std::make_shared<std::vector<btScalar>>();
-	auto indices = std::make_shared<std::vector<unsigned int>>();
-
-	if (!meshDeserializer) {
+void GeometryProperty::buildMeshCreator(std::shared_ptr<MeshShape> mesh) {
+	if (!mesh) {
+		std::vector<btScalar> verts;
+		std::vector<unsigned int> indices;
 
 		auto vertsI = m_data.find("vertices");
 		if (vertsI != m_data.end() && vertsI->second.isList()) {
@@ -352,21 +357,19 @@ void GeometryProperty::buildMeshCreator(const std::shared_ptr<OgreMeshDeserializ
 
 				int numberOfVertices = static_cast<int>(vertsList.size() / 3);
 
-				auto& local_verts = *verts;
-				auto& local_indices = *indices;
-				local_verts.resize(vertsList.size());
+				verts.resize(vertsList.size());
 
 				for (size_t i = 0; i < vertsList.size(); i += 3) {
 					if (!vertsList[i].isFloat() || !vertsList[i + 1].isFloat() || !vertsList[i + 2].isFloat()) {
 						spdlog::error("Vertex data was not a float for mesh.");
 						return;
 					}
-					local_verts[i] = (float)vertsList[i].Float();
-					local_verts[i + 1] = (float)vertsList[i + 1].Float();
-					local_verts[i + 2] = (float)vertsList[i + 2].Float();
+					verts[i] = (float)vertsList[i].Float();
+					verts[i + 1] = (float)vertsList[i + 1].Float();
+					verts[i + 2] = (float)vertsList[i + 2].Float();
 				}
 
-				local_indices.resize(trisList.size());
+				indices.resize(trisList.size());
 				for (size_t i = 0; i < trisList.size(); i += 3) {
 					if (!trisList[i].isInt() || !trisList[i + 1].isInt() || !trisList[i + 2].isInt()) {
 						spdlog::error("Index data was not an int for mesh.");
@@ -376,9 +379,9 @@ void GeometryProperty::buildMeshCreator(const std::shared_ptr<OgreMeshDeserializ
 						spdlog::error("Index data was out of bounds for vertices for mesh.");
 						return;
 					}
-					local_indices[i] = (unsigned int)trisList[i].Int();
-					local_indices[i + 1] = (unsigned int)trisList[i + 1].Int();
-					local_indices[i + 2] = (unsigned int)trisList[i + 2].Int();
+					indices[i] = (unsigned int)trisList[i].Int();
+					indices[i + 1] = (unsigned int)trisList[i + 1].Int();
+					indices[i + 2] = (unsigned int)trisList[i + 2].Int();
 				}
 
 
@@ -388,60 +391,23 @@ void GeometryProperty::buildMeshCreator(const std::shared_ptr<OgreMeshDeserializ
 		} else {
 			spdlog::error("Could not find list of vertices for mesh.");
 		}
-	} else {
-		*indices = std::move(meshDeserializer->m_indices);
-		*verts = std::move(meshDeserializer->m_vertices);
-	}
 
-
-	if (indices->empty() || verts->empty()) {
-		spdlog::error("Vertices or indices were empty.");
-		return;
-	}
-
-	for (auto index: *indices) {
-		if (index >= verts->size() / 3) {
-			spdlog::error("Index out of bounds.");
+		mesh = MeshShape::create(std::move(verts), std::move(indices), {});
+		if (!mesh) {
 			return;
 		}
 	}
 
-	int vertStride = sizeof(btScalar) * 3;
-	int indexStride = sizeof(unsigned int) * 3;
-
-	int indicesCount = static_cast<int>(indices->size() / 3);
-	int vertexCount = static_cast<int>(verts->size() / 3);
-
-	//Make sure to capture "verts" and "indices" so that they are kept around.
-	std::shared_ptr<btTriangleIndexVertexArray> triangleVertexArray(new btTriangleIndexVertexArray(indicesCount,
-			reinterpret_cast<int*>(indices->data()),
-			indexStride,
-			vertexCount,
-			verts->data(),
-			vertStride),
-			//Important that we keep references to "verts" and "indices" so they outlive the mesh.
-		[verts, indices](btTriangleIndexVertexArray* p) {
-			delete p;
-		});
-
-	btVector3 aabbMin, aabbMax;
-	triangleVertexArray->calculateAabbBruteForce(aabbMin, aabbMax);
-	triangleVertexArray->setPremadeAabb(aabbMin, aabbMax);
-
-	std::shared_ptr<btBvhTriangleMeshShape> meshShape(new btBvhTriangleMeshShape(triangleVertexArray.get(), true, true),
-			//Important that we keep references to "triangleVertexArray" so it outlives the mesh.
-		[triangleVertexArray](btBvhTriangleMeshShape* p) {
-			delete p;
-		});
-	meshShape->setLocalScaling(btVector3(1, 1, 1));
+	//The BVH shape is shared by all shapes created from the mesh, which might be used by multiple types too.
+	auto meshShape = mesh->bvhShape();
 	//Store the bounds, so that the "bbox" property can be updated when this is applied to a TypeNode
 	m_meshBounds = WFMath::AxisBox<3>(Convert::toWF<WFMath::Point<3>>(meshShape->getLocalAabbMin()),
 		Convert::toWF<WFMath::Point<3>>(meshShape->getLocalAabbMax()));
 
-	mShapeCreator = [meshShape, triangleVertexArray](const WFMath::AxisBox<3>& bbox,
-													 const WFMath::Vector<3>& size,
-													 btVector3& centerOfMassOffset,
-													 float mass) -> std::shared_ptr<btCollisionShape> {
+	mShapeCreator = [mesh, meshShape](const WFMath::AxisBox<3>& bbox,
+									   const WFMath::Vector<3>& size,
+									   btVector3& centerOfMassOffset,
+									   float mass) -> std::shared_ptr<btCollisionShape> {
 		//In contrast to other shapes there's no centerOfMassOffset for mesh shapes
 		centerOfMassOffset = btVector3(0, 0, 0);
 		btVector3 meshSize = meshShape->getLocalAabbMax() - meshShape->getLocalAabbMin();
@@ -449,14 +415,20 @@ void GeometryProperty::buildMeshCreator(const std::shared_ptr<OgreMeshDeserializ
 
 		//Due to performance reasons we should use different shapes depending on whether it's static (i.e. mass == 0) or not
 		if (mass == 0) {
-			//Hold on to meshShape as long as the scaled mesh exists.
-			return std::shared_ptr<btScaledBvhTriangleMeshShape>(new btScaledBvhTriangleMeshShape(meshShape.get(), scaling),
-				[meshShape](btScaledBvhTriangleMeshShape* p) {
+			//Hold on to the mesh as long as the scaled mesh exists.
+			return std::shared_ptr<btScaledBvhTriangleMeshShape>(new btScaledBvhTriangleMeshShape(meshShape, scaling),
+				[mesh](btScaledBvhTriangleMeshShape* p) {
 					delete p;
 				});
 		} else {
 
-			auto shape = std::make_shared<btConvexTriangleMeshShape>(triangleVertexArray.get(), true);
+			//Scaling a convex mesh shape scales its interface, so each shape needs its own over the shared mesh data.
+			auto* triangleVertexArray = mesh->createTriangleVertexArray().release();
+			std::shared_ptr<btConvexTriangleMeshShape> shape(new btConvexTriangleMeshShape(triangleVertexArray, true),
+				[mesh, triangleVertexArray](btConvexTriangleMeshShape* p) {
+					delete p;
+					delete triangleVertexArray;
+				});
 			/**
 						auto shape = new btConvexHullShape(verts.get()->data(), verts.get()->size() / 3, sizeof(float) * 3);
 
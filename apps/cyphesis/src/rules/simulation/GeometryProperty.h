@@ -23,6 +23,7 @@
 #include <wfmath/axisbox.h>
 #include <wfmath/vector.h>
 #include <bullet/LinearMath/btVector3.h>
+#include <filesystem>
 #include <functional>
 #include <boost/variant.hpp>
 
@@ -30,7 +31,7 @@ class btCollisionShape;
 
 class btVector3;
 
-class OgreMeshDeserializer;
+class MeshShape;
 
 /**
  * @brief Specifies geometry of an entity.
@@ -130,13 +131,18 @@ protected:
 													btVector3& centerOfMassOffset,
 													float mass)> mShapeCreator;
 
-	void buildMeshCreator(const std::shared_ptr<OgreMeshDeserializer>& meshDeserializer);
+	void buildMeshCreator(std::shared_ptr<MeshShape> mesh);
 
 	void buildCompoundCreator();
 
 	ScalerType parseScalerType();
 
-	void parseData(const std::shared_ptr<OgreMeshDeserializer>& deserializer);
+	void parseData(const std::shared_ptr<MeshShape>& mesh);
+
+	/**
+	 * Loads the mesh at the path, going through the MeshShapeCache if there is one.
+	 */
+	std::shared_ptr<MeshShape> loadMesh(const std::filesystem::path& path) const;
 
 };
 
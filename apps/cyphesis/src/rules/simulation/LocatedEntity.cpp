@@ -31,11 +31,11 @@
 #include <Atlas/Objects/Anonymous.h>
 #include <wfmath/atlasconv.h>
 
+#include <array>
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <common/Link.h>
-#include <common/Monitors.h>
-#include "common/Variable.h"
 #include <common/operations/Thought.h>
 #include <rules/PhysicalProperties.h>
 #include "common/SynchedState_impl.h"
@@ -74,7 +74,12 @@ using Atlas::Objects::smart_dynamic_cast;
 /// normal means.
 std::set<std::string> LocatedEntity::s_immutable = {"id", "parent", "loc", "contains", "objtype"};
 
-SynchedState<std::map<const TypeNode<LocatedEntity>*, int>> LocatedEntity::s_monitorsMap;
+SynchedState<std::map<const TypeNode<LocatedEntity>*, Metrics::Gauge*>> LocatedEntity::s_monitorsMap;
+
+namespace {
+/// The properties which are sent to observers when an entity is moved.
+const std::array<std::string, 6> transformPropertyNames = {"pos", "velocity", "angular", "orientation", "mode", "mode_data"};
+}
 
 static constexpr auto debug_flag = false;
 
@@ -108,7 +113,7 @@ LocatedEntity::~LocatedEntity() {
 		s_monitorsMap.withState([&](auto state) {
 			auto I = state->find(m_type);
 			if (I != state->end()) {
-				--I->second;
+				I->second->add(-1);
 			}
 		});
 	}
@@ -363,10 +368,14 @@ void LocatedEntity::updateProperties(const Operation& op, OpVector& res) {
 	bool hadProtectedChanges = false;
 	bool hadPrivateChanges = false;
 
+	//The sequence number the entity will have if anything has changed.
+	auto newSeq = m_seq + 1;
+
 	for (const auto& entry: m_properties) {
 		auto& prop = entry.second.property;
 		if (prop && prop->hasFlags(prop_flag_unsent)) {
 			cy_debug_print("UPDATE:  " << prop_flag_unsent << " " << entry.first)
+			m_changeLog.record(newSeq, entry.first);
 			if (prop->hasFlags(prop_flag_visibility_private)) {
 				prop->add(entry.first, set_arg_private);
 				hadPrivateChanges = true;
@@ -398,6 +407,7 @@ void LocatedEntity::updateProperties(const Operation& op, OpVector& res) {
 	if (hadPublicChanges) {
 
 		set_arg->setId(getIdAsString());
+		set_arg->setStamp(newSeq);
 
 		Set set;
 		set->setTo(getIdAsString());
@@ -412,6 +422,7 @@ void LocatedEntity::updateProperties(const Operation& op, OpVector& res) {
 
 	if (hadProtectedChanges) {
 		set_arg_protected->setId(getIdAsString());
+		set_arg_protected->setStamp(newSeq);
 
 		Set set;
 		set->setTo(getIdAsString());
@@ -426,6 +437,7 @@ void LocatedEntity::updateProperties(const Operation& op, OpVector& res) {
 
 	if (hadPrivateChanges) {
 		set_arg_private->setId(getIdAsString());
+		set_arg_private->setStamp(newSeq);
 
 		Set set;
 		set->setTo(getIdAsString());
@@ -440,7 +452,7 @@ void LocatedEntity::updateProperties(const Operation& op, OpVector& res) {
 
 	//Only change sequence number and call onUpdated if something actually changed.
 	if (hadChanges) {
-		m_seq++;
+		m_seq = newSeq;
 		if (!hasFlags(entity_clean)) {
 			onUpdated();
 		}
@@ -476,6 +488,19 @@ void LocatedEntity::generateSightOp(const LocatedEntity& observingEntity, const
 
 	Anonymous sarg;
 
+	//If the observer already knows about an earlier version of this entity it will tell us which, and we only need to
+	//send what's changed since. If the change log can't tell what's changed the whole entity is sent.
+	std::optional<EntityChangeLog::Changes> changedProperties;
+	if (!originalLookOp->getArgs().empty()) {
+		auto& lookArg = originalLookOp->getArgs().front();
+		if (lookArg->hasAttrFlag(Atlas::Objects::STAMP_FLAG) && lookArg->getId() == getIdAsString()) {
+			changedProperties = m_changeLog.changedSince((int) lookArg->getStamp(), m_seq);
+		}
+	}
+	auto isUnchanged = [&](const std::string& name) {
+		return changedProperties && !changedProperties->changed.contains(name);
+	};
+
 	//If there's a domain we should let it decide "contains, and in that case other code shouldn't send the property itself.
 	bool filterOutContainsProp = true;
 	if (m_contains != nullptr) {
@@ -503,6 +528,9 @@ void LocatedEntity::generateSightOp(const LocatedEntity& observingEntity, const
 			if (filterOutContainsProp && entry.first == "contains") {
 				continue;
 			}
+			if (isUnchanged(entry.first)) {
+				continue;
+			}
 			entry.second.property->add(entry.first, sarg);
 		}
 	} else if (observingEntity.getIdAsInt() == getIdAsInt()) {
@@ -512,6 +540,9 @@ void LocatedEntity::generateSightOp(const LocatedEntity& observingEntity, const
 				if (filterOutContainsProp && entry.first == "contains") {
 					continue;
 				}
+				if (isUnchanged(entry.first)) {
+					continue;
+				}
 				entry.second.property->add(entry.first, sarg);
 			}
 		}
@@ -522,11 +553,20 @@ void LocatedEntity::generateSightOp(const LocatedEntity& observingEntity, const
 				if (filterOutContainsProp && entry.first == "contains") {
 					continue;
 				}
+				if (isUnchanged(entry.first)) {
+					continue;
+				}
 				entry.second.property->add(entry.first, sarg);
 			}
 		}
 	}
 
+	//Observers can tell a reply with only the changes from one with the whole entity by this being present.
+	if (changedProperties) {
+		Atlas::Message::ListType removedList(changedProperties->removed.begin(), changedProperties->removed.end());
+		sarg->setAttr("removed_properties", std::move(removedList));
+	}
+
 	sarg->setStamp(m_seq);
 	if (m_type) {
 		sarg->setParent(m_type->name());
@@ -779,11 +819,19 @@ void LocatedEntity::moveOurselves(const Operation& op, const RootEntity& ent, Op
 	//    }
 
 
-	m_seq++;
+	increaseSequenceNumber();
+	m_changeLog.record(m_seq, "loc");
 
 	onUpdated();
 }
 
+void LocatedEntity::increaseSequenceNumber() {
+	m_seq++;
+	for (auto& name: transformPropertyNames) {
+		m_changeLog.record(m_seq, name);
+	}
+}
+
 
 void LocatedEntity::moveOtherEntity(const Operation& op, const RootEntity& ent, OpVector& res) const {
 	if (auto otherEntity = BaseWorld::instance().getEntity(ent->getId())) {
@@ -844,12 +892,9 @@ void LocatedEntity::setType(const TypeNode<LocatedEntity>* t) {
 		s_monitorsMap.withState([&](auto state) {
 			auto I = state->find(t);
 			if (I == state->end()) {
-				auto result = state->emplace(t, 1);
-
-				Monitors::instance().watch(fmt::format("entity_count{{type=\"{}\"}}", t->name()), std::make_unique<Variable<int>>(result.first->second));
-			} else {
-				++I->second;
+				I = state->emplace(t, &Metrics::instance().gauge("entity_count", "Number of existing entities, per type.", {{"type", t->name()}})).first;
 			}
+			I->second->add(1);
 		});
 	}
 }
@@ -1466,6 +1511,17 @@ PropertyBase* LocatedEntity::setProperty(const std::string& name,
 	return installedProp.property.get();
 }
 
+void LocatedEntity::removeProperty(const std::string& name) {
+	auto I = m_properties.find(name);
+	if (I == m_properties.end()) {
+		return;
+	}
+	I->second.property->remove(*this, name);
+	m_properties.erase(I);
+	m_seq++;
+	m_changeLog.recordRemoval(m_seq, name);
+}
+
 void LocatedEntity::sendWorld(OpVector& res) {
 	for (auto& op: res) {
 		sendWorld(std::move(op));
@@ -1614,6 +1670,8 @@ void LocatedEntity::addChild(LocatedEntity& childEntity) {
 	makeContainer();
 	bool was_empty = m_contains->empty();
 	m_contains->insert(&childEntity);
+	m_seq++;
+	m_changeLog.record(m_seq, ContainsProperty::property_name);
 	if (was_empty) {
 		onUpdated();
 	}
@@ -1634,6 +1692,8 @@ void LocatedEntity::removeChild(LocatedEntity& childEntity) {
 	}
 
 	m_contains->erase(&childEntity);
+	m_seq++;
+	m_changeLog.record(m_seq, ContainsProperty::property_name);
 	if (m_contains->empty()) {
 		onUpdated();
 	}
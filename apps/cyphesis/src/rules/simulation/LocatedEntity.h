@@ -27,11 +27,13 @@
 #include "modules/Flags.h"
 
 #include "PropertyBase.h"
+#include "EntityChangeLog.h"
 #include "common/Router.h"
 #include "common/log.h"
 #include "common/Visibility.h"
 #include "common/PropertyUtil.h"
 #include "common/SynchedState.h"
+#include "common/Metrics.h"
 
 #include <Atlas/Objects/Operation.h>
 
@@ -164,6 +166,11 @@ static constexpr std::uint32_t entity_visibility_private = 1u << 17u;
  */
 static constexpr std::uint32_t entity_update_broadcast_queued = 1u << 18u;
 
+/**
+ * The entity is a read-only mirror of an entity simulated by another server. It only accepts operations from itself.
+ */
+static constexpr std::uint32_t entity_proxy = 1u << 19u;
+
 struct EntityState {
 	/// Map of properties
 	std::map<std::string, ModifiableProperty> m_properties;
@@ -199,6 +206,9 @@ protected:
 	/// Sequence number
 	int m_seq;
 
+	/// Tracks which properties changed with which sequence number, so observers can be sent only what's changed.
+	EntityChangeLog m_changeLog;
+
 	/// Class of which this is an instance
 	const TypeNode<LocatedEntity>* m_type;
 
@@ -207,9 +217,9 @@ protected:
     std::multimap<int, std::string> m_delegates;
 
     /// A static map tracking the number of existing entities per type.
-    /// A monitor by the name of "entity_count{type=*}" will be created
+    /// A gauge by the name of "entity_count", labelled with the type, will be created
     /// per type.
-    static SynchedState<std::map<const TypeNode<LocatedEntity>*, int>> s_monitorsMap;
+    static SynchedState<std::map<const TypeNode<LocatedEntity>*, Metrics::Gauge*>> s_monitorsMap;
 
     std::unique_ptr<Domain> m_domain;
 
@@ -335,9 +345,14 @@ public:
 	/// \brief Accessor for sequence number
 	int getSeq() const { return m_seq; }
 
-	void increaseSequenceNumber() {
-		m_seq++;
-	}
+	/// \brief Increases the sequence number after the entity has been moved.
+	///
+	/// The properties describing the position and movement of the entity are
+	/// recorded as changed.
+	void increaseSequenceNumber();
+
+	/// \brief Accessor for the log of changed properties
+	const EntityChangeLog& getChangeLog() const { return m_changeLog; }
 
 	/// \brief Accessor for entity type property
 	const TypeNode<LocatedEntity>* getType() const { return m_type; }
@@ -412,6 +427,13 @@ public:
 	/// @param prop the property object to be used
 	PropertyBase* setProperty(const std::string& name, std::unique_ptr<PropertyBase> prop);
 
+	/// \brief Remove the property object for a given attribute
+	///
+	/// The removal is recorded, so that observers which ask for what's
+	/// changed are told about it.
+	/// @param name name of the attribute to remove
+	void removeProperty(const std::string& name);
+
 	 void installDelegate(int, const std::string&);
 
 	 void removeDelegate(int, const std::string&);
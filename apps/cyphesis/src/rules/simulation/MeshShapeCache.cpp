@@ -0,0 +1,416 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "MeshShapeCache.h"
+#include "OgreMeshDeserializer.h"
+#include "physics/Convert.h"
+#include "common/log.h"
+
+#include "squall/core/Generator.h"
+
+#include <BulletCollision/CollisionShapes/btTriangleIndexVertexArray.h>
+#include <BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h>
+#include <BulletCollision/CollisionShapes/btOptimizedBvh.h>
+#include <LinearMath/btAlignedAllocator.h>
+
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace {
+
+/// \brief Placed at the start of each cache file.
+struct CacheHeader {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t scalarSize;
+	std::uint64_t vertexCount;
+	std::uint64_t indexCount;
+	double bounds[6];
+	/// \brief Size of the serialized BVH, or zero if there's none.
+	std::uint64_t bvhSize;
+};
+
+const char CACHE_MAGIC[8] = "CYSHAPE";
+
+/// \brief Bump whenever the format, or the way shapes are built, changes.
+constexpr std::uint32_t CACHE_VERSION = 1;
+
+/// \brief Bullet requires serialized BVHs to be aligned.
+constexpr std::size_t BVH_ALIGNMENT = 16;
+
+std::size_t alignedOffset(std::size_t offset) {
+	return (offset + BVH_ALIGNMENT - 1) & ~(BVH_ALIGNMENT - 1);
+}
+}
+
+std::shared_ptr<MeshShape> MeshShape::create(std::vector<btScalar> vertices,
+											 std::vector<unsigned int> indices,
+											 WFMath::AxisBox<3> bounds) {
+	if (indices.empty() || vertices.empty()) {
+		spdlog::error("Vertices or indices were empty.");
+		return {};
+	}
+
+	if (vertices.size() % 3 != 0 || indices.size() % 3 != 0) {
+		spdlog::error("Vertices or indices were not even with 3.");
+		return {};
+	}
+
+	auto vertexCount = vertices.size() / 3;
+	for (auto index: indices) {
+		if (index >= vertexCount) {
+			spdlog::error("Index out of bounds.");
+			return {};
+		}
+	}
+
+	return std::shared_ptr<MeshShape>(new MeshShape(std::move(vertices), std::move(indices), bounds));
+}
+
+std::shared_ptr<MeshShape> MeshShape::readMeshFile(const std::filesystem::path& path) {
+	if (std::ifstream fileStream(path); fileStream) {
+		OgreMeshDeserializer deserializer(fileStream);
+		deserializer.deserialize();
+		return create(std::move(deserializer.m_vertices), std::move(deserializer.m_indices), deserializer.m_bounds);
+	}
+	return {};
+}
+
+MeshShape::MeshShape(std::vector<btScalar> vertices,
+					 std::vector<unsigned int> indices,
+					 WFMath::AxisBox<3> bounds)
+		: m_vertices(std::move(vertices)),
+		  m_indices(std::move(indices)),
+		  m_bounds(bounds),
+		  m_bvhBuffer(nullptr),
+		  m_deserializedBvh(nullptr) {
+	m_triangleVertexArray = createTriangleVertexArray();
+
+	btVector3 aabbMin, aabbMax;
+	m_triangleVertexArray->getPremadeAabb(&aabbMin, &aabbMax);
+
+	if (!m_bounds.isValid()) {
+		m_bounds = WFMath::AxisBox<3>(Convert::toWF<WFMath::Point<3>>(aabbMin), Convert::toWF<WFMath::Point<3>>(aabbMax));
+	}
+}
+
+std::unique_ptr<btTriangleIndexVertexArray> MeshShape::createTriangleVertexArray() const {
+	int vertStride = sizeof(btScalar) * 3;
+	int indexStride = sizeof(unsigned int) * 3;
+
+	//Bullet only reads through these pointers, so it's safe to share the const data.
+	auto array = std::make_unique<btTriangleIndexVertexArray>(static_cast<int>(m_indices.size() / 3),
+															  reinterpret_cast<int*>(const_cast<unsigned int*>(m_indices.data())),
+															  indexStride,
+															  static_cast<int>(m_vertices.size() / 3),
+															  const_cast<btScalar*>(m_vertices.data()),
+															  vertStride);
+
+	btVector3 aabbMin, aabbMax;
+	array->calculateAabbBruteForce(aabbMin, aabbMax);
+	array->setPremadeAabb(aabbMin, aabbMax);
+	return array;
+}
+
+MeshShape::~MeshShape() {
+	//The shape must go before the BVH it uses.
+	m_bvhShape.reset();
+	if (m_deserializedBvh) {
+		//The deserialized BVH was created in place in the buffer, and doesn't own any memory.
+		m_deserializedBvh->~btOptimizedBvh();
+	}
+	if (m_bvhBuffer) {
+		btAlignedFree(m_bvhBuffer);
+	}
+}
+
+bool MeshShape::adoptBvh(void* alignedBuffer, unsigned int size) {
+	auto bvh = btOptimizedBvh::deSerializeInPlace(alignedBuffer, size, false);
+	if (!bvh) {
+		btAlignedFree(alignedBuffer);
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(m_bvhMutex);
+	m_bvhBuffer = alignedBuffer;
+	m_deserializedBvh = bvh;
+	return true;
+}
+
+bool MeshShape::setupBvhShape() {
+	std::lock_guard<std::mutex> lock(m_bvhMutex);
+	if (m_bvhShape) {
+		return false;
+	}
+	if (m_deserializedBvh) {
+		m_bvhShape = std::make_unique<btBvhTriangleMeshShape>(m_triangleVertexArray.get(), true, false);
+		m_bvhShape->setOptimizedBvh(m_deserializedBvh);
+	} else {
+		m_bvhShape = std::make_unique<btBvhTriangleMeshShape>(m_triangleVertexArray.get(), true, true);
+	}
+	m_bvhShape->setLocalScaling(btVector3(1, 1, 1));
+	return true;
+}
+
+btBvhTriangleMeshShape* MeshShape::bvhShape() {
+	setupBvhShape();
+	return m_bvhShape.get();
+}
+
+bool MeshShape::hasBvhShape() const {
+	std::lock_guard<std::mutex> lock(m_bvhMutex);
+	return m_bvhShape != nullptr || m_deserializedBvh != nullptr;
+}
+
+MeshShapeCache::MeshShapeCache(std::filesystem::path directory)
+		: m_directory(std::move(directory)) {
+}
+
+MeshShapeCache::~MeshShapeCache() = default;
+
+std::string MeshShapeCache::signatureFor(const std::filesystem::path& path) {
+	std::error_code ec;
+	auto lastWriteTime = std::filesystem::last_write_time(path, ec);
+	if (ec) {
+		return {};
+	}
+	auto size = std::filesystem::file_size(path, ec);
+	if (ec) {
+		return {};
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto I = m_signatures.find(path);
+		if (I != m_signatures.end() && I->second.lastWriteTime == lastWriteTime && I->second.size == size) {
+			return I->second.signature;
+		}
+	}
+
+	auto result = Squall::Generator::generateSignature(path);
+	if (!result.signature.isValid()) {
+		return {};
+	}
+	auto signature = result.signature.str();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_signatures[path] = FileSignature{lastWriteTime, size, signature};
+	return signature;
+}
+
+std::shared_ptr<MeshShape> MeshShapeCache::get(const std::filesystem::path& path, bool needsBvh) {
+	auto signature = signatureFor(path);
+	if (signature.empty()) {
+		return {};
+	}
+
+	std::shared_ptr<MeshShape> shape;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto I = m_shapes.find(signature);
+		if (I != m_shapes.end()) {
+			shape = I->second.lock();
+		}
+	}
+
+	auto cachePath = m_directory / (signature + ".bin");
+	bool needsWrite = false;
+	if (!shape) {
+		auto newShape = readCacheFile(cachePath);
+		bool fromMeshFile = false;
+		if (!newShape) {
+			newShape = MeshShape::readMeshFile(path);
+			if (!newShape) {
+				return {};
+			}
+			fromMeshFile = true;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto& entry = m_shapes[signature];
+		//Another thread might have loaded the same mesh while we were busy.
+		shape = entry.lock();
+		if (!shape) {
+			entry = newShape;
+			shape = std::move(newShape);
+			needsWrite = fromMeshFile;
+		}
+	}
+
+	if (needsBvh && shape->setupBvhShape() && !shape->m_deserializedBvh) {
+		needsWrite = true;
+	}
+
+	if (needsWrite) {
+		writeCacheFile(cachePath, *shape);
+	}
+	return shape;
+}
+
+std::vector<std::shared_ptr<MeshShape>> MeshShapeCache::preload(const std::map<std::filesystem::path, bool>& paths) {
+	std::vector<std::pair<std::filesystem::path, bool>> entries(paths.begin(), paths.end());
+	std::vector<std::shared_ptr<MeshShape>> shapes(entries.size());
+
+	auto loadMesh = [&](std::size_t index) {
+		auto& entry = entries[index];
+		try {
+			shapes[index] = get(entry.first, entry.second);
+			if (!shapes[index]) {
+				spdlog::error("Could not read geometry file at {}.", entry.first.string());
+			}
+		} catch (const std::exception& ex) {
+			spdlog::error("Exception when trying to parse geometry at {}: {}", entry.first.string(), ex.what());
+		}
+	};
+
+	auto threadCount = std::min(entries.size(), static_cast<std::size_t>(std::max(1u, std::thread::hardware_concurrency())));
+	if (threadCount <= 1) {
+		for (std::size_t i = 0; i < entries.size(); ++i) {
+			loadMesh(i);
+		}
+	} else {
+		boost::asio::thread_pool pool(threadCount);
+		for (std::size_t i = 0; i < entries.size(); ++i) {
+			boost::asio::post(pool, [&loadMesh, i]() { loadMesh(i); });
+		}
+		pool.join();
+	}
+	return shapes;
+}
+
+std::shared_ptr<MeshShape> MeshShapeCache::readCacheFile(const std::filesystem::path& path) const {
+	std::ifstream in(path, std::ios::binary);
+	if (!in) {
+		return {};
+	}
+
+	CacheHeader header{};
+	if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+		|| std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+		|| header.version != CACHE_VERSION
+		|| header.scalarSize != sizeof(btScalar)) {
+		return {};
+	}
+
+	std::error_code ec;
+	auto fileSize = std::filesystem::file_size(path, ec);
+	auto dataSize = sizeof(header) + header.vertexCount * sizeof(btScalar) + header.indexCount * sizeof(unsigned int);
+	if (header.bvhSize) {
+		dataSize = alignedOffset(dataSize) + header.bvhSize;
+	}
+	//Guard against damaged files before allocating anything.
+	if (ec || fileSize != dataSize) {
+		spdlog::warn("Shape cache at '{}' is damaged; ignoring it.", path.string());
+		return {};
+	}
+
+	std::vector<btScalar> vertices(header.vertexCount);
+	std::vector<unsigned int> indices(header.indexCount);
+	in.read(reinterpret_cast<char*>(vertices.data()), static_cast<std::streamsize>(vertices.size() * sizeof(btScalar)));
+	in.read(reinterpret_cast<char*>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(unsigned int)));
+	if (!in) {
+		return {};
+	}
+
+	WFMath::AxisBox<3> bounds(WFMath::Point<3>(header.bounds[0], header.bounds[1], header.bounds[2]),
+							  WFMath::Point<3>(header.bounds[3], header.bounds[4], header.bounds[5]));
+	auto shape = MeshShape::create(std::move(vertices), std::move(indices), bounds);
+	if (!shape) {
+		return {};
+	}
+
+	if (header.bvhSize) {
+		in.seekg(static_cast<std::streamoff>(alignedOffset(static_cast<std::size_t>(in.tellg()))));
+		auto buffer = btAlignedAlloc(header.bvhSize, BVH_ALIGNMENT);
+		if (!in.read(static_cast<char*>(buffer), static_cast<std::streamsize>(header.bvhSize))) {
+			btAlignedFree(buffer);
+			return {};
+		}
+		//If the BVH can't be used we'll just build it again.
+		if (!shape->adoptBvh(buffer, static_cast<unsigned int>(header.bvhSize))) {
+			spdlog::warn("Could not use BVH in shape cache at '{}'.", path.string());
+		}
+	}
+	return shape;
+}
+
+bool MeshShapeCache::writeCacheFile(const std::filesystem::path& path, MeshShape& shape) const {
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	try {
+		std::filesystem::create_directories(path.parent_path());
+
+		void* bvhBuffer = nullptr;
+		unsigned int bvhSize = 0;
+		{
+			std::lock_guard<std::mutex> bvhLock(shape.m_bvhMutex);
+			if (shape.m_bvhShape && shape.m_bvhShape->getOptimizedBvh()) {
+				auto bvh = shape.m_bvhShape->getOptimizedBvh();
+				bvhSize = bvh->calculateSerializeBufferSize();
+				bvhBuffer = btAlignedAlloc(bvhSize, BVH_ALIGNMENT);
+				if (!bvh->serializeInPlace(bvhBuffer, bvhSize, false)) {
+					btAlignedFree(bvhBuffer);
+					bvhBuffer = nullptr;
+					bvhSize = 0;
+				}
+			}
+		}
+		std::unique_ptr<void, void (*)(void*)> bvhHolder(bvhBuffer, [](void* p) { if (p) btAlignedFree(p); });
+
+		//Write to a temporary file which is then moved in place, so that a server starting at the same time never sees a half written file.
+		auto temporaryPath = path;
+		temporaryPath += ".tmp";
+		{
+			std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!out) {
+				return false;
+			}
+			CacheHeader header{};
+			std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+			header.version = CACHE_VERSION;
+			header.scalarSize = sizeof(btScalar);
+			header.vertexCount = shape.vertices().size();
+			header.indexCount = shape.indices().size();
+			auto& bounds = shape.bounds();
+			header.bounds[0] = bounds.lowCorner().x();
+			header.bounds[1] = bounds.lowCorner().y();
+			header.bounds[2] = bounds.lowCorner().z();
+			header.bounds[3] = bounds.highCorner().x();
+			header.bounds[4] = bounds.highCorner().y();
+			header.bounds[5] = bounds.highCorner().z();
+			header.bvhSize = bvhSize;
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(reinterpret_cast<const char*>(shape.vertices().data()), static_cast<std::streamsize>(shape.vertices().size() * sizeof(btScalar)));
+			out.write(reinterpret_cast<const char*>(shape.indices().data()), static_cast<std::streamsize>(shape.indices().size() * sizeof(unsigned int)));
+			if (bvhSize) {
+				auto position = static_cast<std::size_t>(out.tellp());
+				std::vector<char> padding(alignedOffset(position) - position, 0);
+				out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+				out.write(static_cast<const char*>(bvhBuffer), bvhSize);
+			}
+			out.flush();
+			if (!out) {
+				return false;
+			}
+		}
+		std::filesystem::rename(temporaryPath, path);
+		return true;
+	} catch (const std::exception& e) {
+		spdlog::warn("Could not write shape cache at '{}': {}", path.string(), e.what());
+		return false;
+	}
+}
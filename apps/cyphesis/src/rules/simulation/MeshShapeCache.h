@@ -0,0 +1,196 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef RULESETS_MESHSHAPECACHE_H_
+#define RULESETS_MESHSHAPECACHE_H_
+
+#include "common/Singleton.h"
+
+#include <wfmath/axisbox.h>
+#include <LinearMath/btScalar.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class btTriangleIndexVertexArray;
+
+class btBvhTriangleMeshShape;
+
+class btOptimizedBvh;
+
+/**
+ * @brief Triangle mesh data, together with the Bullet structures built from it.
+ *
+ * Instances are immutable once created (apart from the BVH being built on demand), so they
+ * can be shared between all types and entities which use the same mesh.
+ */
+class MeshShape {
+public:
+	/**
+	 * Creates a new instance, after checking that the data is valid.
+	 * @return Null if the data wasn't valid.
+	 */
+	static std::shared_ptr<MeshShape> create(std::vector<btScalar> vertices,
+											 std::vector<unsigned int> indices,
+											 WFMath::AxisBox<3> bounds);
+
+	/**
+	 * Reads the mesh from an Ogre mesh file, without touching any cache.
+	 * @return Null if the file couldn't be read.
+	 */
+	static std::shared_ptr<MeshShape> readMeshFile(const std::filesystem::path& path);
+
+	~MeshShape();
+
+	const std::vector<btScalar>& vertices() const { return m_vertices; }
+
+	const std::vector<unsigned int>& indices() const { return m_indices; }
+
+	/**
+	 * The bounds as declared by the mesh file, or calculated from the vertices if there's no file.
+	 */
+	const WFMath::AxisBox<3>& bounds() const { return m_bounds; }
+
+	btTriangleIndexVertexArray* triangleVertexArray() const { return m_triangleVertexArray.get(); }
+
+	/**
+	 * Creates a new interface over the shared vertex and index data.
+	 * Use this for shapes which scale their interface, since the one returned by triangleVertexArray() is shared by all users.
+	 * The returned array must not outlive this instance.
+	 */
+	std::unique_ptr<btTriangleIndexVertexArray> createTriangleVertexArray() const;
+
+	/**
+	 * Gets the BVH triangle shape, building the BVH if it hasn't been built or loaded already.
+	 * This is thread safe.
+	 */
+	btBvhTriangleMeshShape* bvhShape();
+
+	bool hasBvhShape() const;
+
+private:
+	friend class MeshShapeCache;
+
+	friend struct MeshShapeCacheTest;
+
+	MeshShape(std::vector<btScalar> vertices,
+			  std::vector<unsigned int> indices,
+			  WFMath::AxisBox<3> bounds);
+
+	/**
+	 * Uses a BVH which was previously serialized into the supplied buffer, taking ownership of the buffer.
+	 * @return False if the buffer didn't contain a valid BVH.
+	 */
+	bool adoptBvh(void* alignedBuffer, unsigned int size);
+
+	/**
+	 * Sets up the BVH triangle shape if it's not already set up.
+	 * @return True if it was set up by this call.
+	 */
+	bool setupBvhShape();
+
+	//Note that the order of these fields matters, as the mesh shape must be destroyed before the data it references.
+	std::vector<btScalar> m_vertices;
+	std::vector<unsigned int> m_indices;
+	WFMath::AxisBox<3> m_bounds;
+	std::unique_ptr<btTriangleIndexVertexArray> m_triangleVertexArray;
+
+	/**
+	 * Holds a deserialized BVH, if one was read from the cache.
+	 */
+	void* m_bvhBuffer;
+	btOptimizedBvh* m_deserializedBvh;
+
+	mutable std::mutex m_bvhMutex;
+	std::unique_ptr<btBvhTriangleMeshShape> m_bvhShape;
+};
+
+/**
+ * @brief Keeps mesh shapes around so that they can be shared, and stores them on disk so they don't need to be rebuilt.
+ *
+ * Shapes are identified by the Squall signature of the mesh file they were read from, so types referencing the same
+ * file share the same shape, and any change to the file results in a new shape.
+ *
+ * When stored on disk, the vertices and indices are stored along with the built BVH, which is the most expensive
+ * part of setting up a mesh shape. The cache files are placed in a directory of their own, named after the signatures.
+ */
+class MeshShapeCache : public Singleton<MeshShapeCache> {
+public:
+	explicit MeshShapeCache(std::filesystem::path directory);
+
+	~MeshShapeCache() override;
+
+	/**
+	 * Gets the shape for the mesh file, reading it from memory or disk if possible.
+	 * @param path The full path to the mesh file.
+	 * @param needsBvh True if the BVH will be used, in which case it will be built and stored on disk if needed.
+	 * @return Null if the file couldn't be read.
+	 */
+	std::shared_ptr<MeshShape> get(const std::filesystem::path& path, bool needsBvh);
+
+	/**
+	 * Loads a number of meshes concurrently.
+	 *
+	 * The returned shapes should be held on to until they've been picked up through calls to "get", since
+	 * the cache itself doesn't keep any shapes alive.
+	 * @param paths Full paths to mesh files, and whether the BVH is needed.
+	 */
+	std::vector<std::shared_ptr<MeshShape>> preload(const std::map<std::filesystem::path, bool>& paths);
+
+	const std::filesystem::path& directory() const {
+		return m_directory;
+	}
+
+private:
+	struct FileSignature {
+		std::filesystem::file_time_type lastWriteTime;
+		std::uintmax_t size;
+		std::string signature;
+	};
+
+	std::filesystem::path m_directory;
+
+	std::mutex m_mutex;
+
+	/**
+	 * Makes sure that only one thread at a time writes to the cache directory.
+	 */
+	mutable std::mutex m_writeMutex;
+
+	/**
+	 * Remembers the signatures of files, so we don't need to hash the same file multiple times.
+	 */
+	std::map<std::filesystem::path, FileSignature> m_signatures;
+
+	/**
+	 * All shapes which are in use, by signature.
+	 */
+	std::map<std::string, std::weak_ptr<MeshShape>> m_shapes;
+
+	std::string signatureFor(const std::filesystem::path& path);
+
+	std::shared_ptr<MeshShape> readCacheFile(const std::filesystem::path& path) const;
+
+	bool writeCacheFile(const std::filesystem::path& path, MeshShape& shape) const;
+};
+
+#endif /* RULESETS_MESHSHAPECACHE_H_ */
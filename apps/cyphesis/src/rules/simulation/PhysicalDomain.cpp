@@ -30,12 +30,14 @@
 
 #include "common/debug.h"
 #include "common/operations/Tick.h"
+#include "common/FlightRecorder.h"
 #include "rules/simulation/BaseWorld.h"
 #include "PerceptionSightProperty.h"
 #include "rules/ScaleProperty_impl.h"
 #include "SimulationSpeedProperty.h"
 #include "ModeDataProperty.h"
 #include "VisibilityDistanceProperty.h"
+#include "MindsProperty.h"
 #include "Remotery.h"
 #include "common/AtlasFactories.h"
 
@@ -48,9 +50,13 @@
 
 
 #include <btBulletDynamicsCommon.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
 #include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
 
 #include <algorithm>
+#include <mutex>
+#include <tuple>
 #include <memory>
 #include <unordered_set>
 #include <optional>
@@ -163,7 +169,7 @@ bool removeAndShift(std::vector<T>& collection, const T& entry) {
 }
 }
 
-long PhysicalDomain::s_processTimeUs = 0;
+bool PhysicalDomain::s_multithreaded = false;
 
 /**
  * The minimum angular resolution of visibility, expressed as degrees.
@@ -238,9 +244,14 @@ constexpr short COLLISION_MASK_TERRAIN = 4;
 constexpr short COLLISION_MASK_STATIC = 8;
 
 /**
- * The max amount of entities to do visibility checks for each tick.
+ * The amount of entities to do visibility checks for each tick, regardless of the budget, to make sure that the queue always drains.
  */
-constexpr size_t VISIBILITY_CHECK_MAX_ENTRIES = 20;
+constexpr size_t VISIBILITY_CHECK_MIN_ENTRIES = 20;
+
+/**
+ * Entities which have waited longer than this for visibility checks are given the highest priority, to avoid starvation.
+ */
+constexpr std::chrono::milliseconds VISIBILITY_CHECK_MAX_WAIT{1000};
 
 constexpr auto CCD_MOTION_FACTOR = 0.2f;
 
@@ -289,12 +300,9 @@ struct PhysicalDomain::PhysicalMotionState : public btMotionState {
 				m_bulletEntry.markedAsMovingLastFrame = false;
 			}
 			m_bulletEntry.markedAsMovingThisFrame = true;
-			if (!m_bulletEntry.markedForVisibilityRecalculation) {
-				//Mark the entity for visibility recalculation, but don't move the visibility and view sphere here.
-				//Instead rely on that being done by the calling code.
-				m_domain.m_visibilityRecalculateQueue.emplace_back(&m_bulletEntry);
-				m_bulletEntry.markedForVisibilityRecalculation = true;
-			}
+			//Mark the entity for visibility recalculation, but don't move the visibility and view sphere here.
+			//Instead rely on that being done by the calling code.
+			m_domain.markForVisibilityRecalculation(m_bulletEntry);
 
 			//            cy_debug_print(
 			//                    "setWorldTransform: "<< m_entity.describeEntity() << " (" << centerOfMassWorldTrans.getOrigin().x() << "," << centerOfMassWorldTrans.getOrigin().y() << "," << centerOfMassWorldTrans.getOrigin().z() << ")");
@@ -456,18 +464,23 @@ struct PhysicalDomain::VisibilityPairCallback : public btOverlappingPairCallback
 
 std::chrono::steady_clock::duration postDuration;
 
-PhysicalDomain::PhysicalDomain(LocatedEntity& entity) :
+PhysicalDomain::PhysicalDomain(LocatedEntity& entity, bool multithreaded) :
 	Domain(entity),
 	mWorldInfo{.propellingEntries = &m_propellingEntries, .steppingEntries = &m_steppingEntries},
+	//The multithreaded classes can't be used without a task scheduler.
+	m_multithreaded(multithreaded && btGetTaskScheduler()),
 	//default config for now
 	m_collisionConfiguration(new btDefaultCollisionConfiguration()),
-	m_dispatcher(new btCollisionDispatcher(m_collisionConfiguration.get())),
-	m_constraintSolver(new btSequentialImpulseConstraintSolver()),
+	m_dispatcher(m_multithreaded ? new btCollisionDispatcherMt(m_collisionConfiguration.get()) : new btCollisionDispatcher(m_collisionConfiguration.get())),
+	//With multiple threads each island is solved by one of a pool of solvers, one for each thread.
+	m_constraintSolver(m_multithreaded ? static_cast<btConstraintSolver*>(new btConstraintSolverPoolMt(btGetTaskScheduler()->getNumThreads()))
+									 : new btSequentialImpulseConstraintSolver()),
 	//We'll use a dynamic broadphase for the main world. It's not as fast as SAP variants, but it's faster when dynamic objects are at rest.
 	m_broadphase(new btDbvtBroadphase()),
 	// m_broadphase(new btAxisSweep3(Convert::toBullet(entity.m_location.bBox().lowCorner()),
 	//                                              Convert::toBullet(entity.m_location.bBox().highCorner()))),
-	m_dynamicsWorld(new PhysicalWorld(m_dispatcher.get(), m_broadphase.get(), m_constraintSolver.get(), m_collisionConfiguration.get())),
+	m_dynamicsWorld(m_multithreaded ? static_cast<btDiscreteDynamicsWorld*>(new PhysicalWorldMt(m_dispatcher.get(), m_broadphase.get(), static_cast<btConstraintSolverPoolMt*>(m_constraintSolver.get()), m_collisionConfiguration.get()))
+								  : new PhysicalWorld(m_dispatcher.get(), m_broadphase.get(), m_constraintSolver.get(), m_collisionConfiguration.get())),
 	m_visibilityPairCallback(new VisibilityPairCallback()),
 	m_visibilityDispatcher(new btCollisionDispatcher(m_collisionConfiguration.get())),
 	//We'll use a SAP broadphase for the visibility. This is more efficient than a dynamic one.
@@ -651,6 +664,8 @@ PhysicalDomain::~PhysicalDomain() {
 	}
 
 	m_propertyAppliedConnection.disconnect();
+
+	m_visibilityQueueSize.add(-static_cast<std::int64_t>(m_reportedVisibilityQueueSize));
 }
 
 void PhysicalDomain::installDelegates(LocatedEntity& entity, const std::string& propertyName) {
@@ -1001,22 +1016,114 @@ void PhysicalDomain::updateObservedEntry(BulletEntry& bulletEntry, OpVector& res
 	}
 }
 
+void PhysicalDomain::markForVisibilityRecalculation(BulletEntry& entry) {
+	if (!entry.markedForVisibilityRecalculation) {
+		m_visibilityRecalculateQueue.emplace_back(&entry);
+		entry.markedForVisibilityRecalculation = true;
+		entry.markedForVisibilityRecalculationTime = std::chrono::steady_clock::now();
+	}
+}
+
 void PhysicalDomain::updateVisibilityOfDirtyEntities(OpVector& res) {
 	rmt_ScopedCPUSample(PhysicalDomain_updateVisibilityOfDirtyEntities, 0)
 
+	auto now = std::chrono::steady_clock::now();
 	if (!m_visibilityRecalculateQueue.empty()) {
+		struct Priority {
+			int tier;
+			btScalar distance;
+			std::chrono::steady_clock::time_point time;
+			BulletEntry* entry;
+
+			bool operator<(const Priority& rhs) const {
+				return std::tie(tier, distance, time) < std::tie(rhs.tier, rhs.distance, rhs.time);
+			}
+		};
+		std::vector<Priority> priorities;
+
+		//Only prioritize if we might not be able to handle all entries this tick.
+		if (m_visibilityRecalculateQueue.size() > VISIBILITY_CHECK_MIN_ENTRIES) {
+			//Entities controlled by minds (i.e. players and NPCs) are handled first, so that they quickly see what's around them.
+			//Then entities seen by such entities, with the closest first, and last everything else, with the oldest first.
+			std::unordered_map<const BulletEntry*, bool> controlledEntries;
+			auto isControlledFn = [&](const BulletEntry* entry) {
+				auto result = controlledEntries.emplace(entry, false);
+				if (result.second) {
+					auto mindsProp = entry->entity.getPropertyClassFixed<MindsProperty>();
+					result.first->second = mindsProp && !mindsProp->getMinds().empty();
+				}
+				return result.first->second;
+			};
+
+			priorities.reserve(m_visibilityRecalculateQueue.size());
+			for (auto entry: m_visibilityRecalculateQueue) {
+				Priority priority{2, 0, entry->markedForVisibilityRecalculationTime, entry};
+				if (isControlledFn(entry) || now - entry->markedForVisibilityRecalculationTime > VISIBILITY_CHECK_MAX_WAIT) {
+					priority.tier = 0;
+				} else if (entry->positionProperty.data().isValid()) {
+					auto position = Convert::toBullet(entry->positionProperty.data());
+					for (auto observer: entry->observingThis) {
+						if (observer != entry && observer->positionProperty.data().isValid() && isControlledFn(observer)) {
+							auto distance = position.distance2(Convert::toBullet(observer->positionProperty.data()));
+							if (priority.tier != 1 || distance < priority.distance) {
+								priority.tier = 1;
+								priority.distance = distance;
+							}
+						}
+					}
+				}
+				priorities.push_back(priority);
+			}
+		}
+
+		//The budget only covers the checks themselves, not the prioritization.
+		std::chrono::steady_clock::duration elapsed{};
+		//The entries up to this have been put in order. The rest are only ordered in batches when they are needed,
+		//since usually just a small part of the queue is handled each tick.
+		size_t orderedCount = 0;
+		size_t batchSize = VISIBILITY_CHECK_MIN_ENTRIES;
 		size_t i = 0;
-		//Handle max VISIBILITY_CHECK_MAX_ENTRIES entities each time.
-		auto I = m_visibilityRecalculateQueue.begin();
-		for (; I != m_visibilityRecalculateQueue.end() && i < VISIBILITY_CHECK_MAX_ENTRIES; ++i, ++I) {
-			auto& bulletEntry = *I;
+		for (; i < m_visibilityRecalculateQueue.size(); ++i) {
+			//Always handle a minimum amount of entries, but after that stop when we've used up our budget.
+			if (i >= VISIBILITY_CHECK_MIN_ENTRIES && elapsed >= m_visibilityCheckBudget) {
+				break;
+			}
+			BulletEntry* bulletEntry;
+			if (priorities.empty()) {
+				bulletEntry = m_visibilityRecalculateQueue[i];
+			} else {
+				if (i == orderedCount) {
+					auto batchEnd = priorities.begin() + static_cast<std::ptrdiff_t>(std::min(priorities.size(), orderedCount + batchSize));
+					std::nth_element(priorities.begin() + static_cast<std::ptrdiff_t>(orderedCount), batchEnd, priorities.end());
+					std::sort(priorities.begin() + static_cast<std::ptrdiff_t>(orderedCount), batchEnd);
+					orderedCount = static_cast<size_t>(batchEnd - priorities.begin());
+					//Grow the batches, so that the total amount of selection work stays proportional to the size of the queue.
+					batchSize *= 2;
+				}
+				bulletEntry = priorities[i].entry;
+			}
+			auto checkStart = std::chrono::steady_clock::now();
 			updateObservedEntry(*bulletEntry, res);
 			updateObserverEntry(*bulletEntry, res);
 			bulletEntry->markedForVisibilityRecalculation = false;
 			bulletEntry->entity.onUpdated();
+			now = std::chrono::steady_clock::now();
+			elapsed += now - checkStart;
+			m_visibilityLatency.observe(now - bulletEntry->markedForVisibilityRecalculationTime);
+		}
+
+		if (priorities.empty()) {
+			m_visibilityRecalculateQueue.erase(m_visibilityRecalculateQueue.begin(), m_visibilityRecalculateQueue.begin() + static_cast<std::ptrdiff_t>(i));
+		} else {
+			m_visibilityRecalculateQueue.clear();
+			for (auto J = priorities.begin() + static_cast<std::ptrdiff_t>(i); J != priorities.end(); ++J) {
+				m_visibilityRecalculateQueue.push_back(J->entry);
+			}
 		}
-		m_visibilityRecalculateQueue.erase(m_visibilityRecalculateQueue.begin(), I);
 	}
+
+	m_visibilityQueueSize.add(static_cast<std::int64_t>(m_visibilityRecalculateQueue.size()) - static_cast<std::int64_t>(m_reportedVisibilityQueueSize));
+	m_reportedVisibilityQueueSize = m_visibilityRecalculateQueue.size();
 }
 
 float PhysicalDomain::getMassForEntity(const LocatedEntity& entity) {
@@ -1649,10 +1756,7 @@ void PhysicalDomain::childEntityPropertyApplied(const std::string& name, const P
 
 				if (radius != bulletEntry.visibilityShape->getImplicitShapeDimensions().x()) {
 					bulletEntry.visibilityShape->setUnscaledRadius(radius);
-					if (!bulletEntry.markedForVisibilityRecalculation) {
-						m_visibilityRecalculateQueue.emplace_back(&bulletEntry);
-						bulletEntry.markedForVisibilityRecalculation = true;
-					}
+					markForVisibilityRecalculation(bulletEntry);
 				}
 			}
 
@@ -2232,10 +2336,7 @@ void PhysicalDomain::applyNewPositionForEntity(BulletEntry& entry, const WFMath:
 			BaseWorld::instance().message(op, m_entity);
 		}
 	}
-	if (!entry.markedForVisibilityRecalculation) {
-		m_visibilityRecalculateQueue.emplace_back(&entry);
-		entry.markedForVisibilityRecalculation = true;
-	}
+	markForVisibilityRecalculation(entry);
 
 }
 
@@ -2713,6 +2814,8 @@ void PhysicalDomain::sendMoveSight(BulletEntry& entry, bool posChange, bool velo
 		if (shouldSendOp) {
 			Set setOp;
 			move_arg->setId(entity.getIdAsString());
+			//Let observers know which version of the entity this is, so they can ask for only what's changed later on.
+			move_arg->setStamp(entity.getSeq());
 			if (debug_flag) {
 				cy_debug_print("Sending set op for movement.")
 				if (entry.velocityProperty.data().isValid()) {
@@ -2881,6 +2984,8 @@ void PhysicalDomain::tick(std::chrono::milliseconds tickSize, OpVector& res) {
 
 	//  static std::map<BulletEntry*, BulletCollisionEntry> projectileCollisions;
 	static std::vector<std::pair<BulletEntry*, BulletCollisionEntry>> projectileCollisions;
+	//Contacts are processed on the worker threads when multithreaded.
+	static std::mutex projectileCollisionsMutex;
 
 	gContactProcessedCallback = [](btManifoldPoint& cp, void* body0, void* body1) -> bool {
 		auto object0 = static_cast<btCollisionObject*>(body0);
@@ -2888,6 +2993,10 @@ void PhysicalDomain::tick(std::chrono::milliseconds tickSize, OpVector& res) {
 		auto object1 = static_cast<btCollisionObject*>(body1);
 		auto bulletEntry1 = static_cast<BulletEntry*>(object1->getUserPointer());
 
+		if (bulletEntry0->mode != ModeProperty::Mode::Projectile && bulletEntry1->mode != ModeProperty::Mode::Projectile) {
+			return true;
+		}
+		std::lock_guard<std::mutex> lock(projectileCollisionsMutex);
 		if (bulletEntry0->mode == ModeProperty::Mode::Projectile) {
 			projectileCollisions.emplace_back(bulletEntry0, BulletCollisionEntry{.bulletEntry = bulletEntry1, .pos = cp.getPositionWorldOnB()});
 		}
@@ -2962,6 +3071,11 @@ void PhysicalDomain::tick(std::chrono::milliseconds tickSize, OpVector& res) {
 
 	//CProfileManager::dumpAll();
 
+	//When multithreaded the collisions of a projectile aren't necessarily added one after the other, so they need to be grouped.
+	if (m_multithreaded) {
+		std::stable_sort(projectileCollisions.begin(), projectileCollisions.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+	}
+
 	//The list of projectilecollisions will contain duplicates, so we need to keep track of the last
 	//processed and check that it does not repeat.
 	BulletEntry* lastCollisionEntry = nullptr;
@@ -3077,7 +3191,15 @@ void PhysicalDomain::tick(std::chrono::milliseconds tickSize, OpVector& res) {
 			movingSize
 		);
 	}
-	s_processTimeUs += microseconds.count();
+	m_tickDuration.observe(duration);
+
+	if (FlightRecorder::hasInstance()) {
+		auto& flightRecorder = FlightRecorder::instance();
+		flightRecorder.addPhase("physics", duration);
+		flightRecorder.addPhase("physics_step", interim);
+		flightRecorder.addPhase("physics_visibility", visDuration);
+		flightRecorder.addPhase("physics_post_tick", postDuration);
+	}
 }
 
 void PhysicalDomain::processWaterBodies() {
@@ -22,6 +22,7 @@
 #include "rules/Location.h"
 #include "ModeProperty.h"
 #include "rules/PhysicalProperties.h"
+#include "common/Metrics.h"
 
 #include <sigc++/connection.h>
 
@@ -50,9 +51,9 @@ class btBroadphaseInterface;
 
 class btCollisionWorld;
 
-class btSequentialImpulseConstraintSolver;
+class btConstraintSolver;
 
-class PhysicalWorld;
+class btDiscreteDynamicsWorld;
 
 class btRigidBody;
 
@@ -74,9 +75,16 @@ class PropelProperty;
  */
 class PhysicalDomain : public Domain {
 public:
-	static long s_processTimeUs;
+	/**
+	 * Whether new domains simulate on multiple threads by default, through the Bullet task scheduler (see PhysicsTaskScheduler).
+	 */
+	static bool s_multithreaded;
 
-	explicit PhysicalDomain(LocatedEntity& entity);
+	/**
+	 * @param multithreaded If true the dynamics world uses the multithreaded Bullet classes. This pays off for domains with
+	 * many active bodies; otherwise the simulation is the same as in the single threaded world, which is also deterministic.
+	 */
+	explicit PhysicalDomain(LocatedEntity& entity, bool multithreaded = s_multithreaded);
 
 	~PhysicalDomain() override;
 
@@ -217,6 +225,11 @@ protected:
 		 */
 		bool markedForVisibilityRecalculation = false;
 
+		/**
+		 * When the entry was added to m_visibilityRecalculateQueue. Used to prioritise, and to measure latency.
+		 */
+		std::chrono::steady_clock::time_point markedForVisibilityRecalculationTime;
+
 		/**
 		 * Set to true if the entry has been added to m_movingEntities
 		 */
@@ -297,9 +310,28 @@ protected:
 
 	/**
 	 * Contains entities which needs to have their visibility recalculated, either because they moved or they changed size.
+	 * The order of this is not significant, as it's ordered by priority when being processed.
 	 */
 	std::vector<BulletEntry*> m_visibilityRecalculateQueue;
 
+	/**
+	 * The size of m_visibilityRecalculateQueue when it was last added to m_visibilityQueueSize.
+	 */
+	size_t m_reportedVisibilityQueueSize = 0;
+
+	/**
+	 * Shared by all domains.
+	 */
+	Metrics::Histogram& m_tickDuration = Metrics::instance().histogram("physics_tick_seconds", "Time spent ticking a physical domain.");
+	Metrics::Gauge& m_visibilityQueueSize = Metrics::instance().gauge("physics_visibility_queue", "Number of entities waiting for visibility recalculation.");
+	Metrics::Histogram& m_visibilityLatency = Metrics::instance().histogram("physics_visibility_latency_seconds",
+																		   "Time from an entity being marked for visibility recalculation until it's processed.");
+
+	/**
+	 * How much time to spend on visibility checks each tick. Any entities not handled will be handled in later ticks.
+	 */
+	std::chrono::steady_clock::duration m_visibilityCheckBudget = std::chrono::microseconds(2000);
+
 	/**
 	 * Keeps track of all water bodies, and the entities that currently are near them (as determined by the broadphase proxy).
 	 * The entities contained in the set are thus _possibly_ contained in the water, but not necessarily. The main reason
@@ -364,11 +396,13 @@ protected:
 
 	WorldInfo mWorldInfo;
 
+	bool m_multithreaded;
+
 	std::unique_ptr<btDefaultCollisionConfiguration> m_collisionConfiguration;
 	std::unique_ptr<btCollisionDispatcher> m_dispatcher;
-	std::unique_ptr<btSequentialImpulseConstraintSolver> m_constraintSolver;
+	std::unique_ptr<btConstraintSolver> m_constraintSolver;
 	std::unique_ptr<btBroadphaseInterface> m_broadphase;
-	std::unique_ptr<PhysicalWorld> m_dynamicsWorld;
+	std::unique_ptr<btDiscreteDynamicsWorld> m_dynamicsWorld;
 
 	std::unique_ptr<btOverlappingPairCallback> m_visibilityPairCallback;
 	std::unique_ptr<btCollisionDispatcher> m_visibilityDispatcher;
@@ -452,6 +486,14 @@ protected:
 
 	void processMovedEntity(BulletEntry& bulletEntry, std::chrono::milliseconds timeSinceLastUpdate);
 
+	/**
+	 * Adds the entry to the visibility recalculation queue, unless it already is queued.
+	 */
+	void markForVisibilityRecalculation(BulletEntry& entry);
+
+	/**
+	 * Recalculates visibility for queued entries, in order of priority, for as long as the time budget allows.
+	 */
 	void updateVisibilityOfDirtyEntities(OpVector& res);
 
 	void updateObservedEntry(BulletEntry& entry, OpVector& res, bool generateOps = true) const;
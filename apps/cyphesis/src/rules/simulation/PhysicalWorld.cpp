@@ -20,6 +20,18 @@
 #include <BulletDynamics/Dynamics/btRigidBody.h>
 #include "Remotery.h"
 
+namespace {
+void synchronizeActiveMotionStates(btDiscreteDynamicsWorld& world, btAlignedObjectArray<btRigidBody*>& nonStaticRigidBodies) {
+	//iterate over all active rigid bodies
+	for (int i = 0; i < nonStaticRigidBodies.size(); i++) {
+		btRigidBody* body = nonStaticRigidBodies[i];
+		if (body->isActive()) {
+			world.synchronizeSingleMotionState(body);
+		}
+	}
+}
+}
+
 PhysicalWorld::PhysicalWorld(btDispatcher* dispatcher,
 							 btBroadphaseInterface* pairCache,
 							 btConstraintSolver* constraintSolver,
@@ -36,12 +48,28 @@ int PhysicalWorld::stepSimulation(btScalar timeStep, int maxSubSteps, btScalar f
 	int steps = btDiscreteDynamicsWorld::stepSimulation(timeStep, maxSubSteps, fixedTimeStep);
 
 	rmt_ScopedCPUSample(PhysicalWorld_synchronizeMotionStates, 0)
-	//iterate over all active rigid bodies
-	for (int i = 0; i < m_nonStaticRigidBodies.size(); i++) {
-		btRigidBody* body = m_nonStaticRigidBodies[i];
-		if (body->isActive()) {
-			synchronizeSingleMotionState(body);
-		}
-	}
+	synchronizeActiveMotionStates(*this, m_nonStaticRigidBodies);
+	return steps;
+}
+
+PhysicalWorldMt::PhysicalWorldMt(btDispatcher* dispatcher,
+								 btBroadphaseInterface* pairCache,
+								 btConstraintSolverPoolMt* solverPool,
+								 btCollisionConfiguration* collisionConfiguration)
+		//No separate solver for large islands; these are instead solved by one of the solvers in the pool.
+		: btDiscreteDynamicsWorldMt(dispatcher, pairCache, solverPool, nullptr, collisionConfiguration) {}
+
+void PhysicalWorldMt::synchronizeMotionStates() {
+	//Don't do anything here
+}
+
+int PhysicalWorldMt::stepSimulation(btScalar timeStep, int maxSubSteps, btScalar fixedTimeStep) {
+	rmt_ScopedCPUSample(PhysicalWorldMt_stepSimulation, 0)
+
+	int steps = btDiscreteDynamicsWorldMt::stepSimulation(timeStep, maxSubSteps, fixedTimeStep);
+
+	//Motion states call back into the entities, so they're synchronized on this thread once the step is done.
+	rmt_ScopedCPUSample(PhysicalWorldMt_synchronizeMotionStates, 0)
+	synchronizeActiveMotionStates(*this, m_nonStaticRigidBodies);
 	return steps;
 }
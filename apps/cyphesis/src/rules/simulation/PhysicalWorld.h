@@ -21,6 +21,7 @@
 
 
 #include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
 
 class PhysicalWorld : public btDiscreteDynamicsWorld {
 public:
@@ -32,6 +33,21 @@ public:
 	int stepSimulation(btScalar timeStep, int maxSubSteps = 1, btScalar fixedTimeStep = btScalar(1.) / btScalar(60.)) override;
 
 
+};
+
+/**
+ * Same as PhysicalWorld, but runs collision dispatch, islands and integration in parallel through the installed Bullet task scheduler.
+ */
+class PhysicalWorldMt : public btDiscreteDynamicsWorldMt {
+public:
+	PhysicalWorldMt(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolverPoolMt* solverPool, btCollisionConfiguration* collisionConfiguration);
+
+
+	void synchronizeMotionStates() override;
+
+	int stepSimulation(btScalar timeStep, int maxSubSteps = 1, btScalar fixedTimeStep = btScalar(1.) / btScalar(60.)) override;
+
+
 };
 
 
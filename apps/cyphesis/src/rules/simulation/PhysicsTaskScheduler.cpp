@@ -0,0 +1,182 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "PhysicsTaskScheduler.h"
+
+#include <algorithm>
+
+namespace {
+/**
+ * Set on the workers, and on the calling thread while it takes part in a loop, so that nested loops run inline.
+ */
+thread_local bool t_inParallelLoop = false;
+
+/**
+ * Splitting loops into more chunks than this per thread only adds overhead.
+ */
+constexpr int chunksPerThread = 4;
+}
+
+PhysicsTaskScheduler::PhysicsTaskScheduler(int numThreads)
+		: btITaskScheduler("Cyphesis"),
+		  m_job(nullptr),
+		  m_chunkCount(0),
+		  m_nextChunk(0),
+		  m_completedChunks(0),
+		  m_activeWorkers(0),
+		  m_generation(0),
+		  m_shuttingDown(false) {
+	startWorkers(std::clamp(numThreads, 1, getMaxNumThreads()) - 1);
+	btSetTaskScheduler(this);
+}
+
+PhysicsTaskScheduler::~PhysicsTaskScheduler() {
+	if (btGetTaskScheduler() == this) {
+		btSetTaskScheduler(btGetSequentialTaskScheduler());
+	}
+	stopWorkers();
+}
+
+bool PhysicsTaskScheduler::isSupported() {
+#if BT_THREADSAFE
+	return true;
+#else
+	return false;
+#endif
+}
+
+int PhysicsTaskScheduler::getMaxNumThreads() const {
+	return static_cast<int>(BT_MAX_THREAD_COUNT);
+}
+
+int PhysicsTaskScheduler::getNumThreads() const {
+	return static_cast<int>(m_workers.size()) + 1;
+}
+
+void PhysicsTaskScheduler::setNumThreads(int numThreads) {
+	stopWorkers();
+	startWorkers(std::clamp(numThreads, 1, getMaxNumThreads()) - 1);
+}
+
+void PhysicsTaskScheduler::startWorkers(int count) {
+	m_shuttingDown = false;
+	for (int i = 0; i < count; ++i) {
+		m_workers.emplace_back([this]() { workerLoop(); });
+	}
+}
+
+void PhysicsTaskScheduler::stopWorkers() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_shuttingDown = true;
+	}
+	m_jobAvailable.notify_all();
+	for (auto& worker: m_workers) {
+		worker.join();
+	}
+	m_workers.clear();
+}
+
+void PhysicsTaskScheduler::workerLoop() {
+	t_inParallelLoop = true;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto seenGeneration = m_generation;
+	while (true) {
+		m_jobAvailable.wait(lock, [&]() { return m_shuttingDown || m_generation != seenGeneration; });
+		if (m_shuttingDown) {
+			return;
+		}
+		seenGeneration = m_generation;
+		//The job might already have been completed by the other threads.
+		if (m_job) {
+			m_activeWorkers++;
+			processChunks(lock);
+			m_activeWorkers--;
+			m_jobDone.notify_one();
+		}
+	}
+}
+
+void PhysicsTaskScheduler::processChunks(std::unique_lock<std::mutex>& lock) {
+	while (m_nextChunk < m_chunkCount) {
+		auto chunk = m_nextChunk++;
+		auto& job = *m_job;
+		lock.unlock();
+		job(chunk);
+		lock.lock();
+		m_completedChunks++;
+	}
+}
+
+void PhysicsTaskScheduler::run(int chunkCount, const std::function<void(int)>& job) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_job = &job;
+	m_chunkCount = chunkCount;
+	m_nextChunk = 0;
+	m_completedChunks = 0;
+	m_generation++;
+	m_jobAvailable.notify_all();
+
+	t_inParallelLoop = true;
+	processChunks(lock);
+	t_inParallelLoop = false;
+
+	//Wait for the workers to both finish their chunks, and to stop referring to the job.
+	m_jobDone.wait(lock, [&]() { return m_completedChunks == m_chunkCount && m_activeWorkers == 0; });
+	m_job = nullptr;
+}
+
+void PhysicsTaskScheduler::parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) {
+	auto count = iEnd - iBegin;
+	if (count <= 0) {
+		return;
+	}
+	//The grain size is the smallest chunk worth running on its own, so chunks can be larger.
+	auto chunkSize = std::max({1, grainSize, (count + getNumThreads() * chunksPerThread - 1) / (getNumThreads() * chunksPerThread)});
+	auto chunkCount = (count + chunkSize - 1) / chunkSize;
+	if (chunkCount <= 1 || m_workers.empty() || t_inParallelLoop) {
+		body.forLoop(iBegin, iEnd);
+		return;
+	}
+	run(chunkCount, [&](int chunk) {
+		auto begin = iBegin + chunk * chunkSize;
+		body.forLoop(begin, std::min(begin + chunkSize, iEnd));
+	});
+}
+
+btScalar PhysicsTaskScheduler::parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) {
+	auto count = iEnd - iBegin;
+	if (count <= 0) {
+		return 0;
+	}
+	auto chunkSize = std::max({1, grainSize, (count + getNumThreads() * chunksPerThread - 1) / (getNumThreads() * chunksPerThread)});
+	auto chunkCount = (count + chunkSize - 1) / chunkSize;
+	if (chunkCount <= 1 || m_workers.empty() || t_inParallelLoop) {
+		return body.sumLoop(iBegin, iEnd);
+	}
+	std::vector<btScalar> sums(static_cast<size_t>(chunkCount), 0);
+	run(chunkCount, [&](int chunk) {
+		auto begin = iBegin + chunk * chunkSize;
+		sums[static_cast<size_t>(chunk)] = body.sumLoop(begin, std::min(begin + chunkSize, iEnd));
+	});
+	//Sum in chunk order, so that the result doesn't depend on which thread finished first.
+	btScalar sum = 0;
+	for (auto value: sums) {
+		sum += value;
+	}
+	return sum;
+}
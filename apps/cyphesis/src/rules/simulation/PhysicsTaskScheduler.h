@@ -0,0 +1,108 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef CYPHESIS_PHYSICSTASKSCHEDULER_H
+#define CYPHESIS_PHYSICSTASKSCHEDULER_H
+
+#include <LinearMath/btThreads.h>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs the parallel loops of the multithreaded Bullet classes on a pool of worker threads owned by us.
+ *
+ * Bullet only has one task scheduler per process, so creating an instance installs it (see btSetTaskScheduler),
+ * and destroying it restores the sequential scheduler. It must be created and destroyed on the main thread.
+ *
+ * The threads are kept running between ticks, and the thread calling a parallel loop takes part in the work.
+ * Loops started from within a loop, or which are too small to be split, are run on the calling thread.
+ *
+ * Running the multithreaded Bullet classes in parallel is only safe if Bullet has been built with BT_THREADSAFE,
+ * which can be checked with isSupported().
+ */
+class PhysicsTaskScheduler : public btITaskScheduler {
+public:
+	/**
+	 * @param numThreads The number of threads to run loops on, including the calling thread.
+	 */
+	explicit PhysicsTaskScheduler(int numThreads);
+
+	~PhysicsTaskScheduler() override;
+
+	/**
+	 * @return True if Bullet was built to be safe to run on multiple threads.
+	 */
+	static bool isSupported();
+
+	int getMaxNumThreads() const override;
+
+	int getNumThreads() const override;
+
+	void setNumThreads(int numThreads) override;
+
+	void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) override;
+
+	btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) override;
+
+private:
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_mutex;
+	std::condition_variable m_jobAvailable;
+	std::condition_variable m_jobDone;
+
+	/**
+	 * The current job, which processes a chunk by index. Null when there's no job.
+	 */
+	const std::function<void(int)>* m_job;
+	int m_chunkCount;
+	int m_nextChunk;
+	int m_completedChunks;
+	/**
+	 * Number of workers which are processing the current job.
+	 */
+	int m_activeWorkers;
+	/**
+	 * Increased for each job, so that the workers can tell when there's a new one.
+	 */
+	unsigned int m_generation;
+	bool m_shuttingDown;
+
+	void startWorkers(int count);
+
+	void stopWorkers();
+
+	void workerLoop();
+
+	/**
+	 * Processes chunks of the current job until there are none left.
+	 * @param lock A lock on m_mutex, which is released while a chunk is processed.
+	 */
+	void processChunks(std::unique_lock<std::mutex>& lock);
+
+	/**
+	 * Runs the job over all chunks, on the workers and the calling thread, and returns when all chunks are done.
+	 */
+	void run(int chunkCount, const std::function<void(int)>& job);
+};
+
+
+#endif //CYPHESIS_PHYSICSTASKSCHEDULER_H
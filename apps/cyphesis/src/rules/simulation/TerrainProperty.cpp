@@ -187,7 +187,7 @@ std::optional<int> TerrainProperty::getSurface(LocatedEntity& entity, float x, f
 		return {};
 	}
 	Mercator::Surface& tile_surface = *surfaces.begin()->second;
-	if (!tile_surface.isValid()) {
+	if (tile_surface.isDirty()) {
 		tile_surface.populate();
 	}
 	return tile_surface((int) x, (int) z, 0);
@@ -208,16 +208,15 @@ void WorldProperty::clearWorld(LocatedEntity& entity, OpVector&) {
 	}
 
 	//Remove all properties except for "id"
-	auto propIter = entity.getProperties().begin();
-	while (propIter != entity.getProperties().end()) {
-		if (propIter->first != "id") {
-			auto& prop = propIter->second;
-			prop.property->remove(entity, propIter->first);
-			entity.getProperties().erase(propIter++);
-		} else {
-			++propIter;
+	std::vector<std::string> propertyNames;
+	for (auto& entry: entity.getProperties()) {
+		if (entry.first != "id") {
+			propertyNames.push_back(entry.first);
 		}
 	}
+	for (auto& name: propertyNames) {
+		entity.removeProperty(name);
+	}
 
 	entity.requirePropertyClassFixed<CalendarProperty>();
 	entity.requirePropertyClassFixed<WorldTimeProperty>();
@@ -55,11 +55,11 @@ WorldRouter::WorldRouter(Ref<LocatedEntity> baseEntity,
 						 EntityCreator& entityCreator,
 						 TimeProviderFnType timeProviderFn) :
 		BaseWorld(timeProviderFn),
-		m_operationsDispatcher([&](const Operation& op, Ref<LocatedEntity> from) { this->operation(op, std::move(from)); }, timeProviderFn),
+		m_operationsDispatcher([&](const Operation& op, Ref<LocatedEntity> from, long toId) { this->operation(op, std::move(from), toId); }, timeProviderFn),
 		m_entityCount(1),
 		m_baseEntity(std::move(baseEntity)),
 		m_entityCreator(entityCreator) {
-	m_eobjects[m_baseEntity->getIdAsInt()] = m_baseEntity;
+	m_eobjects.insert(m_baseEntity->getIdAsInt(), m_baseEntity);
 	Monitors::instance().watch("entities", std::make_unique<Variable<int>>(m_entityCount));
 
 
@@ -95,7 +95,7 @@ void WorldRouter::addEntity(const Ref<LocatedEntity>& ent, const Ref<LocatedEnti
 	cy_debug_print("WorldRouter::addEntity(" << ent->describeEntity() << ")")
 	assert(ent->getIdAsInt() != 0);
 	assert(m_eobjects.find(ent->getIdAsInt()) == m_eobjects.end());
-	m_eobjects[ent->getIdAsInt()] = ent;
+	m_eobjects.insert(ent->getIdAsInt(), ent);
 	++m_entityCount;
 
 	ent->changeContainer(parent);
@@ -252,6 +252,10 @@ void WorldRouter::deliverTo(const Operation& op, Ref<LocatedEntity> ent) {
 			return;
 		}
 	}
+	//Proxies mirror entities simulated elsewhere, so they can be looked at but are only changed by themselves.
+	if (ent->hasFlags(entity_proxy) && op->getFrom() != ent->getIdAsString() && op->getClassNo() != Atlas::Objects::Operation::LOOK_NO) {
+		return;
+	}
 	//Set the time of when this op is dispatched. That way, other components in the system can
 	//always use the seconds set on the op to know the current time.
 	op->setStamp(getTimeAsMilliseconds().count());
@@ -296,6 +300,20 @@ void WorldRouter::deliverTo(const Operation& op, Ref<LocatedEntity> ent) {
 /// @param from entity the operation to be dispatched was send from. Note
 /// that it is possible that this entity has been destroyed.
 void WorldRouter::operation(const Operation& op, Ref<LocatedEntity> from) {
+	operation(op, std::move(from), OpQueEntry<LocatedEntity>::resolveToId(*op));
+}
+
+void WorldRouter::operation(const Operation& op, Ref<LocatedEntity> from, long toId) {
+	if (Dispatched.empty()) {
+		dispatchOperation(op, std::move(from), toId);
+	} else {
+		auto start = std::chrono::steady_clock::now();
+		dispatchOperation(op, std::move(from), toId);
+		Dispatched.emit(op, std::chrono::steady_clock::now() - start);
+	}
+}
+
+void WorldRouter::dispatchOperation(const Operation& op, Ref<LocatedEntity> from, long toId) {
 	m_operationsCount++;
 	try {
 		rmt_ScopedCPUSample(WorldRouter_operation, 0)
@@ -316,14 +334,14 @@ void WorldRouter::operation(const Operation& op, Ref<LocatedEntity> from) {
 			}
 			Ref<LocatedEntity> to_entity;
 
-			if (to == from->getIdAsString()) {
+			if (toId == from->getIdAsInt()) {
 				if (from->isDestroyed()) {
 					// Entity no longer exists, don't send anything
 					return;
 				}
 				to_entity = std::move(from);
 			} else {
-				to_entity = getEntity(to);
+				to_entity = m_eobjects.get(toId);
 
 				if (to_entity == nullptr || to_entity->isDestroyed()) {
 					// Entity has been removed, send an Unseen op back to the observer
@@ -348,9 +366,12 @@ void WorldRouter::operation(const Operation& op, Ref<LocatedEntity> from) {
 
 		} else {
 			//This will send an op to all entities in the system. Perhaps we should add some more checks for when we want to allow for this?
-			for (auto& entry: m_eobjects) {
-				op->setTo(entry.second->getIdAsString());
-				deliverTo(op, entry.second);
+			//Iterate over a snapshot, since entities might be added or removed when handling the op.
+			for (auto& entity: m_eobjects.snapshot()) {
+				if (!entity->isDestroyed()) {
+					op->setTo(entity->getIdAsString());
+					deliverTo(op, std::move(entity));
+				}
 			}
 		}
 	}
@@ -71,6 +71,10 @@ protected:
 
 	void resolveDispatchTimeForOp(Atlas::Objects::Operation::RootOperationData& op);
 
+	void dispatchOperation(const Atlas::Objects::Operation::RootOperation&,
+						   Ref<LocatedEntity>,
+						   long toId);
+
 public:
 
 
@@ -102,6 +106,14 @@ public:
 	void operation(const Atlas::Objects::Operation::RootOperation&,
 				   Ref<LocatedEntity>);
 
+	/**
+	 * @brief Dispatches an operation, with the integer id of the entity it's sent to already resolved.
+	 * @param toId The integer id of the recipient, or zero if the op has no "to".
+	 */
+	void operation(const Atlas::Objects::Operation::RootOperation&,
+				   Ref<LocatedEntity>,
+				   long toId);
+
 	void message(Atlas::Objects::Operation::RootOperation,
 				 LocatedEntity&) override;
 
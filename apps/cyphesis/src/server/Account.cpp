@@ -24,6 +24,7 @@
 #include "rules/simulation/ExternalMind.h"
 #include "Persistence.h"
 #include "PossessionAuthenticator.h"
+#include "ExternalMindsManager.h"
 #include "common/custom.h"
 #include "common/TypeNode.h"
 
@@ -212,6 +213,12 @@ void Account::LogoutOperation(const Operation& op, OpVector& res) {
 		for (auto& entry: m_minds) {
 			auto& mind = entry.second.mind;
 			if (mind->getIdAsString() == id) {
+				//A mind which is migrated to another client hands over its thoughts, which must be stored before the
+				//removal of the mind triggers a new possession request.
+				Element thoughtsElem;
+				if (arg->copyAttr("thoughts", thoughtsElem) == 0 && thoughtsElem.isList() && ExternalMindsManager::hasInstance()) {
+					ExternalMindsManager::instance().storeThoughts(mind->getEntity()->getIdAsString(), std::move(thoughtsElem.List()));
+				}
 				removeMindFromEntity(mind.get());
 				m_minds.erase(mind->getEntity()->getIdAsInt());
 
@@ -23,6 +23,7 @@
 #include "Connection.h"
 #include "Ruleset.h"
 #include "Juncture.h"
+#include "ExternalMindsManager.h"
 
 
 #include "rules/simulation/LocatedEntity.h"
@@ -36,6 +37,8 @@
 
 #include <Atlas/Objects/Anonymous.h>
 
+#include <algorithm>
+
 using Atlas::Message::Element;
 using Atlas::Message::MapType;
 using Atlas::Message::ListType;
@@ -48,12 +51,50 @@ using Atlas::Objects::Entity::RootEntity;
 
 static constexpr auto debug_flag = false;
 
+namespace {
+/// \brief The largest number of entities sent in one Info op when exporting a subtree.
+constexpr size_t maxExportBatchSize = 1000;
+
+/// \brief The largest number of subtree exports an account can have in progress at once.
+constexpr size_t maxSubtreeExports = 16;
+
+/// \brief How long a subtree export is kept without the client asking for the next batch.
+constexpr std::chrono::minutes exportIdleTimeout(5);
+
+/// \brief Adds the entity in a format from which it can later be restored.
+///
+/// Any modifiers are taken into account, so that the base values are sent.
+void addArchivedEntity(const LocatedEntity& entity, const RootEntity& info_arg) {
+	for (auto& entry: entity.getProperties()) {
+		//Don't send any property that's ephemeral, except for "id" and "contains" which are marked such.
+		//TODO: remove this flag from those properties and have the StorageManager look specifically for them instead. They are not ephemeral, they are just stored differently by the StorageManager.
+		if (!entry.second.property->hasFlags(prop_flag_persistence_ephem) || entry.first == "id" || entry.first == "contains") {
+			if (!entry.second.modifiers.empty()) {
+				//If the base value is none, only include it if there's a default value
+				if (!entry.second.baseValue.isNone() || (!entity.getType() || entity.getType()->defaults().find(entry.first) != entity.getType()->defaults().end())) {
+					info_arg->setAttr(entry.first, entry.second.baseValue);
+				}
+			} else {
+				entry.second.property->add(entry.first, info_arg);
+			}
+		}
+	}
+
+	info_arg->setStamp(entity.getSeq());
+	if (entity.getType()) {
+		info_arg->setParent(entity.getType()->name());
+	}
+	info_arg->setObjtype("obj");
+}
+}
+
 /// \brief Admin constructor
 Admin::Admin(Connection* conn,
 			 const std::string& username,
 			 const std::string& passwd,
 			 RouterId id) :
-		Account(conn, username, passwd, id) {
+		Account(conn, username, passwd, id),
+		m_nextExportCursor(1) {
 }
 
 Admin::~Admin() {
@@ -66,6 +107,13 @@ const char* Admin::getType() const {
 	return "admin";
 }
 
+void Admin::setConnection(Connection* connection) {
+	if (!connection) {
+		m_subtreeExports.clear();
+	}
+	Account::setConnection(connection);
+}
+
 std::unique_ptr<ExternalMind> Admin::createMind(const Ref<LocatedEntity>& entity) const {
 	auto id = newId();
 
@@ -155,28 +203,13 @@ void Admin::GetOperation(const Operation& op, OpVector& res) {
 			Anonymous info_arg;
 			auto& entity = K->second;
 			//If the "archive" flag is set the clients wants a format where it can later restore the entity.
-			//In that case we need to take any modifiers into account.
+			//If a batch size is also set the whole subtree is exported, one batch at a time.
 			if (arg->hasAttr("archive")) {
-				for (auto& entry: entity->getProperties()) {
-					//Don't send any property that's ephemeral, except for "id" and "contains" which are marked such.
-					//TODO: remove this flag from those properties and have the StorageManager look specifically for them instead. They are not ephemeral, they are just stored differently by the StorageManager.
-					if (!entry.second.property->hasFlags(prop_flag_persistence_ephem) || entry.first == "id" || entry.first == "contains") {
-						if (!entry.second.modifiers.empty()) {
-							//If the base value is none, only include it if there's a default value
-							if (!entry.second.baseValue.isNone() || (!entity->getType() || entity->getType()->defaults().find(entry.first) != entity->getType()->defaults().end())) {
-								info_arg->setAttr(entry.first, entry.second.baseValue);
-							}
-						} else {
-							entry.second.property->add(entry.first, info_arg);
-						}
-					}
-				}
-
-				info_arg->setStamp(entity->getSeq());
-				if (entity->getType()) {
-					info_arg->setParent(entity->getType()->name());
+				if (arg->hasAttr("batch")) {
+					exportSubtree(op, arg, *entity, res);
+					return;
 				}
-				info_arg->setObjtype("obj");
+				addArchivedEntity(*entity, info_arg);
 			} else {
 				entity->addToEntity(info_arg);
 			}
@@ -205,6 +238,87 @@ void Admin::GetOperation(const Operation& op, OpVector& res) {
 	res.push_back(info);
 }
 
+void Admin::exportSubtree(const Operation& op, const Root& arg, const LocatedEntity& root, OpVector& res) {
+	Element batchElem;
+	if (arg->copyAttr("batch", batchElem) != 0 || !batchElem.isInt() || batchElem.Int() <= 0) {
+		error(op, "Export batch size must be a positive integer.", res, getIdAsString());
+		return;
+	}
+	auto batchSize = std::min(static_cast<size_t>(batchElem.Int()), maxExportBatchSize);
+
+	auto now = std::chrono::steady_clock::now();
+	expireSubtreeExports(now);
+
+	//The cursor refers to the entities which are yet to be sent, from a previous batch.
+	long cursor;
+	std::deque<long> pending;
+	Element cursorElem;
+	if (arg->copyAttr("cursor", cursorElem) == 0) {
+		if (!cursorElem.isInt()) {
+			error(op, "Export cursor must be an integer.", res, getIdAsString());
+			return;
+		}
+		auto I = m_subtreeExports.find(cursorElem.Int());
+		if (I == m_subtreeExports.end()) {
+			clientError(op, fmt::format("Unknown export cursor {}.", cursorElem.Int()), res, getIdAsString());
+			return;
+		}
+		cursor = I->first;
+		pending = std::move(I->second.pending);
+		m_subtreeExports.erase(I);
+	} else {
+		cursor = m_nextExportCursor++;
+		pending.push_back(root.getIdAsInt());
+	}
+
+	auto& worldDict = m_connection->m_server.m_world.getEntities();
+	std::vector<Root> args;
+	args.reserve(std::min(batchSize, pending.size()));
+	while (!pending.empty() && args.size() < batchSize) {
+		auto entity = worldDict.get(pending.front());
+		pending.pop_front();
+		//The entity might have been destroyed since the previous batch was sent.
+		if (!entity || entity->isDestroyed()) {
+			continue;
+		}
+		Anonymous info_arg;
+		addArchivedEntity(*entity, info_arg);
+		args.emplace_back(std::move(info_arg));
+		if (entity->m_contains) {
+			for (auto& child: *entity->m_contains) {
+				pending.push_back(child->getIdAsInt());
+			}
+		}
+	}
+
+	Info info;
+	info->setArgs(std::move(args));
+	//Only hand out a cursor if there's more to send; the client asks for the next batch when it's ready for it.
+	if (!pending.empty()) {
+		if (m_subtreeExports.size() >= maxSubtreeExports) {
+			auto oldest = std::min_element(m_subtreeExports.begin(), m_subtreeExports.end(), [](const auto& a, const auto& b) {
+				return a.second.lastUsed < b.second.lastUsed;
+			});
+			spdlog::warn("Admin account {} has too many subtree exports in progress, dropping export {}.", getIdAsString(), oldest->first);
+			m_subtreeExports.erase(oldest);
+		}
+		info->setAttr("cursor", cursor);
+		m_subtreeExports.emplace(cursor, SubtreeExport{std::move(pending), now});
+	}
+	res.push_back(info);
+}
+
+void Admin::expireSubtreeExports(std::chrono::steady_clock::time_point now) {
+	for (auto I = m_subtreeExports.begin(); I != m_subtreeExports.end();) {
+		if (now - I->second.lastUsed >= exportIdleTimeout) {
+			spdlog::debug("Dropping idle subtree export {} of admin account {}.", I->first, getIdAsString());
+			I = m_subtreeExports.erase(I);
+		} else {
+			++I;
+		}
+	}
+}
+
 void Admin::SetOperation(const Operation& op, OpVector& res) {
 	const std::vector<Root>& args = op->getArgs();
 	if (args.empty()) {
@@ -338,6 +452,21 @@ void Admin::setAttribute(const Root& args) {
 		const Element possessiveElement = args->getAttr("possessive");
 		m_connection->setPossessionEnabled(possessiveElement.isInt() && possessiveElement.asInt() != 0, getIdAsString());
 	}
+	//Possessive accounts periodically report their load, which is used to decide which of them should get new minds.
+	if (args->hasAttr("possession_load")) {
+		auto loadElement = args->getAttr("possession_load");
+		if (loadElement.isMap()) {
+			auto& load = loadElement.Map();
+			auto mindsI = load.find("minds");
+			auto cpuTimeI = load.find("cpu_time");
+			if (mindsI != load.end() && mindsI->second.isInt() && cpuTimeI != load.end() && cpuTimeI->second.isNum()) {
+				ExternalMindsManager::instance().updateLoad(getIdAsString(),
+															(size_t) std::max<Atlas::Message::IntType>(0, mindsI->second.Int()),
+															std::chrono::duration<double>(cpuTimeI->second.asNum()),
+															std::chrono::steady_clock::now());
+			}
+		}
+	}
 }
 
 
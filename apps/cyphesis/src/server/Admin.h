@@ -24,6 +24,10 @@
 #include <sigc++/connection.h>
 #include <Atlas/Objects/SmartPtr.h>
 
+#include <chrono>
+#include <deque>
+#include <map>
+
 /// \brief This is a class for handling users with administrative priveleges
 class Admin : public Account {
 protected:
@@ -36,6 +40,31 @@ protected:
 	/// \brief Connection used to monitor the in-game operations
 	sigc::connection m_monitorConnection;
 
+	struct SubtreeExport {
+		/// \brief The ids of the entities which are yet to be sent.
+		std::deque<long> pending;
+		/// \brief When the last batch was sent.
+		std::chrono::steady_clock::time_point lastUsed;
+	};
+
+	/// \brief Subtree exports in progress, keyed by their cursor.
+	///
+	/// Clients may abandon an export at any time, so exports which haven't been continued for a while are
+	/// dropped, as are the least recently used ones if there are too many.
+	std::map<long, SubtreeExport> m_subtreeExports;
+
+	long m_nextExportCursor;
+
+	/// \brief Drops exports which have been idle for too long.
+	void expireSubtreeExports(std::chrono::steady_clock::time_point now);
+
+	/// \brief Sends the next batch of entities of a subtree export.
+	///
+	/// The entities are sent breadth first, so a parent is always sent before its children.
+	/// If there are more entities to send the Info op gets a "cursor" attribute, which the
+	/// client should send back in the next Get op.
+	void exportSubtree(const Operation& op, const Atlas::Objects::Root& arg, const LocatedEntity& root, OpVector& res);
+
 	std::unique_ptr<ExternalMind> createMind(const Ref<LocatedEntity>& entity) const override;
 
 	void processExternalOperation(const Operation& op, OpVector& res) override;
@@ -49,6 +78,9 @@ public:
 
 	const char* getType() const override;
 
+	/// \brief Drops any subtree exports in progress when disconnected.
+	void setConnection(Connection* connection) override;
+
 	/**
 	 * Allow admin clients to logout other accounts.
 	 */
@@ -0,0 +1,134 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "AiClientPool.h"
+
+#include "common/log.h"
+
+#include <algorithm>
+#include <thread>
+
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+
+AiClientPool::AiClientPool(std::vector<std::string> command, size_t size)
+		: m_command(std::move(command)),
+		  m_processes(size, Process{{}, {}, {}, minRestartDelay, false}),
+		  m_restartCount(0),
+		  m_isShutDown(false) {
+}
+
+AiClientPool::~AiClientPool() {
+	shutdown();
+}
+
+void AiClientPool::start(Process& process, std::chrono::steady_clock::time_point now) {
+	//Prepare the arguments before forking, since only async-signal-safe functions should be called in the child.
+	std::vector<char*> args;
+	args.reserve(m_command.size() + 1);
+	for (auto& arg: m_command) {
+		args.push_back(const_cast<char*>(arg.c_str()));
+	}
+	args.push_back(nullptr);
+
+	auto pid = fork();
+	if (pid == 0) {
+		execv(args.front(), args.data());
+		_exit(EXIT_FAILURE);
+	} else if (pid == -1) {
+		spdlog::warn("Could not spawn AI client process.");
+		process.nextStartTime = now + process.restartDelay;
+	} else {
+		if (process.hasStarted) {
+			m_restartCount++;
+		}
+		process.pid = pid;
+		process.startTime = now;
+		process.hasStarted = true;
+	}
+}
+
+void AiClientPool::reap(std::chrono::steady_clock::time_point now) {
+	for (auto& process: m_processes) {
+		//Only wait for our own processes, since any other child processes (such as the importer) are waited for elsewhere.
+		int status;
+		if (!process.pid || waitpid(*process.pid, &status, WNOHANG) <= 0) {
+			continue;
+		}
+		auto pid = *process.pid;
+		process.pid = {};
+		if (now - process.startTime >= stableRunTime) {
+			process.restartDelay = minRestartDelay;
+		} else {
+			process.restartDelay = std::min<std::chrono::steady_clock::duration>(process.restartDelay * 2, maxRestartDelay);
+		}
+		process.nextStartTime = now + process.restartDelay;
+		if (WIFSIGNALED(status)) {
+			spdlog::warn("AI client process {} was terminated by signal {}. Restarting it in {} seconds.",
+						 pid, WTERMSIG(status), std::chrono::duration_cast<std::chrono::seconds>(process.restartDelay).count());
+		} else {
+			spdlog::warn("AI client process {} exited with status {}. Restarting it in {} seconds.",
+						 pid, WEXITSTATUS(status), std::chrono::duration_cast<std::chrono::seconds>(process.restartDelay).count());
+		}
+	}
+}
+
+void AiClientPool::poll(std::chrono::steady_clock::time_point now) {
+	if (m_isShutDown) {
+		return;
+	}
+	reap(now);
+	for (auto& process: m_processes) {
+		if (!process.pid && process.nextStartTime <= now) {
+			start(process, now);
+		}
+	}
+}
+
+void AiClientPool::shutdown() {
+	if (m_isShutDown) {
+		return;
+	}
+	m_isShutDown = true;
+	for (auto& process: m_processes) {
+		if (process.pid) {
+			kill(*process.pid, SIGTERM);
+		}
+	}
+	//Give the clients some time to shut down cleanly before killing them.
+	auto deadline = std::chrono::steady_clock::now() + shutdownTimeout;
+	for (auto& process: m_processes) {
+		while (process.pid) {
+			auto result = waitpid(*process.pid, nullptr, WNOHANG);
+			if (result != 0) {
+				process.pid = {};
+			} else if (std::chrono::steady_clock::now() > deadline) {
+				spdlog::warn("AI client process {} didn't shut down in time, killing it.", *process.pid);
+				kill(*process.pid, SIGKILL);
+				waitpid(*process.pid, nullptr, 0);
+				process.pid = {};
+			} else {
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+		}
+	}
+}
+
+size_t AiClientPool::getRunningCount() const {
+	return std::count_if(m_processes.begin(), m_processes.end(), [](const Process& process) { return process.pid.has_value(); });
+}
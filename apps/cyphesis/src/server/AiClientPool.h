@@ -0,0 +1,116 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef CYPHESIS_AICLIENTPOOL_H
+#define CYPHESIS_AICLIENTPOOL_H
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+/**
+ * Launches and supervises a pool of AI client processes.
+ *
+ * Any process which exits is restarted. If a process exits soon after being started the restart is delayed,
+ * with the delay doubling for each such failure, so that a misconfigured client doesn't spin.
+ *
+ * Call poll() periodically to reap exited processes and restart them.
+ * All processes are terminated when the pool is destroyed.
+ */
+class AiClientPool {
+public:
+	/**
+	 * @param command The command to run, with the first element being the path to the executable.
+	 * @param size The number of processes to keep running.
+	 */
+	AiClientPool(std::vector<std::string> command, size_t size);
+
+	~AiClientPool();
+
+	/**
+	 * Reaps any exited processes, and starts any processes which are due to be (re)started.
+	 * @param now The current time.
+	 */
+	void poll(std::chrono::steady_clock::time_point now);
+
+	/**
+	 * Terminates all processes, and stops restarting them.
+	 */
+	void shutdown();
+
+	/**
+	 * @return The number of processes currently running.
+	 */
+	size_t getRunningCount() const;
+
+	/**
+	 * @return The number of times any process has been restarted after exiting.
+	 */
+	size_t getRestartCount() const {
+		return m_restartCount;
+	}
+
+	/**
+	 * A restart is delayed at least this long.
+	 */
+	static constexpr std::chrono::seconds minRestartDelay{1};
+
+	/**
+	 * A restart is delayed at most this long.
+	 */
+	static constexpr std::chrono::seconds maxRestartDelay{60};
+
+	/**
+	 * A process running at least this long is considered to have started successfully, resetting the restart delay.
+	 */
+	static constexpr std::chrono::seconds stableRunTime{30};
+
+	/**
+	 * When shutting down, processes which haven't exited within this time after being asked to are killed.
+	 */
+	static constexpr std::chrono::seconds shutdownTimeout{5};
+
+private:
+	struct Process {
+		/**
+		 * The pid of the process, if running.
+		 */
+		std::optional<pid_t> pid;
+		std::chrono::steady_clock::time_point startTime;
+		/**
+		 * When the process should be (re)started, if it's not running.
+		 */
+		std::chrono::steady_clock::time_point nextStartTime;
+		std::chrono::steady_clock::duration restartDelay;
+		bool hasStarted;
+	};
+
+	std::vector<std::string> m_command;
+	std::vector<Process> m_processes;
+	size_t m_restartCount;
+	bool m_isShutDown;
+
+	void start(Process& process, std::chrono::steady_clock::time_point now);
+
+	void reap(std::chrono::steady_clock::time_point now);
+};
+
+
+#endif //CYPHESIS_AICLIENTPOOL_H
@@ -23,6 +23,8 @@
 #include "Player.h"
 #include "ExternalMindsConnection.h"
 #include "ExternalMindsManager.h"
+#include "OpJournal.h"
+#include "rules/simulation/ExternalMind.h"
 #include "common/id.h"
 #include "common/debug.h"
 #include "rules/simulation//Inheritance.h"
@@ -239,6 +241,21 @@ void Connection::externalOperation(const Operation& op, Link& link) {
 	cy_debug_print("Connection::externalOperation")
 	//spdlog::info("externalOperation in {}", getId());
 
+	if (OpRecorder::hasInstance()) {
+		//Ops from minds are sent from the id of the mind, which isn't persisted, so the entity is resolved now.
+		std::string entityId;
+		if (!op->isDefaultFrom()) {
+			auto I = m_routers.find(integerId(op->getFrom()));
+			if (I != m_routers.end()) {
+				auto mind = dynamic_cast<ExternalMind*>(I->second.router);
+				if (mind && mind->getEntity()) {
+					entityId = mind->getEntity()->getIdAsString();
+				}
+			}
+		}
+		OpRecorder::instance().record(OpJournalEntry::Source::Client, getIdAsString(), entityId, op);
+	}
+
 	if (op->isDefaultFrom()) {
 		m_operationsQueue.emplace_back(op);
 		if (m_operationsQueue.size() > 1000) {
@@ -23,8 +23,7 @@
 
 #include "common/debug.h"
 #include "rules/simulation/Inheritance.h"
-#include "common/Monitors.h"
-#include "common/Variable.h"
+#include "common/Metrics.h"
 #include "common/type_utils.h"
 
 #include <utility>
@@ -99,7 +98,7 @@ int EntityBuilder::installFactory(const std::string& class_name, const Root& cla
 		return -1;
 	}
 
-	Monitors::instance().watch(fmt::format(R"(created_count{{type="{}"}})", class_name), std::make_unique<Variable<int>>(factory->m_createdCount));
+	factory->m_createdCount = &Metrics::instance().counter("created_count", "Number of entities created, per type.", {{"type", class_name}});
 
 	m_entityFactories.emplace(class_name, std::move(factory));
 
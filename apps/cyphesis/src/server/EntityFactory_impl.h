@@ -36,7 +36,9 @@ template<class T>
 Ref<LocatedEntity> EntityFactory<T>::newEntity(RouterId id,
                                                const Atlas::Objects::Entity::RootEntity& attributes)
 {
-    ++m_createdCount;
+    if (m_createdCount) {
+        m_createdCount->increment();
+    }
     //Important that we create a ref as soon as possible, so we have a positive ref count.
     Ref<T> thing(new T(id));
     initializeEntity(*thing, attributes);
@@ -27,6 +27,7 @@
 #include <string>
 #include "modules/Ref.h"
 #include "rules/simulation/LocatedEntity.h"
+#include "common/Metrics.h"
 
 namespace Atlas {
 namespace Message {
@@ -47,14 +48,14 @@ class ScriptKit;
 class EntityKit {
 protected:
 	EntityKit() : m_type(nullptr),
-				  m_createdCount(0) {
+				  m_createdCount(nullptr) {
 	}
 
 public:
 	/// Inheritance type of this class.
 	TypeNode<LocatedEntity>* m_type;
-	/// Number of times this factory has created an entity
-	int m_createdCount;
+	/// Number of times this factory has created an entity. Set when the factory is installed.
+	Metrics::Counter* m_createdCount;
 
 	virtual ~EntityKit() = default;
 
@@ -19,8 +19,15 @@
 
 #include "ExternalMindsConnection.h"
 
+#include <algorithm>
+
 ExternalMindsConnection::ExternalMindsConnection(Link* link, const std::string& routerId) :
-        m_link(link), m_routerId(routerId)
+        m_link(link),
+        m_routerId(routerId),
+        m_mindCount(0),
+        m_pendingPossessions(0),
+        m_cpuUsage(0),
+        m_hasLoadReport(false)
 {
 }
 
@@ -36,3 +43,56 @@ const std::string& ExternalMindsConnection::getRouterId() const
 {
     return m_routerId;
 }
+
+void ExternalMindsConnection::updateLoad(size_t mindCount, std::chrono::duration<double> cpuTime, std::chrono::steady_clock::time_point now)
+{
+    m_mindCount = mindCount;
+    if (m_lastReport && now > m_lastReport->first) {
+        std::chrono::duration<double> wallTime = now - m_lastReport->first;
+        m_cpuUsage = std::max(0.0, (cpuTime - m_lastReport->second) / wallTime);
+        m_hasLoadReport = true;
+    }
+    m_lastReport = std::make_pair(now, cpuTime);
+}
+
+bool ExternalMindsConnection::hasLoadReport() const
+{
+    return m_hasLoadReport;
+}
+
+size_t ExternalMindsConnection::getMindCount() const
+{
+    return m_mindCount;
+}
+
+double ExternalMindsConnection::getCpuUsage() const
+{
+    return m_cpuUsage;
+}
+
+size_t ExternalMindsConnection::getPendingPossessions() const
+{
+    return m_pendingPossessions;
+}
+
+void ExternalMindsConnection::addPendingPossession()
+{
+    m_pendingPossessions++;
+}
+
+void ExternalMindsConnection::completePendingPossession(bool possessed)
+{
+    if (m_pendingPossessions > 0) {
+        m_pendingPossessions--;
+    }
+    if (possessed) {
+        m_mindCount++;
+    }
+}
+
+void ExternalMindsConnection::removeMind()
+{
+    if (m_mindCount > 0) {
+        m_mindCount--;
+    }
+}
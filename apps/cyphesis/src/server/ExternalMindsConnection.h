@@ -19,10 +19,18 @@
 #ifndef EXTERNALMINDSCONNECTION_H_
 #define EXTERNALMINDSCONNECTION_H_
 
+#include <chrono>
+#include <optional>
 #include <string>
 
 class Link;
 
+/**
+ * A connection to an external AI client which has registered itself as able to possess minds.
+ *
+ * Besides the link to the client this keeps track of the load the client reports, which is used
+ * to decide which client should be asked to possess new minds.
+ */
 class ExternalMindsConnection
 {
     public:
@@ -33,10 +41,55 @@ class ExternalMindsConnection
         Link* getLink() const;
         const std::string& getRouterId() const;
 
+        /**
+         * Updates the load as reported by the client.
+         *
+         * @param mindCount The number of minds the client is running.
+         * @param cpuTime The total CPU time the client process has used since it started.
+         * @param now The time of the report.
+         */
+        void updateLoad(size_t mindCount, std::chrono::duration<double> cpuTime, std::chrono::steady_clock::time_point now);
+
+        /**
+         * @return True if the client has reported its load at least twice, so that its CPU usage is known.
+         */
+        bool hasLoadReport() const;
+
+        /**
+         * @return The number of minds, as last reported by the client or as since updated through possessions.
+         */
+        size_t getMindCount() const;
+
+        /**
+         * @return The fraction of one core which the client used between its two last reports.
+         */
+        double getCpuUsage() const;
+
+        /**
+         * @return The number of possession requests sent to the client, which haven't yet resulted in a mind.
+         */
+        size_t getPendingPossessions() const;
+
+        void addPendingPossession();
+
+        /**
+         * Call when a possession request sent to this client either resulted in a mind or was abandoned.
+         * @param possessed True if the client now runs a mind for the entity.
+         */
+        void completePendingPossession(bool possessed);
+
+        void removeMind();
+
     private:
 
         Link* m_link;
         std::string m_routerId;
+
+        size_t m_mindCount;
+        size_t m_pendingPossessions;
+        double m_cpuUsage;
+        std::optional<std::pair<std::chrono::steady_clock::time_point, std::chrono::duration<double>>> m_lastReport;
+        bool m_hasLoadReport;
 };
 
 #endif /* EXTERNALMINDSCONNECTION_H_ */
@@ -20,13 +20,16 @@
 #include "ExternalMindsManager.h"
 #include "PossessionAuthenticator.h"
 
+#include "common/AtlasFactories.h"
 #include "common/Link.h"
 #include "common/operations/Possess.h"
+#include "common/operations/Think.h"
 #include "common/log.h"
 #include "common/debug.h"
 #include "rules/simulation/LocatedEntity.h"
 
 #include <Atlas/Objects/Entity.h>
+#include <Atlas/Objects/Operation.h>
 
 #include <wfmath/MersenneTwister.h>
 
@@ -36,6 +39,19 @@
 
 static constexpr auto debug_flag = false;
 
+namespace {
+    /**
+     * A connection using more than this fraction of a core is considered overloaded, if there are other
+     * connections with less load.
+     */
+    constexpr double overloadedCpuUsage = 0.8;
+
+    /**
+     * If a mind hasn't been possessed again within this time, we'll consider the migration failed.
+     */
+    constexpr auto migrationTimeout = std::chrono::seconds(60);
+}
+
 ExternalMindsManager::ExternalMindsManager(PossessionAuthenticator& possessionAuthenticator)
         : m_possessionAuthenticator(possessionAuthenticator)
 {}
@@ -77,6 +93,27 @@ int ExternalMindsManager::removeConnection(const std::string& routerId)
         spdlog::info("Deregistered external mind connection registered for router {}. "
                 "There are now {} connections.", routerId,
                 m_connections.size());
+
+        //Any possession requests which were sent to the connection will never be answered, so ask another connection.
+        std::vector<std::string> unansweredEntityIds;
+        for (auto I = m_possessionRequests.begin(); I != m_possessionRequests.end();) {
+            if (I->second == routerId) {
+                unansweredEntityIds.push_back(I->first);
+                I = m_possessionRequests.erase(I);
+            } else {
+                ++I;
+            }
+        }
+        for (auto I = m_possessingConnections.begin(); I != m_possessingConnections.end();) {
+            if (I->second == routerId) {
+                I = m_possessingConnections.erase(I);
+            } else {
+                ++I;
+            }
+        }
+        for (auto& entityId : unansweredEntityIds) {
+            requestPossessionFromRegisteredClients(entityId);
+        }
         return 0;
     }
 }
@@ -120,16 +157,102 @@ void ExternalMindsManager::removeRequest(LocatedEntity& character)
     m_unpossessedEntities.erase(&character);
 }
 
+int ExternalMindsManager::updateLoad(const std::string& routerId,
+        size_t mindCount,
+        std::chrono::duration<double> cpuTime,
+        std::chrono::steady_clock::time_point now)
+{
+    auto I = m_connections.find(routerId);
+    if (I == m_connections.end()) {
+        spdlog::warn("Got load report for router {} for which there's no connection registered.", routerId);
+        return -1;
+    }
+    I->second.updateLoad(mindCount, cpuTime, now);
+    cy_debug_print(fmt::format("Router {} reports {} minds using {} of a core.",
+            routerId, mindCount, I->second.getCpuUsage()));
+    return 0;
+}
+
+void ExternalMindsManager::storeThoughts(const std::string& entityId, std::vector<Atlas::Message::Element> thoughts)
+{
+    m_pendingThoughts[entityId] = std::move(thoughts);
+}
+
+double ExternalMindsManager::getAverageCpuPerMind() const
+{
+    double cpuUsage = 0;
+    size_t minds = 0;
+    for (auto& entry : m_connections) {
+        if (entry.second.hasLoadReport()) {
+            cpuUsage += entry.second.getCpuUsage();
+            minds += entry.second.getMindCount();
+        }
+    }
+    if (minds == 0) {
+        return 0;
+    }
+    return cpuUsage / (double) minds;
+}
+
+double ExternalMindsManager::getProjectedLoad(const ExternalMindsConnection& connection, double cpuPerMind)
+{
+    if (!connection.hasLoadReport()) {
+        return (double) (connection.getMindCount() + connection.getPendingPossessions()) * cpuPerMind;
+    }
+    auto connectionCpuPerMind = connection.getMindCount() == 0 ? cpuPerMind : connection.getCpuUsage() / (double) connection.getMindCount();
+    return connection.getCpuUsage() + (double) connection.getPendingPossessions() * connectionCpuPerMind;
+}
+
+ExternalMindsConnection* ExternalMindsManager::selectConnection(const std::string& entity_id)
+{
+    //A migrated mind shouldn't end up on the connection it was migrated away from, unless there's no other connection.
+    std::string excludedRouterId;
+    auto migrationI = m_migrations.find(entity_id);
+    if (migrationI != m_migrations.end() && m_connections.size() > 1) {
+        excludedRouterId = migrationI->second.fromRouterId;
+    }
+
+    auto cpuPerMind = getAverageCpuPerMind();
+    ExternalMindsConnection* selected = nullptr;
+    //If the projected loads are equal (as they are before any loads are reported) select by the number of minds.
+    std::pair<double, size_t> selectedLoad;
+    for (auto& entry : m_connections) {
+        if (entry.first == excludedRouterId) {
+            continue;
+        }
+        auto& connection = entry.second;
+        std::pair<double, size_t> load{getProjectedLoad(connection, cpuPerMind),
+                                       connection.getMindCount() + connection.getPendingPossessions()};
+        if (!selected || load < selectedLoad) {
+            selected = &connection;
+            selectedLoad = load;
+        }
+    }
+    return selected;
+}
+
+void ExternalMindsManager::cancelPossessionRequest(const std::string& entity_id)
+{
+    auto I = m_possessionRequests.find(entity_id);
+    if (I != m_possessionRequests.end()) {
+        auto connectionI = m_connections.find(I->second);
+        if (connectionI != m_connections.end()) {
+            connectionI->second.completePendingPossession(false);
+        }
+        m_possessionRequests.erase(I);
+    }
+}
+
 
 int ExternalMindsManager::requestPossessionFromRegisteredClients(const std::string& entity_id)
 {
     if (!m_connections.empty()) {
         auto result = m_possessionAuthenticator.getPossessionKey(entity_id);
         if (result) {
-            //Use the last one registered.
-            //TODO: implement a better way to select the connection to use. Should we rotate the connections?
-            //Or do some kind of selection?
-            ExternalMindsConnection& connection = m_connections.rbegin()->second;
+            //Any earlier request for the entity won't be answered now.
+            cancelPossessionRequest(entity_id);
+
+            ExternalMindsConnection& connection = *selectConnection(entity_id);
 
             Atlas::Objects::Operation::Possess possessOp;
 
@@ -146,6 +269,8 @@ int ExternalMindsManager::requestPossessionFromRegisteredClients(const std::stri
                     connection.getRouterId()));
 
             connection.getLink()->send(possessOp);
+            connection.addPendingPossession();
+            m_possessionRequests[entity_id] = connection.getRouterId();
             return 0;
         }
         return -1;
@@ -158,12 +283,35 @@ void ExternalMindsManager::entity_destroyed(LocatedEntity& entity)
 {
     m_unpossessedEntities.erase(&entity);
     m_possessedEntities.erase(&entity);
+
+    auto entityId = entity.getIdAsString();
+    cancelPossessionRequest(entityId);
+    auto I = m_possessingConnections.find(entityId);
+    if (I != m_possessingConnections.end()) {
+        auto connectionI = m_connections.find(I->second);
+        if (connectionI != m_connections.end()) {
+            connectionI->second.removeMind();
+        }
+        m_possessingConnections.erase(I);
+    }
+    m_migrations.erase(entityId);
+    m_pendingThoughts.erase(entityId);
 }
 
 void ExternalMindsManager::entity_mindsChanged(LocatedEntity& entity, const MindsProperty& mindsProp)
 {
     //If there are no minds controlling the entity we should try to possess it
+    auto entityId = entity.getIdAsString();
     if (mindsProp.getMinds().empty()) {
+        auto I = m_possessingConnections.find(entityId);
+        if (I != m_possessingConnections.end()) {
+            auto connectionI = m_connections.find(I->second);
+            if (connectionI != m_connections.end()) {
+                connectionI->second.removeMind();
+            }
+            m_possessingConnections.erase(I);
+        }
+
         m_possessedEntities.erase(&entity);
         m_unpossessedEntities.insert(&entity);
 
@@ -171,12 +319,113 @@ void ExternalMindsManager::entity_mindsChanged(LocatedEntity& entity, const Mind
         addPossessionEntryForCharacter(entity);
 
         //We'll now check for any registered possessive clients and ask them for possession of the newly unpossessed character.
-        requestPossessionFromRegisteredClients(entity.getIdAsString());
+        requestPossessionFromRegisteredClients(entityId);
     } else {
         //Mark that the entity now is possessed (although it might not be by us).
         m_unpossessedEntities.erase(&entity);
         m_possessedEntities.insert(&entity);
 
+        auto I = m_possessionRequests.find(entityId);
+        if (I != m_possessionRequests.end()) {
+            auto connectionI = m_connections.find(I->second);
+            if (connectionI != m_connections.end()) {
+                connectionI->second.completePendingPossession(true);
+                m_possessingConnections[entityId] = I->second;
+            }
+            m_possessionRequests.erase(I);
+        }
+        m_migrations.erase(entityId);
+
+        sendPendingThoughts(entity);
+    }
+}
+
+void ExternalMindsManager::sendPendingThoughts(LocatedEntity& entity)
+{
+    auto I = m_pendingThoughts.find(entity.getIdAsString());
+    if (I != m_pendingThoughts.end()) {
+        //The thoughts are restored in the same way as when an entity is created with thoughts.
+        Atlas::Objects::Operation::Set setOp;
+        setOp->setArgsAsList(I->second, &AtlasFactories::factories);
+        Atlas::Objects::Operation::Think thoughtOp;
+        thoughtOp->setTo(entity.getIdAsString());
+        thoughtOp->setFrom(entity.getIdAsString());
+        thoughtOp->setArgs1(setOp);
+        m_pendingThoughts.erase(I);
+        entity.sendWorld(thoughtOp);
+    }
+}
+
+bool ExternalMindsManager::rebalance(std::chrono::steady_clock::time_point now)
+{
+    for (auto I = m_migrations.begin(); I != m_migrations.end();) {
+        if (now - I->second.startTime > migrationTimeout) {
+            spdlog::warn("Migration of mind for entity {} away from router {} timed out.", I->first, I->second.fromRouterId);
+            I = m_migrations.erase(I);
+        } else {
+            ++I;
+        }
+    }
+    if (!m_migrations.empty()) {
+        return false;
+    }
+
+    auto cpuPerMind = getAverageCpuPerMind();
+    ExternalMindsConnection* mostLoaded = nullptr;
+    ExternalMindsConnection* leastLoaded = nullptr;
+    double mostLoad = 0;
+    double leastLoad = 0;
+    for (auto& entry : m_connections) {
+        auto& connection = entry.second;
+        //Don't do anything until all connections have reported their load.
+        if (!connection.hasLoadReport()) {
+            return false;
+        }
+        auto load = getProjectedLoad(connection, cpuPerMind);
+        if (!mostLoaded || load > mostLoad) {
+            mostLoaded = &connection;
+            mostLoad = load;
+        }
+        if (!leastLoaded || load < leastLoad) {
+            leastLoaded = &connection;
+            leastLoad = load;
+        }
+    }
+
+    if (!mostLoaded || mostLoaded == leastLoaded || mostLoaded->getCpuUsage() < overloadedCpuUsage || mostLoaded->getMindCount() < 2) {
+        return false;
+    }
+
+    //Only migrate if moving one mind would actually even out the load, instead of just moving the overload elsewhere.
+    auto cpuPerMovedMind = mostLoaded->getCpuUsage() / (double) mostLoaded->getMindCount();
+    if (mostLoad - leastLoad <= cpuPerMovedMind * 2) {
+        return false;
+    }
+
+    for (auto& entry : m_possessingConnections) {
+        if (entry.second == mostLoaded->getRouterId()) {
+            auto& entityId = entry.first;
+            spdlog::info("Router {} is overloaded, using {} of a core for {} minds, while router {} is using {}. "
+                         "Migrating mind of entity {}.",
+                    mostLoaded->getRouterId(), mostLoaded->getCpuUsage(), mostLoaded->getMindCount(),
+                    leastLoaded->getRouterId(), leastLoaded->getCpuUsage(), entityId);
+
+            //Ask the client to relinquish the mind. It will log out the mind, handing us its thoughts, which
+            //in turn will make us request possession from another connection.
+            Atlas::Objects::Operation::Possess possessOp;
+
+            Atlas::Objects::Entity::Anonymous possess_args;
+            possess_args->setAttr("possess_entity_id", entityId);
+            possess_args->setAttr("relinquish", 1);
+
+            possessOp->setArgs1(possess_args);
+            possessOp->setTo(mostLoaded->getRouterId());
+
+            mostLoaded->getLink()->send(possessOp);
+            m_migrations.emplace(entityId, Migration{mostLoaded->getRouterId(), now});
+            return true;
+        }
     }
+    return false;
 }
 
@@ -21,11 +21,15 @@
 
 #include "ExternalMindsConnection.h"
 
+#include <Atlas/Message/Element.h>
+
 #include <sigc++/trackable.h>
 
+#include <chrono>
 #include <map>
 #include <unordered_set>
 #include <string>
+#include <vector>
 #include <common/Singleton.h>
 
 class LocatedEntity;
@@ -59,17 +63,108 @@ class ExternalMindsManager : public virtual sigc::trackable, public Singleton<Ex
 
         void removeRequest(LocatedEntity& character);
 
+        /**
+         * Updates the load reported by a registered external minds connection.
+         *
+         * The load is used when deciding which connection should be asked to possess a character.
+         *
+         * @param routerId The router id of the connection.
+         * @param mindCount The number of minds the client is running.
+         * @param cpuTime The total CPU time used by the client process.
+         * @param now The time of the report.
+         * @return 0 if successful, -1 if no connection is registered for the router.
+         */
+        int updateLoad(const std::string& routerId,
+                size_t mindCount,
+                std::chrono::duration<double> cpuTime,
+                std::chrono::steady_clock::time_point now);
+
+        /**
+         * Stores the thoughts of a mind which has been relinquished as part of a migration.
+         *
+         * The thoughts are handed to the next mind which possesses the character.
+         * @param entityId The id of the character.
+         * @param thoughts The thoughts, in the same format as used by Think ops.
+         */
+        void storeThoughts(const std::string& entityId, std::vector<Atlas::Message::Element> thoughts);
+
+        /**
+         * Checks if any connection is overloaded compared to the others, and if so asks it to relinquish one of
+         * its minds, so that the character can be possessed by a less loaded connection.
+         *
+         * This should be called periodically. At most one mind is migrated at any time, so that the effect
+         * of a migration shows up in the reported loads before any further migration is done.
+         *
+         * @param now The current time.
+         * @return True if a migration was started.
+         */
+        bool rebalance(std::chrono::steady_clock::time_point now);
+
+        const std::map<std::string, ExternalMindsConnection>& getConnections() const {
+            return m_connections;
+        }
+
     private:
+        struct Migration
+        {
+            /**
+             * The router id of the connection the mind is migrated away from.
+             */
+            std::string fromRouterId;
+            std::chrono::steady_clock::time_point startTime;
+        };
+
         PossessionAuthenticator& m_possessionAuthenticator;
         std::map<std::string, ExternalMindsConnection> m_connections;
         std::unordered_set<LocatedEntity*> m_unpossessedEntities;
         std::unordered_set<LocatedEntity*> m_possessedEntities;
 
+        /**
+         * Possession requests which haven't yet resulted in a mind, with the entity id as key and the router id
+         * of the connection asked as value.
+         */
+        std::map<std::string, std::string> m_possessionRequests;
+
+        /**
+         * Entities possessed through requests made by us, with the entity id as key and the router id of the
+         * possessing connection as value.
+         */
+        std::map<std::string, std::string> m_possessingConnections;
+
+        /**
+         * Entities which are being migrated between connections.
+         */
+        std::map<std::string, Migration> m_migrations;
+
+        /**
+         * Thoughts of relinquished minds, waiting to be handed to the next mind possessing the entity.
+         */
+        std::map<std::string, std::vector<Atlas::Message::Element>> m_pendingThoughts;
+
         void entity_destroyed(LocatedEntity& character);
         void entity_mindsChanged(LocatedEntity& character, const MindsProperty& mindsProp);
 
         int requestPossessionFromRegisteredClients(const std::string& character_id);
 
+        /**
+         * Selects the connection which should be asked to possess a character, which is the one with the
+         * lowest projected load.
+         */
+        ExternalMindsConnection* selectConnection(const std::string& entity_id);
+
+        /**
+         * Projects the CPU usage of a connection, including the minds it has been given since it last reported.
+         * @param cpuPerMind The average CPU usage per mind over all connections, used for connections which
+         * haven't yet reported any usage.
+         */
+        static double getProjectedLoad(const ExternalMindsConnection& connection, double cpuPerMind);
+
+        double getAverageCpuPerMind() const;
+
+        void cancelPossessionRequest(const std::string& entity_id);
+
+        void sendPendingThoughts(LocatedEntity& entity);
+
         void addPossessionEntryForCharacter(LocatedEntity& character);
 
 
@@ -89,6 +89,19 @@ public:
 
 	int teleportEntity(const LocatedEntity*);
 
+	const std::string& getHost() const {
+		return m_host;
+	}
+
+	int getPort() const {
+		return m_port;
+	}
+
+	/// \brief The peer connection, if connected
+	Peer* getPeer() const {
+		return m_peer;
+	}
+
 	void setConnection(Connection* connection) override;
 
 	Connection* getConnection() const override;
@@ -0,0 +1,122 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "OpJournal.h"
+
+#include <Atlas/Codecs/Binary.h>
+#include <Atlas/Message/MEncoder.h>
+#include <Atlas/Objects/RootOperation.h>
+
+#include <fmt/format.h>
+
+#include <array>
+
+using Atlas::Message::Element;
+using Atlas::Message::MapType;
+
+OpRecorder::OpRecorder(const std::filesystem::path& path)
+		: m_file(path, std::ios::binary | std::ios::trunc),
+		  m_codec(std::make_unique<Atlas::Codecs::Binary>(m_unused, m_file, m_unusedDecoder)),
+		  m_start(std::chrono::steady_clock::now()),
+		  m_entryCount(0) {
+	if (!m_file) {
+		throw std::runtime_error(fmt::format("Could not open operations journal {}.", path.string()));
+	}
+	m_file.write(header.data(), static_cast<std::streamsize>(header.size()));
+	m_codec->streamBegin();
+}
+
+OpRecorder::~OpRecorder() {
+	m_codec->streamEnd();
+	m_file.flush();
+}
+
+void OpRecorder::record(OpJournalEntry::Source source, const std::string& connectionId, const std::string& entityId, const Operation& op) {
+	auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start);
+	MapType entry{
+			{"t",  time.count()},
+			{"s",  static_cast<int>(source)},
+			{"op", op->asMessage()}
+	};
+	if (!connectionId.empty()) {
+		entry.emplace("c", connectionId);
+	}
+	if (!entityId.empty()) {
+		entry.emplace("e", entityId);
+	}
+	Atlas::Message::Encoder encoder(*m_codec);
+	encoder.streamMessageElement(entry);
+	m_entryCount++;
+}
+
+void OpRecorder::flush() {
+	m_file.flush();
+}
+
+OpJournalReader::OpJournalReader(const std::filesystem::path& path)
+		: m_file(path, std::ios::binary),
+		  m_codec(std::make_unique<Atlas::Codecs::Binary>(m_buffer, m_unused, m_decoder)) {
+	if (!m_file) {
+		throw std::runtime_error(fmt::format("Could not open operations journal {}.", path.string()));
+	}
+	std::string header(OpRecorder::header.size(), '\0');
+	m_file.read(header.data(), static_cast<std::streamsize>(header.size()));
+	if (!m_file || header != OpRecorder::header) {
+		throw std::runtime_error(fmt::format("{} isn't an operations journal.", path.string()));
+	}
+}
+
+OpJournalReader::~OpJournalReader() = default;
+
+std::optional<OpJournalEntry> OpJournalReader::next() {
+	std::array<char, 65536> chunk{};
+	while (m_decoder.queueSize() == 0) {
+		m_file.read(chunk.data(), chunk.size());
+		auto count = m_file.gcount();
+		if (count <= 0) {
+			return {};
+		}
+		//The codec keeps any incomplete element itself, so the buffer only needs to hold the new data.
+		m_buffer.str(std::string(chunk.data(), static_cast<size_t>(count)));
+		m_buffer.clear();
+		m_codec->poll();
+	}
+
+	auto message = m_decoder.popMessage();
+	OpJournalEntry entry{};
+	auto I = message.find("t");
+	if (I != message.end() && I->second.isInt()) {
+		entry.time = std::chrono::microseconds(I->second.Int());
+	}
+	I = message.find("s");
+	if (I != message.end() && I->second.isInt()) {
+		entry.source = static_cast<OpJournalEntry::Source>(I->second.Int());
+	}
+	I = message.find("c");
+	if (I != message.end() && I->second.isString()) {
+		entry.connectionId = I->second.String();
+	}
+	I = message.find("e");
+	if (I != message.end() && I->second.isString()) {
+		entry.entityId = I->second.String();
+	}
+	I = message.find("op");
+	if (I != message.end() && I->second.isMap()) {
+		entry.op = std::move(I->second.Map());
+	}
+	return entry;
+}
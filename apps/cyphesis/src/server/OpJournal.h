@@ -0,0 +1,134 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef CYPHESIS_OPJOURNAL_H
+#define CYPHESIS_OPJOURNAL_H
+
+#include "common/OperationRouter.h"
+#include "common/Singleton.h"
+
+#include <Atlas/Message/Element.h>
+#include <Atlas/Message/QueuedDecoder.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+
+namespace Atlas::Codecs {
+class Binary;
+}
+
+/**
+ * An operation recorded in a journal.
+ */
+struct OpJournalEntry {
+	enum class Source {
+		/**
+		 * Received from a client or a mind, through a Connection.
+		 */
+		Client = 0,
+		/**
+		 * Dispatched by the world.
+		 */
+		World = 1
+	};
+
+	/**
+	 * When the operation was recorded, relative to the start of the recording.
+	 */
+	std::chrono::microseconds time;
+	Source source;
+	/**
+	 * The connection the operation was received through, for client operations.
+	 */
+	std::string connectionId;
+	/**
+	 * The entity controlled by the mind which sent the operation, for client operations sent by minds.
+	 *
+	 * Minds use ids of their own which aren't persisted, so the entity is resolved when recording.
+	 */
+	std::string entityId;
+	Atlas::Message::MapType op;
+};
+
+/**
+ * Records operations to a journal file, so that the traffic of a running server can be replayed later (see OpReplayer).
+ *
+ * The journal starts with a short header, followed by one message per operation encoded with the binary Atlas codec.
+ * Since the codec keeps a dictionary of names and types, repeated operations take up little space.
+ */
+class OpRecorder : public Singleton<OpRecorder> {
+public:
+	/**
+	 * @throws std::runtime_error If the file couldn't be opened.
+	 */
+	explicit OpRecorder(const std::filesystem::path& path);
+
+	~OpRecorder() override;
+
+	void record(OpJournalEntry::Source source, const std::string& connectionId, const std::string& entityId, const Operation& op);
+
+	void flush();
+
+	size_t getEntryCount() const {
+		return m_entryCount;
+	}
+
+	/**
+	 * Written at the start of every journal, and includes the version of the format.
+	 */
+	static constexpr std::string_view header = "CYOPJRN1";
+
+private:
+	std::ofstream m_file;
+	std::istringstream m_unused;
+	Atlas::Message::QueuedDecoder m_unusedDecoder;
+	std::unique_ptr<Atlas::Codecs::Binary> m_codec;
+	std::chrono::steady_clock::time_point m_start;
+	size_t m_entryCount;
+};
+
+/**
+ * Reads a journal written by OpRecorder, one entry at a time.
+ */
+class OpJournalReader {
+public:
+	/**
+	 * @throws std::runtime_error If the file couldn't be opened, or isn't a journal.
+	 */
+	explicit OpJournalReader(const std::filesystem::path& path);
+
+	~OpJournalReader();
+
+	/**
+	 * @return The next entry, or an empty optional if there are no more.
+	 */
+	std::optional<OpJournalEntry> next();
+
+private:
+	std::ifstream m_file;
+	std::stringstream m_buffer;
+	std::ostringstream m_unused;
+	Atlas::Message::QueuedDecoder m_decoder;
+	std::unique_ptr<Atlas::Codecs::Binary> m_codec;
+};
+
+#endif //CYPHESIS_OPJOURNAL_H
@@ -0,0 +1,201 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "OpReplayer.h"
+
+#include "rules/simulation/BaseWorld.h"
+#include "common/operations/Thought.h"
+#include "common/operations/Tick.h"
+#include "common/log.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <sys/resource.h>
+
+using Atlas::Objects::smart_dynamic_cast;
+
+namespace {
+std::chrono::duration<double> getCpuTime() {
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+		   + std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+/**
+ * @return The value at the percentile, in milliseconds.
+ */
+template<typename Duration>
+double percentile(std::vector<Duration> values, double fraction) {
+	if (values.empty()) {
+		return 0;
+	}
+	auto index = static_cast<size_t>(std::ceil(fraction * static_cast<double>(values.size()))) - 1;
+	index = std::min(index, values.size() - 1);
+	std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+	return std::chrono::duration<double, std::milli>(values[index]).count();
+}
+
+template<typename Duration>
+void logPercentiles(const std::string& name, const std::vector<Duration>& values) {
+	spdlog::info("{}: p50 {:.2f} ms, p90 {:.2f} ms, p99 {:.2f} ms, max {:.2f} ms ({} samples)",
+				 name,
+				 percentile(values, 0.5),
+				 percentile(values, 0.9),
+				 percentile(values, 0.99),
+				 percentile(values, 1),
+				 values.size());
+}
+}
+
+OpReplayer::OpReplayer(BaseWorld& world,
+					   Atlas::Objects::Factories& factories,
+					   std::unique_ptr<OpJournalReader> reader,
+					   double speed)
+		: m_world(world),
+		  m_factories(factories),
+		  m_reader(std::move(reader)),
+		  m_speed(speed),
+		  m_startCpuTime(0),
+		  m_cpuTime(0),
+		  m_injectedCount(0),
+		  m_skippedCount(0),
+		  m_isDone(false) {
+	m_dispatchingConnection = m_world.Dispatching.connect([this](const Operation& op) {
+		//The stamp is when the op should have been dispatched; it's updated when delivered.
+		if (op->getClassNo() == Atlas::Objects::Operation::TICK_NO && !op->isDefaultStamp()) {
+			m_tickLags.emplace_back(std::max(std::chrono::milliseconds(0),
+											 m_world.getTimeAsMilliseconds() - std::chrono::milliseconds(static_cast<std::int64_t>(op->getStamp()))));
+		}
+	});
+	m_dispatchedConnection = m_world.Dispatched.connect([this](const Operation& op, std::chrono::steady_clock::duration duration) {
+		auto now = std::chrono::steady_clock::now();
+		auto& stats = m_dispatchStats[op->getParent()];
+		stats.count++;
+		stats.time += duration;
+		auto I = m_pendingOps.find(op.get());
+		if (I != m_pendingOps.end()) {
+			m_opLatencies.emplace_back(now - I->second.due);
+			m_pendingOps.erase(I);
+		}
+	});
+}
+
+OpReplayer::~OpReplayer() {
+	m_dispatchingConnection.disconnect();
+	m_dispatchedConnection.disconnect();
+}
+
+bool OpReplayer::poll(std::chrono::steady_clock::time_point now) {
+	if (m_isDone) {
+		return false;
+	}
+	if (!m_start) {
+		m_start = now;
+		m_startCpuTime = getCpuTime();
+		spdlog::info("Starting replay of operations.");
+	}
+
+	while (true) {
+		if (!m_nextEntry) {
+			m_nextEntry = m_reader->next();
+			if (!m_nextEntry) {
+				break;
+			}
+			if (!m_firstEntryTime) {
+				m_firstEntryTime = m_nextEntry->time;
+			}
+		}
+		auto due = now;
+		if (m_speed > 0) {
+			due = *m_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					std::chrono::duration<double, std::micro>(m_nextEntry->time - *m_firstEntryTime) / m_speed);
+			if (due > now) {
+				return true;
+			}
+		} else if (m_pendingOps.size() >= maxPendingOps) {
+			return true;
+		}
+		inject(*m_nextEntry, due);
+		m_nextEntry.reset();
+	}
+
+	//All ops are injected; wait for them to be dispatched. Ops might however be dropped, for example if the entity is destroyed.
+	if (!m_exhaustedTime) {
+		m_exhaustedTime = now;
+	}
+	if (!m_pendingOps.empty() && now - *m_exhaustedTime < drainTimeout) {
+		return true;
+	}
+	m_end = now;
+	m_cpuTime = getCpuTime() - m_startCpuTime;
+	m_isDone = true;
+	m_dispatchingConnection.disconnect();
+	m_dispatchedConnection.disconnect();
+	return false;
+}
+
+void OpReplayer::inject(const OpJournalEntry& entry, std::chrono::steady_clock::time_point due) {
+	//The world ops are generated again by the replay.
+	if (entry.source != OpJournalEntry::Source::Client) {
+		return;
+	}
+	auto op = smart_dynamic_cast<Operation>(m_factories.createObject(entry.op));
+	//Only ops sent by minds to their characters are replayed. Responses to relayed ops and Get ops are handled by the mind itself, outside the world.
+	if (entry.entityId.empty() || !op.isValid() || !op->isDefaultRefno() || op->getClassNo() == Atlas::Objects::Operation::GET_NO) {
+		m_skippedCount++;
+		return;
+	}
+	auto entity = m_world.getEntity(entry.entityId);
+	if (!entity || entity->isDestroyed()) {
+		m_skippedCount++;
+		return;
+	}
+
+	//This is what ExternalMind does with ops from minds.
+	Atlas::Objects::Operation::Thought thought;
+	thought->setTo(entity->getIdAsString());
+	thought->setFrom(entity->getIdAsString());
+	thought->setArgs1(op);
+	m_pendingOps.emplace(thought.get(), PendingOp{thought, due});
+	m_world.message(thought, *entity);
+	m_injectedCount++;
+}
+
+void OpReplayer::report() const {
+	auto wallTime = std::chrono::duration<double>(m_end - m_start.value_or(m_end));
+	spdlog::info("Replayed {} operations ({} skipped) in {:.2f} seconds, using {:.2f} seconds of CPU.",
+				 m_injectedCount, m_skippedCount, wallTime.count(), m_cpuTime.count());
+	logPercentiles("Operation latency", m_opLatencies);
+	logPercentiles("Tick lag", m_tickLags);
+
+	std::vector<std::pair<std::string, DispatchStats>> stats(m_dispatchStats.begin(), m_dispatchStats.end());
+	std::sort(stats.begin(), stats.end(), [](const auto& lhs, const auto& rhs) { return lhs.second.time > rhs.second.time; });
+	std::chrono::duration<double> dispatchTime(0);
+	spdlog::info("Time spent dispatching operations, by type:");
+	for (auto& entry: stats) {
+		std::chrono::duration<double> time = entry.second.time;
+		dispatchTime += time;
+		spdlog::info("  {}: {} ops, {:.3f} s ({:.1f}% of CPU)",
+					 entry.first, entry.second.count, time.count(),
+					 m_cpuTime.count() > 0 ? time.count() / m_cpuTime.count() * 100.0 : 0.0);
+	}
+	spdlog::info("  outside of dispatching: {:.3f} s", std::max(0.0, m_cpuTime.count() - dispatchTime.count()));
+}
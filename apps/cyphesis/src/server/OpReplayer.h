@@ -0,0 +1,147 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef CYPHESIS_OPREPLAYER_H
+#define CYPHESIS_OPREPLAYER_H
+
+#include "OpJournal.h"
+
+#include <Atlas/Objects/Factories.h>
+
+#include <sigc++/connection.h>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class BaseWorld;
+
+/**
+ * Replays the client operations of a journal written by OpRecorder into the world, and measures how the server copes.
+ *
+ * The world is expected to have been restored from a snapshot taken when the recording started, so that the entities
+ * the operations refer to exist. Operations sent by minds and clients to their characters are injected into the world
+ * the same way ExternalMind does, as Thought operations; operations handled by accounts and connections (logins, character
+ * creation and the like) are skipped, as are the world operations in the journal, since those are generated again by the replay.
+ *
+ * Call poll() periodically until it returns false, then report().
+ */
+class OpReplayer {
+public:
+	/**
+	 * @param speed How fast to replay, relative to the recording. Zero or less replays as fast as the world can keep up.
+	 */
+	OpReplayer(BaseWorld& world,
+			   Atlas::Objects::Factories& factories,
+			   std::unique_ptr<OpJournalReader> reader,
+			   double speed);
+
+	~OpReplayer();
+
+	/**
+	 * Injects any operations which are due.
+	 * @return False once all operations have been injected and dispatched.
+	 */
+	bool poll(std::chrono::steady_clock::time_point now);
+
+	/**
+	 * Logs the measurements of the replay.
+	 */
+	void report() const;
+
+	size_t getInjectedCount() const {
+		return m_injectedCount;
+	}
+
+	size_t getSkippedCount() const {
+		return m_skippedCount;
+	}
+
+	/**
+	 * When replaying as fast as possible, injection pauses when this many operations are waiting to be dispatched.
+	 */
+	static constexpr size_t maxPendingOps = 200;
+
+	/**
+	 * Once all operations are injected, the replay waits at most this long for them to be dispatched.
+	 */
+	static constexpr std::chrono::seconds drainTimeout{10};
+
+private:
+	BaseWorld& m_world;
+	Atlas::Objects::Factories& m_factories;
+	std::unique_ptr<OpJournalReader> m_reader;
+	double m_speed;
+
+	std::optional<OpJournalEntry> m_nextEntry;
+	std::optional<std::chrono::microseconds> m_firstEntryTime;
+	std::optional<std::chrono::steady_clock::time_point> m_start;
+	std::optional<std::chrono::steady_clock::time_point> m_exhaustedTime;
+	std::chrono::steady_clock::time_point m_end;
+	std::chrono::duration<double> m_startCpuTime;
+	std::chrono::duration<double> m_cpuTime;
+
+	struct PendingOp {
+		/**
+		 * Held so that the operation isn't freed if it's dropped without being dispatched, as its address could then be
+		 * reused by another operation which would be mistaken for it.
+		 */
+		Operation op;
+		/**
+		 * When the operation should have been dispatched.
+		 */
+		std::chrono::steady_clock::time_point due;
+	};
+
+	/**
+	 * Injected operations not yet dispatched, keyed by their address.
+	 */
+	std::unordered_map<const void*, PendingOp> m_pendingOps;
+
+	size_t m_injectedCount;
+	size_t m_skippedCount;
+	bool m_isDone;
+
+	/**
+	 * Time from when injected operations were due until they had been dispatched.
+	 */
+	std::vector<std::chrono::steady_clock::duration> m_opLatencies;
+	/**
+	 * How late Tick operations were dispatched compared to when they were scheduled, which shows how well the world keeps up.
+	 */
+	std::vector<std::chrono::milliseconds> m_tickLags;
+
+	struct DispatchStats {
+		size_t count;
+		std::chrono::steady_clock::duration time;
+	};
+	/**
+	 * Time spent dispatching operations, by operation type.
+	 */
+	std::map<std::string, DispatchStats> m_dispatchStats;
+
+	sigc::connection m_dispatchingConnection;
+	sigc::connection m_dispatchedConnection;
+
+	void inject(const OpJournalEntry& entry, std::chrono::steady_clock::time_point due);
+};
+
+#endif //CYPHESIS_OPREPLAYER_H
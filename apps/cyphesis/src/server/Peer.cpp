@@ -41,6 +41,24 @@ using Atlas::Objects::Operation::Delete;
 using Atlas::Objects::Operation::Logout;
 using Atlas::Objects::Entity::Anonymous;
 
+namespace {
+/**
+ * Adds all entities contained in the entity, parents before their children.
+ */
+void addContained(const LocatedEntity& entity, std::vector<Root>& args, std::vector<long>& ids) {
+	if (!entity.m_contains) {
+		return;
+	}
+	for (auto& child: *entity.m_contains) {
+		Anonymous child_repr;
+		child->addToEntity(child_repr);
+		args.push_back(child_repr);
+		ids.push_back(child->getIdAsInt());
+		addContained(*child, args, ids);
+	}
+}
+}
+
 /// \brief Constructor
 ///
 /// @param client the client socket used to connect to the peer.
@@ -128,6 +146,8 @@ void Peer::operation(const Operation& op, OpVector& res) {
 
 /// \brief Teleport an entity to the connected peer
 ///
+/// Everything contained in the entity is sent along with it, as further
+/// arguments after any possess key, with parents before their children.
 /// @param ent The entity to be teleported
 /// @return Returns 0 on success and -1 on failure
 int Peer::teleportEntity(const LocatedEntity* ent) {
@@ -182,6 +202,14 @@ int Peer::teleportEntity(const LocatedEntity* ent) {
 		std::vector<Root>& create_args = op->modifyArgs();
 		create_args.push_back(key_arg);
 	}
+
+	std::vector<long> contained;
+	addContained(*ent, op->modifyArgs(), contained);
+	if (!contained.empty()) {
+		spdlog::info("Sending {} contained entities along with the entity", contained.size());
+	}
+	s.setContained(std::move(contained));
+
 	this->send(op);
 	spdlog::info("Sent Create op to peer");
 
@@ -267,6 +295,22 @@ void Peer::peerTeleportResponse(const Operation& op, OpVector&) {
 
 	// FIXME Remove from the world cleanly, not delete.
 
+	// The contained entities which were sent along are deleted first, children
+	// before their parents, as anything left in a deleted entity is moved out
+	// into the world.
+	auto& contained = s.getContained();
+	for (auto J = contained.rbegin(); J != contained.rend(); ++J) {
+		auto containedEntity = BaseWorld::instance().getEntity(*J);
+		if (containedEntity) {
+			Delete containedDelOp;
+			Anonymous contained_del_arg;
+			contained_del_arg->setId(containedEntity->getIdAsString());
+			containedDelOp->setArgs1(contained_del_arg);
+			containedDelOp->setTo(containedEntity->getIdAsString());
+			containedEntity->sendWorld(containedDelOp);
+		}
+	}
+
 	// Delete the entity from the current world
 	Delete delOp;
 	Anonymous del_arg;
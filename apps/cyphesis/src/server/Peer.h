@@ -70,6 +70,11 @@ public:
 
 	PeerAuthState getAuthState();
 
+	/// \brief The id of the account we are logged in as on the peer
+	const std::string& getAccountId() const {
+		return m_accountId;
+	}
+
 	void externalOperation(const Operation& op, Link&) override;
 
 	void operation(const Operation&, OpVector&) override;
@@ -34,8 +34,6 @@ class Database;
 
 class LocatedEntity;
 
-typedef std::map<long, Ref<LocatedEntity>> EntityRefDict;
-
 /// \brief Class for managing the required database tables for persisting
 /// in-game entities and server accounts
 class Persistence : public Singleton<Persistence> {
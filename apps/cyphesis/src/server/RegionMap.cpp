@@ -0,0 +1,115 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "RegionMap.h"
+
+#include "common/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+bool Region::contains(const WFMath::Point<3>& pos) const {
+	return pos.x() >= minX && pos.x() < maxX && pos.z() >= minZ && pos.z() < maxZ;
+}
+
+double Region::distance(const WFMath::Point<3>& pos) const {
+	auto dx = std::max({minX - pos.x(), 0.0, pos.x() - maxX});
+	auto dz = std::max({minZ - pos.z(), 0.0, pos.z() - maxZ});
+	return std::sqrt(dx * dx + dz * dz);
+}
+
+std::optional<RegionMap> RegionMap::parse(const std::string& spec) {
+	RegionMap map;
+	std::istringstream stream(spec);
+	std::string entry;
+	while (std::getline(stream, entry, ';')) {
+		if (entry.empty()) {
+			continue;
+		}
+		auto nameEnd = entry.find('=');
+		if (nameEnd == std::string::npos || nameEnd == 0) {
+			spdlog::error("Region '{}' has no name.", entry);
+			return {};
+		}
+		Region region{entry.substr(0, nameEnd), 0, 0, 0, 0, "", 0};
+
+		auto boundsEnd = entry.find('@', nameEnd);
+		std::istringstream bounds(entry.substr(nameEnd + 1, boundsEnd == std::string::npos ? std::string::npos : boundsEnd - nameEnd - 1));
+		char separator1, separator2, separator3;
+		bounds >> region.minX >> separator1 >> region.minZ >> separator2 >> region.maxX >> separator3 >> region.maxZ;
+		if (!bounds || separator1 != ',' || separator2 != ',' || separator3 != ',' || region.minX >= region.maxX || region.minZ >= region.maxZ) {
+			spdlog::error("Region '{}' has malformed bounds.", region.name);
+			return {};
+		}
+
+		if (boundsEnd != std::string::npos) {
+			auto address = entry.substr(boundsEnd + 1);
+			auto portStart = address.rfind(':');
+			if (portStart == std::string::npos || portStart == 0) {
+				spdlog::error("Region '{}' has a malformed peer address.", region.name);
+				return {};
+			}
+			region.host = address.substr(0, portStart);
+			try {
+				region.port = std::stoi(address.substr(portStart + 1));
+			} catch (const std::exception&) {
+				spdlog::error("Region '{}' has a malformed peer port.", region.name);
+				return {};
+			}
+		}
+		if (map.getRegion(region.name)) {
+			spdlog::error("Region '{}' is defined more than once.", region.name);
+			return {};
+		}
+		map.addRegion(std::move(region));
+	}
+	return map;
+}
+
+void RegionMap::addRegion(Region region) {
+	m_regions.emplace_back(std::move(region));
+}
+
+const Region* RegionMap::getRegion(const std::string& name) const {
+	auto I = std::find_if(m_regions.begin(), m_regions.end(), [&](const Region& region) { return region.name == name; });
+	return I == m_regions.end() ? nullptr : &*I;
+}
+
+const Region* RegionMap::findRegion(const WFMath::Point<3>& pos) const {
+	auto I = std::find_if(m_regions.begin(), m_regions.end(), [&](const Region& region) { return region.contains(pos); });
+	return I == m_regions.end() ? nullptr : &*I;
+}
+
+const Region* RegionMap::findOwningRegion(const WFMath::Point<3>& pos) const {
+	auto region = findRegion(pos);
+	if (region) {
+		return region;
+	}
+	auto I = std::min_element(m_regions.begin(), m_regions.end(), [&](const Region& a, const Region& b) { return a.distance(pos) < b.distance(pos); });
+	return I == m_regions.end() ? nullptr : &*I;
+}
+
+std::vector<const Region*> RegionMap::findRegionsNear(const WFMath::Point<3>& pos, double distance) const {
+	std::vector<const Region*> regions;
+	for (auto& region: m_regions) {
+		if (region.contains(pos) || region.distance(pos) <= distance) {
+			regions.push_back(&region);
+		}
+	}
+	return regions;
+}
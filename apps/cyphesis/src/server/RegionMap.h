@@ -0,0 +1,94 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef CYPHESIS_REGIONMAP_H
+#define CYPHESIS_REGIONMAP_H
+
+#include <wfmath/point.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * A rectangular part of the world, in the horizontal (x/z) plane, simulated by one server.
+ */
+struct Region {
+	std::string name;
+	double minX;
+	double minZ;
+	double maxX;
+	double maxZ;
+	/**
+	 * The host of the peer simulating the region. Empty for the region simulated by this server.
+	 */
+	std::string host;
+	int port;
+
+	/**
+	 * Checks if a position is within the region.
+	 * The lower bounds are inclusive and the upper exclusive, so that a position on a shared border belongs to exactly one region.
+	 */
+	bool contains(const WFMath::Point<3>& pos) const;
+
+	/**
+	 * @return The horizontal distance from the position to the closest point in the region, or zero if it's within it.
+	 */
+	double distance(const WFMath::Point<3>& pos) const;
+};
+
+/**
+ * Describes how the world is split spatially between servers.
+ */
+class RegionMap {
+public:
+	/**
+	 * Parses a region specification, in the form "name=minx,minz,maxx,maxz[@host:port];...".
+	 * @param spec The specification.
+	 * @return A map, or an empty optional if the specification is malformed.
+	 */
+	static std::optional<RegionMap> parse(const std::string& spec);
+
+	void addRegion(Region region);
+
+	const Region* getRegion(const std::string& name) const;
+
+	/**
+	 * @return The region containing the position, if any.
+	 */
+	const Region* findRegion(const WFMath::Point<3>& pos) const;
+
+	/**
+	 * @return The region containing the position, or if none does the one closest to it. Null only if there are no regions.
+	 */
+	const Region* findOwningRegion(const WFMath::Point<3>& pos) const;
+
+	/**
+	 * @return All regions within the specified distance of the position, including any containing it.
+	 */
+	std::vector<const Region*> findRegionsNear(const WFMath::Point<3>& pos, double distance) const;
+
+	const std::vector<Region>& getRegions() const {
+		return m_regions;
+	}
+
+private:
+	std::vector<Region> m_regions;
+};
+
+
+#endif //CYPHESIS_REGIONMAP_H
@@ -0,0 +1,351 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "RegionShard.h"
+
+#include "Juncture.h"
+#include "Peer.h"
+#include "ServerRouting.h"
+
+#include "rules/simulation/BaseWorld.h"
+#include "rules/simulation/LocatedEntity.h"
+#include "rules/simulation/MindsProperty.h"
+#include "rules/simulation/ModeProperty.h"
+#include "rules/PhysicalProperties.h"
+#include "common/log.h"
+
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Operation.h>
+
+#include <vector>
+
+using Atlas::Objects::Root;
+using Atlas::Objects::Entity::Anonymous;
+using Atlas::Objects::Operation::Set;
+using Atlas::Objects::Operation::Delete;
+
+namespace {
+/**
+ * Attributes which aren't copied to proxies, either because they describe the structure of the remote world,
+ * or because they would make the proxy behave like a simulated entity.
+ */
+const std::set<std::string> unmirroredAttributes{"id", "parent", "objtype", "loc", "contains", "stamp",
+												 ModeProperty::property_name, "transient"};
+
+/**
+ * The private attribute on the world entity which tells which region it was partitioned for.
+ */
+const std::string regionAttribute = "_region";
+
+/**
+ * Checks if anything contained in the entity is controlled by a mind.
+ */
+bool containsMinds(const LocatedEntity& entity) {
+	if (!entity.m_contains) {
+		return false;
+	}
+	for (auto& child: *entity.m_contains) {
+		auto mindsProp = child->getPropertyClassFixed<MindsProperty>();
+		if ((mindsProp && !mindsProp->getMinds().empty()) || containsMinds(*child)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Deletes the entity along with everything it contains, children first so that nothing is moved out into the world.
+ */
+void deleteSubtree(LocatedEntity& entity) {
+	if (entity.m_contains) {
+		//Copy the children, as deleting them modifies the container.
+		std::vector<Ref<LocatedEntity>> children(entity.m_contains->begin(), entity.m_contains->end());
+		for (auto& child: children) {
+			deleteSubtree(*child);
+		}
+	}
+	BaseWorld::instance().delEntity(&entity);
+}
+
+Juncture* findJuncture(ServerRouting& serverRouting, const Region& region) {
+	for (auto& entry: serverRouting.getObjects()) {
+		auto juncture = dynamic_cast<Juncture*>(entry.second.get());
+		if (juncture && juncture->getHost() == region.host && juncture->getPort() == region.port) {
+			return juncture;
+		}
+	}
+	return nullptr;
+}
+}
+
+RegionShard::JunctureTransport::JunctureTransport(ServerRouting& serverRouting)
+		: m_serverRouting(serverRouting) {
+}
+
+bool RegionShard::JunctureTransport::send(const Region& region, const Operation& op) {
+	auto juncture = findJuncture(m_serverRouting, region);
+	if (!juncture || !juncture->getPeer() || juncture->getPeer()->getAuthState() != PEER_AUTHENTICATED) {
+		return false;
+	}
+	op->setFrom(juncture->getPeer()->getAccountId());
+	juncture->getPeer()->send(op);
+	return true;
+}
+
+bool RegionShard::JunctureTransport::handOff(const Region& region, const LocatedEntity& entity) {
+	auto juncture = findJuncture(m_serverRouting, region);
+	if (!juncture) {
+		return false;
+	}
+	return juncture->teleportEntity(&entity) == 0;
+}
+
+RegionShard::RegionShard(RegionMap regions,
+						 std::string localRegion,
+						 double margin,
+						 Ref<LocatedEntity> root,
+						 std::unique_ptr<Transport> transport)
+		: m_regions(std::move(regions)),
+		  m_localRegion(m_regions.getRegion(localRegion)),
+		  m_margin(margin),
+		  m_root(std::move(root)),
+		  m_transport(std::move(transport)) {
+	if (!m_localRegion) {
+		throw std::runtime_error(fmt::format("Local region '{}' isn't defined.", localRegion));
+	}
+}
+
+size_t RegionShard::partition() {
+	//The world is persisted after being partitioned, so when the server is restarted it only has the entities it was
+	//simulating, and possibly some which have been handed off to it since. Other regions then still have their own
+	//copies, and would claim any entity which needs to move through the normal handoff.
+	auto regionAttr = m_root->getAttr(regionAttribute);
+	if (regionAttr && regionAttr->isString() && regionAttr->String() == m_localRegion->name) {
+		spdlog::info("World was already partitioned for region '{}'.", m_localRegion->name);
+		return 0;
+	}
+
+	std::vector<Ref<LocatedEntity>> droppedEntities;
+	if (m_root->m_contains) {
+		for (auto& child: *m_root->m_contains) {
+			if (child->hasFlags(entity_proxy) || child->hasFlags(entity_ephem)) {
+				continue;
+			}
+			auto posProp = child->getPropertyClassFixed<PositionProperty<LocatedEntity>>();
+			if (!posProp || !posProp->data().isValid()) {
+				continue;
+			}
+			if (m_regions.findOwningRegion(posProp->data()) != m_localRegion) {
+				droppedEntities.emplace_back(child);
+			}
+		}
+	}
+
+	//Entities can't be deleted while iterating over the children of the world.
+	for (auto& entity: droppedEntities) {
+		spdlog::debug("Dropping entity {}, as it's owned by another region.", entity->describeEntity());
+		deleteSubtree(*entity);
+	}
+	spdlog::info("Dropped {} entities owned by other regions.", droppedEntities.size());
+
+	m_root->setAttrValue(regionAttribute, m_localRegion->name);
+	m_root->enqueueUpdateOp();
+	return droppedEntities.size();
+}
+
+void RegionShard::update(std::chrono::steady_clock::time_point now) {
+	for (auto I = m_handOffs.begin(); I != m_handOffs.end();) {
+		if (now - I->second >= handOffTimeout) {
+			spdlog::warn("Handoff of entity {} timed out.", I->first);
+			I = m_handOffs.erase(I);
+		} else {
+			++I;
+		}
+	}
+
+	std::set<long> insideEntities;
+	std::set<long> keptEntities;
+	if (m_root->m_contains) {
+		for (auto& child: *m_root->m_contains) {
+			if (child->hasFlags(entity_proxy) || child->hasFlags(entity_ephem)) {
+				continue;
+			}
+			auto posProp = child->getPropertyClassFixed<PositionProperty<LocatedEntity>>();
+			if (!posProp || !posProp->data().isValid()) {
+				continue;
+			}
+			auto& pos = posProp->data();
+			auto id = child->getIdAsInt();
+
+			if (m_handOffs.count(id)) {
+				insideEntities.insert(id);
+				continue;
+			}
+
+			auto distance = m_localRegion->distance(pos);
+			//A handoff can only carry over the mind of the entity itself, so any entity containing other entities with minds
+			//is kept here instead. It's still mirrored to the region it's in, as that's within the margin.
+			if (distance >= handOffDistance && containsMinds(*child)) {
+				keptEntities.insert(id);
+				if (!m_keptEntities.count(id)) {
+					spdlog::warn("Not handing off entity {}, since it contains entities with minds which can't be handed off along with it.", child->describeEntity());
+				}
+			} else if (distance >= handOffDistance) {
+				auto region = m_regions.findRegion(pos);
+				if (region && region != m_localRegion && m_transport->handOff(*region, *child)) {
+					spdlog::info("Handing off entity {} to region '{}'.", child->describeEntity(), region->name);
+					m_handOffs.emplace(id, now);
+					//The receiving server replaces its proxy with the entity, but any other regions need to remove theirs.
+					auto I = m_mirrors.find(id);
+					if (I != m_mirrors.end()) {
+						for (auto& mirror: I->second) {
+							if (mirror.first != region) {
+								sendProxyRemoval(*mirror.first, id);
+							}
+						}
+						m_mirrors.erase(I);
+					}
+				}
+				//Keep trying until the handoff has started.
+				insideEntities.insert(id);
+				continue;
+			}
+			insideEntities.insert(id);
+
+			std::set<const Region*> nearRegions;
+			for (auto region: m_regions.findRegionsNear(pos, m_margin)) {
+				if (region != m_localRegion) {
+					nearRegions.insert(region);
+				}
+			}
+			auto I = m_mirrors.find(id);
+			if (nearRegions.empty() && I == m_mirrors.end()) {
+				continue;
+			}
+			auto& sent = m_mirrors[id];
+			for (auto region: nearRegions) {
+				auto J = sent.find(region);
+				if ((J == sent.end() || J->second != child->getSeq()) && sendProxy(*region, *child)) {
+					sent[region] = child->getSeq();
+				}
+			}
+			for (auto J = sent.begin(); J != sent.end();) {
+				if (!nearRegions.count(J->first)) {
+					sendProxyRemoval(*J->first, id);
+					J = sent.erase(J);
+				} else {
+					++J;
+				}
+			}
+			if (sent.empty()) {
+				m_mirrors.erase(id);
+			}
+		}
+	}
+
+	m_keptEntities = std::move(keptEntities);
+
+	//Remove proxies of entities which are gone.
+	for (auto I = m_mirrors.begin(); I != m_mirrors.end();) {
+		if (!insideEntities.count(I->first)) {
+			for (auto& mirror: I->second) {
+				sendProxyRemoval(*mirror.first, I->first);
+			}
+			I = m_mirrors.erase(I);
+		} else {
+			++I;
+		}
+	}
+}
+
+bool RegionShard::sendProxy(const Region& region, LocatedEntity& entity) {
+	Anonymous arg;
+	entity.addToEntity(arg);
+	Set set;
+	set->setArgs1(arg);
+	return m_transport->send(region, set);
+}
+
+void RegionShard::sendProxyRemoval(const Region& region, long entityId) {
+	Anonymous arg;
+	arg->setId(std::to_string(entityId));
+	Delete del;
+	del->setArgs1(arg);
+	m_transport->send(region, del);
+}
+
+void RegionShard::proxyOperation(const Operation& op, const std::string& sourceId) {
+	auto& args = op->getArgs();
+	if (args.empty() || args.front()->isDefaultId()) {
+		spdlog::warn("Proxy operation from {} has no entity id.", sourceId);
+		return;
+	}
+	if (op->getClassNo() == Atlas::Objects::Operation::SET_NO) {
+		applyProxy(args.front(), sourceId);
+	} else if (op->getClassNo() == Atlas::Objects::Operation::DELETE_NO) {
+		removeProxy(sourceId, args.front()->getId());
+	}
+}
+
+void RegionShard::applyProxy(const Root& arg, const std::string& sourceId) {
+	Anonymous attrs;
+	for (auto& entry: arg->asMessage()) {
+		//Private attributes shouldn't be exposed through the proxy.
+		if (entry.first.empty() || entry.first.front() == '_' || unmirroredAttributes.count(entry.first)) {
+			continue;
+		}
+		attrs->setAttr(entry.first, entry.second);
+	}
+
+	auto key = std::make_pair(sourceId, arg->getId());
+	auto I = m_proxies.find(key);
+	if (I != m_proxies.end() && !I->second->isDestroyed()) {
+		auto& proxy = *I->second;
+		attrs->setId(proxy.getIdAsString());
+		//Proxies only accept operations from themselves.
+		Set set;
+		set->setTo(proxy.getIdAsString());
+		set->setFrom(proxy.getIdAsString());
+		set->setArgs1(attrs);
+		proxy.sendWorld(set);
+		return;
+	}
+
+	attrs->setLoc(m_root->getIdAsString());
+	//Proxies are never persisted, and are kept in place rather than being simulated.
+	attrs->setAttr("transient", -1);
+	attrs->setAttr(ModeProperty::property_name, "fixed");
+	auto proxy = BaseWorld::instance().addNewEntity(arg->getParent(), attrs);
+	if (!proxy) {
+		spdlog::warn("Could not create proxy of entity {} of type '{}' from {}.", arg->getId(), arg->getParent(), sourceId);
+		return;
+	}
+	proxy->addFlags(entity_proxy);
+	m_proxies[key] = std::move(proxy);
+}
+
+bool RegionShard::removeProxy(const std::string& sourceId, const std::string& entityId) {
+	auto I = m_proxies.find(std::make_pair(sourceId, entityId));
+	if (I == m_proxies.end()) {
+		return false;
+	}
+	if (!I->second->isDestroyed()) {
+		BaseWorld::instance().delEntity(I->second.get());
+	}
+	m_proxies.erase(I);
+	return true;
+}
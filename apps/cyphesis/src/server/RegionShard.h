@@ -0,0 +1,189 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef CYPHESIS_REGIONSHARD_H
+#define CYPHESIS_REGIONSHARD_H
+
+#include "RegionMap.h"
+
+#include "common/OperationRouter.h"
+#include "common/Singleton.h"
+#include "modules/Ref.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+class LocatedEntity;
+
+class ServerRouting;
+
+/**
+ * Simulates one region of a world which is split spatially across several peered servers.
+ *
+ * Entities which come close to the border of a neighbouring region are mirrored to the server simulating that region,
+ * where they appear as read-only proxies (see entity_proxy). When an entity crosses over into a neighbouring region
+ * it's handed off to that server, using the same mechanism as teleports.
+ *
+ * Only the direct children of the world entity are considered, since anything else moves along with its parent.
+ *
+ * Every server is expected to restore the whole world (from its database or a snapshot), and then call partition()
+ * to only keep the entities owned by its own region. The world is then marked as partitioned, so that nothing is
+ * dropped when the server is restarted. From then on every entity in the world is simulated here, including any
+ * created outside of the region, and is handed off once it's outside the region.
+ *
+ * A handoff transfers the entity along with everything it contains, but only the mind of the entity itself can follow
+ * it. An entity containing other entities with minds is therefore never handed off; it's kept here and mirrored to the
+ * region it's in.
+ *
+ * Call update() periodically. Proxy updates received from peers are handled through proxyOperation().
+ */
+class RegionShard : public Singleton<RegionShard> {
+public:
+	/**
+	 * Sends operations to the servers simulating other regions.
+	 */
+	struct Transport {
+		virtual ~Transport() = default;
+
+		/**
+		 * Sends a proxy update to the server simulating the region.
+		 * @return False if the server isn't connected.
+		 */
+		virtual bool send(const Region& region, const Operation& op) = 0;
+
+		/**
+		 * Starts handing off an entity to the server simulating the region.
+		 * @return False if the handoff couldn't be started.
+		 */
+		virtual bool handOff(const Region& region, const LocatedEntity& entity) = 0;
+	};
+
+	/**
+	 * Sends operations through the Juncture connected to the address of each region.
+	 */
+	class JunctureTransport : public Transport {
+	public:
+		explicit JunctureTransport(ServerRouting& serverRouting);
+
+		bool send(const Region& region, const Operation& op) override;
+
+		bool handOff(const Region& region, const LocatedEntity& entity) override;
+
+	private:
+		ServerRouting& m_serverRouting;
+	};
+
+	/**
+	 * @param regions All regions of the world.
+	 * @param localRegion The name of the region simulated by this server.
+	 * @param margin Entities closer than this to a neighbouring region are mirrored to it.
+	 * @param root The world entity.
+	 * @param transport Used to communicate with the servers simulating the other regions.
+	 */
+	RegionShard(RegionMap regions,
+				std::string localRegion,
+				double margin,
+				Ref<LocatedEntity> root,
+				std::unique_ptr<Transport> transport);
+
+	~RegionShard() override = default;
+
+	/**
+	 * Drops all entities owned by other regions, as the servers simulating those regions have their own copies.
+	 *
+	 * An entity is owned by the region it's in, or the closest one if it's outside of them all.
+	 * Nothing is dropped if the world has already been partitioned for this region, as it then only contains the
+	 * entities this server was simulating.
+	 * @return The number of dropped entities.
+	 */
+	size_t partition();
+
+	/**
+	 * Mirrors entities near borders, and hands off entities which have crossed into other regions.
+	 */
+	void update(std::chrono::steady_clock::time_point now);
+
+	/**
+	 * Applies a proxy update (Set) or removal (Delete) sent by a peer.
+	 * @param op The operation, with the id of the mirrored entity in the first argument.
+	 * @param sourceId The id of the account of the peer, as proxies are tracked per peer.
+	 */
+	void proxyOperation(const Operation& op, const std::string& sourceId);
+
+	/**
+	 * Removes the proxy of an entity, which is done when the entity itself is handed off to us.
+	 * @return True if there was a proxy.
+	 */
+	bool removeProxy(const std::string& sourceId, const std::string& entityId);
+
+	size_t getMirroredCount() const {
+		return m_mirrors.size();
+	}
+
+	size_t getProxyCount() const {
+		return m_proxies.size();
+	}
+
+	/**
+	 * An entity must be at least this far outside the local region before being handed off, so that an entity moving along the border doesn't bounce between servers.
+	 */
+	static constexpr double handOffDistance = 2.0;
+
+	/**
+	 * A handoff which hasn't completed within this time is retried.
+	 */
+	static constexpr std::chrono::seconds handOffTimeout{10};
+
+private:
+	RegionMap m_regions;
+	const Region* m_localRegion;
+	double m_margin;
+	Ref<LocatedEntity> m_root;
+	std::unique_ptr<Transport> m_transport;
+
+	/**
+	 * Local entities being mirrored, with the sequence number last sent to each region.
+	 */
+	std::map<long, std::map<const Region*, int>> m_mirrors;
+
+	/**
+	 * Entities which are outside the region but kept here, since they contain entities with minds. Only used to not repeat the warning.
+	 */
+	std::set<long> m_keptEntities;
+
+	/**
+	 * Entities being handed off, with the time the handoff was started.
+	 */
+	std::map<long, std::chrono::steady_clock::time_point> m_handOffs;
+
+	/**
+	 * Proxies of remote entities, keyed by the peer account and the remote entity id.
+	 */
+	std::map<std::pair<std::string, std::string>, Ref<LocatedEntity>> m_proxies;
+
+	bool sendProxy(const Region& region, LocatedEntity& entity);
+
+	void sendProxyRemoval(const Region& region, long entityId);
+
+	void applyProxy(const Atlas::Objects::Root& arg, const std::string& sourceId);
+};
+
+
+#endif //CYPHESIS_REGIONSHARD_H
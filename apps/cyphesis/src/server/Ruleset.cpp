@@ -31,14 +31,23 @@
 #include "rules/simulation/Inheritance.h"
 #include "common/AtlasFileLoader.h"
 #include "common/AssetsManager.h"
+#include "common/AtlasQuery.h"
+#include "rules/simulation/MeshShapeCache.h"
+#include "RulesetCache.h"
 #include "Remotery.h"
 
 
 #include <filesystem>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <chrono>
+#include <thread>
 #include <boost/asio/steady_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/algorithm/string.hpp>
 
 using Atlas::Message::Element;
 using Atlas::Message::MapType;
@@ -50,12 +59,121 @@ typedef std::map<std::string, Root> RootDict;
 
 static constexpr auto debug_flag = false;
 
+namespace {
+long long millisecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Parses rule files, spread out over multiple threads since decoding the XML is what takes most time when loading rules.
+ * The results are merged in the order of the files, so that the outcome is the same as if they had been parsed one by one.
+ * @param failed Set to true if any file couldn't be parsed, or contained objects which couldn't be loaded.
+ * @return The number of rules parsed.
+ */
+int parseRuleFiles(const std::vector<std::filesystem::path>& files, RootDict& rules, bool& failed) {
+	std::vector<RootDict> fileRules(files.size());
+	std::atomic<bool> anyFailed(false);
+	auto& factories = Inheritance::instance().getFactories();
+
+	auto parseFile = [&](std::size_t index) {
+		auto& filename = files[index].native();
+		try {
+			AtlasFileLoader f(factories, filename, fileRules[index]);
+			if (!f.isOpen()) {
+				spdlog::error("Unable to open rule file \"{}\".", filename);
+				anyFailed = true;
+			} else {
+				f.read();
+				if (f.errorCount() > 0) {
+					anyFailed = true;
+				}
+			}
+		} catch (const std::exception& e) {
+			spdlog::error("Error when parsing rule file \"{}\": {}", filename, e.what());
+			anyFailed = true;
+		}
+	};
+
+	auto threadCount = std::min(files.size(), static_cast<std::size_t>(std::max(1u, std::thread::hardware_concurrency())));
+	if (threadCount <= 1) {
+		for (std::size_t i = 0; i < files.size(); ++i) {
+			parseFile(i);
+		}
+	} else {
+		boost::asio::thread_pool pool(threadCount);
+		for (std::size_t i = 0; i < files.size(); ++i) {
+			boost::asio::post(pool, [&parseFile, i]() { parseFile(i); });
+		}
+		pool.join();
+	}
+
+	int count = 0;
+	for (std::size_t i = 0; i < files.size(); ++i) {
+		for (auto& entry: fileRules[i]) {
+			if (rules.find(entry.first) != rules.end()) {
+				spdlog::warn("Duplicate object ID \"{}\" loaded from file {}.", entry.first, files[i].string());
+			}
+			rules[entry.first] = std::move(entry.second);
+			++count;
+		}
+	}
+	failed = anyFailed;
+	return count;
+}
+
+/**
+ * Finds all mesh files referenced by the default "geometry" of the rules, so that they can be loaded up front.
+ * The value is true if the geometry is of the "mesh" type, which means that the BVH will be needed.
+ */
+std::map<std::filesystem::path, bool> collectMeshPaths(const RootDict& rules) {
+	std::map<std::filesystem::path, bool> paths;
+	auto assetsPath = AssetsManager::instance().getAssetsPath();
+	for (auto& entry: rules) {
+		Atlas::Message::Element attributes;
+		if (entry.second->copyAttr("attributes", attributes) != 0) {
+			continue;
+		}
+		AtlasQuery::find<MapType>(attributes, "geometry", [&](const MapType& geometryAttribute) {
+			AtlasQuery::find<MapType>(geometryAttribute, "default", [&](const MapType& geometry) {
+				AtlasQuery::find<std::string>(geometry, "path", [&](const std::string& path) {
+					if (boost::algorithm::ends_with(path, ".mesh")) {
+						bool needsBvh = false;
+						AtlasQuery::find<std::string>(geometry, "type", [&](const std::string& type) {
+							needsBvh = type == "mesh";
+						});
+						auto& value = paths[assetsPath / path];
+						value = value || needsBvh;
+					}
+				});
+			});
+		});
+	}
+	return paths;
+}
+
+/**
+ * Loads all meshes used by the rules concurrently, so that they're ready when the rules are installed.
+ * The returned shapes need to be kept until the rules have been installed.
+ */
+std::vector<std::shared_ptr<MeshShape>> preloadMeshes(const RootDict& rules) {
+	if (!MeshShapeCache::hasInstance()) {
+		return {};
+	}
+	auto paths = collectMeshPaths(rules);
+	if (paths.empty()) {
+		return {};
+	}
+	return MeshShapeCache::instance().preload(paths);
+}
+}
+
 Ruleset::Ruleset(EntityBuilder& eb, boost::asio::io_context& io_context, PropertyManager<LocatedEntity>& propertyManager) :
 		m_entityHandler(new EntityRuleHandler(eb, propertyManager)),
 		m_opHandler(new OpRuleHandler()),
 		m_propertyHandler(new PropertyRuleHandler(propertyManager)),
 		m_archetypeHandler(new ArchetypeRuleHandler(eb, propertyManager)),
-		m_io_context(io_context) {
+		m_io_context(io_context),
+		m_loadTimes{} {
 }
 
 Ruleset::~Ruleset() {
@@ -218,22 +336,17 @@ void Ruleset::processChangedRules() {
 	rmt_ScopedCPUSample(processChangedRules, 0)
 	if (!m_changedRules.empty()) {
 		RootDict updatedRules;
+		std::vector<std::filesystem::path> files;
 		for (auto& path: m_changedRules) {
-			try {
-				spdlog::debug("Reloading rule file {}", path.string());
-				auto& filename = path.native();
-				AtlasFileLoader f(Inheritance::instance().getFactories(), filename, updatedRules);
-				if (!f.isOpen()) {
-					spdlog::error("Unable to open rule file \"{}\".", filename);
-				} else {
-					spdlog::info("Rule file \"{}\" reloaded.", filename);
-					f.read();
-				}
-			} catch (const std::exception& e) {
-				spdlog::error("Error when reacting to changed file at '{}': {}", path.string(), e.what());
+			if (std::filesystem::is_regular_file(path)) {
+				spdlog::info("Reloading rule file \"{}\".", path.string());
+				files.emplace_back(path);
 			}
 		}
+		bool failed;
+		parseRuleFiles(files, updatedRules, failed);
 		if (!updatedRules.empty()) {
+			auto meshes = preloadMeshes(updatedRules);
 			std::map<const TypeNode<LocatedEntity>*, TypeNode<LocatedEntity>::PropertiesUpdate> changes;
 			for (auto& entry: updatedRules) {
 				auto& class_name = entry.first;
@@ -299,31 +412,48 @@ void Ruleset::getRulesFromFiles(std::filesystem::path directory,
 
 		});
 
-		std::filesystem::recursive_directory_iterator dir(directory), end;
 		spdlog::info("Trying to load rules from directory '{}'", directory.string());
 
-		int count = 0;
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::filesystem::path> files;
+		std::filesystem::recursive_directory_iterator dir(directory), end;
 		while (dir != end) {
 			if (std::filesystem::is_regular_file(dir->status())) {
-				auto filename = dir->path().native();
-				AtlasFileLoader f(Inheritance::instance().getFactories(), filename, rules);
-				if (!f.isOpen()) {
-					spdlog::error("Unable to open rule file \"{}\".", filename);
-				} else {
-					f.read();
-					count += f.count();
-				}
+				files.emplace_back(dir->path());
 			}
 			++dir;
 		}
-
-		spdlog::info("Loaded {} rules.", count);
+		//Sort to get the same outcome regardless of the order the file system lists files in.
+		std::sort(files.begin(), files.end());
+		auto signature = RulesetCache::signature(directory, files);
+		m_loadTimes.scan += millisecondsSince(start);
+
+		start = std::chrono::steady_clock::now();
+		RulesetCache cache(std::filesystem::path(var_directory) / "lib" / "cyphesis" / "cache" /
+						   fmt::format("rules-{:016x}.bin", std::hash<std::string>()(directory.string())));
+		if (cache.read(Inheritance::instance().getFactories(), signature, rules)) {
+			m_loadTimes.cache += millisecondsSince(start);
+			spdlog::info("Loaded {} rules from {} files, using cache at '{}'.", rules.size(), files.size(), cache.path().string());
+		} else {
+			bool failed;
+			auto count = parseRuleFiles(files, rules, failed);
+			m_loadTimes.parse += millisecondsSince(start);
+			spdlog::info("Loaded {} rules from {} files.", count, files.size());
+
+			//Don't cache anything incomplete, since the errors then wouldn't be reported on the next start.
+			if (!failed) {
+				start = std::chrono::steady_clock::now();
+				cache.write(signature, rules);
+				m_loadTimes.cache += millisecondsSince(start);
+			}
+		}
 	}
 
 
 }
 
 void Ruleset::loadRules(const std::string& ruleset) {
+	m_loadTimes = {};
 	std::filesystem::path shared_rules_directory = std::filesystem::path(share_directory) / "cyphesis" / "rulesets/" / ruleset / "rules";
 	std::filesystem::path var_rules_directory = std::filesystem::path(var_directory) / "lib" / "cyphesis" / "rulesets" / ruleset / "rules";
 
@@ -345,11 +475,22 @@ void Ruleset::loadRules(const std::string& ruleset) {
 	//Just ignore any changes, since this happens at startup before any clients are connected.
 	std::map<const TypeNode<LocatedEntity>*, TypeNode<LocatedEntity>::PropertiesUpdate> changes;
 
+	auto start = std::chrono::steady_clock::now();
+	auto meshes = preloadMeshes(ruleTable);
+	m_loadTimes.meshes = millisecondsSince(start);
+	spdlog::info("Loaded {} meshes.", meshes.size());
+
+	start = std::chrono::steady_clock::now();
 	for (auto& entry: ruleTable) {
 		const std::string& class_name = entry.first;
 		const Root& class_desc = entry.second;
 		installItem(class_name, class_desc, changes);
 	}
+	m_loadTimes.install = millisecondsSince(start);
+
+	spdlog::info("Rules loaded in {} ms: scanning files {} ms, parsing files {} ms, reading and writing cache {} ms, loading meshes {} ms, installing rules {} ms.",
+				 m_loadTimes.scan + m_loadTimes.parse + m_loadTimes.cache + m_loadTimes.meshes + m_loadTimes.install,
+				 m_loadTimes.scan, m_loadTimes.parse, m_loadTimes.cache, m_loadTimes.meshes, m_loadTimes.install);
 	// Report on the non-cleared rules.
 	// Perhaps we can keep them too?
 	// m_waitingRules.clear();
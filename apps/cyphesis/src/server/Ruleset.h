@@ -80,6 +80,16 @@ protected:
 
 	std::set<boost::asio::steady_timer*> m_reloadTimers;
 
+	/// \brief Time spent in each phase of loading rules, in milliseconds, for reporting.
+	struct LoadTimes {
+		long long scan;
+		long long parse;
+		long long cache;
+		long long meshes;
+		long long install;
+	};
+	LoadTimes m_loadTimes;
+
 	void installItem(const std::string& class_name,
 					 const Atlas::Objects::Root& class_desc,
 					 std::map<const TypeNode<LocatedEntity>*, TypeNode<LocatedEntity>::PropertiesUpdate>& changes);
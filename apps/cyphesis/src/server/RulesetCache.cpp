@@ -0,0 +1,196 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "RulesetCache.h"
+
+#include "common/log.h"
+
+#include <Atlas/Objects/Decoder.h>
+#include <Atlas/Objects/Encoder.h>
+#include <Atlas/Codecs/Binary.h>
+#include <Atlas/Message/QueuedDecoder.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <streambuf>
+
+using Atlas::Objects::Root;
+
+namespace {
+
+/// \brief Placed at the start of the cache file.
+struct CacheHeader {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t count;
+	std::uint64_t signature;
+};
+
+const char CACHE_MAGIC[8] = "CYRULES";
+
+/// \brief Bump whenever the format, or the way rules are parsed, changes.
+constexpr std::uint32_t CACHE_VERSION = 1;
+
+constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+void hash(std::uint64_t& value, const void* data, std::size_t size) {
+	auto bytes = static_cast<const unsigned char*>(data);
+	for (std::size_t i = 0; i < size; ++i) {
+		value = (value ^ bytes[i]) * FNV_PRIME;
+	}
+}
+
+/// \brief Exposes a block of memory as a read only stream buffer.
+class MemoryBuffer : public std::streambuf {
+public:
+	MemoryBuffer(const char* data, std::size_t size) {
+		auto begin = const_cast<char*>(data);
+		setg(begin, begin, begin + size);
+	}
+};
+
+class RuleCollector : public Atlas::Objects::ObjectsDecoder {
+public:
+	RuleCollector(const Atlas::Objects::Factories& factories, std::map<std::string, Root>& rules)
+			: ObjectsDecoder(factories), m_rules(rules) {
+	}
+
+private:
+	std::map<std::string, Root>& m_rules;
+
+	void objectArrived(Root obj) override {
+		auto& id = obj->getId();
+		m_rules.emplace(id, std::move(obj));
+	}
+};
+}
+
+RulesetCache::RulesetCache(std::filesystem::path path)
+		: m_path(std::move(path)) {
+}
+
+std::uint64_t RulesetCache::signature(const std::filesystem::path& directory,
+									  const std::vector<std::filesystem::path>& files) {
+	std::uint64_t value = FNV_OFFSET;
+	hash(value, &CACHE_VERSION, sizeof(CACHE_VERSION));
+	for (auto& file: files) {
+		std::error_code ec;
+		auto name = std::filesystem::relative(file, directory, ec).string();
+		std::uint64_t size = std::filesystem::file_size(file, ec);
+		std::int64_t modified = std::filesystem::last_write_time(file, ec).time_since_epoch().count();
+		hash(value, name.data(), name.size() + 1);
+		hash(value, &size, sizeof(size));
+		hash(value, &modified, sizeof(modified));
+	}
+	return value;
+}
+
+bool RulesetCache::read(const Atlas::Objects::Factories& factories,
+						std::uint64_t signature,
+						std::map<std::string, Root>& rules) const {
+	auto fd = ::open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat fileStat{};
+	if (::fstat(fd, &fileStat) == -1 || static_cast<std::size_t>(fileStat.st_size) < sizeof(CacheHeader)) {
+		::close(fd);
+		return false;
+	}
+	auto size = static_cast<std::size_t>(fileStat.st_size);
+	auto memory = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (memory == MAP_FAILED) {
+		return false;
+	}
+
+	bool success = false;
+	CacheHeader header{};
+	std::memcpy(&header, memory, sizeof(header));
+	if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 && header.version == CACHE_VERSION && header.signature == signature) {
+		try {
+			std::map<std::string, Root> cachedRules;
+			MemoryBuffer buffer(static_cast<const char*>(memory) + sizeof(header), size - sizeof(header));
+			std::istream in(&buffer);
+			std::ostream out(nullptr);
+			RuleCollector collector(factories, cachedRules);
+			Atlas::Codecs::Binary codec(in, out, collector);
+			codec.poll();
+			//A truncated or otherwise damaged cache won't contain all rules.
+			if (cachedRules.size() == header.count) {
+				for (auto& entry: cachedRules) {
+					rules.insert_or_assign(entry.first, std::move(entry.second));
+				}
+				success = true;
+			} else {
+				spdlog::warn("Rule cache at '{}' is damaged; ignoring it.", m_path.string());
+			}
+		} catch (const std::exception& e) {
+			spdlog::warn("Could not read rule cache at '{}': {}", m_path.string(), e.what());
+		}
+	}
+	::munmap(memory, size);
+	return success;
+}
+
+bool RulesetCache::write(std::uint64_t signature,
+						 const std::map<std::string, Root>& rules) const {
+	try {
+		std::filesystem::create_directories(m_path.parent_path());
+		//Write to a temporary file which is then moved in place, so that a server starting at the same time never sees a half written file.
+		auto temporaryPath = m_path;
+		temporaryPath += ".tmp";
+		{
+			std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!out) {
+				return false;
+			}
+			CacheHeader header{};
+			std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+			header.version = CACHE_VERSION;
+			header.count = static_cast<std::uint32_t>(rules.size());
+			header.signature = signature;
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+			std::istream in(nullptr);
+			//Nothing is decoded, so the bridge is never used.
+			Atlas::Message::QueuedDecoder unused;
+			Atlas::Codecs::Binary codec(in, out, unused);
+			Atlas::Objects::ObjectsEncoder encoder(codec);
+			codec.streamBegin();
+			for (auto& entry: rules) {
+				encoder.streamObjectsMessage(entry.second);
+			}
+			codec.streamEnd();
+			out.flush();
+			if (!out) {
+				return false;
+			}
+		}
+		std::filesystem::rename(temporaryPath, m_path);
+		return true;
+	} catch (const std::exception& e) {
+		spdlog::warn("Could not write rule cache at '{}': {}", m_path.string(), e.what());
+		return false;
+	}
+}
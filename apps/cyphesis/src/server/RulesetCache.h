@@ -0,0 +1,67 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef SERVER_RULESET_CACHE_H
+#define SERVER_RULESET_CACHE_H
+
+#include <Atlas/Objects/Root.h>
+#include <Atlas/Objects/Factories.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+/// \brief Stores the rules parsed from a directory of rule files in a compiled form on disk.
+///
+/// The rules are stored with the compact Binary Atlas codec, which is much faster to decode
+/// than the XML in the rule files. The file is memory mapped when read.
+///
+/// The cache is tagged with a signature of the names, sizes and modification times of the
+/// rule files; if any rule file is added, removed or altered the cache won't be used.
+class RulesetCache {
+public:
+	explicit RulesetCache(std::filesystem::path path);
+
+	/// \brief Computes a signature from the names, sizes and modification times of the files.
+	static std::uint64_t signature(const std::filesystem::path& directory,
+								   const std::vector<std::filesystem::path>& files);
+
+	/// \brief Reads the rules, if the cache exists and has a matching signature.
+	///
+	/// @return True if the rules were read.
+	bool read(const Atlas::Objects::Factories& factories,
+			  std::uint64_t signature,
+			  std::map<std::string, Atlas::Objects::Root>& rules) const;
+
+	/// \brief Writes the rules to the cache, replacing anything already there.
+	///
+	/// @return True if the cache could be written.
+	bool write(std::uint64_t signature,
+			   const std::map<std::string, Atlas::Objects::Root>& rules) const;
+
+	const std::filesystem::path& path() const {
+		return m_path;
+	}
+
+private:
+	std::filesystem::path m_path;
+};
+
+#endif // SERVER_RULESET_CACHE_H
@@ -38,18 +38,19 @@ ScriptReloader::ScriptReloader(BaseWorld& world) {
 //            }
 //        }
 
-		auto& entities = world.getEntities();
+		//Scripts might create or destroy entities when applied, so iterate over a snapshot.
+		auto entities = world.getEntities().snapshot();
 
 
 		//Reload all scripts on all entities. This might be improved to only reload affected scripts.
-		for (auto& entry: entities) {
-			auto scriptsProp = entry.second->getPropertyClass<ScriptsProperty>("__scripts");
+		for (auto& entity: entities) {
+			auto scriptsProp = entity->getPropertyClass<ScriptsProperty>("__scripts");
 			if (scriptsProp) {
-				scriptsProp->applyScripts(*entry.second);
+				scriptsProp->applyScripts(*entity);
 			}
-			auto scriptsInstanceProp = entry.second->getPropertyClass<ScriptsProperty>("__scripts_instance");
+			auto scriptsInstanceProp = entity->getPropertyClass<ScriptsProperty>("__scripts_instance");
 			if (scriptsInstanceProp) {
-				scriptsInstanceProp->applyScripts(*entry.second);
+				scriptsInstanceProp->applyScripts(*entity);
 			}
 		}
 
@@ -21,17 +21,22 @@
 #include "ServerRouting.h"
 #include "Connection.h"
 #include "PossessionAuthenticator.h"
+#include "RegionShard.h"
 
 #include "rules/simulation/LocatedEntity.h"
 
 #include "rules/simulation/BaseWorld.h"
 #include "common/debug.h"
+#include "common/const.h"
+#include "common/log.h"
 
 #include <Atlas/Objects/SmartPtr.h>
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Anonymous.h>
 
 #include <iostream>
+#include <map>
+#include <set>
 
 using Atlas::Message::Element;
 using Atlas::Message::MapType;
@@ -47,6 +52,69 @@ using Atlas::Objects::smart_dynamic_cast;
 
 static constexpr auto debug_flag = false;
 
+namespace {
+/**
+ * Checks if an attribute refers to any of the entities through an "$eid" entry.
+ */
+bool refersToAny(const Element& attr, const std::set<std::string>& ids) {
+	if (attr.isMap()) {
+		auto entityRefI = attr.asMap().find("$eid");
+		if (entityRefI != attr.asMap().end() && entityRefI->second.isString() && ids.count(entityRefI->second.asString())) {
+			return true;
+		}
+		for (auto& I: attr.asMap()) {
+			if (refersToAny(I.second, ids)) {
+				return true;
+			}
+		}
+	} else if (attr.isList()) {
+		for (auto& I: attr.asList()) {
+			if (refersToAny(I, ids)) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * Replaces the ids in all "$eid" entries with the ids they're mapped to.
+ */
+void rewriteReferences(Element& attr, const std::map<std::string, std::string>& ids) {
+	if (attr.isMap()) {
+		for (auto& I: attr.asMap()) {
+			if (I.first == "$eid" && I.second.isString()) {
+				auto newIdI = ids.find(I.second.asString());
+				if (newIdI != ids.end()) {
+					I.second = newIdI->second;
+				}
+			} else {
+				rewriteReferences(I.second, ids);
+			}
+		}
+	} else if (attr.isList()) {
+		for (auto& I: attr.asList()) {
+			rewriteReferences(I, ids);
+		}
+	}
+}
+
+/**
+ * Moves the attributes which refer to any of the entities out of the entity data,
+ * as they can't be set until all entities have been created.
+ */
+MapType extractReferences(RootEntity& attrs, const std::set<std::string>& ids) {
+	MapType references;
+	for (auto& entry: attrs->asMessage()) {
+		if (refersToAny(entry.second, ids)) {
+			references.emplace(entry.first, entry.second);
+			attrs->removeAttr(entry.first);
+		}
+	}
+	return references;
+}
+}
+
 /// \brief ServerAccount constructor
 ServerAccount::ServerAccount(Connection* conn,
 							 const std::string& username,
@@ -62,3 +130,128 @@ ServerAccount::ServerAccount(Connection* conn,
 const char* ServerAccount::getType() const {
 	return "server";
 }
+
+/// \brief Accept an entity teleported or handed off from the peer
+///
+/// The first argument is the entity, and an optional second argument holds
+/// the key with which its mind can possess it again once connected here.
+/// Everything contained in the entity follows, with parents before their
+/// children. All entities get new ids, so their locations and any "$eid"
+/// references between them are rewritten to match.
+void ServerAccount::CreateOperation(const Operation& op, OpVector& res) {
+	const std::vector<Root>& args = op->getArgs();
+	if (args.empty()) {
+		error(op, "No arguments.", res, getIdAsString());
+		return;
+	}
+	auto arg = smart_dynamic_cast<RootEntity>(args.front());
+	if (!arg.isValid() || arg->isDefaultParent()) {
+		error(op, "Entity to create is malformed.", res, getIdAsString());
+		return;
+	}
+
+	BaseWorld& world = m_connection->m_server.m_world;
+	auto root = world.getEntity(consts::rootWorldIntId);
+	if (!root) {
+		error(op, "No world to create entity in.", res, getIdAsString());
+		return;
+	}
+
+	std::vector<RootEntity> containedArgs;
+	std::set<std::string> subtreeIds{arg->getId()};
+	for (auto I = args.begin() + 1; I != args.end(); ++I) {
+		auto containedArg = smart_dynamic_cast<RootEntity>(*I);
+		if (containedArg.isValid() && !containedArg->isDefaultParent() && !containedArg->isDefaultId()) {
+			containedArgs.push_back(containedArg);
+			subtreeIds.insert(containedArg->getId());
+		}
+	}
+
+	//Any proxy of the entity is replaced by the entity itself.
+	if (RegionShard::hasInstance()) {
+		RegionShard::instance().removeProxy(getIdAsString(), arg->getId());
+	}
+
+	std::map<std::string, std::string> newIds;
+	std::vector<std::pair<Ref<LocatedEntity>, MapType>> unresolvedAttributes;
+
+	RootEntity attrs = arg.copy();
+	attrs->removeAttrFlag(Atlas::Objects::ID_FLAG);
+	attrs->removeAttr("contains");
+	attrs->setLoc(root->getIdAsString());
+	auto references = extractReferences(attrs, subtreeIds);
+	auto entity = world.addNewEntity(arg->getParent(), attrs);
+	if (!entity) {
+		error(op, "Could not create entity.", res, getIdAsString());
+		return;
+	}
+	cy_debug_print("ServerAccount: created " << entity->describeEntity() << " from peer entity " << arg->getId())
+	newIds.emplace(arg->getId(), entity->getIdAsString());
+	unresolvedAttributes.emplace_back(entity, std::move(references));
+
+	for (auto& containedArg: containedArgs) {
+		auto locI = newIds.find(containedArg->getLoc());
+		if (locI == newIds.end()) {
+			spdlog::warn("Could not create contained entity {}, as its location {} wasn't created.", containedArg->getId(), containedArg->getLoc());
+			continue;
+		}
+		RootEntity containedAttrs = containedArg.copy();
+		containedAttrs->removeAttrFlag(Atlas::Objects::ID_FLAG);
+		containedAttrs->removeAttr("contains");
+		containedAttrs->setLoc(locI->second);
+		auto containedReferences = extractReferences(containedAttrs, subtreeIds);
+		auto containedEntity = world.addNewEntity(containedArg->getParent(), containedAttrs);
+		if (!containedEntity) {
+			spdlog::warn("Could not create contained entity {} of type '{}'.", containedArg->getId(), containedArg->getParent());
+			continue;
+		}
+		newIds.emplace(containedArg->getId(), containedEntity->getIdAsString());
+		unresolvedAttributes.emplace_back(containedEntity, std::move(containedReferences));
+	}
+
+	//References between the entities can only be resolved once they all exist.
+	for (auto& entry: unresolvedAttributes) {
+		for (auto& attr: entry.second) {
+			rewriteReferences(attr.second, newIds);
+			entry.first->setAttrValue(attr.first, attr.second);
+		}
+	}
+
+	if (args.size() > 1 && args[1]->hasAttr("possess_key")) {
+		auto key = args[1]->getAttr("possess_key");
+		if (key.isString()) {
+			PossessionAuthenticator::instance().addPossession(entity->getIdAsString(), key.String());
+		}
+	}
+
+	Anonymous info_arg;
+	entity->addToEntity(info_arg);
+
+	Info info;
+	info->setArgs1(info_arg);
+	info->setTo(op->getFrom());
+	res.push_back(info);
+}
+
+/// \brief Update a proxy of an entity simulated by the peer
+///
+/// Only entity data sent by a RegionShard is treated as a proxy update; any
+/// other Set is handled like on any other account.
+void ServerAccount::SetOperation(const Operation& op, OpVector& res) {
+	if (RegionShard::hasInstance()) {
+		auto& args = op->getArgs();
+		if (!args.empty() && !args.front()->isDefaultId() && !args.front()->isDefaultParent() && args.front()->getId() != getIdAsString()) {
+			RegionShard::instance().proxyOperation(op, getIdAsString());
+			return;
+		}
+	}
+	Account::SetOperation(op, res);
+}
+
+void ServerAccount::OtherOperation(const Operation& op, OpVector& res) {
+	if (op->getClassNo() == Atlas::Objects::Operation::DELETE_NO && RegionShard::hasInstance()) {
+		RegionShard::instance().proxyOperation(op, getIdAsString());
+		return;
+	}
+	Account::OtherOperation(op, res);
+}
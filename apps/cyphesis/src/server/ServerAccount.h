@@ -43,6 +43,12 @@ public:
 
 	const char* getType() const override;
 
+	void CreateOperation(const Operation&, OpVector&) override;
+
+	void SetOperation(const Operation&, OpVector&) override;
+
+	void OtherOperation(const Operation&, OpVector&) override;
+
 	friend class ServerAccounttest;
 };
 
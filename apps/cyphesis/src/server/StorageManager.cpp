@@ -26,11 +26,14 @@
 #include "rules/simulation/WorldRouter.h"
 
 #include "common/Database.h"
+#include "common/const.h"
 #include "common/debug.h"
+#include "common/Metrics.h"
 #include "common/Monitors.h"
 #include "common/PropertyManager.h"
 #include "common/id.h"
 #include "common/Variable.h"
+#include "common/FlightRecorder.h"
 
 
 #include <Atlas/Objects/Anonymous.h>
@@ -39,6 +42,7 @@
 
 #include <sigc++/adaptors/bind.h>
 
+#include <algorithm>
 #include <unordered_set>
 #include "Remotery.h"
 
@@ -48,6 +52,27 @@ using Atlas::Message::Element;
 
 static constexpr auto debug_flag = false;
 
+namespace {
+/**
+ * @param qtype Either "inserts" or "updates".
+ * @param window The number of ticks the value is averaged over.
+ */
+/**
+ * The number of entities captured each tick when capturing a snapshot.
+ */
+constexpr size_t snapshotEntitiesPerTick = 2000;
+
+/**
+ * How many ticks to keep recapturing changed entities once all entities have been visited, before finishing the snapshot
+ * regardless of how many remain.
+ */
+constexpr int maxSnapshotCatchUpTicks = 20;
+
+Metrics::Gauge& storageQueriesGauge(const std::string& qtype, const std::string& window) {
+	return Metrics::instance().gauge("storage_qps", "Number of storage queries per tick, averaged over a window of ticks.", {{"qtype", qtype}, {"t", window}});
+}
+}
+
 StorageManager::StorageManager(WorldRouter& world,
 							   Database& db,
 							   EntityBuilder& entityBuilder,
@@ -59,10 +84,15 @@ StorageManager::StorageManager(WorldRouter& world,
 		m_insertEntityCount(0), m_updateEntityCount(0),
 		m_insertPropertyCount(0), m_updatePropertyCount(0),
 		m_insertQps(0), m_updateQps(0),
-		m_insertQpsNow(0), m_updateQpsNow(0),
-		m_insertQpsAvg(0), m_updateQpsAvg(0),
+		m_insertQpsNow(storageQueriesGauge("inserts", "1")),
+		m_updateQpsNow(storageQueriesGauge("updates", "1")),
+		m_insertQpsAvg(storageQueriesGauge("inserts", "32")),
+		m_updateQpsAvg(storageQueriesGauge("updates", "32")),
 		m_insertQpsIndex(0), m_updateQpsIndex(0),
-		m_insertQpsRing(), m_updateQpsRing() {
+		m_insertQpsRing(), m_updateQpsRing(),
+		m_snapshotCaptureDuration(Metrics::instance().histogram("snapshot_capture_seconds", "Time spent on the main thread each tick capturing a world snapshot.")),
+		m_snapshotCaptureTime(0),
+		m_snapshotCatchUpTicks(0) {
 
 	world.inserted.connect(sigc::mem_fun(*this,
 										 &StorageManager::entityInserted));
@@ -76,16 +106,6 @@ StorageManager::StorageManager(WorldRouter& world,
 	Monitors::instance().watch("storage_property_updates",
 							   std::make_unique<Variable<int>>(m_updatePropertyCount));
 
-	Monitors::instance().watch(R"(storage_qps{{qtype="inserts",t="1"}})",
-							   std::make_unique<Variable<int>>(m_insertQpsNow));
-	Monitors::instance().watch(R"(storage_qps{{qtype="updates",t="1"}})",
-							   std::make_unique<Variable<int>>(m_updateQpsNow));
-
-	Monitors::instance().watch(R"(storage_qps{{qtype="inserts",t="32"}})",
-							   std::make_unique<Variable<int>>(m_insertQpsAvg));
-	Monitors::instance().watch(R"(storage_qps{{qtype="updates",t="32"}})",
-							   std::make_unique<Variable<int>>(m_updateQpsAvg));
-
 	for (int i = 0; i < 32; ++i) {
 		m_insertQpsRing[i] = 0;
 		m_updateQpsRing[i] = 0;
@@ -100,6 +120,9 @@ void StorageManager::entityInserted(LocatedEntity& ent) {
 		// This entity is not persisted.
 		return;
 	}
+	if (m_snapshotCapture) {
+		m_snapshotCapture->entityChanged(ent);
+	}
 	if (ent.hasFlags(entity_clean)) {
 		// This entity has just been restored from the database, so does
 		// not need to be inserted, but will need to be updated.
@@ -117,6 +140,9 @@ void StorageManager::entityInserted(LocatedEntity& ent) {
 
 /// \brief Called when an Entity is modified
 void StorageManager::entityUpdated(LocatedEntity& ent) {
+	if (m_snapshotCapture) {
+		m_snapshotCapture->entityChanged(ent);
+	}
 	if (ent.isDestroyed()) {
 		m_destroyedEntities.push_back(ent.getIdAsInt());
 		return;
@@ -364,6 +390,9 @@ size_t StorageManager::restoreChildren(LocatedEntity& parent) {
 
 void StorageManager::tick() {
 	rmt_ScopedCPUSample(StorageManager_tick, 0)
+	FlightRecorder::ScopedPhase phase("storage");
+	m_snapshotWriter.poll();
+
 	int inserts = 0, updates = 0;
 	int old_insert_queries = m_insertEntityCount + m_insertPropertyCount;
 	int old_update_queries = m_updateEntityCount + m_updatePropertyCount;
@@ -421,8 +450,8 @@ void StorageManager::tick() {
 	m_insertQps -= m_insertQpsRing[m_insertQpsIndex];
 	m_insertQps += insert_queries;
 	m_insertQpsRing[m_insertQpsIndex] = insert_queries;
-	m_insertQpsAvg = m_insertQps / 32;
-	m_insertQpsNow = insert_queries;
+	m_insertQpsAvg.set(m_insertQps / 32);
+	m_insertQpsNow.set(insert_queries);
 
 	cy_debug(if (insert_queries) {
 		std::cout << "Ins: " << insert_queries << ", " << m_insertQps / 32
@@ -438,13 +467,17 @@ void StorageManager::tick() {
 	m_updateQps -= m_updateQpsRing[m_updateQpsIndex];
 	m_updateQps += update_queries;
 	m_updateQpsRing[m_updateQpsIndex] = update_queries;
-	m_updateQpsAvg = m_updateQps / 32;
-	m_updateQpsNow = update_queries;
+	m_updateQpsAvg.set(m_updateQps / 32);
+	m_updateQpsNow.set(update_queries);
 
 	cy_debug(if (update_queries) {
 		std::cout << "Ups: " << update_queries << ", " << m_updateQps / 32
 				  << std::endl;
 	})
+
+	if (m_snapshotCapture) {
+		captureSnapshot();
+	}
 }
 
 int StorageManager::initWorld(const Ref<LocatedEntity>& ent) {
@@ -478,7 +511,82 @@ int StorageManager::restoreWorld(const Ref<LocatedEntity>& ent) {
 	return 0;
 }
 
-int StorageManager::shutdown(bool&, const std::map<long, Ref<LocatedEntity>>&) {
+void StorageManager::importSnapshot(const WorldSnapshot& snapshot) {
+	spdlog::info("Replacing stored world with snapshot of {} entities.", snapshot.getEntities().size());
+	//The root entity is always present, so only its properties are replaced.
+	m_db.scheduleCommand("DELETE FROM properties");
+	m_db.scheduleCommand(fmt::format("DELETE FROM entities WHERE id != {}", consts::rootWorldIntId));
+	long maxId = consts::rootWorldIntId;
+	for (auto& entity: snapshot.getEntities()) {
+		maxId = std::max(maxId, entity.id);
+		auto id = std::to_string(entity.id);
+		if (entity.parentId == WorldSnapshot::noParent) {
+			m_db.updateEntityWithoutLoc(id, entity.seq);
+		} else {
+			m_db.insertEntity(id, std::to_string(entity.parentId), entity.type, entity.seq);
+		}
+		if (!entity.properties.empty()) {
+			std::vector<std::tuple<std::string, std::string>> property_tuples;
+			property_tuples.reserve(entity.properties.size());
+			for (auto& property: entity.properties) {
+				std::string value;
+				encodeElement(property.second, value);
+				property_tuples.emplace_back(property.first, value);
+			}
+			m_db.upsertProperties(id, property_tuples);
+		}
+	}
+	m_db.blockUntilAllQueriesComplete();
+	//The id generator was seeded before the import, so it could otherwise hand out ids of restored entities.
+	if (m_db.reserveIds(maxId) != 0) {
+		spdlog::error("Could not reserve ids up to {} after importing snapshot.", maxId);
+	}
+}
+
+bool StorageManager::snapshot(const std::filesystem::path& path) {
+	if (m_snapshotCapture || m_snapshotWriter.isWriting()) {
+		spdlog::warn("Not writing snapshot to {}, since another snapshot is still being captured or written.", path.generic_string());
+		return false;
+	}
+	m_snapshotCapture = std::make_unique<WorldSnapshotCapture>(*m_world.getBaseEntity());
+	m_snapshotPath = path;
+	m_snapshotStart = std::chrono::steady_clock::now();
+	m_snapshotCaptureTime = std::chrono::steady_clock::duration(0);
+	m_snapshotCatchUpTicks = 0;
+	return true;
+}
+
+void StorageManager::captureSnapshot() {
+	auto start = std::chrono::steady_clock::now();
+	auto remaining = m_snapshotCapture->capture(snapshotEntitiesPerTick);
+	//Once all entities have been visited only those changed since they were captured remain. Finishing captures all of
+	//those at once, so wait until there are few enough, unless the world changes faster than they can be captured.
+	if (m_snapshotCapture->hasVisitedAll()) {
+		if (remaining <= snapshotEntitiesPerTick || ++m_snapshotCatchUpTicks > maxSnapshotCatchUpTicks) {
+			finishSnapshot();
+		}
+	}
+	auto duration = std::chrono::steady_clock::now() - start;
+	m_snapshotCaptureDuration.observe(duration);
+	m_snapshotCaptureTime += duration;
+}
+
+void StorageManager::finishSnapshot() {
+	auto snapshot = m_snapshotCapture->finish();
+	m_snapshotCapture.reset();
+	spdlog::info("Captured world snapshot of {} entities and {} properties over {} seconds, of which {} milliseconds were spent on the main thread.",
+				 snapshot->getEntities().size(),
+				 snapshot->getPropertyCount(),
+				 std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::steady_clock::now() - m_snapshotStart).count(),
+				 std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(m_snapshotCaptureTime).count());
+	m_snapshotWriter.write(std::move(snapshot), m_snapshotPath);
+}
+
+int StorageManager::shutdown(bool&, const EntityRegistry&) {
+	if (m_snapshotCapture) {
+		finishSnapshot();
+	}
+	m_snapshotWriter.wait();
 	tick();
 	m_db.blockUntilAllQueriesComplete();
 	return 0;
@@ -19,6 +19,8 @@
 #ifndef SERVER_STORAGE_MANAGER_H
 #define SERVER_STORAGE_MANAGER_H
 
+#include "WorldSnapshot.h"
+#include "common/Metrics.h"
 #include "common/OperationRouter.h"
 #include "common/Property.h"
 #include "modules/Ref.h"
@@ -30,6 +32,9 @@
 #include <map>
 #include <set>
 #include <array>
+#include <chrono>
+#include <filesystem>
+#include <memory>
 #include <Atlas/Message/Element.h>
 #include "rules/simulation/LocatedEntity.h"
 
@@ -41,6 +46,8 @@ class Database;
 
 class WorldRouter;
 
+class EntityRegistry;
+
 template<typename>
 class PropertyManager;
 
@@ -76,11 +83,11 @@ protected:
 	int m_insertQps;
 	int m_updateQps;
 
-	int m_insertQpsNow;
-	int m_updateQpsNow;
+	Metrics::Gauge& m_insertQpsNow;
+	Metrics::Gauge& m_updateQpsNow;
 
-	int m_insertQpsAvg;
-	int m_updateQpsAvg;
+	Metrics::Gauge& m_insertQpsAvg;
+	Metrics::Gauge& m_updateQpsAvg;
 
 	int m_insertQpsIndex;
 	int m_updateQpsIndex;
@@ -88,6 +95,17 @@ protected:
 	std::array<int, 32> m_insertQpsRing;
 	std::array<int, 32> m_updateQpsRing;
 
+	Metrics::Histogram& m_snapshotCaptureDuration;
+
+	/// \brief The snapshot currently being captured, if any.
+	std::unique_ptr<WorldSnapshotCapture> m_snapshotCapture;
+	std::filesystem::path m_snapshotPath;
+	std::chrono::steady_clock::time_point m_snapshotStart;
+	std::chrono::steady_clock::duration m_snapshotCaptureTime;
+	int m_snapshotCatchUpTicks;
+
+	WorldSnapshotWriter m_snapshotWriter;
+
 	void entityInserted(LocatedEntity&);
 
 	void entityUpdated(LocatedEntity&);
@@ -104,6 +122,10 @@ protected:
 
 	size_t restoreChildren(LocatedEntity&);
 
+	void captureSnapshot();
+
+	void finishSnapshot();
+
 public:
 	explicit StorageManager(WorldRouter& world,
 							Database& db,
@@ -118,10 +140,22 @@ public:
 
 	int restoreWorld(const Ref<LocatedEntity>& ent);
 
+	/// \brief Replaces the stored world with the one in a snapshot.
+	///
+	/// This must be done before the world is restored.
+	void importSnapshot(const WorldSnapshot& snapshot);
+
+	/// \brief Starts capturing a snapshot of the world, which is written to a file in the background once complete.
+	///
+	/// The capture is spread over the following ticks, a limited number of entities each tick, and then finished in a
+	/// single tick so that the snapshot is consistent. The time spent each tick is recorded in the "snapshot_capture_seconds" histogram.
+	/// \return False if a snapshot is already being captured or written.
+	bool snapshot(const std::filesystem::path& path);
+
 	/// \brief Called when shutting down.
 	///
 	/// It's expected that the storage manager attempts to persist entity state.
-	int shutdown(bool& exit_flag, const std::map<long, Ref<LocatedEntity>>& entites);
+	int shutdown(bool& exit_flag, const EntityRegistry& entites);
 
 };
 
@@ -36,3 +36,8 @@ void TeleportState::setCreated() {
 void TeleportState::setKey(const std::string& key) {
 	m_possessKey = key;
 }
+
+/// \brief Set the ids of the contained entities sent along with the teleported entity
+void TeleportState::setContained(std::vector<long> contained) {
+	m_contained = std::move(contained);
+}
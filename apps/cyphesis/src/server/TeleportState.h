@@ -20,6 +20,7 @@
 
 #include <chrono>
 #include <string>
+#include <vector>
 
 class TeleportState {
 protected:
@@ -33,6 +34,9 @@ protected:
 
 	std::chrono::steady_clock::time_point m_teleportTime;  /// \brief The time the teleport took place
 
+	/// \brief Ids of the entities contained in the teleported entity, which were sent along with it, parents before children
+	std::vector<long> m_contained;
+
 public:
 	TeleportState(const TeleportState& rhs) = default;
 
@@ -46,6 +50,10 @@ public:
 
 	void setKey(const std::string& key);
 
+	void setContained(std::vector<long> contained);
+
+	const std::vector<long>& getContained() const;
+
 	bool isCreated() const;
 
 	bool isRequested() const;
@@ -89,4 +97,11 @@ inline std::chrono::steady_clock::time_point TeleportState::getCreateTime() cons
 	return m_teleportTime;
 }
 
+/// \brief Get the ids of the contained entities sent along with the teleported entity
+///
+/// @return The ids, with parents before their children
+inline const std::vector<long>& TeleportState::getContained() const {
+	return m_contained;
+}
+
 #endif // SERVER_TELEPORT_STATE_H
@@ -55,10 +55,13 @@ TypeUpdateCoordinator::TypeUpdateCoordinator(Inheritance& inheritance, WorldRout
                                 << change->getParent() << ":"
                                 << change->getFrom() << ":" << change->getTo() << "}")
 
-            //Go through all world entities and check if they need to be updated
-            auto& entities = worldRouter.getEntities();
-            for (auto& entry : entities) {
-                auto entity = entry.second;
+            //Go through all world entities and check if they need to be updated.
+            //Applying properties might create or destroy entities, so iterate over a snapshot.
+            auto entities = worldRouter.getEntities().snapshot();
+            for (auto& entity : entities) {
+                if (entity->isDestroyed()) {
+                    continue;
+                }
                 auto I = typeNodes.find(entity->getType());
                 if (I != typeNodes.end()) {
                     auto typeNode = I->first;
@@ -0,0 +1,382 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "WorldSnapshot.h"
+
+#include "rules/simulation/LocatedEntity.h"
+
+#include "common/Database.h"
+#include "common/DatabaseSQLite.h"
+#include "common/log.h"
+#include "common/TypeNode.h"
+
+#include "Remotery.h"
+
+#include <Atlas/Codecs/Packed.h>
+#include <Atlas/Message/MEncoder.h>
+
+#include <sqlite3pp/sqlite3pp.h>
+
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <unordered_map>
+
+using Atlas::Message::Element;
+using Atlas::Message::MapType;
+
+namespace {
+
+WorldSnapshot::EntityRecord createRecord(const LocatedEntity& entity) {
+	WorldSnapshot::EntityRecord record{entity.getIdAsInt(),
+									   entity.m_parent ? entity.m_parent->getIdAsInt() : WorldSnapshot::noParent,
+									   entity.getType() ? entity.getType()->name() : "",
+									   entity.getSeq(),
+									   {}};
+	for (auto& entry: entity.getProperties()) {
+		auto& prop = entry.second.property;
+		//The property might be empty if there's only modifiers but no property.
+		if (!prop || prop->hasFlags(prop_flag_persistence_ephem)) {
+			continue;
+		}
+		//This is the same value as StorageManager would persist.
+		if (entry.second.modifiers.empty()) {
+			Element value;
+			prop->get(value);
+			record.properties.emplace_back(entry.first, std::move(value));
+		} else {
+			record.properties.emplace_back(entry.first, entry.second.baseValue);
+		}
+	}
+	return record;
+}
+
+/**
+ * Encodes a property value in the same way as the server database does.
+ *
+ * Only const access is used on the value, so this is safe to do from a background thread.
+ */
+std::string encodeValue(const Element& value) {
+	std::stringstream str;
+	Decoder decoder;
+	Atlas::Codecs::Packed codec(str, str, decoder);
+	Atlas::Message::Encoder encoder(codec);
+
+	codec.streamBegin();
+	codec.streamMessage();
+	encoder.mapElementItem("val", value);
+	codec.mapEnd();
+	codec.streamEnd();
+
+	return str.str();
+}
+
+bool decodeValue(const std::string& data, Element& value) {
+	std::stringstream str(data, std::ios::in);
+	Decoder decoder;
+	Atlas::Codecs::Packed codec(str, str, decoder);
+	codec.poll();
+	if (!decoder.check()) {
+		return false;
+	}
+	auto map = decoder.get();
+	auto I = map.find("val");
+	if (I == map.end()) {
+		return false;
+	}
+	value = std::move(I->second);
+	return true;
+}
+
+void orderRecursively(std::vector<WorldSnapshot::EntityRecord>& source,
+					  size_t index,
+					  const std::unordered_multimap<long, size_t>& children,
+					  std::vector<WorldSnapshot::EntityRecord>& ordered) {
+	auto id = source[index].id;
+	ordered.emplace_back(std::move(source[index]));
+	auto range = children.equal_range(id);
+	for (auto I = range.first; I != range.second; ++I) {
+		orderRecursively(source, I->second, children, ordered);
+	}
+}
+
+/**
+ * Places parents before their children. Any entity not connected to the root is dropped.
+ */
+std::vector<WorldSnapshot::EntityRecord> orderFromRoot(std::vector<WorldSnapshot::EntityRecord>& entities, size_t rootIndex) {
+	std::unordered_multimap<long, size_t> children;
+	for (size_t i = 0; i < entities.size(); ++i) {
+		if (i != rootIndex) {
+			children.emplace(entities[i].parentId, i);
+		}
+	}
+	std::vector<WorldSnapshot::EntityRecord> ordered;
+	ordered.reserve(entities.size());
+	orderRecursively(entities, rootIndex, children, ordered);
+	return ordered;
+}
+
+}
+
+WorldSnapshot::WorldSnapshot(std::vector<EntityRecord> entities)
+		: m_entities(std::move(entities)) {
+}
+
+std::shared_ptr<const WorldSnapshot> WorldSnapshot::capture(LocatedEntity& root) {
+	return WorldSnapshotCapture(root).finish();
+}
+
+std::unique_ptr<WorldSnapshot> WorldSnapshot::readFromSQLite(const std::filesystem::path& path) {
+	if (!std::filesystem::exists(path)) {
+		throw std::runtime_error(fmt::format("Snapshot file {} does not exist.", path.generic_string()));
+	}
+	sqlite3pp::database db(path.c_str(), SQLITE_OPEN_READONLY);
+
+	std::vector<EntityRecord> entities;
+	std::unordered_map<long, size_t> indices;
+	std::optional<size_t> rootIndex;
+
+	sqlite3pp::query entityQuery(db, "SELECT id, loc, type, seq FROM entities");
+	for (auto row: entityQuery) {
+		auto id = static_cast<long>(row.get<long long int>(0));
+		auto parentId = row.column_type(1) == SQLITE_NULL ? noParent : static_cast<long>(row.get<long long int>(1));
+		indices.emplace(id, entities.size());
+		if (parentId == noParent) {
+			rootIndex = entities.size();
+		}
+		entities.emplace_back(EntityRecord{id, parentId, row.get<std::string>(2), row.get<int>(3), {}});
+	}
+
+	if (!rootIndex) {
+		throw std::runtime_error(fmt::format("Snapshot file {} contains no root entity.", path.generic_string()));
+	}
+
+	sqlite3pp::query propertyQuery(db, "SELECT id, name, value FROM properties");
+	for (auto row: propertyQuery) {
+		auto id = static_cast<long>(row.get<long long int>(0));
+		auto I = indices.find(id);
+		if (I == indices.end()) {
+			spdlog::warn("Property found in snapshot for entity {}, which doesn't exist.", id);
+			continue;
+		}
+		std::string name = row.get<std::string>(1);
+		Element value;
+		if (!decodeValue(row.get<std::string>(2), value)) {
+			spdlog::error("Could not decode value of property {} for entity {} in snapshot.", name, id);
+			continue;
+		}
+		entities[I->second].properties.emplace_back(std::move(name), std::move(value));
+	}
+
+	//Any entity not connected to the root is dropped, just as it wouldn't be restored from the database.
+	auto ordered = orderFromRoot(entities, *rootIndex);
+	if (ordered.size() != entities.size()) {
+		spdlog::warn("Snapshot {} contained {} entities not connected to the root entity, which were ignored.",
+					 path.generic_string(), entities.size() - ordered.size());
+	}
+
+	return std::make_unique<WorldSnapshot>(std::move(ordered));
+}
+
+void WorldSnapshot::writeToSQLite(const std::filesystem::path& path) const {
+	rmt_ScopedCPUSample(WorldSnapshot_writeToSQLite, 0)
+	auto tempPath = path;
+	tempPath += ".tmp";
+	if (path.has_parent_path()) {
+		std::filesystem::create_directories(path.parent_path());
+	}
+	std::filesystem::remove(tempPath);
+
+	{
+		sqlite3pp::database db(tempPath.c_str());
+		//The file is only moved into place once complete, so there's no need for any journaling.
+		db.execute("PRAGMA journal_mode = OFF");
+		db.execute("PRAGMA synchronous = OFF");
+		if (db.execute(DatabaseSQLite::entityTableSchema().c_str()) != SQLITE_OK
+			|| db.execute(DatabaseSQLite::propertyTableSchema().c_str()) != SQLITE_OK) {
+			throw sqlite3pp::database_error(db);
+		}
+
+		sqlite3pp::transaction transaction(db);
+		sqlite3pp::command insertEntity(db, "INSERT INTO entities (id, loc, type, seq) VALUES (?, ?, ?, ?)");
+		sqlite3pp::command insertProperty(db, "INSERT INTO properties (id, name, value) VALUES (?, ?, ?)");
+
+		for (auto& entity: m_entities) {
+			insertEntity.bind(1, static_cast<long long int>(entity.id));
+			if (entity.parentId != noParent) {
+				insertEntity.bind(2, static_cast<long long int>(entity.parentId));
+			} else {
+				insertEntity.bind(2, sqlite3pp::null_type());
+			}
+			insertEntity.bind(3, entity.type, sqlite3pp::nocopy);
+			insertEntity.bind(4, entity.seq);
+			if (insertEntity.execute() != SQLITE_OK) {
+				throw sqlite3pp::database_error(db);
+			}
+			insertEntity.reset();
+
+			for (auto& property: entity.properties) {
+				auto value = encodeValue(property.second);
+				insertProperty.bind(1, static_cast<long long int>(entity.id));
+				insertProperty.bind(2, property.first, sqlite3pp::nocopy);
+				insertProperty.bind(3, value, sqlite3pp::nocopy);
+				if (insertProperty.execute() != SQLITE_OK) {
+					throw sqlite3pp::database_error(db);
+				}
+				insertProperty.reset();
+			}
+		}
+		if (transaction.commit() != SQLITE_OK) {
+			throw sqlite3pp::database_error(db);
+		}
+	}
+
+	std::filesystem::rename(tempPath, path);
+}
+
+size_t WorldSnapshot::getPropertyCount() const {
+	size_t count = 0;
+	for (auto& entity: m_entities) {
+		count += entity.properties.size();
+	}
+	return count;
+}
+
+WorldSnapshotCapture::WorldSnapshotCapture(LocatedEntity& root)
+		: m_rootId(root.getIdAsInt()) {
+	m_unvisited.emplace_back(&root);
+}
+
+WorldSnapshotCapture::~WorldSnapshotCapture() = default;
+
+void WorldSnapshotCapture::entityChanged(LocatedEntity& entity) {
+	m_changed.emplace(entity.getIdAsInt(), &entity);
+}
+
+size_t WorldSnapshotCapture::capture(size_t maxEntities) {
+	rmt_ScopedCPUSample(WorldSnapshotCapture_capture, 0)
+	size_t count = 0;
+	while (count < maxEntities && !m_unvisited.empty()) {
+		auto entity = std::move(m_unvisited.front());
+		m_unvisited.pop_front();
+		captureEntity(*entity);
+		++count;
+	}
+	while (count < maxEntities && !m_changed.empty()) {
+		//Copy the reference, since capturing removes the entry.
+		auto entity = m_changed.begin()->second;
+		captureEntity(*entity);
+		++count;
+	}
+	return remaining();
+}
+
+void WorldSnapshotCapture::captureEntity(LocatedEntity& entity) {
+	auto id = entity.getIdAsInt();
+	m_changed.erase(id);
+	//Ephemeral entities aren't persisted, and neither is anything they contain.
+	if (entity.hasFlags(entity_ephem) || entity.isDestroyed()) {
+		m_records.erase(id);
+		return;
+	}
+	auto result = m_records.insert_or_assign(id, createRecord(entity));
+	//Children only need to be visited when an entity is first captured; any added later are reported as changed.
+	if (result.second && entity.m_contains) {
+		for (auto& child: *entity.m_contains) {
+			m_unvisited.emplace_back(child);
+		}
+	}
+}
+
+std::shared_ptr<const WorldSnapshot> WorldSnapshotCapture::finish() {
+	rmt_ScopedCPUSample(WorldSnapshotCapture_finish, 0)
+	capture(std::numeric_limits<size_t>::max());
+
+	std::vector<WorldSnapshot::EntityRecord> entities;
+	entities.reserve(m_records.size());
+	std::optional<size_t> rootIndex;
+	for (auto& entry: m_records) {
+		if (entry.first == m_rootId) {
+			rootIndex = entities.size();
+		}
+		entities.emplace_back(std::move(entry.second));
+	}
+	m_records.clear();
+	if (!rootIndex) {
+		return std::make_shared<WorldSnapshot>(std::vector<WorldSnapshot::EntityRecord>());
+	}
+	return std::make_shared<WorldSnapshot>(orderFromRoot(entities, *rootIndex));
+}
+
+WorldSnapshotWriter::WorldSnapshotWriter()
+		: m_done(false),
+		  m_succeeded(false) {
+}
+
+WorldSnapshotWriter::~WorldSnapshotWriter() {
+	wait();
+}
+
+bool WorldSnapshotWriter::write(std::shared_ptr<const WorldSnapshot> snapshot, std::filesystem::path path) {
+	if (m_snapshot) {
+		return false;
+	}
+	m_snapshot = std::move(snapshot);
+	m_path = std::move(path);
+	m_start = std::chrono::steady_clock::now();
+	m_done = false;
+	m_succeeded = false;
+	//Only a raw pointer is passed, since the snapshot must not be released on the background thread.
+	m_thread = std::thread([this, snapshot = m_snapshot.get(), path = m_path]() {
+#ifdef __APPLE__
+		pthread_setname_np("Snapshot writer");
+#else
+		pthread_setname_np(pthread_self(), "Snapshot writer");
+#endif
+		try {
+			snapshot->writeToSQLite(path);
+			m_succeeded = true;
+		} catch (const std::exception& e) {
+			spdlog::error("Could not write world snapshot to {}: {}", path.generic_string(), e.what());
+		}
+		m_done = true;
+	});
+	return true;
+}
+
+void WorldSnapshotWriter::poll() {
+	if (m_snapshot && m_done) {
+		complete();
+	}
+}
+
+void WorldSnapshotWriter::wait() {
+	if (m_snapshot) {
+		complete();
+	}
+}
+
+void WorldSnapshotWriter::complete() {
+	m_thread.join();
+	if (m_succeeded) {
+		spdlog::info("Wrote world snapshot of {} entities to {} in {} seconds.",
+					 m_snapshot->getEntities().size(),
+					 m_path.generic_string(),
+					 std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::steady_clock::now() - m_start).count());
+	}
+	m_snapshot.reset();
+}
@@ -0,0 +1,201 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef CYPHESIS_WORLDSNAPSHOT_H
+#define CYPHESIS_WORLDSNAPSHOT_H
+
+#include "modules/Ref.h"
+
+#include <Atlas/Message/Element.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class LocatedEntity;
+
+/**
+ * @brief A consistent, point in time, image of all persisted entities in the world.
+ *
+ * The snapshot is captured on the main thread, spread over a number of ticks using a WorldSnapshotCapture, and can then be
+ * written on a background thread while the world keeps running.
+ *
+ * Values which already are stored as Atlas elements (soft properties, and the base values of modified properties) share
+ * their data with the live properties, relying on Atlas elements being copy-on-write; typed properties are converted into
+ * new elements. Since the reference counting of Atlas elements isn't thread safe any background thread must only read
+ * from a snapshot, and the snapshot must be released on the main thread.
+ */
+class WorldSnapshot {
+public:
+	/**
+	 * The parent id of the root entity. Zero can't be used, since that's the id of the world entity.
+	 */
+	static constexpr long noParent = -1;
+
+	struct EntityRecord {
+		long id;
+		/**
+		 * The id of the parent entity, or noParent for the root entity.
+		 */
+		long parentId;
+		std::string type;
+		int seq;
+		std::vector<std::pair<std::string, Atlas::Message::Element>> properties;
+	};
+
+	explicit WorldSnapshot(std::vector<EntityRecord> entities);
+
+	/**
+	 * @brief Captures all persisted entities at once, starting at the root.
+	 *
+	 * This blocks until the whole world has been captured. Use a WorldSnapshotCapture to spread the work over many ticks.
+	 */
+	static std::shared_ptr<const WorldSnapshot> capture(LocatedEntity& root);
+
+	/**
+	 * @brief Reads a snapshot previously written with writeToSQLite().
+	 * @throws std::runtime_error If the file couldn't be read.
+	 */
+	static std::unique_ptr<WorldSnapshot> readFromSQLite(const std::filesystem::path& path);
+
+	/**
+	 * @brief Writes the snapshot to a new SQLite database.
+	 *
+	 * The database gets the same "entities" and "properties" tables as the server database.
+	 * The file is first written under a temporary name and then renamed, so an incomplete snapshot is never left at the path.
+	 * @throws std::runtime_error If the file couldn't be written.
+	 */
+	void writeToSQLite(const std::filesystem::path& path) const;
+
+	const std::vector<EntityRecord>& getEntities() const {
+		return m_entities;
+	}
+
+	size_t getPropertyCount() const;
+
+private:
+	std::vector<EntityRecord> m_entities;
+};
+
+/**
+ * @brief Captures a snapshot incrementally, a number of entities at a time.
+ *
+ * Entities are first visited from the root and down. Any entity which changes after it has been captured, is added to
+ * the world, or is destroyed, must be reported through entityChanged(), and will be captured again. When finish() is
+ * called everything still outstanding is captured, so the snapshot shows the world as it is at that point. The cost of
+ * finishing is thus proportional to the number of entities changed since they were captured, not to the size of the world.
+ *
+ * The same entities and properties as the StorageManager would persist are included. Parents are always placed before
+ * their children, and entities not connected to the root are left out.
+ */
+class WorldSnapshotCapture {
+public:
+	explicit WorldSnapshotCapture(LocatedEntity& root);
+
+	~WorldSnapshotCapture();
+
+	/**
+	 * @brief Reports that an entity has changed, been added, or been destroyed.
+	 */
+	void entityChanged(LocatedEntity& entity);
+
+	/**
+	 * @brief Captures up to a number of entities, first those not yet visited and then those which have changed.
+	 * @return The number of entities still to capture.
+	 */
+	size_t capture(size_t maxEntities);
+
+	/**
+	 * @brief True if every entity has been visited at least once, and only changed entities remain.
+	 */
+	bool hasVisitedAll() const {
+		return m_unvisited.empty();
+	}
+
+	size_t remaining() const {
+		return m_unvisited.size() + m_changed.size();
+	}
+
+	/**
+	 * @brief Captures everything still outstanding and creates the snapshot.
+	 *
+	 * The instance can't be used after this.
+	 */
+	std::shared_ptr<const WorldSnapshot> finish();
+
+private:
+	long m_rootId;
+	std::deque<Ref<LocatedEntity>> m_unvisited;
+	std::unordered_map<long, Ref<LocatedEntity>> m_changed;
+	std::unordered_map<long, WorldSnapshot::EntityRecord> m_records;
+
+	void captureEntity(LocatedEntity& entity);
+};
+
+/**
+ * @brief Writes snapshots on a background thread.
+ *
+ * Only one snapshot is written at a time. The owner is expected to call poll() regularly from the main thread, which
+ * releases the snapshot once it's written.
+ */
+class WorldSnapshotWriter {
+public:
+	WorldSnapshotWriter();
+
+	~WorldSnapshotWriter();
+
+	/**
+	 * @brief Starts writing a snapshot in the background.
+	 * @return False if a snapshot is already being written.
+	 */
+	bool write(std::shared_ptr<const WorldSnapshot> snapshot, std::filesystem::path path);
+
+	/**
+	 * @brief Checks if the current write has completed, and if so releases the snapshot.
+	 *
+	 * Must be called from the thread which captured the snapshot.
+	 */
+	void poll();
+
+	/**
+	 * @brief Blocks until any current write has completed, and releases the snapshot.
+	 */
+	void wait();
+
+	bool isWriting() const {
+		return m_snapshot != nullptr;
+	}
+
+private:
+	std::shared_ptr<const WorldSnapshot> m_snapshot;
+	std::filesystem::path m_path;
+	std::chrono::steady_clock::time_point m_start;
+	std::thread m_thread;
+	std::atomic<bool> m_done;
+	bool m_succeeded;
+
+	void complete();
+};
+
+#endif //CYPHESIS_WORLDSNAPSHOT_H
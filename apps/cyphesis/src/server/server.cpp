@@ -23,6 +23,7 @@
 #include "CommMetaClient.h"
 #include "CommMDNSPublisher.h"
 #include "common/net/CommAsioListener_impl.h"
+#include "common/net/SharedMemoryChannel.h"
 #include "Connection.h"
 #include "ServerRouting.h"
 #include "EntityBuilder.h"
@@ -48,13 +49,18 @@
 #include "common/id.h"
 #include "common/const.h"
 #include "common/AtlasFactories.h"
+#include "common/AutoCloseConnection.h"
 #include "rules/simulation/Inheritance.h"
 #include "common/globals.h"
 #include "common/system.h"
 #include "common/sockets.h"
 #include "common/Monitors.h"
 #include "common/Variable.h"
+#include "common/FlightRecorder.h"
 #include "ExternalMindsManager.h"
+#include "AiClientPool.h"
+#include "RegionShard.h"
+#include "OpReplayer.h"
 #include "Player.h"
 #include "ServerPropertyManager.h"
 #include "TypeUpdateCoordinator.h"
@@ -73,6 +79,7 @@
 #include <common/DatabaseSQLite.h>
 #include <common/RepeatedTask.h>
 #include <common/MainLoop.h>
+#include <common/Metrics.h>
 #include <rules/simulation/python/CyPy_Server.h>
 #include <rules/python/CyPy_Physics.h>
 #include <rules/entityfilter/python/CyPy_EntityFilter_impl.h>
@@ -83,9 +90,12 @@
 #include <rules/simulation/ExternalMind.h>
 #include <rules/simulation/PhysicalDomain.h>
 #include <rules/simulation/ScriptsProperty.h>
+#include <rules/simulation/MeshShapeCache.h>
+#include <rules/simulation/PhysicsTaskScheduler.h>
 #include "saf/saf.hpp"
 
 #include <varconf/config.h>
+#include <fmt/chrono.h>
 #include <filesystem>
 
 #include <thread>
@@ -111,7 +121,43 @@ STRING_OPTION(mserver, "metaserver.worldforge.org", CYPHESIS, "metaserver",
 			  "Hostname to use as the metaserver")
 
 INT_OPTION(ai_clients, 1, CYPHESIS, "aiclients",
-		   "Number of AI clients to spawn.")
+		   "Number of AI client processes to spawn and keep running. Minds are distributed among them by their load.")
+
+BOOL_OPTION(network_compression, true, CYPHESIS, "compression",
+			"Flag to control if traffic with remote clients should be compressed, if the client supports it")
+
+BOOL_OPTION(ai_shared_memory, false, CYPHESIS, "aisharedmemory",
+			"Flag to control if AI clients should communicate with the server through shared memory instead of a socket")
+
+INT_OPTION(snapshot_interval, 0, CYPHESIS, "snapshotinterval",
+		   "Interval in minutes between writing snapshots of the world, to be used as backups. Set to 0 to disable.")
+
+STRING_OPTION(restore_snapshot, "", CYPHESIS, "restoresnapshot",
+			  "Path to a world snapshot which should replace the stored world when starting.")
+
+STRING_OPTION(region_name, "", CYPHESIS, "region",
+			  "The region of the world simulated by this server, when the world is split across several peered servers. Leave empty to simulate the whole world.")
+
+STRING_OPTION(regions, "", CYPHESIS, "regions",
+			  "The regions the world is split into, as \"name=minx,minz,maxx,maxz@host:port;...\". The peer address is omitted for the region of this server.")
+
+INT_OPTION(region_margin, 20, CYPHESIS, "regionmargin",
+		   "Entities closer than this to a neighbouring region are mirrored to the server simulating it.")
+
+STRING_OPTION(record_ops, "", CYPHESIS, "recordops",
+			  "Path to a journal to which all operations received from clients, or dispatched by the world, are recorded.")
+
+STRING_OPTION(replay_ops, "", CYPHESIS, "replayops",
+			  "Path to a journal written through \"recordops\" from which client operations are replayed, after which the server exits. Use together with \"restoresnapshot\" to start from the recorded world.")
+
+INT_OPTION(replay_speed, 100, CYPHESIS, "replayspeed",
+		   "Speed of replaying operations, in percent of the recorded speed. Set to 0 to replay as fast as possible.")
+
+INT_OPTION(physics_threads, 0, CYPHESIS, "physicsthreads",
+		   "Number of threads to simulate physics on, including the main thread. Set to 0 or 1 to simulate on the main thread only, which is deterministic. Requires Bullet built with multithreading.")
+
+INT_OPTION(stall_threshold, 100, CYPHESIS, "stallthreshold",
+		   "Frames of the main loop which take longer than this many milliseconds have the timings of the most recent frames dumped to a file in the \"stalls\" directory. Set to 0 to disable.")
 
 /**
  * Wraps either a Postgres server connection along with a vacuum socket, or a SQLite connection along with a vacuum task.
@@ -225,6 +271,7 @@ struct SocketListeners {
 	std::list<CommAsioListener<ip::tcp, CommAsioClient<ip::tcp>>> tcp_atlas_clients;
 	std::unique_ptr<CommAsioListener<local::stream_protocol, CommPythonClient>> pythonListener;
 	std::unique_ptr<CommAsioListener<local::stream_protocol, CommAsioClient<local::stream_protocol>>> localListener;
+	std::unique_ptr<CommAsioListener<local::stream_protocol, CommAsioClient<local::stream_protocol>>> sharedMemoryListener;
 	std::unique_ptr<CommAsioListener<ip::tcp, CommHttpClient>> httpListener;
 };
 
@@ -246,7 +293,7 @@ SocketListeners createListeners(io_context& io_context,
 		client.getSocket().set_option(ip::tcp::no_delay(true));
 		//Listen to both ipv4 and ipv6
 		//client.getSocket().set_option(boost::asio::ip::v6_only(false));
-		client.startAccept(std::make_unique<Connection>(client, serverRouting, "", connection_id));
+		client.startAccept(std::make_unique<Connection>(client, serverRouting, "", connection_id), network_compression);
 	};
 
 
@@ -322,6 +369,29 @@ SocketListeners createListeners(io_context& io_context,
 																																	   local::stream_protocol::endpoint(client_socket_name));
 	spdlog::info("Listening to local named socket at {}", client_socket_name);
 
+	if (ai_shared_memory) {
+		remove(shared_memory_socket_name.c_str());
+		//The socket is only used to hand over the shared memory; all data is then sent through the memory.
+		auto sharedMemoryStarter = [&](CommAsioClient<local::stream_protocol>& client) {
+			try {
+				auto channel = SharedMemoryChannel::create(io_context);
+				channel->sendDescriptors(client.getSocket());
+				client.useSharedMemory(std::move(channel));
+			} catch (const std::exception& e) {
+				spdlog::error("Could not set up shared memory for local client: {}", e.what());
+				return;
+			}
+			auto connection_id = newId();
+			client.startAccept(std::make_unique<TrustedConnection>(client, serverRouting, "", connection_id));
+		};
+		socketListeners.sharedMemoryListener = std::make_unique<CommAsioListener<local::stream_protocol, CommAsioClient<local::stream_protocol>>>(localCreator,
+																																				sharedMemoryStarter,
+																																				serverRouting.getName(),
+																																				io_context,
+																																				local::stream_protocol::endpoint(shared_memory_socket_name));
+		spdlog::info("Listening for shared memory connections at {}", shared_memory_socket_name);
+	}
+
 
 	auto httpCreator = [&]() -> std::shared_ptr<CommHttpClient> {
 		return std::make_shared<CommHttpClient>(serverRouting.getName(), httpPool, httpRequestProcessor);
@@ -340,6 +410,7 @@ SocketListeners createListeners(io_context& io_context,
 	spdlog::info(" /config : shows server configuration");
 	spdlog::info(" /monitors : various monitored values, suitable for time series systems");
 	spdlog::info(" /monitors/numerics : only numerical values, suitable for time series system that only operates on numerical data");
+	spdlog::info(" /metrics : counters, gauges and histograms in the Prometheus format, together with the numerical monitored values");
 
 	return socketListeners;
 }
@@ -364,26 +435,19 @@ int run() {
 	Monitors monitors;
 	monitors.watch("minds", std::make_unique<Variable<int>>(ExternalMind::s_numberOfMinds));
 	monitors.watch("players", std::make_unique<Variable<int>>(Player::s_numberOfPlayers));
-	monitors.watch("physic_processing_us", std::make_unique<Variable<int>>(PhysicalDomain::s_processTimeUs));
 
 
-	//Check if we should spawn AI clients.
-	if (ai_clients) {
+	//Check if we should spawn AI clients. These are supervised, and restarted if they exit.
+	std::unique_ptr<AiClientPool> aiClientPool;
+	if (ai_clients > 0) {
 		spdlog::info("Spawning {} AI client processes.", ai_clients);
-		for (int i = 0; i < ai_clients; ++i) {
-			auto pid = fork();
-			if (pid == 0) {
-				execl((bin_directory + "/cyaiclient").c_str(),
-					  (bin_directory + "/cyaiclient").c_str(),
-					  fmt::format("--cyphesis:confdir={}", etc_directory).c_str(),
-					  fmt::format("--cyphesis:vardir={}", var_directory).c_str(),
-					  fmt::format("--cyphesis:directory={}", share_directory).c_str(),
-					  nullptr);
-				return 0;
-			} else if (pid == -1) {
-				spdlog::warn("Could not spawn AI client process.");
-			}
-		}
+		aiClientPool = std::make_unique<AiClientPool>(std::vector<std::string>{
+				bin_directory + "/cyaiclient",
+				fmt::format("--cyphesis:confdir={}", etc_directory),
+				fmt::format("--cyphesis:vardir={}", var_directory),
+				fmt::format("--cyphesis:directory={}", share_directory)
+		}, (size_t) ai_clients);
+		aiClientPool->poll(std::chrono::steady_clock::now());
 	}
 
 	//A pointer because we need to reset this before we shut down the Python API. Perhaps this could be done better?
@@ -467,6 +531,25 @@ int run() {
 						python_directories);
 		observe_python_directories(*io_context, assets_manager);
 
+		//Built collision shapes are kept on disk, so they don't need to be rebuilt on each start.
+		MeshShapeCache meshShapeCache(std::filesystem::path(var_directory) / "lib" / "cyphesis" / "cache" / "shapes");
+
+		std::unique_ptr<PhysicsTaskScheduler> physicsTaskScheduler;
+		if (physics_threads > 1) {
+			if (PhysicsTaskScheduler::isSupported()) {
+				physicsTaskScheduler = std::make_unique<PhysicsTaskScheduler>(physics_threads);
+				PhysicalDomain::s_multithreaded = true;
+				spdlog::info("Simulating physics on {} threads.", physicsTaskScheduler->getNumThreads());
+			} else {
+				spdlog::warn("Bullet isn't built with multithreading, so physics will be simulated on the main thread only.");
+			}
+		}
+
+		FlightRecorder flightRecorder;
+		if (stall_threshold > 0) {
+			flightRecorder.enableDumps(std::filesystem::path(var_directory) / "lib" / "cyphesis" / "stalls", std::chrono::milliseconds(stall_threshold));
+		}
+
 		Inheritance inheritance;
 		ServerPropertyManager propertyManager(inheritance);
 
@@ -489,16 +572,16 @@ int run() {
 		WorldRouter worldRouter(baseEntity, entityBuilder, timeProviderFn);
 		baseEntity.reset();
 
-		std::map<int, int> operationsMap;
+		//Keyed by the same parent name as the label, since Generic ops share a class number whatever their parent.
+		std::map<std::string, Metrics::Counter*, std::less<>> operationsMap;
 		monitors.watch("operations_processed", std::make_unique<Variable<int>>(worldRouter.m_operationsCount));
 		worldRouter.Dispatching.connect([&](const Operation& op) {
-			auto I = operationsMap.find(op->getClassNo());
+			auto& type = op->getParent();
+			auto I = operationsMap.find(type);
 			if (I == operationsMap.end()) {
-				auto result = operationsMap.emplace(op->getClassNo(), 1);
-				monitors.watch(fmt::format("operation_count{{type=\"{}\"}}", op->getParent()), std::make_unique<Variable<int>>(result.first->second));
-			} else {
-				I->second++;
+				I = operationsMap.emplace(type, &Metrics::instance().counter("operation_count", "Number of operations dispatched, per type.", {{"type", type}})).first;
 			}
+			I->second->increment();
 		});
 
 		CyPy_Server::registerWorld(&worldRouter);
@@ -527,6 +610,21 @@ int run() {
 									RouterId{lobby_int_id});
 		serverRouting.setAssets({assetsHandler.resolveAssetsUrl()});
 
+		std::unique_ptr<RegionShard> regionShard;
+		if (!region_name.empty()) {
+			auto regionMap = RegionMap::parse(regions);
+			if (!regionMap || !regionMap->getRegion(region_name)) {
+				spdlog::critical("Region '{}' isn't defined in the region specification \"{}\".", region_name, regions);
+				return EXIT_CONFIG_ERROR;
+			}
+			regionShard = std::make_unique<RegionShard>(std::move(*regionMap),
+														region_name,
+														region_margin,
+														worldRouter.getBaseEntity(),
+														std::make_unique<RegionShard::JunctureTransport>(serverRouting));
+			spdlog::info("Simulating region '{}'.", region_name);
+		}
+
 
 		assets_manager.observeDirectory(assetsPath.string(), [assetsPath, &ctx = *io_context, &assetsHandler, &serverRouting, &squallThreadPool](const std::filesystem::path& path) {
 
@@ -561,6 +659,11 @@ int run() {
 
 		run_user_scripts("cyphesis");
 
+		if (!restore_snapshot.empty()) {
+			spdlog::info("Restoring world from snapshot {}...", restore_snapshot);
+			store.importSnapshot(*WorldSnapshot::readFromSQLite(restore_snapshot));
+		}
+
 		spdlog::info("Restoring world from database...");
 
 		store.restoreWorld(worldRouter.getBaseEntity());
@@ -571,6 +674,10 @@ int run() {
 
 		spdlog::info("Restored world.");
 
+		if (regionShard) {
+			regionShard->partition();
+		}
+
 		// Configuration is now complete, and verified as somewhat sane, so
 		// we save the updated user config.
 		updateUserConfiguration();
@@ -665,10 +772,70 @@ int run() {
 			IdleConnector storage_idle(*io_context);
 			storage_idle.idling.connect([&store]() { store.tick(); });
 
+			std::unique_ptr<RepeatedTask> snapshotTask;
+			if (snapshot_interval > 0) {
+				snapshotTask = std::make_unique<RepeatedTask>(*io_context, std::chrono::minutes(snapshot_interval), [&store]() {
+					auto timestamp = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+					store.snapshot(std::filesystem::path(var_directory) / "lib" / "cyphesis" / "snapshots" / fmt::format("world-{:%Y%m%d-%H%M%S}.db3", timestamp));
+				});
+			}
+
+			std::unique_ptr<RepeatedTask> aiClientPoolTask;
+			if (aiClientPool) {
+				aiClientPoolTask = std::make_unique<RepeatedTask>(*io_context, std::chrono::seconds(1), [&aiClientPool]() {
+					aiClientPool->poll(std::chrono::steady_clock::now());
+				});
+			}
+
+			//Move minds away from overloaded AI clients.
+			RepeatedTask mindRebalanceTask(*io_context, std::chrono::seconds(10), [&externalMindsManager]() {
+				externalMindsManager.rebalance(std::chrono::steady_clock::now());
+			});
+
+			std::unique_ptr<RepeatedTask> regionShardTask;
+			if (regionShard) {
+				regionShardTask = std::make_unique<RepeatedTask>(*io_context, std::chrono::milliseconds(250), [&regionShard]() {
+					regionShard->update(std::chrono::steady_clock::now());
+				});
+			}
+
+			std::unique_ptr<OpRecorder> opRecorder;
+			AutoCloseConnection opRecorderConnection;
+			std::unique_ptr<RepeatedTask> opRecorderFlushTask;
+			std::unique_ptr<OpReplayer> opReplayer;
+			std::unique_ptr<RepeatedTask> opReplayerTask;
+			try {
+				if (!record_ops.empty()) {
+					opRecorder = std::make_unique<OpRecorder>(record_ops);
+					opRecorderConnection = worldRouter.Dispatching.connect([&opRecorder](const Operation& op) {
+						opRecorder->record(OpJournalEntry::Source::World, "", "", op);
+					});
+					opRecorderFlushTask = std::make_unique<RepeatedTask>(*io_context, std::chrono::seconds(1), [&opRecorder]() {
+						opRecorder->flush();
+					});
+					spdlog::info("Recording operations to {}.", record_ops);
+				}
+				if (!replay_ops.empty()) {
+					opReplayer = std::make_unique<OpReplayer>(worldRouter, atlasFactories, std::make_unique<OpJournalReader>(replay_ops), replay_speed / 100.0);
+					opReplayerTask = std::make_unique<RepeatedTask>(*io_context, std::chrono::milliseconds(10), [&opReplayer]() {
+						if (!exit_flag && !opReplayer->poll(std::chrono::steady_clock::now())) {
+							opReplayer->report();
+							exit_flag = true;
+						}
+					});
+				}
+			} catch (const std::exception& e) {
+				spdlog::critical(e.what());
+				return EXIT_CONFIG_ERROR;
+			}
+
 			spdlog::info("Running and accepting connections");
 			logEvent(START, "- - - Standalone server startup");
 
 			MainLoop::run(daemon_flag, *io_context, worldRouter.getOperationsHandler(), {softExitStart, softExitPoll, softExitTimeout, dispatchOperationsFn}, time);
+			if (aiClientPool) {
+				aiClientPool->shutdown();
+			}
 			if (metaClient) {
 				metaClient->metaserverTerminate();
 			}
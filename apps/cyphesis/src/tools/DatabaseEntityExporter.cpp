@@ -0,0 +1,119 @@
+//
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "DatabaseEntityExporter.h"
+
+#include "common/const.h"
+#include "common/Database.h"
+#include "common/globals.h"
+#include "common/log.h"
+
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/MultiLineListFormatter.h>
+
+using Atlas::Message::MapType;
+using Atlas::Objects::Entity::Anonymous;
+using Atlas::Objects::Entity::RootEntity;
+
+DatabaseEntityExporter::DatabaseEntityExporter(Database& database, const std::string& currentTimestamp) :
+		EntityExporterBase("", "", currentTimestamp),
+		m_database(database) {
+}
+
+size_t DatabaseEntityExporter::exportDatabase(const std::string& filename) {
+	auto res = m_database.runSimpleSelectQuery(fmt::format("SELECT type, seq FROM entities WHERE id = {}", consts::rootWorldIntId));
+	if (res.empty()) {
+		throw std::runtime_error("There's no root entity in the database.");
+	}
+	auto I = res.begin();
+
+	std::vector<RootEntity> entities;
+	readEntitiesRecursively(consts::rootWorldId, "", I.column("type"), std::stoi(I.column("seq")), entities);
+
+	exportEntities(filename, entities);
+	return entities.size();
+}
+
+void DatabaseEntityExporter::readEntitiesRecursively(const std::string& id,
+													 const std::string& loc,
+													 const std::string& type,
+													 int seq,
+													 std::vector<RootEntity>& entities) {
+	//Use the same format as the server uses when sending archived entities.
+	Anonymous entity;
+	entity->setId(id);
+	entity->setParent(type);
+	entity->setStamp(seq);
+	entity->setObjtype("obj");
+	if (!loc.empty()) {
+		entity->setLoc(loc);
+	}
+
+	auto properties = m_database.selectProperties(id);
+	for (auto I = properties.begin(); I != properties.end(); ++I) {
+		const std::string name = I.column("name");
+		MapType prop_data;
+		m_database.decodeMessage(I.column("value"), prop_data);
+		auto J = prop_data.find("val");
+		if (J == prop_data.end()) {
+			spdlog::error("No property value data for {}:{}", id, name);
+			continue;
+		}
+		entity->setAttr(name, std::move(J->second));
+	}
+
+	struct ChildRow {
+		std::string id;
+		std::string type;
+		int seq;
+	};
+	std::vector<ChildRow> children;
+	std::vector<std::string> contains;
+	auto childRows = m_database.selectEntities(id);
+	for (auto I = childRows.begin(); I != childRows.end(); ++I) {
+		children.push_back({I.column("id"), I.column("type"), std::stoi(I.column("seq"))});
+		contains.emplace_back(children.back().id);
+	}
+	if (!contains.empty()) {
+		entity->setContains(std::move(contains));
+	}
+	entities.emplace_back(std::move(entity));
+
+	for (auto& child: children) {
+		readEntitiesRecursively(child.id, id, child.type, child.seq, entities);
+	}
+}
+
+long int DatabaseEntityExporter::newSerialNumber() {
+	return 0;
+}
+
+void DatabaseEntityExporter::send(const Atlas::Objects::Operation::RootOperation&) {
+	//Nothing is ever sent, since there's no server.
+}
+
+void DatabaseEntityExporter::sendAndAwaitResponse(const Atlas::Objects::Operation::RootOperation&, CallbackFunction&) {
+	//Nothing is ever sent, since there's no server.
+}
+
+Atlas::Formatter* DatabaseEntityExporter::createMultiLineFormatter(std::iostream& s, Atlas::Bridge& b) {
+	return new Atlas::MultiLineListFormatter(s, b);
+}
+
+void DatabaseEntityExporter::fillWithServerData(Atlas::Message::MapType& serverMap) {
+	serverMap["ruleset"] = ruleset_name;
+}
@@ -0,0 +1,69 @@
+//
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef CYPHESIS_DATABASEENTITYEXPORTER_H
+#define CYPHESIS_DATABASEENTITYEXPORTER_H
+
+#include "EntityExporterBase.h"
+
+#include <Atlas/Objects/RootEntity.h>
+
+class Database;
+
+/**
+ * @brief Exports the stored world directly from the database, without a running server.
+ *
+ * The server must not be running while exporting, since it might be writing to the database.
+ */
+class DatabaseEntityExporter : public EntityExporterBase {
+public:
+	DatabaseEntityExporter(Database& database, const std::string& currentTimestamp);
+
+	~DatabaseEntityExporter() override = default;
+
+	/**
+	 * @brief Reads all entities from the database, starting at the root entity, and writes them to the file.
+	 * @param filename The file name to where the dump should be written.
+	 * @return The number of entities read.
+	 * @throws std::runtime_error If there's no root entity in the database.
+	 */
+	size_t exportDatabase(const std::string& filename);
+
+protected:
+	Database& m_database;
+
+	long int newSerialNumber() override;
+
+	void send(const Atlas::Objects::Operation::RootOperation& op) override;
+
+	void sendAndAwaitResponse(const Atlas::Objects::Operation::RootOperation& op, CallbackFunction& callback) override;
+
+	Atlas::Formatter* createMultiLineFormatter(std::iostream& s, Atlas::Bridge& b) override;
+
+	void fillWithServerData(Atlas::Message::MapType& serverMap) override;
+
+	/**
+	 * @brief Reads an entity and all of its children, placing the parent before the children.
+	 */
+	void readEntitiesRecursively(const std::string& id,
+								 const std::string& loc,
+								 const std::string& type,
+								 int seq,
+								 std::vector<Atlas::Objects::Entity::RootEntity>& entities);
+};
+
+#endif //CYPHESIS_DATABASEENTITYEXPORTER_H
@@ -88,7 +88,8 @@ EntityExporterBase::EntityExporterBase(const std::string& accountId, const std::
 		mCancelled(false),
 		mOutstandingGetRequestCounter(0),
 		mExportTransient(false),
-		mPreserveIds(false) {
+		mPreserveIds(false),
+		mBatchSize(0) {
 }
 
 void EntityExporterBase::setExportTransient(bool exportTransient) {
@@ -107,6 +108,14 @@ bool EntityExporterBase::getPreserveIds() const {
 	return mPreserveIds;
 }
 
+void EntityExporterBase::setBatchSize(int batchSize) {
+	mBatchSize = batchSize;
+}
+
+int EntityExporterBase::getBatchSize() const {
+	return mBatchSize;
+}
+
 const EntityExporterBase::Stats& EntityExporterBase::getStats() const {
 	return mStats;
 }
@@ -281,13 +290,32 @@ void EntityExporterBase::infoArrived(const Operation& op) {
 		EventProgress.emit();
 		return;
 	}
-	RootEntity ent = smart_dynamic_cast<RootEntity>(args.front());
-	if (!ent.isValid()) {
-		S_LOG_WARNING("Malformed OURS when dumping.")
-		mStats.entitiesError++;
-		EventProgress.emit();
-		return;
+	//When exporting in batches the server sends many entities, and all of their children, at once.
+	for (auto& arg: args) {
+		RootEntity ent = smart_dynamic_cast<RootEntity>(arg);
+		if (!ent.isValid()) {
+			S_LOG_WARNING("Malformed OURS when dumping.")
+			mStats.entitiesError++;
+			EventProgress.emit();
+			continue;
+		}
+		auto contains = entityArrived(ent);
+		if (mBatchSize == 0) {
+			for (auto& id: contains) {
+				mEntityQueue.push_back(id);
+			}
+		}
 	}
+
+	//If the server has more entities in this batch we should ask for them now that we're done with the current ones.
+	Element cursorElem;
+	if (mBatchSize > 0 && op->copyAttr("cursor", cursorElem) == 0) {
+		requestNextBatch(cursorElem);
+	}
+	pollQueue();
+}
+
+std::vector<std::string> EntityExporterBase::entityArrived(const RootEntity& ent) {
 	S_LOG_VERBOSE("Got info when dumping about entity " << ent->getId() << ". Outstanding requests: " << mOutstandingGetRequestCounter)
 	mStats.entitiesReceived++;
 	EventProgress.emit();
@@ -305,24 +333,47 @@ void EntityExporterBase::infoArrived(const Operation& op) {
 				shouldSkip = true;
 			}
 		}
+		//When exporting in batches we also get the children of any skipped entity, which should be skipped too.
+		if (!ent->isDefaultLoc() && mSkippedIds.find(ent->getLoc()) != mSkippedIds.end()) {
+			shouldSkip = true;
+		}
 	}
 
-	if (!shouldSkip) {
-		//Make a copy so that we can sort the contains list and update it in the
-		//entity
-		RootEntity entityCopy(ent->copy());
-		auto contains = ent->getContains();
-		//Sort the contains list so it's deterministic
-		std::sort(contains.begin(), contains.end(), idSorter);
-		entityCopy->setContains(contains);
-
-		//Remove attributes which shouldn't be persisted
-		dumpEntity(std::move(entityCopy));
-		for (auto& id: contains) {
-			mEntityQueue.push_back(id);
-		}
+	if (shouldSkip) {
+		mSkippedIds.insert(ent->getId());
+		return {};
 	}
-	pollQueue();
+	//Make a copy so that we can sort the contains list and update it in the
+	//entity
+	RootEntity entityCopy(ent->copy());
+	auto contains = ent->getContains();
+	//Sort the contains list so it's deterministic
+	std::sort(contains.begin(), contains.end(), idSorter);
+	entityCopy->setContains(contains);
+
+	//Remove attributes which shouldn't be persisted
+	dumpEntity(std::move(entityCopy));
+	return contains;
+}
+
+void EntityExporterBase::requestNextBatch(const Element& cursor) {
+	mOutstandingGetRequestCounter++;
+	Get get;
+
+	Anonymous get_arg;
+	get_arg->setObjtype("obj");
+	get_arg->setId(mRootEntityId);
+	get_arg->setAttr("archive", 1);
+	get_arg->setAttr("batch", mBatchSize);
+	get_arg->setAttr("cursor", cursor);
+	get->setArgs1(get_arg);
+
+	get->setFrom(mAccountId);
+	get->setSerialno(newSerialNumber());
+
+	sigc::slot<void(const Operation&)> slot = sigc::mem_fun(*this, &EntityExporterBase::operationGetResult);
+	sendAndAwaitResponse(get, slot);
+	S_LOG_VERBOSE("Requesting next batch of entities.")
 }
 
 void EntityExporterBase::requestRule(const std::string& rule) {
@@ -603,6 +654,20 @@ void EntityExporterBase::start(const std::string& filename, const std::string& e
 
 }
 
+void EntityExporterBase::exportEntities(const std::string& filename, const std::vector<RootEntity>& entities) {
+	if (mComplete || mCancelled) {
+		S_LOG_FAILURE("Can not restart an already completed or cancelled export instance.")
+		return;
+	}
+
+	S_LOG_INFO("Starting entity dump of " << entities.size() << " entities to file '" << filename << "'.")
+	mFilename = filename;
+	for (auto& entity: entities) {
+		entityArrived(entity);
+	}
+	complete();
+}
+
 void EntityExporterBase::startRequestingEntities() {
 	// Send a get for the requested root entity
 	mOutstandingGetRequestCounter++;
@@ -612,6 +677,9 @@ void EntityExporterBase::startRequestingEntities() {
 	get_arg->setObjtype("obj");
 	get_arg->setId(mRootEntityId);
 	get_arg->setAttr("archive", 1);
+	if (mBatchSize > 0) {
+		get_arg->setAttr("batch", mBatchSize);
+	}
 	get->setArgs1(get_arg);
 
 	get->setFrom(mAccountId);
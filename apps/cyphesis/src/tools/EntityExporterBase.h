@@ -147,6 +147,18 @@ public:
 	 */
 	void start(const std::string& filename, const std::string& entityId = "0");
 
+	/**
+	 * @brief Exports entities which have already been read, without querying the server.
+	 *
+	 * This is used when exporting directly from a database. Since no rules are known any attributes
+	 * which are the same as the type defaults are kept, and only entities with a "transient"
+	 * attribute set are treated as transient.
+	 * The export is completed before this method returns.
+	 * @param filename The file name to where the dump should be written.
+	 * @param entities The entities, with parents placed before their children.
+	 */
+	void exportEntities(const std::string& filename, const std::vector<Atlas::Objects::Entity::RootEntity>& entities);
+
 	/**
 	 * @brief Cancels the dumping.
 	 */
@@ -195,6 +207,22 @@ public:
 	 */
 	bool getPreserveIds() const;
 
+	/**
+	 * @brief Sets the number of entities to ask the server for in each request.
+	 *
+	 * If set, the server sends the whole entity hierarchy in batches, instead of the entities being
+	 * requested one by one. The next batch isn't requested until the previous one has been handled.
+	 * The default is zero, which requests the entities one by one, as older servers expect.
+	 * @param batchSize The number of entities in each batch.
+	 */
+	void setBatchSize(int batchSize);
+
+	/**
+	 * @brief Gets the number of entities to ask the server for in each request.
+	 * @return The batch size, or zero if entities are requested one by one.
+	 */
+	int getBatchSize() const;
+
 	/**
 	 * @brief Gets stats about the export process.
 	 * @return Stats about the process.
@@ -298,6 +326,18 @@ protected:
 	 */
 	bool mPreserveIds;
 
+	/**
+	 * @brief The number of entities to ask for in each request, or zero if they should be requested one by one.
+	 */
+	int mBatchSize;
+
+	/**
+	 * @brief The ids of any transient entities which were skipped.
+	 *
+	 * When exporting in batches the server sends all children, so these are used to skip the children of the transient entities too.
+	 */
+	std::unordered_set<std::string> mSkippedIds;
+
 	/**
 	 * @brief Keeps track of all types that have the "transient" property set by default.
 	 *
@@ -317,6 +357,18 @@ protected:
 
 	void dumpEntity(Atlas::Objects::Entity::RootEntity ent);
 	void infoArrived(const Operation& op);
+
+	/**
+	 * @brief Handles an entity received from the server.
+	 * @return The ids of the entities it contains, or an empty list if the entity was skipped.
+	 */
+	std::vector<std::string> entityArrived(const Atlas::Objects::Entity::RootEntity& ent);
+
+	/**
+	 * @brief Asks the server for the next batch of entities.
+	 * @param cursor The cursor received with the previous batch.
+	 */
+	void requestNextBatch(const Atlas::Message::Element& cursor);
 	void operationGetResult(const Operation& op);
     void operationGetRuleResult(const Operation& op);
 	void requestRule(const std::string& rule);
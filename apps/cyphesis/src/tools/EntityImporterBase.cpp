@@ -232,17 +232,19 @@ void EntityImporterBase::complete() {
 }
 
 void EntityImporterBase::createEntity(const RootEntity& obj, OpVector& res) {
-	++mStats.entitiesProcessedCount;
-	++mStats.entitiesCreateCount;
-	EventProgress.emit();
-
 	m_state = ENTITY_CREATING;
 
 	assert(mTreeStack.size() > 1);
 	auto I = mTreeStack.rbegin();
 	++I;
 	assert(I != mTreeStack.rend());
-	const std::string& loc = I->restored_id;
+	createEntity(obj, I->restored_id, res);
+}
+
+void EntityImporterBase::createEntity(const RootEntity& obj, const std::string& loc, OpVector& res) {
+	++mStats.entitiesProcessedCount;
+	++mStats.entitiesCreateCount;
+	EventProgress.emit();
 
 	RootEntity create_arg = obj.copy();
 
@@ -304,6 +306,44 @@ void EntityImporterBase::createEntity(const RootEntity& obj, OpVector& res) {
 	res.push_back(create);
 }
 
+void EntityImporterBase::startBatchCreating(OpVector& res) {
+	m_state = ENTITY_BATCH_CREATING;
+
+	assert(mTreeStack.size() == 1);
+	const StackEntry& root = mTreeStack.back();
+	queueChildrenForCreation(root.obj->getId(), root.restored_id);
+	mTreeStack.clear();
+
+	S_LOG_INFO("Creating entities in batches of " << mBatchSize << ".")
+	pumpBatchCreates(res);
+}
+
+void EntityImporterBase::queueChildrenForCreation(const std::string& persistedId, const std::string& restoredId) {
+	auto I = mPersistedEntities.find(persistedId);
+	if (I == mPersistedEntities.end()) {
+		return;
+	}
+	for (auto& childId: I->second.children) {
+		//Transient entities might be referenced without having been exported.
+		if (mPersistedEntities.find(childId) != mPersistedEntities.end()) {
+			mCreateQueue.emplace_back(childId, restoredId);
+		}
+	}
+}
+
+void EntityImporterBase::pumpBatchCreates(OpVector& res) {
+	//Parents are always created before their children, since children aren't queued until their parent has been created.
+	while (mCreatesInTransit < mBatchSize && !mCreateQueue.empty()) {
+		auto entry = std::move(mCreateQueue.front());
+		mCreateQueue.pop_front();
+		createEntity(mPersistedEntities.find(entry.first)->second.obj, entry.second, res);
+		mCreatesInTransit++;
+	}
+	if (mCreatesInTransit == 0) {
+		sendResolvedEntityReferences();
+	}
+}
+
 
 void EntityImporterBase::errorArrived(const Operation& op, OpVector& res) {
 	std::string errorMessage;
@@ -351,6 +391,26 @@ void EntityImporterBase::errorArrived(const Operation& op, OpVector& res) {
 			walkEntities(res);
 		}
 			break;
+		case ENTITY_BATCH_CREATING: {
+			auto I = mCreateEntityMapping.find(op->getRefno());
+			if (I == mCreateEntityMapping.end()) {
+				S_LOG_WARNING("Got error for an operation which we didn't seem to have sent. Server message: " << errorMessage)
+				break;
+			}
+			std::string entityType = "unknown";
+			auto J = mPersistedEntities.find(I->second);
+			if (J != mPersistedEntities.end()) {
+				entityType = J->second.obj->getParent();
+			}
+			//Any children of the entity won't be created either, since they have nowhere to go.
+			S_LOG_FAILURE("Could not create entity of type '" << entityType << "', skipping it and its children. Server message: " << errorMessage)
+			mCreateEntityMapping.erase(I);
+			mCreatesInTransit--;
+			mStats.entitiesCreateErrorCount++;
+			EventProgress.emit();
+			pumpBatchCreates(res);
+		}
+			break;
 		default: S_LOG_FAILURE("Unexpected state in state machine: " << m_state << ". Server message: " << errorMessage)
 			break;
 	}
@@ -384,6 +444,20 @@ void EntityImporterBase::infoArrived(const Operation& op, OpVector& res) {
 		}
 
 		walkEntities(res);
+	} else if (m_state == ENTITY_BATCH_CREATING) {
+		auto I = mCreateEntityMapping.find(op->getRefno());
+		if (I == mCreateEntityMapping.end()) {
+			S_LOG_WARNING("Got info about create for an entity which we didn't seem to have sent.")
+			return;
+		}
+		mNewIds.insert(arg->getId());
+		mEntityIdMap.emplace(I->second, arg->getId());
+		S_LOG_VERBOSE("Created: " << arg->getParent() << "(" << arg->getId() << ")")
+		queueChildrenForCreation(I->second, arg->getId());
+		mCreateEntityMapping.erase(I);
+		mCreatesInTransit--;
+
+		pumpBatchCreates(res);
 	} else if (m_state == ENTITY_WALKING) {
 		const RootEntity& ent = smart_dynamic_cast<RootEntity>(arg);
 		if (!ent.isValid()) {
@@ -461,10 +535,16 @@ void EntityImporterBase::sightArrived(const Operation& op, OpVector& res) {
 				S_LOG_FAILURE("This is not our entity update response.")
 				break;
 			}
-			walkEntities(res);
+			//Once the root entity has been updated all other entities can be created in batches, if they're all to be new.
+			if (mBatchSize > 0 && mAlwaysCreateNewEntities && mTreeStack.size() == 1) {
+				startBatchCreating(res);
+			} else {
+				walkEntities(res);
+			}
 		}
 			break;
 		case ENTITY_CREATING:
+		case ENTITY_BATCH_CREATING:
 		case ENTITY_WALKING:
 		case ENTITY_REF_RESOLVING:
 			//Just ignore sights when creating; these are sights of the actual creation ops.
@@ -482,7 +562,9 @@ EntityImporterBase::EntityImporterBase(std::string accountId, std::string avatar
 		mSetOpsInTransit(0),
 		mResumeWorld(false),
 		mSuspendWorld(false),
-		mAlwaysCreateNewEntities(false) {
+		mAlwaysCreateNewEntities(false),
+		mBatchSize(0),
+		mCreatesInTransit(0) {
 }
 
 void EntityImporterBase::start(const std::string& filename) {
@@ -658,6 +740,10 @@ void EntityImporterBase::setAlwaysCreateNewEntities(bool alwaysCreateNew) {
 	mAlwaysCreateNewEntities = alwaysCreateNew;
 }
 
+void EntityImporterBase::setBatchSize(size_t batchSize) {
+	mBatchSize = batchSize;
+}
+
 void EntityImporterBase::operationSetResult(const Operation& op) {
 	mSetOpsInTransit--;
 	if (m_state == ENTITY_REF_RESOLVING && mSetOpsInTransit == 0) {
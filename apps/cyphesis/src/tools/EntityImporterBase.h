@@ -181,6 +181,17 @@ class EntityImporterBase : public virtual sigc::trackable
 
         void setAlwaysCreateNewEntities(bool alwaysCreateNew);
 
+        /**
+         * @brief Sets the number of Create ops which can be in transit at the same time.
+         *
+         * This only applies when always creating new entities. The entities are then created breadth first,
+         * without waiting for each one to be created before sending the next, and any entity references
+         * are resolved once all entities have been created.
+         * The default is zero, which creates the entities one by one.
+         * @param batchSize The number of Create ops which can be in transit.
+         */
+        void setBatchSize(size_t batchSize);
+
         /**
          * @brief Emitted when the load has been completed.
          */
@@ -253,6 +264,7 @@ class EntityImporterBase : public virtual sigc::trackable
             ENTITY_WALKSTART,
             ENTITY_UPDATING,
             ENTITY_CREATING,
+            ENTITY_BATCH_CREATING,
             ENTITY_WALKING,
             ENTITY_REF_RESOLVING,
             CANCEL,
@@ -297,6 +309,23 @@ class EntityImporterBase : public virtual sigc::trackable
 
         bool mAlwaysCreateNewEntities;
 
+        /**
+         * @brief The number of Create ops which can be in transit at the same time, or zero if entities should be created one by one.
+         */
+        size_t mBatchSize;
+
+        /**
+         * @brief The entities which are to be created in batches.
+         *
+         * The first element is the id of the entity in the dump, the second the id of its already created parent.
+         */
+        std::deque<std::pair<std::string, std::string>> mCreateQueue;
+
+        /**
+         * @brief Keeps track of the number of Create ops in transit, when creating in batches.
+         */
+        size_t mCreatesInTransit;
+
         /**
          * @brief Sends an operation to the server.
          */
@@ -331,6 +360,33 @@ class EntityImporterBase : public virtual sigc::trackable
          */
         void createEntity(const Atlas::Objects::Entity::RootEntity& obj, OpVector& res);
 
+        /**
+         * @brief Creates a new entity on the server.
+         * @param obj The entity specification.
+         * @param loc The id of the parent entity on the server.
+         * @param res
+         */
+        void createEntity(const Atlas::Objects::Entity::RootEntity& obj, const std::string& loc, OpVector& res);
+
+        /**
+         * @brief Starts creating all entities below the root entity in batches.
+         * @param res
+         */
+        void startBatchCreating(OpVector& res);
+
+        /**
+         * @brief Queues the children of an entity to be created in batches.
+         * @param persistedId The id of the entity in the dump.
+         * @param restoredId The id of the entity on the server.
+         */
+        void queueChildrenForCreation(const std::string& persistedId, const std::string& restoredId);
+
+        /**
+         * @brief Sends as many Create ops as the batch size allows, or resolves entity references if all entities have been created.
+         * @param res
+         */
+        void pumpBatchCreates(OpVector& res);
+
         /**
          * @brief Register any entity referencing attributes, if found, in mEntitiesWithReferenceAttributes.
          * @param id The persisted id of the entity.
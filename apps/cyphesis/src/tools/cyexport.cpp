@@ -23,16 +23,46 @@
 #include "common/AtlasStreamClient.h"
 
 #include "EntityExporter.h"
+#include "DatabaseEntityExporter.h"
+#include "DatabaseCreation.h"
 #include "AgentCreationTask.h"
 
 #include <varconf/config.h>
 
+#include <chrono>
+
 static void usage(char* prg) {
 	std::cerr << "usage: " << prg << " [options] filepath" << std::endl;
 }
 
 BOOL_OPTION(transients, false, "export", "transients", "Flag to control if transients should also be exported");
 BOOL_OPTION(minds, true, "export", "minds", "Flag to control if minds should also be exported");
+INT_OPTION(batch, 100, "export", "batch", "Number of entities the server should send at once. Set to 0 to request entities one by one");
+BOOL_OPTION(offline, false, "export", "offline", "Export directly from the database instead of from a running server. The server must not be running");
+
+static int exportFromDatabase(const std::string& filename) {
+	auto database = createDatabase();
+	if (database->initConnection() != 0) {
+		std::cerr << "Could not connect to the database." << std::endl;
+		return -1;
+	}
+
+	auto now = std::chrono::system_clock::now();
+	DatabaseEntityExporter exporter(*database, std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count()));
+	exporter.setExportTransient(transients);
+
+	std::cout << "Starting export from database" << std::endl;
+	try {
+		auto count = exporter.exportDatabase(filename);
+		std::cout << "Exported " << count << " entities." << std::endl;
+	} catch (const std::exception& e) {
+		std::cerr << "Could not export: " << e.what() << std::endl;
+		database->shutdownConnection();
+		return -1;
+	}
+	database->shutdownConnection();
+	return 0;
+}
 
 int main(int argc, char** argv) {
 	spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [export] [%^%l%$] %v");
@@ -61,6 +91,10 @@ int main(int argc, char** argv) {
 		return 1;
 	}
 
+	if (offline) {
+		return exportFromDatabase(filename);
+	}
+
 	std::string server;
 	readConfigItem("client", "serverhost", server);
 
@@ -111,6 +145,7 @@ int main(int argc, char** argv) {
 		// Ownership of this is transferred to the bridge when it's run, so we shouldn't delete it
 		auto exporter = std::make_shared<EntityExporter>(accountId, mind_id);
 		exporter->setExportTransient(transients);
+		exporter->setBatchSize(batch);
 
 		bridge.runTask(exporter, filename);
 		if (bridge.pollUntilTaskComplete() != 0) {
@@ -52,6 +52,8 @@ BOOL_OPTION(_resume, false, "", "resume",
 			"If the world is suspended, resume after import.")
 BOOL_OPTION(_suspend, false, "", "suspend",
 			"Suspend the world after import.")
+INT_OPTION(batch, 50, "import", "batch",
+		   "Number of entities to create at once when clearing the world. Set to 0 to create entities one by one.")
 
 static void usage(char* prg) {
 	std::cerr << "usage: " << prg << " [options] filepath" << std::endl
@@ -225,6 +227,7 @@ int main(int argc, char** argv) {
 		importer->setResume(resume);
 		importer->setSuspend(suspend);
 		importer->setAlwaysCreateNewEntities(clear);
+		importer->setBatchSize(static_cast<size_t>(std::max(batch, 0)));
 
 		bridge.runTask(importer, filename);
 		if (bridge.pollUntilTaskComplete() != 0) {
@@ -0,0 +1,289 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifndef TESTS_BENCHMARK_BASE_H
+#define TESTS_BENCHMARK_BASE_H
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Cyphesis {
+
+/**
+ * State handed to each benchmark run.
+ *
+ * The benchmark does its setup, and then calls "measure" with the code to time.
+ */
+class BenchmarkState {
+public:
+	explicit BenchmarkState(size_t entities, size_t iterations)
+			: m_entities(entities),
+			  m_iterations(iterations) {}
+
+	/**
+	 * @return The number of entities the benchmark should be run with.
+	 */
+	size_t entities() const {
+		return m_entities;
+	}
+
+	/**
+	 * @return The number of times the measured function is called.
+	 */
+	size_t iterations() const {
+		return m_iterations;
+	}
+
+	/**
+	 * Calls the supplied function "iterations" times, timing each call.
+	 *
+	 * Can only be called once per run.
+	 */
+	void measure(const std::function<void()>& fn) {
+		measure({}, fn);
+	}
+
+	/**
+	 * Same as above, but calls "setup" before each call without timing it.
+	 */
+	void measure(const std::function<void()>& setup, const std::function<void()>& fn) {
+		m_samples.reserve(m_iterations);
+		for (size_t i = 0; i < m_iterations; ++i) {
+			if (setup) {
+				setup();
+			}
+			auto start = std::chrono::steady_clock::now();
+			auto cpuStart = std::clock();
+			fn();
+			m_cpuTime += static_cast<double>(std::clock() - cpuStart) * 1000.0 / CLOCKS_PER_SEC;
+			m_samples.emplace_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+	}
+
+	/**
+	 * Sets a counter which is reported along with the timings, such as number of ops produced.
+	 */
+	void setCounter(const std::string& name, double value) {
+		m_counters[name] = value;
+	}
+
+	const std::vector<double>& samples() const {
+		return m_samples;
+	}
+
+	const std::map<std::string, double>& counters() const {
+		return m_counters;
+	}
+
+	/**
+	 * @return Total processor time spent in the measured function, in milliseconds.
+	 */
+	double cpuTime() const {
+		return m_cpuTime;
+	}
+
+private:
+	size_t m_entities;
+	size_t m_iterations;
+	std::vector<double> m_samples;
+	std::map<std::string, double> m_counters;
+	double m_cpuTime = 0;
+};
+
+struct Benchmark {
+	std::string name;
+	size_t iterations;
+	std::function<void(BenchmarkState&)> method;
+};
+
+/**
+ * Runs a set of benchmarks, each for a range of entity counts.
+ *
+ * Results are logged, and can also be written as JSON in the same format as Google Benchmark uses,
+ * so that existing tools for comparing runs between releases can be used.
+ *
+ * Recognized arguments:
+ *  --entities=100,1000    Entity counts to run each benchmark with.
+ *  --filter=<substring>   Only run benchmarks whose name contains the substring.
+ *  --out=<file>           Write JSON results to the file.
+ *
+ * The entity counts can also be set through the CYPHESIS_BENCHMARK_ENTITIES environment variable.
+ */
+class BenchmarkBase {
+protected:
+	std::vector<Benchmark> m_benchmarks;
+	std::vector<size_t> m_entityCounts;
+	std::string m_filter;
+	std::string m_outPath;
+
+	static std::vector<size_t> parseCounts(const std::string& value) {
+		std::vector<size_t> counts;
+		size_t start = 0;
+		while (start < value.size()) {
+			auto end = value.find(',', start);
+			if (end == std::string::npos) {
+				end = value.size();
+			}
+			auto count = std::strtoul(value.substr(start, end - start).c_str(), nullptr, 10);
+			if (count > 0) {
+				counts.push_back(count);
+			}
+			start = end + 1;
+		}
+		return counts;
+	}
+
+	static std::string escape(const std::string& value) {
+		std::string result;
+		for (auto c: value) {
+			if (c == '"' || c == '\\') {
+				result.push_back('\\');
+			}
+			result.push_back(c);
+		}
+		return result;
+	}
+
+public:
+	explicit BenchmarkBase(std::vector<size_t> defaultEntityCounts)
+			: m_entityCounts(std::move(defaultEntityCounts)) {}
+
+	virtual ~BenchmarkBase() = default;
+
+	void addBenchmark(const Benchmark& benchmark) {
+		m_benchmarks.push_back(benchmark);
+	}
+
+	void parseArgs(int argc, char** argv) {
+		if (auto env = std::getenv("CYPHESIS_BENCHMARK_ENTITIES")) {
+			auto counts = parseCounts(env);
+			if (!counts.empty()) {
+				m_entityCounts = counts;
+			}
+		}
+		for (int i = 1; i < argc; ++i) {
+			std::string arg(argv[i]);
+			if (arg.rfind("--entities=", 0) == 0) {
+				auto counts = parseCounts(arg.substr(11));
+				if (!counts.empty()) {
+					m_entityCounts = counts;
+				}
+			} else if (arg.rfind("--filter=", 0) == 0) {
+				m_filter = arg.substr(9);
+			} else if (arg.rfind("--out=", 0) == 0) {
+				m_outPath = arg.substr(6);
+			} else {
+				spdlog::warn("Unrecognized argument '{}'.", arg);
+			}
+		}
+	}
+
+	int run() {
+		std::vector<std::string> jsonEntries;
+
+		for (auto& benchmark: m_benchmarks) {
+			if (!m_filter.empty() && benchmark.name.find(m_filter) == std::string::npos) {
+				continue;
+			}
+			for (auto entities: m_entityCounts) {
+				auto name = fmt::format("{}/{}", benchmark.name, entities);
+				BenchmarkState state(entities, benchmark.iterations);
+				spdlog::info("Starting benchmark {}", name);
+				benchmark.method(state);
+
+				auto samples = state.samples();
+				if (samples.empty()) {
+					spdlog::error("Benchmark {} did not measure anything.", name);
+					return 1;
+				}
+				std::sort(samples.begin(), samples.end());
+				double total = 0;
+				for (auto sample: samples) {
+					total += sample;
+				}
+				double mean = total / static_cast<double>(samples.size());
+				auto percentile = [&](double p) {
+					return samples[std::min(samples.size() - 1, static_cast<size_t>(p * static_cast<double>(samples.size())))];
+				};
+
+				spdlog::info("{}: mean {:.3f} ms, median {:.3f} ms, p95 {:.3f} ms, min {:.3f} ms, max {:.3f} ms over {} iterations",
+							 name, mean, percentile(0.5), percentile(0.95), samples.front(), samples.back(), samples.size());
+
+				std::string counters;
+				for (auto& entry: state.counters()) {
+					spdlog::info("{}: {} = {}", name, entry.first, entry.second);
+					counters += fmt::format(",\n      \"{}\": {}", escape(entry.first), entry.second);
+				}
+
+				jsonEntries.emplace_back(fmt::format("    {{\n"
+													 "      \"name\": \"{}\",\n"
+													 "      \"run_name\": \"{}\",\n"
+													 "      \"run_type\": \"iteration\",\n"
+													 "      \"iterations\": {},\n"
+													 "      \"real_time\": {},\n"
+													 "      \"cpu_time\": {},\n"
+													 "      \"time_unit\": \"ms\",\n"
+													 "      \"entities\": {},\n"
+													 "      \"median\": {},\n"
+													 "      \"p95\": {},\n"
+													 "      \"min\": {},\n"
+													 "      \"max\": {}{}\n"
+													 "    }}",
+													 escape(name), escape(name), samples.size(), mean, state.cpuTime() / static_cast<double>(samples.size()), entities,
+													 percentile(0.5), percentile(0.95), samples.front(), samples.back(), counters));
+			}
+		}
+
+		if (!m_outPath.empty()) {
+			std::ofstream out(m_outPath);
+			if (!out) {
+				spdlog::error("Could not open '{}' for writing benchmark results.", m_outPath);
+				return 1;
+			}
+			auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+			out << "{\n  \"context\": {\n    \"date\": " << now << "\n  },\n  \"benchmarks\": [\n";
+			for (size_t i = 0; i < jsonEntries.size(); ++i) {
+				out << jsonEntries[i] << (i + 1 < jsonEntries.size() ? ",\n" : "\n");
+			}
+			out << "  ]\n}\n";
+			spdlog::info("Wrote benchmark results to {}", m_outPath);
+		}
+
+		return 0;
+	}
+};
+
+}
+
+#define ADD_BENCHMARK(_function, _iterations) {\
+    Cyphesis::Benchmark _function_benchmark = { #_function, _iterations,\
+                                                [this](Cyphesis::BenchmarkState& state) { _function(state); } };\
+    this->addBenchmark(_function_benchmark);\
+}
+
+#endif // TESTS_BENCHMARK_BASE_H
@@ -20,6 +20,7 @@
 #define TESTS_DATABASE_NULL_H
 
 #include "common/Database.h"
+#include <algorithm>
 #include <functional>
 #include <memory>
 
@@ -69,6 +70,9 @@ public:
 	std::function<long()> idGeneratorFn = [&]() -> long {
 		return id++;
 	};
+	std::function<void(long)> reserveIdsFn = [&](long maxId) {
+		id = std::max(id, maxId + 1);
+	};
 
 	int initConnection() override {
 		return 0;
@@ -139,6 +143,13 @@ public:
 		return 0;
 	}
 
+	int reserveIds(long maxId) override {
+		if (reserveIdsFn) {
+			reserveIdsFn(maxId);
+		}
+		return 0;
+	}
+
 	int registerEntityIdGenerator() override {
 		return 0;
 	}
@@ -32,6 +32,7 @@
 struct TestWorldExtension {
 	std::function<void(const Operation& op, LocatedEntity& ent)> messageFn;
 	std::function<Ref<LocatedEntity>(const std::string&, const Atlas::Objects::Entity::RootEntity&)> addNewEntityFn;
+	std::function<void(LocatedEntity& ent)> delEntityFn;
 };
 
 struct TestWorld : public BaseWorld {
@@ -48,7 +49,7 @@ struct TestWorld : public BaseWorld {
 	explicit TestWorld(Ref<LocatedEntity> gw)
 			: BaseWorld([]() { return std::chrono::steady_clock::now().time_since_epoch(); }),
 			  m_gw(std::move(gw)) {
-		m_eobjects[m_gw->getIdAsInt()] = m_gw;
+		m_eobjects.insert(m_gw->getIdAsInt(), m_gw);
 	}
 
 	~TestWorld() override {
@@ -61,7 +62,7 @@ struct TestWorld : public BaseWorld {
 	}
 
 	void addEntity(const Ref<LocatedEntity>& ent, const Ref<LocatedEntity>& parent) override {
-		m_eobjects[ent->getIdAsInt()] = ent;
+		m_eobjects.insert(ent->getIdAsInt(), ent);
 		if (parent) {
 			parent->addChild(*ent);
 		}
@@ -77,7 +78,13 @@ struct TestWorld : public BaseWorld {
 		return nullptr;
 	}
 
-	void delEntity(LocatedEntity* obj) override {}
+	void delEntity(LocatedEntity* obj) override {
+		if (m_extension.delEntityFn) {
+			m_extension.delEntityFn(*obj);
+		} else if (extension.delEntityFn) {
+			extension.delEntityFn(*obj);
+		}
+	}
 
 	const std::set<std::string>& getSpawnEntities() const override {
 		static std::set<std::string> spawns;
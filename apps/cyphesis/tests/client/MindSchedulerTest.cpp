@@ -0,0 +1,142 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+#include "../TestPropertyManager.h"
+
+#include "client/aiclient/MindScheduler.h"
+#include "client/SimpleTypeStore.h"
+#include "common/Property_impl.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <sstream>
+
+using namespace std::chrono_literals;
+
+struct MindSchedulerTest : public Cyphesis::TestBase {
+	std::unique_ptr<TestPropertyManager<MemEntity>> propertyManager;
+	std::unique_ptr<TypeStore<MemEntity>> typeStore;
+
+	MindSchedulerTest() {
+		ADD_TEST(MindSchedulerTest::test_idleMindIsNotTicked);
+		ADD_TEST(MindSchedulerTest::test_queuedOperationsAreSent);
+		ADD_TEST(MindSchedulerTest::test_remove);
+		ADD_TEST(MindSchedulerTest::test_memoryStats);
+	}
+
+	void setup() override {
+		propertyManager = std::make_unique<TestPropertyManager<MemEntity>>();
+		typeStore = std::make_unique<SimpleTypeStore>(*propertyManager);
+	}
+
+	void teardown() override {
+		typeStore.reset();
+		propertyManager.reset();
+	}
+
+	void test_idleMindIsNotTicked() {
+		Ref<BaseMind> mind(new BaseMind(1, "2", *typeStore));
+		MindScheduler scheduler;
+		scheduler.add(mind);
+		ASSERT_EQUAL(scheduler.size(), 1u);
+
+		//A mind without an entity and without anything to send has nothing to do until it gets an operation.
+		ASSERT_FALSE(scheduler.getNextTickTime());
+
+		OpVector res;
+		ASSERT_EQUAL(scheduler.tickDue(std::chrono::steady_clock::now(), 10ms, res), 0u);
+		ASSERT_TRUE(res.empty());
+	}
+
+	void test_queuedOperationsAreSent() {
+		Ref<BaseMind> mind(new BaseMind(1, "2", *typeStore));
+		MindScheduler scheduler;
+		scheduler.add(mind);
+
+		//Learning about a new entity queues up a Look, which should make the mind due.
+		mind->getMap()->getAdd("3");
+		scheduler.operationHandled(*mind, 1ms);
+		ASSERT_TRUE(scheduler.getNextTickTime());
+
+		OpVector res;
+		ASSERT_EQUAL(scheduler.tickDue(std::chrono::steady_clock::now(), 10ms, res), 1u);
+		ASSERT_EQUAL(res.size(), 1u);
+		ASSERT_EQUAL(res.front()->getClassNo(), Atlas::Objects::Operation::LOOK_NO);
+		ASSERT_EQUAL(res.front()->getFrom(), mind->getIdAsString());
+
+		//With the look sent the mind is idle again.
+		ASSERT_FALSE(scheduler.getNextTickTime());
+
+		auto stats = scheduler.getStats(*mind);
+		ASSERT_NOT_NULL(stats);
+		ASSERT_EQUAL(stats->ticks, 1u);
+		ASSERT_EQUAL(stats->operations, 1u);
+		ASSERT_TRUE(stats->operationTime == 1ms);
+	}
+
+	void test_remove() {
+		Ref<BaseMind> mind(new BaseMind(1, "2", *typeStore));
+		MindScheduler scheduler;
+		scheduler.add(mind);
+		mind->getMap()->getAdd("3");
+		scheduler.reschedule(*mind);
+		ASSERT_TRUE(scheduler.getNextTickTime());
+
+		scheduler.remove(*mind);
+		ASSERT_EQUAL(scheduler.size(), 0u);
+		ASSERT_FALSE(scheduler.getNextTickTime());
+		ASSERT_NULL(scheduler.getStats(*mind));
+	}
+
+	void test_memoryStats() {
+		Ref<BaseMind> mind(new BaseMind(1, "2", *typeStore));
+		MindScheduler scheduler;
+		scheduler.add(mind);
+		mind->getMap()->getAdd("3");
+		mind->getMap()->getAdd("4");
+		scheduler.operationHandled(*mind, 1ms);
+
+		auto stats = scheduler.getStats(*mind);
+		ASSERT_NOT_NULL(stats);
+		ASSERT_EQUAL(stats->rememberedEntities, 2u);
+
+		std::stringstream ss;
+		Metrics::instance().render(ss);
+		ASSERT_NOT_EQUAL(ss.str().find("mind_remembered_entities{mind=\"1\"} 2\n"), std::string::npos);
+
+		//The metrics of a mind go away with it.
+		scheduler.remove(*mind);
+		std::stringstream ssAfterRemove;
+		Metrics::instance().render(ssAfterRemove);
+		ASSERT_EQUAL(ssAfterRemove.str().find("mind_remembered_entities{mind=\"1\"}"), std::string::npos);
+	}
+};
+
+int main() {
+	MindSchedulerTest t;
+
+	return t.run();
+}
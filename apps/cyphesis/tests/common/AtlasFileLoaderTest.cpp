@@ -31,6 +31,9 @@
 #include <Atlas/Objects/SmartPtr.h>
 
 #include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
 #include <Atlas/Objects/Factories.h>
 
 int main() {
@@ -66,6 +69,27 @@ int main() {
 		assert((unsigned int) loader.count() == data.size());
 	}
 
+	{
+		// Test that objects without an ID are counted as errors
+		auto path = std::filesystem::temp_directory_path() / ("AtlasFileLoaderTest-" + std::to_string(getpid()) + ".xml");
+		{
+			std::ofstream file(path);
+			file << "<atlas>"
+					"<map><string name=\"id\">foo</string><string name=\"objtype\">class</string></map>"
+					"<map><string name=\"objtype\">class</string></map>"
+					"</atlas>";
+		}
+		std::map<std::string, Atlas::Objects::Root> data;
+		AtlasFileLoader loader(factories, path.string(), data);
+		assert(loader.isOpen());
+		loader.read();
+		std::filesystem::remove(path);
+
+		assert(loader.count() == 1);
+		assert(loader.errorCount() == 1);
+		assert(data.count("foo") == 1);
+	}
+
 	return 0;
 }
 
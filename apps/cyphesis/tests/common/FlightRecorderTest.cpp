@@ -0,0 +1,182 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software Foundation,
+ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "common/FlightRecorder.h"
+
+#include <fstream>
+#include <sstream>
+
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+struct FlightRecorderTest : public Cyphesis::TestBase {
+	std::filesystem::path m_directory;
+	std::chrono::steady_clock::time_point m_now;
+
+	FlightRecorderTest() {
+		ADD_TEST(FlightRecorderTest::test_ringBuffer);
+		ADD_TEST(FlightRecorderTest::test_phases);
+		ADD_TEST(FlightRecorderTest::test_scopedPhase);
+		ADD_TEST(FlightRecorderTest::test_ops);
+		ADD_TEST(FlightRecorderTest::test_dump);
+	}
+
+	void setup() override {
+		m_directory = std::filesystem::temp_directory_path() / ("FlightRecorderTest-" + std::to_string(getpid()));
+		m_now = std::chrono::steady_clock::now();
+	}
+
+	void teardown() override {
+		std::filesystem::remove_all(m_directory);
+	}
+
+	void test_ringBuffer() {
+		FlightRecorder recorder(3);
+		ASSERT_TRUE(recorder.getFrames().empty());
+		for (int i = 0; i < 5; ++i) {
+			recorder.beginFrame(m_now + i * 10ms);
+			recorder.endFrame(m_now + i * 10ms + 5ms);
+		}
+		auto frames = recorder.getFrames();
+		ASSERT_EQUAL(frames.size(), 3u);
+		ASSERT_EQUAL(frames[0]->number, 2u);
+		ASSERT_EQUAL(frames[2]->number, 4u);
+		ASSERT_TRUE(frames[2]->duration == 5ms);
+	}
+
+	void test_phases() {
+		FlightRecorder recorder(3);
+		//Nothing is recorded outside of frames.
+		recorder.addPhase("physics", 1ms);
+		recorder.beginFrame(m_now);
+		std::string name = "physics";
+		recorder.addPhase("physics", 1ms);
+		recorder.addPhase("io", 3ms);
+		//Phases are matched by name, not only by pointer.
+		recorder.addPhase(name.c_str(), 2ms);
+		recorder.endFrame(m_now + 10ms);
+
+		auto& frame = *recorder.getFrames().front();
+		ASSERT_EQUAL(frame.phaseCount, 2u);
+		ASSERT_EQUAL(std::string(frame.phases[0].name), "physics");
+		ASSERT_TRUE(frame.phases[0].duration == 3ms);
+		ASSERT_TRUE(frame.phases[1].duration == 3ms);
+	}
+
+	void test_scopedPhase() {
+		//Without a recorder nothing should be recorded.
+		{
+			FlightRecorder::ScopedPhase phase("storage");
+		}
+
+		FlightRecorder recorder(3);
+		recorder.beginFrame(m_now);
+		{
+			FlightRecorder::ScopedPhase phase("storage");
+		}
+		recorder.endFrame(m_now + 10ms);
+
+		auto& frame = *recorder.getFrames().front();
+		ASSERT_EQUAL(frame.phaseCount, 1u);
+		ASSERT_EQUAL(std::string(frame.phases[0].name), "storage");
+	}
+
+	void test_ops() {
+		FlightRecorder recorder(3);
+		recorder.beginFrame(m_now);
+		for (long i = 0; i < 20; ++i) {
+			recorder.recordOp(1, "tick", i, std::chrono::milliseconds(i));
+		}
+		recorder.recordOp(2, "move", 100, 50ms);
+		recorder.endFrame(m_now + 10ms);
+
+		auto& frame = *recorder.getFrames().front();
+		ASSERT_EQUAL(frame.opCount, 21u);
+		ASSERT_EQUAL(frame.opTypeCount, 2u);
+		ASSERT_EQUAL(frame.opTypes[0].name, "tick");
+		ASSERT_EQUAL(frame.opTypes[0].count, 20u);
+		ASSERT_TRUE(frame.opTypes[0].duration == 190ms);
+
+		//Only the slowest ops are kept.
+		ASSERT_EQUAL(frame.slowestOpCount, FlightRecorder::maxSlowestOps);
+		bool foundMove = false;
+		for (size_t i = 0; i < frame.slowestOpCount; ++i) {
+			auto& sample = frame.slowestOps[i];
+			ASSERT_TRUE(sample.duration >= 13ms);
+			if (sample.type == "move") {
+				foundMove = true;
+				ASSERT_EQUAL(sample.entityId, 100);
+			}
+		}
+		ASSERT_TRUE(foundMove);
+
+		//Slots are reused for new frames.
+		recorder.beginFrame(m_now + 10ms);
+		recorder.endFrame(m_now + 20ms);
+		ASSERT_EQUAL(recorder.getFrames().back()->opCount, 0u);
+		ASSERT_EQUAL(recorder.getFrames().back()->slowestOpCount, 0u);
+	}
+
+	void test_dump() {
+		FlightRecorder recorder(10);
+		recorder.beginFrame(m_now);
+		ASSERT_FALSE(recorder.endFrame(m_now + 200ms).has_value());
+
+		recorder.enableDumps(m_directory, 100ms, 1min);
+		recorder.beginFrame(m_now + 1s);
+		ASSERT_FALSE(recorder.endFrame(m_now + 1s + 50ms).has_value());
+
+		recorder.beginFrame(m_now + 2s);
+		recorder.addPhase("process_ops", 150ms);
+		recorder.recordOp(1, "tick", 42, 140ms);
+		auto path = recorder.endFrame(m_now + 2s + 150ms);
+		ASSERT_TRUE(path.has_value());
+		ASSERT_TRUE(std::filesystem::exists(*path));
+
+		std::ifstream file(*path);
+		std::stringstream contents;
+		contents << file.rdbuf();
+		ASSERT_NOT_EQUAL(contents.str().find("Frame 2 took 150.00 ms"), std::string::npos);
+		ASSERT_NOT_EQUAL(contents.str().find("process_ops: 150.00 ms"), std::string::npos);
+		ASSERT_NOT_EQUAL(contents.str().find("tick to entity 42: 140.00 ms"), std::string::npos);
+		//All recorded frames are included.
+		ASSERT_NOT_EQUAL(contents.str().find("  0 -2000.00 ms 200.00 ms"), std::string::npos);
+
+		//Dumps are rate limited.
+		recorder.beginFrame(m_now + 3s);
+		ASSERT_FALSE(recorder.endFrame(m_now + 3s + 150ms).has_value());
+		recorder.beginFrame(m_now + 2s + 1min);
+		ASSERT_TRUE(recorder.endFrame(m_now + 2s + 1min + 150ms).has_value());
+	}
+};
+
+int main() {
+	FlightRecorderTest t;
+
+	return t.run();
+}
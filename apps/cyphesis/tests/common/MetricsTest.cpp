@@ -0,0 +1,166 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software Foundation,
+ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "common/Metrics.h"
+
+#include <sstream>
+#include <thread>
+
+struct MetricsTest : public Cyphesis::TestBase {
+
+	MetricsTest() {
+		ADD_TEST(MetricsTest::test_counterAndGauge);
+		ADD_TEST(MetricsTest::test_histogram);
+		ADD_TEST(MetricsTest::test_render);
+		ADD_TEST(MetricsTest::test_remove);
+		ADD_TEST(MetricsTest::test_concurrentUpdates);
+	}
+
+	void setup() override {
+	}
+
+	void teardown() override {
+	}
+
+	void test_counterAndGauge() {
+		Metrics metrics;
+		auto& counter = metrics.counter("ops_total", "Ops.");
+		counter.increment();
+		counter.increment(2);
+		ASSERT_EQUAL(counter.value(), 3u);
+
+		//Asking again should give the same instance, while other labels give another.
+		ASSERT_EQUAL(&metrics.counter("ops_total", "Ops."), &counter);
+		ASSERT_NOT_EQUAL(&metrics.counter("ops_total", "Ops.", {{"type", "look"}}), &counter);
+
+		auto& gauge = metrics.gauge("queue", "Queue.");
+		gauge.set(10);
+		gauge.add(-3);
+		ASSERT_EQUAL(gauge.value(), 7);
+
+		//A name can only be used by one type of metric.
+		bool thrown = false;
+		try {
+			metrics.gauge("ops_total", "Ops.");
+		} catch (const std::invalid_argument&) {
+			thrown = true;
+		}
+		ASSERT_TRUE(thrown);
+	}
+
+	void test_histogram() {
+		Metrics metrics;
+		auto& histogram = metrics.histogram("latency", "Latency.", {}, {0.1, 1.0});
+		histogram.observe(0.05);
+		//Buckets include their upper bound.
+		histogram.observe(0.1);
+		histogram.observe(0.5);
+		histogram.observe(std::chrono::seconds(2));
+
+		ASSERT_EQUAL(histogram.bucketCount(0), 2u);
+		ASSERT_EQUAL(histogram.bucketCount(1), 1u);
+		ASSERT_EQUAL(histogram.bucketCount(2), 1u);
+		ASSERT_EQUAL(histogram.count(), 4u);
+		ASSERT_FUZZY_EQUAL(histogram.sum(), 2.65, 0.0001);
+
+		auto bounds = Metrics::exponentialBuckets(1, 2, 4);
+		ASSERT_EQUAL(bounds.size(), 4u);
+		ASSERT_FUZZY_EQUAL(bounds.back(), 8.0, 0.0001);
+	}
+
+	void test_render() {
+		Metrics metrics;
+		metrics.counter("ops_total", "Ops handled.", {{"type", "say \"hi\""}}).increment(4);
+		metrics.gauge("queue", "").set(3);
+		auto& histogram = metrics.histogram("latency_seconds", "Latency.", {{"type", "look"}}, {0.1, 1.0});
+		histogram.observe(0.05);
+		histogram.observe(0.5);
+		histogram.observe(5.0);
+
+		std::stringstream ss;
+		metrics.render(ss);
+		auto output = ss.str();
+
+		ASSERT_NOT_EQUAL(output.find("# HELP ops_total Ops handled.\n# TYPE ops_total counter\n"), std::string::npos);
+		ASSERT_NOT_EQUAL(output.find("ops_total{type=\"say \\\"hi\\\"\"} 4\n"), std::string::npos);
+		ASSERT_NOT_EQUAL(output.find("# TYPE queue gauge\nqueue 3\n"), std::string::npos);
+		ASSERT_NOT_EQUAL(output.find("# TYPE latency_seconds histogram\n"), std::string::npos);
+		//Buckets are cumulative.
+		ASSERT_NOT_EQUAL(output.find("latency_seconds_bucket{type=\"look\",le=\"0.1\"} 1\n"), std::string::npos);
+		ASSERT_NOT_EQUAL(output.find("latency_seconds_bucket{type=\"look\",le=\"1\"} 2\n"), std::string::npos);
+		ASSERT_NOT_EQUAL(output.find("latency_seconds_bucket{type=\"look\",le=\"+Inf\"} 3\n"), std::string::npos);
+		ASSERT_NOT_EQUAL(output.find("latency_seconds_sum{type=\"look\"} 5.55\n"), std::string::npos);
+		ASSERT_NOT_EQUAL(output.find("latency_seconds_count{type=\"look\"} 3\n"), std::string::npos);
+	}
+
+	void test_remove() {
+		Metrics metrics;
+		metrics.gauge("entities", "Entities.", {{"mind", "1"}}).set(3);
+		metrics.gauge("entities", "Entities.", {{"mind", "2"}}).set(4);
+		metrics.remove("entities", {{"mind", "1"}});
+		//Removing something which doesn't exist is fine.
+		metrics.remove("entities", {{"mind", "3"}});
+		metrics.remove("nothing", {});
+
+		std::stringstream ss;
+		metrics.render(ss);
+		auto output = ss.str();
+		ASSERT_EQUAL(output.find("entities{mind=\"1\"}"), std::string::npos);
+		ASSERT_NOT_EQUAL(output.find("entities{mind=\"2\"} 4\n"), std::string::npos);
+
+		//A removed metric starts over if registered again.
+		ASSERT_EQUAL(metrics.gauge("entities", "Entities.", {{"mind", "1"}}).value(), 0);
+	}
+
+	void test_concurrentUpdates() {
+		Metrics metrics;
+		auto& counter = metrics.counter("ops_total", "Ops.");
+		auto& histogram = metrics.histogram("latency", "Latency.");
+
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 4; ++i) {
+			threads.emplace_back([&]() {
+				for (int j = 0; j < 10000; ++j) {
+					counter.increment();
+					histogram.observe(0.001);
+				}
+			});
+		}
+		for (auto& thread: threads) {
+			thread.join();
+		}
+		ASSERT_EQUAL(counter.value(), 40000u);
+		ASSERT_EQUAL(histogram.count(), 40000u);
+		ASSERT_FUZZY_EQUAL(histogram.sum(), 40.0, 0.001);
+	}
+};
+
+int main() {
+	MetricsTest t;
+
+	return t.run();
+}
@@ -0,0 +1,234 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "common/net/SharedMemoryChannel.h"
+
+#include <boost/asio/local/connect_pair.hpp>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <string>
+
+struct SharedMemoryChannelTest : public Cyphesis::TestBase {
+
+	SharedMemoryChannelTest() {
+		ADD_TEST(SharedMemoryChannelTest::test_ring);
+		ADD_TEST(SharedMemoryChannelTest::test_transfer);
+		ADD_TEST(SharedMemoryChannelTest::test_close);
+		ADD_TEST(SharedMemoryChannelTest::test_badRingSize);
+	}
+
+	void setup() override {
+	}
+
+	void teardown() override {
+	}
+
+	/**
+	 * Sets up a channel between two sockets in the same process.
+	 */
+	static std::pair<std::shared_ptr<SharedMemoryChannel>, std::shared_ptr<SharedMemoryChannel>> createPair(boost::asio::io_context& io_context,
+																											 boost::asio::local::stream_protocol::socket& creatorSocket,
+																											 boost::asio::local::stream_protocol::socket& receiverSocket,
+																											 std::size_t ringSize) {
+		boost::asio::local::connect_pair(creatorSocket, receiverSocket);
+		auto creator = SharedMemoryChannel::create(io_context, ringSize);
+		creator->sendDescriptors(creatorSocket);
+		std::shared_ptr<SharedMemoryChannel> receiver;
+		SharedMemoryChannel::asyncReceive(io_context, receiverSocket, [&](std::shared_ptr<SharedMemoryChannel> channel) {
+			receiver = std::move(channel);
+		});
+		io_context.run();
+		io_context.restart();
+		return {creator, receiver};
+	}
+
+	void test_ring() {
+		std::array<char, sizeof(SharedMemoryRing::Header) + 16> memory{};
+		SharedMemoryRing ring(memory.data(), 16);
+		ring.initialize();
+
+		std::array<char, 32> buffer{};
+		ASSERT_EQUAL(ring.write("0123456789", 10), 10u);
+		ASSERT_EQUAL(ring.read(buffer.data(), 6), 6u);
+		ASSERT_EQUAL(std::string(buffer.data(), 6), "012345");
+		//Wraps around the end of the data.
+		ASSERT_EQUAL(ring.write("abcdefghijklmnop", 16), 12u);
+		ASSERT_EQUAL(ring.space(), 0u);
+		ASSERT_EQUAL(ring.available(), 16u);
+		ASSERT_EQUAL(ring.read(buffer.data(), buffer.size()), 16u);
+		ASSERT_EQUAL(std::string(buffer.data(), 16), "6789abcdefghijkl");
+		ASSERT_EQUAL(ring.read(buffer.data(), buffer.size()), 0u);
+	}
+
+	void test_transfer() {
+		boost::asio::io_context io_context;
+		boost::asio::local::stream_protocol::socket creatorSocket(io_context);
+		boost::asio::local::stream_protocol::socket receiverSocket(io_context);
+		//Use a small ring, so that the writer has to wait for the reader.
+		auto [creator, receiver] = createPair(io_context, creatorSocket, receiverSocket, 1024);
+		ASSERT_NOT_NULL(creator.get());
+		ASSERT_NOT_NULL(receiver.get());
+
+		std::string data;
+		for (int i = 0; data.size() < 100000; ++i) {
+			data += std::to_string(i);
+		}
+
+		bool written = false;
+		creator->async_write(boost::asio::buffer(data), [&](boost::system::error_code ec, std::size_t length) {
+			ASSERT_FALSE(ec);
+			ASSERT_EQUAL(length, data.size());
+			written = true;
+		});
+
+		std::string received;
+		std::array<char, 700> buffer{};
+		std::function<void(boost::system::error_code, std::size_t)> readHandler = [&](boost::system::error_code ec, std::size_t length) {
+			ASSERT_FALSE(ec);
+			received.append(buffer.data(), length);
+			if (received.size() < data.size()) {
+				receiver->async_read_some(boost::asio::buffer(buffer), readHandler);
+			}
+		};
+		receiver->async_read_some(boost::asio::buffer(buffer), readHandler);
+
+		//Also send the other way at the same time.
+		std::string reply = "reply";
+		receiver->async_write(boost::asio::buffer(reply), [this](boost::system::error_code ec, std::size_t) {
+			ASSERT_FALSE(ec);
+		});
+		std::array<char, 16> replyBuffer{};
+		std::string receivedReply;
+		creator->async_read_some(boost::asio::buffer(replyBuffer), [&](boost::system::error_code ec, std::size_t length) {
+			ASSERT_FALSE(ec);
+			receivedReply.append(replyBuffer.data(), length);
+		});
+
+		io_context.run();
+
+		ASSERT_TRUE(written);
+		ASSERT_TRUE(received == data);
+		ASSERT_EQUAL(receivedReply, reply);
+	}
+
+	void test_close() {
+		boost::asio::io_context io_context;
+		boost::asio::local::stream_protocol::socket creatorSocket(io_context);
+		boost::asio::local::stream_protocol::socket receiverSocket(io_context);
+		auto [creator, receiver] = createPair(io_context, creatorSocket, receiverSocket, 1024);
+
+		std::string data = "last words";
+		creator->async_write(boost::asio::buffer(data), [](boost::system::error_code, std::size_t) {});
+		creator->close();
+
+		//Anything written before closing should still arrive, followed by eof.
+		std::array<char, 64> buffer{};
+		std::string received;
+		boost::system::error_code lastError;
+		std::function<void(boost::system::error_code, std::size_t)> readHandler = [&](boost::system::error_code ec, std::size_t length) {
+			received.append(buffer.data(), length);
+			if (ec) {
+				lastError = ec;
+			} else {
+				receiver->async_read_some(boost::asio::buffer(buffer), readHandler);
+			}
+		};
+		receiver->async_read_some(boost::asio::buffer(buffer), readHandler);
+
+		io_context.run();
+
+		ASSERT_EQUAL(received, data);
+		ASSERT_TRUE(lastError == boost::asio::error::eof);
+	}
+
+	/**
+	 * Sends an announcement with a shared memory of the specified size, and returns whether it was accepted.
+	 */
+	static bool receiveAnnouncement(std::size_t memorySize, std::uint64_t ringSize) {
+		boost::asio::io_context io_context;
+		boost::asio::local::stream_protocol::socket senderSocket(io_context);
+		boost::asio::local::stream_protocol::socket receiverSocket(io_context);
+		boost::asio::local::connect_pair(senderSocket, receiverSocket);
+
+		//Same layout as the announcement sent by SharedMemoryChannel::sendDescriptors().
+		struct {
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint64_t ringSize;
+		} announcement{0x57465348, 1, ringSize};
+
+		int descriptors[3] = {::memfd_create("test", MFD_CLOEXEC), ::eventfd(0, EFD_CLOEXEC), ::eventfd(0, EFD_CLOEXEC)};
+		assert(::ftruncate(descriptors[0], static_cast<off_t>(memorySize)) == 0);
+		iovec iov{&announcement, sizeof(announcement)};
+		alignas(cmsghdr) char control[CMSG_SPACE(sizeof(descriptors))] = {};
+		msghdr message{};
+		message.msg_iov = &iov;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+		auto cmsg = CMSG_FIRSTHDR(&message);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(descriptors));
+		std::memcpy(CMSG_DATA(cmsg), descriptors, sizeof(descriptors));
+		assert(::sendmsg(senderSocket.native_handle(), &message, 0) == static_cast<ssize_t>(sizeof(announcement)));
+		for (auto descriptor: descriptors) {
+			::close(descriptor);
+		}
+
+		std::shared_ptr<SharedMemoryChannel> receiver;
+		SharedMemoryChannel::asyncReceive(io_context, receiverSocket, [&](std::shared_ptr<SharedMemoryChannel> channel) {
+			receiver = std::move(channel);
+		});
+		io_context.run();
+		return receiver != nullptr;
+	}
+
+	void test_badRingSize() {
+		auto memorySize = (sizeof(SharedMemoryRing::Header) + 1024) * 2;
+		ASSERT_TRUE(receiveAnnouncement(memorySize, 1024));
+		ASSERT_FALSE(receiveAnnouncement(memorySize, 0));
+		ASSERT_FALSE(receiveAnnouncement(memorySize, 1000));
+		//Larger than the shared memory.
+		ASSERT_FALSE(receiveAnnouncement(memorySize, 2048));
+		ASSERT_FALSE(receiveAnnouncement(memorySize, std::uint64_t(1) << 63));
+	}
+};
+
+
+int main() {
+	SharedMemoryChannelTest t;
+
+	return t.run();
+}
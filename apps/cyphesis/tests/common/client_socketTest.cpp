@@ -32,6 +32,7 @@ int main() {
 	(void) client_socket_name;
 	(void) python_socket_name;
 	(void) slave_socket_name;
+	(void) shared_memory_socket_name;
 
 	return 0;
 }
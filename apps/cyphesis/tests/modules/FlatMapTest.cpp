@@ -0,0 +1,110 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software Foundation,
+ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "modules/FlatMap.h"
+#include "../TestBase.h"
+
+#include <memory>
+#include <string>
+
+struct FlatMapTest : public Cyphesis::TestBase {
+	FlatMapTest() {
+		ADD_TEST(FlatMapTest::test_insertAndFind);
+		ADD_TEST(FlatMapTest::test_ordered);
+		ADD_TEST(FlatMapTest::test_erase);
+		ADD_TEST(FlatMapTest::test_moveOnlyValues);
+	}
+
+	void setup() override {
+	}
+
+	void teardown() override {
+	}
+
+	void test_insertAndFind() {
+		FlatMap<std::string, int> map;
+		ASSERT_TRUE(map.empty());
+		ASSERT_TRUE(map.find("foo") == map.end());
+
+		map["foo"] = 1;
+		map["bar"] = 2;
+		//Accessing an existing key shouldn't add anything.
+		map["foo"] = 3;
+
+		ASSERT_EQUAL(map.size(), 2u);
+		ASSERT_EQUAL(map.count("foo"), 1u);
+		ASSERT_EQUAL(map.count("baz"), 0u);
+		ASSERT_EQUAL(map.find("foo")->second, 3);
+		ASSERT_EQUAL(map.find("bar")->second, 2);
+
+		const auto& constMap = map;
+		ASSERT_TRUE(constMap.find("bar") != constMap.end());
+		ASSERT_TRUE(constMap.find("baz") == constMap.end());
+	}
+
+	void test_ordered() {
+		FlatMap<std::string, int> map;
+		map["c"] = 3;
+		map["a"] = 1;
+		map["b"] = 2;
+
+		std::string keys;
+		for (auto& entry: map) {
+			keys += entry.first;
+		}
+		ASSERT_EQUAL(keys, "abc");
+	}
+
+	void test_erase() {
+		FlatMap<std::string, int> map;
+		map["a"] = 1;
+		map["b"] = 2;
+		map["c"] = 3;
+
+		ASSERT_EQUAL(map.erase("b"), 1u);
+		ASSERT_EQUAL(map.erase("b"), 0u);
+		ASSERT_EQUAL(map.size(), 2u);
+
+		auto I = map.erase(map.find("a"));
+		ASSERT_EQUAL(I->first, "c");
+
+		map.clear();
+		ASSERT_TRUE(map.empty());
+	}
+
+	void test_moveOnlyValues() {
+		FlatMap<std::string, std::unique_ptr<int>> map;
+		map["b"] = std::make_unique<int>(2);
+		map["a"] = std::make_unique<int>(1);
+		ASSERT_EQUAL(*map.find("a")->second, 1);
+		ASSERT_EQUAL(*map.find("b")->second, 2);
+	}
+};
+
+int main() {
+	FlatMapTest t;
+
+	return t.run();
+}
@@ -0,0 +1,160 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "navigation/Crowd.h"
+#include "navigation/Awareness.h"
+#include "navigation/Steering.h"
+#include "rules/ai/MemEntity.h"
+
+#include <algorithm>
+
+using namespace std::chrono_literals;
+
+struct CrowdTest : public Cyphesis::TestBase {
+
+	CrowdTest() {
+		ADD_TEST(CrowdTest::test_neighbours);
+		ADD_TEST(CrowdTest::test_movingNeighbours);
+		ADD_TEST(CrowdTest::test_pathQueue);
+	}
+
+	void setup() override {
+	}
+
+	void teardown() override {
+	}
+
+	static std::unique_ptr<EntityEntry> createEntry(long id, WFMath::Point<3> pos, WFMath::Vector<3> velocity = WFMath::Vector<3>::ZERO()) {
+		auto entry = std::make_unique<EntityEntry>();
+		entry->entityId = id;
+		entry->pos.data = pos;
+		entry->pos.timestamp = 0ms;
+		entry->velocity.data = velocity;
+		entry->velocity.timestamp = 0ms;
+		entry->bbox.data = {{-1, 0, -1},
+							{1,  1, 1}};
+		return entry;
+	}
+
+	static bool contains(const std::vector<const EntityEntry*>& entries, const EntityEntry* entry) {
+		return std::find(entries.begin(), entries.end(), entry) != entries.end();
+	}
+
+	void test_neighbours() {
+		auto near = createEntry(1, {2, 0, 2});
+		auto acrossCell = createEntry(2, {-3, 0, -3});
+		auto far = createEntry(3, {100, 0, 100});
+		std::set<const EntityEntry*> movingEntities{near.get(), acrossCell.get(), far.get()};
+
+		Crowd crowd(movingEntities);
+		crowd.ensureNeighbours(0ms);
+
+		std::vector<const EntityEntry*> neighbours;
+		crowd.findNeighbours({0, 0}, 5, 0ms, neighbours);
+		ASSERT_TRUE(contains(neighbours, near.get()));
+		ASSERT_TRUE(contains(neighbours, acrossCell.get()));
+		ASSERT_FALSE(contains(neighbours, far.get()));
+
+		neighbours.clear();
+		crowd.findNeighbours({100, 100}, 5, 0ms, neighbours);
+		ASSERT_EQUAL(neighbours.size(), 1u);
+		ASSERT_EQUAL(neighbours.front(), far.get());
+
+		//Entities removed from the moving entities must not be returned once the crowd has been invalidated.
+		movingEntities.erase(far.get());
+		crowd.invalidateNeighbours();
+		crowd.ensureNeighbours(0ms);
+		neighbours.clear();
+		crowd.findNeighbours({100, 100}, 5, 0ms, neighbours);
+		ASSERT_TRUE(neighbours.empty());
+	}
+
+	void test_movingNeighbours() {
+		//Moves ten meters per second along the x axis.
+		auto moving = createEntry(1, {0, 0, 0}, {10, 0, 0});
+		std::set<const EntityEntry*> movingEntities{moving.get()};
+
+		Crowd crowd(movingEntities, 20ms);
+		crowd.ensureNeighbours(0ms);
+
+		std::vector<const EntityEntry*> neighbours;
+		crowd.findNeighbours({0, 0}, 2, 0ms, neighbours);
+		ASSERT_EQUAL(neighbours.size(), 1u);
+
+		//After a second the entity should be found at its new position, as the hash is rebuilt in a new tick.
+		crowd.ensureNeighbours(1000ms);
+		neighbours.clear();
+		crowd.findNeighbours({10, 0}, 2, 1000ms, neighbours);
+		ASSERT_EQUAL(neighbours.size(), 1u);
+		neighbours.clear();
+		crowd.findNeighbours({-20, 0}, 2, 1000ms, neighbours);
+		ASSERT_TRUE(neighbours.empty());
+
+		auto projected = Crowd::projectPosition(*moving, 1000ms);
+		ASSERT_FUZZY_EQUAL(10.0, projected.x(), 0.0001);
+		ASSERT_FUZZY_EQUAL(0.0, projected.y(), 0.0001);
+	}
+
+	void test_pathQueue() {
+		std::set<const EntityEntry*> movingEntities;
+		Crowd crowd(movingEntities, 20ms, 2);
+
+		Ref<MemEntity> entity(new MemEntity(1, nullptr));
+		std::vector<std::unique_ptr<Steering>> steerings;
+		for (int i = 0; i < 5; ++i) {
+			steerings.emplace_back(std::make_unique<Steering>(*entity));
+			crowd.requestPath(*steerings.back());
+		}
+		//Requesting again shouldn't queue another request.
+		crowd.requestPath(*steerings.front());
+		ASSERT_EQUAL(crowd.pendingPathRequests(), 5u);
+
+		crowd.cancelPathRequest(*steerings[1]);
+		ASSERT_FALSE(crowd.isPathRequested(*steerings[1]));
+		ASSERT_EQUAL(crowd.pendingPathRequests(), 4u);
+
+		//Only two paths are found each tick, in the order they were requested.
+		crowd.update(0ms);
+		ASSERT_EQUAL(crowd.pendingPathRequests(), 2u);
+		ASSERT_FALSE(crowd.isPathRequested(*steerings[0]));
+		ASSERT_FALSE(crowd.isPathRequested(*steerings[2]));
+		ASSERT_TRUE(crowd.isPathRequested(*steerings[3]));
+
+		//Nothing happens within the same tick.
+		crowd.update(10ms);
+		ASSERT_EQUAL(crowd.pendingPathRequests(), 2u);
+
+		crowd.update(20ms);
+		ASSERT_EQUAL(crowd.pendingPathRequests(), 0u);
+	}
+};
+
+int main() {
+	CrowdTest t;
+
+	return t.run();
+}
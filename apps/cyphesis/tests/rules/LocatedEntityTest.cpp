@@ -64,6 +64,8 @@ public:
 
 	void test_coverage();
 
+	void test_changeLog_moveChild();
+
 	class TestProperty : public PropertyBase {
 	public:
 		virtual void remove(LocatedEntity&, const std::string& name);
@@ -103,6 +105,7 @@ LocatedEntitytest::LocatedEntitytest() {
 	ADD_TEST(LocatedEntitytest::test_setProperty);
 	ADD_TEST(LocatedEntitytest::test_removeAttr);
 	ADD_TEST(LocatedEntitytest::test_coverage);
+	ADD_TEST(LocatedEntitytest::test_changeLog_moveChild);
 }
 
 void LocatedEntitytest::setup() {
@@ -203,6 +206,31 @@ void LocatedEntitytest::test_coverage() {
 
 }
 
+void LocatedEntitytest::test_changeLog_moveChild() {
+	Ref<LocatedEntity> oldParent = new LocatedEntityTest(RouterId{2});
+	Ref<LocatedEntity> newParent = new LocatedEntityTest(RouterId{3});
+	Ref<LocatedEntity> child = new LocatedEntityTest(RouterId{4});
+
+	oldParent->addChild(*child);
+	int oldParentSeq = oldParent->getSeq();
+	int newParentSeq = newParent->getSeq();
+
+	child->changeContainer(newParent);
+
+	//Both containers must tell observers which know an earlier version that "contains" has changed.
+	ASSERT_GREATER(oldParent->getSeq(), oldParentSeq);
+	auto changed = oldParent->getChangeLog().changedSince(oldParentSeq, oldParent->getSeq());
+	ASSERT_TRUE(changed.has_value());
+	ASSERT_TRUE(changed->changed.contains("contains"));
+
+	ASSERT_GREATER(newParent->getSeq(), newParentSeq);
+	changed = newParent->getChangeLog().changedSince(newParentSeq, newParent->getSeq());
+	ASSERT_TRUE(changed.has_value());
+	ASSERT_TRUE(changed->changed.contains("contains"));
+
+	newParent->removeChild(*child);
+}
+
 int main() {
 	TestPropertyManager<LocatedEntity> propertyManager;
 	LocatedEntityTest::propertyManager = &propertyManager;
@@ -36,6 +36,19 @@
 #include "client/SimpleTypeStore.h"
 #include "common/Property_impl.h"
 
+class TestMind : public BaseMind {
+public:
+	bool moveActive = false;
+
+	TestMind(RouterId mindId, std::string entityId, TypeStore<MemEntity>& typeStore) :
+			BaseMind(std::move(mindId), std::move(entityId), typeStore) {
+	}
+
+	bool isMoveActive() const override {
+		return moveActive;
+	}
+};
+
 class BaseMindtest : public Cyphesis::TestBase {
 protected:
 	Ref<BaseMind> bm;
@@ -72,7 +85,11 @@ public:
 
 	void test_disappearanceOperation();
 
+	void test_reappearance();
+
 	void test_unseenOperation();
+
+	void test_nextTickTime();
 };
 
 BaseMindtest::BaseMindtest() {
@@ -88,7 +105,9 @@ BaseMindtest::BaseMindtest() {
 	ADD_TEST(BaseMindtest::test_soundOperation);
 	ADD_TEST(BaseMindtest::test_appearanceOperation);
 	ADD_TEST(BaseMindtest::test_disappearanceOperation);
+	ADD_TEST(BaseMindtest::test_reappearance);
 	ADD_TEST(BaseMindtest::test_unseenOperation);
+	ADD_TEST(BaseMindtest::test_nextTickTime);
 }
 
 void BaseMindtest::setup() {
@@ -240,6 +259,72 @@ void BaseMindtest::test_disappearanceOperation() {
 	bm->operation(op, res);
 }
 
+void BaseMindtest::test_reappearance() {
+	Ref<TestMind> mind(new TestMind(3, "4", *typeStore));
+	OpVector res;
+	mind->setOwnEntity(res, Ref<MemEntity>(new MemEntity(4, nullptr)));
+	mind->awake();
+
+	Atlas::Objects::Operation::Sight sight;
+	Atlas::Objects::Entity::Anonymous sightArg;
+	sightArg->setId("5");
+	sightArg->setStamp(5);
+	sightArg->setAttr("name", "rock");
+	sightArg->setAttr("status", 1.0);
+	sightArg->setAttr("mass", 10.0);
+	sight->setArgs1(sightArg);
+	sight->setStamp(1);
+	mind->operation(sight, res);
+	ASSERT_EQUAL(5, mind->getMap()->get("5")->getSeq());
+
+	Atlas::Objects::Operation::Disappearance disappearance;
+	Atlas::Objects::Entity::Anonymous disappearanceArg;
+	disappearanceArg->setId("5");
+	disappearance->setArgs1(disappearanceArg);
+	mind->operation(disappearance, res);
+	ASSERT_NULL(mind->getMap()->get("5").get());
+
+	//When the entity appears again we should tell the server which version we knew about.
+	res.clear();
+	Atlas::Objects::Operation::Appearance appearance;
+	Atlas::Objects::Entity::Anonymous appearanceArg;
+	appearanceArg->setId("5");
+	appearanceArg->setStamp(7);
+	appearance->setArgs1(appearanceArg);
+	mind->operation(appearance, res);
+	bool sentLook = false;
+	for (auto& op: res) {
+		if (op->getClassNo() == Atlas::Objects::Operation::LOOK_NO && !op->getArgs().empty() && op->getArgs().front()->getId() == "5") {
+			ASSERT_EQUAL(5, (int) op->getArgs().front()->getStamp());
+			sentLook = true;
+		}
+	}
+	ASSERT_TRUE(sentLook);
+
+	//The reply only contains what's changed since, which should be merged with what we knew about.
+	Atlas::Objects::Operation::Sight reply;
+	Atlas::Objects::Entity::Anonymous replyArg;
+	replyArg->setId("5");
+	replyArg->setStamp(7);
+	replyArg->setAttr("status", 0.5);
+	replyArg->setAttr("removed_properties", Atlas::Message::ListType{"mass"});
+	reply->setArgs1(replyArg);
+	reply->setStamp(2);
+	mind->operation(reply, res);
+
+	auto entity = mind->getMap()->get("5");
+	ASSERT_NOT_NULL(entity.get());
+	ASSERT_EQUAL(7, entity->getSeq());
+	Atlas::Message::Element value;
+	ASSERT_TRUE(entity->getProperties().find("name") != entity->getProperties().end());
+	entity->getProperties().find("name")->second.property->get(value);
+	ASSERT_EQUAL(std::string("rock"), value.asString());
+	entity->getProperties().find("status")->second.property->get(value);
+	ASSERT_EQUAL(0.5, value.asFloat());
+	ASSERT_TRUE(entity->getProperties().find("mass") == entity->getProperties().end());
+	ASSERT_TRUE(entity->getProperties().find("removed_properties") == entity->getProperties().end());
+}
+
 void BaseMindtest::test_unseenOperation() {
 	OpVector res;
 	Atlas::Objects::Operation::Unseen op;
@@ -253,6 +338,21 @@ void BaseMindtest::test_unseenOperation() {
 	bm->operation(op, res);
 }
 
+void BaseMindtest::test_nextTickTime() {
+	Ref<TestMind> mind(new TestMind(3, "4", *typeStore));
+	OpVector res;
+	mind->setOwnEntity(res, Ref<MemEntity>(new MemEntity(4, nullptr)));
+
+	//The first tick does all periodic work. After that nothing should be due until it's time to think again.
+	mind->processTick(res);
+	auto now = std::chrono::steady_clock::now();
+	ASSERT_TRUE(mind->getNextTickTime() > now + std::chrono::milliseconds(100));
+
+	//While moving, the much more frequent move updates should be done.
+	mind->moveActive = true;
+	ASSERT_TRUE(mind->getNextTickTime() < now + std::chrono::milliseconds(100));
+}
+
 int main() {
 	BaseMindtest t;
 
@@ -143,6 +143,10 @@ public:
 
 	void test_findByLoc_consistency_check();
 
+	void test_check_forgetsStale();
+
+	void test_check_limits();
+
 	static void Script_hook_called(const std::string&, MemEntity*);
 };
 
@@ -156,6 +160,32 @@ void MemMaptest::Script_hook_called(const std::string& hook, MemEntity* ent) {
 	m_Script_hook_called_with = ent;
 }
 
+struct TestMapListener : public MemMap::MapListener {
+	std::set<long> pinned;
+	std::vector<long> forgotten;
+
+	void entityAdded(MemEntity& entity) override {}
+
+	void entityUpdated(MemEntity& entity, const Atlas::Objects::Entity::RootEntity& ent, MemEntity* oldLocation) override {}
+
+	void entityDeleted(MemEntity& entity) override {}
+
+	void entityForgotten(MemEntity& entity) override {
+		forgotten.push_back(entity.getIdAsInt());
+	}
+
+	bool isEntityPinned(const MemEntity& entity) const override {
+		return pinned.count(entity.getIdAsInt()) > 0;
+	}
+};
+
+Anonymous createSampleEntity(const std::string& id) {
+	Anonymous data;
+	data->setId(id);
+	data->setParent("sample_type");
+	return data;
+}
+
 class TestScript : public Script<MemEntity> {
 public:
 	virtual void hook(const std::string& function, MemEntity* entity);
@@ -180,6 +210,8 @@ MemMaptest::MemMaptest() {
 	ADD_TEST(MemMaptest::test_findByLoc_results);
 	ADD_TEST(MemMaptest::test_findByLoc_invalid);
 	ADD_TEST(MemMaptest::test_findByLoc_consistency_check);
+	ADD_TEST(MemMaptest::test_check_forgetsStale);
+	ADD_TEST(MemMaptest::test_check_limits);
 }
 
 void MemMaptest::setup() {
@@ -442,6 +474,76 @@ void MemMaptest::test_findByLoc_consistency_check() {
 	ASSERT_TRUE(res.empty());
 }
 
+void MemMaptest::test_check_forgetsStale() {
+	TestMemMap tested(*m_typeResolver);
+	TestMapListener listener;
+	tested.setListener(&listener);
+	OpVector res;
+
+	tested.updateAdd(createSampleEntity("3"), std::chrono::seconds{0}, res);
+	tested.updateAdd(createSampleEntity("4"), std::chrono::seconds{0}, res);
+	tested.updateAdd(createSampleEntity("5"), std::chrono::seconds{0}, res);
+	tested.addEntityMemory("4", "disposition", 25);
+	listener.pinned.insert(5);
+
+	tested.check(std::chrono::seconds{60});
+	ASSERT_EQUAL(tested.getEntities().size(), 3u);
+
+	//Entities which we have memories about, or which are pinned, are never forgotten.
+	tested.check(std::chrono::seconds{601});
+	ASSERT_FALSE(tested.get("3"));
+	ASSERT_TRUE(tested.get("4"));
+	ASSERT_TRUE(tested.get("5"));
+	ASSERT_EQUAL(tested.getForgottenCount(), 1u);
+	ASSERT_EQUAL(listener.forgotten.size(), 1u);
+	ASSERT_EQUAL(listener.forgotten.front(), 3);
+
+	tested.setLimits({0, std::chrono::seconds{10}});
+	tested.updateAdd(createSampleEntity("3"), std::chrono::seconds{600}, res);
+	tested.check(std::chrono::seconds{605});
+	ASSERT_TRUE(tested.get("3"));
+	tested.check(std::chrono::seconds{611});
+	ASSERT_FALSE(tested.get("3"));
+	tested.setListener(nullptr);
+}
+
+void MemMaptest::test_check_limits() {
+	TestMemMap tested(*m_typeResolver);
+	TestMapListener listener;
+	tested.setListener(&listener);
+	tested.setLimits({2, std::chrono::seconds{600}});
+	OpVector res;
+
+	tested.updateAdd(createSampleEntity("3"), std::chrono::seconds{1}, res);
+	tested.updateAdd(createSampleEntity("4"), std::chrono::seconds{2}, res);
+	tested.updateAdd(createSampleEntity("5"), std::chrono::seconds{3}, res);
+	tested.addEntityMemory("3", "disposition", 25);
+
+	//The least recently seen entity which can be forgotten goes first.
+	tested.check(std::chrono::seconds{4});
+	ASSERT_EQUAL(tested.getEntities().size(), 2u);
+	ASSERT_TRUE(tested.get("3"));
+	ASSERT_FALSE(tested.get("4"));
+	ASSERT_TRUE(tested.get("5"));
+
+	//Seeing an entity again makes it the most recent one.
+	tested.updateAdd(createSampleEntity("5"), std::chrono::seconds{5}, res);
+	tested.updateAdd(createSampleEntity("4"), std::chrono::seconds{6}, res);
+	tested.check(std::chrono::seconds{7});
+	ASSERT_EQUAL(tested.getEntities().size(), 2u);
+	ASSERT_TRUE(tested.get("4"));
+	ASSERT_FALSE(tested.get("5"));
+
+	//If nothing can be forgotten the limit is exceeded.
+	listener.pinned.insert(4);
+	tested.updateAdd(createSampleEntity("6"), std::chrono::seconds{8}, res);
+	listener.pinned.insert(6);
+	tested.check(std::chrono::seconds{9});
+	ASSERT_EQUAL(tested.getEntities().size(), 3u);
+	ASSERT_EQUAL(tested.getForgottenCount(), 2u);
+	tested.setListener(nullptr);
+}
+
 int main() {
 	MemMaptest t;
 
@@ -0,0 +1,129 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software Foundation,
+ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../../TestBase.h"
+
+#include "rules/simulation/EntityChangeLog.h"
+
+struct EntityChangeLogTest : public Cyphesis::TestBase {
+
+	EntityChangeLogTest() {
+		ADD_TEST(EntityChangeLogTest::test_changedSince);
+		ADD_TEST(EntityChangeLogTest::test_bounded);
+		ADD_TEST(EntityChangeLogTest::test_removed);
+		ADD_TEST(EntityChangeLogTest::test_reset);
+	}
+
+	void setup() override {
+	}
+
+	void teardown() override {
+	}
+
+	void test_changedSince() {
+		EntityChangeLog log;
+		log.record(1, "name");
+		log.record(2, "pos");
+		log.record(3, "status");
+		log.record(4, "pos");
+
+		auto changed = log.changedSince(0, 4);
+		ASSERT_TRUE(changed.has_value());
+		ASSERT_EQUAL(changed->changed.size(), 3u);
+
+		changed = log.changedSince(2, 4);
+		ASSERT_TRUE(changed.has_value());
+		ASSERT_EQUAL(changed->changed.size(), 2u);
+		ASSERT_TRUE(changed->changed.contains("pos"));
+		ASSERT_TRUE(changed->changed.contains("status"));
+		ASSERT_TRUE(changed->removed.empty());
+
+		//Nothing has changed if the observer knows about the current version.
+		changed = log.changedSince(4, 4);
+		ASSERT_TRUE(changed.has_value());
+		ASSERT_TRUE(changed->changed.empty());
+
+		//The observer can't know about versions which don't exist yet.
+		ASSERT_FALSE(log.changedSince(5, 4).has_value());
+	}
+
+	void test_bounded() {
+		EntityChangeLog log(2);
+		log.record(1, "name");
+		log.record(2, "pos");
+		//Recording an already tracked property shouldn't evict anything.
+		log.record(3, "pos");
+		ASSERT_TRUE(log.changedSince(0, 3).has_value());
+
+		//Tracking a third property evicts "name", so observers which haven't seen that change need the whole entity.
+		log.record(4, "status");
+		ASSERT_FALSE(log.changedSince(0, 4).has_value());
+		auto changed = log.changedSince(1, 4);
+		ASSERT_TRUE(changed.has_value());
+		ASSERT_EQUAL(changed->changed.size(), 2u);
+		ASSERT_FALSE(changed->changed.contains("name"));
+	}
+
+	void test_removed() {
+		EntityChangeLog log;
+		log.record(1, "name");
+		log.record(2, "status");
+		log.recordRemoval(3, "status");
+
+		auto changed = log.changedSince(1, 3);
+		ASSERT_TRUE(changed.has_value());
+		ASSERT_TRUE(changed->changed.empty());
+		ASSERT_EQUAL(changed->removed.size(), 1u);
+		ASSERT_TRUE(changed->removed.contains("status"));
+
+		//Observers which already know about the removal shouldn't be told again.
+		changed = log.changedSince(3, 3);
+		ASSERT_TRUE(changed.has_value());
+		ASSERT_TRUE(changed->removed.empty());
+
+		//A property which is added again is changed, not removed.
+		log.record(4, "status");
+		changed = log.changedSince(1, 4);
+		ASSERT_TRUE(changed.has_value());
+		ASSERT_TRUE(changed->changed.contains("status"));
+		ASSERT_TRUE(changed->removed.empty());
+	}
+
+	void test_reset() {
+		EntityChangeLog log;
+		log.record(1, "name");
+		log.reset(2);
+		ASSERT_FALSE(log.changedSince(1, 2).has_value());
+		auto changed = log.changedSince(2, 2);
+		ASSERT_TRUE(changed.has_value());
+		ASSERT_TRUE(changed->changed.empty());
+	}
+};
+
+int main() {
+	EntityChangeLogTest t;
+
+	return t.run();
+}
@@ -0,0 +1,141 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software Foundation,
+ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../../TestBase.h"
+
+#include "rules/simulation/EntityRegistry.h"
+#include "rules/simulation/LocatedEntity.h"
+
+struct EntityRegistryTest : public Cyphesis::TestBase {
+
+	EntityRegistryTest() {
+		ADD_TEST(EntityRegistryTest::test_insertAndFind);
+		ADD_TEST(EntityRegistryTest::test_erase);
+		ADD_TEST(EntityRegistryTest::test_staleHandle);
+		ADD_TEST(EntityRegistryTest::test_clear);
+	}
+
+	void setup() override {
+	}
+
+	void teardown() override {
+	}
+
+	void test_insertAndFind() {
+		EntityRegistry registry;
+		Ref<LocatedEntity> e1(new LocatedEntity(1));
+		Ref<LocatedEntity> e2(new LocatedEntity(2));
+		registry.insert(1, e1);
+		registry.insert(2, e2);
+
+		ASSERT_EQUAL(registry.size(), 2u);
+		ASSERT_TRUE(registry.get(1) == e1.get());
+		ASSERT_TRUE(registry.get(2) == e2.get());
+		ASSERT_NULL(registry.get(3));
+		ASSERT_TRUE(registry.find(3) == registry.end());
+		ASSERT_TRUE(registry.find(2) != registry.end());
+		ASSERT_EQUAL(registry.find(2)->first, 2);
+
+		//Inserting with an existing id replaces the entity, and keeps the handle valid.
+		auto handle = registry.getHandle(1);
+		Ref<LocatedEntity> e1b(new LocatedEntity(1));
+		registry.insert(1, e1b);
+		ASSERT_EQUAL(registry.size(), 2u);
+		ASSERT_TRUE(registry.get(handle) == e1b.get());
+	}
+
+	void test_erase() {
+		EntityRegistry registry;
+		for (long i = 1; i <= 5; ++i) {
+			registry.insert(i, new LocatedEntity(i));
+		}
+		auto handle5 = registry.getHandle(5);
+
+		//Erasing from the middle moves the last entry, which must still be found.
+		ASSERT_TRUE(registry.erase(2));
+		ASSERT_FALSE(registry.erase(2));
+		ASSERT_EQUAL(registry.size(), 4u);
+		ASSERT_NULL(registry.get(2));
+		for (long i: {1, 3, 4, 5}) {
+			ASSERT_NOT_NULL(registry.get(i));
+			ASSERT_EQUAL(registry.get(i)->getIdAsInt(), i);
+		}
+		ASSERT_NOT_NULL(registry.get(handle5));
+		ASSERT_EQUAL(registry.get(handle5)->getIdAsInt(), 5);
+
+		size_t count = 0;
+		for (auto& entry: registry) {
+			ASSERT_EQUAL(entry.first, entry.second->getIdAsInt());
+			count++;
+		}
+		ASSERT_EQUAL(count, 4u);
+	}
+
+	void test_staleHandle() {
+		EntityRegistry registry;
+		auto handle = registry.insert(1, new LocatedEntity(1));
+		ASSERT_TRUE(handle.isValid());
+		ASSERT_NOT_NULL(registry.get(handle));
+
+		registry.erase(1);
+		ASSERT_NULL(registry.get(handle));
+
+		//The slot is reused, but the old handle must not resolve to the new entity.
+		auto newHandle = registry.insert(2, new LocatedEntity(2));
+		ASSERT_EQUAL(newHandle.index, handle.index);
+		ASSERT_NULL(registry.get(handle));
+		ASSERT_NOT_NULL(registry.get(newHandle));
+
+		ASSERT_FALSE(registry.getHandle(1).isValid());
+		ASSERT_NULL(registry.get(EntityHandle{}));
+	}
+
+	void test_clear() {
+		EntityRegistry registry;
+		auto handle = registry.insert(1, new LocatedEntity(1));
+		registry.insert(2, new LocatedEntity(2));
+
+		auto snapshot = registry.snapshot();
+		ASSERT_EQUAL(snapshot.size(), 2u);
+
+		registry.clear();
+		ASSERT_TRUE(registry.empty());
+		ASSERT_NULL(registry.get(1));
+		ASSERT_NULL(registry.get(handle));
+		//The snapshot keeps the entities alive.
+		ASSERT_EQUAL(snapshot.size(), 2u);
+		ASSERT_NOT_NULL(snapshot.front().get());
+
+		registry.insert(3, new LocatedEntity(3));
+		ASSERT_EQUAL(registry.size(), 1u);
+		ASSERT_NOT_NULL(registry.get(3));
+	}
+};
+
+int main() {
+	EntityRegistryTest t;
+
+	return t.run();
+}
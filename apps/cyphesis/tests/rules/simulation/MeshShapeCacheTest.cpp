@@ -0,0 +1,187 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../../TestBase.h"
+
+#include "rules/simulation/MeshShapeCache.h"
+#include "physics/Convert.h"
+
+#include <BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h>
+#include <BulletCollision/CollisionShapes/btTriangleIndexVertexArray.h>
+
+#include <fmt/ostream.h>
+
+template<>
+struct fmt::formatter<btVector3> : ostream_formatter {
+};
+
+struct MeshShapeCacheTest : public Cyphesis::TestBase {
+
+	std::filesystem::path m_directory;
+	std::filesystem::path m_meshPath;
+
+	MeshShapeCacheTest() {
+		ADD_TEST(MeshShapeCacheTest::test_sharing);
+		ADD_TEST(MeshShapeCacheTest::test_readFromDisk);
+		ADD_TEST(MeshShapeCacheTest::test_damagedCache);
+		ADD_TEST(MeshShapeCacheTest::test_preload);
+		ADD_TEST(MeshShapeCacheTest::test_separateScaling);
+	}
+
+	void setup() override {
+		m_directory = std::filesystem::temp_directory_path() / "cyphesis_mesh_shape_cache_test";
+		std::filesystem::remove_all(m_directory);
+		std::filesystem::create_directories(m_directory);
+		m_meshPath = m_directory / "box.mesh";
+		std::filesystem::copy_file(TESTDATADIR "/box.mesh", m_meshPath);
+	}
+
+	void teardown() override {
+		std::filesystem::remove_all(m_directory);
+	}
+
+	std::size_t cacheFileCount() {
+		std::size_t count = 0;
+		if (std::filesystem::is_directory(m_directory / "cache")) {
+			for ([[maybe_unused]] auto& entry: std::filesystem::directory_iterator(m_directory / "cache")) {
+				count++;
+			}
+		}
+		return count;
+	}
+
+	void test_sharing() {
+		MeshShapeCache cache(m_directory / "cache");
+		auto shape1 = cache.get(m_meshPath, false);
+		ASSERT_NOT_NULL(shape1.get());
+		ASSERT_EQUAL(shape1->vertices().size(), 24u * 3u);
+		ASSERT_EQUAL(shape1->indices().size(), 12u * 3u);
+		ASSERT_TRUE(shape1->bounds().isValid());
+		ASSERT_FALSE(shape1->hasBvhShape());
+		ASSERT_EQUAL(cacheFileCount(), 1u);
+
+		//Asking for the same file again should give the same shape, with a BVH built if needed.
+		auto shape2 = cache.get(m_meshPath, true);
+		ASSERT_EQUAL(shape1.get(), shape2.get());
+		ASSERT_TRUE(shape2->hasBvhShape());
+		ASSERT_EQUAL(shape1->bvhShape(), shape2->bvhShape());
+
+		ASSERT_NULL(cache.get(m_directory / "missing.mesh", true).get());
+	}
+
+	void test_readFromDisk() {
+		btVector3 aabbMin, aabbMax;
+		{
+			MeshShapeCache cache(m_directory / "cache");
+			auto shape = cache.get(m_meshPath, true);
+			ASSERT_NOT_NULL(shape.get());
+			aabbMin = shape->bvhShape()->getLocalAabbMin();
+			aabbMax = shape->bvhShape()->getLocalAabbMax();
+		}
+
+		//A new cache should read the shape from disk.
+		{
+			MeshShapeCache cache(m_directory / "cache");
+			auto shape = cache.get(m_meshPath, true);
+			ASSERT_NOT_NULL(shape.get());
+			//The BVH should have been read from disk, and not built again.
+			ASSERT_TRUE(shape->hasBvhShape());
+			ASSERT_NOT_NULL(shape->m_deserializedBvh);
+			ASSERT_EQUAL(shape->vertices().size(), 24u * 3u);
+			ASSERT_EQUAL(aabbMin, shape->bvhShape()->getLocalAabbMin());
+			ASSERT_EQUAL(aabbMax, shape->bvhShape()->getLocalAabbMax());
+		}
+	}
+
+	void test_damagedCache() {
+		{
+			MeshShapeCache cache(m_directory / "cache");
+			ASSERT_NOT_NULL(cache.get(m_meshPath, true).get());
+		}
+		ASSERT_EQUAL(cacheFileCount(), 1u);
+		auto cacheFile = std::filesystem::directory_iterator(m_directory / "cache")->path();
+		std::filesystem::resize_file(cacheFile, std::filesystem::file_size(cacheFile) - 4);
+
+		{
+			MeshShapeCache cache(m_directory / "cache");
+			auto shape = cache.get(m_meshPath, true);
+			ASSERT_NOT_NULL(shape.get());
+			ASSERT_NULL(shape->m_deserializedBvh);
+			ASSERT_EQUAL(shape->vertices().size(), 24u * 3u);
+		}
+	}
+
+	void test_preload() {
+		auto otherMeshPath = m_directory / "other.mesh";
+		std::filesystem::copy_file(m_meshPath, otherMeshPath);
+
+		MeshShapeCache cache(m_directory / "cache");
+		auto shapes = cache.preload({{m_meshPath,                true},
+									 {otherMeshPath,             false},
+									 {m_directory / "missing.mesh", false}});
+		ASSERT_EQUAL(shapes.size(), 3u);
+		//Since the files have the same content they should share the same shape.
+		auto shape = cache.get(m_meshPath, false);
+		ASSERT_NOT_NULL(shape.get());
+		ASSERT_EQUAL(shape.get(), cache.get(otherMeshPath, false).get());
+		ASSERT_TRUE(shape->hasBvhShape());
+	}
+
+	void test_separateScaling() {
+		MeshShapeCache cache(m_directory / "cache");
+		auto shape = cache.get(m_meshPath, false);
+		ASSERT_NOT_NULL(shape.get());
+
+		auto array1 = shape->createTriangleVertexArray();
+		auto array2 = shape->createTriangleVertexArray();
+		ASSERT_NOT_EQUAL(array1.get(), shape->triangleVertexArray());
+		ASSERT_NOT_EQUAL(array1.get(), array2.get());
+
+		//Scaling one array must not affect the others.
+		array1->setScaling(btVector3(2, 3, 4));
+		ASSERT_EQUAL(array2->getScaling(), btVector3(1, 1, 1));
+		ASSERT_EQUAL(shape->triangleVertexArray()->getScaling(), btVector3(1, 1, 1));
+
+		//They should all share the same mesh data.
+		const unsigned char* vertexBase;
+		int numVerts;
+		PHY_ScalarType type;
+		int stride;
+		const unsigned char* indexBase;
+		int indexStride;
+		int numFaces;
+		PHY_ScalarType indicesType;
+		array1->getLockedReadOnlyVertexIndexBase(&vertexBase, numVerts, type, stride, &indexBase, indexStride, numFaces, indicesType);
+		ASSERT_EQUAL(reinterpret_cast<const btScalar*>(vertexBase), shape->vertices().data());
+		ASSERT_EQUAL(reinterpret_cast<const unsigned int*>(indexBase), shape->indices().data());
+		array1->unLockReadOnlyVertexBase(0);
+	}
+};
+
+int main() {
+	MeshShapeCacheTest t;
+
+	return t.run();
+}
@@ -71,7 +71,7 @@ public:
 	void addEntity(const Ref<LocatedEntity>& ent, const Ref<LocatedEntity>& parent) override {
 		ent->m_parent = parent.get();
 		ent->requirePropertyClassFixed<PositionProperty<LocatedEntity>>().data() = WFMath::Point<3>(0, 0, 0);
-		m_eobjects[ent->getIdAsInt()] = ent;
+		m_eobjects.insert(ent->getIdAsInt(), ent);
 	}
 
 	Ref<LocatedEntity> addNewEntity(const std::string& t,
@@ -174,6 +174,18 @@ public:
 
 	void test_GetOperation_obj_IG();
 
+	void test_GetOperation_obj_subtree();
+
+	void test_GetOperation_obj_subtree_bad_cursor();
+
+	void test_GetOperation_obj_subtree_expired();
+
+	void test_GetOperation_obj_subtree_limit();
+
+	void test_GetOperation_obj_subtree_disconnect();
+
+	Operation startSubtreeExport();
+
 	void test_GetOperation_obj_not_found();
 
 	void test_GetOperation_rule_found();
@@ -320,6 +332,11 @@ Admintest::Admintest() : m_server(0),
 	ADD_TEST(Admintest::test_GetOperation_obj_unconnected);
 	ADD_TEST(Admintest::test_GetOperation_obj_OOG);
 	ADD_TEST(Admintest::test_GetOperation_obj_IG);
+	ADD_TEST(Admintest::test_GetOperation_obj_subtree);
+	ADD_TEST(Admintest::test_GetOperation_obj_subtree_bad_cursor);
+	ADD_TEST(Admintest::test_GetOperation_obj_subtree_expired);
+	ADD_TEST(Admintest::test_GetOperation_obj_subtree_limit);
+	ADD_TEST(Admintest::test_GetOperation_obj_subtree_disconnect);
 	ADD_TEST(Admintest::test_GetOperation_obj_not_found);
 	ADD_TEST(Admintest::test_GetOperation_rule_found);
 	ADD_TEST(Admintest::test_GetOperation_rule_not_found);
@@ -702,6 +719,127 @@ void Admintest::test_GetOperation_obj_IG() {
 
 }
 
+void Admintest::test_GetOperation_obj_subtree() {
+	Ref<LocatedEntity> parent = new LocatedEntity(RouterId{m_id_counter++});
+	m_server->m_world.addEntity(parent, m_gw);
+	Ref<LocatedEntity> child1 = new LocatedEntity(RouterId{m_id_counter++});
+	m_server->m_world.addEntity(child1, parent);
+	Ref<LocatedEntity> child2 = new LocatedEntity(RouterId{m_id_counter++});
+	m_server->m_world.addEntity(child2, parent);
+
+	Anonymous arg;
+	arg->setObjtype("obj");
+	arg->setId(parent->getIdAsString());
+	arg->setAttr("archive", 1);
+	arg->setAttr("batch", 2);
+
+	Atlas::Objects::Operation::Get op;
+	op->setArgs1(arg);
+	OpVector res;
+	m_account->GetOperation(op, res);
+
+	ASSERT_EQUAL(res.size(), 1u);
+	ASSERT_EQUAL(res.front()->getClassNo(), Atlas::Objects::Operation::INFO_NO);
+	ASSERT_EQUAL(res.front()->getArgs().size(), 2u);
+	//The parent is always sent first.
+	ASSERT_EQUAL(res.front()->getArgs().front()->getId(), parent->getIdAsString());
+	ASSERT_TRUE(res.front()->hasAttr("cursor"));
+
+	//Ask for the next batch, which should contain the last child, and no cursor.
+	arg->setAttr("cursor", res.front()->getAttr("cursor"));
+	res.clear();
+	m_account->GetOperation(op, res);
+
+	ASSERT_EQUAL(res.size(), 1u);
+	ASSERT_EQUAL(res.front()->getClassNo(), Atlas::Objects::Operation::INFO_NO);
+	ASSERT_EQUAL(res.front()->getArgs().size(), 1u);
+	ASSERT_TRUE(!res.front()->hasAttr("cursor"));
+
+	//The cursor can't be used once the export is done.
+	res.clear();
+	m_account->GetOperation(op, res);
+
+	ASSERT_EQUAL(res.size(), 1u);
+	ASSERT_EQUAL(res.front()->getClassNo(), Atlas::Objects::Operation::ERROR_NO);
+}
+
+void Admintest::test_GetOperation_obj_subtree_bad_cursor() {
+	Anonymous arg;
+	arg->setObjtype("obj");
+	arg->setId(m_gw->getIdAsString());
+	arg->setAttr("archive", 1);
+	arg->setAttr("batch", 10);
+	arg->setAttr("cursor", 1234);
+
+	Atlas::Objects::Operation::Get op;
+	op->setArgs1(arg);
+	OpVector res;
+	m_account->GetOperation(op, res);
+
+	ASSERT_EQUAL(res.size(), 1u);
+	ASSERT_EQUAL(res.front()->getClassNo(), Atlas::Objects::Operation::ERROR_NO);
+}
+
+/// Starts exporting an entity with two children, one at a time, and returns the Get op for the next batch.
+Operation Admintest::startSubtreeExport() {
+	Ref<LocatedEntity> parent = new LocatedEntity(RouterId{m_id_counter++});
+	m_server->m_world.addEntity(parent, m_gw);
+	m_server->m_world.addEntity(new LocatedEntity(RouterId{m_id_counter++}), parent);
+	m_server->m_world.addEntity(new LocatedEntity(RouterId{m_id_counter++}), parent);
+
+	Anonymous arg;
+	arg->setObjtype("obj");
+	arg->setId(parent->getIdAsString());
+	arg->setAttr("archive", 1);
+	arg->setAttr("batch", 1);
+
+	Atlas::Objects::Operation::Get op;
+	op->setArgs1(arg);
+	OpVector res;
+	m_account->GetOperation(op, res);
+
+	assert(res.size() == 1);
+	assert(res.front()->hasAttr("cursor"));
+	arg->setAttr("cursor", res.front()->getAttr("cursor"));
+	return op;
+}
+
+void Admintest::test_GetOperation_obj_subtree_expired() {
+	auto op = startSubtreeExport();
+	ASSERT_EQUAL(m_account->m_subtreeExports.size(), 1u);
+
+	//An export which the client hasn't continued for a while is dropped.
+	m_account->m_subtreeExports.begin()->second.lastUsed -= std::chrono::minutes(10);
+	OpVector res;
+	m_account->GetOperation(op, res);
+
+	ASSERT_EQUAL(res.size(), 1u);
+	ASSERT_EQUAL(res.front()->getClassNo(), Atlas::Objects::Operation::ERROR_NO);
+	ASSERT_TRUE(m_account->m_subtreeExports.empty());
+}
+
+void Admintest::test_GetOperation_obj_subtree_limit() {
+	auto first = startSubtreeExport();
+	for (int i = 0; i < 20; ++i) {
+		startSubtreeExport();
+	}
+	ASSERT_EQUAL(m_account->m_subtreeExports.size(), 16u);
+
+	//The least recently used export is the one which is dropped.
+	OpVector res;
+	m_account->GetOperation(first, res);
+	ASSERT_EQUAL(res.size(), 1u);
+	ASSERT_EQUAL(res.front()->getClassNo(), Atlas::Objects::Operation::ERROR_NO);
+}
+
+void Admintest::test_GetOperation_obj_subtree_disconnect() {
+	startSubtreeExport();
+	ASSERT_EQUAL(m_account->m_subtreeExports.size(), 1u);
+
+	m_account->setConnection(nullptr);
+	ASSERT_TRUE(m_account->m_subtreeExports.empty());
+}
+
 void Admintest::test_GetOperation_obj_not_found() {
 	Atlas::Objects::Operation::Get op;
 	OpVector res;
@@ -0,0 +1,84 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "server/AiClientPool.h"
+
+#include <thread>
+
+struct AiClientPoolTest : public Cyphesis::TestBase {
+
+	AiClientPoolTest() {
+		ADD_TEST(AiClientPoolTest::test_start);
+		ADD_TEST(AiClientPoolTest::test_restart);
+	}
+
+	void setup() override {
+	}
+
+	void teardown() override {
+	}
+
+	void test_start() {
+		AiClientPool pool({"/bin/sleep", "60"}, 2);
+		ASSERT_EQUAL(pool.getRunningCount(), 0u);
+		pool.poll(std::chrono::steady_clock::now());
+		ASSERT_EQUAL(pool.getRunningCount(), 2u);
+		pool.shutdown();
+		ASSERT_EQUAL(pool.getRunningCount(), 0u);
+		//Nothing should be started after shutting down.
+		pool.poll(std::chrono::steady_clock::now());
+		ASSERT_EQUAL(pool.getRunningCount(), 0u);
+	}
+
+	void test_restart() {
+		AiClientPool pool({"/bin/true"}, 1);
+		auto now = std::chrono::steady_clock::now();
+		pool.poll(now);
+		ASSERT_EQUAL(pool.getRunningCount(), 1u);
+
+		//Wait for the process to exit.
+		for (int i = 0; i < 500 && pool.getRunningCount() > 0; ++i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			pool.poll(now);
+		}
+		ASSERT_EQUAL(pool.getRunningCount(), 0u);
+		ASSERT_EQUAL(pool.getRestartCount(), 0u);
+
+		//Since it exited right away the restart should be delayed.
+		pool.poll(now + AiClientPool::minRestartDelay);
+		ASSERT_EQUAL(pool.getRunningCount(), 0u);
+		pool.poll(now + AiClientPool::minRestartDelay * 2);
+		ASSERT_EQUAL(pool.getRunningCount(), 1u);
+		ASSERT_EQUAL(pool.getRestartCount(), 1u);
+	}
+};
+
+
+int main() {
+	AiClientPoolTest t;
+
+	return t.run();
+}
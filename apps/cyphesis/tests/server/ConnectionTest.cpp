@@ -32,6 +32,7 @@
 #include "rules/simulation/MindsProperty.h"
 #include "rules/simulation/LocatedEntity.h"
 #include "server/Lobby.h"
+#include "server/OpJournal.h"
 #include "server/Player.h"
 #include "server/ServerRouting.h"
 
@@ -46,6 +47,8 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <filesystem>
+#include <unistd.h>
 
 #include <cassert>
 #include "common/Property_impl.h"
@@ -131,6 +134,8 @@ public:
 
 	void test_disconnectObject_non_Entity();
 
+	void test_externalOperation_recorded();
+
 	static void set_Router_error_called();
 
 	static void set_Router_clientError_called();
@@ -167,6 +172,7 @@ Connectiontest::Connectiontest() {
 	ADD_TEST(Connectiontest::test_disconnectObject_others_used_Entity);
 	ADD_TEST(Connectiontest::test_disconnectObject_unlinked_Entity);
 	ADD_TEST(Connectiontest::test_disconnectObject_non_Entity);
+	ADD_TEST(Connectiontest::test_externalOperation_recorded);
 }
 
 void Connectiontest::setup() {
@@ -558,6 +564,29 @@ int main() {
 	return t.run();
 }
 
+void Connectiontest::test_externalOperation_recorded() {
+	auto path = std::filesystem::temp_directory_path() / ("ConnectionTest-" + std::to_string(getpid()) + ".journal");
+
+	//Minds have ids of their own, so the entity must be resolved when recording.
+	Ref<LocatedEntity> avatar(new LocatedEntity(5));
+	ExternalMind mind(6, avatar);
+	m_connection->m_routers[mind.getIdAsInt()].router = &mind;
+	{
+		OpRecorder recorder(path);
+		Atlas::Objects::Operation::Move move;
+		move->setFrom(mind.getIdAsString());
+		m_connection->externalOperation(move, *m_connection);
+	}
+	m_connection->m_routers.erase(mind.getIdAsInt());
+
+	OpJournalReader reader(path);
+	auto entry = reader.next();
+	std::filesystem::remove(path);
+	ASSERT_TRUE(entry.has_value());
+	ASSERT_EQUAL(entry->connectionId, m_connection->getIdAsString());
+	ASSERT_EQUAL(entry->entityId, "5");
+}
+
 // Stubs
 
 #include "rules/simulation/BaseWorld.h"
@@ -0,0 +1,254 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+#include "../TestWorld.h"
+
+#include "server/ExternalMindsManager.h"
+#include "server/PossessionAuthenticator.h"
+
+#include "rules/simulation/LocatedEntity.h"
+#include "rules/simulation/MindsProperty.h"
+#include "rules/simulation/BaseWorld.h"
+#include "common/CommSocket.h"
+#include "common/Link.h"
+#include "common/operations/Think.h"
+
+#include <Atlas/Objects/Operation.h>
+
+using Atlas::Message::Element;
+using Atlas::Message::ListType;
+
+namespace {
+std::vector<Operation> sentOps;
+std::vector<Operation> worldOps;
+}
+
+class TestCommSocket : public CommSocket {
+public:
+	explicit TestCommSocket(boost::asio::io_context& io_context) : CommSocket(io_context) {
+	}
+
+	void disconnect() override {
+	}
+
+	int flush() override {
+		return 0;
+	}
+};
+
+class TestLink : public Link {
+public:
+	TestLink(CommSocket& socket, RouterId id) : Link(socket, std::move(id)) {
+	}
+
+	void externalOperation(const Operation&, Link&) override {
+	}
+
+	void operation(const Operation&, OpVector&) override {
+	}
+};
+
+class TestMind : public Router {
+public:
+	explicit TestMind(RouterId id) : Router(std::move(id)) {
+	}
+
+	void operation(const Operation&, OpVector&) override {
+	}
+};
+
+struct ExternalMindsManagerTest : public Cyphesis::TestBase {
+	boost::asio::io_context m_io_context;
+	std::unique_ptr<TestCommSocket> m_socket;
+	std::unique_ptr<TestLink> m_link;
+	std::unique_ptr<TestWorld> m_world;
+	std::unique_ptr<PossessionAuthenticator> m_authenticator;
+	std::unique_ptr<ExternalMindsManager> m_manager;
+	TestMind m_mind{RouterId(1000)};
+	std::chrono::steady_clock::time_point m_now;
+
+	ExternalMindsManagerTest() {
+		ADD_TEST(ExternalMindsManagerTest::test_selectByMindCount);
+		ADD_TEST(ExternalMindsManagerTest::test_selectByLoad);
+		ADD_TEST(ExternalMindsManagerTest::test_rebalance);
+		ADD_TEST(ExternalMindsManagerTest::test_noRebalanceWhenBalanced);
+	}
+
+	void setup() override {
+		sentOps.clear();
+		worldOps.clear();
+		m_socket = std::make_unique<TestCommSocket>(m_io_context);
+		m_link = std::make_unique<TestLink>(*m_socket, RouterId(1));
+		m_world = std::make_unique<TestWorld>();
+		m_world->m_extension.messageFn = [](const Operation& op, LocatedEntity&) { worldOps.push_back(op); };
+		m_authenticator = std::make_unique<PossessionAuthenticator>();
+		m_manager = std::make_unique<ExternalMindsManager>(*m_authenticator);
+		m_now = std::chrono::steady_clock::now();
+	}
+
+	void teardown() override {
+		m_manager.reset();
+		m_authenticator.reset();
+		m_world.reset();
+		m_link.reset();
+		m_socket.reset();
+	}
+
+	Ref<LocatedEntity> createEntity(long id) {
+		Ref<LocatedEntity> entity(new LocatedEntity(id));
+		entity->setProperty(MindsProperty::property_name, std::make_unique<MindsProperty>());
+		return entity;
+	}
+
+	void setMind(LocatedEntity& entity, bool hasMind) {
+		auto prop = entity.modPropertyClassFixed<MindsProperty>();
+		if (hasMind) {
+			prop->addMind(&m_mind);
+		} else {
+			prop->removeMind(&m_mind, entity);
+		}
+		entity.propertyApplied.emit(MindsProperty::property_name, *prop);
+	}
+
+	/**
+	 * Reports a load for a connection, using two reports one second apart.
+	 */
+	void reportLoad(const std::string& routerId, size_t minds, double cpuUsage) {
+		m_manager->updateLoad(routerId, minds, std::chrono::duration<double>(0), m_now - std::chrono::seconds(1));
+		m_manager->updateLoad(routerId, minds, std::chrono::duration<double>(cpuUsage), m_now);
+	}
+
+	static std::string getEntityId(const Operation& op) {
+		return op->getArgs().front()->getAttr("possess_entity_id").String();
+	}
+
+	void test_selectByMindCount() {
+		m_manager->addConnection(ExternalMindsConnection(m_link.get(), "2"));
+		m_manager->addConnection(ExternalMindsConnection(m_link.get(), "3"));
+
+		//Without any reported load the possessions should be spread evenly.
+		auto e1 = createEntity(100);
+		auto e2 = createEntity(101);
+		auto e3 = createEntity(102);
+		m_manager->requestPossession(*e1);
+		m_manager->requestPossession(*e2);
+		m_manager->requestPossession(*e3);
+
+		ASSERT_EQUAL(sentOps.size(), 3u);
+		ASSERT_EQUAL(sentOps[0]->getTo(), "2");
+		ASSERT_EQUAL(sentOps[1]->getTo(), "3");
+		ASSERT_EQUAL(sentOps[2]->getTo(), "2");
+
+		ASSERT_EQUAL(m_manager->getConnections().find("2")->second.getPendingPossessions(), 2u);
+		setMind(*e1, true);
+		ASSERT_EQUAL(m_manager->getConnections().find("2")->second.getPendingPossessions(), 1u);
+		ASSERT_EQUAL(m_manager->getConnections().find("2")->second.getMindCount(), 1u);
+	}
+
+	void test_selectByLoad() {
+		m_manager->addConnection(ExternalMindsConnection(m_link.get(), "2"));
+		m_manager->addConnection(ExternalMindsConnection(m_link.get(), "3"));
+		//Even if "3" has more minds, they use less CPU.
+		reportLoad("2", 1, 0.9);
+		reportLoad("3", 3, 0.3);
+		ASSERT_EQUAL(m_manager->getConnections().find("2")->second.getCpuUsage(), 0.9);
+
+		auto e1 = createEntity(100);
+		m_manager->requestPossession(*e1);
+		ASSERT_EQUAL(sentOps.size(), 1u);
+		ASSERT_EQUAL(sentOps[0]->getTo(), "3");
+	}
+
+	void test_rebalance() {
+		m_manager->addConnection(ExternalMindsConnection(m_link.get(), "2"));
+		auto e1 = createEntity(100);
+		m_manager->requestPossession(*e1);
+		setMind(*e1, true);
+
+		m_manager->addConnection(ExternalMindsConnection(m_link.get(), "3"));
+		reportLoad("2", 4, 0.9);
+		reportLoad("3", 0, 0);
+		sentOps.clear();
+
+		ASSERT_TRUE(m_manager->rebalance(m_now));
+		ASSERT_EQUAL(sentOps.size(), 1u);
+		ASSERT_EQUAL(sentOps[0]->getTo(), "2");
+		ASSERT_EQUAL(getEntityId(sentOps[0]), "100");
+		ASSERT_TRUE(sentOps[0]->getArgs().front()->getAttr("relinquish") == Element(1));
+		//Only one migration at a time.
+		ASSERT_FALSE(m_manager->rebalance(m_now));
+
+		//The client logs out the mind, handing over its thoughts.
+		m_manager->storeThoughts("100", ListType{Atlas::Message::MapType{{"predicate", "location"}}});
+		sentOps.clear();
+		setMind(*e1, false);
+		ASSERT_EQUAL(sentOps.size(), 1u);
+		ASSERT_EQUAL(sentOps[0]->getTo(), "3");
+		ASSERT_EQUAL(getEntityId(sentOps[0]), "100");
+
+		//When possessed again the thoughts should be sent to the new mind.
+		worldOps.clear();
+		setMind(*e1, true);
+		ASSERT_EQUAL(worldOps.size(), 1u);
+		ASSERT_EQUAL(worldOps[0]->getClassNo(), Atlas::Objects::Operation::THINK_NO);
+		ASSERT_EQUAL(worldOps[0]->getTo(), "100");
+		auto setOp = Atlas::Objects::smart_dynamic_cast<Operation>(worldOps[0]->getArgs().front());
+		ASSERT_TRUE(setOp.isValid());
+		ASSERT_EQUAL(setOp->getArgs().size(), 1u);
+		ASSERT_EQUAL(m_manager->getConnections().find("3")->second.getMindCount(), 1u);
+	}
+
+	void test_noRebalanceWhenBalanced() {
+		m_manager->addConnection(ExternalMindsConnection(m_link.get(), "2"));
+		m_manager->addConnection(ExternalMindsConnection(m_link.get(), "3"));
+		auto e1 = createEntity(100);
+		m_manager->requestPossession(*e1);
+		setMind(*e1, true);
+
+		//Both are busy, but moving a mind wouldn't help.
+		reportLoad("2", 4, 0.9);
+		reportLoad("3", 4, 0.8);
+		ASSERT_FALSE(m_manager->rebalance(m_now));
+
+		//Not overloaded.
+		reportLoad("2", 4, 0.5);
+		reportLoad("3", 0, 0);
+		ASSERT_FALSE(m_manager->rebalance(m_now));
+	}
+};
+
+void Link::send(const Operation& op) const {
+	sentOps.push_back(op);
+}
+
+void LocatedEntity::sendWorld(Operation op) {
+	BaseWorld::instance().message(op, *this);
+}
+
+int main() {
+	ExternalMindsManagerTest t;
+
+	return t.run();
+}
@@ -141,6 +141,18 @@ int main() {
 
 	}
 
+	// HTTP get /metrics
+	{
+		boost::asio::io_context contextMain;
+		HttpHandling hc(Monitors::instance(), contextMain);
+
+		std::list<std::string> headers;
+		headers.push_back("GET /metrics HTTP/1.0");
+
+		hc.processQuery(std::cout, headers);
+
+	}
+
 	{
 		boost::asio::io_context contextMain;
 		TestHttpCache hc(Monitors::instance(), contextMain);
@@ -0,0 +1,194 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+#include "../TestWorld.h"
+#include "../TestPropertyManager.h"
+
+#include "server/OpReplayer.h"
+
+#include "rules/simulation/LocatedEntity.h"
+#include "common/operations/Tick.h"
+
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Operation.h>
+
+#include <unistd.h>
+
+using Atlas::Objects::Entity::Anonymous;
+
+struct OpReplayerTest : public Cyphesis::TestBase {
+	Atlas::Objects::Factories m_factories;
+	Ref<LocatedEntity> m_root;
+	std::unique_ptr<TestWorld> m_world;
+	std::filesystem::path m_path;
+
+	OpReplayerTest() {
+		ADD_TEST(OpReplayerTest::test_roundTrip);
+		ADD_TEST(OpReplayerTest::test_badJournal);
+		ADD_TEST(OpReplayerTest::test_replay);
+		ADD_TEST(OpReplayerTest::test_drain);
+	}
+
+	void setup() override {
+		m_root = new LocatedEntity(0);
+		m_world = std::make_unique<TestWorld>(m_root);
+		m_world->addEntity(new LocatedEntity(1), m_root);
+		m_path = std::filesystem::temp_directory_path() / ("OpReplayerTest-" + std::to_string(getpid()) + ".journal");
+	}
+
+	void teardown() override {
+		std::filesystem::remove(m_path);
+		m_world.reset();
+		m_root.reset();
+	}
+
+	/**
+	 * @param from The id of the mind sending the op, which differs from the id of the entity.
+	 */
+	static Operation createMove(const std::string& from) {
+		Anonymous arg;
+		arg->setId("1");
+		arg->setPos({1, 2, 3});
+		Atlas::Objects::Operation::Move move;
+		move->setFrom(from);
+		move->setArgs1(arg);
+		return move;
+	}
+
+	void test_roundTrip() {
+		{
+			OpRecorder recorder(m_path);
+			//Enough entries to span several reads.
+			for (int i = 0; i < 2000; ++i) {
+				recorder.record(OpJournalEntry::Source::Client, "connection" + std::to_string(i), std::to_string(i), createMove(std::to_string(i)));
+			}
+			Atlas::Objects::Operation::Tick tick;
+			recorder.record(OpJournalEntry::Source::World, "", "", tick);
+			ASSERT_EQUAL(recorder.getEntryCount(), 2001u);
+		}
+
+		OpJournalReader reader(m_path);
+		std::chrono::microseconds lastTime(0);
+		for (int i = 0; i < 2000; ++i) {
+			auto entry = reader.next();
+			ASSERT_TRUE(entry.has_value());
+			ASSERT_TRUE(entry->source == OpJournalEntry::Source::Client);
+			ASSERT_EQUAL(entry->connectionId, "connection" + std::to_string(i));
+			ASSERT_EQUAL(entry->entityId, std::to_string(i));
+			ASSERT_TRUE(entry->time >= lastTime);
+			lastTime = entry->time;
+			auto op = Atlas::Objects::smart_dynamic_cast<Operation>(m_factories.createObject(entry->op));
+			ASSERT_TRUE(op.isValid());
+			ASSERT_EQUAL(op->getClassNo(), Atlas::Objects::Operation::MOVE_NO);
+			ASSERT_EQUAL(op->getFrom(), std::to_string(i));
+		}
+		auto entry = reader.next();
+		ASSERT_TRUE(entry.has_value());
+		ASSERT_TRUE(entry->source == OpJournalEntry::Source::World);
+		ASSERT_TRUE(entry->connectionId.empty());
+		ASSERT_TRUE(entry->entityId.empty());
+		ASSERT_EQUAL(entry->op["parent"].String(), "tick");
+		ASSERT_FALSE(reader.next().has_value());
+	}
+
+	void test_badJournal() {
+		{
+			std::ofstream file(m_path);
+			file << "not a journal";
+		}
+		bool thrown = false;
+		try {
+			OpJournalReader reader(m_path);
+		} catch (const std::runtime_error&) {
+			thrown = true;
+		}
+		ASSERT_TRUE(thrown);
+	}
+
+	void test_replay() {
+		{
+			OpRecorder recorder(m_path);
+			//Ops are sent from the id of the mind, and are replayed against the entity recorded along with them.
+			recorder.record(OpJournalEntry::Source::Client, "c1", "1", createMove("100"));
+			//The entity doesn't exist.
+			recorder.record(OpJournalEntry::Source::Client, "c1", "2", createMove("101"));
+			//Ops not sent by a mind, such as those sent by accounts, aren't for any entity.
+			recorder.record(OpJournalEntry::Source::Client, "c1", "", createMove("1"));
+			//Responses and Get ops never reach the world.
+			auto response = createMove("100");
+			response->setRefno(10);
+			recorder.record(OpJournalEntry::Source::Client, "c1", "1", response);
+			Atlas::Objects::Operation::Get get;
+			get->setFrom("100");
+			recorder.record(OpJournalEntry::Source::Client, "c1", "1", get);
+			//World ops are generated by the world itself.
+			Atlas::Objects::Operation::Tick tick;
+			recorder.record(OpJournalEntry::Source::World, "", "", tick);
+		}
+
+		std::vector<Operation> worldOps;
+		m_world->m_extension.messageFn = [&](const Operation& op, LocatedEntity&) {
+			worldOps.push_back(op);
+			m_world->Dispatched.emit(op, std::chrono::milliseconds(1));
+		};
+
+		OpReplayer replayer(*m_world, m_factories, std::make_unique<OpJournalReader>(m_path), 0);
+		ASSERT_FALSE(replayer.poll(std::chrono::steady_clock::now()));
+		ASSERT_EQUAL(replayer.getInjectedCount(), 1u);
+		ASSERT_EQUAL(replayer.getSkippedCount(), 4u);
+
+		ASSERT_EQUAL(worldOps.size(), 1u);
+		ASSERT_EQUAL(worldOps[0]->getParent(), "thought");
+		ASSERT_EQUAL(worldOps[0]->getTo(), "1");
+		ASSERT_EQUAL(worldOps[0]->getFrom(), "1");
+		auto move = Atlas::Objects::smart_dynamic_cast<Operation>(worldOps[0]->getArgs().front());
+		ASSERT_TRUE(move.isValid());
+		ASSERT_EQUAL(move->getClassNo(), Atlas::Objects::Operation::MOVE_NO);
+		replayer.report();
+	}
+
+	void test_drain() {
+		{
+			OpRecorder recorder(m_path);
+			recorder.record(OpJournalEntry::Source::Client, "c1", "1", createMove("100"));
+		}
+
+		//Ops which aren't dispatched are waited for, until the timeout.
+		OpReplayer replayer(*m_world, m_factories, std::make_unique<OpJournalReader>(m_path), 0);
+		auto now = std::chrono::steady_clock::now();
+		ASSERT_TRUE(replayer.poll(now));
+		ASSERT_EQUAL(replayer.getInjectedCount(), 1u);
+		ASSERT_TRUE(replayer.poll(now + std::chrono::seconds(1)));
+		ASSERT_FALSE(replayer.poll(now + OpReplayer::drainTimeout));
+		ASSERT_FALSE(replayer.poll(now + OpReplayer::drainTimeout));
+	}
+};
+
+int main() {
+	TestPropertyManager<LocatedEntity> propertyManager;
+	OpReplayerTest t;
+
+	return t.run();
+}
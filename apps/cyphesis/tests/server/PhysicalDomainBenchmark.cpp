@@ -24,6 +24,7 @@
 #endif
 
 #include "../TestBase.h"
+#include "../BenchmarkBase.h"
 #include "../TestWorld.h"
 
 #include "server/Ruleset.h"
@@ -34,14 +35,19 @@
 #include "common/debug.h"
 
 #include <rules/simulation/PhysicalDomain.h>
+#include <rules/simulation/PhysicsTaskScheduler.h>
 #include "common/TypeNode.h"
 #include <common/TypeNode_impl.h>
 #include <rules/simulation/ModeProperty.h>
 #include <rules/simulation/TerrainProperty.h>
+#include <rules/simulation/TerrainModProperty.h>
 #include <Mercator/BasePoint.h>
 #include <Mercator/Terrain.h>
 #include <rules/simulation/PropelProperty.h>
 #include <chrono>
+#include <cmath>
+#include <sstream>
+#include <thread>
 #include <rules/BBoxProperty_impl.h>
 
 
@@ -70,6 +76,10 @@ public:
 
 	void test_static_entities_no_move();
 
+	/**
+	 * Despite the name this only measures how long ticking takes, and doesn't check the outcome.
+	 * Determinism is asserted by PhysicalDomainScalingBenchmark::tick_free_deterministic.
+	 */
 	void test_determinism();
 
 	void test_visibilityPerformance();
@@ -327,10 +337,366 @@ void PhysicalDomainBenchmark::test_visibilityPerformance() {
 	}
 }
 
+namespace {
+const std::chrono::milliseconds tickSize{static_cast<long>((1.0 / 15.0) * 1000)};
+
+/**
+ * A root entity with a domain, and the entities added to it.
+ *
+ * The domain is declared last so that it's destroyed before any entity.
+ */
+struct Scene {
+	Ref<LocatedEntity> rootEntity;
+	std::vector<Ref<LocatedEntity>> entities;
+	std::unique_ptr<TestWorld> world;
+	std::unique_ptr<PhysicalDomain> domain;
+	WFMath::AxisBox<3> aabb;
+};
+}
+
+/**
+ * Measures ticks for a range of entity counts, reporting timings which can be compared between runs.
+ */
+class PhysicalDomainScalingBenchmark : public Cyphesis::BenchmarkBase {
+protected:
+	static long m_id_counter;
+
+	TypeNode<LocatedEntity> m_rockType{"rock"};
+	TypeNode<LocatedEntity> m_humanType{"human"};
+
+public:
+	PhysicalDomainScalingBenchmark();
+
+	static long newId();
+
+	/**
+	 * Creates a flat terrain large enough to fit the supplied number of entities at a one meter interval.
+	 * @param multithreaded If the domain should use the multithreaded world, which requires a task scheduler to be installed.
+	 */
+	Scene createScene(size_t entityCount, bool multithreaded = false);
+
+	Ref<LocatedEntity> addPlanted(Scene& scene, const WFMath::Point<3>& pos);
+
+	Ref<LocatedEntity> addFree(Scene& scene, const WFMath::Point<3>& pos);
+
+	Ref<LocatedEntity> addPropelled(Scene& scene, const WFMath::Point<3>& pos, const WFMath::Vector<3>& propel);
+
+	/**
+	 * Gets the position of the "index":th entity when spread out over the scene.
+	 */
+	static WFMath::Point<3> gridPosition(const Scene& scene, size_t index, size_t count, float height);
+
+	void tick_planted(Cyphesis::BenchmarkState& state);
+
+	void tick_free(Cyphesis::BenchmarkState& state);
+
+	void tick_free_multithreaded(Cyphesis::BenchmarkState& state);
+
+	/**
+	 * Ticks two identical scenes on the main thread, and asserts that they end up in exactly the same state.
+	 * This is the only check of determinism; PhysicalDomainBenchmark::test_determinism only measures timing.
+	 */
+	void tick_free_deterministic(Cyphesis::BenchmarkState& state);
+
+	void tick_propelled(Cyphesis::BenchmarkState& state);
+
+	void visibility_churn(Cyphesis::BenchmarkState& state);
+
+	void terrain_mod_churn(Cyphesis::BenchmarkState& state);
+};
+
+long PhysicalDomainScalingBenchmark::m_id_counter = 0L;
+
+PhysicalDomainScalingBenchmark::PhysicalDomainScalingBenchmark()
+		: Cyphesis::BenchmarkBase({100, 1000, 4000}) {
+	ADD_BENCHMARK(PhysicalDomainScalingBenchmark::tick_planted, 30);
+	ADD_BENCHMARK(PhysicalDomainScalingBenchmark::tick_free, 30);
+	ADD_BENCHMARK(PhysicalDomainScalingBenchmark::tick_free_multithreaded, 30);
+	ADD_BENCHMARK(PhysicalDomainScalingBenchmark::tick_free_deterministic, 30);
+	ADD_BENCHMARK(PhysicalDomainScalingBenchmark::tick_propelled, 30);
+	ADD_BENCHMARK(PhysicalDomainScalingBenchmark::visibility_churn, 60);
+	ADD_BENCHMARK(PhysicalDomainScalingBenchmark::terrain_mod_churn, 15);
+}
+
+long PhysicalDomainScalingBenchmark::newId() {
+	return ++m_id_counter;
+}
+
+Scene PhysicalDomainScalingBenchmark::createScene(size_t entityCount, bool multithreaded) {
+	Scene scene;
+	//Round up to whole terrain segments.
+	auto halfSize = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(entityCount)) / 2.0 / 64.0)) * 64;
+	scene.aabb = WFMath::AxisBox<3>(WFMath::Point<3>(-halfSize, -64, -halfSize), WFMath::Point<3>(halfSize, 64, halfSize));
+
+	scene.rootEntity = new LocatedEntity(newId());
+	auto terrainProperty = new TerrainProperty();
+	scene.rootEntity->setProperty(TerrainProperty::property_name, std::unique_ptr<PropertyBase>(terrainProperty));
+	Mercator::Terrain& terrain = TerrainProperty::getData(*scene.rootEntity);
+	int segments = halfSize / 64;
+	for (int x = -segments; x <= segments; ++x) {
+		for (int y = -segments; y <= segments; ++y) {
+			terrain.setBasePoint(x, y, Mercator::BasePoint(10));
+		}
+	}
+	scene.rootEntity->requirePropertyClassFixed<PositionProperty<LocatedEntity>>().data() = WFMath::Point<3>::ZERO();
+	scene.rootEntity->requirePropertyClassFixed<BBoxProperty<LocatedEntity>>().data() = scene.aabb;
+	scene.world = std::make_unique<TestWorld>(scene.rootEntity);
+	scene.domain = std::make_unique<PhysicalDomain>(*scene.rootEntity, multithreaded);
+	return scene;
+}
+
+WFMath::Point<3> PhysicalDomainScalingBenchmark::gridPosition(const Scene& scene, size_t index, size_t count, float height) {
+	auto side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+	auto size = scene.aabb.highCorner() - scene.aabb.lowCorner();
+	auto interval = std::min(size.x(), size.z()) / static_cast<float>(side + 1);
+	return {scene.aabb.lowCorner().x() + interval * static_cast<float>((index % side) + 1),
+			height,
+			scene.aabb.lowCorner().z() + interval * static_cast<float>((index / side) + 1)};
+}
+
+Ref<LocatedEntity> PhysicalDomainScalingBenchmark::addPlanted(Scene& scene, const WFMath::Point<3>& pos) {
+	Ref<LocatedEntity> entity = new LocatedEntity(newId());
+	auto modeProperty = new ModeProperty();
+	modeProperty->set("planted");
+	entity->setProperty(ModeProperty::property_name, std::unique_ptr<PropertyBase>(modeProperty));
+	entity->setType(&m_rockType);
+	entity->requirePropertyClassFixed<PositionProperty<LocatedEntity>>().data() = pos;
+	entity->requirePropertyClassFixed<BBoxProperty<LocatedEntity>>().data() = WFMath::AxisBox<3>(WFMath::Point<3>(-0.25f, 0, -0.25f), WFMath::Point<3>(0.25f, 0.5f, 0.25f));
+	scene.domain->addEntity(*entity);
+	scene.entities.push_back(entity);
+	return entity;
+}
+
+Ref<LocatedEntity> PhysicalDomainScalingBenchmark::addFree(Scene& scene, const WFMath::Point<3>& pos) {
+	Ref<LocatedEntity> entity = new LocatedEntity(newId());
+	auto massProp = new Property<double, LocatedEntity>();
+	massProp->data() = 100;
+	entity->setProperty("mass", std::unique_ptr<PropertyBase>(massProp));
+	entity->setType(&m_rockType);
+	entity->requirePropertyClassFixed<PositionProperty<LocatedEntity>>().data() = pos;
+	entity->requirePropertyClassFixed<BBoxProperty<LocatedEntity>>().data() = WFMath::AxisBox<3>(WFMath::Point<3>(-0.25f, 0, -0.25f), WFMath::Point<3>(0.25f, 0.5f, 0.25f));
+	scene.domain->addEntity(*entity);
+	scene.entities.push_back(entity);
+	return entity;
+}
+
+Ref<LocatedEntity> PhysicalDomainScalingBenchmark::addPropelled(Scene& scene, const WFMath::Point<3>& pos, const WFMath::Vector<3>& propel) {
+	Ref<LocatedEntity> entity = new LocatedEntity(newId());
+	auto massProp = new Property<double, LocatedEntity>();
+	massProp->data() = 100;
+	entity->setProperty("mass", std::unique_ptr<PropertyBase>(massProp));
+	auto propelProperty = new PropelProperty();
+	propelProperty->data() = propel;
+	entity->setProperty(PropelProperty::property_name, std::unique_ptr<PropertyBase>(propelProperty));
+	entity->setType(&m_humanType);
+	entity->requirePropertyClassFixed<SolidProperty<LocatedEntity>>().set(0);
+	entity->requirePropertyClassFixed<PositionProperty<LocatedEntity>>().data() = pos;
+	entity->requirePropertyClassFixed<BBoxProperty<LocatedEntity>>().data() = WFMath::AxisBox<3>(WFMath::Point<3>(-0.1f, 0, -0.1f), WFMath::Point<3>(0.1, 2, 0.1));
+	scene.domain->addEntity(*entity);
+	scene.entities.push_back(entity);
+	return entity;
+}
+
+void PhysicalDomainScalingBenchmark::tick_planted(Cyphesis::BenchmarkState& state) {
+	auto scene = createScene(state.entities());
+	for (size_t i = 0; i < state.entities(); ++i) {
+		addPlanted(scene, gridPosition(scene, i, state.entities(), 10));
+	}
+
+	OpVector res;
+	//First tick is setup, so we'll exclude that from time measurement
+	scene.domain->tick(tickSize, res);
+	res.clear();
+	size_t ops = 0;
+	state.measure([&]() {
+		scene.domain->tick(tickSize, res);
+		ops += res.size();
+		res.clear();
+	});
+	state.setCounter("ops_per_tick", static_cast<double>(ops) / static_cast<double>(state.iterations()));
+}
+
+void PhysicalDomainScalingBenchmark::tick_free(Cyphesis::BenchmarkState& state) {
+	auto scene = createScene(state.entities());
+	for (size_t i = 0; i < state.entities(); ++i) {
+		//Drop them from a little above the ground so that they're all active during the measurement.
+		addFree(scene, gridPosition(scene, i, state.entities(), 20));
+	}
+
+	OpVector res;
+	scene.domain->tick(tickSize, res);
+	res.clear();
+	size_t ops = 0;
+	state.measure([&]() {
+		scene.domain->tick(tickSize, res);
+		ops += res.size();
+		res.clear();
+	});
+	state.setCounter("ops_per_tick", static_cast<double>(ops) / static_cast<double>(state.iterations()));
+}
+
+void PhysicalDomainScalingBenchmark::tick_free_multithreaded(Cyphesis::BenchmarkState& state) {
+	//Without a multithreaded Bullet no scheduler is installed, and this measures the same as "tick_free".
+	std::unique_ptr<PhysicsTaskScheduler> taskScheduler;
+	if (PhysicsTaskScheduler::isSupported()) {
+		taskScheduler = std::make_unique<PhysicsTaskScheduler>(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+	}
+	{
+		auto scene = createScene(state.entities(), true);
+		for (size_t i = 0; i < state.entities(); ++i) {
+			addFree(scene, gridPosition(scene, i, state.entities(), 20));
+		}
 
-int main() {
+		OpVector res;
+		scene.domain->tick(tickSize, res);
+		state.measure([&]() {
+			scene.domain->tick(tickSize, res);
+		});
+		state.setCounter("ops", static_cast<double>(res.size()));
+	}
+	state.setCounter("threads", static_cast<double>(taskScheduler ? taskScheduler->getNumThreads() : 1));
+}
+
+void PhysicalDomainScalingBenchmark::tick_free_deterministic(Cyphesis::BenchmarkState& state) {
+	auto sceneA = createScene(state.entities());
+	auto sceneB = createScene(state.entities());
+	for (size_t i = 0; i < state.entities(); ++i) {
+		addFree(sceneA, gridPosition(sceneA, i, state.entities(), 20));
+		addFree(sceneB, gridPosition(sceneB, i, state.entities(), 20));
+	}
+
+	OpVector res;
+	state.measure([&]() {
+		sceneA.domain->tick(tickSize, res);
+		sceneB.domain->tick(tickSize, res);
+		res.clear();
+	});
+
+	for (size_t i = 0; i < sceneA.entities.size(); ++i) {
+		auto& posA = sceneA.entities[i]->requirePropertyClassFixed<PositionProperty<LocatedEntity>>().data();
+		auto& posB = sceneB.entities[i]->requirePropertyClassFixed<PositionProperty<LocatedEntity>>().data();
+		//Compare exactly, any difference means that the simulation depends on something else than its input.
+		assert(posA.x() == posB.x() && posA.y() == posB.y() && posA.z() == posB.z());
+	}
+}
+
+void PhysicalDomainScalingBenchmark::tick_propelled(Cyphesis::BenchmarkState& state) {
+	auto scene = createScene(state.entities());
+	for (size_t i = 0; i < state.entities(); ++i) {
+		//Move in different directions, so that some will collide.
+		auto angle = static_cast<float>(i) * 0.7f;
+		addPropelled(scene, gridPosition(scene, i, state.entities(), 10), WFMath::Vector<3>(std::cos(angle) * 2, 0, std::sin(angle) * 2));
+	}
+
+	OpVector res;
+	scene.domain->tick(tickSize, res);
+	res.clear();
+	size_t ops = 0;
+	state.measure([&]() {
+		scene.domain->tick(tickSize, res);
+		ops += res.size();
+		res.clear();
+	});
+	state.setCounter("ops_per_tick", static_cast<double>(ops) / static_cast<double>(state.iterations()));
+}
+
+void PhysicalDomainScalingBenchmark::visibility_churn(Cyphesis::BenchmarkState& state) {
+	auto scene = createScene(state.entities());
+	for (size_t i = 0; i < state.entities(); ++i) {
+		addPlanted(scene, gridPosition(scene, i, state.entities(), 10));
+	}
+
+	//One in ten entities is a perceptive observer moving diagonally across the planted entities.
+	auto numberOfObservers = std::max<size_t>(1, state.entities() / 10);
+	for (size_t i = 0; i < numberOfObservers; ++i) {
+		auto observer = addPropelled(scene, gridPosition(scene, i * 10, state.entities(), 10), WFMath::Vector<3>(5, 0, 5));
+		observer->addFlags(entity_perceptive);
+	}
+
+	OpVector res;
+	scene.domain->tick(tickSize, res);
+	res.clear();
+	size_t ops = 0;
+	state.measure([&]() {
+		scene.domain->tick(tickSize, res);
+		ops += res.size();
+		res.clear();
+	});
+	state.setCounter("observers", static_cast<double>(numberOfObservers));
+	state.setCounter("ops_per_tick", static_cast<double>(ops) / static_cast<double>(state.iterations()));
+}
+
+void PhysicalDomainScalingBenchmark::terrain_mod_churn(Cyphesis::BenchmarkState& state) {
+	auto scene = createScene(state.entities());
+	for (size_t i = 0; i < state.entities(); ++i) {
+		addPlanted(scene, gridPosition(scene, i, state.entities(), 10));
+	}
+
+	Atlas::Message::MapType modElement{
+			{"heightoffset", -2.0f},
+			{"shape",        MapType{
+					{"points", ListType{
+							ListType{-2.f, -2.f},
+							ListType{2.f, -2.f},
+							ListType{2.f, 2.f},
+							ListType{-2.f, 2.f},
+					}
+					},
+					{"type",   "polygon"}
+			}
+			},
+			{"type",         "levelmod"}
+	};
+
+	//One terrain mod for every hundred entities, all of which are moved each tick.
+	auto numberOfMods = std::max<size_t>(1, state.entities() / 100);
+	std::vector<Ref<LocatedEntity>> mods;
+	for (size_t i = 0; i < numberOfMods; ++i) {
+		Ref<LocatedEntity> modEntity = new LocatedEntity(newId());
+		modEntity->requirePropertyClassFixed<PositionProperty<LocatedEntity>>().data() = gridPosition(scene, i * 100, state.entities(), 10);
+		auto modeProperty = new ModeProperty();
+		modeProperty->set("planted");
+		modEntity->setProperty(ModeProperty::property_name, std::unique_ptr<PropertyBase>(modeProperty));
+		auto terrainModProperty = new TerrainModProperty();
+		terrainModProperty->set(modElement);
+		terrainModProperty->apply(*modEntity);
+		modEntity->setProperty(TerrainModProperty::property_name, std::unique_ptr<PropertyBase>(terrainModProperty));
+		scene.domain->addEntity(*modEntity);
+		scene.entities.push_back(modEntity);
+		mods.push_back(modEntity);
+	}
+
+	OpVector res;
+	scene.domain->tick(tickSize, res);
+	std::set<LocatedEntity*> transformedEntities;
+	size_t iteration = 0;
+	state.measure([&]() {
+		++iteration;
+		for (size_t i = 0; i < mods.size(); ++i) {
+			auto pos = gridPosition(scene, i * 100, state.entities(), 10);
+			pos.x() += static_cast<float>(iteration % 8);
+			WFMath::Quaternion orientation;
+			scene.domain->applyTransform(*mods[i], Domain::TransformData{orientation, pos, nullptr, {}}, transformedEntities);
+		}
+		scene.domain->tick(tickSize, res);
+		transformedEntities.clear();
+	});
+	state.setCounter("terrain_mods", static_cast<double>(numberOfMods));
+}
+
+
+int main(int argc, char** argv) {
 	Monitors m;
-	PhysicalDomainBenchmark t;
+	{
+		PhysicalDomainBenchmark t;
+		auto result = t.run();
+		if (result != 0) {
+			return result;
+		}
+	}
+
+	PhysicalDomainScalingBenchmark t;
+	t.parseArgs(argc, argv);
 
 	return t.run();
 }
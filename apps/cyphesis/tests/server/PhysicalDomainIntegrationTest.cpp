@@ -51,6 +51,10 @@
 #include <rules/simulation/EntityProperty.h>
 #include <rules/simulation/ModeDataProperty.h>
 #include <rules/simulation/VisibilityDistanceProperty.h>
+#include <rules/simulation/MindsProperty.h>
+#include "common/Router.h"
+
+#include <thread>
 
 using namespace std::chrono_literals;
 using Atlas::Message::Element;
@@ -120,6 +124,39 @@ public:
 	void test_childEntityPropertyApplied(const std::string& name, PropertyBase& prop, long id) {
 		childEntityPropertyApplied(name, prop, *m_entries.find(id)->second);
 	}
+
+	void test_setVisibilityCheckBudget(std::chrono::steady_clock::duration budget) {
+		m_visibilityCheckBudget = budget;
+	}
+
+	size_t test_getVisibilityQueueSize() const {
+		return m_visibilityRecalculateQueue.size();
+	}
+
+	void test_markForVisibilityRecalculation(long id) {
+		markForVisibilityRecalculation(*m_entries.find(id)->second);
+	}
+
+	bool test_isMarkedForVisibilityRecalculation(long id) const {
+		return m_entries.find(id)->second->markedForVisibilityRecalculation;
+	}
+
+	const Metrics::Gauge& test_getVisibilityQueueGauge() const {
+		return m_visibilityQueueSize;
+	}
+
+	const Metrics::Histogram& test_getVisibilityLatency() const {
+		return m_visibilityLatency;
+	}
+};
+
+class TestMind : public Router {
+public:
+	explicit TestMind(RouterId id) : Router(std::move(id)) {
+	}
+
+	void operation(const Operation&, OpVector&) override {
+	}
 };
 
 double epsilon = 0.0001;
@@ -155,6 +192,7 @@ struct Tested : public Cyphesis::TestBaseWithContext<TestContext> {
 		ADD_TEST(Tested::test_zoffset);
 		ADD_TEST(Tested::test_zscaledoffset);
 		ADD_TEST(Tested::test_visibility);
+		ADD_TEST(Tested::test_visibilityQueue);
 		ADD_TEST(Tested::test_stairs);
 	}
 
@@ -1805,6 +1843,115 @@ struct Tested : public Cyphesis::TestBaseWithContext<TestContext> {
 	}
 
 
+	void test_visibilityQueue(TestContext& context) {
+		TypeNode<LocatedEntity> rockType("rock");
+		TypeNode<LocatedEntity> humanType("human");
+		ModeProperty modePlantedProperty{};
+		modePlantedProperty.set("planted");
+
+		LocatedEntity rootEntity(context.newId());
+		rootEntity.incRef();
+		rootEntity.requirePropertyClassFixed<PositionProperty<LocatedEntity>>().data() = WFMath::Point<3>::ZERO();
+		rootEntity.requirePropertyClassFixed<BBoxProperty<LocatedEntity>>().data() = WFMath::AxisBox<3>(WFMath::Point<3>(-128, 0, -128), WFMath::Point<3>(128, 64, 128));
+		std::unique_ptr<TestPhysicalDomain> domain(new TestPhysicalDomain(rootEntity));
+
+		TestWorld testWorld(&rootEntity);
+
+		auto createRockFn = [&](const WFMath::Point<3>& pos) {
+			auto rock = std::make_unique<LocatedEntity>(RouterId(context.newId()));
+			rock->setProperty(ModeProperty::property_name, std::unique_ptr<PropertyBase>(modePlantedProperty.copy()));
+			rock->setType(&rockType);
+			rock->requirePropertyClassFixed<PositionProperty<LocatedEntity>>().data() = pos;
+			rock->requirePropertyClassFixed<BBoxProperty<LocatedEntity>>().data() = WFMath::AxisBox<3>(WFMath::Point<3>(-0.2f, 0, -0.2f), WFMath::Point<3>(0.2, 0.4, 0.2));
+			domain->addEntity(*rock);
+			return rock;
+		};
+
+		//Rocks close to the observer, which it will see.
+		std::vector<std::unique_ptr<LocatedEntity>> nearRocks;
+		for (int i = 0; i < 10; ++i) {
+			nearRocks.emplace_back(createRockFn(WFMath::Point<3>(1.f + (float) i * 0.2f, 0, 1)));
+		}
+		//Rocks too far away for the observer to see.
+		std::vector<std::unique_ptr<LocatedEntity>> farRocks;
+		for (int i = 0; i < 90; ++i) {
+			farRocks.emplace_back(createRockFn(WFMath::Point<3>(-100.f + (float) (i % 10) * 2.f, 0, -100.f + (float) (i / 10) * 2.f)));
+		}
+
+		LocatedEntity observerEntity(RouterId(context.newId()));
+		observerEntity.setProperty(ModeProperty::property_name, std::unique_ptr<PropertyBase>(modePlantedProperty.copy()));
+		observerEntity.setType(&humanType);
+		observerEntity.requirePropertyClassFixed<PositionProperty<LocatedEntity>>().data() = WFMath::Point<3>(0, 0, 0);
+		observerEntity.requirePropertyClassFixed<BBoxProperty<LocatedEntity>>().data() = WFMath::AxisBox<3>(WFMath::Point<3>(-0.2f, 0, -0.2f), WFMath::Point<3>(0.2, 2, 0.2));
+		observerEntity.addFlags(entity_perceptive);
+		TestMind mind{RouterId(context.newId())};
+		observerEntity.requirePropertyClassFixed<MindsProperty>().addMind(&mind);
+		domain->addEntity(observerEntity);
+
+		OpVector res;
+		//At least a minimum of entries are handled each tick, so the queue should drain even with no budget.
+		domain->test_setVisibilityCheckBudget({});
+		for (int i = 0; i < 10 && domain->test_getVisibilityQueueSize() > 0; ++i) {
+			domain->tick(1ms, res);
+			res.clear();
+		}
+		ASSERT_EQUAL(0u, domain->test_getVisibilityQueueSize());
+		for (auto& rock: nearRocks) {
+			ASSERT_TRUE(domain->isEntityVisibleFor(observerEntity, *rock));
+		}
+		for (auto& rock: farRocks) {
+			ASSERT_FALSE(domain->isEntityVisibleFor(observerEntity, *rock));
+		}
+		//The metrics are shared by all domains, so only look at how they change.
+		auto queueSizeBefore = domain->test_getVisibilityQueueGauge().value();
+		auto latencyCountBefore = domain->test_getVisibilityLatency().count();
+		auto latencySumBefore = domain->test_getVisibilityLatency().sum();
+
+		//Mark the far rocks first and the observer last, so that the order of the queue is the opposite of the priority.
+		for (auto& rock: farRocks) {
+			domain->test_markForVisibilityRecalculation(rock->getIdAsInt());
+		}
+		for (auto& rock: nearRocks) {
+			domain->test_markForVisibilityRecalculation(rock->getIdAsInt());
+		}
+		domain->test_markForVisibilityRecalculation(observerEntity.getIdAsInt());
+		std::this_thread::sleep_for(2ms);
+
+		//With no budget only the minimum amount of entries should be handled, which are the observer and the rocks it sees.
+		domain->tick(1ms, res);
+		res.clear();
+		ASSERT_EQUAL(81u, domain->test_getVisibilityQueueSize());
+		ASSERT_EQUAL(queueSizeBefore + 81, domain->test_getVisibilityQueueGauge().value());
+		ASSERT_FALSE(domain->test_isMarkedForVisibilityRecalculation(observerEntity.getIdAsInt()));
+		for (auto& rock: nearRocks) {
+			ASSERT_FALSE(domain->test_isMarkedForVisibilityRecalculation(rock->getIdAsInt()));
+		}
+		size_t farRocksHandled = 0;
+		for (auto& rock: farRocks) {
+			if (!domain->test_isMarkedForVisibilityRecalculation(rock->getIdAsInt())) {
+				farRocksHandled++;
+			}
+		}
+		ASSERT_EQUAL(9u, farRocksHandled);
+		//The latency of each handled entry, which was at least the time slept, should have been observed.
+		ASSERT_EQUAL(latencyCountBefore + 20, domain->test_getVisibilityLatency().count());
+		ASSERT_GREATER(domain->test_getVisibilityLatency().sum() - latencySumBefore, 20 * 0.002);
+
+		domain->tick(1ms, res);
+		res.clear();
+		ASSERT_EQUAL(61u, domain->test_getVisibilityQueueSize());
+		ASSERT_EQUAL(queueSizeBefore + 61, domain->test_getVisibilityQueueGauge().value());
+
+		//With a large budget everything should be handled.
+		domain->test_setVisibilityCheckBudget(std::chrono::hours(1));
+		domain->tick(1ms, res);
+		ASSERT_EQUAL(0u, domain->test_getVisibilityQueueSize());
+		ASSERT_EQUAL(queueSizeBefore, domain->test_getVisibilityQueueGauge().value());
+		for (auto& rock: farRocks) {
+			ASSERT_FALSE(domain->test_isMarkedForVisibilityRecalculation(rock->getIdAsInt()));
+		}
+	}
+
 	void test_visibilityPerformance(TestContext& context);
 
 	void test_stairs(TestContext& context) {
@@ -0,0 +1,361 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+#include "../TestWorld.h"
+#include "../TestPropertyManager.h"
+
+#include "server/RegionShard.h"
+
+#include "rules/simulation/LocatedEntity.h"
+#include "rules/simulation/MindsProperty.h"
+#include "rules/PhysicalProperties.h"
+
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Operation.h>
+
+#include <algorithm>
+
+using Atlas::Objects::Entity::Anonymous;
+using Atlas::Objects::Entity::RootEntity;
+
+struct TestTransport : public RegionShard::Transport {
+	std::vector<std::pair<std::string, Operation>> sent;
+	std::vector<std::pair<std::string, long>> handOffs;
+
+	bool send(const Region& region, const Operation& op) override {
+		sent.emplace_back(region.name, op);
+		return true;
+	}
+
+	bool handOff(const Region& region, const LocatedEntity& entity) override {
+		handOffs.emplace_back(region.name, entity.getIdAsInt());
+		return true;
+	}
+};
+
+struct RegionShardTest : public Cyphesis::TestBase {
+	Ref<LocatedEntity> m_root;
+	std::unique_ptr<TestWorld> m_world;
+	TestTransport* m_transport;
+	std::unique_ptr<RegionShard> m_shard;
+	std::chrono::steady_clock::time_point m_now;
+
+	RegionShardTest() {
+		ADD_TEST(RegionShardTest::test_parse);
+		ADD_TEST(RegionShardTest::test_findRegions);
+		ADD_TEST(RegionShardTest::test_mirror);
+		ADD_TEST(RegionShardTest::test_handOff);
+		ADD_TEST(RegionShardTest::test_partition);
+		ADD_TEST(RegionShardTest::test_partitionAfterRestart);
+		ADD_TEST(RegionShardTest::test_createdOutside);
+		ADD_TEST(RegionShardTest::test_handOffWithChildren);
+		ADD_TEST(RegionShardTest::test_keptWithMinds);
+		ADD_TEST(RegionShardTest::test_proxy);
+	}
+
+	void setup() override {
+		m_root = new LocatedEntity(0);
+		m_world = std::make_unique<TestWorld>(m_root);
+		auto transport = std::make_unique<TestTransport>();
+		m_transport = transport.get();
+		m_shard = std::make_unique<RegionShard>(*RegionMap::parse("west=-100,-100,0,100;east=0,-100,100,100@localhost:6768"),
+												"west",
+												10,
+												m_root,
+												std::move(transport));
+		m_now = std::chrono::steady_clock::now();
+	}
+
+	void teardown() override {
+		m_shard.reset();
+		m_world.reset();
+		m_root.reset();
+	}
+
+	Ref<LocatedEntity> createEntity(long id, WFMath::Point<3> pos) {
+		Ref<LocatedEntity> entity(new LocatedEntity(id));
+		auto prop = std::make_unique<PositionProperty<LocatedEntity>>();
+		prop->data() = pos;
+		entity->setProperty(PositionProperty<LocatedEntity>::property_name, std::move(prop));
+		m_world->addEntity(entity, m_root);
+		return entity;
+	}
+
+	static void move(LocatedEntity& entity, WFMath::Point<3> pos) {
+		entity.modPropertyClassFixed<PositionProperty<LocatedEntity>>()->data() = pos;
+		entity.increaseSequenceNumber();
+	}
+
+	void test_parse() {
+		auto map = RegionMap::parse("west=-100,-100,0,100;east=0,-100,100,100@localhost:6768");
+		ASSERT_TRUE(map.has_value());
+		ASSERT_EQUAL(map->getRegions().size(), 2u);
+		ASSERT_TRUE(map->getRegion("west")->host.empty());
+		ASSERT_EQUAL(map->getRegion("east")->host, "localhost");
+		ASSERT_EQUAL(map->getRegion("east")->port, 6768);
+		ASSERT_EQUAL(map->getRegion("east")->maxX, 100);
+
+		ASSERT_FALSE(RegionMap::parse("west=-100,-100,0").has_value());
+		ASSERT_FALSE(RegionMap::parse("west=0,0,-100,100").has_value());
+		ASSERT_FALSE(RegionMap::parse("=0,0,100,100").has_value());
+		ASSERT_FALSE(RegionMap::parse("west=0,0,100,100@localhost").has_value());
+		ASSERT_FALSE(RegionMap::parse("west=0,0,100,100;west=0,100,100,200").has_value());
+	}
+
+	void test_findRegions() {
+		auto map = *RegionMap::parse("west=-100,-100,0,100;east=0,-100,100,100");
+		//The border belongs to exactly one region.
+		ASSERT_EQUAL(map.findRegion({0, 0, 0})->name, "east");
+		ASSERT_EQUAL(map.findRegion({-0.1, 0, 0})->name, "west");
+		ASSERT_NULL(map.findRegion({0, 0, 200}));
+
+		ASSERT_EQUAL(map.findRegionsNear({-5, 0, 0}, 10).size(), 2u);
+		ASSERT_EQUAL(map.findRegionsNear({-50, 0, 0}, 10).size(), 1u);
+		ASSERT_EQUAL(map.getRegion("east")->distance({-3, 0, -104}), 5);
+	}
+
+	void test_mirror() {
+		auto entity = createEntity(1, {-5, 0, 0});
+		createEntity(2, {-50, 0, 0});
+
+		m_shard->update(m_now);
+		//Only the entity near the border is mirrored.
+		ASSERT_EQUAL(m_transport->sent.size(), 1u);
+		ASSERT_EQUAL(m_transport->sent[0].first, "east");
+		ASSERT_EQUAL(m_transport->sent[0].second->getClassNo(), Atlas::Objects::Operation::SET_NO);
+		ASSERT_EQUAL(m_transport->sent[0].second->getArgs().front()->getId(), "1");
+		ASSERT_EQUAL(m_shard->getMirroredCount(), 1u);
+
+		//Nothing is sent unless the entity has changed.
+		m_shard->update(m_now);
+		ASSERT_EQUAL(m_transport->sent.size(), 1u);
+		move(*entity, {-4, 0, 0});
+		m_shard->update(m_now);
+		ASSERT_EQUAL(m_transport->sent.size(), 2u);
+
+		//Moving away from the border removes the proxy.
+		move(*entity, {-50, 0, 0});
+		m_shard->update(m_now);
+		ASSERT_EQUAL(m_transport->sent.size(), 3u);
+		ASSERT_EQUAL(m_transport->sent[2].second->getClassNo(), Atlas::Objects::Operation::DELETE_NO);
+		ASSERT_EQUAL(m_shard->getMirroredCount(), 0u);
+	}
+
+	void test_handOff() {
+		auto entity = createEntity(1, {-5, 0, 0});
+		m_shard->update(m_now);
+
+		//Just across the border isn't far enough.
+		move(*entity, {1, 0, 0});
+		m_shard->update(m_now);
+		ASSERT_TRUE(m_transport->handOffs.empty());
+
+		move(*entity, {5, 0, 0});
+		m_transport->sent.clear();
+		m_shard->update(m_now);
+		ASSERT_EQUAL(m_transport->handOffs.size(), 1u);
+		ASSERT_EQUAL(m_transport->handOffs[0].first, "east");
+		ASSERT_EQUAL(m_transport->handOffs[0].second, 1);
+		//The receiver replaces its proxy, so it's not removed.
+		ASSERT_TRUE(m_transport->sent.empty());
+		ASSERT_EQUAL(m_shard->getMirroredCount(), 0u);
+
+		//Only one handoff at a time, until it times out.
+		m_shard->update(m_now);
+		ASSERT_EQUAL(m_transport->handOffs.size(), 1u);
+		m_shard->update(m_now + RegionShard::handOffTimeout);
+		ASSERT_EQUAL(m_transport->handOffs.size(), 2u);
+	}
+
+	void test_partition() {
+		std::vector<long> deleted;
+		m_world->m_extension.delEntityFn = [&](LocatedEntity& entity) {
+			deleted.push_back(entity.getIdAsInt());
+			entity.m_parent->removeChild(entity);
+		};
+		createEntity(1, {-5, 0, 0});
+		//Entities owned by other regions are dropped rather than handed off, as their servers have their own copies.
+		auto entity = createEntity(2, {50, 0, 0});
+		Ref<LocatedEntity> child(new LocatedEntity(6));
+		m_world->addEntity(child, entity);
+		createEntity(3, {0, 0, 0});
+		//Outside of all regions, but closest to the local one.
+		createEntity(4, {-50, 0, 150});
+		createEntity(5, {50, 0, 150});
+
+		ASSERT_EQUAL(m_shard->partition(), 3u);
+		ASSERT_EQUAL(m_root->m_contains->size(), 2u);
+		ASSERT_EQUAL(m_root->m_contains->count(m_world->getEntity(1)), 1u);
+		ASSERT_EQUAL(m_root->m_contains->count(m_world->getEntity(4)), 1u);
+		//Children are deleted before their parent, rather than being moved out into the world.
+		ASSERT_EQUAL(deleted.size(), 4u);
+		ASSERT_TRUE(std::find(deleted.begin(), deleted.end(), 6L) < std::find(deleted.begin(), deleted.end(), 2L));
+
+		m_shard->update(m_now);
+		ASSERT_TRUE(m_transport->handOffs.empty());
+
+		//Once partitioned, entities are handed off rather than dropped.
+		move(*m_world->getEntity(1), {50, 0, 0});
+		m_shard->update(m_now);
+		ASSERT_EQUAL(m_transport->handOffs.size(), 1u);
+		ASSERT_EQUAL(m_root->m_contains->size(), 2u);
+	}
+
+	void test_partitionAfterRestart() {
+		m_world->m_extension.delEntityFn = [&](LocatedEntity& entity) { m_root->removeChild(entity); };
+		createEntity(1, {-5, 0, 0});
+		m_shard->partition();
+
+		//After a restart the world only contains what was simulated here, which includes an entity outside the region
+		//which was still being simulated. It's not dropped, but handed off to the owning region.
+		createEntity(2, {50, 0, 0});
+		m_shard.reset();
+		m_shard = std::make_unique<RegionShard>(*RegionMap::parse("west=-100,-100,0,100;east=0,-100,100,100@localhost:6768"),
+												"west",
+												10,
+												m_root,
+												std::make_unique<TestTransport>());
+		ASSERT_EQUAL(m_shard->partition(), 0u);
+		ASSERT_EQUAL(m_root->m_contains->size(), 2u);
+
+		//A world partitioned for another region is still partitioned.
+		m_shard.reset();
+		m_shard = std::make_unique<RegionShard>(*RegionMap::parse("west=-100,-100,0,100;east=0,-100,100,100@localhost:6768"),
+												"east",
+												10,
+												m_root,
+												std::make_unique<TestTransport>());
+		ASSERT_EQUAL(m_shard->partition(), 1u);
+		ASSERT_EQUAL(m_root->m_contains->size(), 1u);
+	}
+
+	void test_createdOutside() {
+		m_world->m_extension.delEntityFn = [&](LocatedEntity& entity) { m_root->removeChild(entity); };
+		createEntity(1, {-5, 0, 0});
+		m_shard->partition();
+		m_shard->update(m_now);
+
+		//Entities created outside of the region after the world has been loaded, for example when dropped by a
+		//character standing at the border, are simulated here until handed off.
+		createEntity(2, {50, 0, 0});
+		m_shard->update(m_now);
+		ASSERT_EQUAL(m_transport->handOffs.size(), 1u);
+		ASSERT_EQUAL(m_transport->handOffs[0].second, 2L);
+		ASSERT_EQUAL(m_root->m_contains->size(), 2u);
+	}
+
+	void test_handOffWithChildren() {
+		auto entity = createEntity(1, {-5, 0, 0});
+		Ref<LocatedEntity> child(new LocatedEntity(2));
+		m_world->addEntity(child, entity);
+		m_shard->update(m_now);
+
+		//The children are handed off along with their parent.
+		move(*entity, {50, 0, 0});
+		m_shard->update(m_now);
+		ASSERT_EQUAL(m_transport->handOffs.size(), 1u);
+		ASSERT_EQUAL(m_transport->handOffs[0].second, 1L);
+	}
+
+	void test_keptWithMinds() {
+		auto entity = createEntity(1, {-5, 0, 0});
+		Ref<LocatedEntity> child(new LocatedEntity(2));
+		m_world->addEntity(child, entity);
+		//Any router will do as the mind.
+		Ref<LocatedEntity> mind(new LocatedEntity(3));
+		child->requirePropertyClassFixed<MindsProperty>().addMind(mind.get());
+		m_shard->update(m_now);
+
+		//Only the mind of the entity itself can follow it, so the entity is kept here and mirrored instead.
+		move(*entity, {50, 0, 0});
+		m_shard->update(m_now);
+		ASSERT_TRUE(m_transport->handOffs.empty());
+		ASSERT_EQUAL(m_shard->getMirroredCount(), 1u);
+		ASSERT_EQUAL(m_transport->sent.back().first, "east");
+
+		//Once the mind is gone it's handed off.
+		child->modPropertyClassFixed<MindsProperty>()->removeMind(mind.get(), *child);
+		m_shard->update(m_now);
+		ASSERT_EQUAL(m_transport->handOffs.size(), 1u);
+	}
+
+	void test_proxy() {
+		std::vector<RootEntity> created;
+		long newId = 100;
+		m_world->m_extension.addNewEntityFn = [&](const std::string&, const RootEntity& attrs) {
+			created.push_back(attrs);
+			Ref<LocatedEntity> entity(new LocatedEntity(newId++));
+			m_world->addEntity(entity, m_root);
+			return entity;
+		};
+		std::vector<Operation> worldOps;
+		m_world->m_extension.messageFn = [&](const Operation& op, LocatedEntity&) { worldOps.push_back(op); };
+
+		Anonymous arg;
+		arg->setId("7");
+		arg->setParent("thing");
+		arg->setLoc("0");
+		arg->setAttr("mode", "free");
+		arg->setAttr("__account", "foo");
+		arg->setAttr("name", "bar");
+		Atlas::Objects::Operation::Set set;
+		set->setArgs1(arg);
+
+		m_shard->proxyOperation(set, "peer");
+		ASSERT_EQUAL(m_shard->getProxyCount(), 1u);
+		ASSERT_EQUAL(created.size(), 1u);
+		ASSERT_EQUAL(created[0]->getLoc(), "0");
+		ASSERT_EQUAL(created[0]->getAttr("mode").String(), "fixed");
+		ASSERT_EQUAL(created[0]->getAttr("name").String(), "bar");
+		ASSERT_FALSE(created[0]->hasAttr("__account"));
+		auto proxy = m_world->getEntity(100);
+		ASSERT_TRUE(proxy->hasFlags(entity_proxy));
+
+		//Further updates are applied by the proxy itself.
+		m_shard->proxyOperation(set, "peer");
+		ASSERT_EQUAL(created.size(), 1u);
+		ASSERT_EQUAL(worldOps.size(), 1u);
+		ASSERT_EQUAL(worldOps[0]->getTo(), "100");
+		ASSERT_EQUAL(worldOps[0]->getFrom(), "100");
+
+		//Proxies are tracked per peer.
+		m_shard->proxyOperation(set, "otherPeer");
+		ASSERT_EQUAL(m_shard->getProxyCount(), 2u);
+
+		Atlas::Objects::Operation::Delete del;
+		del->setArgs1(arg);
+		m_shard->proxyOperation(del, "peer");
+		ASSERT_EQUAL(m_shard->getProxyCount(), 1u);
+		ASSERT_FALSE(m_shard->removeProxy("peer", "7"));
+		ASSERT_TRUE(m_shard->removeProxy("otherPeer", "7"));
+	}
+};
+
+int main() {
+	TestPropertyManager<LocatedEntity> propertyManager;
+	RegionShardTest t;
+
+	return t.run();
+}
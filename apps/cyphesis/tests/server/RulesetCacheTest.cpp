@@ -0,0 +1,107 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "server/RulesetCache.h"
+
+#include <Atlas/Objects/Anonymous.h>
+
+#include <cassert>
+#include <fstream>
+
+using Atlas::Message::MapType;
+using Atlas::Objects::Root;
+using Atlas::Objects::Entity::Anonymous;
+
+int main() {
+	auto directory = std::filesystem::temp_directory_path() / "cyphesis_ruleset_cache_test";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory / "rules");
+
+	auto ruleFile = directory / "rules" / "a.xml";
+	std::ofstream(ruleFile) << "<atlas></atlas>";
+	std::vector<std::filesystem::path> files{ruleFile};
+
+	auto signature = RulesetCache::signature(directory / "rules", files);
+	assert(signature == RulesetCache::signature(directory / "rules", files));
+
+	std::map<std::string, Root> rules;
+	{
+		Anonymous rule;
+		rule->setId("thing");
+		rule->setParent("game_entity");
+		rule->setObjtype("class");
+		rule->setAttr("attributes", MapType{{"mass", MapType{{"default", 10.5}}}});
+		rules.emplace("thing", rule);
+	}
+	{
+		Anonymous rule;
+		rule->setId("tree");
+		rule->setParent("thing");
+		rule->setObjtype("class");
+		rules.emplace("tree", rule);
+	}
+
+	Atlas::Objects::Factories factories;
+	RulesetCache cache(directory / "cache" / "rules.bin");
+
+	// Nothing has been written yet.
+	{
+		std::map<std::string, Root> readRules;
+		assert(!cache.read(factories, signature, readRules));
+	}
+
+	assert(cache.write(signature, rules));
+
+	{
+		std::map<std::string, Root> readRules;
+		assert(cache.read(factories, signature, readRules));
+		assert(readRules.size() == 2);
+		assert(readRules["thing"]->getParent() == "game_entity");
+		assert(readRules["tree"]->getParent() == "thing");
+		Atlas::Message::Element mass;
+		assert(readRules["thing"]->copyAttr("attributes", mass) == 0);
+		assert(mass.Map()["mass"].Map()["default"] == 10.5);
+	}
+
+	// Any change to the files should give a new signature, which means that the cache isn't used.
+	std::ofstream(ruleFile, std::ios::app) << "\n";
+	auto newSignature = RulesetCache::signature(directory / "rules", files);
+	assert(newSignature != signature);
+	{
+		std::map<std::string, Root> readRules;
+		assert(!cache.read(factories, newSignature, readRules));
+		assert(readRules.empty());
+	}
+
+	// A truncated cache should be ignored.
+	std::filesystem::resize_file(cache.path(), std::filesystem::file_size(cache.path()) - 4);
+	{
+		std::map<std::string, Root> readRules;
+		assert(!cache.read(factories, signature, readRules));
+		assert(readRules.empty());
+	}
+
+	std::filesystem::remove_all(directory);
+	return 0;
+}
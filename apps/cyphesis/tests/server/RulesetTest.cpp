@@ -357,6 +357,8 @@ int main(int argc, char** argv) {
 #include "server/EntityFactory_impl.h"
 #include "rules/simulation/CorePropertyManager.h"
 
+#include "server/RulesetCache.h"
+#include "rules/simulation/MeshShapeCache.h"
 #include "common/AtlasFileLoader.h"
 #include "common/log.h"
 #include "common/TypeNode_impl.h"
@@ -414,6 +416,30 @@ bool AtlasFileLoader::isOpen() {
 void AtlasFileLoader::read() {
 }
 
+RulesetCache::RulesetCache(std::filesystem::path path)
+		: m_path(std::move(path)) {
+}
+
+std::uint64_t RulesetCache::signature(const std::filesystem::path& directory,
+									  const std::vector<std::filesystem::path>& files) {
+	return 0;
+}
+
+bool RulesetCache::read(const Atlas::Objects::Factories& factories,
+						std::uint64_t signature,
+						std::map<std::string, Atlas::Objects::Root>& rules) const {
+	return false;
+}
+
+bool RulesetCache::write(std::uint64_t signature,
+						 const std::map<std::string, Atlas::Objects::Root>& rules) const {
+	return true;
+}
+
+std::vector<std::shared_ptr<MeshShape>> MeshShapeCache::preload(const std::map<std::filesystem::path, bool>& paths) {
+	return {};
+}
+
 
 const Atlas::Objects::Root& Inheritance::getClass(const std::string& typeName, Visibility visibility) const {
 	auto I = atlasObjects.find(typeName);
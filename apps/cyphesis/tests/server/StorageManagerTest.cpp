@@ -25,6 +25,7 @@
 
 #include "server/StorageManager.h"
 #include "server/Persistence.h"
+#include "server/WorldSnapshot.h"
 
 #include "rules/simulation/WorldRouter.h"
 
@@ -177,6 +178,20 @@ int main() {
 		store.test_restoreChildren(*e1);
 	}
 
+	{
+		WorldRouter world(le, eb, {});
+
+		DatabaseNull emptyDatabase;
+		StorageManager store(world, emptyDatabase, eb, propertyManager);
+
+		//Restoring into an empty database must not let new ids collide with the restored ones.
+		WorldSnapshot snapshot({{0, WorldSnapshot::noParent, "world", 0, {}},
+								{42, 0, "thing", 0, {}},
+								{7, 42, "thing", 0, {}}});
+		store.importSnapshot(snapshot);
+		assert(emptyDatabase.newId() > 42);
+	}
+
 
 	return 0;
 }
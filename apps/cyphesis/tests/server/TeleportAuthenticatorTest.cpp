@@ -55,7 +55,7 @@ public:
 	}
 
 	LocatedEntity* test_addEntity(LocatedEntity* ent, long intId) {
-		m_eobjects[intId] = ent;
+		m_eobjects.insert(intId, ent);
 		return ent;
 	}
 };
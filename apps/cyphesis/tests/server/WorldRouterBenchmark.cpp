@@ -0,0 +1,220 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../BenchmarkBase.h"
+#include "../DatabaseNull.h"
+#include "../TestPropertyManager.h"
+
+#include "rules/simulation/WorldRouter.h"
+#include "rules/simulation/LocatedEntity.h"
+#include "rules/simulation/Inheritance.h"
+
+#include "server/EntityBuilder.h"
+#include "server/StorageManager.h"
+
+#include "common/Monitors.h"
+
+#include <Atlas/Objects/Operation.h>
+
+using Atlas::Objects::Operation::Touch;
+
+namespace {
+auto timeProviderFn = [] { return std::chrono::steady_clock::now().time_since_epoch(); };
+}
+
+/**
+ * Exposes the signal handlers, so that entities can be queued without going through the full entity lifecycle.
+ */
+struct BenchmarkStorageManager : public StorageManager {
+	using StorageManager::StorageManager;
+	using StorageManager::entityUpdated;
+};
+
+class WorldRouterBenchmark : public Cyphesis::BenchmarkBase {
+protected:
+	static long m_id_counter;
+
+	EntityBuilder m_eb;
+
+public:
+	WorldRouterBenchmark();
+
+	static long newId();
+
+	/**
+	 * Adds the supplied number of entities as direct children of the world root.
+	 */
+	std::vector<Ref<LocatedEntity>> populate(WorldRouter& world, size_t count);
+
+	void op_throughput(Cyphesis::BenchmarkState& state);
+
+	void broadcast_throughput(Cyphesis::BenchmarkState& state);
+
+	void entity_lookup(Cyphesis::BenchmarkState& state);
+
+	void storage_insert_flush(Cyphesis::BenchmarkState& state);
+
+	void storage_update_flush(Cyphesis::BenchmarkState& state);
+};
+
+long WorldRouterBenchmark::m_id_counter = 0L;
+
+WorldRouterBenchmark::WorldRouterBenchmark()
+		: Cyphesis::BenchmarkBase({100, 1000, 10000}) {
+	ADD_BENCHMARK(WorldRouterBenchmark::op_throughput, 30);
+	ADD_BENCHMARK(WorldRouterBenchmark::broadcast_throughput, 10);
+	ADD_BENCHMARK(WorldRouterBenchmark::entity_lookup, 30);
+	ADD_BENCHMARK(WorldRouterBenchmark::storage_insert_flush, 10);
+	ADD_BENCHMARK(WorldRouterBenchmark::storage_update_flush, 30);
+}
+
+long WorldRouterBenchmark::newId() {
+	return ++m_id_counter;
+}
+
+std::vector<Ref<LocatedEntity>> WorldRouterBenchmark::populate(WorldRouter& world, size_t count) {
+	std::vector<Ref<LocatedEntity>> entities;
+	entities.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		Ref<LocatedEntity> entity = new LocatedEntity(newId());
+		world.addEntity(entity, world.getBaseEntity());
+		entities.push_back(entity);
+	}
+	return entities;
+}
+
+void WorldRouterBenchmark::op_throughput(Cyphesis::BenchmarkState& state) {
+	Ref<LocatedEntity> base = new LocatedEntity(newId());
+	WorldRouter world(base, m_eb, timeProviderFn);
+	auto entities = populate(world, state.entities());
+	//Get rid of the Appearance ops sent when adding the entities.
+	world.getOperationsHandler().processUntil(timeProviderFn(), std::chrono::seconds(60));
+
+	size_t dispatched = 0;
+	state.measure([&]() {
+		//Each entity sends an op to another entity, which is then routed through the queue.
+		for (size_t i = 0; i < entities.size(); ++i) {
+			auto& from = entities[i];
+			auto& to = entities[(i + 1) % entities.size()];
+			Touch touch;
+			touch->setFrom(from->getIdAsString());
+			touch->setTo(to->getIdAsString());
+			world.message(touch, *from);
+		}
+		dispatched += world.getOperationsHandler().processUntil(timeProviderFn(), std::chrono::seconds(60));
+	});
+	state.setCounter("ops_per_iteration", static_cast<double>(dispatched) / static_cast<double>(state.iterations()));
+
+	world.shutdown();
+}
+
+void WorldRouterBenchmark::broadcast_throughput(Cyphesis::BenchmarkState& state) {
+	Ref<LocatedEntity> base = new LocatedEntity(newId());
+	WorldRouter world(base, m_eb, timeProviderFn);
+	auto entities = populate(world, state.entities());
+	world.getOperationsHandler().processUntil(timeProviderFn(), std::chrono::seconds(60));
+
+	//An op without "to" is delivered to every entity in the world.
+	state.measure([&]() {
+		Touch touch;
+		touch->setFrom(base->getIdAsString());
+		world.operation(touch, base);
+	});
+
+	world.shutdown();
+}
+
+void WorldRouterBenchmark::entity_lookup(Cyphesis::BenchmarkState& state) {
+	Ref<LocatedEntity> base = new LocatedEntity(newId());
+	WorldRouter world(base, m_eb, timeProviderFn);
+	auto entities = populate(world, state.entities());
+
+	size_t found = 0;
+	state.measure([&]() {
+		for (auto& entity: entities) {
+			if (world.getEntity(entity->getIdAsInt())) {
+				found++;
+			}
+		}
+	});
+	state.setCounter("found_per_iteration", static_cast<double>(found) / static_cast<double>(state.iterations()));
+
+	world.shutdown();
+}
+
+void WorldRouterBenchmark::storage_insert_flush(Cyphesis::BenchmarkState& state) {
+	DatabaseNull database;
+	TestPropertyManager<LocatedEntity> propertyManager;
+	Ref<LocatedEntity> base = new LocatedEntity(newId());
+	WorldRouter world(base, m_eb, timeProviderFn);
+	StorageManager store(world, database, m_eb, propertyManager);
+
+	//New entities are queued for insertion when added to the world, and written on the next tick.
+	std::vector<Ref<LocatedEntity>> entities;
+	state.measure([&]() {
+					  auto batch = populate(world, state.entities());
+					  entities.insert(entities.end(), batch.begin(), batch.end());
+				  },
+				  [&]() {
+					  store.tick();
+				  });
+	state.setCounter("entities_stored", static_cast<double>(entities.size()));
+
+	world.shutdown();
+}
+
+void WorldRouterBenchmark::storage_update_flush(Cyphesis::BenchmarkState& state) {
+	DatabaseNull database;
+	TestPropertyManager<LocatedEntity> propertyManager;
+	Ref<LocatedEntity> base = new LocatedEntity(newId());
+	WorldRouter world(base, m_eb, timeProviderFn);
+	BenchmarkStorageManager store(world, database, m_eb, propertyManager);
+
+	auto entities = populate(world, state.entities());
+	//Do the initial insert.
+	store.tick();
+
+	state.measure([&]() {
+					  for (auto& entity: entities) {
+						  entity->removeFlags(entity_clean);
+						  store.entityUpdated(*entity);
+					  }
+				  },
+				  [&]() {
+					  store.tick();
+				  });
+
+	world.shutdown();
+}
+
+
+int main(int argc, char** argv) {
+	Monitors m;
+	Inheritance inheritance;
+	WorldRouterBenchmark t;
+	t.parseArgs(argc, argv);
+
+	return t.run();
+}
@@ -0,0 +1,176 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2026 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "server/WorldSnapshot.h"
+
+#include "rules/simulation/LocatedEntity.h"
+#include "common/Property_impl.h"
+
+#include <unistd.h>
+
+using Atlas::Message::Element;
+using Atlas::Message::MapType;
+
+struct WorldSnapshotTest : public Cyphesis::TestBase {
+	Ref<LocatedEntity> m_root;
+	Ref<LocatedEntity> m_child;
+	std::filesystem::path m_path;
+
+	WorldSnapshotTest() {
+		ADD_TEST(WorldSnapshotTest::test_capture);
+		ADD_TEST(WorldSnapshotTest::test_copyOnWrite);
+		ADD_TEST(WorldSnapshotTest::test_incremental);
+		ADD_TEST(WorldSnapshotTest::test_writeAndRead);
+		ADD_TEST(WorldSnapshotTest::test_writer);
+	}
+
+	void addChild(LocatedEntity& parent, const Ref<LocatedEntity>& child) {
+		parent.makeContainer();
+		parent.m_contains->insert(child);
+		child->m_parent = &parent;
+	}
+
+	void setup() override {
+		m_root = new LocatedEntity(1);
+		m_child = new LocatedEntity(2);
+		addChild(*m_root, m_child);
+		m_child->setProperty("map", std::make_unique<SoftProperty<LocatedEntity>>(MapType{{"foo", "bar"}}));
+		m_child->setProperty("number", std::make_unique<SoftProperty<LocatedEntity>>(3));
+
+		auto ephem = new SoftProperty<LocatedEntity>(4);
+		ephem->addFlags(prop_flag_persistence_ephem);
+		m_child->setProperty("ephem", std::unique_ptr<PropertyBase>(ephem));
+
+		//Neither ephemeral entities nor their children should be included.
+		Ref<LocatedEntity> ephemEntity(new LocatedEntity(3));
+		ephemEntity->addFlags(entity_ephem);
+		addChild(*m_root, ephemEntity);
+		addChild(*ephemEntity, new LocatedEntity(4));
+
+		m_path = std::filesystem::temp_directory_path() / ("WorldSnapshotTest-" + std::to_string(getpid()) + ".db3");
+	}
+
+	void teardown() override {
+		std::filesystem::remove(m_path);
+		m_child = nullptr;
+		m_root = nullptr;
+	}
+
+	void test_capture() {
+		auto snapshot = WorldSnapshot::capture(*m_root);
+		auto& entities = snapshot->getEntities();
+		ASSERT_EQUAL(entities.size(), 2u);
+		ASSERT_EQUAL(entities[0].id, 1);
+		ASSERT_EQUAL(entities[0].parentId, WorldSnapshot::noParent);
+		ASSERT_EQUAL(entities[1].id, 2);
+		ASSERT_EQUAL(entities[1].parentId, 1);
+		ASSERT_EQUAL(entities[1].properties.size(), 2u);
+		ASSERT_EQUAL(snapshot->getPropertyCount(), 2u);
+	}
+
+	void test_copyOnWrite() {
+		auto snapshot = WorldSnapshot::capture(*m_root);
+
+		//Altering the property after the capture must not alter the snapshot.
+		auto prop = dynamic_cast<SoftProperty<LocatedEntity>*>(m_child->modProperty("map"));
+		ASSERT_NOT_NULL(prop);
+		prop->data().Map()["foo"] = "baz";
+
+		for (auto& property: snapshot->getEntities()[1].properties) {
+			if (property.first == "map") {
+				ASSERT_TRUE(property.second == Element(MapType{{"foo", "bar"}}));
+			}
+		}
+	}
+
+	void test_incremental() {
+		WorldSnapshotCapture capture(*m_root);
+		//Only the root is captured, which then makes its children visible.
+		ASSERT_EQUAL(capture.capture(1), 2u);
+		ASSERT_FALSE(capture.hasVisitedAll());
+		ASSERT_EQUAL(capture.capture(10), 0u);
+		ASSERT_TRUE(capture.hasVisitedAll());
+
+		//Changes made after an entity has been captured are captured again, as are new entities.
+		m_child->setProperty("number", std::make_unique<SoftProperty<LocatedEntity>>(5));
+		capture.entityChanged(*m_child);
+		Ref<LocatedEntity> newEntity(new LocatedEntity(5));
+		addChild(*m_child, newEntity);
+		capture.entityChanged(*newEntity);
+		ASSERT_EQUAL(capture.remaining(), 2u);
+
+		auto snapshot = capture.finish();
+		auto& entities = snapshot->getEntities();
+		ASSERT_EQUAL(entities.size(), 3u);
+		ASSERT_EQUAL(entities[0].id, 1);
+		ASSERT_EQUAL(entities[1].id, 2);
+		ASSERT_EQUAL(entities[2].id, 5);
+		ASSERT_EQUAL(entities[2].parentId, 2);
+		for (auto& property: entities[1].properties) {
+			if (property.first == "number") {
+				ASSERT_TRUE(property.second == Element(5));
+			}
+		}
+	}
+
+	void test_writeAndRead() {
+		WorldSnapshot::capture(*m_root)->writeToSQLite(m_path);
+		ASSERT_TRUE(std::filesystem::exists(m_path));
+
+		auto snapshot = WorldSnapshot::readFromSQLite(m_path);
+		auto& entities = snapshot->getEntities();
+		ASSERT_EQUAL(entities.size(), 2u);
+		ASSERT_EQUAL(entities[0].id, 1);
+		ASSERT_EQUAL(entities[1].id, 2);
+		ASSERT_EQUAL(entities[1].parentId, 1);
+		ASSERT_EQUAL(entities[1].properties.size(), 2u);
+		for (auto& property: entities[1].properties) {
+			if (property.first == "map") {
+				ASSERT_TRUE(property.second == Element(MapType{{"foo", "bar"}}));
+			} else {
+				ASSERT_EQUAL(property.first, "number");
+				ASSERT_TRUE(property.second == Element(3));
+			}
+		}
+	}
+
+	void test_writer() {
+		WorldSnapshotWriter writer;
+		ASSERT_TRUE(writer.write(WorldSnapshot::capture(*m_root), m_path));
+		ASSERT_TRUE(writer.isWriting());
+		//Only one snapshot at a time.
+		ASSERT_FALSE(writer.write(WorldSnapshot::capture(*m_root), m_path));
+		writer.wait();
+		ASSERT_FALSE(writer.isWriting());
+		ASSERT_TRUE(std::filesystem::exists(m_path));
+	}
+};
+
+int main() {
+	WorldSnapshotTest t;
+
+	return t.run();
+}
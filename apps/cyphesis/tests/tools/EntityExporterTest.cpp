@@ -20,9 +20,14 @@
 #include "../TestBaseWithContext.h"
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Entity.h>
+#include <Atlas/MultiLineListFormatter.h>
 
 #include "tools/EntityExporterBase.h"
 
+#include <filesystem>
+#include <sstream>
+#include <unistd.h>
+
 
 using Atlas::Message::MapType;
 using Atlas::Message::ListType;
@@ -31,11 +36,30 @@ struct TestContext {
 
 };
 
+struct TestExporter : public EntityExporterBase {
+	TestExporter() : EntityExporterBase("1", "2", "0") {}
+
+	long int newSerialNumber() override {
+		return 0;
+	}
+
+	void send(const Atlas::Objects::Operation::RootOperation&) override {}
+
+	void sendAndAwaitResponse(const Atlas::Objects::Operation::RootOperation&, CallbackFunction&) override {}
+
+	Atlas::Formatter* createMultiLineFormatter(std::iostream& s, Atlas::Bridge& b) override {
+		return new Atlas::MultiLineListFormatter(s, b);
+	}
+
+	void fillWithServerData(Atlas::Message::MapType&) override {}
+};
+
 
 struct Tested : public Cyphesis::TestBaseWithContext<TestContext> {
 	Tested() {
 		ADD_TEST(test_extract_list);
 		ADD_TEST(test_extract_map);
+		ADD_TEST(test_export_entities);
 	}
 
 	void test_extract_list(TestContext& context) {
@@ -131,6 +155,48 @@ struct Tested : public Cyphesis::TestBaseWithContext<TestContext> {
 			ASSERT_EQUAL(expected, result)
 		}
 	}
+
+	void test_export_entities(TestContext& context) {
+		auto path = std::filesystem::temp_directory_path() / ("EntityExporterTest-" + std::to_string(getpid()) + ".xml");
+
+		auto makeEntity = [](const std::string& id, const std::string& loc, const std::string& name, std::vector<std::string> contains) {
+			Atlas::Objects::Entity::Anonymous entity;
+			entity->setId(id);
+			entity->setParent("thing");
+			if (!loc.empty()) {
+				entity->setLoc(loc);
+			}
+			entity->setName(name);
+			entity->setContains(std::move(contains));
+			return Atlas::Objects::Entity::RootEntity(entity);
+		};
+
+		auto transient = makeEntity("1", "0", "transient_entity", {"3"});
+		transient->setAttr("transient", 1);
+		std::vector<Atlas::Objects::Entity::RootEntity> entities{
+				makeEntity("0", "", "root_entity", {"1", "2"}),
+				transient,
+				makeEntity("2", "0", "kept_entity", {}),
+				makeEntity("3", "1", "child_of_transient", {})
+		};
+
+		TestExporter exporter;
+		bool completed = false;
+		exporter.EventCompleted.connect([&]() { completed = true; });
+		exporter.exportEntities(path.string(), entities);
+		ASSERT_TRUE(completed)
+
+		std::ifstream file(path);
+		std::stringstream contents;
+		contents << file.rdbuf();
+		std::filesystem::remove(path);
+
+		//Transient entities, and anything they contain, should be skipped.
+		ASSERT_TRUE(contents.str().find("root_entity") != std::string::npos)
+		ASSERT_TRUE(contents.str().find("kept_entity") != std::string::npos)
+		ASSERT_TRUE(contents.str().find("transient_entity") == std::string::npos)
+		ASSERT_TRUE(contents.str().find("child_of_transient") == std::string::npos)
+	}
 };
 
 
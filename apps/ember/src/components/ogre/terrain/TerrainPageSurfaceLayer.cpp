@@ -137,15 +137,6 @@ const TerrainLayerDefinition& TerrainPageSurfaceLayer::getDefinition() const {
 void TerrainPageSurfaceLayer::populate(const TerrainPageGeometry& geometry) {
 	const SegmentVector validSegments = geometry.getValidSegments();
 	for (const auto& validSegment: validSegments) {
-#if 0
-		//the current Mercator code works such that whenever an Area is added to Terrain, _all_ surfaces for the affected segments are invalidated, thus requiering a total repopulation of the segment
-		//If however that code was changed to only invalidate the affected surface the code below would be very much handy
-		Mercator::Surface* surface(getSurfaceForSegment(I->segment));
-		if (surface) {
-			surface->populate();
-		}
-#else
-
 		Mercator::Segment* segment(validSegment.segment);
 		if (!segment->isValid()) {
 			segment->populate();
@@ -160,9 +151,9 @@ void TerrainPageSurfaceLayer::populate(const TerrainPageGeometry& geometry) {
 				sss[mSurfaceIndex] = mShader.newSurface(*segment);
 			}
 		}
-		//NOTE: we have to repopulate all surfaces mainly to get the foliage to work.
+		//NOTE: we populate all surfaces mainly to get the foliage to work.
+		//Mercator keeps track of which parts of each surface have been touched by area and mod updates, so only those parts are shaded again.
 		segment->populateSurfaces();
-#endif
 	}
 }
 
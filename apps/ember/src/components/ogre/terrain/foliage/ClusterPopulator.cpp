@@ -47,7 +47,7 @@ void ClusterPopulator::populate(PlantAreaQueryResult& result, SegmentRefPtr segm
 	for (auto I = mercatorSegment.getSurfaces().begin(); I != mercatorSegment.getSurfaces().end(); ++I) {
 		if (I->first >= mLayerIndex) {
 			if (I->second->m_shader.checkIntersect(mercatorSegment)) {
-				if (!I->second->isValid()) {
+				if (I->second->isDirty()) {
 					I->second->populate();
 				}
 				indexSort.push_back(I->first);
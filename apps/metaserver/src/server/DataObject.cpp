@@ -21,30 +21,105 @@
 #include "DataObject.hpp"
 #include <spdlog/spdlog.h>
 #include <fmt/ostream.h>
+#include <cstdlib>
 
 template<>
 struct fmt::formatter<boost::posix_time::ptime> : ostream_formatter {
 };
 
-DataObject::DataObject() {
-	m_serverData.clear();
-	m_clientData.clear();
-	m_clientFilterData.clear();
-	m_handshakeQueue.clear();
-	m_serverListreq.clear();
-	m_listreqExpiry.clear();
+namespace {
+/*
+ * arbitrary iso string used when a supplied expiry can not be parsed, guaranteeing expiry
+ */
+const std::string expiryDefault = "20000101T010000.000000";
 }
 
+DataObject::DataObject() = default;
+
 
 DataObject::~DataObject() = default;
 
+DataObject::ServerSession&
+DataObject::touchServerSession(ServerShard& shard, const std::string& sessionid) {
+	auto result = shard.data.try_emplace(sessionid);
+	if (result.second) {
+		/*
+		 * A new session always gets an expiry, so that it's subject to the sweep.
+		 */
+		setServerExpiry(shard, sessionid, result.first->second, getNow());
+		m_serverListDirty = true;
+	}
+	return result.first->second;
+}
+
+DataObject::ClientSession&
+DataObject::touchClientSession(ClientShard& shard, const std::string& sessionid) {
+	auto result = shard.data.try_emplace(sessionid);
+	if (result.second) {
+		setClientExpiry(shard, sessionid, result.first->second, getNow());
+	}
+	return result.first->second;
+}
+
+void
+DataObject::setServerExpiry(ServerShard& shard, const std::string& sessionid, ServerSession& session, boost::posix_time::ptime expiry) {
+	session.expiry = expiry;
+	shard.expiryQueue.push(sessionid, expiry);
+}
+
+void
+DataObject::setClientExpiry(ClientShard& shard, const std::string& sessionid, ClientSession& session, boost::posix_time::ptime expiry) {
+	session.expiry = expiry;
+	shard.expiryQueue.push(sessionid, expiry);
+}
+
+std::string
+DataObject::getAttribute(const std::map<std::string, std::string>& attributes, boost::posix_time::ptime expiry, const std::string& key) {
+	if (key == "expiry") {
+		return boost::posix_time::to_iso_string(expiry);
+	}
+	auto I = attributes.find(key);
+	if (I != attributes.end()) {
+		return I->second;
+	}
+	return "";
+}
+
+boost::posix_time::ptime
+DataObject::parseExpiry(const std::string& value) {
+	try {
+		return boost::posix_time::from_iso_string(value);
+	}
+	catch (const std::exception&) {
+		/*
+		 * Whoops, date is malformed. Reset it so the session will disappear by itself.
+		 */
+		spdlog::warn("expiry time '{}' seems bad, resetting: {}", value, expiryDefault);
+		return boost::posix_time::from_iso_string(expiryDefault);
+	}
+}
+
 bool
 DataObject::addServerAttribute(const std::string& sessionid, const std::string& name, const std::string& value) {
 	/**
 	 * Can not have empty values for required keys, value *can* be an empty string
 	 */
-	if (!sessionid.empty() && !sessionid.empty() && !name.empty() && !name.empty()) {
-		m_serverData[sessionid][name] = value;
+	if (!sessionid.empty() && !name.empty()) {
+		auto& shard = shardFor(m_serverShards, sessionid);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto& session = touchServerSession(shard, sessionid);
+		if (name == "expiry") {
+			setServerExpiry(shard, sessionid, session, parseExpiry(value));
+		} else {
+			auto& attribute = session.attributes[name];
+			if (name == "ip_int" && attribute != value) {
+				/*
+				 * The address is part of the serialized server list.
+				 */
+				m_serverListDirty = true;
+			}
+			attribute = value;
+		}
 		spdlog::trace("  AddServerAttribute: {}:{}:{}", sessionid, name, value);
 		return true;
 	}
@@ -60,9 +135,12 @@ DataObject::removeServerAttribute(const std::string& sessionid, const std::strin
 	 * 	port
 	 * 	expiry
 	 */
-	if (m_serverData.find(sessionid) != m_serverData.end()) {
+	auto& shard = shardFor(m_serverShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto I = shard.data.find(sessionid);
+	if (I != shard.data.end()) {
 		if (name != "ip" && name != "expiry" && name != "port") {
-			m_serverData[sessionid].erase(name);
+			I->second.attributes.erase(name);
 		}
 
 	}
@@ -70,10 +148,11 @@ DataObject::removeServerAttribute(const std::string& sessionid, const std::strin
 
 std::string
 DataObject::getServerAttribute(const std::string& sessionid, const std::string& key) {
-	if (m_serverData.find(sessionid) != m_serverData.end()) {
-		if (m_serverData[sessionid].find(key) != m_serverData[sessionid].end()) {
-			return m_serverData[sessionid][key];
-		}
+	auto& shard = shardFor(m_serverShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto I = shard.data.find(sessionid);
+	if (I != shard.data.end()) {
+		return getAttribute(I->second.attributes, I->second.expiry, key);
 	}
 	return "";
 }
@@ -83,8 +162,15 @@ DataObject::addClientAttribute(const std::string& sessionid, const std::string&
 	/**
 	 * Can not have empty values for required keys, value *can* be an empty string
 	 */
-	if (!sessionid.empty() && !sessionid.empty() && !name.empty() && !name.empty()) {
-		m_clientData[sessionid][name] = value;
+	if (!sessionid.empty() && !name.empty()) {
+		auto& shard = shardFor(m_clientShards, sessionid);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto& session = touchClientSession(shard, sessionid);
+		if (name == "expiry") {
+			setClientExpiry(shard, sessionid, session, parseExpiry(value));
+		} else {
+			session.attributes[name] = value;
+		}
 		return true;
 	}
 	return false;
@@ -99,9 +185,12 @@ DataObject::removeClientAttribute(const std::string& sessionid, const std::strin
 	 * 	port
 	 * 	expiry
 	 */
-	if (m_clientData.find(sessionid) != m_clientData.end()) {
+	auto& shard = shardFor(m_clientShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto I = shard.data.find(sessionid);
+	if (I != shard.data.end()) {
 		if (name != "ip" && name != "expiry" && name != "port") {
-			m_clientData[sessionid].erase(name);
+			I->second.attributes.erase(name);
 		}
 
 	}
@@ -109,10 +198,11 @@ DataObject::removeClientAttribute(const std::string& sessionid, const std::strin
 
 std::string
 DataObject::getClientAttribute(const std::string& sessionid, const std::string& key) {
-	if (m_clientData.find(sessionid) != m_clientData.end()) {
-		if (m_clientData[sessionid].find(key) != m_clientData[sessionid].end()) {
-			return m_clientData[sessionid][key];
-		}
+	auto& shard = shardFor(m_clientShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto I = shard.data.find(sessionid);
+	if (I != shard.data.end()) {
+		return getAttribute(I->second.attributes, I->second.expiry, key);
 	}
 	return "";
 }
@@ -122,15 +212,18 @@ DataObject::addClientFilter(const std::string& sessionid, const std::string& nam
 	/**
 	 * Can not have empty values for required keys, value *can* be an empty string
 	 */
-	if (!sessionid.empty() && !sessionid.empty() && !name.empty() && !name.empty()) {
-		if (keyExists<std::string>(m_clientData, sessionid)) {
+	if (!sessionid.empty() && !name.empty()) {
+		auto& shard = shardFor(m_clientShards, sessionid);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto I = shard.data.find(sessionid);
+		if (I != shard.data.end()) {
 			/**
 			 * This serves as both a create and update.  In order to prevent DOS
 			 * style attack on MS, make establishing a session is a requirement
-			 * to add a filter.  Also, some cleanup processes will expire out
-			 * filter data that does not have a corresponding client session
+			 * to add a filter.  Filters live inside the client session, so they
+			 * are expired along with it.
 			 */
-			m_clientFilterData[sessionid][name] = value;
+			I->second.filters[name] = value;
 			return true;
 		}
 	}
@@ -139,24 +232,25 @@ DataObject::addClientFilter(const std::string& sessionid, const std::string& nam
 
 std::map<std::string, std::string>
 DataObject::getClientFilter(const std::string& sessionid) {
-	std::map<std::string, std::string> empty;
-	empty.clear();
-
-	if (keyExists<std::string>(m_clientFilterData, sessionid) &&
-		keyExists<std::string>(m_clientData, sessionid)) {
-		return m_clientFilterData[sessionid];
+	auto& shard = shardFor(m_clientShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto I = shard.data.find(sessionid);
+	if (I != shard.data.end()) {
+		return I->second.filters;
 	}
-	return empty;
+	return {};
 }
 
 std::string
 DataObject::getClientFilter(const std::string& sessionid, const std::string& key) {
-
-
-	if (m_clientFilterData.find(sessionid) != m_clientFilterData.end() &&
-		m_clientFilterData[sessionid].find(key) != m_clientFilterData[sessionid].end() &&
-		m_clientData.find(sessionid) != m_clientData.end()) {
-		return m_clientFilterData[sessionid][key];
+	auto& shard = shardFor(m_clientShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto I = shard.data.find(sessionid);
+	if (I != shard.data.end()) {
+		auto J = I->second.filters.find(key);
+		if (J != I->second.filters.end()) {
+			return J->second;
+		}
 	}
 
 	return "";
@@ -164,8 +258,11 @@ DataObject::getClientFilter(const std::string& sessionid, const std::string& key
 
 void
 DataObject::removeClientFilter(const std::string& sessionid, const std::string& name) {
-	if (m_clientFilterData.find(sessionid) != m_clientFilterData.end()) {
-		m_clientFilterData[sessionid].erase(name);
+	auto& shard = shardFor(m_clientShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto I = shard.data.find(sessionid);
+	if (I != shard.data.end()) {
+		I->second.filters.erase(name);
 	}
 }
 
@@ -173,20 +270,22 @@ bool
 DataObject::addServerSession(const std::string& sessionid) {
 
 	bool ret = false;
+	auto& shard = shardFor(m_serverShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
 	/*
 	 *  If the server session does not exist, create it
 	 */
-	if (!keyExists<std::string>(m_serverData, sessionid)) {
-		addServerAttribute(sessionid, "ip", sessionid);
+	auto I = shard.data.find(sessionid);
+	if (I == shard.data.end()) {
+		touchServerSession(shard, sessionid).attributes["ip"] = sessionid;
 		ret = true;
+	} else {
+		/*
+		 *  The structure already exists, just refresh the timeout
+		 */
+		setServerExpiry(shard, sessionid, I->second, getNow());
 	}
 
-	/*
-	 *  If a new structure, this will create the expiry, if existing it will just
-	 *  refresh the timeout
-	 */
-	addServerAttribute(sessionid, "expiry", getNowStr());
-
 
 	return ret;
 
@@ -195,89 +294,90 @@ DataObject::addServerSession(const std::string& sessionid) {
 void
 DataObject::removeServerSession(const std::string& sessionid) {
 
+	auto& shard = shardFor(m_serverShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
 	/*
-	 * Erase from main data
+	 * Erase from main data. Any entry in the expiry queue becomes stale
+	 * and is discarded when reached.
 	 */
-	m_serverData.erase(sessionid);
-
-	/*
-	 * If we remove a session, blast out the default cache and let it
-	 * be recreated
-	 */
-	m_serverListreq.erase("default");
+	if (shard.data.erase(sessionid) == 1) {
+		/*
+		 * The server list needs to be rebuilt. Clients already paging through
+		 * the old snapshot will continue to do so.
+		 */
+		m_serverListDirty = true;
+	}
 }
 
 bool
 DataObject::serverSessionExists(const std::string& sessionid) {
-	return keyExists<std::string>(m_serverData, sessionid);
+	auto& shard = shardFor(m_serverShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	return shard.data.find(sessionid) != shard.data.end();
 }
 
 std::map<std::string, std::string>
 DataObject::getServerSession(const std::string& sessionid) {
-	if (keyExists<std::string>(m_serverData, sessionid))
-		return m_serverData[sessionid];
+	auto& shard = shardFor(m_serverShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto I = shard.data.find(sessionid);
+	if (I != shard.data.end()) {
+		auto session = I->second.attributes;
+		session["expiry"] = boost::posix_time::to_iso_string(I->second.expiry);
+		return session;
+	}
 
-	std::map<std::string, std::string> empty;
-	empty.clear();
-	return empty;
+	return {};
 }
 
 bool DataObject::addClientSession(const std::string& sessionid) {
 	bool ret = false;
+	auto& shard = shardFor(m_clientShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
 	/*
 	 *  If the client session does not exist, create it, and add+uniq the listresp
 	 */
-	if (!keyExists<std::string>(m_clientData, sessionid)) {
-		addClientAttribute(sessionid, "ip", sessionid);
+	auto I = shard.data.find(sessionid);
+	if (I == shard.data.end()) {
+		touchClientSession(shard, sessionid).attributes["ip"] = sessionid;
 		ret = true;
+	} else {
+		/*
+		 *  The structure already exists, just refresh the timeout
+		 */
+		setClientExpiry(shard, sessionid, I->second, getNow());
 	}
 
-	/*
-	 *  If a new structure, this will create the expiry, if existing it will just
-	 *  refresh the timeout
-	 */
-	addClientAttribute(sessionid, "expiry", getNowStr());
-
 	return ret;
 }
 
 
 void
 DataObject::removeClientSession(const std::string& sessionid) {
-	m_clientFilterData.erase(sessionid);
-	if (m_clientData.erase(sessionid) == 1) {
-		// logging if any
-	}
+	auto& shard = shardFor(m_clientShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
 	/*
-	 * If we have an listresp cache, remove it as well
+	 * Filters are part of the session, and go away with it.
 	 */
-//	m_serverListreq.erase(sessionid);
-//	if( m_serverListreq.find(sessionid) != m_serverListreq.end() )
-//	{
-//		m_serverListreq.erase(sessionid);
-//	}
-//
-//	/*
-//	 * Blast out the default cache and let it be
-//	 * recreated
-//	 */
-//	m_serverListreq.erase("default");
+	shard.data.erase(sessionid);
 }
 
 bool
 DataObject::clientSessionExists(const std::string& sessionid) {
-	return keyExists<std::string>(m_clientData, sessionid);
+	auto& shard = shardFor(m_clientShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	return shard.data.find(sessionid) != shard.data.end();
 }
 
 std::list<std::string>
 DataObject::getClientSessionList() {
 	std::list<std::string> cslist;
-	cslist.clear();
 
-	std::map<std::string, std::map<std::string, std::string> >::iterator it;
-
-	for (it = m_clientData.begin(); it != m_clientData.end(); it++) {
-		cslist.push_back(it->first);
+	for (auto& shard: m_clientShards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for (auto& entry: shard.data) {
+			cslist.push_back(entry.first);
+		}
 	}
 
 	return cslist;
@@ -286,106 +386,64 @@ DataObject::getClientSessionList() {
 std::list<std::string>
 DataObject::getServerSessionList(uint32_t start_idx, uint32_t max_items, std::string sessionid) {
 	std::list<std::string> ss_slice;
-	std::vector<std::string>::iterator ss_itr;
-
-	ss_slice.clear();
 
-	spdlog::trace("pre - start_idx: {} -- max_items:{} -- ss_slice:{} -- serverData: {}", start_idx, max_items, ss_slice.size(), m_serverData.size());
-
-
-	/*
-	 * in the event of no session specified, just use the "default" list
-	 */
-	spdlog::trace("getServerSessionList({})", sessionid);
+	spdlog::trace("getServerSessionList({}) - start_idx: {} -- max_items:{}", sessionid, start_idx, max_items);
 
 	/*
-	 * If we're doing the default list and it doesn't match with the current data
-	 * create it
+	 * If we're doing the default list, make sure it's bound to the latest snapshot
 	 */
 	if (start_idx == 0 && sessionid == "default") {
 		spdlog::trace("Refreshing (default) server list");
 		createServerSessionListresp("default");
 	}
 
-	/*
-	 * Lets see how things are looking
-	 */
-	spdlog::trace("FULL m_serverData     : {}", m_serverData.size());
-	spdlog::trace("m_serverDataList[{}] : {}", sessionid, getServerSessionCount(sessionid));
+	auto snapshot = getServerListSnapshot(sessionid);
 
 	/*
 	 * If we're empty or going out of bounds, just return the big bubkis
 	 */
-	if (getServerSessionCount(sessionid) == 0 || start_idx >= getServerSessionCount(sessionid)) {
+	if (!snapshot || start_idx >= snapshot->sessions.size()) {
 		return ss_slice;
 	}
 
-	for (ss_itr = m_serverListreq[sessionid].begin() + start_idx; ss_itr != m_serverListreq[sessionid].end(); ++ss_itr) {
-
-		/*
-		 * Early bail out
-		 */
-		if (ss_slice.size() >= max_items) {
-			spdlog::trace("ss_slice size({}) is greater than max_items ({})", ss_slice.size(), max_items);
-			break;
-		}
-		ss_slice.push_back(*ss_itr);
-		spdlog::trace("   I({}): {}", ss_slice.size(), *ss_itr);
-
-	}
+	auto end = std::min<size_t>(snapshot->sessions.size(), static_cast<size_t>(start_idx) + max_items);
+	ss_slice.insert(ss_slice.end(), snapshot->sessions.begin() + start_idx, snapshot->sessions.begin() + end);
 
 	spdlog::trace("   M: {}", ss_slice.size());
-	ss_slice.unique();
-	spdlog::trace("   N: {}", ss_slice.size());
 	return ss_slice;
 }
 
-/*
- * TODO: this is a copy of expireHandshakes ... refactor same as keyExists<T>(blah)
- */
 std::vector<std::string>
 DataObject::expireServerSessions(unsigned int expiry) {
 	std::vector<std::string> expiredSS;
-	expiredSS.clear();
-
-	boost::posix_time::ptime now = getNow();
-	boost::posix_time::ptime etime;
 
 	/*
 	 * Option 1: etime = 0.  The end time becomes now + 0, thus guaranteed expiry.
 	 * Option 2: etime = expiry(sec). End time becomes now + expiry.
 	 *           a) expiry>0 : all entries that are older that m_handshakeExpirySeconds are removed
 	 *           b) expiry<=0 : immediate expiry by making the etime less than now.
-	 */
-	for (auto itr = m_serverData.begin(); itr != m_serverData.end();) {
-		std::string key = itr->first;
-
-		spdlog::trace("  from_iso_string ({}: {}", key, getServerExpiryIso(key));
-		etime = boost::posix_time::from_iso_string(getServerExpiryIso(key)) +
-				boost::posix_time::seconds(expiry);
-
-		/**
-		 * We need to make a copy of the iterator if we modify the
-		 * underlying container because the iterator becomes invalid
-		 */
-		if (now > etime) {
-			auto itr_copy = itr;
-			++itr_copy;
-
+	 *
+	 * Only entries at the front of the expiry queue are visited, so the cost
+	 * is proportional to the number of sessions that actually expire.
+	 */
+	auto now = getNow();
+	for (auto& shard: m_serverShards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto currentTime = [&](const std::string& key) -> const boost::posix_time::ptime* {
+			auto I = shard.data.find(key);
+			return I != shard.data.end() ? &I->second.expiry : nullptr;
+		};
+		shard.expiryQueue.expire(now, expiry, currentTime, [&](const std::string& key) {
 			/*
-			 * This also remove listreq cache items as well as the default cache
+			 * Clients paging through a list containing the session keep their snapshot.
 			 */
-			removeServerSession(key);
-			itr = itr_copy;
+			shard.data.erase(key);
+			m_serverListDirty = true;
 			expiredSS.push_back(key);
-		} else {
-			/**
-			 * We are not modifying, just increment normally.
-			 */
-			++itr;
-		}
-
+		});
+		shard.expiryQueue.compact(shard.data.size(), currentTime);
 	}
+
 	return expiredSS;
 
 
@@ -395,46 +453,46 @@ std::list<std::string>
 DataObject::searchServerSessionByAttribute(const std::string& attr_name, const std::string& attr_val) {
 	std::list<std::string> matched;
 
-	matched.clear();
-
 	/*
 	 * Loop through all servers
 	 */
-	for (auto& vv: m_serverData) {
+	for (auto& shard: m_serverShards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for (auto& vv: shard.data) {
 
-		/*
-		 * Returns an empty string
-		 */
-		std::string vattr = getServerAttribute(vv.first, attr_name);
+			/*
+			 * Returns an empty string
+			 */
+			std::string vattr = getAttribute(vv.second.attributes, vv.second.expiry, attr_name);
 
-		/*
-		 * If the session has the attribute, and the value matches, push it on list
-		 */
-		if (boost::iequals(vattr, attr_val))
-			matched.push_back(vv.first);
+			/*
+			 * If the session has the attribute, and the value matches, push it on list
+			 */
+			if (boost::iequals(vattr, attr_val))
+				matched.push_back(vv.first);
 
+		}
 	}
 	return matched;
 }
 
 std::map<std::string, std::string>
 DataObject::getClientSession(const std::string& sessionid) {
-	if (keyExists<std::string>(m_clientData, sessionid))
-		return m_clientData[sessionid];
+	auto& shard = shardFor(m_clientShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto I = shard.data.find(sessionid);
+	if (I != shard.data.end()) {
+		auto session = I->second.attributes;
+		session["expiry"] = boost::posix_time::to_iso_string(I->second.expiry);
+		return session;
+	}
 
-	// @TODO: there has to be a way to do this without polluting the stack
-	std::map<std::string, std::string> empty;
-	empty.clear();
-	return empty;
+	return {};
 }
 
 std::vector<std::string>
 DataObject::expireClientSessions(unsigned int expiry) {
 	std::vector<std::string> expiredCS;
-	expiredCS.clear();
-
-	boost::posix_time::ptime now = getNow();
-	boost::posix_time::ptime etime;
 
 	/*
 	 * Option 1: etime = 0.  The end time becomes now + 0, thus guaranteed expiry.
@@ -442,41 +500,20 @@ DataObject::expireClientSessions(unsigned int expiry) {
 	 *           a) expiry>0 : all entries that are older that m_handshakeExpirySeconds are removed
 	 *           b) expiry<=0 : immediate expiry by making the etime less than now.
 	 */
-	std::map<std::string, std::map<std::string, std::string> >::iterator itr;
-	for (itr = m_clientData.begin(); itr != m_clientData.end();) {
-		std::string key = itr->first;
-		std::string et = itr->second["expiry"];
-
-		if (et.empty()) {
-			/*
-			 * arbitrary iso string for conversion
-			 */
-			et = "20000101T010000.000000";
-		}
-
-
-		spdlog::trace("  from_iso_string: {}", et);
-		etime = boost::posix_time::from_iso_string(et) +
-				boost::posix_time::seconds(expiry);
-
-		/**
-		 * We need to make a copy of the iterator if we modify the
-		 * underlying container because the iterator becomes invalid
-		 */
-		if (now > etime) {
-			auto itr_copy = itr;
-			++itr_copy;
-			removeClientSession(key);
-			itr = itr_copy;
+	auto now = getNow();
+	for (auto& shard: m_clientShards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto currentTime = [&](const std::string& key) -> const boost::posix_time::ptime* {
+			auto I = shard.data.find(key);
+			return I != shard.data.end() ? &I->second.expiry : nullptr;
+		};
+		shard.expiryQueue.expire(now, expiry, currentTime, [&](const std::string& key) {
+			shard.data.erase(key);
 			expiredCS.push_back(key);
-		} else {
-			/**
-			 * We are not modifying, just increment normally.
-			 */
-			++itr;
-		}
-
+		});
+		shard.expiryQueue.compact(shard.data.size(), currentTime);
 	}
+
 	return expiredCS;
 
 }
@@ -484,7 +521,6 @@ DataObject::expireClientSessions(unsigned int expiry) {
 std::vector<std::string>
 DataObject::expireClientSessionCache(unsigned int expiry) {
 	std::vector<std::string> expiredCSC;
-	expiredCSC.clear();
 	/*
 	 * Iterate over all the client caches, and if there is no corresponding
 	 * client session, remove the cache
@@ -492,28 +528,24 @@ DataObject::expireClientSessionCache(unsigned int expiry) {
 	boost::posix_time::ptime now = getNow();
 	boost::posix_time::ptime etime;
 
-	/*
-	 * Grab our list of expired cache items
-	 */
-	for (auto& f: m_listreqExpiry) {
-		spdlog::trace("  iterate m_listreqExpiry : {}={}", f.first, f.second);
-		etime = boost::posix_time::from_iso_string(f.second)
-				+ boost::posix_time::seconds(expiry);
-
-		spdlog::trace("  evaluate etime : {}", etime);
-		spdlog::trace("  evaluate   now : {}", now);
-		if (now > etime) {
-			spdlog::trace("  expire m_listreqExpiry : {}", f.first);
-			expiredCSC.push_back(f.first);
+	for (auto& shard: m_listreqShards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for (auto I = shard.data.begin(); I != shard.data.end();) {
+			etime = I->second.time + boost::posix_time::seconds(expiry);
+
+			spdlog::trace("  evaluate etime : {}", etime);
+			spdlog::trace("  evaluate   now : {}", now);
+			if (now > etime) {
+				spdlog::trace("  expire listreq cache : {}", I->first);
+				expiredCSC.push_back(I->first);
+				I = shard.data.erase(I);
+			} else {
+				++I;
+			}
 		}
 	}
 
-	spdlog::trace("  collected expiredCSC({})", expiredCSC.size());
-	for (auto& f: expiredCSC) {
-		spdlog::trace("  purge expired({})", f);
-		m_listreqExpiry.erase(f);
-		m_serverListreq.erase(f);
-	}
+	spdlog::trace("  purged expiredCSC({})", expiredCSC.size());
 	return expiredCSC;
 }
 
@@ -521,28 +553,26 @@ DataObject::expireClientSessionCache(unsigned int expiry) {
 uint32_t
 DataObject::addHandshake(unsigned int handshake) {
 
-	unsigned int ret = 0;
-
+	auto& shard = shardFor(m_handshakeShards, handshake);
+	std::lock_guard<std::mutex> lock(shard.mutex);
 	// set expiry in data structure, if it exists already it is updated
-	spdlog::trace("  from_iso_string: {}", getNowStr());
-	m_handshakeQueue[handshake]["expiry"] = getNowStr();
+	auto now = getNow();
+	shard.data[handshake] = now;
+	shard.expiryQueue.push(handshake, now);
 
-	// if we find said element again, return handshake, otherwise 0
-	if (m_handshakeQueue[handshake].find("expiry") != m_handshakeQueue[handshake].end()) {
-		ret = handshake;
-	}
-
-	return ret;
+	return handshake;
 
 }
 
 uint32_t
 DataObject::removeHandshake(unsigned int hs) {
+	auto& shard = shardFor(m_handshakeShards, hs);
+	std::lock_guard<std::mutex> lock(shard.mutex);
 	/*
 	 * There is technically nothing wrong with deleting an element that doesn't exist.
 	 * Thus the return code is semi-superfluous
 	 */
-	if (m_handshakeQueue.erase(hs) == 1) {
+	if (shard.data.erase(hs) == 1) {
 		return hs;
 	}
 	return 0;
@@ -550,7 +580,9 @@ DataObject::removeHandshake(unsigned int hs) {
 
 bool
 DataObject::handshakeExists(unsigned int hs) {
-	return keyExists<unsigned int>(m_handshakeQueue, hs);
+	auto& shard = shardFor(m_handshakeShards, hs);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	return shard.data.find(hs) != shard.data.end();
 }
 
 std::vector<unsigned int>
@@ -560,60 +592,36 @@ DataObject::expireHandshakes(unsigned int expiry) {
 	 */
 	std::vector<unsigned int> removedHS;
 
-	boost::posix_time::ptime now = getNow();
-	boost::posix_time::ptime etime;
-
 	/*
 	 * Option 1: etime = 0.  The end time becomes now + 0, thus guaranteed expiry.m_handshakeExpirySeconds
 	 * Option 2: etime = expiry(sec). End time becomes now + expiry.
 	 *           a) expiry>0 : all entries that are older that m_handshakeExpirySeconds are removed
 	 *           b) expiry<=0 : immediate expiry by making the etime less than now.
 	 */
-	std::map<unsigned int, std::map<std::string, std::string> >::iterator itr;
-	for (itr = m_handshakeQueue.begin(); itr != m_handshakeQueue.end();) {
-		unsigned int key = itr->first;
-		std::string et = itr->second["expiry"];
-
-		if (et.empty()) {
-			/*
-			 * arbitrary iso string for conversion
-			 */
-			et = "20000101T010000.000000";
-		}
-
-		spdlog::trace("  from_iso_string: {}", et);
-		etime = boost::posix_time::from_iso_string(et) +
-				boost::posix_time::seconds(expiry);
-
-		/**
-		 * We need to make a copy of the iterator if we modify the
-		 * underlying container because the iterator becomes invalid
-		 */
-		if (now > etime) {
-			auto itr_copy = itr;
-			++itr_copy;
-			removeHandshake(key);
-			itr = itr_copy;
+	auto now = getNow();
+	for (auto& shard: m_handshakeShards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto currentTime = [&](unsigned int key) -> const boost::posix_time::ptime* {
+			auto I = shard.data.find(key);
+			return I != shard.data.end() ? &I->second : nullptr;
+		};
+		shard.expiryQueue.expire(now, expiry, currentTime, [&](unsigned int key) {
+			shard.data.erase(key);
 			removedHS.push_back(key);
-		} else {
-			/**
-			 * We are not modifying, just increment normally.
-			 */
-			++itr;
-		}
-
+		});
+		shard.expiryQueue.compact(shard.data.size(), currentTime);
 	}
+
 	return removedHS;
 }
 
 boost::posix_time::ptime
 DataObject::getHandshakeExpiry(unsigned int hs) {
-	/*
-	 *
-	 */
-	if (handshakeExists(hs)) {
-		spdlog::trace("  from_iso_string: {}", m_handshakeQueue[hs]["expiry"]);
-		return boost::posix_time::from_iso_string(m_handshakeQueue[hs]["expiry"]);
+	auto& shard = shardFor(m_handshakeShards, hs);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto I = shard.data.find(hs);
+	if (I != shard.data.end()) {
+		return I->second;
 	} else {
 		/*
 		 * Handicap it if we can't find it ... 5000ms should be
@@ -625,7 +633,12 @@ DataObject::getHandshakeExpiry(unsigned int hs) {
 
 uint32_t
 DataObject::getHandshakeCount() {
-	return m_handshakeQueue.size();
+	uint32_t count = 0;
+	for (auto& shard: m_handshakeShards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		count += shard.data.size();
+	}
+	return count;
 }
 
 uint32_t
@@ -641,23 +654,29 @@ DataObject::getServerSessionCount(std::string s) {
 		/*
 		 * Called with the default argument
 		 */
-		spdlog::trace("  default m_serverData.size() count");
-		return m_serverData.size();
+		spdlog::trace("  default server session count");
+		uint32_t count = 0;
+		for (auto& shard: m_serverShards) {
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			count += shard.data.size();
+		}
+		return count;
 
 	} else {
 
-		if (m_serverListreq.find(s) != m_serverListreq.end()) {
+		auto snapshot = getServerListSnapshot(s);
+		if (snapshot) {
 			/*
-			 * We've got a custom list defined already, give a count
+			 * We've got a snapshot bound already, give a count
 			 */
-			spdlog::trace("  m_serverListreq[{}] found of size : {}", s, m_serverListreq[s].size());
-			return m_serverListreq[s].size();
+			spdlog::trace("  listreq cache [{}] found of size : {}", s, snapshot->sessions.size());
+			return snapshot->sessions.size();
 		}
 
 		/*
 		 * We have no custom list
 		 */
-		spdlog::trace("no m_serverListreq[{}] Found.  Return 0.", s);
+		spdlog::trace("no listreq cache [{}] Found.  Return 0.", s);
 		return 0;
 	}
 
@@ -665,7 +684,12 @@ DataObject::getServerSessionCount(std::string s) {
 
 uint32_t
 DataObject::getClientSessionCount() {
-	return m_clientData.size();
+	uint32_t count = 0;
+	for (auto& shard: m_clientShards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		count += shard.data.size();
+	}
+	return count;
 }
 
 boost::posix_time::ptime
@@ -692,127 +716,125 @@ DataObject::getLatency(boost::posix_time::ptime& t1, boost::posix_time::ptime& t
 
 uint32_t
 DataObject::createServerSessionListresp(std::string ip) {
-	std::list<std::string> ip_list;
-	std::vector<std::string> ip_vec;
+	spdlog::trace("createServerSessionListresp({})", ip);
 
-	/*
-	 * zero out list
-	 */
-	ip_list.clear();
-	ip_vec.clear();
+	return bindServerListSnapshot(ip)->sessions.size();
+}
+
+std::shared_ptr<const ServerListSnapshot>
+DataObject::bindServerListSnapshot(const std::string& ip) {
+	auto snapshot = getServerListSnapshot();
 
-	spdlog::trace("createServerSessionListresp({})", ip);
-	spdlog::trace("m_serverData({})", m_serverData.size());
 	/*
-	 * Check if cache exists ... if so erase it
+	 *  Bind the client to the snapshot; this is just a reference, no matter the size of the list.
 	 */
-	if (m_serverListreq.find(ip) != m_serverListreq.end()) {
-		spdlog::trace("  m_serverListreq[{}] exists, erasing", ip);
-		m_serverListreq.erase(ip);
-//		m_serverListreq[ip].clear();
-	}
+	auto& shard = shardFor(m_listreqShards, ip);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	shard.data[ip] = ListreqBinding{snapshot, getNow()};
+
+	return snapshot;
+}
 
+std::shared_ptr<const ServerListSnapshot>
+DataObject::getServerListSnapshot() {
+	std::lock_guard<std::mutex> listLock(m_serverListMutex);
 	/*
-	 * TODO: this is where we can apply custom per-client sorting and
-	 * filtering.  Perhaps maybe create a sort lambda ?
-	 */
-	for (auto& foo: m_serverData) {
-		spdlog::trace("    Temp Cache[{}] = {}", ip, foo.first);
-		ip_list.push_back(foo.first);
+	 * The flag is cleared before the sessions are read, so that any change made
+	 * while rebuilding marks the new snapshot as dirty.
+	 */
+	if (!m_serverListDirty.exchange(false) && m_serverListSnapshot) {
+		return m_serverListSnapshot;
+	}
+
+	auto snapshot = std::make_shared<ServerListSnapshot>();
+	snapshot->version = ++m_serverListVersion;
+
+	std::vector<std::pair<std::string, uint32_t>> servers;
+	for (auto& shard: m_serverShards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for (auto& entry: shard.data) {
+			auto& attributes = entry.second.attributes;
+			auto I = attributes.find("ip_int");
+			uint32_t address = 0;
+			if (I != attributes.end()) {
+				address = static_cast<uint32_t>(std::strtoul(I->second.c_str(), nullptr, 10));
+			}
+			servers.emplace_back(entry.first, address);
+		}
 	}
 
 	/*
-	 * Just put in the list to make preventing duplicates easier
+	 * Keep the list ordered, so that clients see a stable order between snapshots.
+	 * TODO: this is where we can apply custom per-client sorting and filtering.
 	 */
-	ip_list.unique();
+	std::sort(servers.begin(), servers.end());
 
-	for (auto& bar: ip_list) {
-		spdlog::trace("    Packing vector ({})", bar);
-		ip_vec.push_back(bar);
+	snapshot->sessions.reserve(servers.size());
+	snapshot->addresses.reserve(servers.size());
+	for (auto& server: servers) {
+		snapshot->sessions.push_back(server.first);
+		snapshot->addresses.push_back(server.second);
 	}
 
 	/*
-	 *  Place list into cache
-	 */
-	m_serverListreq[ip] = ip_vec;
-	m_listreqExpiry[ip] = getNowStr();
+	 * Serialize the LISTRESP pages.
+	 */
+	auto total = static_cast<uint32_t>(snapshot->addresses.size());
+	for (uint32_t start = 0; start < total; start += ServerListSnapshot::serversPerPage) {
+		auto count = std::min(ServerListSnapshot::serversPerPage, total - start);
+		MetaServerPacket packet;
+		packet.setPacketType(NMT_LISTRESP);
+		packet.addPacketData(total);
+		packet.addPacketData(count);
+		for (uint32_t i = start; i < start + count; ++i) {
+			packet.addPacketData(snapshot->addresses[i]);
+		}
+		snapshot->pages.push_back(ServerListSnapshot::Page{packet.getBuffer(), packet.getSize()});
+	}
 
-	return ip_vec.size();
+	spdlog::trace("Rebuilt server list snapshot version {} with {} servers", snapshot->version, total);
+
+	m_serverListSnapshot = std::move(snapshot);
+	return m_serverListSnapshot;
+}
+
+std::shared_ptr<const ServerListSnapshot>
+DataObject::getServerListSnapshot(const std::string& ip) {
+	auto& shard = shardFor(m_listreqShards, ip);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto I = shard.data.find(ip);
+	if (I != shard.data.end()) {
+		return I->second.snapshot;
+	}
+	return {};
 }
 
 std::list<std::string>
 DataObject::getServerSessionCacheList() {
 	std::list<std::string> slist;
-	slist.clear();
-	spdlog::trace("getServerSessionCacheList(): total={}", m_serverListreq.size());
-	for (auto& m: m_serverListreq) {
-		spdlog::trace("  cache-{}", m.first);
-		slist.push_back(m.first);
+	for (auto& shard: m_listreqShards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for (auto& m: shard.data) {
+			spdlog::trace("  cache-{}", m.first);
+			slist.push_back(m.first);
+		}
 	}
+	spdlog::trace("getServerSessionCacheList(): total={}", slist.size());
 	return slist;
 }
 
 std::string
 DataObject::getServerExpiryIso(std::string& sessionid) {
-
-	const std::string etdef = "20000101T010000.000000";
-	std::string et;
-	if (m_serverData.find(sessionid) == m_serverData.end()) {
+	auto& shard = shardFor(m_serverShards, sessionid);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto I = shard.data.find(sessionid);
+	if (I == shard.data.end()) {
 		/*
-		 * We don't have a session
-		 * Option 1: some list somewhere is iterating over the list and it's
-		 *           removed ... very bad
-		 * Option 2: expiry sub-map is empty ... which is not allowed
+		 * We don't have a session; some list somewhere is iterating over the list and it's
+		 * removed.
 		 */
 		spdlog::trace("session({}) does not exist for expiry request", sessionid);
-		et = getNowStr();
-	} else {
-		/*
-		 * found session, check expiry
-		 *
-		 */
-		if (m_serverData[sessionid].find("expiry") != m_serverData[sessionid].end()) {
-			et = m_serverData[sessionid]["expiry"];
-		} else {
-			spdlog::trace("session({}) does not contain expiry attribute", sessionid);
-			et = getNowStr();
-		}
-	}
-
-	/*
-	 * And just in case because we know for sure we can't have anything that
-	 * is empty
-	 */
-	if (et.empty()) {
-		spdlog::trace("session({}) expiry time empty, defaulting:{}", sessionid, etdef);
-		et = etdef;
-	}
-
-	/*
-	 * Since it's so important to get the time, we can do a from_iso_string and
-	 * if there is an issue here, there will definitely be an issue elsewhere,
-	 * thus we can override that.
-	 */
-	try {
-		boost::posix_time::from_iso_string(et);
-	}
-	catch (const boost::exception& bex) {
-		/*
-		 * Whoops, date is malformed, we want to reset, unless
-		 * the session is maybe on the way out in which case just
-		 * let it be as it will disappear itself
-		 */
-		spdlog::warn("expiry time for session({}) seems bad, resetting: {}", sessionid, etdef);
-		if (m_serverData.find(sessionid) != m_serverData.end()) {
-			/*
-			 * TODO: rethink this
-			 */
-			m_serverData[sessionid]["expiry"] = etdef;
-		}
-
+		return getNowStr();
 	}
-
-	return et;
+	return boost::posix_time::to_iso_string(I->second.expiry);
 }
-
-
@@ -25,18 +25,67 @@
 /*
  * Local Includes
  */
+#include "ExpiryQueue.hpp"
+#include "MetaServerPacket.hpp"
 
 /*
  * System Includes
  */
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <list>
 #include <vector>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/algorithm/string.hpp>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
+/**
+ * An immutable snapshot of the registered servers, shared by all clients
+ * paging through the list.
+ *
+ * The LISTRESP packets are serialized up front, one page per
+ * serversPerPage servers, so that answering a LISTREQ for a page boundary
+ * is just a copy of the prepared payload.
+ */
+struct ServerListSnapshot {
+	static constexpr uint32_t serversPerPage = (MAX_UDP_OUT_BYTES - 4 - 4 - 4) / sizeof(uint32_t);
+
+	struct Page {
+		std::array<char, MAX_PACKET_BYTES> payload;
+		std::size_t size;
+	};
+
+	/**
+	 * Increased each time the snapshot is rebuilt.
+	 */
+	uint64_t version;
+
+	/**
+	 * Session ids, in list order.
+	 */
+	std::vector<std::string> sessions;
+
+	/**
+	 * The "ip_int" of each session, in the same order as "sessions".
+	 */
+	std::vector<uint32_t> addresses;
+
+	std::vector<Page> pages;
+};
+
+/**
+ * The session store of the metaserver.
+ *
+ * All methods are safe to call from several threads at once. Each store is
+ * split into shards by key, each with its own lock, so that packets for
+ * different sessions can be processed in parallel by the UDP workers. Methods
+ * which visit all sessions, such as the expiry sweeps, lock one shard at a time.
+ */
 class DataObject {
 
 public:
@@ -114,47 +163,142 @@ public:
 
 	static unsigned int getLatency(boost::posix_time::ptime& t1, boost::posix_time::ptime& t2);
 
+	/**
+	 * Binds the client to the current server list snapshot, rebuilding it first if
+	 * servers have joined, left or changed since it was made.
+	 *
+	 * @param ip The client to bind.
+	 * @return The number of servers in the snapshot.
+	 */
 	uint32_t createServerSessionListresp(std::string ip = "default");
 
+	/**
+	 * Binds the client to the current server list snapshot, like createServerSessionListresp().
+	 *
+	 * @param ip The client to bind.
+	 * @return The snapshot the client was bound to. Unlike a later call to getServerListSnapshot(ip)
+	 * this can't be null, even if the binding has been expired by another thread in between.
+	 */
+	std::shared_ptr<const ServerListSnapshot> bindServerListSnapshot(const std::string& ip);
+
+	/**
+	 * @return The current server list snapshot, rebuilt if needed.
+	 */
+	std::shared_ptr<const ServerListSnapshot> getServerListSnapshot();
+
+	/**
+	 * @param ip The client.
+	 * @return The snapshot the client is paging through, or null if it has none.
+	 */
+	std::shared_ptr<const ServerListSnapshot> getServerListSnapshot(const std::string& ip);
+
 	std::list<std::string> getServerSessionCacheList();
 
 	std::string getServerExpiryIso(std::string& sessionid);
 
 private:
+
+	/**
+	 * Number of shards each store is split into.
+	 */
+	static constexpr std::size_t shardCount = 16;
+
+	/**
+	 * A part of a store, holding the entries whose keys hash to it.
+	 * All fields are guarded by the mutex.
+	 */
+	template<typename K, typename V>
+	struct Shard {
+		std::mutex mutex;
+		std::unordered_map<K, V> data;
+		/**
+		 * Expiry heap, allowing the sweeps to only visit entries which are actually due.
+		 */
+		ExpiryQueue<K> expiryQueue;
+	};
+
+	template<typename K, typename V>
+	using Shards = std::array<Shard<K, V>, shardCount>;
+
+	template<typename K, typename V>
+	static Shard<K, V>& shardFor(Shards<K, V>& shards, const K& key) {
+		return shards[std::hash<K>()(key) % shardCount];
+	}
+
 	/**
-	 *  Example Data Structure ( m_serverData )
-	 *  "192.168.1.200" => {
+	 * A registered server.
+	 *
+	 * Example attributes:
+	 *  	"ip" => "192.168.1.200",
 	 *  	"serverVersion" => "0.5.20",
 	 *  	"serverType" => "cyphesis",
 	 *  	"serverUsers" => "100",
-	 *  	"attribute1" => "value1",
-	 *  	"attribute2" => "value2",
 	 *  	"latency" => "200"
-	 *  }
 	 *
-	 *  m_serverDataList contains an ordered representation of
-	 *  m_serverData keys so that multiple LISTREQ requests can be
-	 *  done and avoid duplicate servers packet responses.
+	 * The "expiry" attribute is kept as a typed timestamp rather than as a string,
+	 * and is only rendered as an ISO string when requested.
 	 */
+	struct ServerSession {
+		std::map<std::string, std::string> attributes;
+		boost::posix_time::ptime expiry;
+	};
 
-	template<class T>
-	bool keyExists(std::map<T, std::map<std::string, std::string> >& mapRef, T key) {
-		if (mapRef.find(key) != mapRef.end()) {
-			return true;
-		}
+	/**
+	 * A client session, along with any filters the client has registered.
+	 */
+	struct ClientSession {
+		std::map<std::string, std::string> attributes;
+		std::map<std::string, std::string> filters;
+		boost::posix_time::ptime expiry;
+	};
 
-		return false;
-	}
+	/**
+	 * A client bound to the server list snapshot it's paging through, so that
+	 * multiple LISTREQ requests can be done and avoid duplicate servers packet
+	 * responses even if the list changes in between.
+	 */
+	struct ListreqBinding {
+		std::shared_ptr<const ServerListSnapshot> snapshot;
+		boost::posix_time::ptime time;
+	};
+
+	using ServerShard = Shard<std::string, ServerSession>;
+	using ClientShard = Shard<std::string, ClientSession>;
+
+	/*
+	 * These expect the lock of the shard to be held.
+	 */
+	ServerSession& touchServerSession(ServerShard& shard, const std::string& sessionid);
+
+	ClientSession& touchClientSession(ClientShard& shard, const std::string& sessionid);
+
+	static void setServerExpiry(ServerShard& shard, const std::string& sessionid, ServerSession& session, boost::posix_time::ptime expiry);
+
+	static void setClientExpiry(ClientShard& shard, const std::string& sessionid, ClientSession& session, boost::posix_time::ptime expiry);
 
-	std::map<std::string, std::map<std::string, std::string> > m_serverData;
-	std::map<std::string, std::vector<std::string> > m_serverListreq;
-	std::map<std::string, std::string> m_listreqExpiry;
+	static std::string getAttribute(const std::map<std::string, std::string>& attributes, boost::posix_time::ptime expiry, const std::string& key);
 
-	std::map<std::string, std::map<std::string, std::string> > m_clientData;
-	std::map<std::string, std::map<std::string, std::string> > m_clientFilterData;
+	static boost::posix_time::ptime parseExpiry(const std::string& value);
 
-	std::map<unsigned int, std::map<std::string, std::string> > m_handshakeQueue;
+	Shards<std::string, ServerSession> m_serverShards;
 
+	Shards<std::string, ClientSession> m_clientShards;
+
+	Shards<unsigned int, boost::posix_time::ptime> m_handshakeShards;
+
+	/**
+	 * Keyed by client. These aren't in the expiry heaps, as the cache sweep visits all of them.
+	 */
+	Shards<std::string, ListreqBinding> m_listreqShards;
+
+	/**
+	 * Guards the latest snapshot, which is rebuilt on demand when m_serverListDirty is set.
+	 * It's never locked while holding the lock of a shard.
+	 */
+	std::mutex m_serverListMutex;
+	std::shared_ptr<const ServerListSnapshot> m_serverListSnapshot;
+	uint64_t m_serverListVersion = 0;
+	std::atomic<bool> m_serverListDirty{true};
 
 };
 
@@ -0,0 +1,118 @@
+/**
+ Worldforge Next Generation MetaServer
+
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+ */
+
+#ifndef EXPIRYQUEUE_HPP_
+#define EXPIRYQUEUE_HPP_
+
+/*
+ * System Includes
+ */
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+/**
+ * A min-heap of (timestamp, key) pairs used to find the sessions that are due
+ * for expiry without visiting every session.
+ *
+ * Refreshing a session does not touch the heap entry already present; instead
+ * a new entry is pushed and the old one becomes stale. Stale entries are
+ * recognised when popped by comparing against the owner's current timestamp,
+ * which keeps both refresh and sweep cheap. The heap is compacted when stale
+ * entries start to dominate.
+ */
+template<typename K>
+class ExpiryQueue {
+public:
+
+	struct Entry {
+		boost::posix_time::ptime time;
+		K key;
+
+		bool operator>(const Entry& rhs) const {
+			return time > rhs.time;
+		}
+	};
+
+	void push(const K& key, boost::posix_time::ptime time) {
+		m_heap.push_back(Entry{time, key});
+		std::push_heap(m_heap.begin(), m_heap.end(), std::greater<Entry>());
+	}
+
+	/**
+	 * Pops all entries whose timestamp plus the expiry is before "now".
+	 *
+	 * @param now The current time.
+	 * @param expiry Number of seconds an entry is allowed to live.
+	 * @param currentTime Callable returning a pointer to the current timestamp of the key, or null if the key no longer exists.
+	 * @param onExpired Called with each key that is live and expired.
+	 */
+	template<typename CurrentTimeFn, typename ExpiredFn>
+	void expire(boost::posix_time::ptime now, unsigned int expiry, CurrentTimeFn&& currentTime, ExpiredFn&& onExpired) {
+		auto expirySeconds = boost::posix_time::seconds(expiry);
+		while (!m_heap.empty() && now > m_heap.front().time + expirySeconds) {
+			std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<Entry>());
+			Entry entry = std::move(m_heap.back());
+			m_heap.pop_back();
+
+			/*
+			 * Only act if this entry reflects the latest refresh of a key that still exists.
+			 */
+			const boost::posix_time::ptime* current = currentTime(entry.key);
+			if (current && *current == entry.time) {
+				onExpired(entry.key);
+			}
+		}
+	}
+
+	/**
+	 * Rebuilds the heap from the live entries if stale entries outnumber them.
+	 *
+	 * @param liveCount Number of live keys.
+	 * @param currentTime Same semantics as for expire().
+	 */
+	template<typename CurrentTimeFn>
+	void compact(size_t liveCount, CurrentTimeFn&& currentTime) {
+		if (m_heap.size() <= (liveCount * 2) + 64) {
+			return;
+		}
+		auto I = std::remove_if(m_heap.begin(), m_heap.end(), [&](const Entry& entry) {
+			const boost::posix_time::ptime* current = currentTime(entry.key);
+			return !current || *current != entry.time;
+		});
+		m_heap.erase(I, m_heap.end());
+		std::make_heap(m_heap.begin(), m_heap.end(), std::greater<Entry>());
+	}
+
+	size_t size() const {
+		return m_heap.size();
+	}
+
+	void clear() {
+		m_heap.clear();
+	}
+
+private:
+	std::vector<Entry> m_heap;
+};
+
+#endif /* EXPIRYQUEUE_HPP_ */
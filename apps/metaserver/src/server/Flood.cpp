@@ -0,0 +1,70 @@
+/**
+ Worldforge Next Generation MetaServer
+
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+ */
+
+#include "Flood.hpp"
+#include "MetaServerPacket.hpp"
+#include <boost/asio/io_context.hpp>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <array>
+#include <chrono>
+
+void flood(const boost::asio::ip::udp::endpoint& target, int packets, FloodResult& result) {
+	boost::asio::io_context io_service;
+	std::array<char, MAX_PACKET_BYTES> recvBuffer{};
+	boost::asio::ip::udp::endpoint sender_endpoint;
+
+	boost::asio::ip::udp::socket s(io_service, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0));
+
+	/*
+	 * Don't wait forever on dropped packets.
+	 */
+	timeval timeout{};
+	timeout.tv_usec = 500000;
+	setsockopt(s.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	result.latencies.reserve(packets);
+
+	for (int i = 0; i < packets; ++i) {
+		MetaServerPacket req;
+		/*
+		 * Alternate between keepalives (answered with a handshake) and list requests.
+		 */
+		if (i % 2 == 0) {
+			req.setPacketType(NMT_CLIENTKEEPALIVE);
+		} else {
+			req.setPacketType(NMT_LISTREQ);
+			req.addPacketData(0);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		s.send_to(boost::asio::buffer(req.getBuffer(), req.getSize()), target);
+
+		boost::system::error_code ec;
+		s.receive_from(boost::asio::buffer(recvBuffer), sender_endpoint, 0, ec);
+		if (ec) {
+			result.timeouts++;
+			continue;
+		}
+		result.latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+}
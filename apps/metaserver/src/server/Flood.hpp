@@ -0,0 +1,52 @@
+/**
+ Worldforge Next Generation MetaServer
+
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+ */
+
+#ifndef FLOOD_HPP_
+#define FLOOD_HPP_
+
+/*
+ * System Includes
+ */
+#include <boost/asio/ip/udp.hpp>
+
+#include <vector>
+
+struct FloodResult {
+	/**
+	 * Response times in microseconds, one for each answered packet.
+	 */
+	std::vector<long> latencies;
+	unsigned long timeouts = 0;
+};
+
+/**
+ * Sends client keepalives and list requests to a metaserver, alternating between
+ * the two, and waits for the response to each before sending the next one.
+ *
+ * Used by the flood client, and by the tests of the UDP workers.
+ *
+ * @param target The metaserver.
+ * @param packets The number of packets to send.
+ * @param result Filled in with the response times and the number of packets which weren't answered.
+ */
+void flood(const boost::asio::ip::udp::endpoint& target, int packets, FloodResult& result);
+
+#endif /* FLOOD_HPP_ */
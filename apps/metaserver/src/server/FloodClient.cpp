@@ -0,0 +1,121 @@
+/**
+ Worldforge Next Generation MetaServer
+
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+ */
+
+/**
+ * Floods a metaserver with client keepalives and list requests from a number of
+ * threads, each simulating a client, and reports packets per second along with
+ * response time percentiles. Used to measure how the metaserver copes with a
+ * client launch surge.
+ */
+
+#include "Flood.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv) {
+
+	boost::program_options::options_description desc("FloodClient");
+	boost::program_options::variables_map vm;
+
+	desc.add_options()
+			("help,h", "Display help message")
+			("server", boost::program_options::value<std::string>()->default_value("localhost"), "MetaServer host. \nDefault:localhost")
+			("port", boost::program_options::value<int>()->default_value(8453), "MetaServer port. \nDefault:8453")
+			("clients", boost::program_options::value<int>()->default_value(16), "Number of concurrent clients, each on its own thread. \nDefault:16")
+			("packets", boost::program_options::value<int>()->default_value(10000), "Number of packets sent per client. \nDefault:10000");
+
+	try {
+		boost::program_options::store(
+				boost::program_options::parse_command_line(argc, argv, desc),
+				vm
+		);
+		boost::program_options::notify(vm);
+
+		if (vm.count("help")) {
+			std::cout << desc << std::endl;
+			return 0;
+		}
+
+		auto clients = vm["clients"].as<int>();
+		auto packets = vm["packets"].as<int>();
+
+		std::cout << "Server       : " << vm["server"].as<std::string>() << std::endl;
+		std::cout << "Port         : " << vm["port"].as<int>() << std::endl;
+		std::cout << "Clients      : " << clients << std::endl;
+		std::cout << "Packets      : " << packets << std::endl;
+		std::cout << "---------------" << std::endl;
+
+		boost::asio::io_context io_service;
+		boost::asio::ip::udp::resolver resolver(io_service);
+		auto resolver_result = resolver.resolve(boost::asio::ip::udp::v4(), vm["server"].as<std::string>(), std::to_string(vm["port"].as<int>()));
+		if (resolver_result.empty()) {
+			std::cerr << "Could not resolve server." << std::endl;
+			return 1;
+		}
+		auto target = resolver_result.begin()->endpoint();
+
+		std::vector<FloodResult> results(clients);
+		std::vector<std::thread> threads;
+
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < clients; ++i) {
+			threads.emplace_back([&, i]() { flood(target, packets, results[i]); });
+		}
+		for (auto& thread: threads) {
+			thread.join();
+		}
+		auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::vector<long> latencies;
+		unsigned long timeouts = 0;
+		for (auto& result: results) {
+			latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+			timeouts += result.timeouts;
+		}
+		std::sort(latencies.begin(), latencies.end());
+
+		auto percentile = [&](double p) -> long {
+			if (latencies.empty()) {
+				return 0;
+			}
+			return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * static_cast<double>(latencies.size())))];
+		};
+
+		std::cout << "Responses    : " << latencies.size() << std::endl;
+		std::cout << "Timeouts     : " << timeouts << std::endl;
+		std::cout << "Packets/sec  : " << static_cast<long>(static_cast<double>(latencies.size()) / elapsed) << std::endl;
+		std::cout << "p50 (us)     : " << percentile(0.50) << std::endl;
+		std::cout << "p99 (us)     : " << percentile(0.99) << std::endl;
+		std::cout << "max (us)     : " << (latencies.empty() ? 0 : latencies.back()) << std::endl;
+	}
+	catch (std::exception& e) {
+		std::cerr << "Exception: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
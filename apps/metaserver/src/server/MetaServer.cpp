@@ -218,34 +218,45 @@ MetaServer::update_timer(const boost::system::error_code&) {
 	 *  the different integer types.  Almost everything via stringstream can
 	 *  convert to/from a number
 	 */
+	std::map<std::string, std::string> stats;
 	std::ostringstream ss;
 
 	ss.str("");
-	ss << m_PacketSequence;
-	m_metaStats["packet.sequence"] = ss.str();
+	{
+		std::lock_guard<std::mutex> lock(m_sequenceMutex);
+		ss << m_PacketSequence;
+	}
+	stats["packet.sequence"] = ss.str();
 
 	ss.str("");
 	ss << msdo.getServerSessionCount();
-	m_metaStats["server.sessions"] = ss.str();
+	stats["server.sessions"] = ss.str();
 
 	ss.str("");
 	ss << msdo.getClientSessionCount();
-	m_metaStats["client.sessions"] = ss.str();
+	stats["client.sessions"] = ss.str();
 
 	ss.str("");
 	ss << msdo.getHandshakeCount();
-	m_metaStats["current.handshakes"] = ss.str();
+	stats["current.handshakes"] = ss.str();
 
 	ss.str("");
 	ss << msdo.getServerSessionCacheList().size();
-	m_metaStats["client.cache"] = ss.str();
+	stats["client.cache"] = ss.str();
 
 	/*
 	 * Calculate uptime
 	 */
 	ss.str("");
 	ss << getDeltaMillis();
-	m_metaStats["server.uptime"] = ss.str();
+	stats["server.uptime"] = ss.str();
+
+	{
+		std::lock_guard<std::mutex> lock(m_statsMutex);
+		for (auto& entry: stats) {
+			m_metaStats[entry.first] = entry.second;
+		}
+	}
 
 	/*
 	 * Reset Timer
@@ -444,12 +455,13 @@ MetaServer::score_timer(const boost::system::error_code&) {
 }
 
 /**
- * Convenience method that evaluates what type of packet and call appropriate handle method
- * @param msp incoming metaserver packet
- * @param rsp outgoing metaserver packet to be filled
+ * Stamps a packet with the next sequence number and its time offset from the first packet.
+ * May be called from several handler threads at once.
+ * @param packet incoming metaserver packet
  */
 void
-MetaServer::processMetaserverPacket(MetaServerPacket& msp, MetaServerPacket& rsp) {
+MetaServer::sequencePacket(MetaServerPacket& packet) {
+	std::lock_guard<std::mutex> lock(m_sequenceMutex);
 
 	/*
 	 * Packet Sequence: store this so that we can replay the packets in the
@@ -463,8 +475,25 @@ MetaServer::processMetaserverPacket(MetaServerPacket& msp, MetaServerPacket& rsp
 		m_startTime = boost::posix_time::microsec_clock::local_time();
 
 	++m_PacketSequence;
-	msp.setSequence(m_PacketSequence);
-	msp.setTimeOffset(getDeltaMillis());
+	packet.setSequence(m_PacketSequence);
+	packet.setTimeOffset((DataObject::getNow() - m_startTime).total_milliseconds());
+}
+
+uint32_t
+MetaServer::newHandshake() {
+	std::lock_guard<std::mutex> lock(m_randomMutex);
+	return mRandomEngine();
+}
+
+/**
+ * Convenience method that evaluates what type of packet and call appropriate handle method
+ * @param msp incoming metaserver packet
+ * @param rsp outgoing metaserver packet to be filled
+ */
+void
+MetaServer::processMetaserverPacket(MetaServerPacket& msp, MetaServerPacket& rsp) {
+
+	sequencePacket(msp);
 
 	switch (msp.getPacketType()) {
 		case NMT_SERVERKEEPALIVE:
@@ -509,9 +538,7 @@ MetaServer::processMetaserverPacket(MetaServerPacket& msp, MetaServerPacket& rsp
 	/*
 	 * Flag response packets sequence and offset tagging
 	 */
-	++m_PacketSequence;
-	rsp.setSequence(m_PacketSequence);
-	rsp.setTimeOffset(getDeltaMillis());
+	sequencePacket(rsp);
 	rsp.setOutBound(true);
 
 	/*
@@ -534,7 +561,7 @@ MetaServer::processMetaserverPacket(MetaServerPacket& msp, MetaServerPacket& rsp
 void
 MetaServer::processSERVERKEEPALIVE(const MetaServerPacket& in, MetaServerPacket& out) {
 
-	uint32_t i = msdo.addHandshake(mRandomEngine());
+	uint32_t i = msdo.addHandshake(newHandshake());
 
 	if (i > 0) {
 		spdlog::trace("processSERVERKEEPALIVE(): {}", i);
@@ -655,7 +682,7 @@ MetaServer::processTERMINATE(const MetaServerPacket& in, MetaServerPacket&) {
 void
 MetaServer::processCLIENTKEEPALIVE(const MetaServerPacket& in, MetaServerPacket& out) {
 
-	uint32_t i = msdo.addHandshake(mRandomEngine());
+	uint32_t i = msdo.addHandshake(newHandshake());
 
 	if (i > 0) {
 		spdlog::trace("processCLIENTKEEPALIVE(){}", i);
@@ -700,97 +727,55 @@ MetaServer::processCLIENTSHAKE(const MetaServerPacket& in, MetaServerPacket&) {
 void
 MetaServer::processLISTREQ(const MetaServerPacket& in, MetaServerPacket& out) {
 	uint32_t server_index = in.getIntData(4);
-	uint32_t packed = 0;
-	uint32_t temp_int = 0;
-	std::list<uint32_t> resp_list;
 	std::string ip_str = in.getAddressStr();
-	uint32_t total = msdo.getServerSessionCount(ip_str);
-	uint32_t packed_max = total;
-
 
 	/*
-	 * Trigger the creation of a listreq cache creation
+	 * An initial request binds the client to the latest server list snapshot.
+	 * Following requests page through that same snapshot, even if servers
+	 * have come and gone since, so there are neither gaps nor duplicates.
 	 */
-	if (server_index == 0) {
-		spdlog::trace("Initial LISTREQ Request, creating lookup cache ({})", ip_str);
-		total = msdo.createServerSessionListresp(ip_str);
-		spdlog::trace("  Total: {}", total);
-		packed_max = total;
+	auto snapshot = msdo.getServerListSnapshot(ip_str);
+	if (server_index == 0 || !snapshot) {
+		spdlog::trace("Initial LISTREQ Request, binding server list snapshot ({})", ip_str);
+		snapshot = msdo.bindServerListSnapshot(ip_str);
 	}
 
-	/*
-	 * If we are unable to pack the entire list into 1 packet
-	 */
-	if ((total * sizeof(uint32_t) - (server_index * sizeof(uint32_t))) > (MAX_UDP_OUT_BYTES - 4 - 4 - 4)) {
-		/*
-		 * We want it to round ... just like the price is right, the goal is not to go over
-		 */
-		packed_max = (MAX_UDP_OUT_BYTES - 4 - 4 - 4) / sizeof(uint32_t);
-	}
+	auto total = static_cast<uint32_t>(snapshot->addresses.size());
 
+	spdlog::trace("server_index:{} ** total: {} ** snapshot: {}", server_index, total, snapshot->version);
 
-	/*
-	 * We hide the craziness of what goes on here inside the single method.
-	 * The goal, is to get the list of servers constrained by packed_max
-	 */
-	std::list<std::string> sess_list = msdo.getServerSessionList(server_index, packed_max, ip_str);
-	std::list<std::string>::iterator list_itr;
-
-	spdlog::trace("server_index:{} ** total: {} ** packed_max: {} ** sess_list: {}", server_index, total, packed_max, sess_list.size());
-
-	for (list_itr = sess_list.begin(); list_itr != sess_list.end(); list_itr++) {
-		/*
-		 * Defensive to make sure we're not going to exceed our max
-		 */
-		if (packed >= packed_max)
-			break;
+	out.setAddress(in.getAddress(), in.getAddressInt());
 
+	if (server_index < total && server_index % ServerListSnapshot::serversPerPage == 0) {
 		/*
-		 * Defensive to make sure that the item in the list is
-		 * actually a valid data item we can send ( orthogonal processes
-		 * such as expiry could invalidate at any time ).
-		 *
-		 * Thus we can iterate over as much of the server list as we need to
-		 * and dead items won't count, only those added to the response packet.
+		 * The common case; the client is asking for one of the prepared pages.
 		 */
-		if (msdo.serverSessionExists(*list_itr)) {
-			/*
-			 * Pack the int IP
-			 */
-			std::istringstream(msdo.getServerSession(*list_itr)["ip_int"]) >> temp_int;
-
-			spdlog::trace("Packing Session Itr[{}] Session Int[{}] Session IP[{}] SS Int[{}]",
-						  *list_itr, msdo.getServerSession(*list_itr)["ip_int"], msdo.getServerSession(*list_itr)["ip"], temp_int);
-			resp_list.push_back(temp_int);
-
-			//resp_list.push_back( atoi( msdo.getServerSession(*list_itr)["ip_int"].c_str() ) );
-			++packed;
-		}
-
-	}
-
-	if (packed != resp_list.size()) {
-		spdlog::warn("Packed: {} vs Response: {}MISMATCH!", packed, resp_list.size());
+		auto& page = snapshot->pages[server_index / ServerListSnapshot::serversPerPage];
+		auto payload = page.payload;
+		out.setBuffer(payload, page.size);
+		out.parsePacketType();
+		return;
 	}
 
-	out.setAddress(in.getAddress(), in.getAddressInt());
 	out.setPacketType(NMT_LISTRESP);
 
-	/**
-	 * If the list is empty, just send a 0,0 to indicate completion.
-	 * NOTE: I think this logic is a bug in the protocol, as the
-	 * 		original MS code looks as if this was just not working correctly.
-	 */
-	if (!resp_list.empty()) {
-		out.addPacketData(msdo.getServerSessionCount());
-		out.addPacketData((uint32_t) resp_list.size());
-		while (!resp_list.empty()) {
-			spdlog::trace("processLISTRESP() - Adding : {}", resp_list.front());
-			out.addPacketData(resp_list.front());
-			resp_list.pop_front();
+	if (server_index < total) {
+		/*
+		 * The client is paging with an unusual offset, so pack from the snapshot directly.
+		 */
+		auto count = std::min(ServerListSnapshot::serversPerPage, total - server_index);
+		out.addPacketData(total);
+		out.addPacketData(count);
+		for (uint32_t i = server_index; i < server_index + count; ++i) {
+			spdlog::trace("processLISTRESP() - Adding : {}", snapshot->addresses[i]);
+			out.addPacketData(snapshot->addresses[i]);
 		}
 	} else {
-		/*
+		/**
+		 * If the list is empty, just send a 0,0 to indicate completion.
+		 * NOTE: I think this logic is a bug in the protocol, as the
+		 * 		original MS code looks as if this was just not working correctly.
+		 *
 		 *  For the record, I think this is a stupid protocol construct
 		 */
 		spdlog::trace("processLISTRESP(0,0) - Empty");
@@ -1357,6 +1342,7 @@ MetaServer::initTimers(boost::asio::io_context& ios) {
 unsigned long long
 MetaServer::getDeltaMillis() {
 	boost::posix_time::ptime ntime = DataObject::getNow();
+	std::lock_guard<std::mutex> lock(m_sequenceMutex);
 	boost::posix_time::time_duration dur = ntime - m_startTime;
 	return dur.total_milliseconds();
 }
@@ -1368,6 +1354,7 @@ MetaServer::isDaemon() const {
 
 void
 MetaServer::getMSStats(std::map<std::string, std::string>& req_stats) {
+	std::lock_guard<std::mutex> lock(m_statsMutex);
 	if (req_stats.empty()) {
 		/*
 		 * If you've specified nothing, you get everything
@@ -40,6 +40,7 @@
 
 #include <set>
 #include <random>
+#include <mutex>
 
 
 /*
@@ -143,6 +144,34 @@ private:
 	unsigned int m_serverClientCacheExpirySeconds;
 	std::default_random_engine mRandomEngine;
 
+	/*
+	 * Packets can be processed from several UDP worker threads at once while the
+	 * timers run on the io_context. The session store does its own locking per
+	 * session; these only guard the little state which is shared by all packets.
+	 */
+
+	/**
+	 * Guards m_PacketSequence and m_startTime.
+	 */
+	std::mutex m_sequenceMutex;
+
+	/**
+	 * Guards m_metaStats.
+	 */
+	std::mutex m_statsMutex;
+
+	/**
+	 * Guards mRandomEngine.
+	 */
+	std::mutex m_randomMutex;
+
+	/**
+	 * Tags the packet with the next sequence number and the time offset.
+	 */
+	void sequencePacket(MetaServerPacket& packet);
+
+	uint32_t newHandshake();
+
 };
 
 #endif
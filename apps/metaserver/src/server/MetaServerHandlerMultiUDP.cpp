@@ -0,0 +1,222 @@
+/**
+ Worldforge Next Generation MetaServer
+
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+ */
+
+/*
+ * Local Includes
+ */
+#include "MetaServerHandlerMultiUDP.hpp"
+#include "MetaServerPacket.hpp"
+#include "MetaServer.hpp"
+
+/*
+ * System Includes
+ */
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+
+namespace {
+/**
+ * How long a worker waits for traffic before checking if it should stop.
+ */
+const int pollTimeoutMilliseconds = 200;
+}
+
+MetaServerHandlerMultiUDP::MetaServerHandlerMultiUDP(MetaServer& ms,
+													 const std::string& address,
+													 unsigned int port,
+													 unsigned int workers,
+													 unsigned int batchSize)
+		: m_Address(address),
+		  m_Port(port),
+		  m_batchSize(batchSize == 0 ? 1 : batchSize),
+		  m_msRef(ms),
+		  m_isStopped(false) {
+
+	sockaddr_in bindAddress{};
+	bindAddress.sin_family = AF_INET;
+	bindAddress.sin_port = htons(static_cast<uint16_t>(port));
+	if (inet_pton(AF_INET, address.c_str(), &bindAddress.sin_addr) != 1) {
+		throw std::runtime_error("Invalid bind address for UDP workers: " + address);
+	}
+
+	/*
+	 * Create all sockets up front, so that a failure is reported before any thread is started.
+	 */
+	for (unsigned int i = 0; i < workers; ++i) {
+		int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+		if (fd < 0) {
+			stop();
+			throw std::runtime_error(std::string("Could not create UDP socket: ") + std::strerror(errno));
+		}
+		m_Sockets.push_back(fd);
+
+		int enable = 1;
+		if (::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) != 0 ||
+			::bind(fd, reinterpret_cast<sockaddr*>(&bindAddress), sizeof(bindAddress)) != 0) {
+			auto error = std::string(std::strerror(errno));
+			stop();
+			throw std::runtime_error("Could not bind UDP socket with SO_REUSEPORT: " + error);
+		}
+	}
+
+	for (auto fd: m_Sockets) {
+		m_Workers.emplace_back([this, fd]() { this->run_worker(fd); });
+	}
+
+	spdlog::info("MetaServerHandlerMultiUDP() Startup : {},{} with {} workers", m_Address, m_Port, workers);
+}
+
+MetaServerHandlerMultiUDP::~MetaServerHandlerMultiUDP() {
+	stop();
+	spdlog::trace("MetaServerHandlerMultiUDP() Shutdown : {},{}", m_Address, m_Port);
+}
+
+void
+MetaServerHandlerMultiUDP::stop() {
+	m_isStopped = true;
+	for (auto& worker: m_Workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+	m_Workers.clear();
+	for (auto fd: m_Sockets) {
+		::close(fd);
+	}
+	m_Sockets.clear();
+}
+
+void
+MetaServerHandlerMultiUDP::run_worker(int socket) {
+
+	/*
+	 * Per worker buffers; the kernel fills the inbound ones directly.
+	 */
+	std::vector<std::array<char, MAX_PACKET_BYTES>> recvBuffers(m_batchSize);
+	std::vector<std::array<char, MAX_PACKET_BYTES>> sendBuffers(m_batchSize);
+	std::vector<sockaddr_in> recvAddresses(m_batchSize);
+	std::vector<sockaddr_in> sendAddresses(m_batchSize);
+	std::vector<iovec> recvVecs(m_batchSize);
+	std::vector<iovec> sendVecs(m_batchSize);
+	std::vector<mmsghdr> recvMessages(m_batchSize);
+	std::vector<mmsghdr> sendMessages(m_batchSize);
+
+	for (unsigned int i = 0; i < m_batchSize; ++i) {
+		recvVecs[i].iov_base = recvBuffers[i].data();
+		recvVecs[i].iov_len = recvBuffers[i].size();
+		recvMessages[i].msg_hdr.msg_iov = &recvVecs[i];
+		recvMessages[i].msg_hdr.msg_iovlen = 1;
+		sendMessages[i].msg_hdr.msg_iov = &sendVecs[i];
+		sendMessages[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	pollfd pfd{};
+	pfd.fd = socket;
+	pfd.events = POLLIN;
+
+	while (!m_isStopped) {
+
+		int ready = ::poll(&pfd, 1, pollTimeoutMilliseconds);
+		if (ready <= 0) {
+			if (ready < 0 && errno != EINTR) {
+				spdlog::error("UDP worker poll failed: {}", std::strerror(errno));
+			}
+			continue;
+		}
+
+		/*
+		 * The address fields are in/out, so they must be reset before every call.
+		 */
+		for (unsigned int i = 0; i < m_batchSize; ++i) {
+			recvMessages[i].msg_hdr.msg_name = &recvAddresses[i];
+			recvMessages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		}
+
+		int received = ::recvmmsg(socket, recvMessages.data(), m_batchSize, MSG_DONTWAIT, nullptr);
+		if (received <= 0) {
+			if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				spdlog::warn("ERROR:{}", std::strerror(errno));
+			}
+			continue;
+		}
+
+		unsigned int responses = 0;
+		for (int i = 0; i < received; ++i) {
+			try {
+				const auto& remote = recvAddresses[i];
+
+				/**
+				 *  Create a MSP from the incoming buffer and add in some useful information
+				 */
+				MetaServerPacket msp(recvBuffers[i], recvMessages[i].msg_len);
+
+				std::array<char, INET_ADDRSTRLEN> addressChars{};
+				inet_ntop(AF_INET, &remote.sin_addr, addressChars.data(), INET_ADDRSTRLEN);
+				msp.setAddress(addressChars.data(), ntohl(remote.sin_addr.s_addr));
+				msp.setPort(ntohs(remote.sin_port));
+
+				spdlog::trace("UDP: Incoming Packet [{}][{}][{}]", msp.getAddress(), NMT_PRETTY[msp.getPacketType()], recvMessages[i].msg_len);
+
+				MetaServerPacket rsp;
+				m_msRef.processMetaserverPacket(msp, rsp);
+
+				if (rsp.getSize() > 0 && rsp.getPacketType() != NMT_NULL) {
+					spdlog::trace("UDP: Outgoing Packet [{}][{}][{}]", rsp.getAddress(), NMT_PRETTY[rsp.getPacketType()], rsp.getSize());
+					sendBuffers[responses] = rsp.getBuffer();
+					sendAddresses[responses] = remote;
+					sendVecs[responses].iov_base = sendBuffers[responses].data();
+					sendVecs[responses].iov_len = rsp.getSize();
+					sendMessages[responses].msg_hdr.msg_name = &sendAddresses[responses];
+					sendMessages[responses].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+					++responses;
+				}
+			} catch (const std::exception& ex) {
+				/*
+				 * A malformed packet shouldn't take the rest of the batch with it.
+				 */
+				spdlog::error("MetaServerHandlerMultiUDP Exception: {}", ex.what());
+			}
+		}
+
+		/*
+		 * sendmmsg may send fewer messages than requested, in which case we continue from there.
+		 */
+		unsigned int sent = 0;
+		while (sent < responses) {
+			int result = ::sendmmsg(socket, sendMessages.data() + sent, responses - sent, 0);
+			if (result < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				spdlog::error("Error when trying to send: {}", std::strerror(errno));
+				break;
+			}
+			sent += static_cast<unsigned int>(result);
+		}
+	}
+}
@@ -0,0 +1,84 @@
+/**
+ Worldforge Next Generation MetaServer
+
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+ */
+
+#ifndef METASERVERHANDLERMULTIUDP_HPP_
+#define METASERVERHANDLERMULTIUDP_HPP_
+
+/*
+ * System Includes
+ */
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Forward Declarations
+ */
+class MetaServer;
+
+/**
+ * Serves UDP traffic from several threads, each with its own socket.
+ *
+ * All sockets are bound to the same address using SO_REUSEPORT, which lets
+ * the kernel spread incoming datagrams over them. Each worker reads and writes
+ * in batches through recvmmsg/sendmmsg, so that a surge of keepalives and list
+ * requests costs far fewer syscalls than one async_receive_from per packet.
+ *
+ * Packets for different sessions are processed in parallel, as the session
+ * store locks each of its shards separately.
+ *
+ * This is only available on Linux.
+ */
+class MetaServerHandlerMultiUDP {
+
+public:
+
+	MetaServerHandlerMultiUDP(MetaServer& ms,
+							  const std::string& address,
+							  unsigned int port,
+							  unsigned int workers,
+							  unsigned int batchSize = 32);
+
+	~MetaServerHandlerMultiUDP();
+
+	/**
+	 * Signals all workers to stop, and waits for them to exit.
+	 */
+	void stop();
+
+private:
+
+	void run_worker(int socket);
+
+	const std::string m_Address;
+	const unsigned int m_Port;
+	const unsigned int m_batchSize;
+	MetaServer& m_msRef;
+
+	std::vector<int> m_Sockets;
+	std::vector<std::thread> m_Workers;
+	std::atomic<bool> m_isStopped;
+
+};
+
+
+#endif /* METASERVERHANDLERMULTIUDP_HPP_ */
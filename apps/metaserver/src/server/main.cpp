@@ -26,6 +26,10 @@
 #include "MetaServer.hpp"
 #include "MetaServerHandlerUDP.hpp"
 
+#ifdef HAVE_RECVMMSG
+#include "MetaServerHandlerMultiUDP.hpp"
+#endif
+
 /*
  * System Includes
  */
@@ -64,6 +68,7 @@ int main(int argc, char** argv) {
 			("help,h", "Display help message")
 			("server.port,p", boost::program_options::value<int>(), "Server bind port. \nDefault:8543")
 			("server.ip", boost::program_options::value<std::string>(), "Server bind IP. \nDefault:0.0.0.0")
+			("server.udp_workers", boost::program_options::value<int>()->default_value(0), "Number of UDP worker threads, each with its own SO_REUSEPORT socket (Linux only). 0 serves all traffic from the main loop.\nDefault: 0")
 			("server.daemon", boost::program_options::value<std::string>(), "Daemonize after startup [true|false].\nDefault: true")
 			("server.logfile", boost::program_options::value<std::string>(), "Server logfile location.\nDefault: logdir/metaserver-ng.log")
 			("server.pidfile", boost::program_options::value<std::string>(), "Server pidfile location.\nDefault: rundir/metaserver-ng.pid")
@@ -332,8 +337,23 @@ int main(int argc, char** argv) {
 		 * Define Handlers
 		 */
 		//MetaServerHandlerUDP tcp(ms, io_service, ip, port);
-		spdlog::trace("Start UPD Handler");
-		MetaServerHandlerUDP udp(ms, io_service, ip, port);
+		int udpWorkers = vm["server.udp_workers"].as<int>();
+		std::unique_ptr<MetaServerHandlerUDP> udp;
+#ifdef HAVE_RECVMMSG
+		std::unique_ptr<MetaServerHandlerMultiUDP> udpMulti;
+		if (udpWorkers > 0) {
+			spdlog::trace("Start UDP Worker Handler");
+			udpMulti = std::make_unique<MetaServerHandlerMultiUDP>(ms, ip, port, udpWorkers);
+		} else
+#else
+		if (udpWorkers > 0) {
+			spdlog::warn("UDP workers are not supported on this platform, serving from the main loop.");
+		}
+#endif
+		{
+			spdlog::trace("Start UPD Handler");
+			udp = std::make_unique<MetaServerHandlerUDP>(ms, io_service, ip, port);
+		}
 
 		/*
 		 * Register Timers
@@ -0,0 +1,105 @@
+/**
+ Worldforge Next Generation MetaServer
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+ */
+
+/**
+ * Load test of the DataObject session store, measuring how long the expiry sweeps
+ * take with a large number of registered servers, clients and handshakes.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include "DataObject.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <cassert>
+
+namespace {
+
+const unsigned int sessionCount = 100000;
+
+template<typename Fn>
+void measure(const std::string& name, Fn&& fn) {
+	auto start = std::chrono::steady_clock::now();
+	auto count = fn();
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	std::cout << name << ": " << duration.count() << " us (" << count << " items)" << std::endl;
+}
+
+std::string sessionName(unsigned int i) {
+	return std::to_string(10 + (i >> 16)) + "." + std::to_string((i >> 8) & 0xFF) + "." + std::to_string(i & 0xFF) + ".1";
+}
+}
+
+int main() {
+	DataObject msdo;
+
+	measure("Register servers", [&]() {
+		for (unsigned int i = 0; i < sessionCount; ++i) {
+			auto name = sessionName(i);
+			msdo.addServerSession(name);
+			msdo.addServerAttribute(name, "port", "6767");
+		}
+		return msdo.getServerSessionCount();
+	});
+
+	measure("Register clients", [&]() {
+		for (unsigned int i = 0; i < sessionCount; ++i) {
+			msdo.addClientSession(sessionName(i));
+		}
+		return msdo.getClientSessionCount();
+	});
+
+	measure("Register handshakes", [&]() {
+		for (unsigned int i = 0; i < sessionCount; ++i) {
+			msdo.addHandshake(i + 1);
+		}
+		return msdo.getHandshakeCount();
+	});
+
+	measure("Keepalive all servers", [&]() {
+		for (unsigned int i = 0; i < sessionCount; ++i) {
+			msdo.addServerSession(sessionName(i));
+		}
+		return msdo.getServerSessionCount();
+	});
+
+	//A sweep where nothing is due should not need to look at the sessions.
+	measure("Sweep servers, none expired", [&]() { return msdo.expireServerSessions(3600).size(); });
+	measure("Sweep clients, none expired", [&]() { return msdo.expireClientSessions(300).size(); });
+	measure("Sweep handshakes, none expired", [&]() { return msdo.expireHandshakes(30).size(); });
+	assert(msdo.getServerSessionCount() == sessionCount);
+
+	//Make sure that the clock moves on, so that an expiry of zero seconds catches all entries.
+	std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+	measure("Sweep servers, all expired", [&]() { return msdo.expireServerSessions(0).size(); });
+	measure("Sweep clients, all expired", [&]() { return msdo.expireClientSessions(0).size(); });
+	measure("Sweep handshakes, all expired", [&]() { return msdo.expireHandshakes(0).size(); });
+
+	assert(msdo.getServerSessionCount() == 0);
+	assert(msdo.getClientSessionCount() == 0);
+	assert(msdo.getHandshakeCount() == 0);
+
+	return 0;
+}
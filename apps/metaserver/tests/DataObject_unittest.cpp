@@ -42,6 +42,7 @@ CPPUNIT_TEST_SUITE(DataObject_unittest);
 		CPPUNIT_TEST(test_Handshake);
 		CPPUNIT_TEST(test_ServerSession);
 		CPPUNIT_TEST(test_ClientSession);
+		CPPUNIT_TEST(test_ServerListSnapshot);
 
 
 	CPPUNIT_TEST_SUITE_END();
@@ -275,6 +276,49 @@ public:
 
 	}
 
+	void test_ServerListSnapshot() {
+
+		// add enough servers to need more than one page
+		uint32_t count = ServerListSnapshot::serversPerPage + 10;
+		for (uint32_t i = 0; i < count; ++i) {
+			std::string ip = "10.0.0." + std::to_string(i);
+			CPPUNIT_ASSERT(msdo->addServerSession(ip) == true);
+			CPPUNIT_ASSERT(msdo->addServerAttribute(ip, "ip_int", std::to_string(i + 1)) == true);
+		}
+
+		// bind a client to the current snapshot
+		CPPUNIT_ASSERT(msdo->createServerSessionListresp("client") == count);
+		auto snapshot = msdo->getServerListSnapshot("client");
+		CPPUNIT_ASSERT(snapshot);
+		CPPUNIT_ASSERT(snapshot->pages.size() == 2);
+		CPPUNIT_ASSERT(snapshot->addresses.size() == count);
+
+		// the first page is a complete LISTRESP packet
+		MetaServerPacket page(snapshot->pages[0].payload, snapshot->pages[0].size);
+		CPPUNIT_ASSERT(page.getPacketType() == NMT_LISTRESP);
+		CPPUNIT_ASSERT(page.getIntData(4) == count);
+		CPPUNIT_ASSERT(page.getIntData(8) == ServerListSnapshot::serversPerPage);
+
+		// binding another client without changes shares the snapshot
+		msdo->createServerSessionListresp("other-client");
+		CPPUNIT_ASSERT(msdo->getServerListSnapshot("other-client") == snapshot);
+
+		// keepalives don't invalidate the snapshot
+		msdo->addServerSession("10.0.0.1");
+		CPPUNIT_ASSERT(msdo->getServerListSnapshot() == snapshot);
+
+		// removing a server creates a new version, but the client keeps paging its old one
+		msdo->removeServerSession("10.0.0.1");
+		CPPUNIT_ASSERT(msdo->getServerListSnapshot("client") == snapshot);
+		auto newSnapshot = msdo->getServerListSnapshot();
+		CPPUNIT_ASSERT(newSnapshot->version > snapshot->version);
+		CPPUNIT_ASSERT(newSnapshot->sessions.size() == count - 1);
+
+		// rebinding picks up the new version
+		CPPUNIT_ASSERT(msdo->createServerSessionListresp("client") == count - 1);
+		CPPUNIT_ASSERT(msdo->getServerListSnapshot("client") == newSnapshot);
+	}
+
 };
 
 
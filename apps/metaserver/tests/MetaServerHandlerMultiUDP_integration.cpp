@@ -0,0 +1,148 @@
+/**
+ Worldforge Next Generation MetaServer
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+ */
+
+/*
+ * Local Includes
+ */
+#include "MetaServerHandlerMultiUDP.hpp"
+#include "MetaServer.hpp"
+#include "DataObject.hpp"
+#include "Flood.hpp"
+
+/*
+ * System Includes
+ */
+#include <cppunit/TestCase.h>
+#include <cppunit/TestRunner.h>
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+class MetaServerHandlerMultiUDP_integration : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE(MetaServerHandlerMultiUDP_integration);
+	CPPUNIT_TEST(test_flood);
+	CPPUNIT_TEST(test_concurrentSessions);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	MetaServerHandlerMultiUDP_integration() {}
+
+	/*
+	 * Floods a metaserver served by several UDP workers from several clients at once,
+	 * the same way the flood client does, and checks that every packet is answered.
+	 */
+	void test_flood() {
+		const unsigned int port = 18453;
+		const int clients = 8;
+		const int packets = 500;
+
+		MetaServer ms;
+		MetaServerHandlerMultiUDP handler(ms, "127.0.0.1", port, 4);
+
+		boost::asio::ip::udp::endpoint target(boost::asio::ip::make_address_v4("127.0.0.1"), port);
+		std::vector<FloodResult> results(clients);
+		std::vector<std::thread> threads;
+		for (int i = 0; i < clients; ++i) {
+			threads.emplace_back([&, i]() { flood(target, packets, results[i]); });
+		}
+		for (auto& thread: threads) {
+			thread.join();
+		}
+		handler.stop();
+
+		for (auto& result: results) {
+			CPPUNIT_ASSERT_EQUAL(0ul, result.timeouts);
+			CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(packets), result.latencies.size());
+		}
+	}
+
+	/*
+	 * Registers, refreshes and expires sessions from several threads at once,
+	 * as the UDP workers and the expiry timer do.
+	 */
+	void test_concurrentSessions() {
+		const int threadCount = 8;
+		const int sessionsPerThread = 500;
+
+		DataObject msdo;
+		std::vector<std::thread> threads;
+		for (int t = 0; t < threadCount; ++t) {
+			threads.emplace_back([&, t]() {
+				for (int i = 0; i < sessionsPerThread; ++i) {
+					auto session = std::to_string(t) + "." + std::to_string(i);
+					msdo.addServerSession(session);
+					msdo.addServerAttribute(session, "ip_int", std::to_string(i));
+					msdo.addClientSession(session);
+					msdo.addHandshake(static_cast<unsigned int>(t * sessionsPerThread + i + 1));
+					msdo.createServerSessionListresp(session);
+					/*
+					 * Every other server leaves again.
+					 */
+					if (i % 2 == 1) {
+						msdo.removeServerSession(session);
+					}
+				}
+			});
+		}
+		/*
+		 * Sweeps with a long expiry shouldn't remove anything, but run alongside the updates.
+		 */
+		threads.emplace_back([&]() {
+			for (int i = 0; i < 100; ++i) {
+				msdo.expireServerSessions(3600);
+				msdo.expireClientSessions(3600);
+				msdo.expireHandshakes(3600);
+				msdo.getServerListSnapshot();
+			}
+		});
+		for (auto& thread: threads) {
+			thread.join();
+		}
+
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(threadCount * sessionsPerThread / 2), msdo.getServerSessionCount());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(threadCount * sessionsPerThread), msdo.getClientSessionCount());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(threadCount * sessionsPerThread), msdo.getHandshakeCount());
+		CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(threadCount * sessionsPerThread / 2), msdo.getServerListSnapshot()->sessions.size());
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(threadCount * sessionsPerThread / 2), msdo.expireServerSessions(0).size());
+		CPPUNIT_ASSERT_EQUAL(0u, msdo.getServerSessionCount());
+		CPPUNIT_ASSERT(msdo.getServerListSnapshot()->sessions.empty());
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MetaServerHandlerMultiUDP_integration);
+
+int main() {
+	CppUnit::TextTestRunner runner;
+	CppUnit::Test* tp =
+			CppUnit::TestFactoryRegistry::getRegistry().makeTest();
+
+	runner.addTest(tp);
+
+	if (runner.run()) {
+		return 0;
+	} else {
+		return 1;
+	}
+}
@@ -30,6 +30,7 @@
 #obj_list = codec.decode(some_string)
 
 from . import xml
+from . import binary
 #from . import xml2
 #import packed
 # from . import binary1
@@ -67,6 +68,9 @@ factory_list = [
     CodecFactory("XML",
                  xml.get_encoder,
                  xml.get_encoder),
+    CodecFactory("Binary",
+                 binary.get_parser,
+                 binary.get_encoder),
     # CodecFactory("XML2_test",
     #              xml2.get_parser,
     #              lambda :xml2.gen_xml2),
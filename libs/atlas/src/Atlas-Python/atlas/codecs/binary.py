@@ -0,0 +1,255 @@
+#Binary codec, same format as Atlas::Codecs::Binary in the C++ library:
+#see Atlas/Codecs/Binary.h for a description of the format
+
+#Copyright (C) 2026 Erik Ogenvik
+
+#This library is free software; you can redistribute it and/or
+#modify it under the terms of the GNU Lesser General Public
+#License as published by the Free Software Foundation; either
+#version 2.1 of the License, or (at your option) any later version.
+
+#This library is distributed in the hope that it will be useful,
+#but WITHOUT ANY WARRANTY; without even the implied warranty of
+#MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+#Lesser General Public License for more details.
+
+#You should have received a copy of the GNU Lesser General Public
+#License along with this library; if not, write to the Free Software
+#Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#The transport passes data around as strings, so the encoded bytes are
+#kept as latin-1 strings, where each character is one byte.
+
+import struct
+
+from atlas import Object
+from atlas.typemap import *
+from . import encoder, decoder
+
+TAG_MAP = 0x01
+TAG_MAP_END = 0x02
+TAG_LIST = 0x03
+TAG_LIST_END = 0x04
+TAG_INT = 0x05
+TAG_FLOAT = 0x06
+TAG_STRING = 0x07
+TAG_NONE = 0x08
+TAG_STRING_REFERENCE = 0x09
+
+MAX_DICTIONARY_SIZE = 4096
+MAX_DICTIONARY_STRING_LENGTH = 64
+
+dictionary_values = ("parent", "objtype")
+
+class BinaryException(Exception): pass
+
+class Incomplete(Exception): pass
+
+
+def to_bytes(value):
+    return value.encode("utf-8")
+
+def from_bytes(value):
+    return value.decode("utf-8")
+
+def add_to_dictionary(dictionary_size, value):
+    """must match the rules in the C++ codec"""
+    return dictionary_size < MAX_DICTIONARY_SIZE and \
+           len(value) <= MAX_DICTIONARY_STRING_LENGTH
+
+
+class Encoder(encoder.BaseEncoder):
+    begin_string = ""
+    middle_string = ""
+    end_string = ""
+    empty_end_string = ""
+
+    def __init__(self, stream_flag=None):
+        encoder.BaseEncoder.__init__(self, stream_flag)
+        self.dictionary = {}
+
+    def encode1stream(self, object):
+        out = bytearray()
+        self.encode_map(out, object)
+        return out.decode("latin-1")
+
+    encode1 = encode1stream
+
+    def encode_varint(self, out, value):
+        while value >= 0x80:
+            out.append((value & 0x7f) | 0x80)
+            value >>= 7
+        out.append(value)
+
+    def encode_string(self, out, value):
+        data = to_bytes(value)
+        self.encode_varint(out, len(data))
+        out.extend(data)
+
+    def encode_reference(self, out, value):
+        data = to_bytes(value)
+        index = self.dictionary.get(data)
+        if index:
+            self.encode_varint(out, index)
+            return
+        self.encode_varint(out, 0)
+        self.encode_varint(out, len(data))
+        out.extend(data)
+        if add_to_dictionary(len(self.dictionary), data):
+            self.dictionary[data] = len(self.dictionary) + 1
+
+    def encode_value(self, out, value, name=None):
+        """name is None for list items"""
+        type_str = get_atlas_type(value)
+        if value is None:
+            out.append(TAG_NONE)
+            if name is not None: self.encode_reference(out, name)
+        elif type_str == "map":
+            out.append(TAG_MAP)
+            if name is not None: self.encode_reference(out, name)
+            self.encode_map_items(out, value)
+            out.append(TAG_MAP_END)
+        elif type_str == "list":
+            out.append(TAG_LIST)
+            if name is not None: self.encode_reference(out, name)
+            for item in value:
+                self.encode_value(out, item)
+            out.append(TAG_LIST_END)
+        elif type_str == "int":
+            out.append(TAG_INT)
+            if name is not None: self.encode_reference(out, name)
+            self.encode_varint(out, (value << 1) ^ (value >> 63))
+        elif type_str == "float":
+            out.append(TAG_FLOAT)
+            if name is not None: self.encode_reference(out, name)
+            out.extend(struct.pack("<d", value))
+        elif name in dictionary_values:
+            out.append(TAG_STRING_REFERENCE)
+            self.encode_reference(out, name)
+            self.encode_reference(out, value)
+        else:
+            out.append(TAG_STRING)
+            if name is not None: self.encode_reference(out, name)
+            self.encode_string(out, value)
+
+    def encode_map_items(self, out, obj):
+        for name, value in list(obj.items()):
+            if value is None:
+                continue
+            if name == "parent" and not isinstance(value, str):
+                value = value.id
+            self.encode_value(out, value, name)
+
+    def encode_map(self, out, obj):
+        out.append(TAG_MAP)
+        self.encode_map_items(out, obj)
+        out.append(TAG_MAP_END)
+
+
+def get_encoder(stream_flag=None):
+    return Encoder(stream_flag)
+
+############################################################
+
+class BinaryParser(decoder.BaseDecoder):
+    def __init__(self, stream_flag=None):
+        self.buffer = bytearray()
+        self.dictionary = []
+        self.setup(stream_flag)
+
+    def eos(self):
+        """end of stream"""
+        return not self.buffer
+
+    def feed(self, msg):
+        self.buffer.extend(msg.encode("latin-1"))
+        while self.buffer:
+            #Anything added to the dictionary by an incomplete message
+            #is rolled back, since it will be parsed again.
+            dictionary_size = len(self.dictionary)
+            try:
+                obj, pos = self.parse_message(0)
+            except Incomplete:
+                del self.dictionary[dictionary_size:]
+                return
+            del self.buffer[:pos]
+            self.msgList.append(obj)
+
+    def byte(self, pos):
+        if pos >= len(self.buffer):
+            raise Incomplete()
+        return self.buffer[pos]
+
+    def parse_varint(self, pos):
+        value = 0
+        shift = 0
+        while 1:
+            b = self.byte(pos)
+            pos = pos + 1
+            value |= (b & 0x7f) << shift
+            if not b & 0x80:
+                return value, pos
+            shift = shift + 7
+            if shift >= 70:
+                raise BinaryException("varint too long")
+
+    def parse_bytes(self, pos):
+        length, pos = self.parse_varint(pos)
+        if pos + length > len(self.buffer):
+            raise Incomplete()
+        return bytes(self.buffer[pos:pos + length]), pos + length
+
+    def parse_reference(self, pos):
+        index, pos = self.parse_varint(pos)
+        if index == 0:
+            data, pos = self.parse_bytes(pos)
+            if add_to_dictionary(len(self.dictionary), data):
+                self.dictionary.append(data)
+            return from_bytes(data), pos
+        if index > len(self.dictionary):
+            raise BinaryException("unknown dictionary reference %i" % index)
+        return from_bytes(self.dictionary[index - 1]), pos
+
+    def parse_value(self, tag, pos):
+        if tag == TAG_MAP:
+            obj = Object()
+            while 1:
+                tag = self.byte(pos)
+                if tag == TAG_MAP_END:
+                    return obj, pos + 1
+                name, pos = self.parse_reference(pos + 1)
+                value, pos = self.parse_value(tag, pos)
+                setattr(obj, name, value)
+        elif tag == TAG_LIST:
+            lst = []
+            while 1:
+                tag = self.byte(pos)
+                if tag == TAG_LIST_END:
+                    return lst, pos + 1
+                value, pos = self.parse_value(tag, pos + 1)
+                lst.append(value)
+        elif tag == TAG_INT:
+            value, pos = self.parse_varint(pos)
+            return (value >> 1) ^ -(value & 1), pos
+        elif tag == TAG_FLOAT:
+            if pos + 8 > len(self.buffer):
+                raise Incomplete()
+            return struct.unpack("<d", bytes(self.buffer[pos:pos + 8]))[0], pos + 8
+        elif tag == TAG_STRING:
+            data, pos = self.parse_bytes(pos)
+            return from_bytes(data), pos
+        elif tag == TAG_STRING_REFERENCE:
+            return self.parse_reference(pos)
+        elif tag == TAG_NONE:
+            return None, pos
+        raise BinaryException("unknown tag %i" % tag)
+
+    def parse_message(self, pos):
+        tag = self.byte(pos)
+        if tag != TAG_MAP:
+            raise BinaryException("message is not a map")
+        return self.parse_value(tag, pos + 1)
+
+
+def get_parser():
+    return BinaryParser()
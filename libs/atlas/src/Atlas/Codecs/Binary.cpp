@@ -0,0 +1,412 @@
+// This file may be redistributed and modified only under the terms of
+// the GNU Lesser General Public License (See COPYING for details).
+// Copyright (C) 2026 Erik Ogenvik
+
+#include <Atlas/Codecs/Binary.h>
+
+#include <cstring>
+#include <iostream>
+
+namespace {
+constexpr char TAG_MAP = 0x01;
+constexpr char TAG_MAP_END = 0x02;
+constexpr char TAG_LIST = 0x03;
+constexpr char TAG_LIST_END = 0x04;
+constexpr char TAG_INT = 0x05;
+constexpr char TAG_FLOAT = 0x06;
+constexpr char TAG_STRING = 0x07;
+constexpr char TAG_NONE = 0x08;
+constexpr char TAG_STRING_REFERENCE = 0x09;
+
+/**
+ * A 64 bit varint never takes more than this many bytes.
+ */
+constexpr std::size_t MAX_VARINT_LENGTH = 10;
+
+std::uint64_t zigzagEncode(std::int64_t value) {
+	return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t zigzagDecode(std::uint64_t value) {
+	return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+}
+
+namespace Atlas::Codecs {
+
+Binary::Binary(std::istream& in, std::ostream& out, Atlas::Bridge& b)
+		: m_istream(in), m_ostream(out), m_bridge(b), m_inPos(0) {
+	m_state.push(PARSE_NOTHING);
+}
+
+Binary::ReadResult Binary::readVarint(std::uint64_t& value) {
+	value = 0;
+	for (std::size_t i = 0; i < MAX_VARINT_LENGTH; ++i) {
+		if (m_inPos + i >= m_inBuffer.size()) {
+			return ReadResult::INCOMPLETE;
+		}
+		auto byte = static_cast<std::uint8_t>(m_inBuffer[m_inPos + i]);
+		value |= static_cast<std::uint64_t>(byte & 0x7f) << (7 * i);
+		if ((byte & 0x80) == 0) {
+			m_inPos += i + 1;
+			return ReadResult::OK;
+		}
+	}
+	return ReadResult::INVALID;
+}
+
+Binary::ReadResult Binary::readString(std::string& value) {
+	std::uint64_t length;
+	auto result = readVarint(length);
+	if (result != ReadResult::OK) {
+		return result;
+	}
+	if (length > m_inBuffer.size() - m_inPos) {
+		return ReadResult::INCOMPLETE;
+	}
+	value.assign(m_inBuffer, m_inPos, length);
+	m_inPos += length;
+	return ReadResult::OK;
+}
+
+Binary::ReadResult Binary::readReference(std::string& value) {
+	std::uint64_t index;
+	auto result = readVarint(index);
+	if (result != ReadResult::OK) {
+		return result;
+	}
+	if (index == 0) {
+		result = readString(value);
+		//Must match the rules in writeReference().
+		if (result == ReadResult::OK && m_inDictionary.size() < MAX_DICTIONARY_SIZE && value.size() <= MAX_DICTIONARY_STRING_LENGTH) {
+			m_inDictionary.push_back(value);
+		}
+		return result;
+	}
+	if (index <= m_inDictionary.size()) {
+		value = m_inDictionary[index - 1];
+		return ReadResult::OK;
+	}
+	return ReadResult::INVALID;
+}
+
+Binary::ReadResult Binary::readFloat(double& value) {
+	if (m_inBuffer.size() - m_inPos < 8) {
+		return ReadResult::INCOMPLETE;
+	}
+	std::uint64_t bits = 0;
+	for (std::size_t i = 0; i < 8; ++i) {
+		bits |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(m_inBuffer[m_inPos + i])) << (8 * i);
+	}
+	std::memcpy(&value, &bits, sizeof(value));
+	m_inPos += 8;
+	return ReadResult::OK;
+}
+
+bool Binary::parseElement() {
+	if (m_inPos >= m_inBuffer.size()) {
+		return false;
+	}
+
+	if (m_state.top() == PARSE_NOTHING) {
+		m_state.push(PARSE_STREAM);
+		m_bridge.streamBegin();
+	}
+
+	//If the element is incomplete it will be parsed again, so anything added to the dictionary must be rolled back.
+	auto start = m_inPos;
+	auto dictionarySize = m_inDictionary.size();
+	char tag = m_inBuffer[m_inPos++];
+	auto state = m_state.top();
+
+	std::string name;
+	std::string stringValue;
+	std::uint64_t intValue = 0;
+	double floatValue = 0;
+	ReadResult result = ReadResult::OK;
+
+	if (state == PARSE_STREAM) {
+		if (tag != TAG_MAP) {
+			result = ReadResult::INVALID;
+		}
+	} else if (state == PARSE_MAP && tag != TAG_MAP_END) {
+		result = readReference(name);
+	}
+
+	if (result == ReadResult::OK) {
+		switch (tag) {
+			case TAG_INT:
+				result = readVarint(intValue);
+				break;
+			case TAG_FLOAT:
+				result = readFloat(floatValue);
+				break;
+			case TAG_STRING:
+				result = readString(stringValue);
+				break;
+			case TAG_STRING_REFERENCE:
+				result = readReference(stringValue);
+				break;
+			case TAG_MAP:
+			case TAG_LIST:
+			case TAG_NONE:
+				break;
+			case TAG_MAP_END:
+				if (state != PARSE_MAP) {
+					result = ReadResult::INVALID;
+				}
+				break;
+			case TAG_LIST_END:
+				if (state != PARSE_LIST) {
+					result = ReadResult::INVALID;
+				}
+				break;
+			default:
+				result = ReadResult::INVALID;
+				break;
+		}
+	}
+
+	if (result != ReadResult::OK) {
+		m_inDictionary.resize(dictionarySize);
+		if (result == ReadResult::INCOMPLETE) {
+			m_inPos = start;
+		} else {
+			// FIXME signal error here
+			// The stream can't be recovered, so discard what we've got.
+			m_inBuffer.clear();
+			m_inPos = 0;
+		}
+		return false;
+	}
+
+	if (state == PARSE_STREAM) {
+		m_bridge.streamMessage();
+		m_state.push(PARSE_MAP);
+	} else if (state == PARSE_MAP) {
+		switch (tag) {
+			case TAG_MAP:
+				m_bridge.mapMapItem(std::move(name));
+				m_state.push(PARSE_MAP);
+				break;
+			case TAG_LIST:
+				m_bridge.mapListItem(std::move(name));
+				m_state.push(PARSE_LIST);
+				break;
+			case TAG_INT:
+				m_bridge.mapIntItem(std::move(name), zigzagDecode(intValue));
+				break;
+			case TAG_FLOAT:
+				m_bridge.mapFloatItem(std::move(name), floatValue);
+				break;
+			case TAG_STRING:
+			case TAG_STRING_REFERENCE:
+				m_bridge.mapStringItem(std::move(name), std::move(stringValue));
+				break;
+			case TAG_NONE:
+				m_bridge.mapNoneItem(std::move(name));
+				break;
+			case TAG_MAP_END:
+				m_bridge.mapEnd();
+				m_state.pop();
+				break;
+			default:
+				break;
+		}
+	} else if (state == PARSE_LIST) {
+		switch (tag) {
+			case TAG_MAP:
+				m_bridge.listMapItem();
+				m_state.push(PARSE_MAP);
+				break;
+			case TAG_LIST:
+				m_bridge.listListItem();
+				m_state.push(PARSE_LIST);
+				break;
+			case TAG_INT:
+				m_bridge.listIntItem(zigzagDecode(intValue));
+				break;
+			case TAG_FLOAT:
+				m_bridge.listFloatItem(floatValue);
+				break;
+			case TAG_STRING:
+			case TAG_STRING_REFERENCE:
+				m_bridge.listStringItem(std::move(stringValue));
+				break;
+			case TAG_NONE:
+				m_bridge.listNoneItem();
+				break;
+			case TAG_LIST_END:
+				m_bridge.listEnd();
+				m_state.pop();
+				break;
+			default:
+				break;
+		}
+	}
+	return true;
+}
+
+void Binary::poll() {
+	m_istream.peek();
+
+	std::streamsize count;
+	while ((count = m_istream.rdbuf()->in_avail()) > 0) {
+		auto size = m_inBuffer.size();
+		m_inBuffer.resize(size + count);
+		auto read = m_istream.rdbuf()->sgetn(m_inBuffer.data() + size, count);
+		m_inBuffer.resize(size + read);
+	}
+
+	while (parseElement()) {
+	}
+
+	//Only keep the unparsed tail around.
+	if (m_inPos > 0) {
+		m_inBuffer.erase(0, m_inPos);
+		m_inPos = 0;
+	}
+}
+
+void Binary::writeVarint(std::uint64_t value) {
+	while (value >= 0x80) {
+		m_outBuffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	m_outBuffer.push_back(static_cast<char>(value));
+}
+
+void Binary::writeString(const std::string& value) {
+	writeVarint(value.size());
+	m_outBuffer.append(value);
+}
+
+void Binary::writeReference(const std::string& value) {
+	auto I = m_outDictionary.find(value);
+	if (I != m_outDictionary.end()) {
+		writeVarint(I->second);
+		return;
+	}
+	writeVarint(0);
+	writeString(value);
+	if (m_outDictionary.size() < MAX_DICTIONARY_SIZE && value.size() <= MAX_DICTIONARY_STRING_LENGTH) {
+		m_outDictionary.emplace(value, static_cast<std::uint32_t>(m_outDictionary.size() + 1));
+	}
+}
+
+void Binary::writeFloat(double value) {
+	std::uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	for (std::size_t i = 0; i < 8; ++i) {
+		m_outBuffer.push_back(static_cast<char>((bits >> (8 * i)) & 0xff));
+	}
+}
+
+void Binary::flushElement() {
+	m_ostream.write(m_outBuffer.data(), static_cast<std::streamsize>(m_outBuffer.size()));
+	m_outBuffer.clear();
+}
+
+void Binary::streamBegin() {
+	//Do nothing to denote that a stream begins.
+}
+
+void Binary::streamMessage() {
+	m_outBuffer.push_back(TAG_MAP);
+	flushElement();
+}
+
+void Binary::streamEnd() {
+	//Do nothing to denote that a stream ends.
+}
+
+void Binary::mapMapItem(std::string name) {
+	m_outBuffer.push_back(TAG_MAP);
+	writeReference(name);
+	flushElement();
+}
+
+void Binary::mapListItem(std::string name) {
+	m_outBuffer.push_back(TAG_LIST);
+	writeReference(name);
+	flushElement();
+}
+
+void Binary::mapIntItem(std::string name, std::int64_t data) {
+	m_outBuffer.push_back(TAG_INT);
+	writeReference(name);
+	writeVarint(zigzagEncode(data));
+	flushElement();
+}
+
+void Binary::mapFloatItem(std::string name, double data) {
+	m_outBuffer.push_back(TAG_FLOAT);
+	writeReference(name);
+	writeFloat(data);
+	flushElement();
+}
+
+void Binary::mapStringItem(std::string name, std::string data) {
+	if (isDictionaryValue(name)) {
+		m_outBuffer.push_back(TAG_STRING_REFERENCE);
+		writeReference(name);
+		writeReference(data);
+	} else {
+		m_outBuffer.push_back(TAG_STRING);
+		writeReference(name);
+		writeString(data);
+	}
+	flushElement();
+}
+
+void Binary::mapNoneItem(std::string name) {
+	m_outBuffer.push_back(TAG_NONE);
+	writeReference(name);
+	flushElement();
+}
+
+void Binary::mapEnd() {
+	m_outBuffer.push_back(TAG_MAP_END);
+	flushElement();
+}
+
+void Binary::listMapItem() {
+	m_outBuffer.push_back(TAG_MAP);
+	flushElement();
+}
+
+void Binary::listListItem() {
+	m_outBuffer.push_back(TAG_LIST);
+	flushElement();
+}
+
+void Binary::listIntItem(std::int64_t data) {
+	m_outBuffer.push_back(TAG_INT);
+	writeVarint(zigzagEncode(data));
+	flushElement();
+}
+
+void Binary::listFloatItem(double data) {
+	m_outBuffer.push_back(TAG_FLOAT);
+	writeFloat(data);
+	flushElement();
+}
+
+void Binary::listStringItem(std::string data) {
+	m_outBuffer.push_back(TAG_STRING);
+	writeString(data);
+	flushElement();
+}
+
+void Binary::listNoneItem() {
+	m_outBuffer.push_back(TAG_NONE);
+	flushElement();
+}
+
+void Binary::listEnd() {
+	m_outBuffer.push_back(TAG_LIST_END);
+	flushElement();
+}
+
+}
+// namespace Atlas::Codecs
@@ -0,0 +1,176 @@
+// This file may be redistributed and modified only under the terms of
+// the GNU Lesser General Public License (See COPYING for details).
+// Copyright (C) 2026 Erik Ogenvik
+
+#ifndef ATLAS_CODECS_BINARY_H
+#define ATLAS_CODECS_BINARY_H
+
+#include <Atlas/Codec.h>
+
+#include <cstdint>
+#include <iosfwd>
+#include <stack>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace Atlas::Codecs {
+
+/*
+
+A compact binary codec. Each element is written as
+
+[tag][name][data]
+
+where the name is only present for elements in maps. Tags are single bytes:
+
+0x01 map        (followed by elements, ended by 0x02)
+0x03 list       (followed by elements, ended by 0x04)
+0x05 int        zigzag encoded varint
+0x06 float      eight bytes of IEEE 754 double, little endian
+0x07 string     varint length followed by the bytes
+0x08 none
+0x09 string     stored in the dictionary, see below
+
+A message is a map at the top level.
+
+Names, as well as the values of "parent" and "objtype" attributes, are
+written as dictionary references. A reference is a varint; zero means that
+a literal string (varint length and bytes) follows, which is then added to
+the dictionary; any other value refers to the dictionary entry with that
+index, starting at one. Each direction of a connection has its own
+dictionary, which starts out empty and grows identically on both ends.
+
+Sample output for [$parent=move@id=17] first time it's sent:
+
+01 09 00 06 "parent" 00 04 "move" 05 00 02 "id" 22 02
+
+and thereafter:
+
+01 09 01 02 05 03 22 02
+
+*/
+
+class Binary : public Codec {
+public:
+
+	/**
+	 * The max number of entries in a dictionary.
+	 */
+	static constexpr std::size_t MAX_DICTIONARY_SIZE = 4096;
+
+	/**
+	 * Strings longer than this are never put in the dictionary.
+	 */
+	static constexpr std::size_t MAX_DICTIONARY_STRING_LENGTH = 64;
+
+	Binary(std::istream& in, std::ostream& out, Atlas::Bridge& b);
+
+	void poll() override;
+
+	void streamBegin() override;
+
+	void streamMessage() override;
+
+	void streamEnd() override;
+
+	void mapMapItem(std::string name) override;
+
+	void mapListItem(std::string name) override;
+
+	void mapIntItem(std::string name, std::int64_t) override;
+
+	void mapFloatItem(std::string name, double) override;
+
+	void mapStringItem(std::string name, std::string) override;
+
+	void mapNoneItem(std::string name) override;
+
+	void mapEnd() override;
+
+	void listMapItem() override;
+
+	void listListItem() override;
+
+	void listIntItem(std::int64_t) override;
+
+	void listFloatItem(double) override;
+
+	void listStringItem(std::string) override;
+
+	void listNoneItem() override;
+
+	void listEnd() override;
+
+protected:
+
+	std::istream& m_istream;
+	std::ostream& m_ostream;
+	Bridge& m_bridge;
+
+	enum State {
+		PARSE_NOTHING,
+		PARSE_STREAM,
+		PARSE_MAP,
+		PARSE_LIST
+	};
+
+	enum class ReadResult {
+		OK,
+		INCOMPLETE,
+		INVALID
+	};
+
+	std::stack<State> m_state;
+
+	/**
+	 * Incoming bytes which haven't been parsed yet.
+	 */
+	std::string m_inBuffer;
+	/**
+	 * Position of the first unparsed byte in the buffer.
+	 */
+	std::size_t m_inPos;
+
+	/**
+	 * Outgoing bytes for the current element.
+	 */
+	std::string m_outBuffer;
+
+	std::unordered_map<std::string, std::uint32_t> m_outDictionary;
+	std::vector<std::string> m_inDictionary;
+
+	/**
+	 * Parses one element from the buffer.
+	 * @return True if an element was parsed and there might be more to parse.
+	 */
+	bool parseElement();
+
+	ReadResult readVarint(std::uint64_t& value);
+
+	ReadResult readString(std::string& value);
+
+	ReadResult readReference(std::string& value);
+
+	ReadResult readFloat(double& value);
+
+	void writeVarint(std::uint64_t value);
+
+	void writeString(const std::string& value);
+
+	void writeReference(const std::string& value);
+
+	void writeFloat(double value);
+
+	void flushElement();
+
+	static bool isDictionaryValue(const std::string& name) {
+		return name == "parent" || name == "objtype";
+	}
+};
+
+}
+// namespace Atlas::Codecs
+
+#endif
@@ -5,7 +5,7 @@
 // $Id$
 
 #include <Atlas/Filter.h>
-#include <cstring>
+#include <algorithm>
 
 namespace Atlas {
 
@@ -19,52 +19,92 @@ filterbuf::~filterbuf() {
 	sync();
 }
 
+void filterbuf::setStreamBuffer(std::streambuf& buffer) {
+	sync();
+	m_streamBuffer = &buffer;
+}
+
+int filterbuf::flushOutBuffer() {
+	auto num = static_cast<int>(pptr() - pbase());
+	m_pendingOut.append(pbase(), pptr());
+	pbump(-num);
+	return num;
+}
+
 int_type filterbuf::overflow(int_type c) {
+	flushOutBuffer();
 	if (c != traits_type::eof()) {
 		*pptr() = (char) c;
 		pbump(1);
 	}
-	if (flushOutBuffer() == traits_type::eof()) {
-		return traits_type::eof();
+	return traits_type::not_eof(c);
+}
+
+bool filterbuf::fillInBuffer() {
+	auto available = m_streamBuffer->in_avail();
+	if (available <= 0) {
+		//Nothing known to be available, so see if the underlying buffer can fetch more.
+		if (m_streamBuffer->sgetc() == traits_type::eof()) {
+			return false;
+		}
+		available = std::max(std::streamsize(1), m_streamBuffer->in_avail());
 	}
-	return c;
+
+	std::string data(static_cast<std::size_t>(available), '\0');
+	data.resize(static_cast<std::size_t>(m_streamBuffer->sgetn(data.data(), available)));
+
+	auto start = std::chrono::steady_clock::now();
+	std::string decoded = m_filter.decode(data);
+	m_inStatistics.filterTime += std::chrono::steady_clock::now() - start;
+	m_inStatistics.filteredBytes += data.size();
+	m_inStatistics.unfilteredBytes += decoded.size();
+
+	//Keep some of the already read data, to allow for putback.
+	auto consumed = static_cast<std::size_t>(gptr() - eback());
+	auto keep = std::min(consumed, m_inPutback);
+	m_inBuffer.erase(0, consumed - keep);
+	m_inBuffer += decoded;
+
+	setg(m_inBuffer.data(),
+		 m_inBuffer.data() + keep,
+		 m_inBuffer.data() + m_inBuffer.size());
+
+	return gptr() < egptr();
 }
 
 int_type filterbuf::underflow() {
-	if (gptr() < egptr()) return *gptr();
-
-	auto numPutback = gptr() - eback();
-
-	if (numPutback > m_inPutback) numPutback = m_inPutback;
-
-	std::memcpy(m_outBuffer.data() + (m_inPutback - numPutback),
-				gptr() - numPutback,
-				(unsigned long) numPutback);
-
-	//     FIXME
-	// Here we need to actually
-	//  * get data from m_streamBuffer
-	//  * encode it with m_filter
-	//  * put _that_ into the buffer
-	//
-	// Currently it just fetches it and places it straight in the
-	// buffer.
-	// The problem is the limited size of the buffer with the
-	// Filter::decode operation not having any kind of size
-	// limitation.
-	auto num = m_streamBuffer.sgetn(m_inBuffer.data() + m_inPutback,
-							   m_inBuffer.size() - m_inPutback);
-	if (num <= 0) return traits_type::eof();
-
-	setg(m_inBuffer.data() + (m_inPutback - numPutback),
-		 m_inBuffer.data() + m_inPutback,
-		 m_inBuffer.data() + m_inPutback + num);
-
-	return *gptr();
+	if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+	//The filter might need more data before it can produce anything.
+	while (!fillInBuffer()) {
+		if (m_streamBuffer->in_avail() <= 0 && m_streamBuffer->sgetc() == traits_type::eof()) {
+			return traits_type::eof();
+		}
+	}
+
+	return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize filterbuf::showmanyc() {
+	if (m_streamBuffer->in_avail() > 0) {
+		fillInBuffer();
+	}
+	return egptr() - gptr();
 }
 
 int filterbuf::sync() {
-	if (flushOutBuffer() == traits_type::eof()) return -1;
+	flushOutBuffer();
+	if (!m_pendingOut.empty()) {
+		auto start = std::chrono::steady_clock::now();
+		std::string encoded = m_filter.encode(m_pendingOut);
+		m_outStatistics.filterTime += std::chrono::steady_clock::now() - start;
+		m_outStatistics.unfilteredBytes += m_pendingOut.size();
+		m_outStatistics.filteredBytes += encoded.size();
+		m_pendingOut.clear();
+		if (m_streamBuffer->sputn(encoded.data(), static_cast<std::streamsize>(encoded.size())) != static_cast<std::streamsize>(encoded.size())) {
+			return -1;
+		}
+	}
 	return 0;
 }
 
@@ -11,6 +11,7 @@
 #include <string>
 #include <memory>
 #include <array>
+#include <chrono>
 
 namespace Atlas {
 
@@ -60,44 +61,94 @@ protected:
 
 typedef int int_type;
 
+/**
+ * A stream buffer which passes data through a Filter before handing it on to another stream buffer.
+ *
+ * Data written is buffered and encoded on sync(), so make sure to flush the stream at suitable intervals.
+ * Data read is taken from whatever is available in the underlying buffer and decoded.
+ * The same filter can be used for two instances, one used for reading and one for writing.
+ */
 class filterbuf : public std::streambuf {
 
 public:
 
+	/**
+	 * Amount of data passed through the filter in one direction.
+	 */
+	struct Statistics {
+		/**
+		 * Bytes seen by the codec.
+		 */
+		std::size_t unfilteredBytes = 0;
+		/**
+		 * Bytes seen by the underlying buffer.
+		 */
+		std::size_t filteredBytes = 0;
+		/**
+		 * Time spent in the filter.
+		 */
+		std::chrono::nanoseconds filterTime{};
+	};
+
 	filterbuf(std::streambuf& buffer,
 			  Filter& filter)
-			: m_outBuffer(), m_inBuffer(), m_streamBuffer(buffer), m_filter(filter) {
-		setp(m_outBuffer.data(), m_outBuffer.data() + (m_outBuffer.size() - 1));
-		setg(m_inBuffer.data() + m_inPutback, m_inBuffer.data() + m_inPutback,
-			 m_inBuffer.data() + m_inPutback);
+			: m_outBuffer(), m_streamBuffer(&buffer), m_filter(filter) {
+		setp(m_outBuffer.data(), m_outBuffer.data() + m_outBuffer.size());
+		setg(m_inBuffer.data(), m_inBuffer.data(), m_inBuffer.data());
 	}
 
 	~filterbuf() override;
 
-protected:
-	std::array<char, 10> m_outBuffer;
+	/**
+	 * Replaces the underlying buffer, after first flushing any pending output to the current one.
+	 */
+	void setStreamBuffer(std::streambuf& buffer);
 
-	static constexpr auto m_inPutback = 4;
-	std::array<char, 10> m_inBuffer;
+	const Statistics& getInStatistics() const {
+		return m_inStatistics;
+	}
 
-	int flushOutBuffer() {
-		auto num = static_cast<int>(pptr() - pbase());
-		std::string encoded = m_filter.encode(std::string(pbase(), pptr()));
-		m_streamBuffer.sputn(encoded.c_str(), static_cast<std::streamsize>(encoded.size()));
-		pbump(-num);
-		return num;
+	const Statistics& getOutStatistics() const {
+		return m_outStatistics;
 	}
 
+protected:
+	std::array<char, 4096> m_outBuffer;
+
+	/**
+	 * Output which has been written but not yet encoded.
+	 */
+	std::string m_pendingOut;
+
+	static constexpr std::size_t m_inPutback = 4;
+
+	/**
+	 * Decoded input.
+	 */
+	std::string m_inBuffer;
+
+	int flushOutBuffer();
+
+	/**
+	 * Decodes whatever is available in the underlying buffer.
+	 * @return True if there's now data to read.
+	 */
+	bool fillInBuffer();
+
 	int_type overflow(int_type c) override;
 
 	int_type underflow() override;
 
+	std::streamsize showmanyc() override;
+
 	int sync() override;
 
 private:
 
-	std::streambuf& m_streamBuffer;
+	std::streambuf* m_streamBuffer;
 	Filter& m_filter;
+	Statistics m_inStatistics;
+	Statistics m_outStatistics;
 };
 
 } // Atlas namespace
@@ -0,0 +1,207 @@
+// This file may be redistributed and modified only under the terms of
+// the GNU Lesser General Public License (See COPYING for details).
+// Copyright (C) 2026 Erik Ogenvik
+
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+#define ZLIB_CONST
+
+#include <Atlas/Filters/Deflate.h>
+#include <Atlas/Exception.h>
+#include <Atlas/Codecs/Binary.h>
+#include <Atlas/Codecs/Packed.h>
+
+#include <sstream>
+#include <vector>
+
+namespace {
+/**
+ * Use raw deflate streams, without zlib headers or checksums.
+ */
+constexpr int WINDOW_BITS = -15;
+
+/**
+ * Strings commonly found in Atlas traffic when using one of the text codecs.
+ * Deflate prefers matches at the end of the dictionary, so the most common strings are placed last.
+ */
+const std::string TEXT_DICTIONARY =
+		"children" "attributes" "description" "contains" "modifiers" "geometry" "present" "scale" "density" "friction"
+		"mass" "status" "solid" "planted" "mode_data" "_propel" "_direction" "_destination" "action" "entity_ref"
+		"[$parent=login$objtype=op(args=[$username=$password=])]"
+		"[$parent=logout$objtype=op]"
+		"[$parent=error$objtype=op(args=[$message=])]"
+		"[$parent=info$objtype=op(args=[$parent=player$objtype=obj])]"
+		"[$parent=imaginary$objtype=op]"
+		"[$parent=talk$objtype=op(args=[$say=])]"
+		"[$parent=thought$objtype=op]"
+		"[$parent=create$objtype=op]"
+		"[$parent=delete$objtype=op]"
+		"[$parent=look$objtype=op]"
+		"[$parent=use$objtype=op]"
+		"[$parent=wield$objtype=op]"
+		"[$parent=tick$objtype=op#seconds=#future_seconds=]"
+		"[$parent=update$objtype=op]"
+		"[$parent=appearance$objtype=op(args=[$id=@stamp=])]"
+		"[$parent=disappearance$objtype=op(args=[$id=])]"
+		"[$parent=move$objtype=op(args=[$loc=(pos=(orientation=(velocity=(angular=(bbox=$mode=])]"
+		"[$parent=set$objtype=op(args=[$id=$name=])]"
+		"[$parent=sight$objtype=op$from=$to=@serialno=@refno=#seconds=#stamp=(args=[$parent=$objtype=obj$id=$loc="
+		"(pos=(orientation=(velocity=(angular=(bbox=$name=$mode=])]";
+
+/**
+ * Messages commonly found in Atlas traffic, in the Packed format, from which the dictionary for the Binary codec is built.
+ * Deflate prefers matches at the end of the dictionary, so the most common messages are placed last.
+ */
+const std::vector<std::string> COMMON_MESSAGES = {
+		"[$parent=login$objtype=op(args=[$username=user$password=password])]",
+		"[$parent=logout$objtype=op]",
+		"[$parent=error$objtype=op(args=[$message=error])]",
+		"[$parent=info$objtype=op(args=[$parent=player$objtype=obj$id=1(characters=$1)])]",
+		"[$parent=imaginary$objtype=op$from=1(args=[$description=description])]",
+		"[$parent=talk$objtype=op$from=1(args=[$say=say])]",
+		"[$parent=thought$objtype=op$from=1]",
+		"[$parent=create$objtype=op$from=1(args=[$parent=thing$objtype=obj$loc=1(pos=#0#0#0)])]",
+		"[$parent=delete$objtype=op$from=1(args=[$id=1])]",
+		"[$parent=look$objtype=op$from=1(args=[$id=1])]",
+		"[$parent=use$objtype=op$from=1(args=[$id=1])]",
+		"[$parent=wield$objtype=op$from=1(args=[$id=1])]",
+		"[$parent=tick$objtype=op$from=1$to=1#seconds=0.1#future_seconds=0.1]",
+		"[$parent=update$objtype=op$from=1$to=1]",
+		"[$parent=appearance$objtype=op$from=1$to=1#seconds=0.1(args=[$id=1@stamp=1])]",
+		"[$parent=disappearance$objtype=op$from=1$to=1#seconds=0.1(args=[$id=1])]",
+		"[$parent=move$objtype=op$from=1(args=[$id=1$loc=1(pos=#0#0#0)(orientation=#0#0#0#1)(propel=#0#0#0)])]",
+		"[$parent=sight$objtype=op$from=1$to=1#seconds=0.1(args=[$parent=set$objtype=op$from=1$to=1#seconds=0.1"
+		"(args=[$id=1$name=name@stamp=1(modifiers=$1)(contains=$1)[attributes=[status=#1]]])])]",
+		"[$parent=sight$objtype=op$from=1$to=1#seconds=0.1@serialno=1@refno=1(args=[$parent=thing$objtype=obj$id=1$name=name"
+		"$loc=1@stamp=1$description=description$mode=planted(contains=$1)(children=$1)[geometry=$type=box](scale=#1#1#1)"
+		"#density=1#friction=1#mass=1#status=1@solid=1@planted=1[mode_data=$mode=planted$entity_ref=1]"
+		"(pos=#0#0#0)(orientation=#0#0#0#1)(velocity=#0#0#0)(angular=#0#0#0)(bbox=#0#0#0#1#1#1)])]",
+		"[$parent=sight$objtype=op$from=1$to=1#seconds=0.1(args=[$parent=move$objtype=op$from=1#seconds=0.1"
+		"(args=[$id=1$loc=1@stamp=1$mode=free(pos=#0#0#0)(orientation=#0#0#0#1)(velocity=#0#0#0)(angular=#0#0#0)])])]",
+};
+
+/**
+ * Encodes the common messages with the Binary codec.
+ * Each message is encoded by a new codec, so that all strings are written out in full,
+ * as they are the first time they're sent on a connection.
+ */
+std::string buildBinaryDictionary() {
+	std::string dictionary;
+	for (auto& message: COMMON_MESSAGES) {
+		std::istringstream packedStream(message);
+		std::istringstream binaryInStream;
+		std::ostringstream binaryStream;
+		//Nothing is decoded, so the codec can act as its own bridge.
+		Atlas::Codecs::Binary binary(binaryInStream, binaryStream, binary);
+		Atlas::Codecs::Packed packed(packedStream, binaryStream, binary);
+		packed.poll();
+		dictionary += binaryStream.str();
+	}
+	return dictionary;
+}
+}
+
+namespace Atlas::Filters {
+
+Deflate::Deflate(const std::string& codec, int level)
+		: m_incoming{}, m_outgoing{}, m_buf{}, m_dictionary(dictionary(codec)), m_level(level), m_begun(false) {
+}
+
+Deflate::~Deflate() {
+	end();
+}
+
+const std::string& Deflate::dictionary(const std::string& codec) {
+	if (codec == "Binary") {
+		static const std::string binaryDictionary = buildBinaryDictionary();
+		return binaryDictionary;
+	}
+	return TEXT_DICTIONARY;
+}
+
+void Deflate::begin() {
+	if (m_begun) {
+		return;
+	}
+	m_incoming.zalloc = Z_NULL;
+	m_incoming.zfree = Z_NULL;
+	m_incoming.next_in = Z_NULL;
+	m_incoming.avail_in = 0;
+
+	m_outgoing.zalloc = Z_NULL;
+	m_outgoing.zfree = Z_NULL;
+
+	if (inflateInit2(&m_incoming, WINDOW_BITS) != Z_OK) {
+		throw Atlas::Exception("Could not initialize inflate stream.");
+	}
+	if (deflateInit2(&m_outgoing, m_level, Z_DEFLATED, WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		inflateEnd(&m_incoming);
+		throw Atlas::Exception("Could not initialize deflate stream.");
+	}
+	//Raw streams have no header which signals that a dictionary is needed, so it's set upfront on both ends.
+	inflateSetDictionary(&m_incoming, reinterpret_cast<const Bytef*>(m_dictionary.data()), static_cast<uInt>(m_dictionary.size()));
+	deflateSetDictionary(&m_outgoing, reinterpret_cast<const Bytef*>(m_dictionary.data()), static_cast<uInt>(m_dictionary.size()));
+	m_begun = true;
+}
+
+void Deflate::end() {
+	if (m_begun) {
+		inflateEnd(&m_incoming);
+		deflateEnd(&m_outgoing);
+		m_begun = false;
+	}
+}
+
+std::string Deflate::encode(const std::string& data) {
+	std::string out_string;
+	if (data.empty()) {
+		return out_string;
+	}
+
+	m_outgoing.next_in = reinterpret_cast<z_const Bytef*>(data.data());
+	m_outgoing.avail_in = static_cast<uInt>(data.size());
+
+	do {
+		m_outgoing.next_out = m_buf.data();
+		m_outgoing.avail_out = static_cast<uInt>(m_buf.size());
+
+		//Flush each time, so that the other end can decode it right away.
+		auto status = deflate(&m_outgoing, Z_SYNC_FLUSH);
+		if (status != Z_OK && status != Z_BUF_ERROR) {
+			throw Atlas::Exception("Error when compressing data.");
+		}
+
+		out_string.append(reinterpret_cast<char*>(m_buf.data()), m_buf.size() - m_outgoing.avail_out);
+	} while (m_outgoing.avail_out == 0);
+
+	return out_string;
+}
+
+std::string Deflate::decode(const std::string& data) {
+	std::string out_string;
+	if (data.empty()) {
+		return out_string;
+	}
+
+	m_incoming.next_in = reinterpret_cast<z_const Bytef*>(data.data());
+	m_incoming.avail_in = static_cast<uInt>(data.size());
+
+	do {
+		m_incoming.next_out = m_buf.data();
+		m_incoming.avail_out = static_cast<uInt>(m_buf.size());
+
+		auto status = inflate(&m_incoming, Z_SYNC_FLUSH);
+		//Z_BUF_ERROR just means that no progress could be made, which happens when the input ends at a buffer boundary.
+		if (status != Z_OK && status != Z_BUF_ERROR && status != Z_STREAM_END) {
+			throw Atlas::Exception("Corrupt compressed data.");
+		}
+
+		out_string.append(reinterpret_cast<char*>(m_buf.data()), m_buf.size() - m_incoming.avail_out);
+	} while (m_incoming.avail_out == 0);
+
+	return out_string;
+}
+
+}
+// namespace Atlas::Filters
+
+#endif // HAVE_ZLIB_H && HAVE_LIBZ
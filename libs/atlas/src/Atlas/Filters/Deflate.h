@@ -0,0 +1,80 @@
+// This file may be redistributed and modified only under the terms of
+// the GNU Lesser General Public License (See COPYING for details).
+// Copyright (C) 2026 Erik Ogenvik
+
+#ifndef ATLAS_FILTERS_DEFLATE_H
+#define ATLAS_FILTERS_DEFLATE_H
+
+#include <Atlas/Filter.h>
+
+#include <zlib.h>
+#include <array>
+#include <string>
+
+
+namespace Atlas::Filters {
+
+/**
+ * Streaming compression suitable for interactive connections.
+ *
+ * Uses raw deflate without any headers or checksums, and flushes on each call to encode(),
+ * so that every chunk of data can be decoded as soon as it's received.
+ *
+ * Both ends are primed with the same dictionary of strings commonly found in Atlas traffic,
+ * which means that even the first, small messages on a connection compress well.
+ * The dictionary depends on the negotiated codec, since the Binary codec encodes messages
+ * very differently from the text codecs.
+ * The dictionaries must never change for a given name in the negotiation; if they need to be
+ * altered a new filter name must be used.
+ */
+class Deflate : public Filter {
+public:
+
+	/**
+	 * The name used during negotiation.
+	 */
+	static constexpr auto NAME = "Deflate";
+
+	/**
+	 * Low latency is more important than ratio, so use a low level by default.
+	 */
+	static constexpr int DEFAULT_LEVEL = 3;
+
+	/**
+	 * @param codec The name of the negotiated codec, which decides the dictionary.
+	 * @param level The compression level.
+	 */
+	explicit Deflate(const std::string& codec, int level = DEFAULT_LEVEL);
+
+	~Deflate() override;
+
+	void begin() override;
+
+	void end() override;
+
+	std::string encode(const std::string&) override;
+
+	/**
+	 * @throws Atlas::Exception if the data is corrupt.
+	 */
+	std::string decode(const std::string&) override;
+
+	/**
+	 * @param codec The name of the negotiated codec.
+	 * @return The dictionary which both ends use.
+	 */
+	static const std::string& dictionary(const std::string& codec);
+
+private:
+	z_stream m_incoming;
+	z_stream m_outgoing;
+	std::array<unsigned char, 4096> m_buf;
+	const std::string& m_dictionary;
+	int m_level;
+	bool m_begun;
+};
+
+}
+// namespace Atlas::Filters
+
+#endif // ATLAS_FILTERS_DEFLATE_H
@@ -15,6 +15,8 @@ class Bridge;
 
 class Codec;
 
+class Filter;
+
 /** Negotiation of codecs and filters for an Atlas connection
 
 non blocking negotiation of Codecs and Filters
@@ -40,6 +42,13 @@ public:
 
 	virtual std::unique_ptr<Codec> getCodec(Bridge&) = 0;
 
+	/**
+	 * @return A filter, such as compression, to apply to all data after negotiation, or null if none was negotiated.
+	 */
+	virtual std::unique_ptr<Filter> getFilter() {
+		return nullptr;
+	}
+
 	virtual void poll() = 0;
 };
 
@@ -7,8 +7,15 @@
 #include <Atlas/Net/Stream.h>
 
 #include <Atlas/Codecs/XML.h>
+#include <Atlas/Codecs/Binary.h>
 #include <Atlas/Codecs/Packed.h>
 #include <Atlas/Codecs/Bach.h>
+#include <Atlas/Filter.h>
+
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+#include <Atlas/Filters/Deflate.h>
+#define HAVE_DEFLATE
+#endif
 
 #include <iostream>
 #include <memory>
@@ -34,6 +41,18 @@ static inline std::string get_line(std::string& s1, char ch, std::string& s2) {
 	return s2;
 }
 
+#ifdef HAVE_DEFLATE
+/**
+ * @return The name of the codec which getCodec() picks, as the compression depends on it.
+ */
+static std::string get_codec_name(bool canBinary, bool canPacked, bool canXML) {
+	if (canBinary) { return "Binary"; }
+	if (canPacked) { return "Packed"; }
+	if (canXML) { return "XML"; }
+	return "Bach";
+}
+#endif
+
 namespace Atlas::Net {
 
 NegotiateHelper::NegotiateHelper(std::list<std::string>& names) :
@@ -62,9 +81,12 @@ bool NegotiateHelper::get(std::string& buf, const std::string& header) const {
 	return false;
 }
 
-void NegotiateHelper::put(std::string& buf, const std::string& header) {
+void NegotiateHelper::put(std::string& buf, const std::string& header, bool includeCompression) {
 	buf.erase();
 
+	buf += header;
+	buf += " Binary\n";
+
 	buf += header;
 	buf += " Packed\n";
 
@@ -80,13 +102,23 @@ void NegotiateHelper::put(std::string& buf, const std::string& header) {
 	buf += header;
 	buf += " Bzip2\n";
 
+#ifdef HAVE_DEFLATE
+	if (includeCompression) {
+		buf += header;
+		buf += " ";
+		buf += Atlas::Filters::Deflate::NAME;
+		buf += "\n";
+	}
+#endif
+
 	buf += "\n";
 }
 
-StreamConnect::StreamConnect(std::string name, std::istream& inStream, std::ostream& outStream) :
+StreamConnect::StreamConnect(std::string name, std::istream& inStream, std::ostream& outStream, bool allowCompression) :
 		m_state(SERVER_GREETING), m_outName(std::move(name)), m_inStream(inStream), m_outStream(outStream),
 		m_codecHelper(m_inCodecs), m_filterHelper(m_inFilters),
-		m_canPacked(true), m_canXML(true), m_canBach(true), m_canGzip(true), m_canBzip2(true) {
+		m_canBinary(false), m_canPacked(false), m_canXML(false), m_canBach(false), m_canGzip(false), m_canBzip2(false),
+		m_allowCompression(allowCompression), m_canDeflate(false) {
 }
 
 void StreamConnect::poll() {
@@ -118,7 +150,7 @@ void StreamConnect::poll() {
 	if (m_state == CLIENT_CODECS) {
 		std::string out;
 		//processClientCodecs();
-		m_codecHelper.put(out, "ICAN");
+		m_codecHelper.put(out, "ICAN", m_allowCompression);
 		m_outStream << out << std::flush;
 		m_state = SERVER_CODECS;
 	}
@@ -152,7 +184,7 @@ void StreamConnect::poll() {
 
 Atlas::Negotiate::State StreamConnect::getState() {
 	if (m_state == DONE) {
-		if (m_canPacked || m_canXML || m_canBach) {
+		if (m_canBinary || m_canPacked || m_canXML || m_canBach) {
 			return SUCCEEDED;
 		}
 	} else if (m_inStream || m_outStream) {
@@ -163,17 +195,34 @@ Atlas::Negotiate::State StreamConnect::getState() {
 
 /// FIXME We should pass in the Bridge here, not at construction time.
 std::unique_ptr<Atlas::Codec> StreamConnect::getCodec(Atlas::Bridge& bridge) {
+	if (m_canBinary) { return std::make_unique<Atlas::Codecs::Binary>(m_inStream, m_outStream, bridge); }
 	if (m_canPacked) { return std::make_unique<Atlas::Codecs::Packed>(m_inStream, m_outStream, bridge); }
 	if (m_canXML) { return std::make_unique<Atlas::Codecs::XML>(m_inStream, m_outStream, bridge); }
 	if (m_canBach) { return std::make_unique<Atlas::Codecs::Bach>(m_inStream, m_outStream, bridge); }
 	return {};
 }
 
+std::unique_ptr<Atlas::Filter> StreamConnect::getFilter() {
+#ifdef HAVE_DEFLATE
+	if (m_canDeflate) {
+		auto filter = std::make_unique<Atlas::Filters::Deflate>(get_codec_name(m_canBinary, m_canPacked, m_canXML));
+		filter->begin();
+		return filter;
+	}
+#endif
+	return {};
+}
+
 void StreamConnect::processServerCodecs() {
 	for (auto& codec: m_inCodecs) {
 		if (codec == "XML") { m_canXML = true; }
 		if (codec == "Packed") { m_canPacked = true; }
+		if (codec == "Binary") { m_canBinary = true; }
 		if (codec == "Bach") { m_canBach = true; }
+#ifdef HAVE_DEFLATE
+		//Filters are negotiated along with the codecs.
+		if (m_allowCompression && codec == Atlas::Filters::Deflate::NAME) { m_canDeflate = true; }
+#endif
 	}
 }
 
@@ -207,18 +256,21 @@ void StreamConnect::processClientFilters()
 #endif
 
 
-StreamAccept::StreamAccept(std::string name, std::istream& inStream, std::ostream& outStream) :
+StreamAccept::StreamAccept(std::string name, std::istream& inStream, std::ostream& outStream, bool allowCompression) :
 		m_state(SERVER_GREETING),
 		m_outName(std::move(name)),
 		m_inStream(inStream),
 		m_outStream(outStream),
 		m_codecHelper(m_inCodecs),
 		m_filterHelper(m_inFilters),
+		m_canBinary(false),
 		m_canPacked(false),
 		m_canXML(false),
 		m_canBach(false),
 		m_canGzip(false),
-		m_canBzip2(false) {
+		m_canBzip2(false),
+		m_allowCompression(allowCompression),
+		m_canDeflate(false) {
 }
 
 void StreamAccept::poll() {
@@ -256,9 +308,13 @@ void StreamAccept::poll() {
 	}
 
 	if (m_state == SERVER_CODECS) {
-		if (m_canPacked) { m_outStream << "IWILL Packed\n"; }
+		if (m_canBinary) { m_outStream << "IWILL Binary\n"; }
+		else if (m_canPacked) { m_outStream << "IWILL Packed\n"; }
 		else if (m_canXML) { m_outStream << "IWILL XML\n"; }
 		else if (m_canBach) { m_outStream << "IWILL Bach\n"; }
+#ifdef HAVE_DEFLATE
+		if (m_canDeflate) { m_outStream << "IWILL " << Atlas::Filters::Deflate::NAME << "\n"; }
+#endif
 		m_outStream << std::endl;
 
 		m_state = DONE;
@@ -287,7 +343,7 @@ void StreamAccept::poll() {
 
 Atlas::Negotiate::State StreamAccept::getState() {
 	if (m_state == DONE) {
-		if (m_canPacked || m_canXML || m_canBach) {
+		if (m_canBinary || m_canPacked || m_canXML || m_canBach) {
 			return SUCCEEDED;
 		}
 
@@ -308,12 +364,24 @@ std::unique_ptr<Atlas::Codec> StreamAccept::getCodec(Atlas::Bridge& bridge) {
 	// would deallocate? erk. -- sdt 2001-01-05
 	//return (*outCodecs.begin())->
 	//New(Codec<std::iostream>::Parameters(m_socket,bridge));
+	if (m_canBinary) { return std::make_unique<Atlas::Codecs::Binary>(m_inStream, m_outStream, bridge); }
 	if (m_canPacked) { return std::make_unique<Atlas::Codecs::Packed>(m_inStream, m_outStream, bridge); }
 	if (m_canXML) { return std::make_unique<Atlas::Codecs::XML>(m_inStream, m_outStream, bridge); }
 	if (m_canBach) { return std::make_unique<Atlas::Codecs::Bach>(m_inStream, m_outStream, bridge); }
 	return nullptr;
 }
 
+std::unique_ptr<Atlas::Filter> StreamAccept::getFilter() {
+#ifdef HAVE_DEFLATE
+	if (m_canDeflate) {
+		auto filter = std::make_unique<Atlas::Filters::Deflate>(get_codec_name(m_canBinary, m_canPacked, m_canXML));
+		filter->begin();
+		return filter;
+	}
+#endif
+	return nullptr;
+}
+
 #if 0
 void StreamAccept::processServerCodecs()
 {
@@ -359,7 +427,12 @@ void StreamAccept::processClientCodecs() {
 	for (auto& codec: m_inCodecs) {
 		if (codec == "XML") { m_canXML = true; }
 		if (codec == "Packed") { m_canPacked = true; }
+		if (codec == "Binary") { m_canBinary = true; }
 		if (codec == "Bach") { m_canBach = true; }
+#ifdef HAVE_DEFLATE
+		//Filters are negotiated along with the codecs.
+		if (m_allowCompression && codec == Atlas::Filters::Deflate::NAME) { m_canDeflate = true; }
+#endif
 	}
 }
 
@@ -41,7 +41,10 @@ public:
 
 	bool get(std::string& buf, const std::string& header) const;
 
-	void put(std::string& buf, const std::string& header);
+	/**
+	 * @param includeCompression True if compression filters should be included.
+	 */
+	void put(std::string& buf, const std::string& header, bool includeCompression = false);
 
 private:
 
@@ -59,7 +62,11 @@ private:
 class StreamConnect : public Atlas::Negotiate {
 public:
 
-	StreamConnect(std::string name, std::istream& inStream, std::ostream& outStream);
+	/**
+	 * @param allowCompression True if compression should be used if the other end supports it.
+	 * The owner must then insert the filter returned by getFilter() once negotiation is done.
+	 */
+	StreamConnect(std::string name, std::istream& inStream, std::ostream& outStream, bool allowCompression = false);
 
 	~StreamConnect() override = default;
 
@@ -69,6 +76,8 @@ public:
 
 	std::unique_ptr<Atlas::Codec> getCodec(Atlas::Bridge&) override;
 
+	std::unique_ptr<Atlas::Filter> getFilter() override;
+
 private:
 
 	enum {
@@ -101,12 +110,16 @@ private:
 	//void processClientCodecs();
 	//void processClientFilters();
 
+	bool m_canBinary;
 	bool m_canPacked;
 	bool m_canXML;
 	bool m_canBach;
 
 	bool m_canGzip;
 	bool m_canBzip2;
+
+	bool m_allowCompression;
+	bool m_canDeflate;
 };
 
 /// Negotiation of servers accepting a connection from a remote system.
@@ -120,7 +133,11 @@ private:
 class StreamAccept : public Atlas::Negotiate {
 public:
 
-	StreamAccept(std::string name, std::istream& inStream, std::ostream& outStream);
+	/**
+	 * @param allowCompression True if compression should be used if the other end supports it.
+	 * The owner must then insert the filter returned by getFilter() once negotiation is done.
+	 */
+	StreamAccept(std::string name, std::istream& inStream, std::ostream& outStream, bool allowCompression = false);
 
 	~StreamAccept() override = default;
 
@@ -130,6 +147,8 @@ public:
 
 	std::unique_ptr<Atlas::Codec> getCodec(Atlas::Bridge&) override;
 
+	std::unique_ptr<Atlas::Filter> getFilter() override;
+
 private:
 
 	enum {
@@ -162,12 +181,16 @@ private:
 
 	void processClientFilters();
 
+	bool m_canBinary;
 	bool m_canPacked;
 	bool m_canXML;
 	bool m_canBach;
 
 	bool m_canGzip;
 	bool m_canBzip2;
+
+	bool m_allowCompression;
+	bool m_canDeflate;
 };
 
 }
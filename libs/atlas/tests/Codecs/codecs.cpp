@@ -22,6 +22,7 @@
 #include <Atlas/Codecs/XML.h>
 #include <Atlas/Codecs/Bach.h>
 #include <Atlas/Codecs/Packed.h>
+#include <Atlas/Codecs/Binary.h>
 
 #include <sstream>
 #include <string>
@@ -205,6 +206,44 @@ void testPackedSanity() {
 	assert(map2["validfloat"].Float() == 6.0);
 }
 
+void testBinaryDictionary() {
+	MapType map;
+	map["parent"] = "move";
+	map["objtype"] = "op";
+	map["id"] = 17;
+	map["args"] = ListType{MapType{{"parent", "move"}, {"pos", ListType{1.5, -2.0, 3.25}}, {"parent2", "move"}}};
+
+	std::stringstream out;
+	{
+		Atlas::Message::QueuedDecoder decoder;
+		Atlas::Codecs::Binary codec(out, out, decoder);
+		Atlas::Message::Encoder encoder(codec);
+		encoder.streamBegin();
+		encoder.streamMessageElement(map);
+		auto firstSize = out.str().size();
+		encoder.streamMessageElement(map);
+		//The second message should only use references for names and dictionary values.
+		assert(out.str().size() - firstSize < firstSize);
+		encoder.streamEnd();
+	}
+
+	//Feed the data one byte at a time, to make sure that partial elements are handled.
+	std::string atlas_data = out.str();
+	std::stringstream in;
+	Atlas::Message::QueuedDecoder decoder;
+	Atlas::Codecs::Binary codec(in, in, decoder);
+	decoder.streamBegin();
+	for (auto c: atlas_data) {
+		in.clear();
+		in.put(c);
+		codec.poll();
+	}
+	decoder.streamEnd();
+
+	assert(decoder.queueSize() == 2);
+	assert(decoder.popMessage() == map);
+	assert(decoder.popMessage() == map);
+}
 
 int main(int argc, char** argv) {
 	testXMLEscaping();
@@ -212,6 +251,8 @@ int main(int argc, char** argv) {
 //    testCodec<Atlas::Codecs::Bach>();
 	testCodec<Atlas::Codecs::Packed>();
 	testCodec<Atlas::Codecs::XML>();
+	testCodec<Atlas::Codecs::Binary>();
+	testBinaryDictionary();
 	testPackedSanity();
 	testXMLSanity();
 	//Bach is problematic and disabled for now. We should look into using JSON instead.
@@ -0,0 +1,158 @@
+/*
+ Copyright (C) 2026 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <Atlas/Net/Stream.h>
+#include <Atlas/Codec.h>
+#include <Atlas/Filter.h>
+#include <Atlas/Codecs/Binary.h>
+#include <Atlas/Filters/Deflate.h>
+#include <Atlas/Message/Element.h>
+#include <Atlas/Message/MEncoder.h>
+#include <Atlas/Message/QueuedDecoder.h>
+
+#include <sstream>
+#include <string>
+#include <cassert>
+#include <iostream>
+
+using namespace Atlas::Message;
+
+namespace {
+
+struct Connection {
+	std::stringstream clientToServer;
+	std::stringstream serverToClient;
+	std::istream serverIn{clientToServer.rdbuf()};
+	std::ostream serverOut{serverToClient.rdbuf()};
+	std::istream clientIn{serverToClient.rdbuf()};
+	std::ostream clientOut{clientToServer.rdbuf()};
+};
+
+void negotiate(Atlas::Negotiate& client, Atlas::Negotiate& server) {
+	for (int i = 0; i < 10; ++i) {
+		server.poll();
+		client.poll();
+		if (client.getState() != Atlas::Negotiate::IN_PROGRESS && server.getState() != Atlas::Negotiate::IN_PROGRESS) {
+			break;
+		}
+	}
+	assert(client.getState() == Atlas::Negotiate::SUCCEEDED);
+	assert(server.getState() == Atlas::Negotiate::SUCCEEDED);
+}
+
+MapType createMessage(int serialno) {
+	return {{"parent",   "sight"},
+			{"objtype",  "op"},
+			{"serialno", serialno},
+			{"args",     ListType{MapType{{"parent",   "move"},
+										  {"objtype",  "op"},
+										  {"args",     ListType{MapType{{"id",  "1234"},
+																		{"pos", ListType{1.5, 2.0, -3.25}}}}}}}}};
+}
+
+void testUncompressed() {
+	Connection connection;
+	Atlas::Net::StreamConnect client("client", connection.clientIn, connection.clientOut);
+	Atlas::Net::StreamAccept server("server", connection.serverIn, connection.serverOut, true);
+	negotiate(client, server);
+
+	//Neither side should use compression unless both want it.
+	assert(!client.getFilter());
+	assert(!server.getFilter());
+}
+
+void testCompressed() {
+	Connection connection;
+	Atlas::Net::StreamConnect client("client", connection.clientIn, connection.clientOut, true);
+	Atlas::Net::StreamAccept server("server", connection.serverIn, connection.serverOut, true);
+	negotiate(client, server);
+
+	auto clientFilter = client.getFilter();
+	auto serverFilter = server.getFilter();
+	assert(clientFilter);
+	assert(serverFilter);
+
+	//Insert the filter between the streams and the underlying buffers, the same way a client would.
+	Atlas::filterbuf clientInBuffer(*connection.serverToClient.rdbuf(), *clientFilter);
+	Atlas::filterbuf clientOutBuffer(*connection.clientToServer.rdbuf(), *clientFilter);
+	Atlas::filterbuf serverInBuffer(*connection.clientToServer.rdbuf(), *serverFilter);
+	Atlas::filterbuf serverOutBuffer(*connection.serverToClient.rdbuf(), *serverFilter);
+	connection.clientIn.rdbuf(&clientInBuffer);
+	connection.clientOut.rdbuf(&clientOutBuffer);
+	connection.serverIn.rdbuf(&serverInBuffer);
+	connection.serverOut.rdbuf(&serverOutBuffer);
+
+	QueuedDecoder clientDecoder;
+	QueuedDecoder serverDecoder;
+	auto clientCodec = client.getCodec(clientDecoder);
+	auto serverCodec = server.getCodec(serverDecoder);
+	Encoder clientEncoder(*clientCodec);
+	Encoder serverEncoder(*serverCodec);
+	clientCodec->streamBegin();
+	serverCodec->streamBegin();
+	clientDecoder.streamBegin();
+	serverDecoder.streamBegin();
+
+	for (int i = 0; i < 100; ++i) {
+		serverEncoder.streamMessageElement(createMessage(i));
+		connection.serverOut.flush();
+		clientCodec->poll();
+		assert(clientDecoder.queueSize() == 1);
+		assert(clientDecoder.popMessage() == createMessage(i));
+
+		clientEncoder.streamMessageElement(createMessage(i));
+		connection.clientOut.flush();
+		serverCodec->poll();
+		assert(serverDecoder.queueSize() == 1);
+		assert(serverDecoder.popMessage() == createMessage(i));
+	}
+
+	auto& statistics = serverOutBuffer.getOutStatistics();
+	std::cout << "Compressed " << statistics.unfilteredBytes << " bytes to " << statistics.filteredBytes << " bytes." << std::endl;
+	assert(statistics.filteredBytes < statistics.unfilteredBytes / 2);
+	assert(clientInBuffer.getInStatistics().filteredBytes == statistics.filteredBytes);
+	assert(clientInBuffer.getInStatistics().unfilteredBytes == statistics.unfilteredBytes);
+}
+
+void testDictionary() {
+	std::stringstream binaryStream;
+	QueuedDecoder decoder;
+	Atlas::Codecs::Binary codec(binaryStream, binaryStream, decoder);
+	Encoder encoder(codec);
+	encoder.streamMessageElement(createMessage(1));
+	auto message = binaryStream.str();
+
+	//The first message on a Binary connection should compress better with the dictionary made for it than with the text one.
+	Atlas::Filters::Deflate binaryDeflate("Binary");
+	Atlas::Filters::Deflate textDeflate("Packed");
+	binaryDeflate.begin();
+	textDeflate.begin();
+	auto binaryCompressed = binaryDeflate.encode(message);
+	auto textCompressed = textDeflate.encode(message);
+	std::cout << "Compressed first message of " << message.size() << " bytes to " << binaryCompressed.size()
+			  << " bytes, and " << textCompressed.size() << " bytes with the text dictionary." << std::endl;
+	assert(binaryCompressed.size() < textCompressed.size());
+	assert(binaryDeflate.decode(binaryCompressed) == message);
+}
+}
+
+int main(int argc, char** argv) {
+	testUncompressed();
+	testCompressed();
+	testDictionary();
+}
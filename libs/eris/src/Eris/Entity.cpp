@@ -100,7 +100,15 @@ void Entity::handleOperation(const Atlas::Objects::Operation::RootOperation& op,
 								logger->error("Got Sight.Set op without inner id.");
 							} else {
 								if (setEntity->getId() == getId()) {
-									setFromRoot(setEntity);
+									//Only take the stamp if it directly follows the one we know; otherwise we've missed
+									//an update, and keep the old stamp so that the next Look asks for everything since.
+									if (!setEntity->isDefaultStamp() && static_cast<long>(setEntity->getStamp()) != m_stamp.count() + 1) {
+										auto unstamped = setEntity.copy();
+										unstamped->removeAttr("stamp");
+										setFromRoot(unstamped);
+									} else {
+										setFromRoot(setEntity);
+									}
 								} else {
 									logger->error("Got Sight.Set op with inner id of {} which doesn't matter the Sight:From value of {}.", arg->getId(), op->getFrom());
 								}
@@ -366,6 +374,19 @@ void Entity::setFromRoot(const Root& obj, bool includeTypeInfoProperties) {
 	properties.erase("id"); //Id can't be changed once it's initially set, which it's at Entity creation time.
 	properties.erase("contains"); //Contains are handled by the setContentsFromAtlas method which should be called separately.
 
+	//A delta reply to a Look lists the properties which have been removed since the version we knew.
+	auto removedI = properties.find("removed_properties");
+	if (removedI != properties.end()) {
+		if (removedI->second.isList()) {
+			for (auto& removed: removedI->second.List()) {
+				if (removed.isString()) {
+					removeProperty(removed.String());
+				}
+			}
+		}
+		properties.erase(removedI);
+	}
+
 	for (auto& entry: properties) {
 		// see if the value in the sight matches the existing value
 		auto I = m_properties.find(entry.first);
@@ -470,6 +491,33 @@ void Entity::setProperty(const std::string& p, const Element& v) {
 	endUpdate();
 }
 
+void Entity::removeProperty(const std::string& p) {
+	auto I = m_properties.find(p);
+	if (I == m_properties.end()) {
+		return;
+	}
+	m_properties.erase(I);
+
+	beginUpdate();
+	//Fall back to the value of the type, if there is one.
+	auto typeValue = ptrOfProperty(p);
+	Element v = typeValue ? *typeValue : Element();
+	try {
+		nativePropertyChanged(p, v);
+	} catch (const std::exception& ex) {
+		logger->warn("Error when removing property '{}'. Message: {}", p, ex.what());
+	}
+	onPropertyChanged(p, v);
+
+	auto obs = m_observers.find(p);
+	if (obs != m_observers.end()) {
+		obs->second.emit(v);
+	}
+
+	addToUpdate(p);
+	endUpdate();
+}
+
 bool Entity::nativePropertyChanged(const std::string& p, const Element& v) {
 	// in the future, hash these names to a compile-time integer index, and
 	// make this a switch statement. The same index could also be used
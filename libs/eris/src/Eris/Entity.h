@@ -494,6 +494,12 @@ protected:
 
 	void setProperty(const std::string& p, const Atlas::Message::Element& v);
 
+	/**
+	 * @brief Removes an instance property, falling back to the value of the type if there is one.
+	 * @param p The name of the property.
+	 */
+	void removeProperty(const std::string& p);
+
 	/**
 	Map Atlas properties to natively stored properties. Should be changed to
 	use an integer hash in the future, since this called frequently.
@@ -41,7 +41,8 @@ StreamSocket::StreamSocket(io_context& io_service,
 		mOutStream(mWriteBuffer.get()),
 		mShouldSend(false),
 		mIsSending(false),
-		_sc(std::make_unique<Atlas::Net::StreamConnect>(client_name, mInStream, mOutStream)),
+		//The server decides whether compression is used.
+		_sc(std::make_unique<Atlas::Net::StreamConnect>(client_name, mInStream, mOutStream, true)),
 		_negotiateTimer(io_service),
 		_connectTimer(io_service),
 		m_codec(nullptr),
@@ -49,7 +50,14 @@ StreamSocket::StreamSocket(io_context& io_service,
 		m_is_connected(false) {
 }
 
-StreamSocket::~StreamSocket() = default;
+StreamSocket::~StreamSocket() {
+	if (m_outFilterBuffer) {
+		auto& in = m_inFilterBuffer->getInStatistics();
+		auto& out = m_outFilterBuffer->getOutStatistics();
+		logger->debug("Filtered traffic: received {} bytes as {} bytes, sent {} bytes as {} bytes.",
+					  in.unfilteredBytes, in.filteredBytes, out.unfilteredBytes, out.filteredBytes);
+	}
+}
 
 void StreamSocket::detach() {
 	_callbacks = Callbacks();
@@ -96,6 +104,7 @@ Atlas::Negotiate::State StreamSocket::negotiate() {
 
 	// Get the codec that negotiation established
 	m_codec = _sc->getCodec(_bridge);
+	m_filter = _sc->getFilter();
 
 	// Acceptor is now finished with
 	_sc.reset();
@@ -104,6 +113,14 @@ Atlas::Negotiate::State StreamSocket::negotiate() {
 		logger->error("Could not create codec during negotiation.");
 		return Atlas::Negotiate::FAILED;
 	}
+	if (m_filter) {
+		// Everything after the negotiation passes through the filter.
+		m_inFilterBuffer = std::make_unique<Atlas::filterbuf>(mReadBuffer, *m_filter);
+		m_outFilterBuffer = std::make_unique<Atlas::filterbuf>(*mWriteBuffer, *m_filter);
+		mInStream.rdbuf(m_inFilterBuffer.get());
+		mOutStream.rdbuf(m_outFilterBuffer.get());
+	}
+
 	// Create a new encoder to send high level objects to the codec
 	m_encoder = std::make_unique<Atlas::Objects::ObjectsEncoder>(*m_codec);
 
@@ -125,4 +142,12 @@ Atlas::Objects::ObjectsEncoder& StreamSocket::getEncoder() {
 	return *m_encoder;
 }
 
+const Atlas::filterbuf::Statistics* StreamSocket::getFilterInStatistics() const {
+	return m_inFilterBuffer ? &m_inFilterBuffer->getInStatistics() : nullptr;
+}
+
+const Atlas::filterbuf::Statistics* StreamSocket::getFilterOutStatistics() const {
+	return m_outFilterBuffer ? &m_outFilterBuffer->getOutStatistics() : nullptr;
+}
+
 }
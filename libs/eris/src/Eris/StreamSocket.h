@@ -21,6 +21,7 @@
 
 #include <Atlas/Objects/ObjectsFwd.h>
 #include <Atlas/Negotiate.h>
+#include <Atlas/Filter.h>
 
 #include <boost/asio.hpp>
 #include <boost/asio/steady_timer.hpp>
@@ -113,6 +114,18 @@ public:
 	 */
 	virtual void write() = 0;
 
+	/**
+	 * @brief Gets statistics for incoming data passing through the negotiated filter, such as compression.
+	 * @return Null if no filter is used.
+	 */
+	const Atlas::filterbuf::Statistics* getFilterInStatistics() const;
+
+	/**
+	 * @brief Gets statistics for outgoing data passing through the negotiated filter, such as compression.
+	 * @return Null if no filter is used.
+	 */
+	const Atlas::filterbuf::Statistics* getFilterOutStatistics() const;
+
 protected:
 	enum {
 		read_buffer_size = 2048
@@ -157,6 +170,9 @@ protected:
 	 */
 	bool mIsSending;
 
+	std::unique_ptr<Atlas::Filter> m_filter; ///< filter negotiated for all traffic, null if none
+	std::unique_ptr<Atlas::filterbuf> m_inFilterBuffer; ///< decodes mReadBuffer through m_filter, if set
+	std::unique_ptr<Atlas::filterbuf> m_outFilterBuffer; ///< encodes through m_filter into mWriteBuffer, if set
 	std::unique_ptr<Atlas::Net::StreamConnect> _sc; ///< negotiation object (nullptr after connection!)
 	boost::asio::steady_timer _negotiateTimer;
 	boost::asio::steady_timer _connectTimer;
@@ -160,7 +160,13 @@ void AsioStreamSocket<ProtocolT>::do_read() {
 								 if (_callbacks.stateChanged) {
 									 if (!ec) {
 										 mReadBuffer.commit(length);
-										 m_codec->poll();
+										 try {
+											 m_codec->poll();
+										 } catch (const std::exception& e) {
+											 logger->warn("Error when decoding data from socket: {}", e.what());
+											 _callbacks.stateChanged(CONNECTION_FAILED);
+											 return;
+										 }
 										 _callbacks.dispatch();
 										 this->do_read();
 									 } else {
@@ -176,6 +182,10 @@ void AsioStreamSocket<ProtocolT>::do_read() {
 
 template<typename ProtocolT>
 void AsioStreamSocket<ProtocolT>::write() {
+	if (m_outFilterBuffer) {
+		//The filter holds on to any data until flushed.
+		mOutStream.flush();
+	}
 	if (mWriteBuffer->size() != 0) {
 		if (mIsSending) {
 			//We're already sending in the background.
@@ -190,7 +200,11 @@ void AsioStreamSocket<ProtocolT>::write() {
 		auto self(this->shared_from_this());
 		//Swap places between writing buffer and sending buffer, and attach new write buffer to the out stream.
 		std::swap(mWriteBuffer, mSendBuffer);
-		mOutStream.rdbuf(mWriteBuffer.get());
+		if (m_outFilterBuffer) {
+			m_outFilterBuffer->setStreamBuffer(*mWriteBuffer);
+		} else {
+			mOutStream.rdbuf(mWriteBuffer.get());
+		}
 		mIsSending = true;
 
 		async_write(m_socket, mSendBuffer->data(),
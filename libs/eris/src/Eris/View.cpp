@@ -12,6 +12,7 @@
 
 #include <Atlas/Objects/Entity.h>
 #include <Atlas/Objects/Operation.h>
+#include <algorithm>
 
 using namespace Atlas::Objects::Operation;
 using Atlas::Objects::Root;
@@ -287,13 +288,49 @@ void View::appear(const std::string& eid, std::chrono::milliseconds stamp) {
 void View::disappear(const std::string& eid) {
 	auto* ent = getEntity(eid);
 	if (ent) {
+		if (ent->getStamp().count() >= 0) {
+			forgetDisappeared(eid);
+			m_disappearedOrder.push_back(eid);
+			m_disappeared.emplace(eid, DisappearedEntry{ent->getInstanceProperties(), ent->getStamp(), std::prev(m_disappearedOrder.end())});
+			if (m_disappeared.size() > MaxDisappearedEntities) {
+				forgetDisappeared(m_disappearedOrder.front());
+			}
+		}
 		deleteEntity(eid);
 	}
 }
 
+void View::forgetDisappeared(const std::string& eid) {
+	auto I = m_disappeared.find(eid);
+	if (I != m_disappeared.end()) {
+		m_disappearedOrder.erase(I->second.orderIterator);
+		m_disappeared.erase(I);
+	}
+}
 
-Entity* View::initialSight(const RootEntity& gent) {
-	assert(m_contents.count(gent->getId()) == 0);
+
+Entity* View::initialSight(const RootEntity& sight) {
+	assert(m_contents.count(sight->getId()) == 0);
+
+	auto gent = sight;
+	auto disappearedI = m_disappeared.find(sight->getId());
+	if (disappearedI != m_disappeared.end()) {
+		//If the server replied with what's changed since the version we remembered, fill in the rest from that version.
+		Element removed;
+		if (sight->copyAttr("removed_properties", removed) == 0 && removed.isList()) {
+			gent = sight.copy();
+			for (auto& entry: disappearedI->second.properties) {
+				if (entry.first == "id" || gent->hasAttr(entry.first)) {
+					continue;
+				}
+				if (std::find(removed.List().begin(), removed.List().end(), Element(entry.first)) != removed.List().end()) {
+					continue;
+				}
+				gent->setAttr(entry.first, entry.second);
+			}
+		}
+		forgetDisappeared(sight->getId());
+	}
 
 	auto entity = createEntity(gent);
 
@@ -384,6 +421,7 @@ void View::unseen(const std::string& eid) {
 	//This op is received when we tried to interact with something we can't observe anymore (either because it's deleted
 	// or because it's out of sight).
 	deleteEntity(eid);
+	forgetDisappeared(eid);
 	//Remove any pending status.
 	m_pending.erase(eid);
 }
@@ -448,6 +486,16 @@ void View::sendLookAt(const std::string& eid) {
 		// pending map is in the right state, build up the args now
 		Root what;
 		what->setId(eid);
+		// if we already know about a version of the entity, tell the server so that we only get what's changed since
+		auto ent = getEntity(eid);
+		if (ent && ent->getStamp().count() >= 0) {
+			what->setStamp((double) ent->getStamp().count());
+		} else if (!ent) {
+			auto disappearedI = m_disappeared.find(eid);
+			if (disappearedI != m_disappeared.end()) {
+				what->setStamp((double) disappearedI->second.stamp.count());
+			}
+		}
 		look->setArgs1(what);
 	}
 
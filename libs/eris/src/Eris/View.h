@@ -17,6 +17,7 @@
 // std
 #include <string>
 #include <deque>
+#include <list>
 #include <map>
 #include <set>
 #include <unordered_map>
@@ -181,6 +182,11 @@ protected:
 
 	void unseen(const std::string& eid);
 
+	/**
+	 * Forgets the last known version of a disappeared entity, if any.
+	 */
+	void forgetDisappeared(const std::string& eid);
+
 	/// test if the specified entity ID is pending initial sight on the View
 	bool isPending(const std::string& eid) const;
 
@@ -252,6 +258,29 @@ private:
 
 	std::map<std::string, PendingStatus> m_pending;
 
+	/**
+	 * The last known version of an entity which has disappeared from view.
+	 * When it reappears we send its stamp in the Look, and fill in the properties the server
+	 * then leaves out of its reply because they haven't changed.
+	 */
+	struct DisappearedEntry {
+		Atlas::Message::MapType properties;
+		std::chrono::milliseconds stamp;
+		std::list<std::string>::iterator orderIterator;
+	};
+
+	/**
+	 * The max number of disappeared entities we remember; the ones that disappeared first are forgotten first.
+	 */
+	static constexpr std::size_t MaxDisappearedEntities = 256;
+
+	std::unordered_map<std::string, DisappearedEntry> m_disappeared;
+
+	/**
+	 * Ids of the disappeared entities, oldest first.
+	 */
+	std::list<std::string> m_disappearedOrder;
+
 	struct TypeDelayedEntry {
 		std::vector<Atlas::Objects::Operation::RootOperation> operations;
 		/**
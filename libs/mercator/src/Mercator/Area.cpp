@@ -228,12 +228,15 @@ WFMath::Polygon<2> Area::clipToSegment(const Segment& s) const {
 	// box reject
 	if (!checkIntersects(s)) return WFMath::Polygon<2>();
 
-	WFMath::AxisBox<2> segBox(s.getRect());
-	WFMath::Polygon<2> clipped = sutherlandHodgmanKernel(m_shape, TopClip(segBox.lowCorner().y()));
+	return clipToBox(s.getRect());
+}
+
+WFMath::Polygon<2> Area::clipToBox(const WFMath::AxisBox<2>& box) const {
+	WFMath::Polygon<2> clipped = sutherlandHodgmanKernel(m_shape, TopClip(box.lowCorner().y()));
 
-	clipped = sutherlandHodgmanKernel(clipped, BottomClip(segBox.highCorner().y()));
-	clipped = sutherlandHodgmanKernel(clipped, LeftClip(segBox.lowCorner().x()));
-	clipped = sutherlandHodgmanKernel(clipped, RightClip(segBox.highCorner().x()));
+	clipped = sutherlandHodgmanKernel(clipped, BottomClip(box.highCorner().y()));
+	clipped = sutherlandHodgmanKernel(clipped, LeftClip(box.lowCorner().x()));
+	clipped = sutherlandHodgmanKernel(clipped, RightClip(box.highCorner().x()));
 
 	return clipped;
 }
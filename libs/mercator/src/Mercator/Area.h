@@ -68,6 +68,12 @@ public:
 	/// @returns the shape of the intersection of this area with the segment.
 	WFMath::Polygon<2> clipToSegment(const Segment& s) const;
 
+	/// \brief Clip the shape of this area to an axis aligned box.
+	///
+	/// @param box the box that the shape should be clipped to.
+	/// @returns the shape of the intersection of this area with the box.
+	WFMath::Polygon<2> clipToBox(const WFMath::AxisBox<2>& box) const;
+
 private:
 
 	/// The layer number.
@@ -202,11 +202,26 @@ bool AreaShader::checkIntersect(const Segment& s) const {
 }
 
 void AreaShader::shade(Surface& s) const {
-	ColorT* data = s.getData();
+	int max = static_cast<int>(s.getSize()) - 1;
+	shadeRegion(s, {0, 0, max, max});
+}
+
+void AreaShader::shadeRegion(Surface& s, const SurfaceRegion& region) const {
 	unsigned int size = s.getSegment().getSize();
+	ColorT* data = s.getData();
 
-	unsigned int buflen = size * size;
-	for (unsigned int i = 0; i < buflen; ++i) data[i] = 0;
+	for (int z = region.lz; z <= region.hz; ++z) {
+		std::fill(data + z * size + region.lx, data + z * size + region.hx + 1, 0);
+	}
+
+	// Each point covers the half unit around it, so clip the areas to the
+	// edges of the outermost points in the region, without going outside
+	// the segment.
+	auto res = static_cast<WFMath::CoordType>(s.getSegment().getResolution());
+	Point2 segOrigin = s.m_segment.getRect().lowCorner();
+	WFMath::CoordType half = 0.5f, zero = 0;
+	WFMath::AxisBox<2> box(segOrigin + Vector2(std::max(region.lx - half, zero), std::max(region.lz - half, zero)),
+						   segOrigin + Vector2(std::min(region.hx + half, res), std::min(region.hz + half, res)));
 
 	auto& areas = s.m_segment.getAreas();
 	auto it = areas.lower_bound(m_layer);
@@ -217,12 +232,14 @@ void AreaShader::shade(Surface& s) const {
 		if (it->second.area->isHole()) {
 			//TODO: shadeHole
 		} else
-			shadeArea(s, *it->second.area);
+			shadeArea(s, *it->second.area, box);
 	} // of areas in layer
 }
 
-void AreaShader::shadeArea(Surface& s, const Area& ar) {
-	WFMath::Polygon<2> clipped = ar.clipToSegment(s.m_segment);
+void AreaShader::shadeArea(Surface& s, const Area& ar, const WFMath::AxisBox<2>& box) {
+	if (!ar.checkIntersects(s.m_segment)) return;
+
+	WFMath::Polygon<2> clipped = ar.clipToBox(box);
 	assert(clipped.isValid());
 
 	if (clipped.numCorners() == 0) return;
@@ -7,6 +7,8 @@
 
 #include "Shader.h"
 
+#include <wfmath/axisbox.h>
+
 namespace Mercator {
 
 class Area;
@@ -21,11 +23,13 @@ public:
 
 	void shade(Surface& s) const override;
 
+	void shadeRegion(Surface& s, const SurfaceRegion& region) const override;
+
 	bool checkIntersect(const Segment&) const override;
 
 private:
-	/// helper to shader a single area into the surface
-	static void shadeArea(Surface& s, const Area& ar) ;
+	/// helper to shader the part of a single area within a box into the surface
+	static void shadeArea(Surface& s, const Area& ar, const WFMath::AxisBox<2>& box) ;
 
 	/// The layer number.
 	int m_layer;
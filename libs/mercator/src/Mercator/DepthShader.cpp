@@ -50,6 +50,11 @@ bool DepthShader::checkIntersect(const Segment& s) const {
 }
 
 void DepthShader::shade(Surface& s) const {
+	int max = static_cast<int>(s.getSize()) - 1;
+	shadeRegion(s, {0, 0, max, max});
+}
+
+void DepthShader::shadeRegion(Surface& s, const SurfaceRegion& region) const {
 	unsigned int channels = s.getChannels();
 	assert(channels > 0);
 	unsigned int colors = channels - 1;
@@ -62,20 +67,22 @@ void DepthShader::shade(Surface& s) const {
 	}
 	unsigned int size = s.getSegment().getSize();
 
-	unsigned int count = size * size;
-	int j = -1;
-	for (unsigned int i = 0; i < count; ++i) {
-		for (unsigned int k = 0; k < colors; ++k) {
-			data[++j] = colorMax;
-		}
-		float depth = height_data[i];
-		if (depth > m_waterLevel) {
-			data[++j] = colorMin;
-		} else if (depth < m_murkyDepth) {
-			data[++j] = colorMax;
-		} else {
-			data[++j] = colorMax - I_ROUND(colorMax * ((depth - m_murkyDepth)
-													   / (m_waterLevel - m_murkyDepth)));
+	for (int z = region.lz; z <= region.hz; ++z) {
+		for (int x = region.lx; x <= region.hx; ++x) {
+			unsigned int i = z * size + x;
+			int j = static_cast<int>(i * channels) - 1;
+			for (unsigned int k = 0; k < colors; ++k) {
+				data[++j] = colorMax;
+			}
+			float depth = height_data[i];
+			if (depth > m_waterLevel) {
+				data[++j] = colorMin;
+			} else if (depth < m_murkyDepth) {
+				data[++j] = colorMax;
+			} else {
+				data[++j] = colorMax - I_ROUND(colorMax * ((depth - m_murkyDepth)
+														   / (m_waterLevel - m_murkyDepth)));
+			}
 		}
 	}
 }
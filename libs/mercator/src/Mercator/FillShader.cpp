@@ -7,6 +7,8 @@
 #include "Segment.h"
 #include "Surface.h"
 
+#include <algorithm>
+
 namespace Mercator {
 
 FillShader::FillShader() = default;
@@ -31,4 +33,15 @@ void FillShader::shade(Surface& s) const {
 	}
 }
 
+void FillShader::shadeRegion(Surface& s, const SurfaceRegion& region) const {
+	unsigned int channels = s.getChannels();
+	ColorT* data = s.getData();
+	unsigned int size = s.getSegment().getSize();
+
+	for (int z = region.lz; z <= region.hz; ++z) {
+		ColorT* row = data + (z * size + region.lx) * channels;
+		std::fill(row, row + (region.hx - region.lx + 1) * channels, colorMax);
+	}
+}
+
 } // namespace Mercator
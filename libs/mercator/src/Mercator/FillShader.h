@@ -28,6 +28,8 @@ public:
 	bool checkIntersect(const Segment&) const override;
 
 	void shade(Surface&) const override;
+
+	void shadeRegion(Surface&, const SurfaceRegion&) const override;
 };
 
 } // namespace Mercator
@@ -11,8 +11,11 @@
 #include <wfmath/MersenneTwister.h>
 #include <wfmath/intersect.h>
 
-#include <iostream>
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <thread>
+#include <vector>
 
 namespace Mercator {
 
@@ -30,14 +33,137 @@ Forest::Forest(unsigned long seed) :
 Forest::~Forest() = default;
 
 /// \brief Assign an area to this forest.
+///
+/// Any tiles populated for a previous area will be populated anew if requested
+/// through populateRegion().
 void Forest::setArea(Area* area) {
 	m_area = area;
+	m_populatedTiles.clear();
 }
 
 static const float plant_chance = 0.04f;
 static const float plant_min_height = 5.f;
 static const float plant_height_range = 20.f;
 
+/// \brief Cells closer than this to where a row crosses the edge of the area are
+/// checked with Area::contains(), so that points on the edge are treated exactly
+/// as before. All other cells are classified from the crossings alone.
+static const WFMath::CoordType edge_margin = 1.5f;
+
+static int floorDiv(int a, int b) {
+	return (a >= 0) ? (a / b) : ((a - b + 1) / b);
+}
+
+/// \brief Get the range of cells, in tile coordinates, covered by a range of cells.
+static void tilesOfCells(int lx, int ly, int hx, int hy, int& tlx, int& tly, int& thx, int& thy) {
+	tlx = floorDiv(lx, Forest::TILE_SIZE);
+	tly = floorDiv(ly, Forest::TILE_SIZE);
+	thx = floorDiv(hx - 1, Forest::TILE_SIZE) + 1;
+	thy = floorDiv(hy - 1, Forest::TILE_SIZE) + 1;
+}
+
+/// \brief Get the range of cells considered for population, intersected with the supplied box.
+///
+/// The upper bounds are exclusive.
+void Forest::tileRange(const WFMath::AxisBox<2>& box, int& lx, int& ly, int& hx, int& hy) const {
+	WFMath::AxisBox<2> bbox(m_area->bbox());
+
+	lx = std::max(I_ROUND(bbox.lowCorner().x()), (long) std::floor(box.lowCorner().x()));
+	ly = std::max(I_ROUND(bbox.lowCorner().y()), (long) std::floor(box.lowCorner().y()));
+	hx = std::min(I_ROUND(bbox.highCorner().x()), (long) std::ceil(box.highCorner().x()));
+	hy = std::min(I_ROUND(bbox.highCorner().y()), (long) std::ceil(box.highCorner().y()));
+}
+
+/// \brief Make sure that the random values for all cells in the range are cached,
+/// so that they can be read from multiple threads.
+void Forest::primeRandCache(int lx, int ly, int hx, int hy) {
+	int d = std::max(std::max(std::abs(lx), std::abs(hx - 1)),
+					 std::max(std::abs(ly), std::abs(hy - 1)));
+	m_randCache.prime(ZeroSpiralOrdering::sizeWithin(d));
+}
+
+/// \brief Populate a range of cells into the supplied store.
+///
+/// Rather than checking each cell against the polygon of the area, the
+/// polygon is scan converted one row at a time. The points where the
+/// row crosses the edges of the polygon are calculated in the same way as
+/// WFMath does for its containment check, and the cells between each pair
+/// of crossings are inside the area.
+///
+/// This doesn't modify the forest, and can be called concurrently as long as
+/// primeRandCache() has been called for the range beforehand.
+void Forest::populateCells(int lx, int ly, int hx, int hy, PlantStore& store) const {
+	const WFMath::Polygon<2>& shape = m_area->shape();
+	auto corners = shape.numCorners();
+	if (corners == 0 || m_species.empty()) {
+		return;
+	}
+
+	WFMath::MTRand rng;
+	std::vector<WFMath::CoordType> crossings;
+
+	for (int j = ly; j < hy; ++j) {
+		auto y = (WFMath::CoordType) j;
+
+		crossings.clear();
+		for (std::size_t c = 0, prev = corners - 1; c < corners; prev = c++) {
+			const auto& pc = shape.getCorner(c);
+			const auto& pp = shape.getCorner(prev);
+			bool vertically_between = ((pc.y() <= y && y < pp.y()) ||
+									   (pp.y() <= y && y < pc.y()));
+			if (!vertically_between) {
+				continue;
+			}
+			crossings.push_back(pc.x() + (pp.x() - pc.x()) * (y - pc.y()) / (pp.y() - pc.y()));
+		}
+		std::sort(crossings.begin(), crossings.end());
+
+		int next = lx;
+		for (std::size_t k = 1; k < crossings.size(); k += 2) {
+			WFMath::CoordType start = crossings[k - 1], end = crossings[k];
+			int first = std::max(next, (int) std::floor(start - edge_margin));
+			int last = std::min(hx, (int) std::ceil(end + edge_margin) + 1);
+
+			for (int i = first; i < last; ++i) {
+				bool inside;
+				if ((WFMath::CoordType) i - start > edge_margin && end - (WFMath::CoordType) i > edge_margin) {
+					inside = true;
+				} else {
+					inside = m_area->contains(i, j);
+				}
+				if (!inside) {
+					continue;
+				}
+
+				double prob = m_randCache.cached(i, j);
+				for (const Species& species: m_species) {
+					if (prob > species.m_probability) {
+						prob -= species.m_probability;
+						// Next species
+						continue;
+					}
+
+					//this is a bit of a hack
+					rng.seed((int) (prob / species.m_probability * 123456));
+
+					Plant& plant = store[i][j];
+					// plant.setHeight(rng() * plant_height_range + plant_min_height);
+					plant.m_displacement = WFMath::Point<2>(
+							(rng.rand<WFMath::CoordType>() - 0.5f) * species.m_deviation,
+							(rng.rand<WFMath::CoordType>() - 0.5f) * species.m_deviation);
+					plant.m_orientation = WFMath::Quaternion(2, rng.rand<WFMath::CoordType>() * 2 * WFMath::numeric_constants<WFMath::CoordType>::pi());
+//                    auto J = species.m_parameters.begin();
+//                    auto Jend = species.m_parameters.end();
+//                    for (; J != Jend; ++J) {
+//                        plant.setParameter(J->first, rng.rand<WFMath::CoordType>() * J->second.range + J->second.min);
+//                    }
+					break;
+				}
+			}
+			next = std::max(next, last);
+		}
+	}
+}
 
 /// \brief This function uses a pseudo-random technique to populate the
 /// forest with trees. This algorithm as the following essental properties:
@@ -59,54 +185,108 @@ static const float plant_height_range = 20.f;
 /// For each instance a new seed is used to ensure it is repeatable, and
 /// height, displacement and orientation are calculated.
 void Forest::populate() {
-	if (!m_area) return;
-	WFMath::AxisBox<2> bbox(m_area->bbox());
+	populate(1);
+}
 
+/// \brief Populate the whole forest, splitting the work into tiles which are
+/// processed by the supplied number of threads.
+///
+/// The result is identical to a single threaded population, as each cell
+/// only depends on its own coordinates.
+void Forest::populate(unsigned int threads) {
 	// Fill the plant store with plants.
 	m_plants.clear();
-	WFMath::MTRand rng;
+	m_populatedTiles.clear();
+	if (!m_area) return;
 
-	int lx = I_ROUND(bbox.lowCorner().x()),
-			ly = I_ROUND(bbox.lowCorner().y()),
-			hx = I_ROUND(bbox.highCorner().x()),
-			hy = I_ROUND(bbox.highCorner().y());
+	int lx, ly, hx, hy;
+	tileRange(m_area->bbox(), lx, ly, hx, hy);
+	if (lx >= hx || ly >= hy) return;
 
-	PlantSpecies::const_iterator I;
-	auto Iend = m_species.end();
+	primeRandCache(lx, ly, hx, hy);
 
-	for (int j = ly; j < hy; ++j) {
-		for (int i = lx; i < hx; ++i) {
-			if (!m_area->contains(i, j)) {
+	int tlx, tly, thx, thy;
+	tilesOfCells(lx, ly, hx, hy, tlx, tly, thx, thy);
+	for (int ty = tly; ty < thy; ++ty) {
+		for (int tx = tlx; tx < thx; ++tx) {
+			m_populatedTiles.emplace(tx, ty);
+		}
+	}
+
+	if (threads <= 1) {
+		populateCells(lx, ly, hx, hy, m_plants);
+		return;
+	}
+
+	std::vector<std::pair<int, int>> tiles(m_populatedTiles.begin(), m_populatedTiles.end());
+	std::vector<PlantStore> results(tiles.size());
+	std::atomic<std::size_t> nextTile(0);
+
+	auto worker = [&]() {
+		for (std::size_t t = nextTile++; t < tiles.size(); t = nextTile++) {
+			int tx = tiles[t].first, ty = tiles[t].second;
+			populateCells(std::max(lx, tx * TILE_SIZE), std::max(ly, ty * TILE_SIZE),
+						  std::min(hx, (tx + 1) * TILE_SIZE), std::min(hy, (ty + 1) * TILE_SIZE),
+						  results[t]);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < threads; ++i) {
+		workers.emplace_back(worker);
+	}
+	for (auto& thread: workers) {
+		thread.join();
+	}
+
+	// Tiles don't overlap, so the results can just be merged.
+	for (auto& result: results) {
+		for (auto& column: result) {
+			m_plants[column.first].insert(column.second.begin(), column.second.end());
+		}
+	}
+}
+
+/// \brief Populate only the parts of the forest within the given region.
+///
+/// The forest is populated a tile at a time, and tiles which already have
+/// been populated are left as they are. This allows a client to only
+/// generate the vegetation it actually needs to show.
+void Forest::populateRegion(const WFMath::AxisBox<2>& region) {
+	if (!m_area) return;
+
+	int lx, ly, hx, hy;
+	tileRange(region, lx, ly, hx, hy);
+	if (lx >= hx || ly >= hy) return;
+
+	int alx, aly, ahx, ahy;
+	tileRange(m_area->bbox(), alx, aly, ahx, ahy);
+
+	int tlx, tly, thx, thy;
+	tilesOfCells(lx, ly, hx, hy, tlx, tly, thx, thy);
+
+	for (int ty = tly; ty < thy; ++ty) {
+		for (int tx = tlx; tx < thx; ++tx) {
+			if (!m_populatedTiles.emplace(tx, ty).second) {
 				continue;
 			}
-			double prob = m_randCache(i, j);
-			I = m_species.begin();
-			for (; I != Iend; ++I) {
-				const Species& species = *I;
-				if (prob > species.m_probability) {
-					prob -= species.m_probability;
-					// Next species
-					continue;
-				}
 
-//                std::cout << "Plant at [" << i << ", " << j << "]"
-//                          << std::endl;
-				//this is a bit of a hack
-				rng.seed((int) (prob / I->m_probability * 123456));
-
-				Plant& plant = m_plants[i][j];
-				// plant.setHeight(rng() * plant_height_range + plant_min_height);
-				plant.m_displacement = WFMath::Point<2>(
-						(rng.rand<WFMath::CoordType>() - 0.5f) * species.m_deviation,
-						(rng.rand<WFMath::CoordType>() - 0.5f) * species.m_deviation);
-				plant.m_orientation = WFMath::Quaternion(2, rng.rand<WFMath::CoordType>() * 2 * WFMath::numeric_constants<WFMath::CoordType>::pi());
-//                auto J = species.m_parameters.begin();
-//                auto Jend = species.m_parameters.end();
-//                for (; J != Jend; ++J) {
-//                    plant.setParameter(J->first, rng.rand<WFMath::CoordType>() * J->second.range + J->second.min);
-//                }
-				break;
+			int clx = std::max(alx, tx * TILE_SIZE), cly = std::max(aly, ty * TILE_SIZE),
+					chx = std::min(ahx, (tx + 1) * TILE_SIZE), chy = std::min(ahy, (ty + 1) * TILE_SIZE);
+
+			primeRandCache(clx, cly, chx, chy);
+
+			// Remove anything left from an earlier area.
+			for (auto I = m_plants.lower_bound(clx); I != m_plants.end() && I->first < chx;) {
+				I->second.erase(I->second.lower_bound(cly), I->second.lower_bound(chy));
+				if (I->second.empty()) {
+					I = m_plants.erase(I);
+				} else {
+					++I;
+				}
 			}
+
+			populateCells(clx, cly, chx, chy, m_plants);
 		}
 	}
 }
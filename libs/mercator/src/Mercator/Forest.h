@@ -11,6 +11,7 @@
 #include <wfmath/polygon.h>
 
 #include <map>
+#include <set>
 #include <string>
 
 namespace Mercator {
@@ -70,6 +71,9 @@ public:
 
 	/// STL vector of plant species in this forest.
 	typedef std::vector<Species> PlantSpecies;
+
+	/// \brief The size of the tiles used when populating parts of the forest.
+	static const int TILE_SIZE = 64;
 private:
 	//TODO: store as value, not pointer
 	/// Area of terrain affected by the presence of this forest.
@@ -83,6 +87,14 @@ private:
 	unsigned long m_seed;
 	/// Cache for optimising random number generation.
 	RandCache m_randCache;
+	/// Tiles, in tile coordinates, which have been populated.
+	std::set<std::pair<int, int>> m_populatedTiles;
+
+	void primeRandCache(int lx, int ly, int hx, int hy);
+
+	void populateCells(int lx, int ly, int hx, int hy, PlantStore& store) const;
+
+	void tileRange(const WFMath::AxisBox<2>& box, int& lx, int& ly, int& hx, int& hy) const;
 
 public:
 	explicit Forest(unsigned long seed = 0);
@@ -108,6 +120,15 @@ public:
 	void setArea(Area* a);
 
 	void populate();
+
+	void populate(unsigned int threads);
+
+	void populateRegion(const WFMath::AxisBox<2>& region);
+
+	/// \brief Check if the tile at the given tile coordinates has been populated.
+	bool isTilePopulated(int tx, int ty) const {
+		return m_populatedTiles.count({tx, ty}) != 0;
+	}
 };
 
 }
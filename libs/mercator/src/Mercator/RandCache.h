@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cstdlib>
 #include <memory>
+#include <cassert>
 #include <wfmath/MersenneTwister.h>
 
 // construct with something like:
@@ -66,6 +67,31 @@ public:
 		return double(m_cache[cache_order] * (1.0 / 4294967295.0));
 	}
 
+	/// \brief Make sure that at least the given number of values are cached.
+	///
+	/// @param count number of values, in cache order.
+	void prime(size_type count) {
+		size_type old_size = m_cache.size();
+		if (count > old_size) {
+			m_cache.resize(count);
+			while (old_size < m_cache.size())
+				m_cache[old_size++] = m_rand.randInt();
+		}
+	}
+
+	/// \brief Retrieve a value which is already in the cache.
+	///
+	/// As the cache isn't modified this can be called concurrently from
+	/// multiple threads, as long as prime() has been called beforehand to
+	/// cover the coordinates requested.
+	/// @param x coordinate associated with value to be retrieved.
+	/// @param y coordinate associated with value to be retrieved.
+	double cached(int x, int y) const {
+		size_type cache_order = (*m_ordering)(x, y);
+		assert(cache_order < m_cache.size());
+		return double(m_cache[cache_order] * (1.0 / 4294967295.0));
+	}
+
 private:
 	/// \brief Source random number generator.
 	WFMath::MTRand m_rand;
@@ -78,6 +104,12 @@ private:
 /// \brief A spiral around 0,0
 class ZeroSpiralOrdering : public RandCache::Ordering {
 public:
+	/// \brief The number of values needed to cover all coordinates within
+	/// the given distance of the centre.
+	static RandCache::size_type sizeWithin(int d) {
+		return RandCache::size_type(2 * d + 1) * RandCache::size_type(2 * d + 1);
+	}
+
 	RandCache::size_type operator()(int x, int y) override {
 		if (x == 0 && y == 0) return 0;
 
@@ -12,6 +12,7 @@
 
 #include <wfmath/MersenneTwister.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cassert>
 
@@ -90,6 +91,40 @@ void Segment::invalidateSurfaces() {
 	}
 }
 
+/// \brief Mark part of the surfaces as stale.
+///
+/// Only the surface points within the area, plus a margin of one point to
+/// account for shaders which look at neighbouring points, will be shaded
+/// again when the surfaces are next populated.
+/// @param area the affected area, in world coordinates.
+void Segment::invalidateSurfaces(const WFMath::AxisBox<2>& area) {
+	SurfaceRegion region{};
+	if (!regionFor(area, region)) {
+		return;
+	}
+	for (auto& entry: m_surfaces) {
+		entry.second->invalidate(region);
+	}
+}
+
+/// \brief Determine the surface points affected by an area.
+///
+/// @param area the affected area, in world coordinates.
+/// @param region the affected points, including a margin of one point.
+/// @return true if the area intersects with this Segment, false otherwise.
+bool Segment::regionFor(const WFMath::AxisBox<2>& area, SurfaceRegion& region) const {
+	WFMath::AxisBox<2> local = area;
+	local.shift(WFMath::Vector<2>(-m_xRef, -m_zRef));
+	if (!clipToSegment(local, region.lx, region.hx, region.lz, region.hz)) {
+		return false;
+	}
+	region.lx = std::max(region.lx - 1, 0);
+	region.lz = std::max(region.lz - 1, 0);
+	region.hx = std::min(region.hx + 1, m_res);
+	region.hz = std::min(region.hz + 1, m_res);
+	return true;
+}
+
 /// \brief Populate the Segment with surface normal data.
 ///
 /// Storage for the normals is allocated if necessary, and the average
@@ -184,7 +219,12 @@ void Segment::populateNormals() {
 void Segment::populateSurfaces() {
 	for (const auto& entry: m_surfaces) {
 		if (entry.second->m_shader.checkIntersect(*this)) {
-			entry.second->populate();
+			if (entry.second->isDirty()) {
+				entry.second->populate();
+			}
+		} else if (entry.second->getDirtyRegion()) {
+			// The shader no longer applies, so the data is stale all over.
+			entry.second->invalidate();
 		}
 	}
 }
@@ -241,12 +281,19 @@ bool Segment::clipToSegment(const WFMath::AxisBox<2>& bbox,
 }
 
 void Segment::updateMod(long id, const TerrainMod* t) {
+	// Only the surface points covered by the old and the new mod change.
+	auto I = m_terrainMods.find(id);
+	if (I != m_terrainMods.end()) {
+		invalidateSurfaces(I->second->bbox());
+	}
 	if (t) {
+		invalidateSurfaces(t->bbox());
 		m_terrainMods[id] = t;
 	} else {
 		m_terrainMods.erase(id);
 	}
-	invalidate();
+	m_heightMap.invalidate();
+	m_normals = {};
 }
 
 /// \brief Delete all the modifications applied to this Segment.
@@ -281,7 +328,7 @@ void Segment::applyMod(const TerrainMod* t) {
 	}
 
 	//currently mods dont fix the normals
-	invalidate(false);
+	m_normals = {};
 }
 
 void Segment::updateArea(long id, const Area* area, const Shader* shader) {
@@ -290,9 +337,12 @@ void Segment::updateArea(long id, const Area* area, const Shader* shader) {
 		auto& areaEntry = areaLookupI->second->second;
 		auto J = m_surfaces.find(areaEntry.area->getLayer());
 		if (J != m_surfaces.end()) {
-			// segment already has a surface for this shader, mark it
-			// for re-generation
-			J->second->invalidate();
+			// segment already has a surface for this shader, mark the
+			// part covered by the old area for re-generation
+			SurfaceRegion region{};
+			if (regionFor(areaEntry.area->bbox(), region)) {
+				J->second->invalidate(region);
+			}
 		}
 		m_areas.erase(areaLookupI->second);
 		m_areaLookup.erase(areaLookupI);
@@ -304,7 +354,10 @@ void Segment::updateArea(long id, const Area* area, const Shader* shader) {
 		m_areaLookup.emplace(id, result);
 		auto J = m_surfaces.find(area->getLayer());
 		if (J != m_surfaces.end()) {
-			J->second->invalidate();
+			SurfaceRegion region{};
+			if (regionFor(area->bbox(), region)) {
+				J->second->invalidate(region);
+			}
 		} else {
 			if (shader) {
 				m_surfaces[area->getLayer()] = shader->newSurface(*this);
@@ -26,6 +26,8 @@ class Terrain;
 
 class Surface;
 
+struct SurfaceRegion;
+
 class TerrainMod;
 
 class Area;
@@ -221,6 +223,10 @@ private:
 
 	void invalidateSurfaces();
 
+	void invalidateSurfaces(const WFMath::AxisBox<2>& area);
+
+	bool regionFor(const WFMath::AxisBox<2>& area, SurfaceRegion& region) const;
+
 };
 
 } // namespace Mercator
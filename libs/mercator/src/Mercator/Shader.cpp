@@ -27,4 +27,13 @@ std::unique_ptr<Surface> Shader::newSurface(const Segment& segment) const {
 	return std::make_unique<Surface>(segment, *this, m_color, m_alpha);
 }
 
+/// \brief Shade part of a Surface.
+///
+/// Shaders which can't shade only part of a Surface, for example because
+/// the value at each point depends on its neighbours, will shade the whole
+/// Surface instead.
+void Shader::shadeRegion(Surface& surface, const SurfaceRegion&) const {
+	shade(surface);
+}
+
 } // namespace Mercator
@@ -13,6 +13,8 @@ namespace Mercator {
 
 class Surface;
 
+struct SurfaceRegion;
+
 class Segment;
 
 /// \brief Base class for Shader objects which create surface data for use
@@ -57,6 +59,13 @@ public:
 	/// \brief Populate a Surface with data.
 	virtual void shade(Surface&) const = 0;
 
+	/// \brief Populate part of a Surface with data.
+	///
+	/// The Surface must already contain data. Only the points within the
+	/// region need to be written; the default implementation shades the
+	/// whole Surface.
+	virtual void shadeRegion(Surface&, const SurfaceRegion&) const;
+
 	/// STL map of parameter values for a shader constructor.
 	typedef std::map<std::string, float> Parameters;
 };
@@ -21,13 +21,42 @@ Surface::Surface(const Segment& seg, const Shader& sh, bool color, bool alpha)
 
 /// \brief Populate the data buffer using the correct shader.
 ///
-/// Call the shader to full this surface buffer with surface data.
+/// Call the shader to full this surface buffer with surface data. If the
+/// surface already contains data, and only part of it has been marked as
+/// stale, only that part is shaded again.
 void Surface::populate() {
 	if (!isValid()) {
 		allocate();
+		m_shader.shade(*this);
+	} else if (m_dirtyRegion) {
+		m_shader.shadeRegion(*this, *m_dirtyRegion);
+	} else {
+		m_shader.shade(*this);
 	}
+	m_dirtyRegion.reset();
+}
 
-	m_shader.shade(*this);
+/// \brief Mark part of the surface as stale.
+///
+/// The region is clamped to the surface, and added to any region already
+/// marked. Nothing is done if the surface has no data, as it will be
+/// shaded in full anyway.
+/// @param region the points which need to be shaded again.
+void Surface::invalidate(const SurfaceRegion& region) {
+	if (!isValid()) {
+		return;
+	}
+	int max = static_cast<int>(m_size) - 1;
+	SurfaceRegion clamped{std::max(region.lx, 0), std::max(region.lz, 0),
+						  std::min(region.hx, max), std::min(region.hz, max)};
+	if (clamped.lx > clamped.hx || clamped.lz > clamped.hz) {
+		return;
+	}
+	if (m_dirtyRegion) {
+		m_dirtyRegion->add(clamped);
+	} else {
+		m_dirtyRegion = clamped;
+	}
 }
 
 } // namespace Mercator
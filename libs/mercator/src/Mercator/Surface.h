@@ -8,7 +8,9 @@
 #include "Buffer.h"
 #include "Segment.h"
 
+#include <algorithm>
 #include <climits>
+#include <optional>
 
 namespace Mercator {
 
@@ -19,6 +21,25 @@ typedef unsigned char ColorT;
 static const ColorT colorMax = UCHAR_MAX;
 static const ColorT colorMin = 0;
 
+/// \brief Rectangle of points within a Surface.
+///
+/// Coordinates are in points relative to the origin of the segment, and
+/// the bounds are inclusive.
+struct SurfaceRegion {
+	int lx;
+	int lz;
+	int hx;
+	int hz;
+
+	/// \brief Grow this region so that it also covers another region.
+	void add(const SurfaceRegion& other) {
+		lx = std::min(lx, other.lx);
+		lz = std::min(lz, other.lz);
+		hx = std::max(hx, other.hx);
+		hz = std::max(hz, other.hz);
+	}
+};
+
 /// \brief Data store for terrain surface data.
 class Surface : public Buffer<ColorT> {
 public:
@@ -34,11 +55,34 @@ public:
 
 	void populate();
 
+	using Buffer<ColorT>::invalidate;
+
+	void invalidate(const SurfaceRegion& region);
+
+	/// \brief Check whether this surface needs to be populated.
+	///
+	/// @return true if the surface has no data, or if part of it is stale.
+	bool isDirty() const {
+		return !isValid() || m_dirtyRegion.has_value();
+	}
+
+	/// \brief Accessor for the part of the surface which is stale, if any.
+	const std::optional<SurfaceRegion>& getDirtyRegion() const {
+		return m_dirtyRegion;
+	}
+
 	/// Accessor for the terrain height segment this surface is associated with.
 	const Segment& getSegment() const {
 		return m_segment;
 	}
 	// Do we need an accessor presenting the array in colour form?
+
+private:
+	/// \brief The part of the surface which needs to be shaded again.
+	///
+	/// Only used while the surface is valid; an invalid surface is always
+	/// shaded in full.
+	std::optional<SurfaceRegion> m_dirtyRegion;
 };
 
 } // namespace Mercator
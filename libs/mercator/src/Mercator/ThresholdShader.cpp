@@ -37,6 +37,11 @@ bool HighShader::checkIntersect(const Segment& s) const {
 }
 
 void HighShader::shade(Surface& s) const {
+	int max = static_cast<int>(s.getSize()) - 1;
+	shadeRegion(s, {0, 0, max, max});
+}
+
+void HighShader::shadeRegion(Surface& s, const SurfaceRegion& region) const {
 	unsigned int channels = s.getChannels();
 	assert(channels > 0);
 	unsigned int colors = channels - 1;
@@ -49,13 +54,15 @@ void HighShader::shade(Surface& s) const {
 	}
 	unsigned int size = s.getSegment().getSize();
 
-	unsigned int count = size * size;
-	int j = -1;
-	for (unsigned int i = 0; i < count; ++i) {
-		for (unsigned int k = 0; k < colors; ++k) {
-			data[++j] = colorMax;
+	for (int z = region.lz; z <= region.hz; ++z) {
+		for (int x = region.lx; x <= region.hx; ++x) {
+			unsigned int i = z * size + x;
+			int j = static_cast<int>(i * channels) - 1;
+			for (unsigned int k = 0; k < colors; ++k) {
+				data[++j] = colorMax;
+			}
+			data[++j] = ((height_data[i] > m_threshold) ? colorMax : colorMin);
 		}
-		data[++j] = ((height_data[i] > m_threshold) ? colorMax : colorMin);
 	}
 }
 
@@ -85,6 +92,11 @@ bool LowShader::checkIntersect(const Segment& s) const {
 }
 
 void LowShader::shade(Surface& s) const {
+	int max = static_cast<int>(s.getSize()) - 1;
+	shadeRegion(s, {0, 0, max, max});
+}
+
+void LowShader::shadeRegion(Surface& s, const SurfaceRegion& region) const {
 	unsigned int channels = s.getChannels();
 	assert(channels > 0);
 	unsigned int colors = channels - 1;
@@ -97,13 +109,15 @@ void LowShader::shade(Surface& s) const {
 	}
 	unsigned int size = s.getSegment().getSize();
 
-	unsigned int count = size * size;
-	int j = -1;
-	for (unsigned int i = 0; i < count; ++i) {
-		for (unsigned int k = 0; k < colors; ++k) {
-			data[++j] = colorMax;
+	for (int z = region.lz; z <= region.hz; ++z) {
+		for (int x = region.lx; x <= region.hx; ++x) {
+			unsigned int i = z * size + x;
+			int j = static_cast<int>(i * channels) - 1;
+			for (unsigned int k = 0; k < colors; ++k) {
+				data[++j] = colorMax;
+			}
+			data[++j] = ((height_data[i] < m_threshold) ? colorMax : colorMin);
 		}
-		data[++j] = ((height_data[i] < m_threshold) ? colorMax : colorMin);
 	}
 }
 
@@ -142,6 +156,11 @@ bool BandShader::checkIntersect(const Segment& s) const {
 }
 
 void BandShader::shade(Surface& s) const {
+	int max = static_cast<int>(s.getSize()) - 1;
+	shadeRegion(s, {0, 0, max, max});
+}
+
+void BandShader::shadeRegion(Surface& s, const SurfaceRegion& region) const {
 	unsigned int channels = s.getChannels();
 	assert(channels > 0);
 	unsigned int colors = channels - 1;
@@ -154,14 +173,16 @@ void BandShader::shade(Surface& s) const {
 	}
 	unsigned int size = s.getSegment().getSize();
 
-	unsigned int count = size * size;
-	int j = -1;
-	for (unsigned int i = 0; i < count; ++i) {
-		for (unsigned int k = 0; k < colors; ++k) {
-			data[++j] = colorMax;
+	for (int z = region.lz; z <= region.hz; ++z) {
+		for (int x = region.lx; x <= region.hx; ++x) {
+			unsigned int i = z * size + x;
+			int j = static_cast<int>(i * channels) - 1;
+			for (unsigned int k = 0; k < colors; ++k) {
+				data[++j] = colorMax;
+			}
+			data[++j] = (((height_data[i] > m_lowThreshold) &&
+						  (height_data[i] < m_highThreshold)) ? colorMax : colorMin);
 		}
-		data[++j] = (((height_data[i] > m_lowThreshold) &&
-					  (height_data[i] < m_highThreshold)) ? colorMax : colorMin);
 	}
 }
 
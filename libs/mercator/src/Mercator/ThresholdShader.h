@@ -39,6 +39,8 @@ public:
 	bool checkIntersect(const Segment&) const override;
 
 	void shade(Surface&) const override;
+
+	void shadeRegion(Surface&, const SurfaceRegion&) const override;
 };
 
 /// \brief Surface shader that defines the surface below a given level.
@@ -71,6 +73,8 @@ public:
 	bool checkIntersect(const Segment&) const override;
 
 	void shade(Surface&) const override;
+
+	void shadeRegion(Surface&, const SurfaceRegion&) const override;
 };
 
 /// \brief Surface shader that defines the surface between two levels.
@@ -114,6 +118,8 @@ public:
 	bool checkIntersect(const Segment&) const override;
 
 	void shade(Surface&) const override;
+
+	void shadeRegion(Surface&, const SurfaceRegion&) const override;
 };
 
 } // namespace Mercator
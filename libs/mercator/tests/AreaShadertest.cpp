@@ -6,6 +6,10 @@
 #include <Mercator/Area.h>
 #include <Mercator/AreaShader.h>
 #include <Mercator/Segment.h>
+#include <Mercator/Surface.h>
+
+#include <cstdlib>
+#include <vector>
 
 #ifdef NDEBUG
 #undef NDEBUG
@@ -52,8 +56,81 @@ void testAreaShader() {
 	seg->populateSurfaces();
 }
 
+// Check that shading only the part of a surface touched by an updated area
+// gives the same result as shading the whole surface again.
+void testAreaShaderRegion() {
+	WFMath::Polygon<2> p1;
+	p1.addCorner(p1.numCorners(), Point2(3, 4));
+	p1.addCorner(p1.numCorners(), Point2(40, 10));
+	p1.addCorner(p1.numCorners(), Point2(20, 30));
+	p1.addCorner(p1.numCorners(), Point2(-8, 11));
+
+	auto a1 = std::make_unique<Mercator::Area>(1, false);
+	a1->setShape(p1);
+
+	Mercator::Terrain terrain(Mercator::Terrain::SHADED, 64);
+
+	Mercator::AreaShader ashade(1);
+	terrain.addShader(&ashade, 1);
+
+	terrain.setBasePoint(0, 0, -1);
+	terrain.setBasePoint(0, 1, 8);
+	terrain.setBasePoint(1, 0, 2);
+	terrain.setBasePoint(1, 1, 11);
+
+	terrain.updateArea(1, std::move(a1));
+
+	Mercator::Segment* seg = terrain.getSegmentAtIndex(0, 0);
+	assert(seg != nullptr);
+	seg->populate();
+	seg->populateSurfaces();
+
+	auto I = seg->getSurfaces().find(1);
+	assert(I != seg->getSurfaces().end());
+	Mercator::Surface& surface = *I->second;
+	assert(surface.isValid());
+	assert(!surface.isDirty());
+
+	WFMath::Polygon<2> p2;
+	p2.addCorner(p2.numCorners(), Point2(30, 35));
+	p2.addCorner(p2.numCorners(), Point2(50, 40));
+	p2.addCorner(p2.numCorners(), Point2(35, 55));
+
+	auto a2 = std::make_unique<Mercator::Area>(1, false);
+	a2->setShape(p2);
+	terrain.updateArea(2, std::move(a2));
+
+	// Only the part covered by the new area should be dirty.
+	assert(surface.isValid());
+	assert(surface.getDirtyRegion());
+	assert(surface.getDirtyRegion()->lx == 29);
+	assert(surface.getDirtyRegion()->lz == 34);
+	assert(surface.getDirtyRegion()->hx == 51);
+	assert(surface.getDirtyRegion()->hz == 56);
+
+	seg->populateSurfaces();
+	assert(!surface.isDirty());
+	std::vector<Mercator::ColorT> regionShaded(surface.getData(), surface.getData() + surface.getSize() * surface.getSize());
+
+	surface.invalidate();
+	seg->populateSurfaces();
+	assert(surface.isValid());
+	std::vector<Mercator::ColorT> fullyShaded(surface.getData(), surface.getData() + surface.getSize() * surface.getSize());
+
+	// Clipping the area to the region introduces new corners, so allow for
+	// rounding differences.
+	bool covered = false;
+	for (size_t i = 0; i < fullyShaded.size(); ++i) {
+		assert(std::abs(regionShaded[i] - fullyShaded[i]) <= 1);
+		covered = covered || fullyShaded[i] != 0;
+	}
+	assert(covered);
+	assert(surface(40, 42, 0) == Mercator::colorMax);
+}
+
 int main() {
 	testAreaShader();
+	testAreaShaderRegion();
 
 	return 0;
 }
@@ -0,0 +1,115 @@
+// This file may be redistributed and modified only under the terms of
+// the GNU General Public License (See COPYING for details).
+// Copyright (C) 2009 Alistair Riddoch
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include <Mercator/Forest.h>
+#include <Mercator/Plant.h>
+#include <Mercator/Area.h>
+
+#include <wfmath/point.h>
+#include <wfmath/axisbox.h>
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+typedef WFMath::Point<2> Point2;
+
+static bool samePlants(const Mercator::Forest::PlantStore& a,
+					   const Mercator::Forest::PlantStore& b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	auto I = a.begin();
+	auto J = b.begin();
+	for (; I != a.end(); ++I, ++J) {
+		if (I->first != J->first || I->second.size() != J->second.size()) {
+			return false;
+		}
+		auto K = I->second.begin();
+		auto L = J->second.begin();
+		for (; K != I->second.end(); ++K, ++L) {
+			if (K->first != L->first ||
+				K->second.m_displacement != L->second.m_displacement ||
+				K->second.m_orientation != L->second.m_orientation) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+template<typename F>
+static double time(F f) {
+	auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	int radius = 512;
+
+	if (argc > 1) {
+		radius = strtol(argv[1], 0, 10);
+	}
+
+	// An irregular, roughly circular forest, so that most rows have long runs
+	// inside the area as well as edges which need exact checks.
+	WFMath::Polygon<2> p;
+	for (int i = 0; i < 64; ++i) {
+		float angle = i * 2 * WFMath::numeric_constants<float>::pi() / 64;
+		float r = radius * (0.8f + 0.2f * std::sin(angle * 5));
+		p.addCorner(p.numCorners(), Point2(r * std::cos(angle) + 17, r * std::sin(angle) - 31));
+	}
+
+	Mercator::Area ar(1, false);
+	ar.setShape(p);
+
+	Mercator::Species pine;
+	pine.m_probability = 0.04;
+	pine.m_deviation = 1.f;
+
+	Mercator::Forest serial(4249162ul);
+	serial.species().push_back(pine);
+	serial.setArea(&ar);
+
+	Mercator::Forest parallel(4249162ul);
+	parallel.species().push_back(pine);
+	parallel.setArea(&ar);
+
+	Mercator::Forest lazy(4249162ul);
+	lazy.species().push_back(pine);
+	lazy.setArea(&ar);
+
+	unsigned int threads = std::max(2u, std::thread::hardware_concurrency());
+
+	double serialTime = time([&]() { serial.populate(); });
+	double parallelTime = time([&]() { parallel.populate(threads); });
+
+	// Populate a view sized region in the middle of the forest.
+	WFMath::AxisBox<2> view(Point2(-128, -128), Point2(128, 128));
+	double lazyTime = time([&]() { lazy.populateRegion(view); });
+
+	std::cout << "Serial   : " << serialTime << " ms" << std::endl;
+	std::cout << "Parallel : " << parallelTime << " ms (" << threads << " threads)" << std::endl;
+	std::cout << "Region   : " << lazyTime << " ms" << std::endl;
+
+	assert(!serial.getPlants().empty());
+	assert(samePlants(serial.getPlants(), parallel.getPlants()));
+
+	// Populating the rest of the forest lazily gives the same result.
+	lazy.populateRegion(ar.bbox());
+	assert(samePlants(serial.getPlants(), lazy.getPlants()));
+
+	return 0;
+}
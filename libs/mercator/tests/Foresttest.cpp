@@ -140,5 +140,26 @@ int main() {
 		std::cout << countPlants(plants) << "," << plant_count
 				  << std::endl;
 
+		// Populating with threads, or a region at a time, gives the same plants
+		{
+			Mercator::Forest threaded(4249162ul);
+			threaded.species() = species;
+			threaded.setArea(&ar);
+			threaded.populate(4);
+
+			assert(countPlants(threaded.getPlants()) == countPlants(plants));
+
+			Mercator::Forest lazy(4249162ul);
+			lazy.species() = species;
+			lazy.setArea(&ar);
+			lazy.populateRegion(WFMath::AxisBox<2>(Point2(0, 0), Point2(10, 10)));
+
+			assert(lazy.isTilePopulated(0, 0));
+			assert(!lazy.isTilePopulated(1, 0));
+			assert(countPlants(lazy.getPlants()) <= countPlants(plants));
+
+			lazy.populateRegion(ar.bbox());
+			assert(countPlants(lazy.getPlants()) == countPlants(plants));
+		}
 	}
 }
@@ -77,10 +77,11 @@ int main() {
 
 	auto* sfce = new Mercator::Surface(*seg, shader);
 
-	// Force allocation of the surface buffer so we can check later that it
-	// gets destroyed when the area is added to the terrain.
-	sfce->allocate();
+	// Populate the surface so we can check later that the part covered by
+	// the area gets marked as dirty when the area is added to the terrain.
+	sfce->populate();
 	assert(sfce->isValid());
+	assert(!sfce->isDirty());
 
 	// Add the surface to the store for this segment
 	sss[0].reset(sfce);
@@ -88,13 +89,18 @@ int main() {
 	// Add the area which should cause relevant surface date to be invalidated
 	t.updateArea(1, std::move(a1));
 
-	// We assert this to ensure that the buffer has been de-allocated
-	// by a call to Surface::invalidate caused by adding the Area.
-	assert(!sfce->isValid());
-
-	// force the surface to re-allocate
-	sfce->allocate();
+	// We assert this to ensure that only the part of the surface covered by
+	// the Area, plus a margin of one point, has been marked as dirty.
 	assert(sfce->isValid());
+	assert(sfce->isDirty());
+	assert(sfce->getDirtyRegion()->lx == 0);
+	assert(sfce->getDirtyRegion()->lz == 3);
+	assert(sfce->getDirtyRegion()->hx == 19);
+	assert(sfce->getDirtyRegion()->hz == 21);
+
+	// re-shade the dirty part of the surface
+	sfce->populate();
+	assert(!sfce->isDirty());
 
 	// Modify the areas shape
 	p.addCorner(p.numCorners(), WFMath::Point<2>(-9, 12));
@@ -104,17 +110,26 @@ int main() {
 	// and cause an area update
 	t.updateArea(1, std::move(a1_2));
 
-	// Check the surface has been invalidated again
-	assert(!sfce->isValid());
+	// Check the surface has been marked as dirty again, and that the region
+	// covers the new shape
+	assert(sfce->isDirty());
+	assert(sfce->getDirtyRegion()->lx == 0);
+	assert(sfce->getDirtyRegion()->lz == 3);
 
-	// force the surface to re-allocate
-	sfce->allocate();
-	assert(sfce->isValid());
+	sfce->populate();
+	assert(!sfce->isDirty());
 
 	t.updateArea(1, nullptr);
 
-	// Check the surface has been invalidated again
+	// Check the surface has been marked as dirty again
+	assert(sfce->isValid());
+	assert(sfce->isDirty());
+
+	// Invalidating the whole surface means that it needs to be shaded again
+	// in full
+	sfce->invalidate();
 	assert(!sfce->isValid());
+	assert(sfce->isDirty());
 }
 
 // stubs